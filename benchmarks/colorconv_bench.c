@@ -0,0 +1,140 @@
+/*
+ * colorconv_bench.c — RGBA → YUV 4:2:0 conversion cost per kernel
+ *
+ * Converts a 1080p and a 2160p RGBA frame of noise to NV12, I420 and
+ * P010 (BT.709, limited range) with every kernel this CPU supports on a
+ * single thread, then 2160p NV12 with the auto kernel on all threads as
+ * the encoders run it.  "legacy" is the former per-pixel rgba_to_nv12()
+ * of vaapi_encoder.c (top-left chroma sample, no averaging) for
+ * reference.
+ *
+ * Output format:
+ *   BENCH colorconv_<fmt>: kernel=NAME res=WxH threads=N ns_per_px=X ms_per_frame=X
+ *
+ * Exit: 0 if every SIMD kernel matches the scalar output and threaded
+ *       2160p NV12 takes ≤ 8 ms (half a 60 fps frame), 1 otherwise.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "colorconv/colorconv.h"
+
+#define ITERATIONS_1080 40
+#define ITERATIONS_2160 12
+#define BUDGET_MS       8.0
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* The pre-colorconv VA-API conversion, kept for comparison */
+static void legacy_rgba_to_nv12(const uint8_t *rgba, uint8_t *y_plane, uint8_t *uv_plane,
+                                int width, int height) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t *p = rgba + ((size_t)y * width + x) * 4;
+            y_plane[(size_t)y * width + x] =
+                (uint8_t)(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+            if ((y & 1) == 0 && (x & 1) == 0) {
+                uint8_t *uv = uv_plane + (size_t)(y / 2) * width + x;
+                uv[0] = (uint8_t)(((-38 * p[0] - 74 * p[1] + 112 * p[2] + 128) >> 8) + 128);
+                uv[1] = (uint8_t)(((112 * p[0] - 94 * p[1] - 18 * p[2] + 128) >> 8) + 128);
+            }
+        }
+    }
+}
+
+static void report(const char *fmt, const char *kernel, int w, int h, int threads,
+                   uint64_t ns, int iters) {
+    double per_frame = (double)ns / iters;
+    printf("BENCH colorconv_%s: kernel=%s res=%dx%d threads=%d ns_per_px=%.3f "
+           "ms_per_frame=%.2f\n",
+           fmt, kernel, w, h, threads, per_frame / ((double)w * h), per_frame / 1e6);
+}
+
+int main(void) {
+    static const int res[][2] = {{1920, 1080}, {3840, 2160}};
+    static const colorconv_format_t fmts[] = {COLORCONV_NV12, COLORCONV_I420, COLORCONV_P010};
+    static const char *fmt_names[] = {"nv12", "i420", "p010"};
+    static const colorconv_kernel_t kernels[] = {COLORCONV_KERNEL_SCALAR, COLORCONV_KERNEL_SSE2,
+                                                 COLORCONV_KERNEL_AVX2};
+    bool ok = true;
+    double threaded_ms = 0.0;
+
+    colorconv_t *cc = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 1);
+    colorconv_t *mt = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 0);
+    if (!cc || !mt) return 1;
+
+    for (int r = 0; r < 2; r++) {
+        int w = res[r][0], h = res[r][1];
+        int iters = r == 0 ? ITERATIONS_1080 : ITERATIONS_2160;
+
+        uint8_t *rgba = malloc((size_t)w * h * 4);
+        uint64_t s = 0x2545F4914F6CDD1DULL;
+        for (size_t i = 0; i < (size_t)w * h * 4; i++) {
+            s ^= s << 13;
+            s ^= s >> 7;
+            s ^= s << 17;
+            rgba[i] = (uint8_t)s;
+        }
+        colorconv_image_t src;
+        colorconv_image_init(&src, COLORCONV_RGBA, w, h, rgba);
+
+        size_t max_size = colorconv_image_size(COLORCONV_P010, w, h);
+        uint8_t *ref = malloc(max_size), *out = malloc(max_size);
+
+        uint64_t t0 = now_ns();
+        for (int it = 0; it < iters; it++)
+            legacy_rgba_to_nv12(rgba, out, out + (size_t)w * h, w, h);
+        report("nv12", "legacy", w, h, 1, now_ns() - t0, iters);
+
+        for (int f = 0; f < 3; f++) {
+            size_t size = colorconv_image_size(fmts[f], w, h);
+            colorconv_image_t ref_img, dst;
+            colorconv_image_init(&ref_img, fmts[f], w, h, ref);
+            colorconv_image_init(&dst, fmts[f], w, h, out);
+
+            for (int k = 0; k < 3; k++) {
+                if (colorconv_set_kernel(cc, kernels[k]) != 0) continue;
+                colorconv_image_t *img = k == 0 ? &ref_img : &dst;
+
+                t0 = now_ns();
+                for (int it = 0; it < iters; it++) colorconv_convert(cc, &src, img);
+                report(fmt_names[f], colorconv_kernel_name(kernels[k]), w, h, 1, now_ns() - t0,
+                       iters);
+                if (k > 0 && memcmp(ref, out, size) != 0) ok = false;
+            }
+        }
+
+        if (r == 1) {
+            colorconv_image_t dst;
+            colorconv_image_init(&dst, COLORCONV_NV12, w, h, out);
+            colorconv_convert(mt, &src, &dst); /* Wake the workers */
+            t0 = now_ns();
+            for (int it = 0; it < iters; it++) colorconv_convert(mt, &src, &dst);
+            uint64_t ns = now_ns() - t0;
+            threaded_ms = (double)ns / iters / 1e6;
+
+            long threads = sysconf(_SC_NPROCESSORS_ONLN);
+            if (threads > COLORCONV_MAX_THREADS) threads = COLORCONV_MAX_THREADS;
+            report("nv12", colorconv_kernel_name(colorconv_get_kernel(mt)), w, h, (int)threads, ns,
+                   iters);
+        }
+
+        free(out);
+        free(ref);
+        free(rgba);
+    }
+
+    colorconv_destroy(mt);
+    colorconv_destroy(cc);
+    return (ok && threaded_ms <= BUDGET_MS) ? 0 : 1;
+}
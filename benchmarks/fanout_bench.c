@@ -0,0 +1,221 @@
+/*
+ * fanout_bench.c — Frame-to-last-peer latency of the video fan-out
+ *
+ * Sends the same frame sequence (a ~150 KB keyframe every 60 frames,
+ * ~20 KB P-frames otherwise) through the real send path (src/network.c)
+ * to 1, 4 and 16 authenticated loopback UDP peers, two ways:
+ *
+ *   serial  — rootstream_net_send_video() for each peer in turn, the way
+ *             the host loop used to send;
+ *   fanout  — rootstream_net_send_video_all() + rootstream_net_flush_video(),
+ *             chunking and FEC parity once per frame, per-peer sealing
+ *             and sending on the sender threads.
+ *
+ * Latency is measured from handing the frame over until the last peer's
+ * last packet has been passed to the kernel.  Every peer runs at 10 % FEC
+ * so the shared parity is part of the measurement.
+ *
+ * Output format:
+ *   BENCH fanout: peers=N mode=serial|fanout p50_us=X p99_us=X bytes=N
+ *   BENCH fanout: workers=N speedup_16=X
+ *
+ * Exit: 0 if both modes put the same bytes on the wire for every peer
+ *       count and, on a machine with at least 2 CPUs, fan-out beats
+ *       serial at 16 peers; 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sodium.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/rootstream.h"
+
+#define BENCH_FRAMES   300          /* 5 s at 60 fps */
+#define KEYFRAME_BYTES (150 * 1024) /* 1080p IDR */
+#define PFRAME_BYTES   (20 * 1024)  /* 1080p P-frame at ~10 Mbps */
+#define GOP_LENGTH     60
+#define FEC_PERCENT    10
+
+/* ── Link stubs for modules the send path never reaches ──────────── */
+
+void config_add_peer_to_history(rootstream_ctx_t *ctx, const char *code) {
+    (void)ctx; (void)code;
+}
+int peer_reconnect_init(peer_t *peer) { (void)peer; return 0; }
+int peer_try_reconnect(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; return -1; }
+void peer_reconnect_cleanup(peer_t *peer) { (void)peer; }
+int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
+    (void)ctx; (void)event; return 0;
+}
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len) {
+    (void)ctx; (void)peer; (void)payload; (void)len; return 0;
+}
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; }
+int rootstream_net_tcp_connect(rootstream_ctx_t *ctx, peer_t *peer) {
+    (void)ctx; (void)peer; return -1;
+}
+int rootstream_net_tcp_send(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data,
+                            size_t size) {
+    (void)ctx; (void)peer; (void)data; (void)size; return -1;
+}
+int rootstream_net_tcp_recv(rootstream_ctx_t *ctx, peer_t *peer, uint8_t *buffer,
+                            size_t *buffer_len) {
+    (void)ctx; (void)peer; (void)buffer; (void)buffer_len; return -1;
+}
+void rootstream_net_tcp_cleanup(peer_t *peer) { (void)peer; }
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer) { (void)peer; return -1; }
+int rootstream_opus_decode(rootstream_ctx_t *ctx, const uint8_t *in, size_t in_len,
+                           int16_t *pcm, size_t *pcm_len) {
+    (void)ctx; (void)in; (void)in_len; (void)pcm; (void)pcm_len; return -1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static rootstream_ctx_t ctx;
+static int rx_fds[MAX_PEERS];
+static uint64_t samples[BENCH_FRAMES];
+
+/* Receivers: loopback sockets nobody reads (the kernel drops overflow) */
+static int setup_peers(int n) {
+    ctx.num_peers = n;
+    for (int i = 0; i < n; i++) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        rx_fds[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        if (rx_fds[i] < 0 || bind(rx_fds[i], (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            getsockname(rx_fds[i], (struct sockaddr *)&addr, &len) < 0) {
+            perror("receiver socket"); return -1;
+        }
+
+        peer_t *peer = &ctx.peers[i];
+        memset(peer, 0, sizeof(*peer));
+        memcpy(&peer->addr, &addr, sizeof(addr));
+        peer->addr_len          = sizeof(addr);
+        peer->state             = PEER_CONNECTED;
+        peer->transport         = TRANSPORT_UDP;
+        peer->is_streaming      = true;
+        peer->video_fec_percent = FEC_PERCENT;
+        peer->session.authenticated = true;
+        randombytes_buf(peer->session.shared_key, sizeof(peer->session.shared_key));
+        snprintf(peer->hostname, sizeof(peer->hostname), "bench-peer-%d", i);
+    }
+    return 0;
+}
+
+static void teardown_peers(void) {
+    while (ctx.num_peers > 0) {
+        close(rx_fds[ctx.num_peers - 1]);
+        rootstream_remove_peer(&ctx, &ctx.peers[ctx.num_peers - 1]);
+    }
+}
+
+/* Runs one mode; returns p50 in µs, or -1 on a send failure */
+static double run(int peers, int fanout, const uint8_t *frame, uint64_t *bytes) {
+    if (setup_peers(peers) < 0) return -1;
+
+    /* Warm-up keyframe creates the send arenas (and the sender threads) */
+    for (int w = 0; w < 2; w++) {
+        if (fanout) {
+            rootstream_net_send_video_all(&ctx, frame, KEYFRAME_BYTES, 0, true);
+            rootstream_net_flush_video(&ctx);
+        } else {
+            for (int i = 0; i < peers; i++)
+                rootstream_net_send_video(&ctx, &ctx.peers[i], frame, KEYFRAME_BYTES, 0);
+        }
+    }
+
+    uint64_t bytes_start = ctx.bytes_sent;
+    for (int f = 0; f < BENCH_FRAMES; f++) {
+        bool key = f % GOP_LENGTH == 0;
+        size_t size = key ? KEYFRAME_BYTES : PFRAME_BYTES;
+        uint64_t ts = (uint64_t)f * 16667;
+        uint64_t t0 = now_ns();
+
+        if (fanout) {
+            if (rootstream_net_send_video_all(&ctx, frame, size, ts, key) != peers) return -1;
+            rootstream_net_flush_video(&ctx);
+        } else {
+            for (int i = 0; i < peers; i++)
+                if (rootstream_net_send_video(&ctx, &ctx.peers[i], frame, size, ts) < 0) return -1;
+        }
+        samples[f] = now_ns() - t0;
+    }
+    *bytes = ctx.bytes_sent - bytes_start;
+
+    for (int i = 0; i < peers; i++)
+        if (ctx.peers[i].state != PEER_CONNECTED) return -1;
+    teardown_peers();
+
+    qsort(samples, BENCH_FRAMES, sizeof(samples[0]), cmp_u64);
+    double p50 = samples[BENCH_FRAMES / 2] / 1000.0;
+    double p99 = samples[BENCH_FRAMES * 99 / 100] / 1000.0;
+    printf("BENCH fanout: peers=%d mode=%s p50_us=%.0f p99_us=%.0f bytes=%lu\n", peers,
+           fanout ? "fanout" : "serial", p50, p99, (unsigned long)*bytes);
+    return p50;
+}
+
+int main(void) {
+    if (sodium_init() < 0) { fprintf(stderr, "sodium_init failed\n"); return 1; }
+
+    ctx.sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (ctx.sock_fd < 0) { perror("socket"); return 1; }
+    int sndbuf = 4 * 1024 * 1024;
+    setsockopt(ctx.sock_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    uint8_t *frame = malloc(KEYFRAME_BYTES);
+    if (!frame) return 1;
+    randombytes_buf(frame, KEYFRAME_BYTES);
+
+    static const int peer_counts[] = {1, 4, 16};
+    int ok = 1;
+    double serial16 = 0, fanout16 = 0;
+
+    for (size_t i = 0; i < sizeof(peer_counts) / sizeof(peer_counts[0]); i++) {
+        int n = peer_counts[i];
+        uint64_t serial_bytes = 0, fanout_bytes = 0;
+        double s = run(n, 0, frame, &serial_bytes);
+        double f = run(n, 1, frame, &fanout_bytes);
+        if (s < 0 || f < 0) {
+            fprintf(stderr, "send failed with %d peers\n", n);
+            return 1;
+        }
+        if (serial_bytes != fanout_bytes) {
+            fprintf(stderr, "byte mismatch with %d peers\n", n);
+            ok = 0;
+        }
+        if (n == 16) {
+            serial16 = s;
+            fanout16 = f;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 1 ? (int)(cpus - 1 < 4 ? cpus - 1 : 4) : 1;
+    double speedup = fanout16 > 0 ? serial16 / fanout16 : 0.0;
+    printf("BENCH fanout: workers=%d speedup_16=%.2f\n", workers, speedup);
+    if (cpus >= 2 && speedup <= 1.0) ok = 0;
+
+    rootstream_net_cleanup(&ctx);
+    free(frame);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/*
+ * input_batch_bench.c — Packets and host syscalls for a 1000 Hz mouse
+ *
+ * Replays 10 s of input from a 1000 Hz gaming mouse (an REL_X and an
+ * REL_Y every millisecond), a left click every 250 ms and a key stroke
+ * every 500 ms, with the client polling its window at 60 Hz, three ways:
+ *
+ *   legacy    — one PKT_INPUT per event; the host calls gettimeofday()
+ *               and write()s the event and a SYN_REPORT separately, the
+ *               way input.c injected before batching
+ *   batch     — one PKT_INPUT_BATCH per poll, no coalescing; the host
+ *               decodes it and injects with input_batch_inject(), one
+ *               write() per device
+ *   coalesce  — as batch, with relative motion coalesced
+ *
+ * Injection writes go to /dev/null so only their syscall cost is timed.
+ * Wire bytes count the RootStream header, the IPv4/UDP headers and the
+ * payload of each packet.
+ *
+ * Output format:
+ *   BENCH input_<mode>: events=N packets=N wire_bytes=N writes=N
+ *         inject_ns_per_event=X motion_x=N
+ *
+ * Exit: 0 if coalescing sends at least 10× fewer packets and makes at
+ *       least 10× fewer write() calls than legacy while delivering the
+ *       same total motion, 1 otherwise.
+ */
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/rootstream.h"
+#include "input/input_batch.h"
+
+#define SECONDS        10
+#define POLL_US        16667
+#define CLICK_EVERY_MS 250
+#define KEY_EVERY_MS   500
+#define IP_UDP_BYTES   28
+#define TARGET_RATIO   10
+
+typedef enum { MODE_LEGACY, MODE_BATCH, MODE_COALESCE } bench_mode_t;
+
+typedef struct {
+    uint64_t events;
+    uint64_t packets;
+    uint64_t wire_bytes;
+    uint64_t writes;
+    uint64_t inject_ns;
+    int64_t motion_x;
+} result_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* input.c's emit_event() before batching */
+static void legacy_emit(int fd, const input_event_pkt_t *e, result_t *r) {
+    struct input_event ev = {.type = e->type, .code = e->code, .value = e->value};
+    gettimeofday(&ev.time, NULL);
+    if (write(fd, &ev, sizeof(ev)) < 0)
+        exit(1);
+    ev.type = EV_SYN;
+    ev.code = SYN_REPORT;
+    ev.value = 0;
+    if (write(fd, &ev, sizeof(ev)) < 0)
+        exit(1);
+    r->writes += 2;
+}
+
+/* Host side of one PKT_INPUT_BATCH, as rootstream_input_process_batch() */
+static void host_batch(int fd, const uint8_t *payload, size_t len, result_t *r) {
+    input_batch_event_t events[INPUT_BATCH_MAX_EVENTS];
+    input_batch_event_t kbd[INPUT_BATCH_MAX_EVENTS], mouse[INPUT_BATCH_MAX_EVENTS];
+    int nkbd = 0, nmouse = 0;
+
+    int n = input_batch_decode(payload, len, NULL, events, INPUT_BATCH_MAX_EVENTS);
+    if (n < 0)
+        exit(1);
+    for (int i = 0; i < n; i++) {
+        if (events[i].type == EV_REL && events[i].code == REL_X)
+            r->motion_x += events[i].value;
+        if (events[i].type == EV_KEY && events[i].code < BTN_MOUSE)
+            kbd[nkbd++] = events[i];
+        else
+            mouse[nmouse++] = events[i];
+    }
+    if (nkbd > 0) {
+        input_batch_inject(fd, kbd, nkbd);
+        r->writes++;
+    }
+    if (nmouse > 0) {
+        input_batch_inject(fd, mouse, nmouse);
+        r->writes++;
+    }
+}
+
+static void send_batch(int fd, input_batch_t *b, uint16_t *seq, uint64_t t_us, result_t *r) {
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(b, (*seq)++, t_us, payload, sizeof(payload));
+    input_batch_reset(b);
+    if (len == 0)
+        return;
+    r->packets++;
+    r->wire_bytes += IP_UDP_BYTES + sizeof(packet_header_t) + len;
+    uint64_t start = now_ns();
+    host_batch(fd, payload, len, r);
+    r->inject_ns += now_ns() - start;
+}
+
+static void add_event(int fd, bench_mode_t mode, input_batch_t *b, uint16_t *seq, uint8_t type,
+                      uint16_t code, int32_t value, uint64_t t_us, result_t *r) {
+    r->events++;
+    if (mode == MODE_LEGACY) {
+        input_event_pkt_t e = {.type = type, .code = code, .value = value};
+        r->packets++;
+        r->wire_bytes += IP_UDP_BYTES + sizeof(packet_header_t) + sizeof(e);
+        if (type == EV_REL && code == REL_X)
+            r->motion_x += value;
+        uint64_t start = now_ns();
+        legacy_emit(fd, &e, r);
+        r->inject_ns += now_ns() - start;
+        return;
+    }
+    if (input_batch_add(b, type, code, value, t_us) < 0) {
+        send_batch(fd, b, seq, t_us, r);
+        input_batch_add(b, type, code, value, t_us);
+    }
+}
+
+static result_t run(bench_mode_t mode, int fd) {
+    result_t r = {0};
+    input_batch_t batch;
+    uint16_t seq = 0;
+    uint64_t next_poll = POLL_US;
+    uint32_t rng = 12345;
+
+    input_batch_init(&batch, mode == MODE_COALESCE);
+
+    for (uint64_t ms = 0; ms < SECONDS * 1000; ms++) {
+        uint64_t t = ms * 1000;
+        if (t >= next_poll) {
+            if (mode != MODE_LEGACY)
+                send_batch(fd, &batch, &seq, t, &r);
+            next_poll += POLL_US;
+        }
+        rng = rng * 1103515245 + 12345;
+        add_event(fd, mode, &batch, &seq, EV_REL, REL_X, (int32_t)(rng >> 28) - 7, t, &r);
+        add_event(fd, mode, &batch, &seq, EV_REL, REL_Y, (int32_t)((rng >> 24) & 7) - 3, t, &r);
+        if (ms % CLICK_EVERY_MS == 0) {
+            add_event(fd, mode, &batch, &seq, EV_KEY, BTN_LEFT, 1, t, &r);
+            add_event(fd, mode, &batch, &seq, EV_KEY, BTN_LEFT, 0, t + 1, &r);
+        }
+        if (ms % KEY_EVERY_MS == 0) {
+            add_event(fd, mode, &batch, &seq, EV_KEY, KEY_W, 1, t, &r);
+            add_event(fd, mode, &batch, &seq, EV_KEY, KEY_W, 0, t + 1, &r);
+        }
+    }
+    if (mode != MODE_LEGACY)
+        send_batch(fd, &batch, &seq, SECONDS * 1000000ULL, &r);
+    return r;
+}
+
+int main(void) {
+    static const char *names[] = {"legacy", "batch", "coalesce"};
+    result_t res[3];
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+
+    for (int m = MODE_LEGACY; m <= MODE_COALESCE; m++) {
+        res[m] = run((bench_mode_t)m, fd);
+        printf("BENCH input_%s: events=%llu packets=%llu wire_bytes=%llu writes=%llu "
+               "inject_ns_per_event=%.1f motion_x=%lld\n",
+               names[m], (unsigned long long)res[m].events, (unsigned long long)res[m].packets,
+               (unsigned long long)res[m].wire_bytes, (unsigned long long)res[m].writes,
+               (double)res[m].inject_ns / (double)res[m].events, (long long)res[m].motion_x);
+    }
+    close(fd);
+
+    const result_t *l = &res[MODE_LEGACY], *c = &res[MODE_COALESCE];
+    bool ok = c->packets * TARGET_RATIO <= l->packets && c->writes * TARGET_RATIO <= l->writes &&
+              c->motion_x == l->motion_x && res[MODE_BATCH].motion_x == l->motion_x;
+    return ok ? 0 : 1;
+}
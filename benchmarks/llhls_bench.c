@@ -0,0 +1,183 @@
+/*
+ * llhls_bench.c — LL-HLS packaging cost and blocking-reload wake latency
+ *
+ * Packages 60 s of a 6 Mbit/s, 60 fps H.264 stream with 48 kHz AAC into
+ * 200 ms CMAF parts and 2 s segments in memory, as fast as possible.
+ * Then feeds the same stream one frame per millisecond while a reader
+ * thread keeps a blocking playlist reload parked on the next part, and
+ * measures how long after the publishing write() the reader returns.
+ *
+ * Output format:
+ *   BENCH llhls_package: media_s=N segments=N pack_us_per_s=X
+ *   BENCH llhls_reload: wakeups=N p50_us=X p99_us=X max_us=X
+ *
+ * Exit: 0 if a parked reload returns within 2 ms of the publishing
+ *       write() at p99, 1 otherwise.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hls/llhls_packager.h"
+
+#define FPS         60
+#define MEDIA_SEC   60
+#define GOP         120
+#define FRAME_90K   (90000 / FPS)
+#define AUDIO_FRAME 1920 /* 90 kHz ticks per 1024-sample AAC frame */
+#define AUDIO_BYTES 384  /* 128 kbit/s */
+#define KBPS        6000
+#define MAX_WAKEUPS 4096
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static uint8_t au_buf[256 * 1024];
+static uint8_t adts_buf[AUDIO_BYTES + 7];
+
+static size_t make_au(bool kf) {
+    static const uint8_t head[] = {0, 0, 0, 1, 0x67, 0x64, 0x00, 0x28, 0xAC,
+                                   0, 0, 0, 1, 0x68, 0xEB, 0xE3, 0xCB};
+    size_t n = 0;
+    if (kf) {
+        memcpy(au_buf, head, sizeof(head));
+        n = sizeof(head);
+    }
+    /* Keyframes are ~8x a P-frame at the same average bitrate */
+    size_t per_gop = (size_t)KBPS * 125 * GOP / FPS;
+    size_t payload = kf ? per_gop * 8 / (GOP + 7) : per_gop / (GOP + 7);
+    au_buf[n++] = 0;
+    au_buf[n++] = 0;
+    au_buf[n++] = 0;
+    au_buf[n++] = 1;
+    au_buf[n++] = kf ? 0x65 : 0x41;
+    memset(au_buf + n, 0x5A, payload);
+    return n + payload;
+}
+
+static size_t make_adts(void) {
+    size_t len = sizeof(adts_buf);
+    adts_buf[0] = 0xFF;
+    adts_buf[1] = 0xF1;
+    adts_buf[2] = (1 << 6) | (3 << 2);
+    adts_buf[3] = (uint8_t)((2 << 6) | (len >> 11));
+    adts_buf[4] = (uint8_t)(len >> 3);
+    adts_buf[5] = (uint8_t)(((len & 7) << 5) | 0x1F);
+    adts_buf[6] = 0xFC;
+    return len;
+}
+
+static llhls_packager_t *create(void) {
+    llhls_config_t cfg = {.width = 1920, .height = 1080, .with_audio = true};
+    snprintf(cfg.base_name, sizeof(cfg.base_name), "seg");
+    snprintf(cfg.playlist_name, sizeof(cfg.playlist_name), "live.m3u8");
+    return llhls_create(&cfg);
+}
+
+/* Feed frame @k and the audio up to its end */
+static int feed(llhls_packager_t *p, int k, uint64_t *audio_pts) {
+    uint64_t dts = (uint64_t)k * FRAME_90K;
+    if (llhls_write_video(p, au_buf, make_au(k % GOP == 0), dts, dts, k % GOP == 0) != 0)
+        return -1;
+    for (; *audio_pts < dts + FRAME_90K; *audio_pts += AUDIO_FRAME) {
+        if (llhls_write_audio(p, adts_buf, make_adts(), *audio_pts) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* ── Reload wake latency ─────────────────────────────────────────── */
+
+typedef struct {
+    llhls_packager_t *p;
+    _Atomic double last_write_us; /* Start of the newest write */
+    atomic_bool done;
+    double wake_us[MAX_WAKEUPS];
+    int n_wake;
+} reload_ctx_t;
+
+static void *reader(void *arg) {
+    reload_ctx_t *c = arg;
+    while (!atomic_load(&c->done) && c->n_wake < MAX_WAKEUPS) {
+        int64_t msn;
+        int part;
+        llhls_get_position(c->p, &msn, &part);
+        char target[96];
+        snprintf(target, sizeof(target), "/live.m3u8?_HLS_msn=%lld&_HLS_part=%d",
+                 (long long)msn, part);
+        llhls_response_t res;
+        double start = now_us();
+        int status = llhls_handle_request(c->p, target, 500, &res);
+        double t = now_us();
+        if (status != 200)
+            continue;
+        llhls_response_release(&res);
+        /* Count only reloads that were parked when the part was published */
+        double written = atomic_load(&c->last_write_us);
+        if (written > start)
+            c->wake_us[c->n_wake++] = t - written;
+    }
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(void) {
+    /* Packaging cost */
+    llhls_packager_t *p = create();
+    if (!p)
+        return 1;
+    uint64_t audio_pts = 0;
+    double t0 = now_us();
+    for (int k = 0; k < FPS * MEDIA_SEC; k++) {
+        if (feed(p, k, &audio_pts) != 0)
+            return 1;
+    }
+    llhls_finish(p);
+    double elapsed = now_us() - t0;
+    int64_t msn;
+    llhls_get_position(p, &msn, NULL);
+    printf("BENCH llhls_package: media_s=%d segments=%lld pack_us_per_s=%.0f\n", MEDIA_SEC,
+           (long long)msn, elapsed / MEDIA_SEC);
+    llhls_destroy(p);
+
+    /* Blocking reload wake-up */
+    reload_ctx_t *c = calloc(1, sizeof(*c));
+    if (!c || !(c->p = create()))
+        return 1;
+    pthread_t th;
+    pthread_create(&th, NULL, reader, c);
+    audio_pts = 0;
+    for (int k = 0; k < FPS * 20; k++) {
+        atomic_store(&c->last_write_us, now_us());
+        if (feed(c->p, k, &audio_pts) != 0)
+            return 1;
+        usleep(1000);
+    }
+    atomic_store(&c->done, true);
+    pthread_join(th, NULL);
+    llhls_destroy(c->p);
+
+    int n = c->n_wake;
+    double *w = c->wake_us;
+    qsort(w, (size_t)n, sizeof(*w), cmp_double);
+    double p50 = n ? w[n / 2] : 0.0, p99 = n ? w[n * 99 / 100] : 0.0;
+    printf("BENCH llhls_reload: wakeups=%d p50_us=%.0f p99_us=%.0f max_us=%.0f\n", n, p50, p99,
+           n ? w[n - 1] : 0.0);
+    free(c);
+
+    return (n > 0 && p99 < 2000.0) ? 0 : 1;
+}
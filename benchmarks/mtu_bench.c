@@ -0,0 +1,278 @@
+/*
+ * mtu_bench.c — Per-packet cost of 1400- vs 8900-byte video packets
+ *
+ * Moves 256 MB of video over loopback twice: once chunked into
+ * MAX_PACKET_SIZE (1400-byte) datagrams, once into MAX_JUMBO_PACKET_SIZE
+ * (8900-byte) datagrams, the size path MTU probing settles on for a
+ * jumbo-frame LAN.  Loopback's 64 KB MTU carries both unfragmented.
+ *
+ * A sender thread packetizes 128 KB frames the way
+ * rootstream_net_send_video() does (packet header, chunk header, chunk,
+ * room for the MAC) into a 64-slot arena and sends each arena with
+ * udp_batch (sendmmsg + GSO).  It stays at most 1 MB ahead of the
+ * receiver, which drains with udp_rx (epoll + recvmmsg) on the main
+ * thread and touches each chunk header.  CPU time is thread time
+ * (CLOCK_THREAD_CPUTIME_ID) spent packetizing and sending, or receiving
+ * and dispatching, so waits are not counted.
+ *
+ * Then a real search (plpmtud) runs over a loopback socket with
+ * IP_PMTUDISC_PROBE, answering each probe in-process.
+ *
+ * Output format:
+ *   BENCH mtu_<size>: packets=N tx_syscalls=N rx_syscalls=N
+ *         tx_ns_per_mb=X rx_ns_per_mb=X lost=N
+ *   BENCH mtu_search: plpmtu=N probes=N us=N
+ *
+ * Exit: 0 if 8900-byte packets take at least 5× fewer packets and less
+ *       CPU per MB (send plus receive) than 1400-byte ones, 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/rootstream.h"
+#include "network/plpmtud.h"
+#include "network/udp_batch.h"
+#include "network/udp_rx.h"
+
+#define FRAME_BYTES    (128 * 1024)
+#define TOTAL_BYTES    (256ULL * 1024 * 1024)
+#define AHEAD_BYTES    (1024 * 1024)
+#define RCVBUF_BYTES   (4 * 1024 * 1024)
+#define ARENA_PACKETS  64
+#define MAC_BYTES      16
+#define TARGET_RATIO   5
+
+typedef struct {
+    size_t packet_size;
+    struct sockaddr_in dst;
+    atomic_uint_fast64_t received; /* Chunk bytes the receiver has */
+    atomic_int done;
+    uint64_t packets;
+    uint64_t syscalls;
+    uint64_t cpu_ns;
+} sender_t;
+
+typedef struct {
+    uint64_t packets;
+    uint64_t syscalls;
+    uint64_t tx_cpu_ns;
+    uint64_t rx_cpu_ns;
+    uint64_t lost;
+} result_t;
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void *sender_main(void *arg) {
+    sender_t *s = (sender_t *)arg;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int sndbuf = RCVBUF_BYTES;
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    udp_batch_t *batch = udp_batch_create(true);
+    uint8_t *arena = malloc(ARENA_PACKETS * s->packet_size);
+    uint8_t *frame = malloc(FRAME_BYTES);
+    if (fd < 0 || !batch || !arena || !frame) {
+        fprintf(stderr, "sender setup failed\n");
+        exit(1);
+    }
+    memset(frame, 0x5A, FRAME_BYTES);
+
+    size_t max_chunk = s->packet_size - sizeof(packet_header_t) - sizeof(video_chunk_header_t) -
+                       MAC_BYTES;
+    uint64_t sent = 0;
+    int used = 0;
+    for (uint32_t frame_id = 1; sent < TOTAL_BYTES; frame_id++) {
+        while (sent - atomic_load(&s->received) > AHEAD_BYTES)
+            usleep(20);
+
+        uint64_t t0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        for (size_t offset = 0; offset < FRAME_BYTES; offset += max_chunk) {
+            size_t chunk = FRAME_BYTES - offset < max_chunk ? FRAME_BYTES - offset : max_chunk;
+            uint8_t *pkt = arena + (size_t)used * s->packet_size;
+            packet_header_t hdr = {.magic = 0x524F4F54, .version = PROTOCOL_VERSION,
+                                   .type = PKT_VIDEO, .nonce = s->packets,
+                                   .payload_size = (uint16_t)(sizeof(video_chunk_header_t) +
+                                                              chunk + MAC_BYTES)};
+            video_chunk_header_t ch = {.frame_id = frame_id, .total_size = FRAME_BYTES,
+                                       .offset = (uint32_t)offset, .chunk_size = (uint16_t)chunk};
+            memcpy(pkt, &hdr, sizeof(hdr));
+            memcpy(pkt + sizeof(hdr), &ch, sizeof(ch));
+            memcpy(pkt + sizeof(hdr) + sizeof(ch), frame + offset, chunk);
+            size_t len = sizeof(hdr) + sizeof(ch) + chunk + MAC_BYTES;
+            udp_batch_add(batch, pkt, len);
+            s->packets++;
+            sent += chunk;
+            if (++used == ARENA_PACKETS) {
+                udp_batch_flush(batch, fd, (struct sockaddr *)&s->dst, sizeof(s->dst));
+                used = 0;
+            }
+        }
+        if (used > 0) {
+            udp_batch_flush(batch, fd, (struct sockaddr *)&s->dst, sizeof(s->dst));
+            used = 0;
+        }
+        s->cpu_ns += clock_ns(CLOCK_THREAD_CPUTIME_ID) - t0;
+    }
+
+    udp_batch_stats_t st;
+    udp_batch_get_stats(batch, &st);
+    s->syscalls = st.syscalls;
+    udp_batch_destroy(batch);
+    free(arena);
+    free(frame);
+    close(fd);
+    atomic_store(&s->done, 1);
+    return NULL;
+}
+
+/* Per-datagram dispatch stand-in: read the chunk header */
+static volatile uint32_t sink;
+static size_t dispatch(const uint8_t *data, size_t len) {
+    video_chunk_header_t ch;
+    if (len < sizeof(packet_header_t) + sizeof(ch))
+        return 0;
+    memcpy(&ch, data + sizeof(packet_header_t), sizeof(ch));
+    sink += ch.frame_id + data[len - 1];
+    return ch.chunk_size;
+}
+
+static int run(size_t packet_size, result_t *r) {
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = RCVBUF_BYTES;
+    setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sender_t *s = calloc(1, sizeof(*s));
+    s->packet_size = packet_size;
+    s->dst.sin_family = AF_INET;
+    s->dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(s->dst);
+    if (rx_fd < 0 || bind(rx_fd, (struct sockaddr *)&s->dst, sizeof(s->dst)) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&s->dst, &len) < 0) {
+        perror("receiver socket");
+        return -1;
+    }
+    udp_rx_t *rx = udp_rx_create(rx_fd, UDP_RX_MAX_BATCH, MAX_JUMBO_PACKET_SIZE);
+    if (!rx) {
+        fprintf(stderr, "udp_rx_create failed\n");
+        return -1;
+    }
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, sender_main, s);
+
+    uint64_t received = 0, cpu_ns = 0, packets = 0;
+    int idle = 0;
+    while (!atomic_load(&s->done) || idle < 5) {
+        if (udp_rx_wait(rx, 10) <= 0) {
+            idle += atomic_load(&s->done);
+            continue;
+        }
+        idle = 0;
+        uint64_t t0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+        int n;
+        while ((n = udp_rx_recv(rx)) > 0) {
+            for (int i = 0; i < n; i++) {
+                udp_rx_packet_t *p = udp_rx_packet(rx, i);
+                received += dispatch(p->data, p->len);
+            }
+            packets += (uint64_t)n;
+            if (n < UDP_RX_MAX_BATCH)
+                break;
+        }
+        cpu_ns += clock_ns(CLOCK_THREAD_CPUTIME_ID) - t0;
+        atomic_store(&s->received, received);
+    }
+    pthread_join(tid, NULL);
+
+    udp_rx_stats_t st;
+    udp_rx_get_stats(rx, &st);
+    r->packets = s->packets;
+    r->syscalls = s->syscalls;
+    r->tx_cpu_ns = s->cpu_ns;
+    r->rx_cpu_ns = cpu_ns;
+    r->lost = s->packets - packets;
+
+    double mb = (double)TOTAL_BYTES / (1024.0 * 1024.0);
+    printf("BENCH mtu_%zu: packets=%llu tx_syscalls=%llu rx_syscalls=%llu tx_ns_per_mb=%.0f "
+           "rx_ns_per_mb=%.0f lost=%llu\n",
+           packet_size, (unsigned long long)r->packets, (unsigned long long)r->syscalls,
+           (unsigned long long)st.syscalls, (double)r->tx_cpu_ns / mb,
+           (double)r->rx_cpu_ns / mb, (unsigned long long)r->lost);
+
+    udp_rx_destroy(rx);
+    close(rx_fd);
+    free(s);
+    return 0;
+}
+
+/* Search the loopback path with real probes; the receiver acks in-process */
+static void search(void) {
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in dst = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t len = sizeof(dst);
+    struct timeval tv = {.tv_sec = 0, .tv_usec = 10000};
+    int probe = IP_PMTUDISC_PROBE;
+    if (tx_fd < 0 || rx_fd < 0 || bind(rx_fd, (struct sockaddr *)&dst, len) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&dst, &len) < 0 ||
+        setsockopt(tx_fd, IPPROTO_IP, IP_MTU_DISCOVER, &probe, sizeof(probe)) < 0) {
+        perror("search socket");
+        return;
+    }
+    setsockopt(rx_fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    plpmtud_t *p = plpmtud_create(PLPMTUD_MIN_SIZE, MAX_JUMBO_PACKET_SIZE);
+    static uint8_t buf[MAX_JUMBO_PACKET_SIZE];
+    uint64_t start = clock_ns(CLOCK_MONOTONIC) / 1000;
+    uint64_t now = start;
+    while (plpmtud_state(p) != PLPMTUD_SEARCH_COMPLETE && now - start < 10000000) {
+        uint32_t id;
+        size_t size = plpmtud_poll(p, now, &id);
+        if (size > 0) {
+            plpmtud_encode(PLPMTUD_KIND_PROBE, id, (uint16_t)size, buf, size);
+            if (sendto(tx_fd, buf, size, 0, (struct sockaddr *)&dst, sizeof(dst)) < 0 &&
+                errno == EMSGSIZE)
+                plpmtud_on_too_big(p, now);
+        }
+        uint8_t kind;
+        uint16_t got;
+        ssize_t n = recv(rx_fd, buf, sizeof(buf), 0);
+        now = clock_ns(CLOCK_MONOTONIC) / 1000;
+        if (n > 0 && plpmtud_decode(buf, (size_t)n, &kind, &id, &got) == 0)
+            plpmtud_on_ack(p, id, now);
+    }
+
+    plpmtud_stats_t st;
+    plpmtud_get_stats(p, &st);
+    printf("BENCH mtu_search: plpmtu=%zu probes=%llu us=%llu\n", plpmtud_size(p),
+           (unsigned long long)st.probes_sent, (unsigned long long)(now - start));
+    plpmtud_destroy(p);
+    close(tx_fd);
+    close(rx_fd);
+}
+
+int main(void) {
+    result_t small, jumbo;
+    if (run(MAX_PACKET_SIZE, &small) < 0 || run(MAX_JUMBO_PACKET_SIZE, &jumbo) < 0)
+        return 1;
+    search();
+
+    bool ok = jumbo.packets * TARGET_RATIO <= small.packets &&
+              jumbo.tx_cpu_ns + jumbo.rx_cpu_ns < small.tx_cpu_ns + small.rx_cpu_ns;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+/*
+ * nack_bench.c — Keyframe requests under random loss, with and without NACK
+ *
+ * Simulates 60 s of 60 fps video (~150 KB keyframes, ~20 KB P-frames,
+ * 1376-byte chunks paced at 50 Mbit/s) over a link with 20 ms one-way
+ * delay, up to 1 ms jitter and 1–3 % independent random loss in both
+ * directions.  FEC is off so only retransmission repairs frames.  The
+ * receiver is the network.c client path:
+ *
+ *   off   — frame_reasm alone; a frame handed out after a gap triggers a
+ *           keyframe request (at most one per 250 ms), and the sender's
+ *           next frame is a keyframe once the request reaches it
+ *   nack  — as above plus nack_tracker: NACKs built every 1 ms tick
+ *           travel back over the lossy link, the sender resends the
+ *           cached packets from a nack_cache, and frame_reasm holds
+ *           incomplete frames for nack_tracker_hold_ms()
+ *
+ * Output format:
+ *   BENCH nack_<mode>_loss<P>: frames=N delivered=N dropped=N keyframe_reqs=N
+ *         keyframe_reqs_per_min=X nacks=N resent=N overhead_pct=X
+ *
+ * Exit: 0 if NACK cuts keyframe requests per minute by at least 4× at
+ *       every loss rate, 1 otherwise.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chunk/frame_reasm.h"
+#include "network/nack.h"
+
+#define SECONDS        60
+#define FPS            60
+#define GOP_LENGTH     600
+#define KEYFRAME_BYTES (150 * 1024)
+#define PFRAME_BYTES   (20 * 1024)
+#define CHUNK_BYTES    1376
+#define LINK_BPS       50000000.0
+#define DELAY_US       20000
+#define JITTER_US      1000
+#define TICK_US        1000
+#define KF_REQUEST_MS  250
+#define MAX_EVENTS     (1 << 16)
+#define TARGET_RATIO   4.0
+
+typedef enum { EV_CHUNK, EV_NACK, EV_KEYFRAME_REQ } ev_type_t;
+
+typedef struct {
+    uint64_t at_us;
+    ev_type_t type;
+    uint32_t frame_id;
+    uint32_t total;
+    uint32_t offset;
+    uint32_t len;
+    uint64_t nonce;
+    bool retransmit;
+    uint16_t nack_len;
+    uint8_t nack[NACK_MAX_PAYLOAD];
+} event_t;
+
+/* What the sender's cache holds in place of a sealed packet */
+typedef struct {
+    uint32_t frame_id, total, offset, len;
+} wire_chunk_t;
+
+static event_t *heap;
+static int heap_n;
+
+static uint64_t rng_state;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+static bool lost(double loss_pct) {
+    return rng() % 100000 < (uint32_t)(loss_pct * 1000.0);
+}
+
+static void heap_push(const event_t *e) {
+    if (heap_n == MAX_EVENTS) {
+        fprintf(stderr, "event heap full\n");
+        exit(1);
+    }
+    int i = heap_n++;
+    while (i > 0 && heap[(i - 1) / 2].at_us > e->at_us) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = *e;
+}
+
+static void heap_pop(event_t *out) {
+    *out = heap[0];
+    event_t last = heap[--heap_n];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= heap_n)
+            break;
+        if (c + 1 < heap_n && heap[c + 1].at_us < heap[c].at_us)
+            c++;
+        if (last.at_us <= heap[c].at_us)
+            break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    if (heap_n > 0)
+        heap[i] = last;
+}
+
+/* Put an event on the wire at send_us; the link may drop it */
+static void transmit(event_t *e, uint64_t send_us, double loss_pct) {
+    if (lost(loss_pct))
+        return;
+    e->at_us = send_us + DELAY_US + rng() % JITTER_US;
+    heap_push(e);
+}
+
+typedef struct {
+    uint32_t frames;
+    uint32_t delivered;
+    uint32_t keyframe_reqs;
+    uint64_t nacks;
+    uint64_t resent;
+    uint64_t sent;
+} result_t;
+
+static result_t run(double loss_pct, bool use_nack) {
+    static uint8_t frame_data[KEYFRAME_BYTES];
+    result_t res = {0};
+    rng_state = 0x9E3779B97F4A7C15ULL;
+    heap_n = 0;
+
+    frame_reasm_t *reasm = frame_reasm_create(0, 0, 0);
+    nack_tracker_t *tracker = use_nack ? nack_tracker_create(0) : NULL;
+    nack_cache_t *cache = use_nack ? nack_cache_create(sizeof(wire_chunk_t)) : NULL;
+    if (!reasm || (use_nack && (!tracker || !cache))) {
+        fprintf(stderr, "allocation failed\n");
+        exit(1);
+    }
+
+    uint64_t nonce = 0;
+    uint64_t link_free_us = 0;
+    bool keyframe_wanted = false;
+    uint64_t last_kf_req_ms = 0;
+    bool kf_req_sent = false;
+    const uint64_t frame_us = 1000000 / FPS;
+    const uint64_t end_us = (uint64_t)SECONDS * 1000000;
+
+    for (uint64_t now = 0; now < end_us + 200000; now += TICK_US) {
+        /* Sender: next frame, chunks paced at the link rate */
+        uint32_t frame_id = (uint32_t)(now / frame_us);
+        if (now < end_us && now % frame_us < TICK_US) {
+            bool key = frame_id % GOP_LENGTH == 0 || keyframe_wanted;
+            keyframe_wanted = false;
+            uint32_t total = key ? KEYFRAME_BYTES : PFRAME_BYTES;
+            uint64_t t = link_free_us > now ? link_free_us : now;
+            for (uint32_t off = 0; off < total; off += CHUNK_BYTES) {
+                uint32_t len = total - off < CHUNK_BYTES ? total - off : CHUNK_BYTES;
+                wire_chunk_t w = {frame_id, total, off, len};
+                nack_cache_store(cache, nonce, (const uint8_t *)&w, sizeof(w));
+                event_t e = {.type = EV_CHUNK, .frame_id = frame_id, .total = total,
+                             .offset = off, .len = len, .nonce = nonce++};
+                transmit(&e, t, loss_pct);
+                t += (uint64_t)((len + 80) * 8 / LINK_BPS * 1e6);
+                res.sent++;
+            }
+            link_free_us = t;
+            res.frames++;
+        }
+
+        /* Everything that has arrived by now, at either end */
+        while (heap_n > 0 && heap[0].at_us <= now) {
+            event_t e;
+            heap_pop(&e);
+            if (e.type == EV_CHUNK) {
+                nack_tracker_on_chunk(tracker, e.frame_id, e.nonce, e.offset, e.len, e.total,
+                                      e.retransmit, e.at_us);
+                if (frame_reasm_add(reasm, e.frame_id, e.total, e.offset,
+                                    frame_data + e.offset, e.len, e.frame_id,
+                                    e.at_us / 1000) == FRAME_REASM_COMPLETE) {
+                    nack_tracker_on_complete(tracker, e.frame_id);
+                }
+            } else if (e.type == EV_NACK) {
+                uint64_t nonces[NACK_MAX_NONCES];
+                int n = nack_decode(e.nack, e.nack_len, nonces, NACK_MAX_NONCES);
+                uint64_t t = link_free_us > e.at_us ? link_free_us : e.at_us;
+                for (int i = 0; i < n; i++) {
+                    wire_chunk_t w;
+                    if (nack_cache_fetch(cache, nonces[i], (uint8_t *)&w, sizeof(w)) == 0)
+                        continue;
+                    event_t r = {.type = EV_CHUNK, .frame_id = w.frame_id, .total = w.total,
+                                 .offset = w.offset, .len = w.len, .nonce = nonces[i],
+                                 .retransmit = true};
+                    transmit(&r, t, loss_pct);
+                    t += (uint64_t)((w.len + 80) * 8 / LINK_BPS * 1e6);
+                    res.resent++;
+                }
+                link_free_us = t;
+            } else {
+                keyframe_wanted = true;
+            }
+        }
+
+        /* Receiver tick */
+        if (use_nack) {
+            event_t e = {.type = EV_NACK};
+            size_t len = nack_tracker_poll(tracker, reasm, now, e.nack, sizeof(e.nack));
+            if (len > 0) {
+                e.nack_len = (uint16_t)len;
+                res.nacks++;
+                transmit(&e, now, loss_pct);
+            }
+            frame_reasm_set_reorder(reasm, nack_tracker_hold_ms(tracker));
+        }
+
+        frame_reasm_frame_t f;
+        while (frame_reasm_pop(reasm, now / 1000, &f) == 1) {
+            res.delivered++;
+            uint64_t now_ms = now / 1000;
+            if (f.after_gap && (!kf_req_sent || now_ms - last_kf_req_ms >= KF_REQUEST_MS)) {
+                kf_req_sent = true;
+                last_kf_req_ms = now_ms;
+                res.keyframe_reqs++;
+                event_t e = {.type = EV_KEYFRAME_REQ};
+                transmit(&e, now, loss_pct);
+            }
+        }
+    }
+
+    nack_cache_destroy(cache);
+    nack_tracker_destroy(tracker);
+    frame_reasm_destroy(reasm);
+    return res;
+}
+
+int main(void) {
+    static const double losses[] = {1.0, 2.0, 3.0};
+    heap = malloc(sizeof(event_t) * MAX_EVENTS);
+    if (!heap) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(losses) / sizeof(losses[0]); i++) {
+        double per_min[2];
+        for (int mode = 0; mode < 2; mode++) {
+            result_t r = run(losses[i], mode == 1);
+            per_min[mode] = r.keyframe_reqs * 60.0 / SECONDS;
+            printf("BENCH nack_%s_loss%.0f: frames=%u delivered=%u dropped=%u "
+                   "keyframe_reqs=%u keyframe_reqs_per_min=%.1f nacks=%llu resent=%llu "
+                   "overhead_pct=%.2f\n",
+                   mode ? "on" : "off", losses[i], r.frames, r.delivered,
+                   r.frames - r.delivered, r.keyframe_reqs, per_min[mode],
+                   (unsigned long long)r.nacks, (unsigned long long)r.resent,
+                   r.sent ? 100.0 * (double)r.resent / (double)r.sent : 0.0);
+        }
+        if (per_min[1] * TARGET_RATIO > per_min[0])
+            ok = false;
+    }
+
+    free(heap);
+    return ok ? 0 : 1;
+}
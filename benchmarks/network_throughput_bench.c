@@ -1,14 +1,23 @@
 /*
- * network_throughput_bench.c — Benchmark TCP loopback throughput
+ * network_throughput_bench.c — Benchmark TCP and UDP loopback send paths
  *
  * Creates a loopback TCP connection (server thread + client thread),
  * transfers 10 MB of data in 64 KB chunks, and measures throughput (MB/s)
  * and round-trip latency (µs) using POSIX sockets and clock_gettime.
  *
+ * Then sends 300 video-sized frames (~200 KB as 1400-byte datagrams) over
+ * loopback UDP three ways — one sendto() per packet, udp_batch with
+ * sendmmsg only, and udp_batch with UDP GSO — and reports syscalls per
+ * frame and sender CPU time (user + sys, getrusage) per Mbit sent.
+ *
  * Output format:
  *   BENCH tcp_loopback: throughput=X MB/s latency=Xus
+ *   BENCH udp_sendto: syscalls_per_frame=X cpu_us_per_mbit=X
+ *   BENCH udp_sendmmsg: syscalls_per_frame=X cpu_us_per_mbit=X
+ *   BENCH udp_gso: syscalls_per_frame=X cpu_us_per_mbit=X gso=on|off
  *
- * Exit: 0 if throughput >= 100 MB/s, 1 otherwise.
+ * Exit: 0 if throughput >= 100 MB/s and batching cuts syscalls per frame
+ *       below the sendto() baseline, 1 otherwise.
  */
 
 #include <arpa/inet.h>
@@ -19,15 +28,24 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "network/udp_batch.h"
+
 #define TRANSFER_BYTES  (10 * 1024 * 1024)   /* 10 MB */
 #define CHUNK_SIZE      (64 * 1024)           /* 64 KB */
 #define LOOPBACK_PORT   17329
 #define TARGET_MBPS     100.0
 
+#define UDP_FRAMES      300
+#define UDP_FRAME_BYTES (200 * 1024)          /* 1080p keyframe-sized */
+#define UDP_PACKET      1400                  /* Default RootStream datagram */
+
+typedef enum { UDP_MODE_SENDTO, UDP_MODE_SENDMMSG, UDP_MODE_GSO } udp_mode_t;
+
 typedef struct {
     int listen_fd;
     int conn_fd;
@@ -64,6 +82,95 @@ static void *server_thread(void *arg) {
     return NULL;
 }
 
+static double cpu_time_us(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1e6 +
+           (double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+/* Send UDP_FRAMES frames to dst (receiver never reads); returns syscalls/frame */
+static double bench_udp(udp_mode_t mode, const struct sockaddr_in *dst, const uint8_t *frame) {
+    static const char *names[] = {"udp_sendto", "udp_sendmmsg", "udp_gso"};
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) { perror("socket"); return -1; }
+
+    udp_batch_t *batch = NULL;
+    if (mode != UDP_MODE_SENDTO) {
+        batch = udp_batch_create(mode == UDP_MODE_GSO);
+        if (!batch) { close(fd); return -1; }
+    }
+
+    uint64_t syscalls = 0;
+    uint64_t bytes = 0;
+    double cpu0 = cpu_time_us();
+
+    for (int f = 0; f < UDP_FRAMES; f++) {
+        for (size_t off = 0; off < UDP_FRAME_BYTES; off += UDP_PACKET) {
+            size_t len = UDP_FRAME_BYTES - off;
+            if (len > UDP_PACKET) len = UDP_PACKET;
+
+            if (!batch) {
+                sendto(fd, frame + off, len, 0, (const struct sockaddr *)dst, sizeof(*dst));
+                syscalls++;
+            } else {
+                if (udp_batch_count(batch) == UDP_BATCH_MAX_PACKETS)
+                    udp_batch_flush(batch, fd, (const struct sockaddr *)dst, sizeof(*dst));
+                udp_batch_add(batch, frame + off, len);
+            }
+            bytes += len;
+        }
+        if (batch)
+            udp_batch_flush(batch, fd, (const struct sockaddr *)dst, sizeof(*dst));
+    }
+
+    double cpu_us = cpu_time_us() - cpu0;
+
+    if (batch) {
+        udp_batch_stats_t st;
+        udp_batch_get_stats(batch, &st);
+        syscalls = st.syscalls;
+    }
+
+    double spf = (double)syscalls / UDP_FRAMES;
+    double mbit = (double)bytes * 8.0 / 1e6;
+    printf("BENCH %s: syscalls_per_frame=%.1f cpu_us_per_mbit=%.2f", names[mode], spf,
+           cpu_us / mbit);
+    if (mode == UDP_MODE_GSO)
+        printf(" gso=%s", udp_batch_gso_active(batch) ? "on" : "off");
+    printf("\n");
+
+    udp_batch_destroy(batch);
+    close(fd);
+    return spf;
+}
+
+static int run_udp_benches(void) {
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in dst;
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family      = AF_INET;
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t dst_len = sizeof(dst);
+    if (rx_fd < 0 || bind(rx_fd, (struct sockaddr *)&dst, sizeof(dst)) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&dst, &dst_len) < 0) {
+        perror("udp receiver"); return 1;
+    }
+
+    uint8_t *frame = malloc(UDP_FRAME_BYTES);
+    if (!frame) { close(rx_fd); return 1; }
+    memset(frame, 0xCD, UDP_FRAME_BYTES);
+
+    double base = bench_udp(UDP_MODE_SENDTO, &dst, frame);
+    double mmsg = bench_udp(UDP_MODE_SENDMMSG, &dst, frame);
+    double gso  = bench_udp(UDP_MODE_GSO, &dst, frame);
+
+    free(frame);
+    close(rx_fd);
+    return (base > 0 && mmsg >= 0 && gso >= 0 && mmsg < base && gso <= mmsg) ? 0 : 1;
+}
+
 int main(void) {
     /* ------------------------------------------------------------------ */
     /* Set up listening socket                                              */
@@ -154,5 +261,7 @@ int main(void) {
     printf("BENCH tcp_loopback: throughput=%.1f MB/s latency=%ldus\n",
            mbps, first_chunk_us);
 
-    return (mbps >= TARGET_MBPS) ? 0 : 1;
+    int udp_rc = run_udp_benches();
+
+    return (mbps >= TARGET_MBPS && udp_rc == 0) ? 0 : 1;
 }
@@ -0,0 +1,249 @@
+/*
+ * pacer_bench.c — Inter-packet gaps of a keyframe, burst vs. paced
+ *
+ * Sends 20 ~300 KB keyframes (215 × 1400-byte datagrams each, 250 ms
+ * apart) at a loopback socket two ways:
+ *
+ *   burst  — udp_batch with GSO, 64 packets per flush, the way
+ *            rootstream_net_send_video() sent before pacing
+ *   paced  — tx_pacer at 40 Mbit/s (NET_PACING_GAIN × a 20 Mbit/s stream)
+ *
+ * A receiver thread reads the kernel receive timestamp (SO_TIMESTAMPNS)
+ * of every datagram; on loopback that is the moment the sender's
+ * syscall delivered it.  Gaps are taken between consecutive packets of
+ * the same frame.
+ *
+ * Output format:
+ *   BENCH pacer_<mode>: frames=N packets=N lost=N gap_p50_us=X gap_p99_us=X
+ *         ideal_gap_us=X max_burst=N spread_ms=X
+ *   BENCH pacer_<mode>_hist: lt10=N 10_50=N 50_100=N 100_200=N 200_500=N
+ *         500_1000=N ge1000=N
+ *   BENCH pacer_paced_thread: wakeups=N max_late_us=N dropped=N
+ *
+ * max_burst is the longest run of packets less than 10 µs apart;
+ * spread_ms the mean time from a frame's first packet to its last.
+ *
+ * Exit: 0 if the paced median gap is within 25 % of the ideal
+ *       len × 8 / rate, no paced burst exceeds twice the bucket depth
+ *       and no paced packet is lost, 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "network/tx_pacer.h"
+#include "network/udp_batch.h"
+
+#define FRAMES         20
+#define FRAME_PACKETS  215           /* ~300 KB IDR */
+#define PACKET_BYTES   1400
+#define FRAME_GAP_US   250000
+#define PACE_BPS       40000000ULL
+#define BURST_GAP_US   10.0
+#define RCVBUF_BYTES   (4 * 1024 * 1024)
+#define TARGET_SLACK   0.25
+
+static const double bucket_edges[] = {10, 50, 100, 200, 500, 1000};
+#define BUCKETS 7
+
+/* Arrival time (ns, CLOCK_REALTIME) of each packet, 0 = not received */
+static uint64_t arrival_ns[FRAMES][FRAME_PACKETS];
+static atomic_int rx_done;
+
+typedef struct {
+    int fd;
+} receiver_t;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void *receiver_main(void *arg) {
+    receiver_t *r = arg;
+    uint8_t buf[2048];
+    union {
+        char buf[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } ctrl;
+    struct pollfd pfd = {.fd = r->fd, .events = POLLIN};
+
+    while (!atomic_load(&rx_done)) {
+        if (poll(&pfd, 1, 10) <= 0)
+            continue;
+        struct iovec iov = {.iov_base = buf, .iov_len = sizeof(buf)};
+        struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1,
+                             .msg_control = ctrl.buf, .msg_controllen = sizeof(ctrl.buf)};
+        ssize_t n = recvmsg(r->fd, &msg, 0);
+        if (n < 4)
+            continue;
+
+        uint64_t at = 0;
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                at = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+            }
+        }
+        uint16_t frame, idx;
+        memcpy(&frame, buf, 2);
+        memcpy(&idx, buf + 2, 2);
+        if (frame < FRAMES && idx < FRAME_PACKETS && at)
+            arrival_ns[frame][idx] = at;
+    }
+    return NULL;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    double p50, p99;
+    int max_burst;
+    int lost;
+} result_t;
+
+static result_t report(const char *mode) {
+    static double gaps[FRAMES * FRAME_PACKETS];
+    int hist[BUCKETS] = {0};
+    int ngaps = 0, packets = 0, max_burst = 0;
+    double spread_sum = 0;
+    int spread_frames = 0;
+
+    for (int f = 0; f < FRAMES; f++) {
+        uint64_t prev = 0, first = 0;
+        int run = 1;
+        for (int i = 0; i < FRAME_PACKETS; i++) {
+            uint64_t at = arrival_ns[f][i];
+            if (!at)
+                continue;
+            packets++;
+            if (!first)
+                first = at;
+            if (prev) {
+                double gap = at > prev ? (double)(at - prev) / 1000.0 : 0.0;
+                gaps[ngaps++] = gap;
+                int b = 0;
+                while (b < BUCKETS - 1 && gap >= bucket_edges[b])
+                    b++;
+                hist[b]++;
+                run = gap < BURST_GAP_US ? run + 1 : 1;
+                if (run > max_burst)
+                    max_burst = run;
+            }
+            prev = at;
+        }
+        if (first && prev > first) {
+            spread_sum += (double)(prev - first) / 1e6;
+            spread_frames++;
+        }
+    }
+
+    qsort(gaps, (size_t)ngaps, sizeof(gaps[0]), cmp_double);
+    result_t r = {.p50 = ngaps ? gaps[ngaps / 2] : 0,
+                  .p99 = ngaps ? gaps[ngaps * 99 / 100] : 0,
+                  .max_burst = max_burst,
+                  .lost = FRAMES * FRAME_PACKETS - packets};
+    printf("BENCH pacer_%s: frames=%d packets=%d lost=%d gap_p50_us=%.1f gap_p99_us=%.1f "
+           "ideal_gap_us=%.1f max_burst=%d spread_ms=%.2f\n",
+           mode, FRAMES, packets, r.lost, r.p50, r.p99, PACKET_BYTES * 8.0 / PACE_BPS * 1e6,
+           max_burst, spread_frames ? spread_sum / spread_frames : 0.0);
+    printf("BENCH pacer_%s_hist: lt10=%d 10_50=%d 50_100=%d 100_200=%d 200_500=%d "
+           "500_1000=%d ge1000=%d\n",
+           mode, hist[0], hist[1], hist[2], hist[3], hist[4], hist[5], hist[6]);
+    return r;
+}
+
+static result_t run(bool paced, int tx_fd, const struct sockaddr_in *dst) {
+    static uint8_t packets[FRAME_PACKETS][PACKET_BYTES];
+    memset(arrival_ns, 0, sizeof(arrival_ns));
+
+    udp_batch_t *batch = udp_batch_create(true);
+    tx_pacer_t *pacer = paced ? tx_pacer_create(tx_fd, 1, PACKET_BYTES) : NULL;
+    int flow = paced ? tx_pacer_flow_open(pacer, (const struct sockaddr *)dst, sizeof(*dst)) : -1;
+    if (!batch || (paced && flow < 0)) {
+        fprintf(stderr, "setup failed\n");
+        exit(1);
+    }
+    tx_pacer_set_rate(pacer, flow, PACE_BPS);
+
+    for (uint16_t f = 0; f < FRAMES; f++) {
+        uint64_t start = now_us();
+        for (uint16_t i = 0; i < FRAME_PACKETS; i++) {
+            memset(packets[i], 0x5A, PACKET_BYTES);
+            memcpy(packets[i], &f, 2);
+            memcpy(packets[i] + 2, &i, 2);
+            if (paced) {
+                tx_pacer_enqueue(pacer, flow, packets[i], PACKET_BYTES, NULL);
+                continue;
+            }
+            udp_batch_add(batch, packets[i], PACKET_BYTES);
+            if (udp_batch_count(batch) == UDP_BATCH_MAX_PACKETS || i == FRAME_PACKETS - 1)
+                udp_batch_flush(batch, tx_fd, (const struct sockaddr *)dst, sizeof(*dst));
+        }
+        uint64_t elapsed = now_us() - start;
+        if (elapsed < FRAME_GAP_US)
+            usleep((useconds_t)(FRAME_GAP_US - elapsed));
+    }
+
+    if (paced) {
+        tx_pacer_stats_t st;
+        tx_pacer_get_stats(pacer, &st);
+        printf("BENCH pacer_paced_thread: wakeups=%llu max_late_us=%llu dropped=%llu\n",
+               (unsigned long long)st.wakeups, (unsigned long long)st.max_late_us,
+               (unsigned long long)st.dropped);
+    }
+    tx_pacer_destroy(pacer);
+    udp_batch_destroy(batch);
+    usleep(20000); /* Let the receiver drain */
+    return report(paced ? "paced" : "burst");
+}
+
+int main(void) {
+    struct sockaddr_in dst = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t len = sizeof(dst);
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int on = 1, rcvbuf = RCVBUF_BYTES;
+    if (rx_fd < 0 || tx_fd < 0 || bind(rx_fd, (struct sockaddr *)&dst, len) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&dst, &len) < 0) {
+        perror("socket");
+        return 1;
+    }
+    setsockopt(rx_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    if (setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf)) < 0)
+        setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    receiver_t r = {.fd = rx_fd};
+    pthread_t rx;
+    pthread_create(&rx, NULL, receiver_main, &r);
+
+    result_t burst = run(false, tx_fd, &dst);
+    result_t paced = run(true, tx_fd, &dst);
+
+    atomic_store(&rx_done, 1);
+    pthread_join(rx, NULL);
+    close(rx_fd);
+    close(tx_fd);
+
+    double ideal = PACKET_BYTES * 8.0 / PACE_BPS * 1e6;
+    bool ok = paced.p50 > ideal * (1 - TARGET_SLACK) && paced.p50 < ideal * (1 + TARGET_SLACK) &&
+              paced.max_burst <= 2 * TX_PACER_BURST_PACKETS && paced.lost == 0;
+    (void)burst;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/*
+ * packetize_alloc_bench.c — Heap allocations in the video send path
+ *
+ * Drives the real rootstream_net_send_video() (src/network.c) against a
+ * loopback UDP receiver with a mix of keyframe-sized (~150 KB) and
+ * P-frame-sized (~20 KB) payloads, and counts every malloc/calloc/realloc
+ * made while sending.  The linker's --wrap option redirects the
+ * allocator calls of the linked RootStream objects through counters
+ * below; libc and libsodium internals are not affected.
+ *
+ * The first frame is a warm-up (it creates the peer's send arena); after
+ * that the path must not allocate at all.
+ *
+ * Output format:
+ *   BENCH packetize_alloc: frames=N chunks=N allocs_per_frame=X ns_per_chunk=X
+ *
+ * Exit: 0 if steady-state allocations == 0, 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sodium.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/rootstream.h"
+
+#define BENCH_FRAMES    600          /* 10 s at 60 fps */
+#define KEYFRAME_BYTES  (150 * 1024) /* 1080p IDR */
+#define PFRAME_BYTES    (20 * 1024)  /* 1080p P-frame at ~10 Mbps */
+#define GOP_LENGTH      60
+
+/* ── Allocation counters (link with -Wl,--wrap=malloc,...) ──────── */
+
+static int counting = 0;
+static uint64_t alloc_calls = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    if (counting) alloc_calls++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    if (counting) alloc_calls++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (counting) alloc_calls++;
+    return __real_realloc(ptr, size);
+}
+
+/* ── Link stubs for modules the send path never reaches ──────────── */
+
+void config_add_peer_to_history(rootstream_ctx_t *ctx, const char *code) {
+    (void)ctx; (void)code;
+}
+int peer_reconnect_init(peer_t *peer) { (void)peer; return 0; }
+int peer_try_reconnect(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; return -1; }
+void peer_reconnect_cleanup(peer_t *peer) { (void)peer; }
+int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
+    (void)ctx; (void)event; return 0;
+}
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len) {
+    (void)ctx; (void)peer; (void)payload; (void)len; return 0;
+}
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; }
+int rootstream_net_tcp_connect(rootstream_ctx_t *ctx, peer_t *peer) {
+    (void)ctx; (void)peer; return -1;
+}
+int rootstream_net_tcp_send(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data,
+                            size_t size) {
+    (void)ctx; (void)peer; (void)data; (void)size; return -1;
+}
+int rootstream_net_tcp_recv(rootstream_ctx_t *ctx, peer_t *peer, uint8_t *buffer,
+                            size_t *buffer_len) {
+    (void)ctx; (void)peer; (void)buffer; (void)buffer_len; return -1;
+}
+void rootstream_net_tcp_cleanup(peer_t *peer) { (void)peer; }
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer) { (void)peer; return -1; }
+int rootstream_opus_decode(rootstream_ctx_t *ctx, const uint8_t *in, size_t in_len,
+                           int16_t *pcm, size_t *pcm_len) {
+    (void)ctx; (void)in; (void)in_len; (void)pcm; (void)pcm_len; return -1;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static rootstream_ctx_t ctx;
+
+int main(void) {
+    if (sodium_init() < 0) { fprintf(stderr, "sodium_init failed\n"); return 1; }
+
+    /* Receiver: loopback socket nobody reads (the kernel drops overflow) */
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in rx_addr;
+    memset(&rx_addr, 0, sizeof(rx_addr));
+    rx_addr.sin_family      = AF_INET;
+    rx_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    rx_addr.sin_port        = 0;
+    socklen_t rx_len = sizeof(rx_addr);
+    if (rx_fd < 0 || bind(rx_fd, (struct sockaddr *)&rx_addr, sizeof(rx_addr)) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&rx_addr, &rx_len) < 0) {
+        perror("receiver socket"); return 1;
+    }
+
+    /* Sender: host context with one authenticated UDP peer */
+    ctx.sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (ctx.sock_fd < 0) { perror("socket"); return 1; }
+
+    peer_t *peer = &ctx.peers[0];
+    ctx.num_peers = 1;
+    memcpy(&peer->addr, &rx_addr, sizeof(rx_addr));
+    peer->addr_len  = sizeof(rx_addr);
+    peer->state     = PEER_CONNECTED;
+    peer->transport = TRANSPORT_UDP;
+    peer->session.authenticated = true;
+    randombytes_buf(peer->session.shared_key, sizeof(peer->session.shared_key));
+    snprintf(peer->hostname, sizeof(peer->hostname), "bench-peer");
+
+    uint8_t *frame = malloc(KEYFRAME_BYTES);
+    if (!frame) return 1;
+    randombytes_buf(frame, KEYFRAME_BYTES);
+
+    /* Warm-up frame creates the per-peer send arena */
+    if (rootstream_net_send_video(&ctx, peer, frame, KEYFRAME_BYTES, 0) < 0) {
+        fprintf(stderr, "warm-up send failed\n"); return 1;
+    }
+
+    uint64_t nonce_start = peer->session.nonce_counter;
+    counting = 1;
+    uint64_t t0 = now_ns();
+
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        size_t size = (i % GOP_LENGTH == 0) ? KEYFRAME_BYTES : PFRAME_BYTES;
+        if (rootstream_net_send_video(&ctx, peer, frame, size, (uint64_t)i * 16667) < 0) {
+            counting = 0;
+            fprintf(stderr, "send failed at frame %d\n", i); return 1;
+        }
+    }
+
+    uint64_t elapsed = now_ns() - t0;
+    counting = 0;
+
+    uint64_t chunks = peer->session.nonce_counter - nonce_start;
+    printf("BENCH packetize_alloc: frames=%d chunks=%lu allocs_per_frame=%.2f "
+           "ns_per_chunk=%.0f\n",
+           BENCH_FRAMES, (unsigned long)chunks, (double)alloc_calls / BENCH_FRAMES,
+           chunks ? (double)elapsed / (double)chunks : 0.0);
+
+    free(frame);
+    close(ctx.sock_fd);
+    close(rx_fd);
+    return alloc_calls == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * reassembly_loss_bench.c — Video reassembly under a jittery link
+ *
+ * Streams 1800 frames (30 s at 60 fps, one ~150 KB keyframe per 60,
+ * ~20 KB P-frames otherwise) as 1376-byte chunks through a simulated
+ * Wi-Fi channel that delays 3 % of chunks by 1–8 packets (so they can
+ * land in the next frame), duplicates 1 % and loses 0.2 %.  The chunk
+ * stream is fed to two receivers:
+ *
+ *   legacy      — the former single-frame path of process_received_packet()
+ *                 (one frame per peer, byte counter, a chunk of another
+ *                 frame restarts reassembly)
+ *   frame_reasm — src/chunk/frame_reasm.c as used by network.c now
+ *
+ * Every handed-out frame is compared against the source.  A keyframe
+ * request is counted whenever a frame_id gap is seen at hand-off, rate
+ * limited to one per 250 ms as in network.c.
+ *
+ * Output format:
+ *   BENCH reassembly_<mode>: frames=N intact=N corrupt=N lost=N keyframe_reqs=N
+ *
+ * Exit: 0 if frame_reasm delivers more intact frames than legacy with no
+ *       corrupt frames, 1 otherwise.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chunk/frame_reasm.h"
+
+#define FRAMES         1800
+#define GOP_LENGTH     60
+#define KEYFRAME_BYTES (150 * 1024)
+#define PFRAME_BYTES   (20 * 1024)
+#define CHUNK_BYTES    1376
+#define FRAME_MS       16
+#define DELAY_PCT      3.0
+#define DELAY_MAX      8
+#define DUP_PCT        1.0
+#define LOSS_PCT       0.2
+#define KEYFRAME_REQ_MS 250
+
+typedef struct {
+    uint32_t frame_id;
+    uint32_t total;
+    uint32_t offset;
+    uint16_t len;
+    uint64_t due;     /* Arrival order key */
+    uint64_t now_ms;
+} wire_chunk_t;
+
+typedef struct {
+    uint64_t intact, corrupt, lost, keyframe_reqs;
+    uint32_t last_id;
+    int have_last;
+    uint64_t last_req_ms;
+} result_t;
+
+static uint8_t *frame_src[FRAMES + 1];
+static uint32_t frame_len[FRAMES + 1];
+
+/* xorshift64 — deterministic channel */
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+static double rnd_pct(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (double)(rng_state % 1000000ULL) / 10000.0;
+}
+
+static int cmp_due(const void *a, const void *b) {
+    const wire_chunk_t *x = a, *y = b;
+    return (x->due > y->due) - (x->due < y->due);
+}
+
+static void on_frame(result_t *r, uint32_t id, const uint8_t *data, size_t size, uint64_t now) {
+    if (id >= 1 && id <= FRAMES && size == frame_len[id] && memcmp(data, frame_src[id], size) == 0)
+        r->intact++;
+    else
+        r->corrupt++;
+
+    if (r->have_last && id != r->last_id + 1 && now - r->last_req_ms >= KEYFRAME_REQ_MS) {
+        r->keyframe_reqs++;
+        r->last_req_ms = now;
+    }
+    r->last_id = id;
+    r->have_last = 1;
+}
+
+static void print_result(const char *name, result_t *r) {
+    r->lost = FRAMES - r->intact - r->corrupt;
+    printf("BENCH reassembly_%s: frames=%d intact=%lu corrupt=%lu lost=%lu keyframe_reqs=%lu\n",
+           name, FRAMES, (unsigned long)r->intact, (unsigned long)r->corrupt,
+           (unsigned long)r->lost, (unsigned long)r->keyframe_reqs);
+}
+
+/* The pre-frame_reasm receive path, reduced to its reassembly logic */
+static void run_legacy(const wire_chunk_t *w, size_t n, result_t *r) {
+    uint32_t rx_id = 0;
+    uint8_t *buf = NULL;
+    size_t cap = 0, expected = 0, received = 0;
+    uint32_t shown = 0; /* Last id handed out */
+
+    for (size_t i = 0; i < n; i++) {
+        if (rx_id != w[i].frame_id) {
+            rx_id = w[i].frame_id;
+            received = 0;
+            expected = w[i].total;
+        }
+        if (cap < expected) {
+            buf = realloc(buf, expected);
+            cap = expected;
+        }
+        memcpy(buf + w[i].offset, frame_src[w[i].frame_id] + w[i].offset, w[i].len);
+        received += w[i].len;
+        /* Later chunks of the same id re-deliver it; count it once */
+        if (received >= expected && rx_id != shown) {
+            on_frame(r, rx_id, buf, expected, w[i].now_ms);
+            shown = rx_id;
+        }
+    }
+    free(buf);
+}
+
+static void run_reasm(const wire_chunk_t *w, size_t n, result_t *r) {
+    frame_reasm_t *fr = frame_reasm_create(0, 0, 0);
+    frame_reasm_frame_t f;
+
+    for (size_t i = 0; i < n; i++) {
+        frame_reasm_add(fr, w[i].frame_id, w[i].total, w[i].offset,
+                        frame_src[w[i].frame_id] + w[i].offset, w[i].len,
+                        0, w[i].now_ms);
+        while (frame_reasm_pop(fr, w[i].now_ms, &f))
+            on_frame(r, f.frame_id, f.data, f.size, w[i].now_ms);
+    }
+    /* Drain what is still queued after the last packet */
+    uint64_t end = w[n - 1].now_ms + 1000;
+    while (frame_reasm_pop(fr, end, &f))
+        on_frame(r, f.frame_id, f.data, f.size, end);
+
+    frame_reasm_destroy(fr);
+}
+
+int main(void) {
+    size_t cap = 0, n = 0;
+    for (uint32_t id = 1; id <= FRAMES; id++) {
+        frame_len[id] = ((id - 1) % GOP_LENGTH == 0) ? KEYFRAME_BYTES : PFRAME_BYTES;
+        frame_src[id] = malloc(frame_len[id]);
+        for (uint32_t b = 0; b < frame_len[id]; b++)
+            frame_src[id][b] = (uint8_t)(id * 31u + b * 7u);
+        cap += frame_len[id] / CHUNK_BYTES + 2;
+    }
+    cap += cap / 10;
+
+    wire_chunk_t *w = malloc(cap * sizeof(*w));
+    if (!w) return 1;
+
+    /* Build the wire order: sequential, then perturb */
+    uint64_t seq = 0;
+    for (uint32_t id = 1; id <= FRAMES; id++) {
+        for (uint32_t off = 0; off < frame_len[id]; off += CHUNK_BYTES) {
+            uint32_t len = frame_len[id] - off < CHUNK_BYTES ? frame_len[id] - off : CHUNK_BYTES;
+            seq++;
+            if (rnd_pct() < LOSS_PCT) continue;
+
+            wire_chunk_t c = {id, frame_len[id], off, (uint16_t)len, seq * 64, 0};
+            if (rnd_pct() < DELAY_PCT)
+                c.due += (uint64_t)(1 + rng_state % DELAY_MAX) * 64 + 1;
+            w[n++] = c;
+            if (rnd_pct() < DUP_PCT && n < cap) {
+                c.due += 2 * 64 + 3;
+                w[n++] = c;
+            }
+        }
+    }
+    qsort(w, n, sizeof(*w), cmp_due);
+
+    /* Arrival time: the whole stream spread evenly over 30 s */
+    for (size_t i = 0; i < n; i++)
+        w[i].now_ms = (uint64_t)i * FRAMES * FRAME_MS / n;
+
+    result_t legacy = {0}, reasm = {0};
+    run_legacy(w, n, &legacy);
+    run_reasm(w, n, &reasm);
+
+    print_result("legacy", &legacy);
+    print_result("frame_reasm", &reasm);
+
+    free(w);
+    for (uint32_t id = 1; id <= FRAMES; id++) free(frame_src[id]);
+    return (reasm.intact > legacy.intact && reasm.corrupt == 0) ? 0 : 1;
+}
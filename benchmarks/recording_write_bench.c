@@ -0,0 +1,230 @@
+/*
+ * recording_write_bench.c — Recording cost on the capture thread, and seeking
+ *
+ * Records 240 frames paced at 120 fps (~250 KB keyframe every 60, ~40 KB
+ * deltas otherwise, ~40 Mbit/s) and times the call the capture loop
+ * makes per frame:
+ *
+ *   legacy — write() of the record header + write() of the frame, as
+ *            recording_write_frame() used to do
+ *   async  — rstr_writer_write(): copy into the ring; a writer thread
+ *            issues batched writes
+ *
+ * Then writes a 10-minute 60 fps recording of small frames and compares
+ * building its keyframe index from the v2 trailer with a full scan, and
+ * times rstr_seek().
+ *
+ * Pass a directory to record on a real disk (default /tmp).
+ *
+ * Output format:
+ *   BENCH recording_write: mode=<m> p50_us=X p99_us=X max_us=X syscalls_per_frame=X
+ *   BENCH recording_seek: keyframes=N trailer_us=X scan_us=X seek_ns=X
+ *
+ * Exit: 0 if the async p99 is below the legacy p99 and every seek lands
+ *       on the right keyframe, 1 otherwise.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rstr/rstr_reader.h"
+#include "rstr/rstr_writer.h"
+
+#define BENCH_FRAMES    240
+#define FRAME_PERIOD_US 8333 /* 120 fps */
+#define GOP             60
+#define KEY_BYTES       (250 * 1024)
+#define DELTA_BYTES     (40 * 1024)
+
+#define SEEK_FRAMES     36000 /* 10 min at 60 fps */
+#define SEEK_FRAME_US   16667
+#define SEEK_LOOKUPS    100000
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until_us(uint64_t t) {
+    uint64_t now = now_us();
+    if (t > now)
+        usleep((useconds_t)(t - now));
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *mode, uint64_t *samples, double syscalls_per_frame) {
+    qsort(samples, BENCH_FRAMES, sizeof(samples[0]), cmp_u64);
+    printf("BENCH recording_write: mode=%s p50_us=%lu p99_us=%lu max_us=%lu "
+           "syscalls_per_frame=%.2f\n",
+           mode, samples[BENCH_FRAMES / 2], samples[BENCH_FRAMES * 99 / 100],
+           samples[BENCH_FRAMES - 1], syscalls_per_frame);
+}
+
+/* The old recording_write_frame(): two blocking write()s per frame */
+static uint64_t run_legacy(const char *path, const uint8_t *frame, uint64_t *samples) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return UINT64_MAX;
+    rstr_header_t hdr = {0};
+    hdr.magic = RSTR_MAGIC;
+    hdr.version = RSTR_VERSION_1;
+    if (write(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+        close(fd);
+        return UINT64_MAX;
+    }
+
+    uint64_t start = now_us();
+    for (int n = 0; n < BENCH_FRAMES; n++) {
+        sleep_until_us(start + (uint64_t)n * FRAME_PERIOD_US);
+        size_t size = n % GOP == 0 ? KEY_BYTES : DELTA_BYTES;
+        rstr_frame_header_t fh = {0};
+        fh.timestamp_us = (uint64_t)n * FRAME_PERIOD_US;
+        fh.size = (uint32_t)size;
+        fh.flags = n % GOP == 0 ? RSTR_FLAG_KEYFRAME : 0;
+
+        uint64_t t0 = now_us();
+        if (write(fd, &fh, sizeof(fh)) != sizeof(fh) ||
+            write(fd, frame, size) != (ssize_t)size) {
+            close(fd);
+            return UINT64_MAX;
+        }
+        samples[n] = now_us() - t0;
+    }
+    fsync(fd);
+    close(fd);
+    return 2ULL * BENCH_FRAMES;
+}
+
+static uint64_t run_async(const char *path, const uint8_t *frame, uint64_t *samples) {
+    rstr_header_t hdr = {0};
+    rstr_writer_t *w = rstr_writer_open(path, &hdr, NULL);
+    if (!w)
+        return UINT64_MAX;
+
+    uint64_t start = now_us();
+    for (int n = 0; n < BENCH_FRAMES; n++) {
+        sleep_until_us(start + (uint64_t)n * FRAME_PERIOD_US);
+        size_t size = n % GOP == 0 ? KEY_BYTES : DELTA_BYTES;
+
+        uint64_t t0 = now_us();
+        if (rstr_writer_write(w, (uint64_t)n * FRAME_PERIOD_US, frame, size, n % GOP == 0) !=
+            RSTR_WRITE_QUEUED) {
+            rstr_writer_close(w);
+            return UINT64_MAX;
+        }
+        samples[n] = now_us() - t0;
+    }
+
+    rstr_writer_stats_t st;
+    rstr_writer_get_stats(w, &st);
+    uint64_t writes = st.writes;
+    if (rstr_writer_close(w) < 0)
+        return UINT64_MAX;
+    return writes;
+}
+
+static int bench_seek(const char *path) {
+    /* Written unpaced: the ring must hold the whole recording */
+    rstr_header_t hdr = {0};
+    rstr_writer_config_t cfg = {.ring_bytes = 32u << 20};
+    rstr_writer_t *w = rstr_writer_open(path, &hdr, &cfg);
+    if (!w)
+        return -1;
+    uint8_t frame[512];
+    memset(frame, 0x42, sizeof(frame));
+    for (int n = 0; n < SEEK_FRAMES; n++)
+        rstr_writer_write(w, (uint64_t)n * SEEK_FRAME_US, frame, sizeof(frame), n % GOP == 0);
+    if (rstr_writer_close(w) < 0)
+        return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || rstr_read_header(fd, &hdr) < 0)
+        return -1;
+
+    rstr_index_t trailer, scan;
+    uint64_t t0 = now_us();
+    int rc = rstr_index_load(fd, &hdr, &trailer);
+    uint64_t trailer_us = now_us() - t0;
+
+    rstr_header_t v1 = hdr; /* force the version 1 path: scan every record */
+    v1.version = RSTR_VERSION_1;
+    t0 = now_us();
+    rc |= rstr_index_load(fd, &v1, &scan);
+    uint64_t scan_us = now_us() - t0;
+
+    int ok = rc == 0 && trailer.source == RSTR_INDEX_SOURCE_TRAILER &&
+             trailer.count == scan.count && trailer.count == SEEK_FRAMES / GOP;
+
+    uint64_t total_us = (uint64_t)SEEK_FRAMES * SEEK_FRAME_US;
+    uint64_t ts = 12345;
+    uint64_t t1 = now_ns();
+    for (int i = 0; i < SEEK_LOOKUPS && ok; i++) {
+        ts = (ts * 6364136223846793005ULL + 1442695040888963407ULL);
+        uint64_t target = (ts >> 11) % total_us;
+        uint64_t key_us = 0;
+        if (rstr_seek(fd, &trailer, target, &key_us) < 0 || key_us > target ||
+            target - key_us >= (uint64_t)GOP * SEEK_FRAME_US)
+            ok = 0;
+    }
+    uint64_t seek_ns = (now_ns() - t1) / SEEK_LOOKUPS;
+
+    printf("BENCH recording_seek: keyframes=%zu trailer_us=%lu scan_us=%lu seek_ns=%lu\n",
+           trailer.count, trailer_us, scan_us, seek_ns);
+
+    rstr_index_free(&trailer);
+    rstr_index_free(&scan);
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+    char path[512];
+    snprintf(path, sizeof(path), "%s/recording_write_bench_%d.rstr", dir, (int)getpid());
+
+    uint8_t *frame = malloc(KEY_BYTES);
+    uint64_t *samples = malloc(BENCH_FRAMES * sizeof(uint64_t));
+    if (!frame || !samples)
+        return 1;
+    for (size_t i = 0; i < KEY_BYTES; i++)
+        frame[i] = (uint8_t)(i * 131);
+
+    uint64_t syscalls = run_legacy(path, frame, samples);
+    if (syscalls == UINT64_MAX) {
+        fprintf(stderr, "legacy run failed\n");
+        return 1;
+    }
+    report("legacy", samples, (double)syscalls / BENCH_FRAMES);
+    uint64_t legacy_p99 = samples[BENCH_FRAMES * 99 / 100];
+
+    syscalls = run_async(path, frame, samples);
+    if (syscalls == UINT64_MAX) {
+        fprintf(stderr, "async run failed\n");
+        return 1;
+    }
+    report("async", samples, (double)syscalls / BENCH_FRAMES);
+    uint64_t async_p99 = samples[BENCH_FRAMES * 99 / 100];
+
+    int seek_rc = bench_seek(path);
+    unlink(path);
+    free(frame);
+    free(samples);
+
+    return (async_p99 < legacy_p99 && seek_rc == 0) ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+/*
+ * replay_buffer_bench.cpp — Replay buffer cost on the capture thread
+ *
+ * Fills a 300 s buffer with a 60 fps stream (64 KB keyframe every 120
+ * frames, 8 KB deltas, ~4 Mbit/s), runs another minute so eviction is
+ * in steady state, and times each add:
+ *
+ *   legacy — malloc + memcpy into a std::deque under a mutex, age-based
+ *            cleanup, as replay_buffer.cpp used to do
+ *   arena  — replay_buffer_add_video_frame(): copy into the preallocated
+ *            ring, GOP eviction
+ *
+ * Then saves all 300 s while a capture thread keeps adding a frame every
+ * 2 ms, and reports the worst add.  The legacy save held the buffer lock
+ * for the whole mux; the arena save pins its range and muxes unlocked.
+ *
+ * Pass a directory for the output files (default /tmp).
+ *
+ * Output format:
+ *   BENCH replay_add: mode=<m> ns_per_frame=X p99_ns=X
+ *   BENCH replay_save_stall: mode=<m> save_ms=X max_add_us=X p99_add_us=X adds=N dropped=N
+ *
+ * Exit: 0 if the arena's worst add during a save is below the legacy
+ *       one and both saves succeed, 1 otherwise.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include "recording/replay_buffer.h"
+
+#define FPS          60
+#define FRAME_US     16667
+#define GOP          120
+#define KEY_BYTES    (64 * 1024)
+#define DELTA_BYTES  (8 * 1024)
+#define BUFFER_SEC   300
+#define FILL_FRAMES  ((BUFFER_SEC + 60) * FPS)
+#define SAVE_ADD_US  2000
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static size_t frame_bytes(int n) {
+    return n % GOP == 0 ? KEY_BYTES : DELTA_BYTES;
+}
+
+/* ── The old implementation, reduced to video ──────────────────────── */
+
+struct legacy_buffer {
+    std::deque<replay_video_frame_t> frames;
+    std::mutex mutex;
+    uint64_t max_age_us = (uint64_t)BUFFER_SEC * 1000000;
+};
+
+static int legacy_add(legacy_buffer *b, const uint8_t *data, size_t size, uint64_t ts, bool key) {
+    std::lock_guard<std::mutex> lock(b->mutex);
+    uint8_t *copy = (uint8_t *)malloc(size);
+    if (!copy)
+        return -1;
+    memcpy(copy, data, size);
+    b->frames.push_back({copy, size, ts, 1920, 1080, key});
+    while (!b->frames.empty() && ts - b->frames.front().timestamp_us > b->max_age_us) {
+        free(b->frames.front().data);
+        b->frames.pop_front();
+    }
+    return 0;
+}
+
+/* Mux everything with the lock held, like the old replay_buffer_save() */
+static int legacy_save(legacy_buffer *b, const char *filename) {
+    std::lock_guard<std::mutex> lock(b->mutex);
+
+    AVFormatContext *fmt = nullptr;
+    if (avformat_alloc_output_context2(&fmt, nullptr, nullptr, filename) < 0)
+        return -1;
+    AVStream *st = avformat_new_stream(fmt, nullptr);
+    if (!st || avio_open(&fmt->pb, filename, AVIO_FLAG_WRITE) < 0) {
+        avformat_free_context(fmt);
+        return -1;
+    }
+    st->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    st->codecpar->codec_id = AV_CODEC_ID_H264;
+    st->codecpar->width = 1920;
+    st->codecpar->height = 1080;
+    st->time_base = (AVRational){1, 1000000};
+
+    int rc = avformat_write_header(fmt, nullptr) < 0 ? -1 : 0;
+    AVPacket *pkt = av_packet_alloc();
+    for (size_t i = 0; rc == 0 && pkt && i < b->frames.size(); i++) {
+        const replay_video_frame_t &f = b->frames[i];
+        if (av_new_packet(pkt, (int)f.size) < 0) {
+            rc = -1;
+            break;
+        }
+        memcpy(pkt->data, f.data, f.size);
+        pkt->pts = pkt->dts = f.timestamp_us;
+        pkt->flags = f.is_keyframe ? AV_PKT_FLAG_KEY : 0;
+        av_interleaved_write_frame(fmt, pkt);
+    }
+    av_packet_free(&pkt);
+    if (rc == 0)
+        av_write_trailer(fmt);
+    avio_closep(&fmt->pb);
+    avformat_free_context(fmt);
+    return rc;
+}
+
+static void legacy_free(legacy_buffer *b) {
+    for (auto &f : b->frames)
+        free(f.data);
+    b->frames.clear();
+}
+
+/* ── Measurements ──────────────────────────────────────────────────── */
+
+static void report_add(const char *mode, std::vector<uint64_t> &ns) {
+    uint64_t total = 0;
+    for (uint64_t v : ns)
+        total += v;
+    std::sort(ns.begin(), ns.end());
+    printf("BENCH replay_add: mode=%s ns_per_frame=%lu p99_ns=%lu\n", mode,
+           (unsigned long)(total / ns.size()), (unsigned long)ns[ns.size() * 99 / 100]);
+}
+
+/*
+ * Add a frame every SAVE_ADD_US until @saving clears; returns the worst
+ * add in µs.
+ */
+template <typename AddFn>
+static uint64_t capture_during_save(std::atomic<bool> &saving, const uint8_t *frame,
+                                    AddFn add, const char *mode, uint64_t save_start_ns,
+                                    std::atomic<uint64_t> &save_end_ns) {
+    std::vector<uint64_t> us;
+    int n = FILL_FRAMES;
+    uint64_t dropped = 0;
+    while (saving.load()) {
+        uint64_t t0 = now_ns();
+        if (add(frame, frame_bytes(n), (uint64_t)n * FRAME_US, n % GOP == 0) != 0)
+            dropped++;
+        us.push_back((now_ns() - t0) / 1000);
+        n++;
+        usleep(SAVE_ADD_US);
+    }
+    std::sort(us.begin(), us.end());
+    uint64_t worst = us.empty() ? 0 : us.back();
+    printf("BENCH replay_save_stall: mode=%s save_ms=%lu max_add_us=%lu p99_add_us=%lu "
+           "adds=%zu dropped=%lu\n",
+           mode, (unsigned long)((save_end_ns.load() - save_start_ns) / 1000000),
+           (unsigned long)worst, (unsigned long)(us.empty() ? 0 : us[us.size() * 99 / 100]),
+           us.size(), (unsigned long)dropped);
+    return worst;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+    char path[512];
+    snprintf(path, sizeof(path), "%s/replay_buffer_bench_%d.h264", dir, (int)getpid());
+
+    uint8_t *frame = (uint8_t *)malloc(KEY_BYTES);
+    if (!frame)
+        return 1;
+    for (size_t i = 0; i < KEY_BYTES; i++)
+        frame[i] = (uint8_t)(i * 131);
+    std::vector<uint64_t> ns(FILL_FRAMES);
+
+    /* Legacy */
+    legacy_buffer legacy;
+    for (int n = 0; n < FILL_FRAMES; n++) {
+        uint64_t t0 = now_ns();
+        legacy_add(&legacy, frame, frame_bytes(n), (uint64_t)n * FRAME_US, n % GOP == 0);
+        ns[n] = now_ns() - t0;
+    }
+    report_add("legacy", ns);
+
+    std::atomic<bool> saving(true);
+    std::atomic<uint64_t> save_end(0);
+    int legacy_rc = 0;
+    uint64_t save_start = now_ns();
+    std::thread saver([&]() {
+        legacy_rc = legacy_save(&legacy, path);
+        save_end = now_ns();
+        saving = false;
+    });
+    usleep(1000); /* let the save take the lock first */
+    uint64_t legacy_worst = capture_during_save(
+        saving, frame,
+        [&](const uint8_t *d, size_t s, uint64_t ts, bool k) {
+            return legacy_add(&legacy, d, s, ts, k);
+        },
+        "legacy", save_start, save_end);
+    saver.join();
+    legacy_free(&legacy);
+    unlink(path);
+
+    /* Arena */
+    replay_buffer_t *rb = replay_buffer_create(BUFFER_SEC, 0);
+    if (!rb)
+        return 1;
+    for (int n = 0; n < FILL_FRAMES; n++) {
+        uint64_t t0 = now_ns();
+        replay_buffer_add_video_frame(rb, frame, frame_bytes(n), 1920, 1080,
+                                      (uint64_t)n * FRAME_US, n % GOP == 0);
+        ns[n] = now_ns() - t0;
+    }
+    report_add("arena", ns);
+
+    saving = true;
+    save_start = now_ns();
+    struct done_ctx {
+        std::atomic<bool> *saving;
+        std::atomic<uint64_t> *end;
+    } done = {&saving, &save_end};
+    int arena_rc = replay_buffer_save_async(
+        rb, path, 0, VIDEO_CODEC_H264,
+        [](int, uint32_t, void *user) {
+            done_ctx *d = (done_ctx *)user;
+            d->end->store(now_ns());
+            d->saving->store(false);
+        },
+        &done);
+    uint64_t arena_worst = 0;
+    if (arena_rc == 0) {
+        arena_worst = capture_during_save(
+            saving, frame,
+            [&](const uint8_t *d, size_t s, uint64_t ts, bool k) {
+                return replay_buffer_add_video_frame(rb, d, s, 1920, 1080, ts, k);
+            },
+            "arena", save_start, save_end);
+        arena_rc = replay_buffer_save_wait(rb);
+    }
+    replay_buffer_destroy(rb);
+    unlink(path);
+    free(frame);
+
+    return (legacy_rc == 0 && arena_rc == 0 && arena_worst < legacy_worst) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/*
+ * replay_window_bench.c — Per-packet cost of nonce replay protection
+ *
+ * Generates 2 M nonces the way a peer's receive path sees them: video
+ * frames of 20–1500 chunks whose nonces were reserved up front, sent by
+ * fan-out lanes so later audio/input packets overtake them, chunk order
+ * shuffled within each frame, plus 1 % duplicated packets.  Each nonce
+ * is pushed through
+ *
+ *   legacy  — the attack_prevention cache: constant-time compare against
+ *             up to 1024 cached nonces, memmove of the cache when full
+ *   window  — replay_window_check() + replay_window_update()
+ *
+ * and compared with copying a 1400-byte datagram, a cost every received
+ * packet already pays.
+ *
+ * Output format:
+ *   BENCH replay_<mode>: packets=N ns_per_pkt=X accepted=N rejected=N
+ *   BENCH replay_budget: copy_ns_per_pkt=X window_cpu_pct_at_100k_pps=X
+ *
+ * Exit: 0 if the window accepts every fresh nonce, rejects every
+ *       duplicate and costs less per packet than the 1400-byte copy,
+ *       1 otherwise.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "network/replay_window.h"
+
+#define PACKETS      2000000
+#define DUP_PERMILLE 10
+#define LEGACY_NONCES 1024
+#define COPY_BYTES   1400
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+/* ── Legacy cache (attack_prevention_check_nonce) ────────────────── */
+
+static struct {
+    uint8_t nonce[32];
+    bool used;
+} legacy_cache[LEGACY_NONCES];
+static int legacy_count;
+
+static bool ct_compare(const uint8_t *a, const uint8_t *b, size_t len) {
+    volatile uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++)
+        diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+static bool legacy_check(uint64_t counter) {
+    uint8_t nonce[32] = {0};
+    memcpy(nonce, &counter, sizeof(counter));
+    for (int i = 0; i < legacy_count && i < LEGACY_NONCES; i++) {
+        if (legacy_cache[i].used && ct_compare(legacy_cache[i].nonce, nonce, 32))
+            return false;
+    }
+    if (legacy_count < LEGACY_NONCES) {
+        memcpy(legacy_cache[legacy_count].nonce, nonce, 32);
+        legacy_cache[legacy_count++].used = true;
+    } else {
+        memmove(&legacy_cache[0], &legacy_cache[1], sizeof(legacy_cache[0]) * (LEGACY_NONCES - 1));
+        memcpy(legacy_cache[LEGACY_NONCES - 1].nonce, nonce, 32);
+        legacy_cache[LEGACY_NONCES - 1].used = true;
+    }
+    return true;
+}
+
+/* ── Workload ────────────────────────────────────────────────────── */
+
+/* Fills seq with PACKETS arrivals; dup[i] marks a repeated nonce */
+static void make_arrivals(uint64_t *seq, bool *dup) {
+    uint64_t next = 0;
+    size_t n = 0;
+    while (n < PACKETS) {
+        /* A frame reserves its nonces, then a few control packets follow */
+        uint32_t chunks = 20 + rng() % 60;
+        if (rng() % 60 == 0)
+            chunks = 600 + rng() % 900; /* keyframe */
+        uint64_t first = next;
+        next += chunks;
+        uint32_t extra = 1 + rng() % 4;
+        for (uint32_t i = 0; i < extra && n < PACKETS; i++)
+            seq[n++] = next + i; /* overtake the frame */
+        size_t start = n;
+        for (uint32_t c = 0; c < chunks && n < PACKETS; c++)
+            seq[n++] = first + c;
+        for (size_t i = n - 1; i > start; i--) {
+            size_t j = start + rng() % (i - start + 1);
+            uint64_t t = seq[i];
+            seq[i] = seq[j];
+            seq[j] = t;
+        }
+        next += extra;
+    }
+    for (size_t i = 0; i < PACKETS; i++) {
+        dup[i] = false;
+        if (i > 0 && rng() % 1000 < DUP_PERMILLE) {
+            seq[i] = seq[i - 1 - rng() % (i < 64 ? i : 64)];
+            dup[i] = true;
+        }
+    }
+}
+
+int main(void) {
+    uint64_t *seq = malloc(PACKETS * sizeof(*seq));
+    bool *dup = malloc(PACKETS * sizeof(*dup));
+    uint8_t *src = calloc(1, COPY_BYTES), *dst = calloc(1, COPY_BYTES);
+    if (!seq || !dup || !src || !dst)
+        return 1;
+    make_arrivals(seq, dup);
+
+    /* Legacy: cost only (its 1024-entry memory forgets old nonces) */
+    size_t legacy_n = PACKETS / 20;
+    size_t accepted = 0;
+    double t0 = now_ns();
+    for (size_t i = 0; i < legacy_n; i++)
+        accepted += legacy_check(seq[i]);
+    double legacy_ns = (now_ns() - t0) / (double)legacy_n;
+    printf("BENCH replay_legacy: packets=%zu ns_per_pkt=%.1f accepted=%zu rejected=%zu\n",
+           legacy_n, legacy_ns, accepted, legacy_n - accepted);
+
+    /* Window */
+    static replay_window_t w;
+    replay_window_reset(&w);
+    size_t wrong = 0;
+    accepted = 0;
+    t0 = now_ns();
+    for (size_t i = 0; i < PACKETS; i++) {
+        bool ok = replay_window_check(&w, seq[i]) && replay_window_update(&w, seq[i]);
+        accepted += ok;
+        wrong += ok == dup[i];
+    }
+    double window_ns = (now_ns() - t0) / PACKETS;
+    printf("BENCH replay_window: packets=%d ns_per_pkt=%.1f accepted=%zu rejected=%zu\n", PACKETS,
+           window_ns, accepted, (size_t)PACKETS - accepted);
+
+    /* Yardstick: the copy each datagram already costs */
+    t0 = now_ns();
+    for (size_t i = 0; i < PACKETS; i++) {
+        src[i % COPY_BYTES] = (uint8_t)i;
+        memcpy(dst, src, COPY_BYTES);
+        __asm__ volatile("" : : "r"(dst) : "memory");
+    }
+    double copy_ns = (now_ns() - t0) / PACKETS;
+    printf("BENCH replay_budget: copy_ns_per_pkt=%.1f window_cpu_pct_at_100k_pps=%.4f\n", copy_ns,
+           window_ns * 100000.0 / 1e9 * 100.0);
+
+    free(seq);
+    free(dup);
+    free(src);
+    free(dst);
+    return (wrong == 0 && window_ns < copy_ns) ? 0 : 1;
+}
@@ -0,0 +1,358 @@
+/*
+ * ts_writer_bench.c — MPEG-TS muxing cost and syscall rate
+ *
+ * Muxes 60 s of a 6 Mbit/s, 60 fps H.264 stream with 48 kHz AAC into
+ * 2 s segments and compares with the previous writer (one write() per
+ * 188-byte packet, bitwise CRC).  Write syscalls are read from
+ * /proc/self/io.  Then muxes a four-rung ladder (6, 3, 1.5 and
+ * 0.8 Mbit/s) through hls_segmenter_write_frames(), one rung after
+ * another and in parallel, and times the PSI CRC on its own.
+ *
+ * Pass a directory for the segment files (default /tmp).
+ *
+ * Output format:
+ *   BENCH ts_writer: mode=<m> mbit_s=X syscalls_per_s=X mux_us_per_s=X
+ *   BENCH ts_ladder: rungs=N mode=<m> mux_us_per_s=X
+ *   BENCH ts_crc: mode=<m> mb_s=X
+ *
+ * Exit: 0 if the buffered writer makes under 10 write() calls per
+ *       second of a 6 Mbit/s stream and muxes faster than the old one,
+ *       1 otherwise.
+ */
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hls/hls_segmenter.h"
+#include "hls/ts_writer.h"
+
+#define FPS           60
+#define MEDIA_SEC     60
+#define SEG_SEC       2
+#define GOP           120
+#define AUDIO_FRAME   1920 /* 90 kHz ticks per 1024-sample AAC frame */
+#define AUDIO_BYTES   384  /* 128 kbit/s */
+#define RUNGS         4
+#define CRC_BYTES     (1 << 20)
+#define CRC_ROUNDS    50
+
+static const int rung_kbps[RUNGS] = {6000, 3000, 1500, 800};
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* write() calls made by this process so far, or -1 without /proc */
+static long write_syscalls(void) {
+    FILE *f = fopen("/proc/self/io", "r");
+    if (!f)
+        return -1;
+    char line[128];
+    long syscw = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "syscw: %ld", &syscw) == 1)
+            break;
+    }
+    fclose(f);
+    return syscw;
+}
+
+/* Video frame size at @kbps: keyframes 8x a delta frame */
+static size_t frame_bytes(int kbps, int n) {
+    size_t gop_bytes = (size_t)kbps * 1000 / 8 * GOP / FPS;
+    size_t delta = gop_bytes / (GOP - 1 + 8);
+    return n % GOP == 0 ? delta * 8 : delta;
+}
+
+/* ── The old ts_writer, reduced to what a segment needs ───────────── */
+
+typedef struct {
+    int fd;
+    uint8_t cc[0x2000];
+} legacy_ts_t;
+
+static uint32_t legacy_crc(const uint8_t *d, size_t n) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint32_t)d[i] << 24;
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+static int legacy_packet(legacy_ts_t *w, uint16_t pid, bool pusi, bool rai, const uint8_t *data,
+                         size_t len) {
+    uint8_t pkt[HLS_TS_PACKET_SZ];
+    memset(pkt, 0xFF, sizeof(pkt));
+    int stuffing = HLS_TS_PACKET_SZ - 4 - (int)len;
+    bool has_af = stuffing > 0 || rai;
+    pkt[0] = HLS_TS_SYNC_BYTE;
+    pkt[1] = (uint8_t)((pusi ? 0x40 : 0) | ((pid >> 8) & 0x1F));
+    pkt[2] = (uint8_t)pid;
+    pkt[3] = (uint8_t)((has_af ? 0x30 : 0x10) | w->cc[pid]);
+    w->cc[pid] = (w->cc[pid] + 1) & 0x0F;
+    int pos = 4;
+    if (has_af) {
+        uint8_t af_len = (uint8_t)(stuffing > 0 ? stuffing - 1 : 0);
+        pkt[pos++] = af_len;
+        if (af_len > 0) {
+            pkt[pos++] = rai ? 0x40 : 0x00;
+            pos += af_len - 1;
+        }
+    }
+    memcpy(pkt + pos, data, len);
+    return write(w->fd, pkt, HLS_TS_PACKET_SZ) == HLS_TS_PACKET_SZ ? 0 : -1;
+}
+
+static int legacy_pat_pmt(legacy_ts_t *w) {
+    uint8_t sec[32];
+    static const uint8_t pat[12] = {0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1,
+                                    0x00, 0x00, 0x00, 0x01, 0xF0, 0x00};
+    sec[0] = 0;
+    memcpy(sec + 1, pat, 12);
+    uint32_t crc = legacy_crc(pat, 12);
+    for (int i = 0; i < 4; i++)
+        sec[13 + i] = (uint8_t)(crc >> (24 - 8 * i));
+    if (legacy_packet(w, 0, true, false, sec, 17) != 0)
+        return -1;
+    static const uint8_t pmt[22] = {0x02, 0xB0, 0x17, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                                    0xE1, 0x00, 0xF0, 0x00, 0x1B, 0xE1, 0x00, 0xF0,
+                                    0x00, 0x0F, 0xE1, 0x01, 0xF0, 0x00};
+    memcpy(sec + 1, pmt, 22);
+    crc = legacy_crc(pmt, 22);
+    for (int i = 0; i < 4; i++)
+        sec[23 + i] = (uint8_t)(crc >> (24 - 8 * i));
+    return legacy_packet(w, TS_PMT_PID, true, false, sec, 27);
+}
+
+static int legacy_pes(legacy_ts_t *w, uint16_t pid, uint8_t sid, const uint8_t *data, size_t len,
+                      uint64_t pts, bool rai) {
+    uint8_t first[HLS_TS_PACKET_SZ - 4] = {0x00, 0x00, 0x01, sid, 0x00, 0x00, 0x80, 0x80, 0x05};
+    first[9] = (uint8_t)(0x21 | ((pts >> 29) & 0x0E));
+    first[10] = (uint8_t)(pts >> 22);
+    first[11] = (uint8_t)(0x01 | ((pts >> 14) & 0xFE));
+    first[12] = (uint8_t)(pts >> 7);
+    first[13] = (uint8_t)(0x01 | ((pts << 1) & 0xFE));
+    size_t n = len < sizeof(first) - 14 ? len : sizeof(first) - 14;
+    memcpy(first + 14, data, n);
+    if (legacy_packet(w, pid, true, rai, first, 14 + n) != 0)
+        return -1;
+    for (size_t off = n; off < len;) {
+        size_t chunk = len - off < HLS_TS_PACKET_SZ - 4 ? len - off : HLS_TS_PACKET_SZ - 4;
+        if (legacy_packet(w, pid, false, false, data + off, chunk) != 0)
+            return -1;
+        off += chunk;
+    }
+    return 0;
+}
+
+/* ── Single stream ─────────────────────────────────────────────────── */
+
+static uint8_t *video_buf;
+static uint8_t audio_buf[AUDIO_BYTES];
+
+typedef struct {
+    double mux_us_per_s;
+    double syscalls_per_s;
+    double mbit_s;
+} stream_result_t;
+
+static int mux_stream(const char *dir, bool legacy, stream_result_t *res) {
+    char path[512];
+    long calls0 = write_syscalls();
+    size_t bytes = 0;
+    double busy = 0.0;
+    uint64_t next_audio = 0;
+
+    for (int s = 0; s < MEDIA_SEC / SEG_SEC; s++) {
+        snprintf(path, sizeof(path), "%s/ts_writer_bench_%d.ts", dir, (int)getpid());
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return -1;
+        legacy_ts_t old = {.fd = fd};
+        ts_writer_config_t cfg = {.audio_type = TS_STREAM_AAC};
+        ts_writer_t *w = legacy ? NULL : ts_writer_create_ex(fd, &cfg);
+
+        double t0 = now_us();
+        int rc = legacy ? legacy_pat_pmt(&old) : ts_writer_write_pat_pmt(w);
+        for (int i = 0; rc == 0 && i < SEG_SEC * FPS; i++) {
+            int n = s * SEG_SEC * FPS + i;
+            uint64_t pts = (uint64_t)n * 90000 / FPS;
+            size_t len = frame_bytes(rung_kbps[0], n);
+            rc = legacy ? legacy_pes(&old, TS_VIDEO_PID, 0xE0, video_buf, len, pts, n % GOP == 0)
+                        : ts_writer_write_video(w, video_buf, len, pts, pts, n % GOP == 0);
+            for (; rc == 0 && next_audio <= pts; next_audio += AUDIO_FRAME) {
+                rc = legacy ? legacy_pes(&old, TS_AUDIO_PID, 0xC0, audio_buf, AUDIO_BYTES,
+                                         next_audio, false)
+                            : ts_writer_write_audio(w, audio_buf, AUDIO_BYTES, next_audio);
+            }
+        }
+        if (!legacy) {
+            if (rc == 0)
+                rc = ts_writer_flush(w);
+            bytes += ts_writer_bytes_written(w);
+            ts_writer_destroy(w);
+        } else {
+            bytes += (size_t)lseek(fd, 0, SEEK_CUR);
+        }
+        busy += now_us() - t0;
+        close(fd);
+        unlink(path);
+        if (rc != 0)
+            return -1;
+    }
+
+    long calls = write_syscalls() - calls0;
+    res->mux_us_per_s = busy / MEDIA_SEC;
+    res->syscalls_per_s = calls0 < 0 ? -1.0 : (double)calls / MEDIA_SEC;
+    res->mbit_s = (double)bytes * 8 / 1e6 / MEDIA_SEC;
+    printf("BENCH ts_writer: mode=%s mbit_s=%.2f syscalls_per_s=%.1f mux_us_per_s=%.0f\n",
+           legacy ? "legacy" : "buffered", res->mbit_s, res->syscalls_per_s,
+           res->mux_us_per_s);
+    return 0;
+}
+
+/* ── Ladder ────────────────────────────────────────────────────────── */
+
+static int mux_ladder(const char *dir, bool parallel) {
+    hls_segmenter_t *segs[RUNGS] = {0};
+    int seg_count = parallel ? 1 : RUNGS;
+
+    for (int i = 0; i < seg_count; i++) {
+        hls_segmenter_config_t cfg = {0};
+        snprintf(cfg.output_dir, sizeof(cfg.output_dir), "%s", dir);
+        snprintf(cfg.base_name, sizeof(cfg.base_name), "ts_ladder_%d_%d_", (int)getpid(), i);
+        snprintf(cfg.playlist_name, sizeof(cfg.playlist_name), "ts_ladder.m3u8");
+        cfg.with_audio = true;
+        cfg.rendition_count = parallel ? RUNGS : 1;
+        for (int r = 0; r < RUNGS; r++) {
+            snprintf(cfg.renditions[r].name, sizeof(cfg.renditions[r].name), "r%d", r);
+            cfg.renditions[r].bandwidth_bps = rung_kbps[r] * 1000;
+        }
+        segs[i] = hls_segmenter_create(&cfg);
+        if (!segs[i])
+            return -1;
+    }
+
+    double busy = 0.0;
+    uint64_t next_audio = 0;
+    int rc = 0;
+    for (int s = 0; rc == 0 && s < MEDIA_SEC / SEG_SEC; s++) {
+        double t0 = now_us();
+        for (int i = 0; i < seg_count; i++)
+            rc |= hls_segmenter_open_segment(segs[i]);
+        for (int f = 0; rc == 0 && f < SEG_SEC * FPS; f++) {
+            int n = s * SEG_SEC * FPS + f;
+            uint64_t pts = (uint64_t)n * 90000 / FPS;
+            hls_frame_t frames[RUNGS * 2];
+            int count = 0;
+            bool audio = next_audio <= pts;
+            for (int r = 0; r < RUNGS; r++) {
+                int rung = parallel ? r : 0;
+                frames[count++] = (hls_frame_t){.rendition = rung, .data = video_buf,
+                                                .len = frame_bytes(rung_kbps[r], n),
+                                                .pts_90khz = pts, .dts_90khz = pts,
+                                                .is_kf = n % GOP == 0};
+                if (audio)
+                    frames[count++] = (hls_frame_t){.rendition = rung, .data = audio_buf,
+                                                    .len = AUDIO_BYTES,
+                                                    .pts_90khz = next_audio, .is_audio = true};
+            }
+            if (audio)
+                next_audio += AUDIO_FRAME;
+            if (parallel) {
+                rc |= hls_segmenter_write_frames(segs[0], frames, count);
+            } else {
+                int per = count / RUNGS;
+                for (int r = 0; r < RUNGS; r++)
+                    rc |= hls_segmenter_write_frames(segs[r], frames + r * per, per);
+            }
+        }
+        for (int i = 0; i < seg_count; i++)
+            rc |= hls_segmenter_close_segment(segs[i], SEG_SEC);
+        busy += now_us() - t0;
+    }
+
+    /* Remove the published segments */
+    char path[1024];
+    for (int i = 0; i < seg_count; i++) {
+        for (int s = 0; s < MEDIA_SEC / SEG_SEC; s++) {
+            for (int r = 0; r < RUNGS; r++) {
+                if (parallel)
+                    snprintf(path, sizeof(path), "%s/ts_ladder_%d_%d_r%d_%d.ts", dir,
+                             (int)getpid(), i, r, s);
+                else
+                    snprintf(path, sizeof(path), "%s/ts_ladder_%d_%d_%d.ts", dir,
+                             (int)getpid(), i, s);
+                unlink(path);
+            }
+        }
+        hls_segmenter_destroy(segs[i]);
+    }
+    if (rc != 0)
+        return -1;
+
+    printf("BENCH ts_ladder: rungs=%d mode=%s mux_us_per_s=%.0f\n", RUNGS,
+           parallel ? "parallel" : "sequential", busy / MEDIA_SEC);
+    return 0;
+}
+
+/* ── CRC ───────────────────────────────────────────────────────────── */
+
+static void bench_crc(void) {
+    uint8_t *buf = malloc(CRC_BYTES);
+    if (!buf)
+        return;
+    for (size_t i = 0; i < CRC_BYTES; i++)
+        buf[i] = (uint8_t)(i * 131);
+
+    volatile uint32_t sink = 0;
+    double t0 = now_us();
+    for (int i = 0; i < CRC_ROUNDS; i++)
+        sink ^= legacy_crc(buf, CRC_BYTES);
+    double bitwise_us = now_us() - t0;
+
+    t0 = now_us();
+    for (int i = 0; i < CRC_ROUNDS; i++)
+        sink ^= ts_crc32_mpeg(buf, CRC_BYTES);
+    double sliced_us = now_us() - t0;
+    (void)sink;
+
+    double mb = (double)CRC_BYTES * CRC_ROUNDS / 1e6;
+    printf("BENCH ts_crc: mode=bitwise mb_s=%.0f\n", mb / (bitwise_us / 1e6));
+    printf("BENCH ts_crc: mode=slicing8 mb_s=%.0f\n", mb / (sliced_us / 1e6));
+    free(buf);
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+
+    video_buf = malloc(frame_bytes(rung_kbps[0], 0));
+    if (!video_buf)
+        return 1;
+    memset(video_buf, 0x5A, frame_bytes(rung_kbps[0], 0));
+    memset(audio_buf, 0xA5, sizeof(audio_buf));
+
+    stream_result_t legacy, buffered;
+    if (mux_stream(dir, true, &legacy) != 0 || mux_stream(dir, false, &buffered) != 0) {
+        free(video_buf);
+        return 1;
+    }
+    int rc = mux_ladder(dir, false) | mux_ladder(dir, true);
+    bench_crc();
+    free(video_buf);
+
+    return (rc == 0 && buffered.syscalls_per_s >= 0.0 && buffered.syscalls_per_s < 10.0 &&
+            buffered.mux_us_per_s < legacy.mux_us_per_s)
+               ? 0
+               : 1;
+}
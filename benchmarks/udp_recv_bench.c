@@ -0,0 +1,178 @@
+/*
+ * udp_recv_bench.c — Loopback UDP receive rate and drop rate
+ *
+ * A sender thread replays keyframe bursts (150 × 1200-byte datagrams every
+ * 5 ms, ~30 000 packets/s) at a loopback socket with a 256 KB receive
+ * buffer for 2 s.  The receiver runs a client-style loop: one receive call
+ * with a 1 ms timeout, then ~20 µs of other per-iteration work (decode,
+ * present).  Two receive calls are compared:
+ *
+ *   legacy  — poll(0) + one recvfrom() per call (the old rootstream_net_recv)
+ *   batched — udp_rx: epoll wait with the real timeout, then recvmmsg()
+ *             batches of 64 until the socket is drained (max 8 batches)
+ *
+ * Output format:
+ *   BENCH udp_recv_<mode>: sent=N received=N pps=X drop_pct=X syscalls_per_pkt=X
+ *
+ * Exit: 0 if the batched receiver drops fewer packets than legacy and
+ *       stays under 1 % loss, 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "network/udp_rx.h"
+
+#define PACKET_BYTES     1200
+#define BURST_PACKETS    150      /* One ~180 KB keyframe */
+#define BURST_PERIOD_US  5000
+#define RUN_US           2000000  /* 2 s */
+#define RCVBUF_BYTES     (256 * 1024)
+#define LOOP_WORK_US     20
+#define RX_MAX_BATCHES   8
+
+typedef struct {
+    struct sockaddr_in dst;
+    atomic_int done;
+    uint64_t sent;
+} sender_t;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static void spin_us(uint64_t us) {
+    uint64_t end = now_us() + us;
+    while (now_us() < end) { }
+}
+
+static void *sender_main(void *arg) {
+    sender_t *s = (sender_t *)arg;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint8_t pkt[PACKET_BYTES];
+    memset(pkt, 0x5A, sizeof(pkt));
+
+    uint64_t start = now_us();
+    uint64_t next = start;
+    while (now_us() - start < RUN_US) {
+        for (int i = 0; i < BURST_PACKETS; i++) {
+            if (sendto(fd, pkt, sizeof(pkt), 0, (struct sockaddr *)&s->dst,
+                       sizeof(s->dst)) == (ssize_t)sizeof(pkt))
+                s->sent++;
+        }
+        next += BURST_PERIOD_US;
+        uint64_t now = now_us();
+        if (next > now) usleep((useconds_t)(next - now));
+    }
+
+    close(fd);
+    atomic_store(&s->done, 1);
+    return NULL;
+}
+
+/* Per-datagram dispatch stand-in: touch the payload like header parsing */
+static volatile uint32_t sink;
+static void dispatch(const uint8_t *data, size_t len) {
+    sink += data[0] + data[len - 1];
+}
+
+/* Returns drop percentage, or -1 on setup failure */
+static double run(int batched) {
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = RCVBUF_BYTES;
+    setsockopt(rx_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sender_t s;
+    memset(&s, 0, sizeof(s));
+    s.dst.sin_family      = AF_INET;
+    s.dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(s.dst);
+    if (rx_fd < 0 || bind(rx_fd, (struct sockaddr *)&s.dst, sizeof(s.dst)) < 0 ||
+        getsockname(rx_fd, (struct sockaddr *)&s.dst, &len) < 0) {
+        perror("receiver socket"); return -1;
+    }
+
+    udp_rx_t *rx = batched ? udp_rx_create(rx_fd, UDP_RX_MAX_BATCH, 2048) : NULL;
+    if (batched && !rx) { fprintf(stderr, "udp_rx_create failed\n"); return -1; }
+
+    uint8_t buf[2048];
+    uint64_t received = 0, syscalls = 0, idle_since = 0;
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, sender_main, &s);
+    uint64_t t0 = now_us();
+
+    for (;;) {
+        uint64_t before = received;
+
+        if (batched) {
+            syscalls++;
+            if (udp_rx_wait(rx, 1) > 0) {
+                for (int b = 0; b < RX_MAX_BATCHES; b++) {
+                    int n = udp_rx_recv(rx);
+                    for (int i = 0; i < n; i++) {
+                        udp_rx_packet_t *p = udp_rx_packet(rx, i);
+                        dispatch(p->data, p->len);
+                    }
+                    if (n > 0) received += (uint64_t)n;
+                    if (n < UDP_RX_MAX_BATCH) break;
+                }
+            }
+        } else {
+            struct pollfd pfd = {.fd = rx_fd, .events = POLLIN};
+            syscalls++;
+            if (poll(&pfd, 1, 0) > 0) {
+                ssize_t r = recvfrom(rx_fd, buf, sizeof(buf), 0, NULL, NULL);
+                syscalls++;
+                if (r > 0) { dispatch(buf, (size_t)r); received++; }
+            }
+        }
+
+        spin_us(LOOP_WORK_US);
+
+        /* Stop once the sender is done and the socket stays empty */
+        if (received != before) {
+            idle_since = 0;
+        } else if (atomic_load(&s.done)) {
+            if (!idle_since) idle_since = now_us();
+            else if (now_us() - idle_since > 50000) break;
+        }
+    }
+    uint64_t elapsed = now_us() - t0;
+    pthread_join(tid, NULL);
+
+    if (batched) {
+        udp_rx_stats_t st;
+        udp_rx_get_stats(rx, &st);
+        syscalls += st.syscalls;
+        udp_rx_destroy(rx);
+    }
+    close(rx_fd);
+
+    double drop_pct = s.sent ? 100.0 * (double)(s.sent - received) / (double)s.sent : 0.0;
+    printf("BENCH udp_recv_%s: sent=%lu received=%lu pps=%.0f drop_pct=%.2f "
+           "syscalls_per_pkt=%.3f\n",
+           batched ? "batched" : "legacy", (unsigned long)s.sent, (unsigned long)received,
+           (double)received * 1e6 / (double)elapsed, drop_pct,
+           received ? (double)syscalls / (double)received : 0.0);
+    return drop_pct;
+}
+
+int main(void) {
+    double legacy  = run(0);
+    double batched = run(1);
+    if (legacy < 0 || batched < 0) return 1;
+    return (batched < legacy && batched < 1.0) ? 0 : 1;
+}
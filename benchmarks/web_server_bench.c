@@ -0,0 +1,258 @@
+/*
+ * web_server_bench.c — Embedded HTTP/WebSocket server under dashboard load
+ *
+ * Starts the epoll server on loopback and drives it from one client
+ * thread that multiplexes its own sockets with epoll:
+ *
+ *   http — 64 keep-alive connections issuing GETs back to back
+ *   ws   — 2000 WebSocket dashboards receiving 100 broadcast frames of
+ *          300 bytes, one every 50 ms (a 20 Hz metrics feed)
+ *
+ * For the broadcast run it reports the CPU time the publishing thread
+ * pays per http_server_broadcast() call and how long after the call the
+ * last of the 2000 clients has the frame.
+ *
+ * Output format:
+ *   BENCH web_http: conns=N requests=N req_per_s=X
+ *   BENCH web_ws: clients=N frames=N delivered=N call_us=X fanout_p50_us=X fanout_p99_us=X
+ *
+ * Exit: 0 if every client receives every frame, a broadcast call costs
+ *       under 20 µs and fan-out completes within 50 ms at p99, 1 otherwise.
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "web/http_server.h"
+
+#define HTTP_CONNS    64
+#define HTTP_REQUESTS 200000
+#define WS_CLIENTS    2000
+#define WS_FRAMES     100
+#define FRAME_BYTES   300
+#define FRAME_GAP_US  50000
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* CPU time of the calling thread: on a loaded host the wakeup may hand the
+ * core to the server thread mid-call, which is not the caller's cost */
+static double thread_cpu_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int connect_to(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+        return -1;
+    return fd;
+}
+
+static void hello(const http_request_t *req, http_response_t *res, void *user) {
+    (void)req;
+    (void)user;
+    res->body = strdup("{\"ok\": true}");
+    res->body_len = strlen(res->body);
+}
+
+/* ── HTTP keep-alive throughput ──────────────────────────────────── */
+
+static int run_http(uint16_t port) {
+    static const char req[] = "GET /api/hello HTTP/1.1\r\nHost: bench\r\n\r\n";
+    int ep = epoll_create1(0);
+    int fds[HTTP_CONNS];
+    for (int i = 0; i < HTTP_CONNS; i++) {
+        fds[i] = connect_to(port);
+        if (fds[i] < 0)
+            return -1;
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = (uint32_t)i};
+        epoll_ctl(ep, EPOLL_CTL_ADD, fds[i], &ev);
+    }
+
+    int sent = 0, done = 0;
+    double t0 = now_us();
+    for (int i = 0; i < HTTP_CONNS; i++, sent++)
+        if (write(fds[i], req, sizeof(req) - 1) < 0)
+            return -1;
+    while (done < HTTP_REQUESTS) {
+        struct epoll_event evs[HTTP_CONNS];
+        int n = epoll_wait(ep, evs, HTTP_CONNS, 2000);
+        if (n <= 0)
+            return -1;
+        for (int i = 0; i < n; i++) {
+            int fd = fds[evs[i].data.u32];
+            char buf[512];
+            /* Responses are small and never pipelined here: one read each */
+            if (read(fd, buf, sizeof(buf)) <= 0)
+                return -1;
+            done++;
+            if (sent < HTTP_REQUESTS) {
+                if (write(fd, req, sizeof(req) - 1) < 0)
+                    return -1;
+                sent++;
+            }
+        }
+    }
+    double elapsed = now_us() - t0;
+    printf("BENCH web_http: conns=%d requests=%d req_per_s=%.0f\n", HTTP_CONNS, HTTP_REQUESTS,
+           HTTP_REQUESTS / (elapsed / 1e6));
+    for (int i = 0; i < HTTP_CONNS; i++)
+        close(fds[i]);
+    close(ep);
+    return 0;
+}
+
+/* ── WebSocket fan-out ───────────────────────────────────────────── */
+
+typedef struct {
+    int fd;
+    unsigned char buf[4096];
+    size_t len;
+} ws_client_t;
+
+static double sent_at[WS_FRAMES], last_at[WS_FRAMES];
+static int got[WS_FRAMES];
+
+/* Consume complete frames; payload starts with the frame number */
+static void ws_drain(ws_client_t *c) {
+    for (;;) {
+        ssize_t n = read(c->fd, c->buf + c->len, sizeof(c->buf) - c->len);
+        if (n <= 0)
+            break;
+        c->len += (size_t)n;
+    }
+    double t = now_us();
+    size_t off = 0;
+    while (c->len - off >= 4) {
+        size_t plen = c->buf[off + 1] & 0x7F, hdr = 2;
+        if (plen == 126) {
+            plen = (size_t)c->buf[off + 2] << 8 | c->buf[off + 3];
+            hdr = 4;
+        }
+        if (c->len - off < hdr + plen)
+            break;
+        int seq = atoi((const char *)c->buf + off + hdr);
+        if (seq >= 0 && seq < WS_FRAMES) {
+            got[seq]++;
+            if (t > last_at[seq])
+                last_at[seq] = t;
+        }
+        off += hdr + plen;
+    }
+    memmove(c->buf, c->buf + off, c->len - off);
+    c->len -= off;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int run_ws(http_server_t *s, uint16_t port, double *call_us, double *p99_us) {
+    static ws_client_t clients[WS_CLIENTS];
+    static const char upgrade[] =
+        "GET /live HTTP/1.1\r\nHost: bench\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    int ep = epoll_create1(0);
+    for (int i = 0; i < WS_CLIENTS; i++) {
+        ws_client_t *c = &clients[i];
+        c->fd = connect_to(port);
+        if (c->fd < 0 || write(c->fd, upgrade, sizeof(upgrade) - 1) < 0)
+            return -1;
+        /* Swallow the 101 response (ends the first read on loopback) */
+        char buf[256];
+        if (read(c->fd, buf, sizeof(buf)) <= 0)
+            return -1;
+        fcntl(c->fd, F_SETFL, O_NONBLOCK);
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = c};
+        epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+    }
+    while (http_server_get_ws_count(s) < WS_CLIENTS)
+        usleep(1000);
+
+    char payload[FRAME_BYTES];
+    double call_total = 0.0;
+    int frame = 0;
+    double next = now_us();
+    long delivered = 0;
+    while (delivered < (long)WS_CLIENTS * WS_FRAMES) {
+        double t = now_us();
+        if (frame < WS_FRAMES && t >= next) {
+            memset(payload, 'x', sizeof(payload));
+            int n = snprintf(payload, sizeof(payload), "%d ", frame);
+            payload[n] = ' ';
+            double cpu0 = thread_cpu_us();
+            sent_at[frame] = now_us();
+            http_server_broadcast(s, payload, sizeof(payload));
+            call_total += thread_cpu_us() - cpu0;
+            frame++;
+            next += FRAME_GAP_US;
+        }
+        struct epoll_event evs[256];
+        int n = epoll_wait(ep, evs, 256, frame < WS_FRAMES ? 1 : 2000);
+        if (n == 0 && frame == WS_FRAMES)
+            break; /* Something was lost */
+        for (int i = 0; i < n; i++)
+            ws_drain(evs[i].data.ptr);
+        delivered = 0;
+        for (int k = 0; k < frame; k++)
+            delivered += got[k];
+    }
+
+    double fan[WS_FRAMES];
+    for (int k = 0; k < WS_FRAMES; k++)
+        fan[k] = last_at[k] - sent_at[k];
+    qsort(fan, WS_FRAMES, sizeof(double), cmp_double);
+    *call_us = call_total / WS_FRAMES;
+    *p99_us = fan[WS_FRAMES * 99 / 100];
+    printf("BENCH web_ws: clients=%d frames=%d delivered=%ld call_us=%.1f fanout_p50_us=%.0f "
+           "fanout_p99_us=%.0f\n",
+           WS_CLIENTS, WS_FRAMES, delivered, *call_us, fan[WS_FRAMES / 2], *p99_us);
+    for (int i = 0; i < WS_CLIENTS; i++)
+        close(clients[i].fd);
+    close(ep);
+    return delivered == (long)WS_CLIENTS * WS_FRAMES ? 0 : -1;
+}
+
+int main(void) {
+    /* Two descriptors per client (both ends live in this process) */
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < 2 * WS_CLIENTS + 64 && rl.rlim_max >= 2 * WS_CLIENTS + 64) {
+        rl.rlim_cur = 2 * WS_CLIENTS + 64;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    http_server_config_t cfg = {.bind_addr = "127.0.0.1"};
+    http_server_t *s = http_server_create(&cfg);
+    if (!s || http_server_route(s, "GET", "/api/hello", hello, NULL) != 0 ||
+        http_server_websocket(s, "/live") != 0 || http_server_start(s) != 0)
+        return 1;
+    uint16_t port = http_server_get_port(s);
+
+    if (run_http(port) != 0)
+        return 1;
+    double call_us = 0.0, p99_us = 0.0;
+    int ws = run_ws(s, port, &call_us, &p99_us);
+    http_server_destroy(s);
+
+    return (ws == 0 && call_us < 20.0 && p99_us < 50000.0) ? 0 : 1;
+}
@@ -73,6 +73,9 @@ void StreamBackendConnector::connectToHost(const QString &host,
     cfg.peer_port     = port;
     cfg.audio_enabled = true;
     cfg.low_latency   = true;
+    /* Receive and decode on the core's own threads, so a busy GUI or
+     * render thread never stalls packet reception */
+    cfg.threaded      = true;
 
     session_ = rs_client_session_create(&cfg);
     if (!session_) {
@@ -152,6 +155,28 @@ QString StreamBackendConnector::decoderName() const {
     return QString::fromUtf8(rs_client_session_decoder_name(session_));
 }
 
+QVariantMap StreamBackendConnector::pipelineStats() const {
+    QVariantMap m;
+    rs_client_stats_t st;
+    if (!session_ || rs_client_session_get_stats(session_, &st) != 0) return m;
+
+    m[QStringLiteral("decodeQueueDepth")]     = st.decode_queue_depth;
+    m[QStringLiteral("decodeQueueCapacity")]  = st.decode_queue_capacity;
+    m[QStringLiteral("presentQueueDepth")]    = st.present_queue_depth;
+    m[QStringLiteral("presentQueueCapacity")] = st.present_queue_capacity;
+    m[QStringLiteral("framesHeld")]           = st.frames_held;
+    m[QStringLiteral("framesReceived")]       = QVariant::fromValue<quint64>(st.frames_received);
+    m[QStringLiteral("framesDecoded")]        = QVariant::fromValue<quint64>(st.frames_decoded);
+    m[QStringLiteral("framesPresented")]      = QVariant::fromValue<quint64>(st.frames_presented);
+    m[QStringLiteral("receiveDropped")]       = QVariant::fromValue<quint64>(st.receive_dropped);
+    m[QStringLiteral("presentDropped")]       = QVariant::fromValue<quint64>(st.present_dropped);
+    m[QStringLiteral("decodeErrors")]         = QVariant::fromValue<quint64>(st.decode_errors);
+    m[QStringLiteral("queueWaitUs")]          = st.queue_wait_us;
+    m[QStringLiteral("decodeUs")]             = st.decode_us;
+    m[QStringLiteral("presentWaitUs")]        = st.present_wait_us;
+    return m;
+}
+
 /* ── C callback trampolines ───────────────────────────────────────── */
 
 /*
@@ -205,7 +230,7 @@ void StreamBackendConnector::cVideoCallback(void                  *user,
 }
 
 /*
- * cAudioCallback — called from the session worker thread each audio buffer.
+ * cAudioCallback — called from the session network thread each audio buffer.
  *
  * Copies PCM int16 samples into a QByteArray and emits audioSamplesReady.
  * The AudioPlayer receives this signal and feeds the data to the audio
@@ -23,7 +23,10 @@
  * THREADING
  * ---------
  *   GUI thread:     creates StreamBackendConnector, calls connectToHost/disconnect
- *   Session thread: rs_client_session_run() blocks here; C callbacks fire here
+ *   Session thread: rs_client_session_run() blocks here; the video callback
+ *                   fires here
+ *   Core threads:   the session's network thread (audio callback fires
+ *                   here) and decode thread
  *   Render thread:  VideoRenderer::synchronize() and render() run here
  *
  * The C callbacks copy frame data and emit Qt signals (QueuedConnection),
@@ -43,6 +46,7 @@
 #include <QThread>
 #include <QByteArray>
 #include <QString>
+#include <QVariantMap>
 
 extern "C" {
 #include "rootstream_client_session.h"
@@ -78,6 +82,18 @@ public:
     /** Returns the decoder backend name after streaming starts */
     QString decoderName() const;
 
+    /**
+     * pipelineStats — queue depths, drop counters and per-stage timings
+     * of the session pipeline, for the HUD.  Thread-safe; empty before
+     * the session has started.
+     *
+     * Keys: decodeQueueDepth, decodeQueueCapacity, presentQueueDepth,
+     * presentQueueCapacity, framesHeld, framesReceived, framesDecoded,
+     * framesPresented, receiveDropped, presentDropped, decodeErrors,
+     * queueWaitUs, decodeUs, presentWaitUs.
+     */
+    QVariantMap pipelineStats() const;
+
 signals:
     /**
      * videoFrameReady — emitted (QueuedConnection) when a decoded frame is ready.
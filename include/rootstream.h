@@ -7,6 +7,9 @@
 /* Platform abstraction for cross-platform socket types */
 #include "../src/platform/platform.h"
 
+/* Per-peer nonce replay window (embedded in peer_t) */
+#include "../src/network/replay_window.h"
+
 /* Cross-platform packed struct support */
 #ifdef _MSC_VER
 #define PACKED_STRUCT __pragma(pack(push, 1)) struct
@@ -49,15 +52,24 @@
 #define ROOTSTREAM_VERSION "1.0.0"
 #define PROTOCOL_VERSION 1
 #define PROTOCOL_MIN_VERSION 1
-#define PROTOCOL_FLAGS 0
+#define PROTOCOL_FLAG_TRANSPORT_FEEDBACK 0x01 /* Receiver sends PKT_FEEDBACK */
+#define PROTOCOL_FLAG_NACK 0x02               /* Lost video is requested with PKT_NACK */
+#define PROTOCOL_FLAG_INPUT_BATCH 0x04        /* Input arrives as PKT_INPUT_BATCH */
+#define PROTOCOL_FLAG_PLPMTUD 0x08            /* Path MTU probes (PKT_PROBE) are answered */
+#define PROTOCOL_FLAG_SESSION_NONCE 0x10      /* Handshake nonces salt the session key */
+#define PROTOCOL_FLAGS                                                                 \
+    (PROTOCOL_FLAG_TRANSPORT_FEEDBACK | PROTOCOL_FLAG_NACK | PROTOCOL_FLAG_INPUT_BATCH | \
+     PROTOCOL_FLAG_PLPMTUD | PROTOCOL_FLAG_SESSION_NONCE)
 #define MAX_DISPLAYS 4
-#define MAX_PACKET_SIZE 1400
+#define MAX_PACKET_SIZE 1400       /* Datagram size until path MTU probing finds a larger one */
+#define MAX_JUMBO_PACKET_SIZE 8900 /* Largest datagram (9000-byte MTU less IP/UDP headers) */
 #define MAX_PEERS 16
 
 /* Cryptographic constants (libsodium) */
 #define CRYPTO_PUBLIC_KEY_BYTES 32
 #define CRYPTO_SECRET_KEY_BYTES 32
 #define CRYPTO_NONCE_BYTES 24
+#define CRYPTO_SESSION_NONCE_BYTES 32 /* Per-handshake random salt */
 #define CRYPTO_MAC_BYTES 16
 #define CRYPTO_SHARED_KEY_BYTES 32
 
@@ -106,6 +118,13 @@ typedef enum {
 typedef struct rootstream_ctx rootstream_ctx_t;
 typedef struct frame_buffer frame_buffer_t;
 
+/*
+ * capture_fn returns 0 for a new frame, -1 on error, or CAPTURE_UNCHANGED
+ * when the screen has not changed since the last frame: @frame is left
+ * untouched and the caller skips encode and send for that tick.
+ */
+#define CAPTURE_UNCHANGED 1
+
 /* Capture backend interface */
 typedef struct capture_backend {
     const char *name;
@@ -125,18 +144,47 @@ typedef struct {
     char name[64];         /* Display name (e.g., "HDMI-A-1") */
 } display_info_t;
 
+#define FRAME_MAX_DIRTY_RECTS 16
+
+typedef struct {
+    uint16_t x, y;
+    uint16_t width, height;
+} frame_rect_t;
+
 typedef struct frame_buffer {
-    uint8_t *data;      /* Frame pixel data (RGBA) */
-    uint32_t size;      /* Total size in bytes */
-    uint32_t capacity;  /* Allocated buffer size in bytes */
-    uint32_t width;     /* Frame width */
-    uint32_t height;    /* Frame height */
-    uint32_t pitch;     /* Bytes per row (stride) */
-    uint32_t format;    /* Pixel format — use FRAME_FORMAT_* constants */
-    uint64_t timestamp; /* Capture timestamp (microseconds) */
-    bool is_keyframe;   /* True if this is an I-frame/IDR */
+    uint8_t *data;                             /* Frame pixel data (RGBA) */
+    uint32_t size;                             /* Total size in bytes */
+    uint32_t capacity;                         /* Allocated buffer size in bytes */
+    uint32_t width;                            /* Frame width */
+    uint32_t height;                           /* Frame height */
+    uint32_t pitch;                            /* Bytes per row (stride) */
+    uint32_t format;                           /* Pixel format — use FRAME_FORMAT_* constants */
+    uint64_t timestamp;                        /* Capture timestamp (microseconds) */
+    bool is_keyframe;                          /* True if this is an I-frame/IDR */
+    uint32_t dirty_count;                      /* Changed rects, 0 = whole frame */
+    frame_rect_t dirty[FRAME_MAX_DIRTY_RECTS]; /* Changed since the previous capture */
+    uint32_t memory;                           /* FRAME_MEMORY_* — where the pixels live */
+    int dmabuf_fd;                             /* FRAME_MEMORY_DMABUF: owned by capture */
+    const uint8_t *mapped;                     /* FRAME_MEMORY_DMABUF: CPU view, or NULL */
 } frame_buffer_t;
 
+/*
+ * frame_buffer_t.memory
+ *
+ * A DMABUF frame leaves data untouched: the pixels stay in the capture
+ * backend's framebuffer (offset 0, pitch bytes per row), which GPU
+ * encoders can import by fd and CPU encoders read through mapped.  Both
+ * stay valid until the backend has captured FB_CACHE_MAX_ENTRIES other
+ * framebuffers or is cleaned up.
+ */
+#define FRAME_MEMORY_CPU    0 /* Pixels in data (caller-owned buffer) */
+#define FRAME_MEMORY_DMABUF 1 /* Pixels in dmabuf_fd */
+
+/* CPU-readable pixels of a frame, or NULL for a DMABUF frame without a mapping */
+static inline const uint8_t *frame_buffer_pixels(const frame_buffer_t *frame) {
+    return frame->memory == FRAME_MEMORY_DMABUF ? frame->mapped : frame->data;
+}
+
 /* Pixel format constants for frame_buffer_t.format */
 #define FRAME_FORMAT_RGBA 0 /* 32-bit RGBA, 4 bytes/pixel */
 #define FRAME_FORMAT_NV12 1 /* YUV 4:2:0, Y plane + interleaved UV */
@@ -152,10 +200,17 @@ typedef struct {
     uint64_t encode_us;  /* Encode duration */
     uint64_t send_us;    /* Send duration (all peers) */
     uint64_t total_us;   /* Capture → send duration */
+
+    /* Pipelined host only (zero in the serial loop) */
+    uint64_t encode_wait_us;      /* Time queued between capture and encode */
+    uint64_t send_wait_us;        /* Time queued between encode and send */
+    uint32_t capture_queue_depth; /* Raw frames waiting when encode started */
+    uint32_t encode_queue_depth;  /* Encoded frames waiting when send started */
 } latency_sample_t;
 
 typedef struct {
     bool enabled;                /* Enable latency logging */
+    bool pipelined;              /* Report queue wait/depth columns */
     size_t capacity;             /* Ring buffer capacity */
     size_t count;                /* Samples stored */
     size_t cursor;               /* Next insert position */
@@ -186,8 +241,12 @@ typedef struct {
     int device_fd;       /* Encoder device file descriptor */
     void *hw_ctx;        /* Hardware context (opaque) */
 
-    /* Encoding parameters */
+    /* Encoding parameters.  The network thread retargets the bitrate and
+     * asks for keyframes while the encode thread runs: once encoding has
+     * started, bitrate, max_bitrate and force_keyframe are only accessed
+     * through the encoder_*() helpers below. */
     uint32_t bitrate;       /* Target bitrate (bits/sec) */
+    uint32_t max_bitrate;   /* Congestion control ceiling, 0 = initial bitrate */
     uint32_t framerate;     /* Target framerate (fps) */
     uint8_t quality;        /* Quality level 0-100 */
     bool low_latency;       /* Enable low-latency mode */
@@ -195,6 +254,42 @@ typedef struct {
     size_t max_output_size; /* Max encoded output size (bytes) */
 } encoder_ctx_t;
 
+#ifndef __cplusplus
+/* Atomic access to the encoder fields shared between threads.  The fields
+ * stay plain so C++ code can include this header. */
+static inline uint32_t encoder_get_bitrate(const encoder_ctx_t *enc) {
+    return __atomic_load_n(&enc->bitrate, __ATOMIC_RELAXED);
+}
+
+static inline void encoder_set_bitrate(encoder_ctx_t *enc, uint32_t bps) {
+    __atomic_store_n(&enc->bitrate, bps, __ATOMIC_RELAXED);
+}
+
+static inline uint32_t encoder_get_max_bitrate(const encoder_ctx_t *enc) {
+    return __atomic_load_n(&enc->max_bitrate, __ATOMIC_RELAXED);
+}
+
+static inline void encoder_set_max_bitrate(encoder_ctx_t *enc, uint32_t bps) {
+    __atomic_store_n(&enc->max_bitrate, bps, __ATOMIC_RELAXED);
+}
+
+/* Ask for the next encoded frame to be a keyframe */
+static inline void encoder_request_keyframe(encoder_ctx_t *enc) {
+    __atomic_store_n(&enc->force_keyframe, true, __ATOMIC_RELEASE);
+}
+
+/* Whether a keyframe request is outstanding (does not consume it) */
+static inline bool encoder_keyframe_pending(const encoder_ctx_t *enc) {
+    return __atomic_load_n(&enc->force_keyframe, __ATOMIC_ACQUIRE);
+}
+
+/* Consume a keyframe request: a request that arrives during the call is
+ * either returned or left for the next frame, never lost */
+static inline bool encoder_take_keyframe(encoder_ctx_t *enc) {
+    return __atomic_exchange_n(&enc->force_keyframe, false, __ATOMIC_ACQ_REL);
+}
+#endif
+
 /* Forward declaration for encoder_backend_t */
 typedef struct encoder_backend_t encoder_backend_t;
 
@@ -248,13 +343,20 @@ packet_header_t;
 PACKED_STRUCT_END
 
 /* Packet types */
-#define PKT_HANDSHAKE 0x01 /* Initial key exchange */
-#define PKT_VIDEO 0x02     /* Encrypted video frame */
-#define PKT_AUDIO 0x03     /* Encrypted audio frame */
-#define PKT_INPUT 0x04     /* Encrypted input events */
-#define PKT_CONTROL 0x05   /* Control messages */
-#define PKT_PING 0x06      /* Keepalive ping */
-#define PKT_PONG 0x07      /* Keepalive pong */
+#define PKT_HANDSHAKE 0x01   /* Initial key exchange */
+#define PKT_VIDEO 0x02       /* Encrypted video frame */
+#define PKT_AUDIO 0x03       /* Encrypted audio frame */
+#define PKT_INPUT 0x04       /* Encrypted input events */
+#define PKT_CONTROL 0x05     /* Control messages */
+#define PKT_PING 0x06        /* Keepalive ping */
+#define PKT_PONG 0x07        /* Keepalive pong */
+#define PKT_FEEDBACK 0x08    /* Encrypted transport feedback (congestion/transport_feedback.h) */
+#define PKT_NACK 0x09        /* Encrypted retransmission request (network/nack.h) */
+#define PKT_INPUT_BATCH 0x0A /* Encrypted timestamped input events (input/input_batch.h) */
+#define PKT_PROBE 0x0B       /* Encrypted padded path MTU probe or its ack (network/plpmtud.h) */
+
+/* Packet flags (packet_header_t.flags) */
+#define PKT_FLAG_RETRANSMIT 0x0001 /* Resent copy of an earlier packet, same nonce */
 
 /* Control command types for PKT_CONTROL */
 typedef enum {
@@ -265,6 +367,7 @@ typedef enum {
     CTRL_REQUEST_KEYFRAME = 0x05, /* Request immediate keyframe */
     CTRL_SET_QUALITY = 0x06,      /* Change quality level */
     CTRL_DISCONNECT = 0x07,       /* Graceful disconnect */
+    CTRL_SET_FEC = 0x08,          /* Video FEC repair overhead (percent, 0 = off) */
 } control_cmd_t;
 
 /* Control packet payload (encrypted) */
@@ -281,12 +384,26 @@ typedef PACKED_STRUCT {
     uint32_t total_size;   /* Total encoded frame size */
     uint32_t offset;       /* Offset of this chunk */
     uint16_t chunk_size;   /* Size of this chunk */
-    uint16_t flags;        /* Reserved for future use */
+    uint16_t flags;        /* VIDEO_CHUNK_* */
     uint64_t timestamp_us; /* Capture timestamp */
 }
 video_chunk_header_t;
 PACKED_STRUCT_END
 
+/* Chunk is an FEC repair: a video_fec_header_t follows the chunk header,
+ * offset is the byte offset of the group's first source chunk and
+ * chunk_size the repair length (the frame's chunk stride) */
+#define VIDEO_CHUNK_REPAIR 0x0001
+
+/* FEC repair chunk header (Cauchy Reed-Solomon, see src/fec/) */
+typedef PACKED_STRUCT {
+    uint8_t group_k;    /* Source chunks in the group */
+    uint8_t repair_idx; /* Repair index within the group */
+    uint16_t reserved;
+}
+video_fec_header_t;
+PACKED_STRUCT_END
+
 /* Audio payload header (inside encrypted payload) */
 typedef PACKED_STRUCT {
     uint64_t timestamp_us; /* Capture timestamp */
@@ -349,6 +466,7 @@ typedef struct {
     /* Multi-client tracking */
     input_client_info_t clients[INPUT_MAX_CLIENTS];
     int active_client_count;
+    uint32_t next_client_id; /* Last id handed to a peer (input.c) */
 
     /* Statistics */
     uint64_t total_inputs_processed;
@@ -356,6 +474,14 @@ typedef struct {
     uint64_t total_latency_us;
     uint32_t latency_samples;
 
+    /* Click-to-photon: a press waits for the first frame captured after
+     * it was injected (input_manager_on_video_frame) */
+    uint64_t pending_click_us;        /* Host-clock time of the press, 0 = none */
+    uint64_t pending_click_inject_us; /* When it was injected */
+    uint64_t total_click_latency_us;
+    uint32_t click_latency_samples;
+    uint64_t max_click_latency_us;
+
     /* Configuration */
     bool initialized;
 } input_manager_ctx_t;
@@ -392,21 +518,41 @@ typedef struct {
     char hostname[64];                             /* Peer hostname */
     bool is_streaming;                             /* Currently streaming? */
     uint32_t video_tx_frame_id;                    /* Outgoing video frame counter */
-    uint32_t video_rx_frame_id;                    /* Current incoming frame id */
-    uint8_t *video_rx_buffer;                      /* Reassembly buffer */
-    size_t video_rx_capacity;                      /* Reassembly buffer size */
-    size_t video_rx_expected;                      /* Expected frame size */
-    size_t video_rx_received;                      /* Bytes received so far */
+    struct frame_reasm_s *video_rx;                /* Video reassembler (chunk/frame_reasm) */
+    uint64_t video_rx_keyframe_req;                /* Last loss keyframe request (ms) */
+    uint8_t video_fec_percent;                     /* FEC overhead the receiver asked for */
+    uint8_t video_rx_fec_percent;                  /* FEC overhead we asked the sender for */
+    uint8_t video_rx_fec_clean;                    /* Loss-free FEC periods in a row */
+    uint64_t video_rx_fec_check;                   /* Last FEC level update (ms) */
+    uint64_t video_rx_fec_lost;                    /* Lost chunks at last update */
+    uint64_t video_rx_fec_total;                   /* Expected chunks at last update */
+    struct peer_tx_s *tx;                          /* Send arena + UDP batch (network.c) */
+    int fanout_lane;                               /* Video fan-out lane + 1, 0 = none */
+    int pacer_flow;                                /* Paced video flow + 1, 0 = none */
     uint64_t last_sent;                            /* Last outbound packet time (ms) */
     uint64_t last_ping;                            /* Last keepalive ping time (ms) */
     uint8_t protocol_version;                      /* Peer protocol version */
     uint8_t protocol_flags;                        /* Peer protocol flags */
+    struct tfb_recorder_s *rx_feedback;            /* Arrivals to report (feedback receiver) */
+    uint64_t rx_feedback_sent;                     /* Last feedback report (ms) */
+    struct delay_controller_s *tx_cc;              /* Send-rate controller (feedback sender) */
+    struct nack_tracker_s *rx_nack;                /* Lost video to request (NACK receiver) */
+    struct plpmtud_s *tx_pmtu;                     /* Path MTU search (video sender) */
 
     /* Network resilience (PHASE 4) */
     transport_type_t transport; /* Current transport (UDP/TCP) */
     void *transport_priv;       /* Transport-specific private data */
     void *reconnect_ctx;        /* Reconnection tracking */
     uint64_t last_received;     /* Last inbound packet time (ms) */
+
+    /* Nonces of authenticated inbound packets (replay protection) */
+    replay_window_t rx_replay;
+
+    /* Handshake salts of the current session (PROTOCOL_FLAG_SESSION_NONCE) */
+    uint8_t hs_nonce[CRYPTO_SESSION_NONCE_BYTES];      /* Ours */
+    uint8_t hs_peer_nonce[CRYPTO_SESSION_NONCE_BYTES]; /* The peer's */
+
+    uint32_t input_client_id; /* Input manager client, 0 = none yet (input.c) */
 } peer_t;
 
 /* ============================================================================
@@ -491,6 +637,9 @@ typedef struct {
     uint32_t video_framerate; /* Target framerate (fps) */
     char video_codec[16];     /* Codec: "h264", "h265" */
     int display_index;        /* Preferred display index */
+    bool pipeline_enabled;    /* Run capture/encode/send on separate threads */
+    bool damage_capture;      /* Skip capture/encode while the screen is static */
+    bool zero_copy_capture;   /* Hand frames to the encoder as dmabufs, no copy */
 
     /* Audio settings */
     bool audio_enabled;     /* Enable audio streaming */
@@ -502,6 +651,9 @@ typedef struct {
     uint16_t network_port;  /* UDP port */
     bool discovery_enabled; /* Enable mDNS discovery */
 
+    /* Input settings */
+    bool input_coalesce; /* Merge relative motion within an input batch */
+
     /* Connection history */
     char peer_history[MAX_PEER_HISTORY][ROOTSTREAM_CODE_MAX_LEN];
     int peer_history_count;
@@ -513,12 +665,13 @@ typedef struct {
  * ============================================================================ */
 
 typedef struct {
-    int fd;                 /* Recording file descriptor */
-    bool active;            /* Recording in progress */
-    uint64_t start_time_us; /* Recording start timestamp */
-    uint64_t frame_count;   /* Frames written */
-    uint64_t bytes_written; /* Total bytes written */
-    char filename[256];     /* Output filename */
+    struct rstr_writer_s *writer; /* Background file writer (src/rstr/rstr_writer.h) */
+    bool active;                  /* Recording in progress */
+    uint64_t start_time_us;       /* Recording start timestamp */
+    uint64_t frame_count;         /* Frames queued */
+    uint64_t frames_dropped;      /* Frames dropped while the disk lagged */
+    uint64_t bytes_written;       /* Total bytes queued */
+    char filename[256];           /* Output filename */
 } recording_ctx_t;
 
 /* ============================================================================
@@ -574,8 +727,13 @@ typedef struct rootstream_ctx {
     const audio_playback_backend_t *audio_playback_backend;
 
     /* Network */
-    rs_socket_t sock_fd; /* UDP socket */
-    uint16_t port;       /* Listening port */
+    rs_socket_t sock_fd;         /* UDP socket */
+    uint16_t port;               /* Listening port */
+    struct udp_rx *udp_rx;       /* Batched UDP receive state (network.c) */
+    struct net_fanout_s *fanout; /* Parallel video send workers (network.c) */
+    struct tx_pacer_s *tx_pacer; /* Paced video sender thread (network.c) */
+    bool udp_probe_mtu;          /* sock_fd can send probes with DF (network.c) */
+    int udp_pmtudisc;            /* sock_fd's IP_MTU_DISCOVER mode outside probes */
 
     /* Peer connection target (client mode) */
     char peer_host[256]; /* Peer hostname or IP (client mode) */
@@ -681,6 +839,8 @@ int crypto_format_fingerprint(const uint8_t *public_key, size_t key_len, char *o
                               size_t output_len);
 int crypto_create_session(crypto_session_t *session, const uint8_t *my_secret,
                           const uint8_t *peer_public);
+int crypto_salt_session(crypto_session_t *session, const uint8_t *nonce_a,
+                        const uint8_t *nonce_b);
 int crypto_encrypt_packet(const crypto_session_t *session, const void *plaintext, size_t plain_len,
                           void *ciphertext, size_t *cipher_len, uint64_t nonce);
 int crypto_decrypt_packet(const crypto_session_t *session, const void *ciphertext,
@@ -830,10 +990,14 @@ int rootstream_net_send_encrypted(rootstream_ctx_t *ctx, peer_t *peer, uint8_t t
                                   const void *data, size_t size);
 int rootstream_net_send_video(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data, size_t size,
                               uint64_t timestamp_us);
+int rootstream_net_send_video_all(rootstream_ctx_t *ctx, const uint8_t *data, size_t size,
+                                  uint64_t timestamp_us, bool keyframe);
+void rootstream_net_flush_video(rootstream_ctx_t *ctx);
 int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms);
 int rootstream_net_handshake(rootstream_ctx_t *ctx, peer_t *peer);
 void rootstream_net_tick(rootstream_ctx_t *ctx);
 int rootstream_net_validate_packet(const uint8_t *buffer, size_t len);
+void rootstream_net_cleanup(rootstream_ctx_t *ctx);
 
 /* --- Network TCP Fallback (PHASE 4) --- */
 int rootstream_net_tcp_connect(rootstream_ctx_t *ctx, peer_t *peer);
@@ -842,6 +1006,7 @@ int rootstream_net_tcp_recv(rootstream_ctx_t *ctx, peer_t *peer, uint8_t *buffer
                             size_t *buffer_len);
 void rootstream_net_tcp_cleanup(peer_t *peer);
 bool rootstream_net_tcp_is_healthy(peer_t *peer);
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer);
 
 /* --- Peer Reconnection (PHASE 4) --- */
 int peer_reconnect_init(peer_t *peer);
@@ -895,6 +1060,9 @@ void discovery_print_stats(rootstream_ctx_t *ctx);
 /* --- Input (existing, polished) --- */
 int rootstream_input_init(rootstream_ctx_t *ctx);
 int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event);
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len);
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer);
 void rootstream_input_cleanup(rootstream_ctx_t *ctx);
 
 /* --- Tray UI --- */
@@ -938,6 +1106,9 @@ int input_manager_init(rootstream_ctx_t *ctx, input_backend_type_t backend);
 int input_manager_submit_packet(rootstream_ctx_t *ctx, const input_event_pkt_t *event,
                                 uint32_t client_id, uint16_t sequence_number,
                                 uint64_t timestamp_us);
+int input_manager_submit_batch(rootstream_ctx_t *ctx, const uint8_t *payload, size_t len,
+                               uint32_t client_id);
+void input_manager_on_video_frame(rootstream_ctx_t *ctx, uint64_t capture_us);
 int input_manager_register_client(rootstream_ctx_t *ctx, uint32_t client_id,
                                   const char *client_name);
 int input_manager_unregister_client(rootstream_ctx_t *ctx, uint32_t client_id);
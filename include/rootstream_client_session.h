@@ -37,6 +37,18 @@
  * dedicated thread (not the UI thread).  The callbacks are invoked FROM
  * that same thread.
  *
+ * With rs_client_config_t.threaded set (Linux), run() starts a network
+ * thread and a decode thread and itself becomes the presentation stage:
+ *
+ *   network thread ──▶ decode queue ──▶ decode thread ──▶ presentation
+ *                                                          queue
+ *                                                            │
+ *          on_video (run thread) or rs_client_session_acquire_frame()
+ *
+ * A slow on_video then only backs up the presentation queue, which
+ * keeps the newest frames; packet reception never waits for it.  The
+ * audio callback is invoked from the network thread in this mode.
+ *
  * Callers must ensure their callbacks are thread-safe.  For Qt, the
  * recommended pattern is:
  *
@@ -52,6 +64,12 @@
  * the callback.  The caller MUST copy any data it needs to retain.  This is
  * intentional: the backend reuses decode buffers to avoid per-frame allocation.
  *
+ * Threaded sessions hand out reference-counted video frames instead
+ * (rs_video_frame_t.ref is non-NULL): rs_video_frame_retain() keeps a
+ * frame valid past the callback, on any thread, until the matching
+ * rs_video_frame_release().  Frames from rs_client_session_acquire_frame()
+ * arrive with one reference already held.
+ *
  * NULL SAFETY
  * -----------
  * All public functions are NULL-safe.  Calling any function with a NULL
@@ -92,8 +110,8 @@ typedef enum {
 /**
  * rs_video_frame_t — describes one decoded video frame.
  *
- * LIFETIME: valid only for the duration of the on_video callback.
- * Copy plane data if you need it after the callback returns.
+ * LIFETIME: valid only for the duration of the on_video callback, unless
+ * a reference is held (threaded sessions, see OWNERSHIP above).
  *
  * For NV12 (most common):
  *   plane0 = Y  (luma),   stride0 = bytes per row of Y
@@ -116,6 +134,7 @@ typedef struct {
     int stride2;           /**< Bytes per row for plane2 (0 if NULL)    */
     uint64_t pts_us;       /**< Presentation timestamp (microseconds)   */
     bool is_keyframe;      /**< True if this is an intra-coded frame     */
+    void *ref;             /**< Reference owner (threaded sessions), or NULL */
 } rs_video_frame_t;
 
 /* ── Audio frame descriptor ───────────────────────────────────────── */
@@ -179,8 +198,35 @@ typedef struct {
     const char *peer_code; /**< Optional peer pairing code             */
     bool audio_enabled;    /**< Enable audio decode + callback         */
     bool low_latency;      /**< Request low-latency decode mode        */
+    bool threaded;         /**< Network / decode / present on separate
+                            *  threads (Linux; ignored elsewhere)     */
+    int queue_depth;       /**< Frames per pipeline queue (0 = default) */
 } rs_client_config_t;
 
+/* ── Pipeline statistics ──────────────────────────────────────────── */
+
+/**
+ * rs_client_stats_t — queue depths, counters and per-stage timings of a
+ * threaded session (for HUDs).  Timings are running means over roughly
+ * the last eight frames.
+ */
+typedef struct {
+    uint32_t decode_queue_depth;     /**< Received frames waiting to decode   */
+    uint32_t decode_queue_capacity;  /**< Slots in the decode queue           */
+    uint32_t present_queue_depth;    /**< Decoded frames waiting to present   */
+    uint32_t present_queue_capacity; /**< Slots in the presentation queue     */
+    uint32_t frames_held;            /**< Handed-out frames still referenced  */
+    uint64_t frames_received;        /**< Reassembled frames off the network  */
+    uint64_t frames_decoded;         /**< Frames decoded                      */
+    uint64_t frames_presented;       /**< Frames handed to the application    */
+    uint64_t receive_dropped;        /**< Frames shed before decode           */
+    uint64_t present_dropped;        /**< Decoded frames shed before display  */
+    uint64_t decode_errors;          /**< Failed decode calls                 */
+    uint32_t queue_wait_us;          /**< Reassembled → decode start          */
+    uint32_t decode_us;              /**< Decode duration                     */
+    uint32_t present_wait_us;        /**< Decoded → handed to the application */
+} rs_client_stats_t;
+
 /* ── Session handle ───────────────────────────────────────────────── */
 
 /** Opaque session handle returned by rs_client_session_create() */
@@ -270,6 +316,38 @@ int rs_client_session_run(rs_client_session_t *s);
  */
 void rs_client_session_request_stop(rs_client_session_t *s);
 
+/* ── Reference-counted frames (threaded sessions) ──────────────────── */
+
+/**
+ * rs_client_session_acquire_frame — take the next decoded frame
+ *
+ * For threaded sessions without a video callback (pull model, e.g. a
+ * render loop that fetches a frame per vsync).  Call from one thread.
+ *
+ * @param s           Session handle
+ * @param timeout_ms  Maximum wait
+ * @return            Frame with one reference owned by the caller, or
+ *                    NULL on timeout / not threaded / callback set
+ */
+const rs_video_frame_t *rs_client_session_acquire_frame(rs_client_session_t *s, int timeout_ms);
+
+/**
+ * rs_video_frame_retain — keep @frame valid beyond the callback
+ *
+ * Thread-safe.  Frames remain valid after the session is destroyed.
+ *
+ * @return  @frame, or NULL if @frame is not reference counted
+ *          (single-threaded session)
+ */
+const rs_video_frame_t *rs_video_frame_retain(const rs_video_frame_t *frame);
+
+/**
+ * rs_video_frame_release — drop a reference taken by retain/acquire
+ *
+ * Thread-safe; NULL and non-counted frames are ignored.
+ */
+void rs_video_frame_release(const rs_video_frame_t *frame);
+
 /* ── Introspection ────────────────────────────────────────────────── */
 
 /**
@@ -288,6 +366,15 @@ bool rs_client_session_is_running(const rs_client_session_t *s);
  */
 const char *rs_client_session_decoder_name(const rs_client_session_t *s);
 
+/**
+ * rs_client_session_get_stats — snapshot the pipeline of a threaded session
+ *
+ * Thread-safe.  Counters keep their last values after run() returns.
+ *
+ * @return  0 on success, -1 if the session has not run threaded
+ */
+int rs_client_session_get_stats(const rs_client_session_t *s, rs_client_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
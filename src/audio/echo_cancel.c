@@ -1,37 +1,158 @@
 /*
  * echo_cancel.c — NLMS-based acoustic echo cancellation
+ *
+ * Each channel has its own filter and a mirrored delay line: every
+ * reference sample is stored twice, C = taps + 1 apart, so the newest
+ * taps + 1 samples are always contiguous (newest first) without any
+ * modulo.  The window for the previous sample is the current one
+ * shifted by one, which lets a single pass apply the previous sample's
+ * weight update and compute the current echo estimate:
+ *
+ *     w[k] += g * x[k + 1];   y += w[k] * x[k];
+ *
+ * This is exactly sample-by-sample NLMS with one pass over the taps
+ * instead of three.  The update for the last sample of a call is kept
+ * pending and applied by the first sample of the next one.
+ *
+ * Reference power is tracked incrementally (add the new sample, drop
+ * the one leaving the window) and recomputed exactly once per lap of
+ * the delay line so rounding cannot accumulate.
  */
 
 #include "echo_cancel.h"
 
-#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define AEC_X86 1
+#endif
+
+/* y = Σ w[k] * x[k] after w[k] += g * x[k + 1], k < n */
+typedef float (*aec_update_dot_fn)(float *w, const float *x, float g, int n);
+
+typedef struct {
+    float *weights; /* taps */
+    float *hist;    /* 2 * (taps + 1), mirrored */
+    int pos;        /* Newest sample; window is hist[pos .. pos + taps] */
+    float power;    /* Σ x² over the taps newest samples */
+    float pending;  /* Update step for the previous sample's window */
+} aec_channel_t;
+
 struct aec_state_s {
     int sample_rate;
     int channels;
     int filter_taps; /* filter_length_ms * sample_rate / 1000 */
     float mu;        /* NLMS step size */
 
-    /* Adaptive filter weights (length = filter_taps * channels) */
-    float *weights;
-
-    /* Reference signal delay line (circular buffer) */
-    float *delay_line;
-    int delay_pos;
+    aec_channel_t *ch;
+    aec_update_dot_fn update_dot;
 
     /* Current reference buffer set by aec_set_reference() */
     const float *ref_buf;
     size_t ref_len;
 };
 
+/* ── Kernels ───────────────────────────────────────────────────────── */
+
+static float update_dot_scalar(float *w, const float *x, float g, int n) {
+    float acc = 0.0f;
+    for (int k = 0; k < n; k++) {
+        w[k] += g * x[k + 1];
+        acc += w[k] * x[k];
+    }
+    return acc;
+}
+
+static float dot_scalar(const float *a, const float *b, int n) {
+    float acc = 0.0f;
+    for (int k = 0; k < n; k++)
+        acc += a[k] * b[k];
+    return acc;
+}
+
+#ifdef AEC_X86
+
+__attribute__((target("sse2"))) static float hsum_sse(__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+__attribute__((target("sse2"))) static float update_dot_sse(float *w, const float *x, float g,
+                                                             int n) {
+    const __m128 vg = _mm_set1_ps(g);
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int k = 0;
+
+    for (; k + 8 <= n; k += 8) {
+        __m128 w0 = _mm_loadu_ps(w + k);
+        __m128 w1 = _mm_loadu_ps(w + k + 4);
+        w0 = _mm_add_ps(w0, _mm_mul_ps(vg, _mm_loadu_ps(x + k + 1)));
+        w1 = _mm_add_ps(w1, _mm_mul_ps(vg, _mm_loadu_ps(x + k + 5)));
+        _mm_storeu_ps(w + k, w0);
+        _mm_storeu_ps(w + k + 4, w1);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(w0, _mm_loadu_ps(x + k)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(w1, _mm_loadu_ps(x + k + 4)));
+    }
+    return hsum_sse(_mm_add_ps(acc0, acc1)) + update_dot_scalar(w + k, x + k, g, n - k);
+}
+
+__attribute__((target("avx2,fma"))) static float update_dot_avx2(float *w, const float *x,
+                                                                 float g, int n) {
+    const __m256 vg = _mm256_set1_ps(g);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    int k = 0;
+
+    for (; k + 16 <= n; k += 16) {
+        __m256 w0 = _mm256_fmadd_ps(vg, _mm256_loadu_ps(x + k + 1), _mm256_loadu_ps(w + k));
+        __m256 w1 = _mm256_fmadd_ps(vg, _mm256_loadu_ps(x + k + 9), _mm256_loadu_ps(w + k + 8));
+        _mm256_storeu_ps(w + k, w0);
+        _mm256_storeu_ps(w + k + 8, w1);
+        acc0 = _mm256_fmadd_ps(w0, _mm256_loadu_ps(x + k), acc0);
+        acc1 = _mm256_fmadd_ps(w1, _mm256_loadu_ps(x + k + 8), acc1);
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    return hsum_sse(s) + update_dot_scalar(w + k, x + k, g, n - k);
+}
+
+#endif /* AEC_X86 */
+
+static aec_update_dot_fn pick_kernel(void) {
+#ifdef AEC_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return update_dot_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return update_dot_sse;
+#endif
+    return update_dot_scalar;
+}
+
+const char *aec_kernel_name(void) {
+    aec_update_dot_fn fn = pick_kernel();
+#ifdef AEC_X86
+    if (fn == update_dot_avx2)
+        return "avx2";
+    if (fn == update_dot_sse)
+        return "sse2";
+#endif
+    (void)fn;
+    return "scalar";
+}
+
+/* ── State ─────────────────────────────────────────────────────────── */
+
 aec_state_t *aec_create(const aec_config_t *config) {
     if (!config || config->sample_rate <= 0 || config->channels <= 0) {
         return NULL;
     }
 
-    int taps = (config->filter_length_ms * config->sample_rate) / 1000;
+    int taps = config->filter_taps > 0 ? config->filter_taps
+                                       : (config->filter_length_ms * config->sample_rate) / 1000;
     if (taps <= 0)
         taps = 256;
 
@@ -43,16 +164,21 @@ aec_state_t *aec_create(const aec_config_t *config) {
     s->channels = config->channels;
     s->filter_taps = taps;
     s->mu = (config->step_size > 0.0f && config->step_size <= 1.0f) ? config->step_size : 0.5f;
+    s->update_dot = pick_kernel();
 
-    s->weights = calloc((size_t)taps * (size_t)config->channels, sizeof(float));
-    s->delay_line = calloc((size_t)taps * (size_t)config->channels, sizeof(float));
-
-    if (!s->weights || !s->delay_line) {
-        free(s->weights);
-        free(s->delay_line);
+    s->ch = calloc((size_t)config->channels, sizeof(*s->ch));
+    if (!s->ch) {
         free(s);
         return NULL;
     }
+    for (int c = 0; c < s->channels; c++) {
+        s->ch[c].weights = calloc((size_t)taps, sizeof(float));
+        s->ch[c].hist = calloc(2 * ((size_t)taps + 1), sizeof(float));
+        if (!s->ch[c].weights || !s->ch[c].hist) {
+            aec_destroy(s);
+            return NULL;
+        }
+    }
 
     return s;
 }
@@ -60,57 +186,61 @@ aec_state_t *aec_create(const aec_config_t *config) {
 void aec_destroy(aec_state_t *state) {
     if (!state)
         return;
-    free(state->weights);
-    free(state->delay_line);
+    for (int c = 0; c < state->channels && state->ch; c++) {
+        free(state->ch[c].weights);
+        free(state->ch[c].hist);
+    }
+    free(state->ch);
     free(state);
 }
 
-void aec_process(aec_state_t *state, const float *mic_samples, const float *ref_samples,
-                 float *out_samples, size_t frame_count) {
-    if (!state || !mic_samples || !ref_samples || !out_samples)
-        return;
+/* ── Processing ────────────────────────────────────────────────────── */
 
-    int taps = state->filter_taps;
-    float mu = state->mu;
-    int ch = state->channels;
+static void process_channel(aec_state_t *s, aec_channel_t *c, const float *mic, const float *ref,
+                            float *out, size_t frame_count, int stride) {
+    const int taps = s->filter_taps;
+    const int lap = taps + 1;
 
     for (size_t f = 0; f < frame_count; f++) {
-        for (int c = 0; c < ch; c++) {
-            /* Insert reference sample into delay line */
-            state->delay_line[state->delay_pos * ch + c] = ref_samples[f * (size_t)ch + (size_t)c];
+        /* Push the reference sample into both halves of the delay line */
+        if (c->pos == 0) {
+            c->pos = lap - 1;
+        } else {
+            c->pos--;
         }
+        float *x = c->hist + c->pos;
+        float r = ref[f * (size_t)stride];
+        x[0] = r;
+        x[lap] = r;
 
-        /* Compute echo estimate via dot product */
-        float echo_est[8] = {0.0f}; /* max 8 channels */
-        for (int k = 0; k < taps; k++) {
-            int idx = ((state->delay_pos - k + taps) % taps) * ch;
-            for (int c = 0; c < ch && c < 8; c++) {
-                echo_est[c] += state->weights[k * ch + c] * state->delay_line[idx + c];
-            }
+        if (c->pos == 0) {
+            c->power = dot_scalar(x, x, taps);
+        } else {
+            c->power += r * r - x[taps] * x[taps];
+            if (c->power < 0.0f)
+                c->power = 0.0f;
         }
 
-        /* Error = mic - echo estimate */
-        float power = 0.0f;
-        for (int k = 0; k < taps; k++) {
-            int idx = ((state->delay_pos - k + taps) % taps) * ch;
-            for (int c = 0; c < ch && c < 8; c++) {
-                power += state->delay_line[idx + c] * state->delay_line[idx + c];
-            }
-        }
-        float norm = (power > 1e-10f) ? mu / power : 0.0f;
+        /* Previous update and echo estimate in one pass */
+        float echo_est = s->update_dot(c->weights, x, c->pending, taps);
 
-        for (int c = 0; c < ch && c < 8; c++) {
-            float err = mic_samples[f * (size_t)ch + (size_t)c] - echo_est[c];
-            out_samples[f * (size_t)ch + (size_t)c] = err;
+        float d = mic[f * (size_t)stride];
+        float err = d - echo_est;
+        out[f * (size_t)stride] = err;
 
-            /* NLMS weight update */
-            for (int k = 0; k < taps; k++) {
-                int idx = ((state->delay_pos - k + taps) % taps) * ch;
-                state->weights[k * ch + c] += norm * err * state->delay_line[idx + c];
-            }
-        }
+        c->pending = (c->power > 1e-10f) ? s->mu * err / c->power : 0.0f;
+    }
+}
 
-        state->delay_pos = (state->delay_pos + 1) % taps;
+void aec_process(aec_state_t *state, const float *mic_samples, const float *ref_samples,
+                 float *out_samples, size_t frame_count) {
+    if (!state || !mic_samples || !ref_samples || !out_samples)
+        return;
+
+    /* One channel at a time keeps its weights and history in cache */
+    for (int c = 0; c < state->channels; c++) {
+        process_channel(state, &state->ch[c], mic_samples + c, ref_samples + c, out_samples + c,
+                        frame_count, state->channels);
     }
 }
 
@@ -124,18 +254,13 @@ void aec_set_reference(aec_state_t *state, const float *ref_samples, size_t fram
 static void aec_pipeline_process(float *samples, size_t frame_count, int channels,
                                  void *user_data) {
     aec_state_t *s = (aec_state_t *)user_data;
+    (void)channels;
     if (!s || !s->ref_buf)
         return;
 
-    /* Use stack buffer for output to avoid aliasing issues */
-    float *tmp = malloc(frame_count * (size_t)channels * sizeof(float));
-    if (!tmp)
-        return;
-
+    /* Each sample is read before its output is written: safe in place */
     size_t ref_frames = (s->ref_len < frame_count) ? s->ref_len : frame_count;
-    aec_process(s, samples, s->ref_buf, tmp, ref_frames);
-    memcpy(samples, tmp, ref_frames * (size_t)channels * sizeof(float));
-    free(tmp);
+    aec_process(s, samples, s->ref_buf, samples, ref_frames);
 
     s->ref_buf = NULL;
     s->ref_len = 0;
@@ -1,9 +1,11 @@
 /*
  * echo_cancel.h — Acoustic echo cancellation (AEC)
  *
- * Implements a block-based normalized least-mean-squares (NLMS) adaptive
- * filter that estimates and cancels acoustic echo from the far-end
- * reference signal.
+ * Implements a normalized least-mean-squares (NLMS) adaptive filter per
+ * channel that estimates and cancels acoustic echo from the far-end
+ * reference signal.  The filter runs over a modulo-free mirrored delay
+ * line with SSE2/AVX2 kernels (picked at runtime), so 4096 taps of
+ * 48 kHz stereo fit comfortably in a 10 ms frame.
  *
  * Usage
  * ─────
@@ -15,6 +17,8 @@
  * Integrates with audio_pipeline_t via aec_make_node().
  * When used in a pipeline the far-end reference must be set externally
  * via aec_set_reference() before each call to audio_pipeline_process().
+ *
+ * Thread-safety: a state must be used from one thread at a time.
  */
 
 #ifndef ROOTSTREAM_ECHO_CANCEL_H
@@ -34,6 +38,8 @@ typedef struct {
     int channels;         /**< Mono (1) or stereo (2) */
     int filter_length_ms; /**< Adaptive filter length in ms (e.g. 100) */
     float step_size;      /**< NLMS step size 0 < μ ≤ 1 (e.g. 0.5) */
+    int filter_taps;      /**< Filter length in taps; overrides
+                               filter_length_ms when > 0 */
 } aec_config_t;
 
 /** Opaque AEC state */
@@ -90,6 +96,13 @@ void aec_set_reference(aec_state_t *state, const float *ref_samples, size_t fram
  */
 audio_filter_node_t aec_make_node(aec_state_t *state);
 
+/**
+ * aec_kernel_name — name of the filter kernel this CPU uses
+ *
+ * @return  "avx2", "sse2" or "scalar"
+ */
+const char *aec_kernel_name(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,590 @@
+/*
+ * frame_reasm.c — Multi-frame video reassembly implementation
+ */
+
+#include "frame_reasm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../fec/fec_decoder.h"
+
+/* A frame_id this far behind the head means the sender restarted */
+#define FRAME_REASM_RESYNC_FRAMES 1024
+
+/* A stored repair chunk; its payload is at repair_buf + i * stride */
+typedef struct {
+    uint32_t group_first; /* Chunk index of the group's first source */
+    uint8_t group_k;
+    uint8_t repair_idx;
+} reasm_repair_t;
+
+typedef struct {
+    bool in_use;
+    bool held; /* Handed out by the last pop */
+    uint32_t frame_id;
+    uint32_t total_size;
+    uint32_t stride;      /* 0 until the first non-final chunk */
+    uint32_t chunk_count; /* Valid once stride is known */
+    uint32_t received;    /* Distinct chunks marked in bits */
+    bool tail_seen;       /* Final chunk stored before stride was known */
+    uint32_t tail_offset;
+    uint64_t timestamp_us;
+    uint64_t first_ms;
+    uint64_t last_ms;
+    uint8_t *buf;
+    size_t capacity;
+    uint64_t bits[FRAME_REASM_MAX_CHUNKS / 64];
+
+    reasm_repair_t *repairs; /* FEC repairs of this frame */
+    uint32_t repair_count;
+    uint32_t repair_capacity;
+    uint8_t *repair_buf; /* repair_capacity × stride */
+    size_t repair_buf_size;
+} reasm_slot_t;
+
+struct frame_reasm_s {
+    reasm_slot_t *slots;
+    int nslots;
+    uint32_t max_age_ms;
+    uint32_t reorder_ms;
+
+    bool have_horizon;
+    uint32_t horizon; /* Last frame_id delivered or dropped */
+    bool have_delivered;
+    uint32_t last_delivered;
+    bool gap_pending;
+
+    uint8_t *fec_tail; /* Zero-padded short final chunk while decoding */
+    size_t fec_tail_size;
+
+    frame_reasm_stats_t stats;
+};
+
+/* Wrap-aware "a is newer than b" */
+static bool id_after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+frame_reasm_t *frame_reasm_create(int slots, uint32_t max_age_ms, uint32_t reorder_ms) {
+    if (slots <= 0)
+        slots = FRAME_REASM_DEFAULT_SLOTS;
+    if (slots > FRAME_REASM_MAX_SLOTS)
+        slots = FRAME_REASM_MAX_SLOTS;
+
+    frame_reasm_t *r = calloc(1, sizeof(*r));
+    if (!r)
+        return NULL;
+    r->slots = calloc((size_t)slots, sizeof(reasm_slot_t));
+    if (!r->slots) {
+        free(r);
+        return NULL;
+    }
+    r->nslots = slots;
+    r->max_age_ms = max_age_ms ? max_age_ms : FRAME_REASM_DEFAULT_MAX_AGE_MS;
+    r->reorder_ms = reorder_ms ? reorder_ms : FRAME_REASM_DEFAULT_REORDER_MS;
+    return r;
+}
+
+void frame_reasm_destroy(frame_reasm_t *r) {
+    if (!r)
+        return;
+    for (int i = 0; i < r->nslots; i++) {
+        free(r->slots[i].buf);
+        free(r->slots[i].repairs);
+        free(r->slots[i].repair_buf);
+    }
+    free(r->slots);
+    free(r->fec_tail);
+    free(r);
+}
+
+/* Forget frame state; a held frame stays valid if keep_held is set */
+static void forget_frames(frame_reasm_t *r, bool keep_held) {
+    for (int i = 0; i < r->nslots; i++) {
+        if (keep_held && r->slots[i].held)
+            continue;
+        r->slots[i].in_use = false;
+        r->slots[i].held = false;
+    }
+    r->have_horizon = false;
+    r->have_delivered = false;
+    r->gap_pending = false;
+}
+
+void frame_reasm_reset(frame_reasm_t *r) {
+    if (!r)
+        return;
+    forget_frames(r, false);
+    memset(&r->stats, 0, sizeof(r->stats));
+}
+
+void frame_reasm_get_stats(const frame_reasm_t *r, frame_reasm_stats_t *out) {
+    if (!r || !out)
+        return;
+    *out = r->stats;
+    out->active = 0;
+    for (int i = 0; i < r->nslots; i++)
+        if (r->slots[i].in_use && !r->slots[i].held)
+            out->active++;
+}
+
+bool frame_reasm_is_held(const frame_reasm_t *r, const uint8_t *data) {
+    if (!r || !data)
+        return false;
+    for (int i = 0; i < r->nslots; i++)
+        if (r->slots[i].held && r->slots[i].buf == data)
+            return true;
+    return false;
+}
+
+static bool slot_complete(const reasm_slot_t *s) {
+    return s->stride != 0 && s->received == s->chunk_count;
+}
+
+/* Oldest frame still being assembled or waiting to be popped */
+static reasm_slot_t *oldest_slot(frame_reasm_t *r) {
+    reasm_slot_t *oldest = NULL;
+    for (int i = 0; i < r->nslots; i++) {
+        reasm_slot_t *s = &r->slots[i];
+        if (s->in_use && !s->held && (!oldest || id_after(oldest->frame_id, s->frame_id)))
+            oldest = s;
+    }
+    return oldest;
+}
+
+/* Drop an incomplete frame; everything up to it is now behind the horizon */
+static void drop_slot(frame_reasm_t *r, reasm_slot_t *s) {
+    if (!r->have_horizon || id_after(s->frame_id, r->horizon)) {
+        r->horizon = s->frame_id;
+        r->have_horizon = true;
+    }
+    s->in_use = false;
+    r->gap_pending = true;
+    r->stats.frames_dropped++;
+    r->stats.missing += s->stride ? s->chunk_count - s->received : 1;
+}
+
+static reasm_slot_t *find_slot(frame_reasm_t *r, uint32_t frame_id) {
+    for (int i = 0; i < r->nslots; i++) {
+        reasm_slot_t *s = &r->slots[i];
+        if (s->in_use && !s->held && s->frame_id == frame_id)
+            return s;
+    }
+    return NULL;
+}
+
+static reasm_slot_t *open_slot(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size,
+                               uint64_t timestamp_us, uint64_t now_ms) {
+    reasm_slot_t *s = NULL;
+    for (int i = 0; i < r->nslots && !s; i++)
+        if (!r->slots[i].in_use)
+            s = &r->slots[i];
+
+    if (!s) {
+        /* All slots busy: make room by giving up on the oldest frame */
+        reasm_slot_t *oldest = oldest_slot(r);
+        if (!oldest || !id_after(frame_id, oldest->frame_id))
+            return NULL;
+        drop_slot(r, oldest);
+        s = oldest;
+    }
+
+    if (s->capacity < total_size) {
+        uint8_t *buf = realloc(s->buf, total_size);
+        if (!buf)
+            return NULL;
+        s->buf = buf;
+        s->capacity = total_size;
+    }
+
+    s->in_use = true;
+    s->held = false;
+    s->frame_id = frame_id;
+    s->total_size = total_size;
+    s->stride = 0;
+    s->chunk_count = 0;
+    s->received = 0;
+    s->tail_seen = false;
+    s->tail_offset = 0;
+    s->repair_count = 0;
+    s->timestamp_us = timestamp_us;
+    s->first_ms = now_ms;
+    s->last_ms = now_ms;
+    return s;
+}
+
+static bool chunk_present(const reasm_slot_t *s, uint32_t idx) {
+    return (s->bits[idx >> 6] >> (idx & 63u)) & 1u;
+}
+
+static bool test_and_set(reasm_slot_t *s, uint32_t idx) {
+    uint64_t bit = 1ULL << (idx & 63u);
+    if (s->bits[idx >> 6] & bit)
+        return true;
+    s->bits[idx >> 6] |= bit;
+    s->received++;
+    return false;
+}
+
+/* Fix the chunk grid of a frame; returns false if the frame is malformed */
+static bool set_stride(reasm_slot_t *s, uint32_t stride) {
+    uint32_t count = (uint32_t)(((uint64_t)s->total_size + stride - 1) / stride);
+    if (count > FRAME_REASM_MAX_CHUNKS)
+        return false;
+
+    s->stride = stride;
+    s->chunk_count = count;
+    memset(s->bits, 0, ((count + 63u) / 64u) * sizeof(uint64_t));
+
+    if (s->tail_seen) {
+        if (s->tail_offset != (count - 1u) * stride)
+            return false;
+        test_and_set(s, count - 1u);
+    }
+    return true;
+}
+
+/*
+ * Rebuild the missing source chunks of one FEC group if enough of its
+ * source and repair chunks are in; returns the number of chunks rebuilt
+ */
+static uint32_t decode_group(frame_reasm_t *r, reasm_slot_t *s, uint32_t first, uint32_t k) {
+    const uint8_t *pkts[FEC_MAX_K + FEC_MAX_R] = {0};
+    bool received[FEC_MAX_K + FEC_MAX_R] = {0};
+    uint8_t *out[FEC_MAX_K] = {0};
+    uint32_t present = 0;
+    uint32_t repairs = 0;
+    int rmax = 0;
+
+    for (uint32_t j = 0; j < k; j++)
+        present += chunk_present(s, first + j);
+    if (present == k)
+        return 0;
+
+    for (uint32_t i = 0; i < s->repair_count; i++) {
+        const reasm_repair_t *rp = &s->repairs[i];
+        if (rp->group_first != first || rp->group_k != k)
+            continue;
+        pkts[k + rp->repair_idx] = s->repair_buf + (size_t)i * s->stride;
+        received[k + rp->repair_idx] = true;
+        if (rp->repair_idx + 1 > rmax)
+            rmax = rp->repair_idx + 1;
+        repairs++;
+    }
+    if (present + repairs < k)
+        return 0;
+
+    /* The short final chunk takes part zero-padded to the stride */
+    uint32_t tail = s->chunk_count - 1u;
+    size_t tail_len = s->total_size - (size_t)tail * s->stride;
+    bool pad_tail = tail >= first && tail < first + k && tail_len < s->stride;
+    if (pad_tail && r->fec_tail_size < s->stride) {
+        uint8_t *buf = realloc(r->fec_tail, s->stride);
+        if (!buf)
+            return 0;
+        r->fec_tail = buf;
+        r->fec_tail_size = s->stride;
+    }
+
+    for (uint32_t j = 0; j < k; j++) {
+        uint32_t idx = first + j;
+        uint8_t *chunk = s->buf + (size_t)idx * s->stride;
+        bool have = chunk_present(s, idx);
+
+        if (pad_tail && idx == tail) {
+            memset(r->fec_tail, 0, s->stride);
+            if (have)
+                memcpy(r->fec_tail, chunk, tail_len);
+            chunk = r->fec_tail;
+        }
+        received[j] = have;
+        if (have)
+            pkts[j] = chunk;
+        else
+            out[j] = chunk;
+    }
+
+    if (fec_decode(pkts, received, (int)k, rmax, s->stride, out) <= 0)
+        return 0;
+
+    if (pad_tail && !chunk_present(s, tail))
+        memcpy(s->buf + (size_t)tail * s->stride, r->fec_tail, tail_len);
+
+    uint32_t rebuilt = 0;
+    for (uint32_t j = 0; j < k; j++) {
+        if (!test_and_set(s, first + j))
+            rebuilt++;
+    }
+    r->stats.recovered += rebuilt;
+    return rebuilt;
+}
+
+/* Decode the group that chunk idx belongs to, if it has repairs */
+static void decode_chunk_group(frame_reasm_t *r, reasm_slot_t *s, uint32_t idx) {
+    for (uint32_t i = 0; i < s->repair_count; i++) {
+        const reasm_repair_t *rp = &s->repairs[i];
+        if (idx >= rp->group_first && idx < rp->group_first + rp->group_k) {
+            decode_group(r, s, rp->group_first, rp->group_k);
+            return;
+        }
+    }
+}
+
+/* Find or open the slot for frame_id; NULL (with stats updated) if late */
+static reasm_slot_t *slot_for(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size,
+                              uint64_t timestamp_us, uint64_t now_ms) {
+    if (r->have_horizon && !id_after(frame_id, r->horizon)) {
+        if ((int32_t)(r->horizon - frame_id) < FRAME_REASM_RESYNC_FRAMES) {
+            r->stats.late_chunks++;
+            return NULL;
+        }
+        /* Far behind the head: the sender restarted its frame counter */
+        forget_frames(r, true);
+    }
+
+    reasm_slot_t *s = find_slot(r, frame_id);
+    if (!s) {
+        s = open_slot(r, frame_id, total_size, timestamp_us, now_ms);
+        if (!s)
+            r->stats.late_chunks++;
+    }
+    return s;
+}
+
+int frame_reasm_add(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size, uint32_t offset,
+                    const uint8_t *data, size_t len, uint64_t timestamp_us, uint64_t now_ms) {
+    if (!r || !data || len == 0 || total_size == 0 || offset >= total_size ||
+        len > total_size - offset) {
+        if (r)
+            r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    reasm_slot_t *s = slot_for(r, frame_id, total_size, timestamp_us, now_ms);
+    if (!s)
+        return FRAME_REASM_LATE;
+
+    if (slot_complete(s)) {
+        r->stats.duplicates++;
+        return FRAME_REASM_DUPLICATE;
+    }
+    if (total_size != s->total_size) {
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    bool tail = (size_t)offset + len == total_size;
+
+    if (s->stride == 0) {
+        if (!tail || offset == 0) {
+            /* First non-final (or only) chunk defines the grid */
+            if (!set_stride(s, (uint32_t)len)) {
+                drop_slot(r, s);
+                r->stats.invalid_chunks++;
+                return FRAME_REASM_INVALID;
+            }
+        } else {
+            /* Final chunk ahead of the grid: store it, mark it later */
+            if (s->tail_seen) {
+                r->stats.duplicates++;
+                return FRAME_REASM_DUPLICATE;
+            }
+            memcpy(s->buf + offset, data, len);
+            s->tail_seen = true;
+            s->tail_offset = offset;
+            s->last_ms = now_ms;
+            r->stats.chunks++;
+            return FRAME_REASM_ACCEPTED;
+        }
+    }
+
+    if (offset % s->stride != 0 || (!tail && len != s->stride) ||
+        (tail && offset / s->stride != s->chunk_count - 1u)) {
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    uint32_t idx = offset / s->stride;
+    if (test_and_set(s, idx)) {
+        r->stats.duplicates++;
+        return FRAME_REASM_DUPLICATE;
+    }
+
+    memcpy(s->buf + offset, data, len);
+    s->last_ms = now_ms;
+    r->stats.chunks++;
+    if (s->repair_count > 0)
+        decode_chunk_group(r, s, idx);
+    return slot_complete(s) ? FRAME_REASM_COMPLETE : FRAME_REASM_ACCEPTED;
+}
+
+int frame_reasm_add_repair(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size,
+                           uint32_t group_offset, int group_k, int repair_idx,
+                           const uint8_t *data, size_t len, uint64_t timestamp_us,
+                           uint64_t now_ms) {
+    if (!r || !data || len == 0 || len > FEC_MAX_PKT_SIZE || total_size == 0 ||
+        group_offset >= total_size || group_k < 1 || group_k > FEC_MAX_K || repair_idx < 0 ||
+        repair_idx >= FEC_MAX_R) {
+        if (r)
+            r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    reasm_slot_t *s = slot_for(r, frame_id, total_size, timestamp_us, now_ms);
+    if (!s)
+        return FRAME_REASM_LATE;
+
+    if (slot_complete(s)) {
+        r->stats.duplicates++;
+        return FRAME_REASM_DUPLICATE;
+    }
+    if (total_size != s->total_size) {
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    /* A repair is exactly one stride long, so it also fixes the grid */
+    if (s->stride == 0 && (len > total_size || !set_stride(s, (uint32_t)len))) {
+        drop_slot(r, s);
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    uint32_t first = group_offset / s->stride;
+    if (len != s->stride || group_offset % s->stride != 0 ||
+        first + (uint32_t)group_k > s->chunk_count) {
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+
+    for (uint32_t i = 0; i < s->repair_count; i++) {
+        if (s->repairs[i].group_first == first && s->repairs[i].repair_idx == repair_idx) {
+            r->stats.duplicates++;
+            return FRAME_REASM_DUPLICATE;
+        }
+    }
+
+    if (s->repair_count >= FRAME_REASM_MAX_REPAIRS) {
+        r->stats.invalid_chunks++;
+        return FRAME_REASM_INVALID;
+    }
+    if (s->repair_count == s->repair_capacity) {
+        uint32_t cap = s->repair_capacity ? s->repair_capacity * 2u : 16u;
+        if (cap > FRAME_REASM_MAX_REPAIRS)
+            cap = FRAME_REASM_MAX_REPAIRS;
+        reasm_repair_t *repairs = realloc(s->repairs, cap * sizeof(reasm_repair_t));
+        if (!repairs)
+            return FRAME_REASM_INVALID;
+        s->repairs = repairs;
+        s->repair_capacity = cap;
+    }
+    /* Buffers are reused across frames, whose stride may differ */
+    size_t need = (size_t)s->repair_capacity * s->stride;
+    if (s->repair_buf_size < need) {
+        uint8_t *buf = realloc(s->repair_buf, need);
+        if (!buf)
+            return FRAME_REASM_INVALID;
+        s->repair_buf = buf;
+        s->repair_buf_size = need;
+    }
+
+    reasm_repair_t *rp = &s->repairs[s->repair_count];
+    rp->group_first = first;
+    rp->group_k = (uint8_t)group_k;
+    rp->repair_idx = (uint8_t)repair_idx;
+    memcpy(s->repair_buf + (size_t)s->repair_count * s->stride, data, len);
+    s->repair_count++;
+    s->last_ms = now_ms;
+    r->stats.repairs++;
+
+    decode_group(r, s, first, (uint32_t)group_k);
+    return slot_complete(s) ? FRAME_REASM_COMPLETE : FRAME_REASM_ACCEPTED;
+}
+
+int frame_reasm_missing(const frame_reasm_t *r, uint32_t frame_id, uint32_t *idx, int max) {
+    if (!r || !idx)
+        return -1;
+
+    const reasm_slot_t *s = NULL, *newer = NULL;
+    for (int i = 0; i < r->nslots; i++) {
+        const reasm_slot_t *o = &r->slots[i];
+        if (!o->in_use || o->held)
+            continue;
+        if (o->frame_id == frame_id)
+            s = o;
+        else if (id_after(o->frame_id, frame_id))
+            newer = o;
+    }
+    if (!s || s->stride == 0)
+        return -1;
+
+    uint32_t end = s->chunk_count;
+    if (s->repair_count == 0 && !newer) {
+        while (end > 0 && !chunk_present(s, end - 1u))
+            end--;
+    }
+
+    int n = 0;
+    for (uint32_t i = 0; i < end && n < max; i++)
+        if (!chunk_present(s, i))
+            idx[n++] = i;
+    return n;
+}
+
+void frame_reasm_set_reorder(frame_reasm_t *r, uint32_t reorder_ms) {
+    if (r)
+        r->reorder_ms = reorder_ms ? reorder_ms : FRAME_REASM_DEFAULT_REORDER_MS;
+}
+
+int frame_reasm_pop(frame_reasm_t *r, uint64_t now_ms, frame_reasm_frame_t *out) {
+    if (!r || !out)
+        return 0;
+
+    /* Recycle the frame handed out last time */
+    for (int i = 0; i < r->nslots; i++) {
+        if (r->slots[i].held) {
+            r->slots[i].held = false;
+            r->slots[i].in_use = false;
+        }
+    }
+
+    for (;;) {
+        reasm_slot_t *s = oldest_slot(r);
+        if (!s)
+            return 0;
+
+        if (slot_complete(s)) {
+            out->frame_id = s->frame_id;
+            out->data = s->buf;
+            out->size = s->total_size;
+            out->timestamp_us = s->timestamp_us;
+            out->after_gap =
+                r->gap_pending || (r->have_delivered && s->frame_id != r->last_delivered + 1u);
+            if (out->after_gap)
+                r->stats.gaps++;
+
+            s->held = true;
+            r->gap_pending = false;
+            r->have_delivered = true;
+            r->last_delivered = s->frame_id;
+            r->horizon = s->frame_id;
+            r->have_horizon = true;
+            r->stats.frames_complete++;
+            return 1;
+        }
+
+        bool newer_ready = false;
+        for (int i = 0; i < r->nslots && !newer_ready; i++) {
+            reasm_slot_t *o = &r->slots[i];
+            newer_ready = o != s && o->in_use && !o->held && slot_complete(o);
+        }
+
+        bool expired = now_ms - s->first_ms >= r->max_age_ms;
+        bool stalled = newer_ready && now_ms - s->last_ms >= r->reorder_ms;
+        if (!expired && !stalled)
+            return 0;
+
+        drop_slot(r, s);
+    }
+}
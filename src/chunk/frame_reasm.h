@@ -0,0 +1,198 @@
+/*
+ * frame_reasm.h — Multi-frame, loss-tolerant video frame reassembly
+ *
+ * Reassembles encoded frames from byte-range chunks (frame_id, total
+ * size, offset, payload) as carried by the core PKT_VIDEO path.  Up to
+ * FRAME_REASM_MAX_SLOTS frames are assembled concurrently, so a chunk of
+ * frame N+1 arriving early no longer discards frame N.
+ *
+ * Each slot owns a payload buffer (grown on demand and reused) and a
+ * per-chunk arrival bitmap, so duplicated chunks are ignored instead of
+ * being counted twice.  The chunk stride is learned from the first
+ * non-final chunk of a frame; all non-final chunks must share it.
+ *
+ * Completed frames are handed out in frame_id order by frame_reasm_pop()
+ * without copying.  An incomplete frame blocks newer completed frames
+ * only while its chunks are still arriving: it is dropped once it has
+ * been idle for reorder_ms with a newer frame ready, or once it is older
+ * than max_age_ms.  The first frame handed out after a drop or a
+ * missing frame_id is flagged after_gap.
+ *
+ * FEC repair chunks (fec/fec_encoder.h) protect groups of consecutive
+ * source chunks.  They are kept next to the frame and a group is decoded
+ * as soon as enough of its source and repair chunks are in, so lost
+ * chunks are rebuilt without waiting for a retransmit or keyframe.
+ *
+ * Thread-safety: NOT thread-safe.
+ */
+
+#ifndef ROOTSTREAM_FRAME_REASM_H
+#define ROOTSTREAM_FRAME_REASM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FRAME_REASM_MAX_SLOTS 32        /**< Upper bound on concurrent frames */
+#define FRAME_REASM_DEFAULT_SLOTS 16    /**< Concurrent frames if slots ≤ 0 */
+#define FRAME_REASM_MAX_CHUNKS 16384    /**< Max chunks per frame (bitmap size) */
+#define FRAME_REASM_DEFAULT_MAX_AGE_MS 100
+#define FRAME_REASM_DEFAULT_REORDER_MS 5
+#define FRAME_REASM_MAX_REPAIRS 512     /**< Max repair chunks kept per frame */
+
+/** frame_reasm_add() results */
+#define FRAME_REASM_INVALID (-1)  /**< Malformed chunk (dropped) */
+#define FRAME_REASM_ACCEPTED 0    /**< Chunk stored, frame still incomplete */
+#define FRAME_REASM_COMPLETE 1    /**< Chunk stored and frame now complete */
+#define FRAME_REASM_DUPLICATE 2   /**< Chunk already received (ignored) */
+#define FRAME_REASM_LATE 3        /**< Frame already delivered or dropped */
+
+/** A completed frame handed out by frame_reasm_pop() */
+typedef struct {
+    uint32_t frame_id;
+    const uint8_t *data; /**< Owned by the reassembler */
+    size_t size;
+    uint64_t timestamp_us;
+    bool after_gap; /**< Frames were lost since the previous pop */
+} frame_reasm_frame_t;
+
+/** Reassembly statistics (monotonic since create/reset) */
+typedef struct {
+    uint64_t chunks;          /**< Source chunks stored */
+    uint64_t repairs;         /**< FEC repair chunks stored */
+    uint64_t recovered;       /**< Source chunks rebuilt by FEC */
+    uint64_t missing;         /**< Source chunks of dropped frames never seen */
+    uint64_t duplicates;      /**< Duplicate chunks ignored */
+    uint64_t late_chunks;     /**< Chunks for delivered/dropped frames */
+    uint64_t invalid_chunks;  /**< Malformed chunks */
+    uint64_t frames_complete; /**< Frames handed out */
+    uint64_t frames_dropped;  /**< Incomplete frames aged out or evicted */
+    uint64_t gaps;            /**< Pops flagged after_gap */
+    uint32_t active;          /**< Frames currently in progress */
+} frame_reasm_stats_t;
+
+/** Opaque reassembler */
+typedef struct frame_reasm_s frame_reasm_t;
+
+/**
+ * frame_reasm_create — allocate reassembler
+ *
+ * @param slots       Concurrent frames (≤ 0 → default, clamped to max)
+ * @param max_age_ms  Drop incomplete frames older than this (0 → default)
+ * @param reorder_ms  Idle time before an incomplete frame yields to a
+ *                    newer complete one (0 → default)
+ * @return            Non-NULL handle, or NULL on OOM
+ */
+frame_reasm_t *frame_reasm_create(int slots, uint32_t max_age_ms, uint32_t reorder_ms);
+
+/**
+ * frame_reasm_destroy — free reassembler and all frame buffers
+ */
+void frame_reasm_destroy(frame_reasm_t *r);
+
+/**
+ * frame_reasm_reset — forget all frames (buffers are kept for reuse)
+ */
+void frame_reasm_reset(frame_reasm_t *r);
+
+/**
+ * frame_reasm_add — store one chunk
+ *
+ * @param r             Reassembler
+ * @param frame_id      Frame sequence number (wraps)
+ * @param total_size    Total frame size in bytes (> 0)
+ * @param offset        Byte offset of this chunk
+ * @param data          Chunk payload
+ * @param len           Chunk length (> 0, offset + len ≤ total_size)
+ * @param timestamp_us  Capture timestamp of the frame
+ * @param now_ms        Current time in ms (monotonic)
+ * @return              FRAME_REASM_* result
+ */
+int frame_reasm_add(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size, uint32_t offset,
+                    const uint8_t *data, size_t len, uint64_t timestamp_us, uint64_t now_ms);
+
+/**
+ * frame_reasm_add_repair — store one FEC repair chunk
+ *
+ * The repair protects group_k source chunks starting at byte offset
+ * group_offset; its length is the frame's chunk stride (the whole frame
+ * for single-chunk frames), with a short final chunk zero-padded.
+ *
+ * @param r             Reassembler
+ * @param frame_id      Frame sequence number (wraps)
+ * @param total_size    Total frame size in bytes (> 0)
+ * @param group_offset  Byte offset of the group's first source chunk
+ * @param group_k       Source chunks in the group (1..FEC_MAX_K)
+ * @param repair_idx    Repair index within the group (0..FEC_MAX_R-1)
+ * @param data          Repair payload
+ * @param len           Repair length (chunk stride)
+ * @param timestamp_us  Capture timestamp of the frame
+ * @param now_ms        Current time in ms (monotonic)
+ * @return              FRAME_REASM_* result (COMPLETE if the repair
+ *                      completed the frame)
+ */
+int frame_reasm_add_repair(frame_reasm_t *r, uint32_t frame_id, uint32_t total_size,
+                           uint32_t group_offset, int group_k, int repair_idx,
+                           const uint8_t *data, size_t len, uint64_t timestamp_us,
+                           uint64_t now_ms);
+
+/**
+ * frame_reasm_pop — hand out the next completed frame in frame_id order
+ *
+ * Also ages out incomplete frames.  The previously popped frame is
+ * recycled, so out->data stays valid only until the next pop or reset.
+ *
+ * @param r       Reassembler
+ * @param now_ms  Current time in ms (monotonic)
+ * @param out     Receives the frame
+ * @return        1 if a frame was handed out, 0 otherwise
+ */
+int frame_reasm_pop(frame_reasm_t *r, uint64_t now_ms, frame_reasm_frame_t *out);
+
+/**
+ * frame_reasm_missing — list source chunks of a frame still to come
+ *
+ * Chunks are sent in offset order, so only chunks below the highest one
+ * received count as missing, or all of them once the frame is closed: a
+ * repair chunk or a newer frame has arrived.  FEC-rebuilt chunks count
+ * as present.
+ *
+ * @param r         Reassembler
+ * @param frame_id  Frame in progress
+ * @param idx       Receives missing chunk indices (offset / stride), ascending
+ * @param max       Capacity of @idx
+ * @return          Number written (0 if nothing is missing), or -1 if the
+ *                  frame is not in progress or its chunk grid is unknown
+ */
+int frame_reasm_missing(const frame_reasm_t *r, uint32_t frame_id, uint32_t *idx, int max);
+
+/**
+ * frame_reasm_set_reorder — change how long an incomplete frame may stall
+ *
+ * Lets a receiver that requests retransmissions wait about a round trip
+ * before giving up on a frame.
+ *
+ * @param r           Reassembler
+ * @param reorder_ms  New idle time (0 → default)
+ */
+void frame_reasm_set_reorder(frame_reasm_t *r, uint32_t reorder_ms);
+
+/**
+ * frame_reasm_is_held — true if data is the frame handed out by the last pop
+ */
+bool frame_reasm_is_held(const frame_reasm_t *r, const uint8_t *data);
+
+/**
+ * frame_reasm_get_stats — snapshot statistics
+ */
+void frame_reasm_get_stats(const frame_reasm_t *r, frame_reasm_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_FRAME_REASM_H */
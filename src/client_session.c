@@ -35,12 +35,22 @@
  *    rs_audio_frame_t.samples points into a local buffer valid for the
  *    callback duration only.
  *
- * 5. Thread-safety boundaries
+ * 5. Threaded mode is the same loop cut into stages
+ *    With cfg.threaded, the receive half of the loop moves to a network
+ *    thread and decode to a decode thread (pipeline/client_pipeline.c);
+ *    run() keeps only presentation.  Frames are then reference counted,
+ *    which lifts the callback-lifetime rule of (3) for callers that take
+ *    a reference.  If the pipeline cannot start, run() falls back to the
+ *    single-threaded loop.
+ *
+ * 6. Thread-safety boundaries
  *    - rs_client_session_create/destroy: call from one thread only (owner)
  *    - rs_client_session_set_*_callback: call before run() or hold external lock
  *    - rs_client_session_run: runs on a dedicated thread
  *    - rs_client_session_request_stop: thread-safe (atomic store)
  *    - rs_client_session_is_running: thread-safe (atomic load)
+ *    - rs_client_session_get_stats, rs_video_frame_retain/release:
+ *      thread-safe
  */
 
 #include <stdatomic.h>
@@ -50,6 +60,11 @@
 
 #include "../include/rootstream.h"
 #include "../include/rootstream_client_session.h"
+#include "pipeline/client_pipeline.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 /* ── Internal session struct ──────────────────────────────────────── */
 
@@ -77,6 +92,14 @@ struct rs_client_session_s {
 
     /* Decoder backend name string (set once decode is initialised) */
     const char *decoder_name;
+
+#ifndef _WIN32
+    /* Threaded mode: the pipeline of the latest run.  It outlives run()
+     * so stats stay readable and held frames stay valid; replaced (under
+     * the lock) by the next threaded run, freed by destroy. */
+    pthread_mutex_t pipeline_lock;
+    client_pipeline_t *pipeline;
+#endif
 };
 
 /* ── Internal helpers ─────────────────────────────────────────────── */
@@ -87,6 +110,137 @@ static void notify_state(rs_client_session_t *s, const char *msg) {
         s->on_state(s->on_state_user, msg);
 }
 
+/* Decode and deliver the audio packet waiting in ctx->current_audio */
+static void deliver_audio(rs_client_session_t *s) {
+    rootstream_ctx_t *ctx = s->ctx;
+    if (!ctx->settings.audio_enabled || !s->on_audio || !ctx->current_audio.data ||
+        ctx->current_audio.size == 0)
+        return;
+
+    /* Decode Opus-compressed audio to PCM */
+    int16_t pcm_buf[48000 / 10 * 2]; /* 100ms stereo at 48 kHz */
+    size_t pcm_len = sizeof(pcm_buf) / sizeof(pcm_buf[0]);
+    int pcm_samples = rootstream_opus_decode(ctx, ctx->current_audio.data,
+                                             ctx->current_audio.size, pcm_buf, &pcm_len);
+    if (pcm_samples > 0) {
+        rs_audio_frame_t af;
+        af.samples = pcm_buf;
+        af.num_samples = (size_t)pcm_samples;
+        af.channels = ctx->settings.audio_channels > 0 ? ctx->settings.audio_channels : 2;
+        af.sample_rate = 48000;
+        af.pts_us = 0;
+        s->on_audio(s->on_audio_user, &af);
+        /* af.samples is now INVALID — pcm_buf is on the stack */
+    }
+
+    ctx->current_audio.size = 0;
+}
+
+/*
+ * Single-threaded loop: receive, decode and present inline.
+ *
+ * Loop invariants:
+ *   - stop_requested atomic is checked first each iteration.
+ *   - ctx->running is also checked (allows core-level shutdown signals).
+ *   - rootstream_net_recv() blocks for up to 16ms (one display frame at
+ *     60fps) waiting for incoming packets.  This sets the maximum latency
+ *     before a stop request is honoured.
+ */
+static void run_inline(rs_client_session_t *s) {
+    rootstream_ctx_t *ctx = s->ctx;
+    frame_buffer_t decoded_frame = {0};
+
+    while (!atomic_load(&s->stop_requested) && ctx->running) {
+        /* Receive incoming packets (16ms = one frame at 60fps).
+         * rootstream_net_recv() handles partial packets, reassembly, and
+         * populates ctx->current_frame when a complete video frame arrives. */
+        rootstream_net_recv(ctx, 16);
+        rootstream_net_tick(ctx);
+
+        /* ── Video frame handling ─────────────────────────────────────── */
+        if (ctx->current_frame.data && ctx->current_frame.size > 0) {
+            /* Decode the compressed frame to the pixel format the decoder
+             * was initialised with (NV12 for VA-API, RGBA for software). */
+            if (rootstream_decode_frame(ctx, ctx->current_frame.data, ctx->current_frame.size,
+                                        &decoded_frame) == 0) {
+                /* Invoke the video callback if registered.
+                 * The callback is responsible for copying any data it needs
+                 * to retain — the decoded_frame buffer is reused on the
+                 * next iteration. */
+                if (s->on_video && decoded_frame.data) {
+                    rs_video_frame_t vf;
+                    client_pipeline_map_frame(&decoded_frame, &vf);
+                    s->on_video(s->on_video_user, &vf);
+                    /* vf pointers are now INVALID — decoded_frame.data will
+                     * be overwritten on the next decode call. */
+                }
+
+            } else {
+                fprintf(stderr, "rs_client_session: frame decode failed\n");
+            }
+
+            /* Reset frame pointer so we don't re-decode the same frame */
+            ctx->current_frame.size = 0;
+        }
+
+        /* ── Audio handling ───────────────────────────────────────────── */
+        deliver_audio(s);
+    }
+
+    /* Free the decode output buffer */
+    if (decoded_frame.data) {
+        free(decoded_frame.data);
+    }
+}
+
+#ifndef _WIN32
+/* Network-thread hook: audio stays on the thread that received it */
+static void pipeline_tick(rootstream_ctx_t *ctx, void *user) {
+    (void)ctx;
+    deliver_audio((rs_client_session_t *)user);
+}
+
+/*
+ * Threaded loop: the pipeline receives and decodes, this thread presents.
+ *
+ * Without a video callback frames are left in the presentation queue for
+ * rs_client_session_acquire_frame(); this thread then only waits for the
+ * stop request.
+ *
+ * @return 0 when the session ended, -1 if the pipeline could not start
+ */
+static int run_pipelined(rs_client_session_t *s) {
+    rootstream_ctx_t *ctx = s->ctx;
+
+    client_pipeline_t *p = client_pipeline_start(ctx, s->cfg.queue_depth, pipeline_tick, s);
+    if (!p)
+        return -1;
+
+    pthread_mutex_lock(&s->pipeline_lock);
+    client_pipeline_t *old = s->pipeline;
+    s->pipeline = p;
+    pthread_mutex_unlock(&s->pipeline_lock);
+    client_pipeline_destroy(old);
+
+    while (!atomic_load(&s->stop_requested) && ctx->running) {
+        if (!s->on_video) {
+            rs_sleep_ms(CLIENT_PIPELINE_RECV_TIMEOUT_MS);
+            continue;
+        }
+
+        client_frame_t *f = client_pipeline_next(p, CLIENT_PIPELINE_RECV_TIMEOUT_MS * 1000);
+        if (!f)
+            continue;
+        /* The callback may retain the frame; ours is dropped here */
+        s->on_video(s->on_video_user, client_frame_view(f));
+        client_frame_release(f);
+    }
+
+    client_pipeline_stop(p);
+    return 0;
+}
+#endif
+
 /* ── Lifecycle ────────────────────────────────────────────────────── */
 
 rs_client_session_t *rs_client_session_create(const rs_client_config_t *cfg) {
@@ -101,6 +255,9 @@ rs_client_session_t *rs_client_session_create(const rs_client_config_t *cfg) {
     atomic_store(&s->stop_requested, 0);
     atomic_store(&s->is_running, 0);
     s->decoder_name = "unknown";
+#ifndef _WIN32
+    pthread_mutex_init(&s->pipeline_lock, NULL);
+#endif
 
     /* Allocate and zero-initialise the core streaming context.
      * rootstream_ctx_t is the same struct used by the CLI path in service.c;
@@ -131,6 +288,12 @@ void rs_client_session_destroy(rs_client_session_t *s) {
      * run thread before destroying to avoid a tight spin. */
     rs_client_session_request_stop(s);
 
+#ifndef _WIN32
+    /* Frames the application still holds keep their buffers */
+    client_pipeline_destroy(s->pipeline);
+    pthread_mutex_destroy(&s->pipeline_lock);
+#endif
+
     /* Free the core context (decoders/network were cleaned up by run()) */
     free(s->ctx);
     free(s);
@@ -220,117 +383,22 @@ int rs_client_session_run(rs_client_session_t *s) {
         }
     }
 
-    /* ── Step 3: Main receive/decode loop ───────────────────────────────
-     * This is the core of what service_run_client() previously contained.
-     *
-     * Loop invariants:
-     *   - stop_requested atomic is checked first each iteration.
-     *   - ctx->running is also checked (allows core-level shutdown signals).
-     *   - rootstream_net_recv() blocks for up to 16ms (one display frame at
-     *     60fps) waiting for incoming packets.  This sets the maximum latency
-     *     before a stop request is honoured.
-     */
-    frame_buffer_t decoded_frame = {0};
-
+    /* ── Step 3: Receive/decode loop ────────────────────────────────────
+     * Either cut into network / decode / present threads, or the
+     * original single-threaded loop lifted from service_run_client(). */
     notify_state(s, "connected");
 
-    while (!atomic_load(&s->stop_requested) && ctx->running) {
-        /* Receive incoming packets (16ms = one frame at 60fps).
-         * rootstream_net_recv() handles partial packets, reassembly, and
-         * populates ctx->current_frame when a complete video frame arrives. */
-        rootstream_net_recv(ctx, 16);
-        rootstream_net_tick(ctx);
-
-        /* ── Video frame handling ─────────────────────────────────────── */
-        if (ctx->current_frame.data && ctx->current_frame.size > 0) {
-            /* Decode the compressed frame to the pixel format the decoder
-             * was initialised with (NV12 for VA-API, RGBA for software). */
-            if (rootstream_decode_frame(ctx, ctx->current_frame.data, ctx->current_frame.size,
-                                        &decoded_frame) == 0) {
-                /* Invoke the video callback if registered.
-                 * The callback is responsible for copying any data it needs
-                 * to retain — the decoded_frame buffer is reused on the
-                 * next iteration. */
-                if (s->on_video && decoded_frame.data) {
-                    rs_video_frame_t vf;
-                    vf.width = decoded_frame.width;
-                    vf.height = decoded_frame.height;
-                    /* Use the capture timestamp from the decoded frame as the
-                     * presentation timestamp.  The decoder preserves the
-                     * timestamp field from the incoming frame_buffer_t. */
-                    vf.pts_us = decoded_frame.timestamp;
-                    vf.is_keyframe = decoded_frame.is_keyframe;
-
-                    /* Map the decoder's output format to rs_pixfmt_t.
-                     * VA-API typically outputs NV12; software decoder may
-                     * output RGBA.  The pixfmt field tells the renderer how
-                     * to interpret the plane pointers. */
-                    if (decoded_frame.format == FRAME_FORMAT_NV12) {
-                        /* NV12: Y plane followed by interleaved UV plane.
-                         * plane0 = Y luma, stride0 = width
-                         * plane1 = UV chroma, stride1 = width (UV rows = height/2) */
-                        vf.pixfmt = RS_PIXFMT_NV12;
-                        vf.plane0 = decoded_frame.data;
-                        vf.stride0 = decoded_frame.width;
-                        vf.plane1 = decoded_frame.data + decoded_frame.width * decoded_frame.height;
-                        vf.stride1 = decoded_frame.width;
-                        vf.plane2 = NULL;
-                        vf.stride2 = 0;
-                    } else {
-                        /* Fallback: treat as packed RGBA */
-                        vf.pixfmt = RS_PIXFMT_RGBA;
-                        vf.plane0 = decoded_frame.data;
-                        vf.stride0 = decoded_frame.width * 4;
-                        vf.plane1 = NULL;
-                        vf.stride1 = 0;
-                        vf.plane2 = NULL;
-                        vf.stride2 = 0;
-                    }
-
-                    s->on_video(s->on_video_user, &vf);
-                    /* vf pointers are now INVALID — decoded_frame.data will
-                     * be overwritten on the next decode call. */
-                }
-
-            } else {
-                fprintf(stderr, "rs_client_session: frame decode failed\n");
-            }
-
-            /* Reset frame pointer so we don't re-decode the same frame */
-            ctx->current_frame.size = 0;
-        }
-
-        /* ── Audio handling ───────────────────────────────────────────── */
-        if (ctx->settings.audio_enabled && s->on_audio && ctx->current_audio.data &&
-            ctx->current_audio.size > 0) {
-            /* Decode Opus-compressed audio to PCM */
-            int16_t pcm_buf[48000 / 10 * 2]; /* 100ms stereo at 48 kHz */
-            size_t pcm_len = sizeof(pcm_buf) / sizeof(pcm_buf[0]);
-            int pcm_samples = rootstream_opus_decode(ctx, ctx->current_audio.data,
-                                                     ctx->current_audio.size, pcm_buf, &pcm_len);
-            if (pcm_samples > 0) {
-                rs_audio_frame_t af;
-                af.samples = pcm_buf;
-                af.num_samples = (size_t)pcm_samples;
-                af.channels = ctx->settings.audio_channels > 0 ? ctx->settings.audio_channels : 2;
-                af.sample_rate = 48000;
-                af.pts_us = 0;
-                s->on_audio(s->on_audio_user, &af);
-                /* af.samples is now INVALID — pcm_buf is on the stack */
-            }
-
-            ctx->current_audio.size = 0;
-        }
-    }
+#ifndef _WIN32
+    if (!s->cfg.threaded || run_pipelined(s) < 0)
+        run_inline(s);
+#else
+    run_inline(s);
+#endif
 
     /* ── Cleanup ────────────────────────────────────────────────────────
-     * Free the decode output buffer and clean up the decoder.
-     * Network/crypto cleanup is NOT done here — the caller (service.c or
-     * KDE RootStreamClient) owns the network connection lifecycle. */
-    if (decoded_frame.data) {
-        free(decoded_frame.data);
-    }
-
+     * Clean up the decoder (and audio).  Network/crypto cleanup is NOT
+     * done here — the caller (service.c or KDE RootStreamClient) owns the
+     * network connection lifecycle. */
     if (ctx->settings.audio_enabled) {
         rootstream_opus_cleanup(ctx);
     }
@@ -350,6 +418,46 @@ void rs_client_session_request_stop(rs_client_session_t *s) {
         s->ctx->running = 0; /* also stop net_recv / net_tick */
 }
 
+/* ── Reference-counted frames ─────────────────────────────────────── */
+
+const rs_video_frame_t *rs_client_session_acquire_frame(rs_client_session_t *s, int timeout_ms) {
+#ifndef _WIN32
+    if (!s || s->on_video || timeout_ms < 0)
+        return NULL;
+
+    pthread_mutex_lock(&s->pipeline_lock);
+    client_pipeline_t *p = s->pipeline;
+    pthread_mutex_unlock(&s->pipeline_lock);
+
+    client_frame_t *f = client_pipeline_next(p, (uint64_t)timeout_ms * 1000);
+    return f ? client_frame_view(f) : NULL;
+#else
+    (void)s;
+    (void)timeout_ms;
+    return NULL;
+#endif
+}
+
+const rs_video_frame_t *rs_video_frame_retain(const rs_video_frame_t *frame) {
+#ifndef _WIN32
+    if (frame && frame->ref) {
+        client_frame_retain((client_frame_t *)frame->ref);
+        return frame;
+    }
+#endif
+    (void)frame;
+    return NULL;
+}
+
+void rs_video_frame_release(const rs_video_frame_t *frame) {
+#ifndef _WIN32
+    if (frame && frame->ref)
+        client_frame_release((client_frame_t *)frame->ref);
+#else
+    (void)frame;
+#endif
+}
+
 /* ── Introspection ────────────────────────────────────────────────── */
 
 bool rs_client_session_is_running(const rs_client_session_t *s) {
@@ -359,3 +467,38 @@ bool rs_client_session_is_running(const rs_client_session_t *s) {
 const char *rs_client_session_decoder_name(const rs_client_session_t *s) {
     return (s && s->decoder_name) ? s->decoder_name : "unknown";
 }
+
+int rs_client_session_get_stats(const rs_client_session_t *s, rs_client_stats_t *out) {
+#ifndef _WIN32
+    if (!s || !out)
+        return -1;
+
+    rs_client_session_t *ms = (rs_client_session_t *)s;
+    client_pipeline_stats_t st;
+    pthread_mutex_lock(&ms->pipeline_lock);
+    int rc = client_pipeline_get_stats(ms->pipeline, &st);
+    pthread_mutex_unlock(&ms->pipeline_lock);
+    if (rc < 0)
+        return -1;
+
+    out->decode_queue_depth = st.decode_queue_depth;
+    out->decode_queue_capacity = st.decode_queue_capacity;
+    out->present_queue_depth = st.present_queue_depth;
+    out->present_queue_capacity = st.present_queue_capacity;
+    out->frames_held = st.held;
+    out->frames_received = st.received;
+    out->frames_decoded = st.decoded;
+    out->frames_presented = st.presented;
+    out->receive_dropped = st.receive_dropped;
+    out->present_dropped = st.present_dropped;
+    out->decode_errors = st.decode_errors;
+    out->queue_wait_us = st.queue_wait_us;
+    out->decode_us = st.decode_us;
+    out->present_wait_us = st.present_wait_us;
+    return 0;
+#else
+    (void)s;
+    (void)out;
+    return -1;
+#endif
+}
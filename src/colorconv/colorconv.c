@@ -0,0 +1,644 @@
+/*
+ * colorconv.c — RGBA/BGRA → NV12/I420/P010 kernels and band threading
+ *
+ * Fixed point: every output sample is
+ *
+ *   (add + c0·s0 + c1·s1 + c2·s2) >> shift
+ *
+ * with 16-bit coefficients in source byte order (alpha weighted 0).
+ * Chroma sums the four pixels of its 2×2 block first and shifts two more
+ * bits.  The SIMD kernels evaluate the same expression with PMADDWD, so
+ * their output is bit-identical to the scalar kernel, which also handles
+ * the columns left over at the end of each row.
+ */
+
+#include "colorconv.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define COLORCONV_X86 1
+#endif
+
+#define SHIFT_8BIT  14 /* Coefficients in Q14 for 8-bit output */
+#define SHIFT_10BIT 12 /* Q12 keeps 10-bit full-range coefficients in int16 */
+
+typedef struct {
+    colorconv_format_t dst;
+    int shift;    /* Luma shift; chroma uses shift + 2 */
+    int max;      /* Largest code value: 255 or 1023 */
+    int16_t y[4]; /* Per source byte; [3] (alpha) is 0 */
+    int16_t u[4];
+    int16_t v[4];
+    int32_t y_add; /* Offset + rounding, pre-shifted */
+    int32_t c_add;
+} cc_coef_t;
+
+typedef struct {
+    const cc_coef_t *k;
+    const colorconv_image_t *src;
+    const colorconv_image_t *dst;
+    colorconv_kernel_t kernel;
+    int pairs; /* Row pairs in the frame */
+    int bands;
+} cc_job_t;
+
+struct colorconv_s {
+    colorconv_matrix_t matrix;
+    colorconv_range_t range;
+    colorconv_kernel_t kernel;
+
+    int nworkers; /* Threads besides the caller */
+    pthread_t workers[COLORCONV_MAX_THREADS - 1];
+    pthread_mutex_t lock;
+    pthread_cond_t start_cv;
+    pthread_cond_t done_cv;
+    uint64_t generation; /* Bumped for every threaded job */
+    int busy;            /* Workers not yet done with the current job */
+    int next_band;
+    bool stop;
+    cc_job_t job;
+};
+
+/* ── Coefficients ───────────────────────────────────────────────── */
+
+static int16_t q(double v, int shift) {
+    double s = v * (double)(1 << shift);
+    return (int16_t)(s < 0 ? s - 0.5 : s + 0.5);
+}
+
+static void build_coef(cc_coef_t *k, colorconv_matrix_t matrix, colorconv_range_t range,
+                       colorconv_format_t src, colorconv_format_t dst) {
+    double kr = matrix == COLORCONV_BT709 ? 0.2126 : 0.299;
+    double kb = matrix == COLORCONV_BT709 ? 0.0722 : 0.114;
+    int bits = dst == COLORCONV_P010 ? 10 : 8;
+    int s = bits == 10 ? SHIFT_10BIT : SHIFT_8BIT;
+    int max = (1 << bits) - 1;
+
+    double ys, cs;
+    int y_off, c_mid = 1 << (bits - 1);
+    if (range == COLORCONV_RANGE_FULL) {
+        ys = cs = (double)max / 255.0;
+        y_off = 0;
+    } else {
+        ys = (double)(219 << (bits - 8)) / 255.0;
+        cs = (double)(224 << (bits - 8)) / 255.0;
+        y_off = 16 << (bits - 8);
+    }
+
+    /* Luma weights sum to the white level and chroma weights to zero
+     * exactly, so grey stays grey after rounding */
+    int16_t yr = q(kr * ys, s), yb = q(kb * ys, s);
+    int16_t yg = (int16_t)(q(ys, s) - yr - yb);
+    int16_t ub = q(0.5 * cs, s), ur = q(-0.5 * cs * kr / (1.0 - kb), s);
+    int16_t ug = (int16_t)(-ub - ur);
+    int16_t vr = q(0.5 * cs, s), vb = q(-0.5 * cs * kb / (1.0 - kr), s);
+    int16_t vg = (int16_t)(-vr - vb);
+
+    int ri = src == COLORCONV_BGRA ? 2 : 0, bi = 2 - ri;
+    memset(k, 0, sizeof(*k));
+    k->dst = dst;
+    k->shift = s;
+    k->max = max;
+    k->y[ri] = yr, k->y[1] = yg, k->y[bi] = yb;
+    k->u[ri] = ur, k->u[1] = ug, k->u[bi] = ub;
+    k->v[ri] = vr, k->v[1] = vg, k->v[bi] = vb;
+    k->y_add = (y_off << s) + (1 << (s - 1));
+    k->c_add = (c_mid << (s + 2)) + (1 << (s + 1));
+}
+
+/* ── Scalar kernel ──────────────────────────────────────────────── */
+
+static inline int clamp_code(int v, int max) {
+    return v < 0 ? 0 : v > max ? max : v;
+}
+
+static inline void store16(uint8_t *p, int v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_y(const cc_coef_t *k, uint8_t *row, int x, const uint8_t *px) {
+    int v = (k->y_add + k->y[0] * px[0] + k->y[1] * px[1] + k->y[2] * px[2]) >> k->shift;
+    v = clamp_code(v, k->max);
+    if (k->dst == COLORCONV_P010)
+        store16(row + 2 * x, v << 6);
+    else
+        row[x] = (uint8_t)v;
+}
+
+/* Rows s0/s1 (s1 == s0 and y1 == NULL for an odd last row), columns
+ * [x, width); x is even */
+static void rowpair_scalar(const cc_coef_t *k, const uint8_t *s0, const uint8_t *s1,
+                           uint8_t *y0, uint8_t *y1, uint8_t *c0, uint8_t *c1, int x,
+                           int width) {
+    for (; x < width; x += 2) {
+        int xr = x + 1 < width ? x + 1 : x;
+        const uint8_t *p0 = s0 + 4 * x, *p1 = s0 + 4 * xr;
+        const uint8_t *p2 = s1 + 4 * x, *p3 = s1 + 4 * xr;
+
+        put_y(k, y0, x, p0);
+        if (xr != x) put_y(k, y0, xr, p1);
+        if (y1) {
+            put_y(k, y1, x, p2);
+            if (xr != x) put_y(k, y1, xr, p3);
+        }
+
+        int sr = p0[0] + p1[0] + p2[0] + p3[0];
+        int sg = p0[1] + p1[1] + p2[1] + p3[1];
+        int sb = p0[2] + p1[2] + p2[2] + p3[2];
+        int cs = k->shift + 2;
+        int u = clamp_code((k->c_add + k->u[0] * sr + k->u[1] * sg + k->u[2] * sb) >> cs, k->max);
+        int v = clamp_code((k->c_add + k->v[0] * sr + k->v[1] * sg + k->v[2] * sb) >> cs, k->max);
+
+        int cx = x / 2;
+        switch (k->dst) {
+        case COLORCONV_NV12:
+            c0[2 * cx] = (uint8_t)u;
+            c0[2 * cx + 1] = (uint8_t)v;
+            break;
+        case COLORCONV_I420:
+            c0[cx] = (uint8_t)u;
+            c1[cx] = (uint8_t)v;
+            break;
+        default: /* P010 */
+            store16(c0 + 4 * cx, u << 6);
+            store16(c0 + 4 * cx + 2, v << 6);
+            break;
+        }
+    }
+}
+
+#ifdef COLORCONV_X86
+
+/* ── SSE2 kernel: 16 pixels per row pair and iteration ──────────── */
+
+/* w01/w23 hold two pixels each as 16-bit channels; returns the four
+ * (add + Σ coef·channel) >> sh sums in pixel order */
+__attribute__((target("sse2"))) static inline __m128i dot4_sse2(__m128i w01, __m128i w23,
+                                                                __m128i coef, __m128i add,
+                                                                __m128i sh) {
+    __m128 a = _mm_castsi128_ps(_mm_madd_epi16(w01, coef));
+    __m128 b = _mm_castsi128_ps(_mm_madd_epi16(w23, coef));
+    __m128i even = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i odd = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), add), sh);
+}
+
+/* 2×2 channel sums of 4 pixels from each row → [block 0, block 1] */
+__attribute__((target("sse2"))) static inline __m128i quad_sse2(__m128i a, __m128i b) {
+    const __m128i z = _mm_setzero_si128();
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, z), _mm_unpacklo_epi8(b, z));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, z), _mm_unpackhi_epi8(b, z));
+    return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+}
+
+__attribute__((target("sse2"))) static inline __m128i p010_sse2(__m128i a, __m128i b,
+                                                                __m128i max) {
+    __m128i w = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(a, b), _mm_setzero_si128()), max);
+    return _mm_slli_epi16(w, 6);
+}
+
+__attribute__((target("sse2"))) static void luma16_sse2(const cc_coef_t *k, const uint8_t *s,
+                                                        uint8_t *out, __m128i cy, __m128i add,
+                                                        __m128i sh, __m128i max) {
+    const __m128i z = _mm_setzero_si128();
+    __m128i y[4];
+    for (int i = 0; i < 4; i++) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(s + 16 * i));
+        y[i] = dot4_sse2(_mm_unpacklo_epi8(px, z), _mm_unpackhi_epi8(px, z), cy, add, sh);
+    }
+    if (k->dst == COLORCONV_P010) {
+        _mm_storeu_si128((__m128i *)out, p010_sse2(y[0], y[1], max));
+        _mm_storeu_si128((__m128i *)(out + 16), p010_sse2(y[2], y[3], max));
+    } else {
+        __m128i b = _mm_packus_epi16(_mm_packs_epi32(y[0], y[1]), _mm_packs_epi32(y[2], y[3]));
+        _mm_storeu_si128((__m128i *)out, b);
+    }
+}
+
+__attribute__((target("sse2"))) static int rowpair_sse2(const cc_coef_t *k, const uint8_t *s0,
+                                                        const uint8_t *s1, uint8_t *y0,
+                                                        uint8_t *y1, uint8_t *c0, uint8_t *c1,
+                                                        int width) {
+    const __m128i cy = _mm_setr_epi16(k->y[0], k->y[1], k->y[2], 0, k->y[0], k->y[1], k->y[2], 0);
+    const __m128i cu = _mm_setr_epi16(k->u[0], k->u[1], k->u[2], 0, k->u[0], k->u[1], k->u[2], 0);
+    const __m128i cv = _mm_setr_epi16(k->v[0], k->v[1], k->v[2], 0, k->v[0], k->v[1], k->v[2], 0);
+    const __m128i yadd = _mm_set1_epi32(k->y_add), cadd = _mm_set1_epi32(k->c_add);
+    const __m128i ysh = _mm_cvtsi32_si128(k->shift), csh = _mm_cvtsi32_si128(k->shift + 2);
+    const __m128i max = _mm_set1_epi16((int16_t)k->max);
+    int bpp = k->dst == COLORCONV_P010 ? 2 : 1;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        const uint8_t *a = s0 + 4 * x, *b = s1 + 4 * x;
+
+        luma16_sse2(k, a, y0 + bpp * x, cy, yadd, ysh, max);
+        if (y1) luma16_sse2(k, b, y1 + bpp * x, cy, yadd, ysh, max);
+
+        __m128i qd[4];
+        for (int i = 0; i < 4; i++)
+            qd[i] = quad_sse2(_mm_loadu_si128((const __m128i *)(a + 16 * i)),
+                              _mm_loadu_si128((const __m128i *)(b + 16 * i)));
+        __m128i u0 = dot4_sse2(qd[0], qd[1], cu, cadd, csh);
+        __m128i u1 = dot4_sse2(qd[2], qd[3], cu, cadd, csh);
+        __m128i v0 = dot4_sse2(qd[0], qd[1], cv, cadd, csh);
+        __m128i v1 = dot4_sse2(qd[2], qd[3], cv, cadd, csh);
+
+        if (k->dst == COLORCONV_I420) {
+            __m128i uv = _mm_packus_epi16(_mm_packs_epi32(u0, u1), _mm_packs_epi32(v0, v1));
+            _mm_storel_epi64((__m128i *)(c0 + x / 2), uv);
+            _mm_storel_epi64((__m128i *)(c1 + x / 2), _mm_srli_si128(uv, 8));
+            continue;
+        }
+        __m128i lo0 = _mm_unpacklo_epi32(u0, v0), hi0 = _mm_unpackhi_epi32(u0, v0);
+        __m128i lo1 = _mm_unpacklo_epi32(u1, v1), hi1 = _mm_unpackhi_epi32(u1, v1);
+        if (k->dst == COLORCONV_P010) {
+            _mm_storeu_si128((__m128i *)(c0 + 2 * x), p010_sse2(lo0, hi0, max));
+            _mm_storeu_si128((__m128i *)(c0 + 2 * x + 16), p010_sse2(lo1, hi1, max));
+        } else {
+            __m128i uv = _mm_packus_epi16(_mm_packs_epi32(lo0, hi0), _mm_packs_epi32(lo1, hi1));
+            _mm_storeu_si128((__m128i *)(c0 + x), uv);
+        }
+    }
+    return x;
+}
+
+/* ── AVX2 kernel: 32 pixels per row pair and iteration ──────────── */
+
+/* The in-lane unpack/pack instructions leave results in the order the
+ * two 128-bit lanes produced them; the permutes below restore pixel
+ * order before every store. */
+
+__attribute__((target("avx2"))) static inline __m256i dot8_avx2(__m256i w01, __m256i w23,
+                                                                __m256i coef, __m256i add,
+                                                                __m128i sh) {
+    __m256 a = _mm256_castsi256_ps(_mm256_madd_epi16(w01, coef));
+    __m256 b = _mm256_castsi256_ps(_mm256_madd_epi16(w23, coef));
+    __m256i even = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m256i odd = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(even, odd), add), sh);
+}
+
+__attribute__((target("avx2"))) static inline __m256i quad_avx2(__m256i a, __m256i b) {
+    const __m256i z = _mm256_setzero_si256();
+    __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, z), _mm256_unpacklo_epi8(b, z));
+    __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, z), _mm256_unpackhi_epi8(b, z));
+    return _mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi));
+}
+
+/* packs_epi32 of two in-order vectors, back in order, clamped, << 6 */
+__attribute__((target("avx2"))) static inline __m256i p010_avx2(__m256i a, __m256i b,
+                                                                __m256i max) {
+    __m256i w = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+    w = _mm256_min_epi16(_mm256_max_epi16(w, _mm256_setzero_si256()), max);
+    return _mm256_slli_epi16(w, 6);
+}
+
+__attribute__((target("avx2"))) static void luma32_avx2(const cc_coef_t *k, const uint8_t *s,
+                                                        uint8_t *out, __m256i cy, __m256i add,
+                                                        __m128i sh, __m256i max) {
+    const __m256i z = _mm256_setzero_si256();
+    __m256i y[4];
+    for (int i = 0; i < 4; i++) {
+        __m256i px = _mm256_loadu_si256((const __m256i *)(s + 32 * i));
+        y[i] = dot8_avx2(_mm256_unpacklo_epi8(px, z), _mm256_unpackhi_epi8(px, z), cy, add, sh);
+    }
+    if (k->dst == COLORCONV_P010) {
+        _mm256_storeu_si256((__m256i *)out, p010_avx2(y[0], y[1], max));
+        _mm256_storeu_si256((__m256i *)(out + 32), p010_avx2(y[2], y[3], max));
+    } else {
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        __m256i b = _mm256_packus_epi16(_mm256_packs_epi32(y[0], y[1]),
+                                        _mm256_packs_epi32(y[2], y[3]));
+        _mm256_storeu_si256((__m256i *)out, _mm256_permutevar8x32_epi32(b, order));
+    }
+}
+
+__attribute__((target("avx2"))) static int rowpair_avx2(const cc_coef_t *k, const uint8_t *s0,
+                                                        const uint8_t *s1, uint8_t *y0,
+                                                        uint8_t *y1, uint8_t *c0, uint8_t *c1,
+                                                        int width) {
+#define CC_BCAST(c) _mm256_setr_epi16(c[0], c[1], c[2], 0, c[0], c[1], c[2], 0, \
+                                      c[0], c[1], c[2], 0, c[0], c[1], c[2], 0)
+    const __m256i cy = CC_BCAST(k->y), cu = CC_BCAST(k->u), cv = CC_BCAST(k->v);
+#undef CC_BCAST
+    const __m256i yadd = _mm256_set1_epi32(k->y_add), cadd = _mm256_set1_epi32(k->c_add);
+    const __m128i ysh = _mm_cvtsi32_si128(k->shift), csh = _mm_cvtsi32_si128(k->shift + 2);
+    const __m256i max = _mm256_set1_epi16((int16_t)k->max);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int bpp = k->dst == COLORCONV_P010 ? 2 : 1;
+    int x = 0;
+
+    for (; x + 32 <= width; x += 32) {
+        const uint8_t *a = s0 + 4 * x, *b = s1 + 4 * x;
+
+        luma32_avx2(k, a, y0 + bpp * x, cy, yadd, ysh, max);
+        if (y1) luma32_avx2(k, b, y1 + bpp * x, cy, yadd, ysh, max);
+
+        __m256i qd[4];
+        for (int i = 0; i < 4; i++)
+            qd[i] = quad_avx2(_mm256_loadu_si256((const __m256i *)(a + 32 * i)),
+                              _mm256_loadu_si256((const __m256i *)(b + 32 * i)));
+        /* Lane 0 holds blocks 0,1,4,5 (8,9,12,13), lane 1 blocks 2,3,6,7 (…) */
+        __m256i u0 = dot8_avx2(qd[0], qd[1], cu, cadd, csh);
+        __m256i u1 = dot8_avx2(qd[2], qd[3], cu, cadd, csh);
+        __m256i v0 = dot8_avx2(qd[0], qd[1], cv, cadd, csh);
+        __m256i v1 = dot8_avx2(qd[2], qd[3], cv, cadd, csh);
+
+        if (k->dst == COLORCONV_I420) {
+            const __m256i spread = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7,
+                                                    14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12,
+                                                    13, 6, 7, 14, 15);
+            __m256i uv = _mm256_packus_epi16(_mm256_packs_epi32(u0, u1),
+                                             _mm256_packs_epi32(v0, v1));
+            uv = _mm256_permute4x64_epi64(uv, _MM_SHUFFLE(3, 1, 2, 0));
+            uv = _mm256_shuffle_epi8(uv, spread);
+            _mm_storeu_si128((__m128i *)(c0 + x / 2), _mm256_castsi256_si128(uv));
+            _mm_storeu_si128((__m128i *)(c1 + x / 2), _mm256_extracti128_si256(uv, 1));
+            continue;
+        }
+        __m256i lo0 = _mm256_unpacklo_epi32(u0, v0), hi0 = _mm256_unpackhi_epi32(u0, v0);
+        __m256i lo1 = _mm256_unpacklo_epi32(u1, v1), hi1 = _mm256_unpackhi_epi32(u1, v1);
+        if (k->dst == COLORCONV_P010) {
+            _mm256_storeu_si256((__m256i *)(c0 + 2 * x), p010_avx2(lo0, hi0, max));
+            _mm256_storeu_si256((__m256i *)(c0 + 2 * x + 32), p010_avx2(lo1, hi1, max));
+        } else {
+            __m256i uv = _mm256_packus_epi16(_mm256_packs_epi32(lo0, hi0),
+                                             _mm256_packs_epi32(lo1, hi1));
+            _mm256_storeu_si256((__m256i *)(c0 + x), _mm256_permutevar8x32_epi32(uv, order));
+        }
+    }
+    return x;
+}
+
+#endif /* COLORCONV_X86 */
+
+/* ── Row bands ──────────────────────────────────────────────────── */
+
+static void convert_pairs(const cc_job_t *job, int first, int last) {
+    const colorconv_image_t *src = job->src, *dst = job->dst;
+    int w = src->width, h = src->height;
+
+    for (int r = first; r < last; r++) {
+        int row = 2 * r;
+        bool pair = row + 1 < h;
+        const uint8_t *s0 = src->plane[0] + (size_t)row * src->stride[0];
+        const uint8_t *s1 = pair ? s0 + src->stride[0] : s0;
+        uint8_t *y0 = dst->plane[0] + (size_t)row * dst->stride[0];
+        uint8_t *y1 = pair ? y0 + dst->stride[0] : NULL;
+        uint8_t *c0 = dst->plane[1] + (size_t)r * dst->stride[1];
+        uint8_t *c1 = dst->format == COLORCONV_I420 ? dst->plane[2] + (size_t)r * dst->stride[2]
+                                                    : NULL;
+        int done = 0;
+#ifdef COLORCONV_X86
+        if (job->kernel == COLORCONV_KERNEL_AVX2)
+            done = rowpair_avx2(job->k, s0, s1, y0, y1, c0, c1, w);
+        else if (job->kernel == COLORCONV_KERNEL_SSE2)
+            done = rowpair_sse2(job->k, s0, s1, y0, y1, c0, c1, w);
+#endif
+        rowpair_scalar(job->k, s0, s1, y0, y1, c0, c1, done, w);
+    }
+}
+
+static void convert_band(const cc_job_t *job, int band) {
+    int first = (int)((int64_t)job->pairs * band / job->bands);
+    int last = (int)((int64_t)job->pairs * (band + 1) / job->bands);
+    convert_pairs(job, first, last);
+}
+
+/* Called with cc->lock held; takes bands until none are left */
+static void run_bands_locked(colorconv_t *cc) {
+    while (cc->next_band < cc->job.bands) {
+        int band = cc->next_band++;
+        cc_job_t job = cc->job;
+        pthread_mutex_unlock(&cc->lock);
+        convert_band(&job, band);
+        pthread_mutex_lock(&cc->lock);
+    }
+}
+
+static void *worker_main(void *arg) {
+    colorconv_t *cc = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&cc->lock);
+    for (;;) {
+        while (!cc->stop && cc->generation == seen)
+            pthread_cond_wait(&cc->start_cv, &cc->lock);
+        if (cc->stop) break;
+        seen = cc->generation;
+        run_bands_locked(cc);
+        if (--cc->busy == 0) pthread_cond_signal(&cc->done_cv);
+    }
+    pthread_mutex_unlock(&cc->lock);
+    return NULL;
+}
+
+/* ── Public API ─────────────────────────────────────────────────── */
+
+static colorconv_kernel_t best_kernel(void) {
+#ifdef COLORCONV_X86
+    if (__builtin_cpu_supports("avx2"))
+        return COLORCONV_KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return COLORCONV_KERNEL_SSE2;
+#endif
+    return COLORCONV_KERNEL_SCALAR;
+}
+
+colorconv_t *colorconv_create(colorconv_matrix_t matrix, colorconv_range_t range, int threads) {
+    colorconv_t *cc = calloc(1, sizeof(*cc));
+    if (!cc) return NULL;
+
+    cc->matrix = matrix;
+    cc->range = range;
+    cc->kernel = best_kernel();
+
+    if (threads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (int)n : 1;
+    }
+    if (threads > COLORCONV_MAX_THREADS) threads = COLORCONV_MAX_THREADS;
+
+    pthread_mutex_init(&cc->lock, NULL);
+    pthread_cond_init(&cc->start_cv, NULL);
+    pthread_cond_init(&cc->done_cv, NULL);
+
+    for (int i = 0; i < threads - 1; i++) {
+        if (pthread_create(&cc->workers[i], NULL, worker_main, cc) != 0) {
+            colorconv_destroy(cc);
+            return NULL;
+        }
+        cc->nworkers++;
+    }
+    return cc;
+}
+
+void colorconv_destroy(colorconv_t *cc) {
+    if (!cc) return;
+
+    pthread_mutex_lock(&cc->lock);
+    cc->stop = true;
+    pthread_cond_broadcast(&cc->start_cv);
+    pthread_mutex_unlock(&cc->lock);
+    for (int i = 0; i < cc->nworkers; i++)
+        pthread_join(cc->workers[i], NULL);
+
+    pthread_cond_destroy(&cc->done_cv);
+    pthread_cond_destroy(&cc->start_cv);
+    pthread_mutex_destroy(&cc->lock);
+    free(cc);
+}
+
+int colorconv_set_kernel(colorconv_t *cc, colorconv_kernel_t kernel) {
+    if (!cc) return -1;
+
+    switch (kernel) {
+    case COLORCONV_KERNEL_AUTO:
+        cc->kernel = best_kernel();
+        return 0;
+    case COLORCONV_KERNEL_SCALAR:
+        cc->kernel = kernel;
+        return 0;
+#ifdef COLORCONV_X86
+    case COLORCONV_KERNEL_SSE2:
+        if (!__builtin_cpu_supports("sse2")) return -1;
+        cc->kernel = kernel;
+        return 0;
+    case COLORCONV_KERNEL_AVX2:
+        if (!__builtin_cpu_supports("avx2")) return -1;
+        cc->kernel = kernel;
+        return 0;
+#endif
+    default:
+        return -1;
+    }
+}
+
+colorconv_kernel_t colorconv_get_kernel(const colorconv_t *cc) {
+    return cc ? cc->kernel : COLORCONV_KERNEL_SCALAR;
+}
+
+const char *colorconv_kernel_name(colorconv_kernel_t kernel) {
+    switch (kernel) {
+    case COLORCONV_KERNEL_SCALAR: return "scalar";
+    case COLORCONV_KERNEL_SSE2:   return "sse2";
+    case COLORCONV_KERNEL_AVX2:   return "avx2";
+    default:                      return "auto";
+    }
+}
+
+static bool geometry_ok(const colorconv_image_t *src, const colorconv_image_t *dst) {
+    if (src->format != COLORCONV_RGBA && src->format != COLORCONV_BGRA) return false;
+    if (dst->format != COLORCONV_NV12 && dst->format != COLORCONV_I420 &&
+        dst->format != COLORCONV_P010)
+        return false;
+    if (src->width <= 0 || src->height <= 0) return false;
+    if (src->width != dst->width || src->height != dst->height) return false;
+
+    int w = src->width, cw = (w + 1) / 2;
+    int bps = dst->format == COLORCONV_P010 ? 2 : 1;
+    int cstride = dst->format == COLORCONV_I420 ? cw : 2 * cw * bps;
+    if (!src->plane[0] || src->stride[0] < 4 * w) return false;
+    if (!dst->plane[0] || dst->stride[0] < w * bps) return false;
+    if (!dst->plane[1] || dst->stride[1] < cstride) return false;
+    if (dst->format == COLORCONV_I420 && (!dst->plane[2] || dst->stride[2] < cw)) return false;
+    return true;
+}
+
+int colorconv_convert(colorconv_t *cc, const colorconv_image_t *src,
+                      const colorconv_image_t *dst) {
+    if (!cc || !src || !dst || !geometry_ok(src, dst)) return -1;
+
+    cc_coef_t k;
+    build_coef(&k, cc->matrix, cc->range, src->format, dst->format);
+
+    cc_job_t job = {
+        .k = &k,
+        .src = src,
+        .dst = dst,
+        .kernel = cc->kernel,
+        .pairs = (src->height + 1) / 2,
+        .bands = 1,
+    };
+
+    if (cc->nworkers == 0 || (int64_t)src->width * src->height < COLORCONV_MT_MIN_PIXELS) {
+        convert_pairs(&job, 0, job.pairs);
+        return 0;
+    }
+
+    /* Two bands per thread evens out threads that start late */
+    job.bands = 2 * (cc->nworkers + 1);
+    if (job.bands > job.pairs) job.bands = job.pairs;
+
+    pthread_mutex_lock(&cc->lock);
+    cc->job = job;
+    cc->next_band = 0;
+    cc->busy = cc->nworkers;
+    cc->generation++;
+    pthread_cond_broadcast(&cc->start_cv);
+    run_bands_locked(cc);
+    while (cc->busy > 0)
+        pthread_cond_wait(&cc->done_cv, &cc->lock);
+    pthread_mutex_unlock(&cc->lock);
+    return 0;
+}
+
+colorconv_matrix_t colorconv_matrix_for_height(int height) {
+    return height > 576 ? COLORCONV_BT709 : COLORCONV_BT601;
+}
+
+size_t colorconv_image_size(colorconv_format_t format, int width, int height) {
+    size_t luma = (size_t)width * height;
+    size_t chroma = (size_t)((width + 1) / 2) * ((height + 1) / 2);
+
+    switch (format) {
+    case COLORCONV_RGBA:
+    case COLORCONV_BGRA: return 4 * luma;
+    case COLORCONV_NV12:
+    case COLORCONV_I420: return luma + 2 * chroma;
+    case COLORCONV_P010: return 2 * (luma + 2 * chroma);
+    }
+    return 0;
+}
+
+void colorconv_image_init(colorconv_image_t *img, colorconv_format_t format, int width,
+                          int height, uint8_t *buf) {
+    int cw = (width + 1) / 2, ch = (height + 1) / 2;
+
+    memset(img, 0, sizeof(*img));
+    img->format = format;
+    img->width = width;
+    img->height = height;
+    img->plane[0] = buf;
+
+    switch (format) {
+    case COLORCONV_RGBA:
+    case COLORCONV_BGRA:
+        img->stride[0] = 4 * width;
+        break;
+    case COLORCONV_NV12:
+        img->stride[0] = width;
+        img->plane[1] = buf + (size_t)width * height;
+        img->stride[1] = 2 * cw;
+        break;
+    case COLORCONV_I420:
+        img->stride[0] = width;
+        img->plane[1] = buf + (size_t)width * height;
+        img->stride[1] = cw;
+        img->plane[2] = img->plane[1] + (size_t)cw * ch;
+        img->stride[2] = cw;
+        break;
+    case COLORCONV_P010:
+        img->stride[0] = 2 * width;
+        img->plane[1] = buf + (size_t)2 * width * height;
+        img->stride[1] = 4 * cw;
+        break;
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * colorconv.h — RGBA/BGRA → YUV 4:2:0 conversion shared by the encoders
+ *
+ * Converts packed 32-bit RGB frames to the three 4:2:0 layouts the
+ * encoders consume:
+ *
+ *   NV12 — 8-bit Y plane + interleaved UV plane
+ *   I420 — 8-bit Y, U and V planes
+ *   P010 — 16-bit little-endian Y plane + interleaved UV plane, 10
+ *          significant bits in the high bits of each sample
+ *
+ * Luma and chroma use BT.601 or BT.709 coefficients in limited (studio)
+ * or full range.  Each chroma sample is the average of its 2×2 block of
+ * source pixels; an odd last row or column is averaged with itself.
+ *
+ * The work is done two source rows at a time by a scalar, SSE2 or AVX2
+ * kernel; the fastest one the CPU supports is chosen at run time and all
+ * three produce identical output.  Frames of at least
+ * COLORCONV_MT_MIN_PIXELS are split into bands of row pairs that the
+ * converter's worker threads process in parallel with the caller.
+ *
+ * Thread-safety: a colorconv_t may only be used by one thread at a
+ *                time; separate converters are independent.
+ */
+
+#ifndef ROOTSTREAM_COLORCONV_H
+#define ROOTSTREAM_COLORCONV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COLORCONV_MAX_THREADS   8
+#define COLORCONV_MT_MIN_PIXELS (2560 * 1440) /**< Smallest frame split over threads */
+
+typedef enum {
+    COLORCONV_RGBA = 0, /**< Bytes R, G, B, A */
+    COLORCONV_BGRA,     /**< Bytes B, G, R, A */
+    COLORCONV_NV12,
+    COLORCONV_I420,
+    COLORCONV_P010,
+} colorconv_format_t;
+
+typedef enum {
+    COLORCONV_BT601 = 0,
+    COLORCONV_BT709,
+} colorconv_matrix_t;
+
+typedef enum {
+    COLORCONV_RANGE_LIMITED = 0, /**< Y 16–235, UV 16–240 (×4 for 10-bit) */
+    COLORCONV_RANGE_FULL,        /**< Y and UV use the whole code range */
+} colorconv_range_t;
+
+typedef enum {
+    COLORCONV_KERNEL_AUTO = 0,
+    COLORCONV_KERNEL_SCALAR,
+    COLORCONV_KERNEL_SSE2,
+    COLORCONV_KERNEL_AVX2,
+} colorconv_kernel_t;
+
+/** One frame: plane[0] is RGB or Y, plane[1] UV or U, plane[2] V (I420) */
+typedef struct {
+    colorconv_format_t format;
+    int width;
+    int height;
+    uint8_t *plane[3];
+    int stride[3]; /**< Bytes per row of each plane */
+} colorconv_image_t;
+
+/** Opaque converter */
+typedef struct colorconv_s colorconv_t;
+
+/**
+ * colorconv_create — allocate a converter
+ *
+ * @param matrix   Colour matrix of the output
+ * @param range    Quantisation range of the output
+ * @param threads  Threads used for large frames, including the caller;
+ *                 0 picks one per online CPU, capped at
+ *                 COLORCONV_MAX_THREADS
+ * @return         Converter, or NULL on OOM / thread creation failure
+ */
+colorconv_t *colorconv_create(colorconv_matrix_t matrix, colorconv_range_t range, int threads);
+
+/**
+ * colorconv_destroy — stop the worker threads and free @cc
+ */
+void colorconv_destroy(colorconv_t *cc);
+
+/**
+ * colorconv_set_kernel — force a kernel (benchmarks and tests)
+ *
+ * @return 0, or -1 if this CPU or build cannot run @kernel
+ */
+int colorconv_set_kernel(colorconv_t *cc, colorconv_kernel_t kernel);
+
+/**
+ * colorconv_get_kernel — kernel conversions currently run with
+ */
+colorconv_kernel_t colorconv_get_kernel(const colorconv_t *cc);
+
+/**
+ * colorconv_kernel_name — "scalar", "sse2", "avx2" or "auto"
+ */
+const char *colorconv_kernel_name(colorconv_kernel_t kernel);
+
+/**
+ * colorconv_convert — convert @src into @dst
+ *
+ * @param src  RGBA or BGRA image
+ * @param dst  NV12, I420 or P010 image of the same width and height
+ * @return     0 on success, -1 on unsupported formats or bad geometry
+ */
+int colorconv_convert(colorconv_t *cc, const colorconv_image_t *src,
+                      const colorconv_image_t *dst);
+
+/**
+ * colorconv_matrix_for_height — BT.601 up to 576 lines, BT.709 above
+ *
+ * Matches what decoders (SDL, most players) assume for untagged video.
+ */
+colorconv_matrix_t colorconv_matrix_for_height(int height);
+
+/**
+ * colorconv_image_size — bytes of a tightly packed @format image
+ *
+ * Planes follow each other; Y rows are @width samples wide and chroma
+ * planes are rounded up for odd dimensions.
+ */
+size_t colorconv_image_size(colorconv_format_t format, int width, int height);
+
+/**
+ * colorconv_image_init — describe a tightly packed image stored at @buf
+ *
+ * Uses the layout of colorconv_image_size().
+ */
+void colorconv_image_init(colorconv_image_t *img, colorconv_format_t format, int width,
+                          int height, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_COLORCONV_H */
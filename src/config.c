@@ -100,6 +100,9 @@ static void config_init_defaults(settings_t *settings) {
     settings->video_framerate = 60;     /* 60 fps */
     strncpy(settings->video_codec, "h264", sizeof(settings->video_codec) - 1);
     settings->display_index = 0;
+    settings->pipeline_enabled = false;
+    settings->damage_capture = true;
+    settings->zero_copy_capture = false;
 
     /* Audio defaults */
     settings->audio_enabled = true;
@@ -109,6 +112,9 @@ static void config_init_defaults(settings_t *settings) {
     settings->network_port = 9876;
     settings->discovery_enabled = true;
 
+    /* Input defaults */
+    settings->input_coalesce = true;
+
     /* Connection history */
     settings->peer_history_count = 0;
     settings->last_connected[0] = '\0';
@@ -210,6 +216,13 @@ static int config_load_ini(settings_t *settings, const char *config_dir) {
                 strncpy(settings->video_codec, value, sizeof(settings->video_codec) - 1);
             } else if (strcmp(key, "display") == 0) {
                 settings->display_index = atoi(value);
+            } else if (strcmp(key, "pipeline") == 0) {
+                settings->pipeline_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+            } else if (strcmp(key, "damage") == 0) {
+                settings->damage_capture = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+            } else if (strcmp(key, "zero_copy") == 0) {
+                settings->zero_copy_capture =
+                    (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
             }
         }
         /* Audio settings */
@@ -229,6 +242,12 @@ static int config_load_ini(settings_t *settings, const char *config_dir) {
                     (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
             }
         }
+        /* Input settings */
+        else if (strcmp(section, "input") == 0) {
+            if (strcmp(key, "coalesce") == 0) {
+                settings->input_coalesce = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+            }
+        }
         /* Peer history */
         else if (strcmp(section, "peers") == 0) {
             if (strcmp(key, "last_connected") == 0) {
@@ -277,7 +296,10 @@ static int config_save_ini(const settings_t *settings, const char *config_dir) {
     fprintf(fp, "bitrate = %u\n", settings->video_bitrate);
     fprintf(fp, "framerate = %u\n", settings->video_framerate);
     fprintf(fp, "codec = %s\n", settings->video_codec);
-    fprintf(fp, "display = %d\n\n", settings->display_index);
+    fprintf(fp, "display = %d\n", settings->display_index);
+    fprintf(fp, "pipeline = %s\n", settings->pipeline_enabled ? "true" : "false");
+    fprintf(fp, "damage = %s\n", settings->damage_capture ? "true" : "false");
+    fprintf(fp, "zero_copy = %s\n\n", settings->zero_copy_capture ? "true" : "false");
 
     /* Audio settings */
     fprintf(fp, "[audio]\n");
@@ -289,6 +311,10 @@ static int config_save_ini(const settings_t *settings, const char *config_dir) {
     fprintf(fp, "port = %u\n", settings->network_port);
     fprintf(fp, "discovery = %s\n\n", settings->discovery_enabled ? "true" : "false");
 
+    /* Input settings */
+    fprintf(fp, "[input]\n");
+    fprintf(fp, "coalesce = %s\n\n", settings->input_coalesce ? "true" : "false");
+
     /* Peer history */
     fprintf(fp, "[peers]\n");
     if (settings->last_connected[0] != '\0') {
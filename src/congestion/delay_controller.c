@@ -0,0 +1,479 @@
+/*
+ * delay_controller.c — Delay-gradient send-rate controller
+ */
+
+#include "delay_controller.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtt_estimator.h"
+
+#define TREND_SMOOTHING 0.9
+#define TREND_GAIN 4.0
+#define TREND_MAX_DELTAS 60
+#define THRESHOLD_INIT_MS 12.5
+#define THRESHOLD_MIN_MS 6.0
+#define THRESHOLD_MAX_MS 600.0
+#define THRESHOLD_K_UP 0.0087
+#define THRESHOLD_K_DOWN 0.039
+#define THRESHOLD_MAX_JUMP_MS 15.0
+#define ARRIVAL_RESET_US 3000000 /* Arrival gap that restarts delay tracking */
+
+#define ACKED_BIN_US 10000 /* Receive-rate histogram bin */
+#define ACKED_BINS 64
+#define ACKED_WINDOW_BINS 50 /* 500 ms */
+#define ACKED_MIN_BINS 10    /* Need 100 ms before trusting the rate */
+
+#define INCREASE_PER_S 1.08
+#define RESPONSE_EXTRA_US 100000 /* Response time = RTT + this */
+#define LOSS_MIN_PACKETS 20
+#define LOSS_INTERVAL_US 500000 /* Loss is measured over at least this */
+#define LOSS_DECREASE_INTERVAL_US 300000
+
+typedef enum { RATE_HOLD, RATE_INCREASE } rate_state_t;
+
+typedef struct {
+    uint64_t first_send_us;
+    uint64_t last_send_us;
+    uint64_t last_arrival_us;
+} packet_group_t;
+
+struct delay_controller_s {
+    delay_controller_config_t config;
+    double target_bps;
+
+    /* Packet groups */
+    packet_group_t cur, prev;
+    bool have_cur, have_prev;
+
+    /* Trendline */
+    double acc_delay_ms;
+    double smoothed_ms;
+    double first_arrival_ms;
+    double hist_x[DC_TREND_WINDOW]; /* Arrival time since first_arrival_ms */
+    double hist_y[DC_TREND_WINDOW]; /* Smoothed accumulated delay */
+    int hist_len, hist_head;
+    int num_deltas;
+    double trend, prev_trend;
+
+    /* Overuse detector */
+    double threshold_ms;
+    double threshold_updated_ms;
+    double time_over_ms; /* < 0: not above threshold */
+    int overuse_count;
+    dc_usage_t usage;
+
+    /* Rate control */
+    rate_state_t rate_state;
+    uint64_t last_update_us;
+    uint64_t last_decrease_us;
+    double link_kbps, link_var; /* Receive rate at past decreases */
+    bool link_known;
+    double avg_packet_bytes;
+
+    /* Acknowledged receive rate (arrival clock) */
+    uint64_t bin_key[ACKED_BINS];
+    uint64_t bin_bytes[ACKED_BINS];
+    uint64_t first_key, newest_key;
+    bool have_bins;
+    double acked_bps;
+
+    /* Loss */
+    uint32_t loss_received, loss_lost;
+    uint64_t loss_since_us;
+    double loss_fraction;
+    uint64_t last_loss_decrease_us;
+
+    rtt_estimator_t *rtt;
+    delay_controller_stats_t stats;
+};
+
+static double clamp_target(const delay_controller_t *dc, double bps) {
+    if (bps < dc->config.min_bps)
+        return dc->config.min_bps;
+    if (bps > dc->config.max_bps)
+        return dc->config.max_bps;
+    return bps;
+}
+
+delay_controller_t *delay_controller_create(const delay_controller_config_t *config) {
+    if (!config || config->min_bps == 0 || config->max_bps < config->min_bps)
+        return NULL;
+    delay_controller_t *dc = calloc(1, sizeof(*dc));
+    if (!dc)
+        return NULL;
+    dc->rtt = rtt_estimator_create();
+    if (!dc->rtt) {
+        free(dc);
+        return NULL;
+    }
+    dc->config = *config;
+    dc->target_bps = clamp_target(dc, config->start_bps);
+    delay_controller_reset(dc);
+    return dc;
+}
+
+void delay_controller_destroy(delay_controller_t *dc) {
+    if (!dc)
+        return;
+    rtt_estimator_destroy(dc->rtt);
+    free(dc);
+}
+
+static void reset_delay(delay_controller_t *dc) {
+    dc->have_cur = dc->have_prev = false;
+    dc->acc_delay_ms = dc->smoothed_ms = 0.0;
+    dc->first_arrival_ms = -1.0;
+    dc->hist_len = dc->hist_head = 0;
+    dc->num_deltas = 0;
+    dc->trend = dc->prev_trend = 0.0;
+    dc->time_over_ms = -1.0;
+    dc->overuse_count = 0;
+    dc->usage = DC_USAGE_NORMAL;
+}
+
+void delay_controller_reset(delay_controller_t *dc) {
+    if (!dc)
+        return;
+    reset_delay(dc);
+    dc->threshold_ms = THRESHOLD_INIT_MS;
+    dc->threshold_updated_ms = -1.0;
+    dc->rate_state = RATE_HOLD;
+    dc->last_update_us = dc->last_decrease_us = dc->last_loss_decrease_us = 0;
+    dc->link_known = false;
+    dc->avg_packet_bytes = 1200.0;
+    memset(dc->bin_key, 0, sizeof(dc->bin_key));
+    memset(dc->bin_bytes, 0, sizeof(dc->bin_bytes));
+    dc->have_bins = false;
+    dc->acked_bps = 0.0;
+    dc->loss_received = dc->loss_lost = 0;
+    dc->loss_since_us = 0;
+    dc->loss_fraction = 0.0;
+    rtt_estimator_reset(dc->rtt);
+}
+
+int delay_controller_set_bounds(delay_controller_t *dc, uint32_t min_bps, uint32_t max_bps) {
+    if (!dc || min_bps == 0 || max_bps < min_bps)
+        return -1;
+    dc->config.min_bps = min_bps;
+    dc->config.max_bps = max_bps;
+    dc->target_bps = clamp_target(dc, dc->target_bps);
+    return 0;
+}
+
+uint32_t delay_controller_target_bps(const delay_controller_t *dc) {
+    return dc ? (uint32_t)dc->target_bps : 0;
+}
+
+/* ── Acknowledged rate ───────────────────────────────────────────── */
+
+static void acked_add(delay_controller_t *dc, uint64_t arrival_us, uint32_t size) {
+    uint64_t key = arrival_us / ACKED_BIN_US;
+    if (!dc->have_bins) {
+        dc->first_key = dc->newest_key = key;
+        dc->have_bins = true;
+    }
+    if (key + ACKED_BINS <= dc->newest_key)
+        return; /* Older than the histogram */
+    size_t slot = key % ACKED_BINS;
+    if (dc->bin_key[slot] != key) {
+        dc->bin_key[slot] = key;
+        dc->bin_bytes[slot] = 0;
+    }
+    dc->bin_bytes[slot] += size;
+    if (key > dc->newest_key)
+        dc->newest_key = key;
+}
+
+/* Rate over the last complete bins (the newest is still filling) */
+static void acked_update(delay_controller_t *dc) {
+    if (!dc->have_bins)
+        return;
+    uint64_t span = dc->newest_key - dc->first_key;
+    if (span > ACKED_WINDOW_BINS)
+        span = ACKED_WINDOW_BINS;
+    if (span < ACKED_MIN_BINS)
+        return;
+
+    uint64_t bytes = 0;
+    for (uint64_t key = dc->newest_key - span; key < dc->newest_key; key++) {
+        size_t slot = key % ACKED_BINS;
+        if (dc->bin_key[slot] == key)
+            bytes += dc->bin_bytes[slot];
+    }
+    dc->acked_bps = (double)bytes * 8.0 * 1e6 / ((double)span * ACKED_BIN_US);
+}
+
+/* ── Trendline + overuse detector ────────────────────────────────── */
+
+static double trend_slope(const delay_controller_t *dc) {
+    double sx = 0.0, sy = 0.0;
+    for (int i = 0; i < dc->hist_len; i++) {
+        sx += dc->hist_x[i];
+        sy += dc->hist_y[i];
+    }
+    double mx = sx / dc->hist_len, my = sy / dc->hist_len;
+    double num = 0.0, den = 0.0;
+    for (int i = 0; i < dc->hist_len; i++) {
+        num += (dc->hist_x[i] - mx) * (dc->hist_y[i] - my);
+        den += (dc->hist_x[i] - mx) * (dc->hist_x[i] - mx);
+    }
+    return den > 0.0 ? num / den : dc->trend;
+}
+
+static void threshold_update(delay_controller_t *dc, double modified, double now_ms) {
+    if (dc->threshold_updated_ms < 0.0)
+        dc->threshold_updated_ms = now_ms;
+    double mag = fabs(modified);
+    if (mag > dc->threshold_ms + THRESHOLD_MAX_JUMP_MS) {
+        /* A spike (e.g. a route change) must not drag the threshold up */
+        dc->threshold_updated_ms = now_ms;
+        return;
+    }
+    double k = mag < dc->threshold_ms ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+    double dt = fmin(now_ms - dc->threshold_updated_ms, 100.0);
+    dc->threshold_ms += k * (mag - dc->threshold_ms) * dt;
+    dc->threshold_ms = fmax(THRESHOLD_MIN_MS, fmin(dc->threshold_ms, THRESHOLD_MAX_MS));
+    dc->threshold_updated_ms = now_ms;
+}
+
+static void detect(delay_controller_t *dc, double send_delta_ms, double now_ms) {
+    double modified = fmin(dc->num_deltas, TREND_MAX_DELTAS) * dc->trend * TREND_GAIN;
+    if (dc->num_deltas < 2) {
+        dc->usage = DC_USAGE_NORMAL;
+    } else if (modified > dc->threshold_ms) {
+        if (dc->time_over_ms < 0.0)
+            dc->time_over_ms = send_delta_ms / 2.0;
+        else
+            dc->time_over_ms += send_delta_ms;
+        dc->overuse_count++;
+        if (dc->time_over_ms > DC_OVERUSE_MS && dc->overuse_count > 1 &&
+            modified >= dc->prev_trend) {
+            dc->time_over_ms = 0.0;
+            dc->overuse_count = 0;
+            dc->usage = DC_USAGE_OVER;
+        }
+    } else if (modified < -dc->threshold_ms) {
+        dc->time_over_ms = -1.0;
+        dc->overuse_count = 0;
+        dc->usage = DC_USAGE_UNDER;
+    } else {
+        dc->time_over_ms = -1.0;
+        dc->overuse_count = 0;
+        dc->usage = DC_USAGE_NORMAL;
+    }
+    dc->prev_trend = modified;
+    dc->stats.trend = modified;
+    threshold_update(dc, modified, now_ms);
+}
+
+static void trend_update(delay_controller_t *dc, double delay_ms, double send_delta_ms,
+                         double arrival_ms) {
+    if (dc->num_deltas < 1000)
+        dc->num_deltas++;
+    dc->acc_delay_ms += delay_ms;
+    dc->smoothed_ms = TREND_SMOOTHING * dc->smoothed_ms + (1.0 - TREND_SMOOTHING) *
+                                                              dc->acc_delay_ms;
+    if (dc->first_arrival_ms < 0.0)
+        dc->first_arrival_ms = arrival_ms;
+
+    dc->hist_x[dc->hist_head] = arrival_ms - dc->first_arrival_ms;
+    dc->hist_y[dc->hist_head] = dc->smoothed_ms;
+    dc->hist_head = (dc->hist_head + 1) % DC_TREND_WINDOW;
+    if (dc->hist_len < DC_TREND_WINDOW)
+        dc->hist_len++;
+    if (dc->hist_len == DC_TREND_WINDOW)
+        dc->trend = trend_slope(dc);
+
+    detect(dc, send_delta_ms, arrival_ms);
+}
+
+/*
+ * Add a received packet to the current group; a packet sent more than
+ * DC_BURST_US after the group's first closes it and starts the next
+ */
+static void group_packet(delay_controller_t *dc, const tfb_packet_t *p) {
+    if (!dc->have_cur) {
+        dc->cur = (packet_group_t){p->send_us, p->send_us, p->arrival_us};
+        dc->have_cur = true;
+        return;
+    }
+    if (p->send_us < dc->cur.first_send_us)
+        return; /* Reordered across groups */
+    if (p->send_us - dc->cur.first_send_us <= DC_BURST_US) {
+        if (p->send_us > dc->cur.last_send_us)
+            dc->cur.last_send_us = p->send_us;
+        if (p->arrival_us > dc->cur.last_arrival_us)
+            dc->cur.last_arrival_us = p->arrival_us;
+        return;
+    }
+
+    if (dc->have_prev) {
+        int64_t arrival_delta = (int64_t)(dc->cur.last_arrival_us - dc->prev.last_arrival_us);
+        int64_t send_delta = (int64_t)(dc->cur.last_send_us - dc->prev.last_send_us);
+        if (arrival_delta > ARRIVAL_RESET_US) {
+            reset_delay(dc); /* Sender paused; old delay no longer relevant */
+        } else if (arrival_delta >= 0) {
+            trend_update(dc, (double)(arrival_delta - send_delta) / 1000.0,
+                         (double)send_delta / 1000.0, (double)dc->cur.last_arrival_us / 1000.0);
+        }
+    }
+    dc->prev = dc->cur;
+    dc->have_prev = true;
+    dc->cur = (packet_group_t){p->send_us, p->send_us, p->arrival_us};
+    dc->have_cur = true;
+}
+
+/* ── Rate control ────────────────────────────────────────────────── */
+
+static void link_update(delay_controller_t *dc, double acked_bps) {
+    double kbps = acked_bps / 1000.0;
+    if (!dc->link_known) {
+        dc->link_kbps = kbps;
+        dc->link_var = 0.4;
+        dc->link_known = true;
+        return;
+    }
+    double sigma = sqrt(dc->link_var * dc->link_kbps);
+    if (fabs(kbps - dc->link_kbps) > 3.0 * sigma) {
+        dc->link_kbps = kbps; /* Capacity changed */
+        dc->link_var = 0.4;
+        return;
+    }
+    const double alpha = 0.05;
+    dc->link_kbps = (1.0 - alpha) * dc->link_kbps + alpha * kbps;
+    double norm = fmax(dc->link_kbps, 1.0);
+    dc->link_var = (1.0 - alpha) * dc->link_var +
+                   alpha * (dc->link_kbps - kbps) * (dc->link_kbps - kbps) / norm;
+    dc->link_var = fmax(0.4, fmin(dc->link_var, 2.5));
+}
+
+static double delay_based_target(delay_controller_t *dc, uint64_t now_us) {
+    double target = dc->target_bps;
+    double dt_s = dc->last_update_us ? (double)(now_us - dc->last_update_us) / 1e6 : 0.0;
+    if (dt_s > 1.0)
+        dt_s = 1.0;
+
+    rtt_snapshot_t rtt;
+    rtt_estimator_snapshot(dc->rtt, &rtt);
+    double rtt_us = rtt.sample_count ? rtt.srtt_us : 100000.0;
+
+    switch (dc->usage) {
+        case DC_USAGE_OVER:
+            if (now_us - dc->last_decrease_us >= (uint64_t)rtt_us || !dc->last_decrease_us) {
+                double base = dc->acked_bps > 0.0 ? dc->acked_bps : target;
+                if (DC_BETA * base < target) {
+                    target = DC_BETA * base;
+                    if (dc->acked_bps > 0.0)
+                        link_update(dc, dc->acked_bps);
+                    dc->stats.overuse_events++;
+                }
+                dc->last_decrease_us = now_us;
+            }
+            dc->rate_state = RATE_HOLD;
+            return target;
+        case DC_USAGE_UNDER:
+            dc->rate_state = RATE_HOLD;
+            return target;
+        case DC_USAGE_NORMAL:
+            break;
+    }
+
+    if (dc->rate_state == RATE_HOLD) {
+        dc->rate_state = RATE_INCREASE;
+        return target;
+    }
+
+    double link_bps = dc->link_kbps * 1000.0;
+    double sigma_bps = sqrt(dc->link_var * dc->link_kbps) * 1000.0;
+    if (dc->link_known && dc->acked_bps > link_bps + 3.0 * sigma_bps)
+        dc->link_known = false; /* Delivering more than we thought possible */
+
+    if (dc->link_known && target > link_bps - 3.0 * sigma_bps) {
+        /* Near the capacity found at the last drop: about one packet per
+         * response time */
+        double response_s = (rtt_us + RESPONSE_EXTRA_US) / 1e6;
+        double per_s = fmax(dc->avg_packet_bytes * 8.0 / response_s, 4000.0);
+        target += per_s * dt_s;
+    } else {
+        target *= pow(INCREASE_PER_S, dt_s);
+    }
+
+    /* Do not run far ahead of what the path has shown it delivers */
+    if (dc->acked_bps > 0.0 && target > 1.5 * dc->acked_bps + 10000.0)
+        target = fmax(dc->target_bps, 1.5 * dc->acked_bps + 10000.0);
+    return target;
+}
+
+uint32_t delay_controller_on_feedback(delay_controller_t *dc, const tfb_packet_t *pkts, int n,
+                                      uint64_t now_us) {
+    if (!dc)
+        return 0;
+
+    uint64_t newest_send = 0;
+    for (int i = 0; i < n; i++) {
+        const tfb_packet_t *p = &pkts[i];
+        dc->stats.packets++;
+        if (p->arrival_us == 0) {
+            dc->loss_lost++;
+            dc->stats.lost++;
+            continue;
+        }
+        dc->loss_received++;
+        if (p->send_us > newest_send)
+            newest_send = p->send_us;
+        dc->avg_packet_bytes = 0.95 * dc->avg_packet_bytes + 0.05 * p->size;
+        acked_add(dc, p->arrival_us, p->size);
+        group_packet(dc, p);
+    }
+    dc->stats.feedbacks++;
+
+    if (newest_send > 0 && now_us > newest_send)
+        rtt_estimator_update(dc->rtt, now_us - newest_send);
+    acked_update(dc);
+
+    uint32_t loss_total = dc->loss_received + dc->loss_lost;
+    if (!dc->loss_since_us)
+        dc->loss_since_us = now_us;
+    if (loss_total >= LOSS_MIN_PACKETS && now_us - dc->loss_since_us >= LOSS_INTERVAL_US) {
+        dc->loss_fraction = (double)dc->loss_lost / loss_total;
+        dc->loss_received = dc->loss_lost = 0;
+        dc->loss_since_us = now_us;
+    }
+
+    double target = delay_based_target(dc, now_us);
+    if (dc->loss_fraction > DC_LOSS_HIGH) {
+        if (now_us - dc->last_loss_decrease_us >= LOSS_DECREASE_INTERVAL_US ||
+            !dc->last_loss_decrease_us) {
+            target = fmin(target, dc->target_bps * (1.0 - 0.5 * dc->loss_fraction));
+            dc->last_loss_decrease_us = now_us;
+            dc->rate_state = RATE_HOLD;
+            dc->stats.loss_events++;
+        } else {
+            target = fmin(target, dc->target_bps);
+        }
+    } else if (dc->loss_fraction > DC_LOSS_LOW) {
+        target = fmin(target, dc->target_bps);
+    }
+
+    dc->target_bps = clamp_target(dc, target);
+    dc->last_update_us = now_us;
+    return (uint32_t)dc->target_bps;
+}
+
+int delay_controller_get_stats(const delay_controller_t *dc, delay_controller_stats_t *out) {
+    if (!dc || !out)
+        return -1;
+    *out = dc->stats;
+    out->target_bps = (uint32_t)dc->target_bps;
+    out->acked_bps = (uint32_t)dc->acked_bps;
+    out->threshold_ms = dc->threshold_ms;
+    out->usage = dc->usage;
+    out->loss_fraction = dc->loss_fraction;
+    rtt_snapshot_t rtt;
+    rtt_estimator_snapshot(dc->rtt, &rtt);
+    out->rtt_us = rtt.sample_count ? rtt.srtt_us : 0.0;
+    return 0;
+}
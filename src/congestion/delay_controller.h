@@ -0,0 +1,151 @@
+/*
+ * delay_controller.h — Delay-gradient send-rate controller
+ *
+ * Sender-side congestion control in the style of Google Congestion
+ * Control (draft-ietf-rmcat-gcc), driven by transport feedback
+ * (transport_feedback.h):
+ *
+ *   1. Packets sent within DC_BURST_US of each other form a group.  For
+ *      consecutive groups the change in one-way delay (arrival delta
+ *      minus send delta) is accumulated, smoothed and fitted with a
+ *      least-squares trendline over the last DC_TREND_WINDOW groups.
+ *   2. The scaled slope is compared with an adaptive threshold: above
+ *      it for DC_OVERUSE_MS means a queue is building (overuse), below
+ *      its negative that one is draining (underuse).
+ *   3. AIMD on the target: overuse drops it to DC_BETA times the rate
+ *      the receiver actually got; otherwise it grows 8 %/s, or by about
+ *      one packet per round trip once it is near the link capacity
+ *      measured at earlier drops.  It never runs far ahead of the
+ *      acknowledged rate.
+ *   4. Loss caps the result: above DC_LOSS_HIGH the target is cut by
+ *      half the loss fraction, between DC_LOSS_LOW and that it is held.
+ *
+ * The round-trip time used for pacing decisions is the time from a
+ * packet's send to the feedback that reports it, so it includes the
+ * receiver's report interval.
+ *
+ * Thread-safety: NOT thread-safe.
+ */
+
+#ifndef ROOTSTREAM_DELAY_CONTROLLER_H
+#define ROOTSTREAM_DELAY_CONTROLLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "transport_feedback.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DC_BURST_US 5000       /**< Send-time span of one packet group (µs) */
+#define DC_TREND_WINDOW 20     /**< Groups in the trendline fit */
+#define DC_OVERUSE_MS 10.0     /**< Time above threshold before overuse (ms) */
+#define DC_BETA 0.85           /**< Multiplicative decrease factor */
+#define DC_LOSS_HIGH 0.10      /**< Loss fraction that cuts the target */
+#define DC_LOSS_LOW 0.02       /**< Loss fraction that stops increases */
+
+/** Delay signal */
+typedef enum {
+    DC_USAGE_NORMAL = 0, /**< Queues stable */
+    DC_USAGE_OVER = 1,   /**< Queue building: decrease */
+    DC_USAGE_UNDER = 2,  /**< Queue draining: hold */
+} dc_usage_t;
+
+/** Controller configuration */
+typedef struct {
+    uint32_t min_bps;   /**< Lower bound of the target */
+    uint32_t max_bps;   /**< Upper bound of the target */
+    uint32_t start_bps; /**< Initial target */
+} delay_controller_config_t;
+
+/** Controller statistics */
+typedef struct {
+    uint32_t target_bps;     /**< Current target */
+    uint32_t acked_bps;      /**< Receive rate reported back, 0 = not yet known */
+    double trend;            /**< Scaled delay trend (ms) */
+    double threshold_ms;     /**< Adaptive overuse threshold (ms) */
+    dc_usage_t usage;        /**< Last delay signal */
+    double loss_fraction;    /**< Loss over the last loss interval */
+    double rtt_us;           /**< Smoothed send-to-feedback time (µs) */
+    uint64_t feedbacks;      /**< Reports processed */
+    uint64_t packets;        /**< Packets reported */
+    uint64_t lost;           /**< Packets reported lost */
+    uint64_t overuse_events; /**< Delay-based decreases */
+    uint64_t loss_events;    /**< Loss-based decreases */
+} delay_controller_stats_t;
+
+/** Opaque controller */
+typedef struct delay_controller_s delay_controller_t;
+
+/**
+ * delay_controller_create — allocate controller
+ *
+ * @param config  Bounds and initial target (start is clamped to them)
+ * @return        Non-NULL handle, or NULL on invalid config / OOM
+ */
+delay_controller_t *delay_controller_create(const delay_controller_config_t *config);
+
+/**
+ * delay_controller_destroy — free controller
+ *
+ * @param dc  Controller to destroy
+ */
+void delay_controller_destroy(delay_controller_t *dc);
+
+/**
+ * delay_controller_reset — drop delay and loss history, keep the target
+ *
+ * @param dc  Controller
+ */
+void delay_controller_reset(delay_controller_t *dc);
+
+/**
+ * delay_controller_set_bounds — change the target range
+ *
+ * @param dc       Controller
+ * @param min_bps  Lower bound
+ * @param max_bps  Upper bound (>= min_bps)
+ * @return         0 on success, -1 on invalid args
+ */
+int delay_controller_set_bounds(delay_controller_t *dc, uint32_t min_bps, uint32_t max_bps);
+
+/**
+ * delay_controller_on_feedback — process one feedback report
+ *
+ * @pkts must be in sequence order with send_us and size filled in;
+ * entries the sender no longer knows should be left out.
+ *
+ * @param dc      Controller
+ * @param pkts    Reported packets
+ * @param n       Number of packets
+ * @param now_us  Current time on the send clock
+ * @return        New target (bits/sec)
+ */
+uint32_t delay_controller_on_feedback(delay_controller_t *dc, const tfb_packet_t *pkts, int n,
+                                      uint64_t now_us);
+
+/**
+ * delay_controller_target_bps — current target
+ *
+ * @param dc  Controller
+ * @return    Target (bits/sec), 0 if @dc is NULL
+ */
+uint32_t delay_controller_target_bps(const delay_controller_t *dc);
+
+/**
+ * delay_controller_get_stats — copy statistics
+ *
+ * @param dc   Controller
+ * @param out  Output
+ * @return     0 on success, -1 on NULL
+ */
+int delay_controller_get_stats(const delay_controller_t *dc, delay_controller_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_DELAY_CONTROLLER_H */
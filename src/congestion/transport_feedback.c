@@ -0,0 +1,296 @@
+/*
+ * transport_feedback.c — Transport-wide receiver feedback
+ */
+
+#include "transport_feedback.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDER_MASK ((uint64_t)TFB_RECORDER_SIZE - 1)
+#define HISTORY_MASK ((uint64_t)TFB_HISTORY_SIZE - 1)
+#define RUN_RECEIVED 0x8000u
+#define RUN_MAX 0x7FFFu
+#define VARINT_MAX 10
+
+struct tfb_recorder_s {
+    uint64_t seq[TFB_RECORDER_SIZE]; /* Sequence number + 1 held by each slot, 0 = none */
+    uint64_t arrival_us[TFB_RECORDER_SIZE];
+    uint64_t base;    /* First sequence number not yet reported */
+    uint64_t highest; /* Highest sequence number seen */
+    bool started;
+    uint8_t fb_count;
+};
+
+/* Seqlock per slot: seq is 0 while the slot is being rewritten */
+typedef struct {
+    atomic_uint_fast64_t seq;  /* Sequence number + 1 */
+    atomic_uint_fast64_t sent; /* send_us << 16 | size */
+} history_slot_t;
+
+struct tfb_history_s {
+    history_slot_t slots[TFB_HISTORY_SIZE];
+};
+
+/* ── Wire helpers ────────────────────────────────────────────────── */
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = v << 8 | p[i];
+    return v;
+}
+
+static size_t put_varint(uint8_t *p, int64_t v) {
+    uint64_t z = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); /* zigzag */
+    size_t n = 0;
+    while (z >= 0x80) {
+        p[n++] = (uint8_t)(z | 0x80);
+        z >>= 7;
+    }
+    p[n++] = (uint8_t)z;
+    return n;
+}
+
+/* Returns bytes consumed, 0 if truncated or overlong */
+static size_t get_varint(const uint8_t *p, const uint8_t *end, int64_t *v) {
+    uint64_t z = 0;
+    for (size_t n = 0; n < VARINT_MAX && p + n < end; n++) {
+        z |= (uint64_t)(p[n] & 0x7F) << (7 * n);
+        if (!(p[n] & 0x80)) {
+            *v = (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/* ── Recorder ────────────────────────────────────────────────────── */
+
+tfb_recorder_t *tfb_recorder_create(void) {
+    return calloc(1, sizeof(tfb_recorder_t));
+}
+
+void tfb_recorder_destroy(tfb_recorder_t *r) {
+    free(r);
+}
+
+void tfb_recorder_reset(tfb_recorder_t *r) {
+    if (!r)
+        return;
+    memset(r, 0, sizeof(*r));
+}
+
+static bool recorder_has(const tfb_recorder_t *r, uint64_t seq) {
+    return r->seq[seq & RECORDER_MASK] == seq + 1;
+}
+
+void tfb_recorder_on_packet(tfb_recorder_t *r, uint64_t seq, uint64_t arrival_us) {
+    if (!r || arrival_us == 0)
+        return;
+
+    if (!r->started) {
+        r->base = seq;
+        r->highest = seq;
+        r->started = true;
+    }
+    if (seq < r->base)
+        return; /* Already reported */
+    if (seq - r->base >= TFB_RECORDER_SIZE)
+        r->base = seq - TFB_RECORDER_SIZE + 1; /* Older slots are overwritten unreported */
+
+    r->seq[seq & RECORDER_MASK] = seq + 1;
+    r->arrival_us[seq & RECORDER_MASK] = arrival_us;
+    if (seq > r->highest)
+        r->highest = seq;
+}
+
+/*
+ * End (exclusive) of the range that can be reported at @now_us
+ *
+ * A gap is settled once a later packet has been in for TFB_REORDER_US;
+ * the range stops at the first gap that is not.
+ */
+static uint64_t recorder_settled_end(const tfb_recorder_t *r, uint64_t now_us) {
+    uint64_t s = r->base;
+    for (uint64_t t = r->highest + 1; t-- > r->base;) {
+        if (recorder_has(r, t) && r->arrival_us[t & RECORDER_MASK] + TFB_REORDER_US <= now_us) {
+            s = t + 1;
+            break;
+        }
+    }
+    while (s <= r->highest && recorder_has(r, s))
+        s++;
+    return s;
+}
+
+size_t tfb_recorder_build(tfb_recorder_t *r, uint64_t now_us, uint8_t *buf, size_t cap) {
+    if (!r || !buf || !r->started || r->highest < r->base)
+        return 0;
+
+    uint64_t stop = recorder_settled_end(r, now_us);
+    uint16_t runs[TFB_MAX_PACKETS];
+    uint8_t deltas[TFB_MAX_PACKETS * VARINT_MAX];
+    size_t nruns = 0, dlen = 0;
+    bool run_rx = false;
+    uint64_t ref = 0;
+    int64_t prev_q = 0;
+
+    uint64_t s = r->base;
+    for (; s < stop && s - r->base < TFB_MAX_PACKETS; s++) {
+        bool rx = recorder_has(r, s);
+        uint8_t v[VARINT_MAX];
+        size_t vlen = 0;
+        int64_t q = 0;
+        uint64_t at = r->arrival_us[s & RECORDER_MASK];
+        if (rx) {
+            q = ref == 0 ? 0 : floor_div((int64_t)at - (int64_t)ref, TFB_TICK_US);
+            vlen = put_varint(v, q - prev_q);
+        }
+
+        uint16_t last = nruns > 0 ? runs[nruns - 1] : 0;
+        bool new_run = nruns == 0 || rx != run_rx || (last & RUN_MAX) == RUN_MAX;
+        size_t need = TFB_HEADER_SIZE + 2 * (nruns + (new_run ? 1 : 0)) + dlen + vlen;
+        if (need > cap)
+            break;
+
+        if (new_run) {
+            runs[nruns++] = (uint16_t)((rx ? RUN_RECEIVED : 0) | 1);
+            run_rx = rx;
+        } else {
+            runs[nruns - 1]++;
+        }
+        if (rx) {
+            if (ref == 0)
+                ref = at;
+            memcpy(deltas + dlen, v, vlen);
+            dlen += vlen;
+            prev_q = q;
+        }
+    }
+
+    size_t count = (size_t)(s - r->base);
+    if (count == 0)
+        return 0;
+
+    put_le64(buf, r->base);
+    put_le64(buf + 8, ref);
+    put_le16(buf + 16, (uint16_t)count);
+    put_le16(buf + 18, (uint16_t)nruns);
+    buf[20] = r->fb_count++;
+    for (size_t i = 0; i < nruns; i++)
+        put_le16(buf + TFB_HEADER_SIZE + 2 * i, runs[i]);
+    memcpy(buf + TFB_HEADER_SIZE + 2 * nruns, deltas, dlen);
+
+    r->base = s;
+    return TFB_HEADER_SIZE + 2 * nruns + dlen;
+}
+
+/* ── Parser ──────────────────────────────────────────────────────── */
+
+int tfb_parse(const uint8_t *buf, size_t len, tfb_packet_t *pkts, int max_pkts) {
+    if (!buf || !pkts || len < TFB_HEADER_SIZE)
+        return -1;
+
+    uint64_t base = get_le64(buf);
+    uint64_t ref = get_le64(buf + 8);
+    int count = get_le16(buf + 16);
+    size_t nruns = get_le16(buf + 18);
+    if (count > max_pkts || len < TFB_HEADER_SIZE + 2 * nruns)
+        return -1;
+
+    const uint8_t *d = buf + TFB_HEADER_SIZE + 2 * nruns;
+    const uint8_t *end = buf + len;
+    int n = 0;
+    int64_t q = 0;
+    for (size_t i = 0; i < nruns; i++) {
+        uint16_t run = get_le16(buf + TFB_HEADER_SIZE + 2 * i);
+        int run_len = run & RUN_MAX;
+        if (run_len == 0 || n + run_len > count)
+            return -1;
+
+        for (int j = 0; j < run_len; j++, n++) {
+            pkts[n] = (tfb_packet_t){.seq = base + (uint64_t)n};
+            if (!(run & RUN_RECEIVED))
+                continue;
+
+            int64_t delta;
+            size_t used = get_varint(d, end, &delta);
+            if (used == 0 || delta > (INT64_C(1) << 40) || delta < -(INT64_C(1) << 40))
+                return -1;
+            d += used;
+            q += delta;
+            int64_t at = (int64_t)ref + q * TFB_TICK_US;
+            if (at <= 0)
+                return -1;
+            pkts[n].arrival_us = (uint64_t)at;
+        }
+    }
+    return n == count && d == end ? n : -1;
+}
+
+/* ── Send history ────────────────────────────────────────────────── */
+
+tfb_history_t *tfb_history_create(void) {
+    return calloc(1, sizeof(tfb_history_t)); /* All-zero slots are empty */
+}
+
+void tfb_history_destroy(tfb_history_t *h) {
+    free(h);
+}
+
+void tfb_history_reset(tfb_history_t *h) {
+    if (!h)
+        return;
+    for (size_t i = 0; i < TFB_HISTORY_SIZE; i++)
+        atomic_store_explicit(&h->slots[i].seq, 0, memory_order_relaxed);
+}
+
+void tfb_history_record(tfb_history_t *h, uint64_t seq, uint64_t send_us, uint32_t size) {
+    if (!h)
+        return;
+    history_slot_t *slot = &h->slots[seq & HISTORY_MASK];
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&slot->sent, send_us << 16 | (size > 0xFFFF ? 0xFFFF : size),
+                          memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+}
+
+bool tfb_history_lookup(const tfb_history_t *h, uint64_t seq, uint64_t *send_us,
+                        uint32_t *size) {
+    if (!h)
+        return false;
+    history_slot_t *slot = (history_slot_t *)&h->slots[seq & HISTORY_MASK];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq + 1)
+        return false;
+    uint64_t sent = atomic_load_explicit(&slot->sent, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq + 1)
+        return false;
+
+    if (send_us)
+        *send_us = sent >> 16;
+    if (size)
+        *size = (uint32_t)(sent & 0xFFFF);
+    return true;
+}
@@ -0,0 +1,181 @@
+/*
+ * transport_feedback.h — Transport-wide receiver feedback
+ *
+ * Every packet sent to a peer carries a per-peer sequence number: the
+ * nonce in packet_header_t, which the sender increments once per sealed
+ * packet whatever its type.  The receiver records when each sequence
+ * number arrived (tfb_recorder) and periodically reports back with one
+ * compact feedback payload:
+ *
+ *   offset  size  field
+ *   0       8     base_seq      first sequence number covered
+ *   8       8     ref_time_us   arrival of the first received packet
+ *   16      2     packet_count  sequence numbers covered
+ *   18      2     run_count     status runs that follow
+ *   20      1     fb_count      report counter (wraps)
+ *   21      2×n   runs          bit 15 = received, bits 0-14 = length
+ *   ...     var   deltas        one per received packet
+ *
+ * All integers are little-endian.  Deltas are zigzag LEB128 varints in
+ * TFB_TICK_US units between consecutive received packets in sequence
+ * order (the first relative to ref_time_us), so a reordered packet
+ * costs a negative delta rather than a loss; a typical delta is one
+ * byte.  Arrival times are on the receiver's clock, only their
+ * differences mean anything to the sender.
+ *
+ * A gap in the sequence is reported as lost only once a later packet
+ * has been in for TFB_REORDER_US, so packets overtaken in flight (for
+ * example by a frame's reserved nonces, see network.c) are not.
+ *
+ * The sender keeps a tfb_history of when it sent each sequence number
+ * and joins the two into tfb_packet_t results for the congestion
+ * controller.
+ *
+ * Thread-safety: the recorder is NOT thread-safe.  tfb_history_record()
+ * may run concurrently for distinct sequence numbers while one thread
+ * looks entries up or resets the history.
+ */
+
+#ifndef ROOTSTREAM_TRANSPORT_FEEDBACK_H
+#define ROOTSTREAM_TRANSPORT_FEEDBACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TFB_TICK_US 250          /**< Arrival time resolution (µs) */
+#define TFB_REORDER_US 10000     /**< Gap age before it is reported lost (µs) */
+#define TFB_MAX_PACKETS 1024     /**< Sequence numbers per feedback payload */
+#define TFB_HEADER_SIZE 21       /**< Fixed part of a feedback payload */
+#define TFB_RECORDER_SIZE 8192   /**< Arrivals the receiver tracks */
+#define TFB_HISTORY_SIZE 8192    /**< Sends the sender remembers */
+
+/** One packet of a feedback report */
+typedef struct {
+    uint64_t seq;        /**< Transport sequence number */
+    uint64_t send_us;    /**< Sender clock (filled from the history) */
+    uint64_t arrival_us; /**< Receiver clock, 0 = lost */
+    uint32_t size;       /**< Bytes on the wire (filled from the history) */
+} tfb_packet_t;
+
+/** Opaque receiver-side arrival recorder */
+typedef struct tfb_recorder_s tfb_recorder_t;
+
+/** Opaque sender-side send history */
+typedef struct tfb_history_s tfb_history_t;
+
+/**
+ * tfb_recorder_create — allocate recorder
+ *
+ * @return  Non-NULL handle, or NULL on OOM
+ */
+tfb_recorder_t *tfb_recorder_create(void);
+
+/**
+ * tfb_recorder_destroy — free recorder
+ *
+ * @param r  Recorder to destroy
+ */
+void tfb_recorder_destroy(tfb_recorder_t *r);
+
+/**
+ * tfb_recorder_reset — forget all arrivals (the sender restarted its
+ * sequence numbers)
+ *
+ * @param r  Recorder
+ */
+void tfb_recorder_reset(tfb_recorder_t *r);
+
+/**
+ * tfb_recorder_on_packet — record one arrival
+ *
+ * Packets older than the last report are dropped; a packet more than
+ * TFB_RECORDER_SIZE ahead of it skips the sequence numbers in between.
+ *
+ * @param r           Recorder
+ * @param seq         Transport sequence number
+ * @param arrival_us  Receive time, > 0
+ */
+void tfb_recorder_on_packet(tfb_recorder_t *r, uint64_t seq, uint64_t arrival_us);
+
+/**
+ * tfb_recorder_build — encode the next feedback payload
+ *
+ * Covers up to TFB_MAX_PACKETS sequence numbers that are either in or
+ * settled as lost at @now_us, and as many as fit in @cap bytes.  Call
+ * again until it returns 0 to drain a backlog.
+ *
+ * @param r       Recorder
+ * @param now_us  Current time on the arrival clock
+ * @param buf     Output buffer
+ * @param cap     Buffer size (at least TFB_HEADER_SIZE + 16)
+ * @return        Payload length, 0 if there is nothing to report
+ */
+size_t tfb_recorder_build(tfb_recorder_t *r, uint64_t now_us, uint8_t *buf, size_t cap);
+
+/**
+ * tfb_parse — decode a feedback payload
+ *
+ * Fills seq and arrival_us (0 for lost packets) of one entry per
+ * sequence number covered; send_us and size are zeroed.
+ *
+ * @param buf       Payload
+ * @param len       Payload length
+ * @param pkts      Output array
+ * @param max_pkts  Capacity of @pkts (TFB_MAX_PACKETS always suffices)
+ * @return          Entries written, or -1 if the payload is malformed
+ */
+int tfb_parse(const uint8_t *buf, size_t len, tfb_packet_t *pkts, int max_pkts);
+
+/**
+ * tfb_history_create — allocate send history
+ *
+ * @return  Non-NULL handle, or NULL on OOM
+ */
+tfb_history_t *tfb_history_create(void);
+
+/**
+ * tfb_history_destroy — free send history
+ *
+ * @param h  History to destroy
+ */
+void tfb_history_destroy(tfb_history_t *h);
+
+/**
+ * tfb_history_reset — forget all sends
+ *
+ * @param h  History
+ */
+void tfb_history_reset(tfb_history_t *h);
+
+/**
+ * tfb_history_record — remember one send
+ *
+ * @param h        History
+ * @param seq      Transport sequence number
+ * @param send_us  Send time (< 2^48)
+ * @param size     Bytes on the wire
+ */
+void tfb_history_record(tfb_history_t *h, uint64_t seq, uint64_t send_us, uint32_t size);
+
+/**
+ * tfb_history_lookup — find a send
+ *
+ * @param h        History
+ * @param seq      Transport sequence number
+ * @param send_us  Out: send time
+ * @param size     Out: bytes on the wire
+ * @return         true if @seq is still in the history
+ */
+bool tfb_history_lookup(const tfb_history_t *h, uint64_t seq, uint64_t *send_us,
+                        uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_TRANSPORT_FEEDBACK_H */
@@ -98,10 +98,7 @@ void rootstream_cleanup(rootstream_ctx_t *ctx) {
     latency_cleanup(&ctx->latency);
 
     /* Close network socket */
-    if (ctx->sock_fd != RS_INVALID_SOCKET) {
-        rs_socket_close(ctx->sock_fd);
-        ctx->sock_fd = RS_INVALID_SOCKET;
-    }
+    rootstream_net_cleanup(ctx);
 
     printf("✓ Cleanup complete\n");
 }
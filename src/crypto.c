@@ -431,6 +431,48 @@ int crypto_create_session(crypto_session_t *session, const uint8_t *my_secret,
     return 0;
 }
 
+/*
+ * Salt a session with the two handshake nonces
+ *
+ * @param session  Session from crypto_create_session()
+ * @param nonce_a  One side's CRYPTO_SESSION_NONCE_BYTES random nonce
+ * @param nonce_b  The other side's nonce (order does not matter)
+ * @return         0 on success, -1 on error
+ *
+ * The X25519 secret of two identities never changes, so every session
+ * between them would otherwise share one key and restart its nonce
+ * counter at 0: packets captured from an earlier session would decrypt
+ * again.  Hashing both sides' fresh nonces into the key gives each
+ * handshake its own key.  The nonces are hashed in byte order so both
+ * sides get the same key whichever of them initiated.
+ */
+int crypto_salt_session(crypto_session_t *session, const uint8_t *nonce_a,
+                        const uint8_t *nonce_b) {
+    if (!session || !nonce_a || !nonce_b) {
+        fprintf(stderr, "ERROR: Invalid arguments to crypto_salt_session\n");
+        return -1;
+    }
+
+    bool a_first = memcmp(nonce_a, nonce_b, CRYPTO_SESSION_NONCE_BYTES) <= 0;
+    uint8_t input[CRYPTO_SHARED_KEY_BYTES + 2 * CRYPTO_SESSION_NONCE_BYTES];
+    memcpy(input, session->shared_key, CRYPTO_SHARED_KEY_BYTES);
+    memcpy(input + CRYPTO_SHARED_KEY_BYTES, a_first ? nonce_a : nonce_b,
+           CRYPTO_SESSION_NONCE_BYTES);
+    memcpy(input + CRYPTO_SHARED_KEY_BYTES + CRYPTO_SESSION_NONCE_BYTES,
+           a_first ? nonce_b : nonce_a, CRYPTO_SESSION_NONCE_BYTES);
+
+    int ret = crypto_generichash(session->shared_key, CRYPTO_SHARED_KEY_BYTES, input,
+                                 sizeof(input), NULL, 0);
+    sodium_memzero(input, sizeof(input));
+    if (ret != 0) {
+        fprintf(stderr, "ERROR: Session key derivation failed\n");
+        return -1;
+    }
+
+    session->nonce_counter = 0;
+    return 0;
+}
+
 /*
  * Encrypt packet using ChaCha20-Poly1305
  *
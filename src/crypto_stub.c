@@ -73,6 +73,15 @@ int crypto_create_session(crypto_session_t *session, const uint8_t *my_secret,
     return -1;
 }
 
+int crypto_salt_session(crypto_session_t *session, const uint8_t *nonce_a,
+                        const uint8_t *nonce_b) {
+    (void)session;
+    (void)nonce_a;
+    (void)nonce_b;
+    fprintf(stderr, "ERROR: crypto_salt_session unavailable (NO_CRYPTO build)\n");
+    return -1;
+}
+
 int crypto_encrypt_packet(const crypto_session_t *session, const void *plaintext, size_t plain_len,
                           void *ciphertext, size_t *cipher_len, uint64_t nonce) {
     (void)session;
@@ -16,6 +16,7 @@
 #include <string.h>
 
 #include "../include/rootstream.h"
+#include "input/input_batch.h"
 
 /* SDL2 headers */
 #include <SDL2/SDL.h>
@@ -30,25 +31,61 @@ typedef struct {
     int width;
     int height;
     bool initialized;
+
+    /* Input collected during one display_poll_events() */
+    input_batch_t input;
+    uint16_t input_seq;
 } sdl2_display_ctx_t;
 
+/* First connected peer (typically there's only one for client) */
+static peer_t *input_peer(rootstream_ctx_t *ctx) {
+    for (int i = 0; i < ctx->num_peers; i++) {
+        if (ctx->peers[i].state == PEER_CONNECTED) {
+            return &ctx->peers[i];
+        }
+    }
+    return NULL;
+}
+
+/* Send the collected input as one PKT_INPUT_BATCH */
+static void flush_input_batch(rootstream_ctx_t *ctx, sdl2_display_ctx_t *disp) {
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    peer_t *peer = input_peer(ctx);
+
+    size_t len = input_batch_encode(&disp->input, disp->input_seq, get_timestamp_us(), payload,
+                                    sizeof(payload));
+    if (peer && len > 0) {
+        rootstream_net_send_encrypted(ctx, peer, PKT_INPUT_BATCH, payload, len);
+        disp->input_seq++;
+    }
+    input_batch_reset(&disp->input);
+}
+
 /* Forward SDL2 input event to host */
 static void forward_input_event(rootstream_ctx_t *ctx, uint8_t type, uint16_t code, int32_t value) {
     if (!ctx || ctx->num_peers == 0) {
         return;
     }
 
-    /* Create input event packet */
-    input_event_pkt_t event_pkt = {.type = type, .code = code, .value = value};
+    peer_t *peer = input_peer(ctx);
+    if (!peer) {
+        return;
+    }
 
-    /* Send to first connected peer (typically there's only one for client) */
-    for (int i = 0; i < ctx->num_peers; i++) {
-        peer_t *peer = &ctx->peers[i];
-        if (peer->state == PEER_CONNECTED) {
-            rootstream_net_send_encrypted(ctx, peer, PKT_INPUT, &event_pkt, sizeof(event_pkt));
-            break;
+    /* Hosts that take batches get the event with the rest of this poll's */
+    sdl2_display_ctx_t *disp = (sdl2_display_ctx_t *)ctx->tray.gtk_app;
+    if (disp && (peer->protocol_flags & PROTOCOL_FLAG_INPUT_BATCH)) {
+        uint64_t now = get_timestamp_us();
+        if (input_batch_add(&disp->input, type, code, value, now) < 0) {
+            flush_input_batch(ctx, disp);
+            input_batch_add(&disp->input, type, code, value, now);
         }
+        return;
     }
+
+    /* Create input event packet */
+    input_event_pkt_t event_pkt = {.type = type, .code = code, .value = value};
+    rootstream_net_send_encrypted(ctx, peer, PKT_INPUT, &event_pkt, sizeof(event_pkt));
 }
 
 /* Convert SDL2 keycode to Linux key code */
@@ -174,6 +211,7 @@ int display_init(rootstream_ctx_t *ctx, const char *title, int width, int height
         return -1;
     }
 
+    input_batch_init(&disp->input, ctx->settings.input_coalesce);
     disp->initialized = true;
 
     /* Store display context (reuse tray context pointer) */
@@ -318,6 +356,12 @@ int display_poll_events(rootstream_ctx_t *ctx) {
         }
     }
 
+    /* Everything from this poll leaves in one packet */
+    sdl2_display_ctx_t *disp = ctx ? (sdl2_display_ctx_t *)ctx->tray.gtk_app : NULL;
+    if (disp && disp->input.count > 0) {
+        flush_input_batch(ctx, disp);
+    }
+
     return 0;
 }
 
@@ -4,6 +4,14 @@
  * This is what makes us better than PipeWire/Steam Remote Play.
  * We read directly from the kernel's DRM subsystem, bypassing all
  * the compositor/portal nonsense that constantly breaks.
+ *
+ * Each frame asks the CRTC which framebuffer it is scanning out.
+ * Mappings are kept per framebuffer ID (fb_cache), so the GETFB /
+ * MAP_DUMB / mmap sequence only runs when the compositor flips to a
+ * buffer we have not seen yet.  Buffers that are not dumb buffers are
+ * exported with PRIME and read through the dmabuf.  With zero-copy
+ * capture enabled the frame is handed out as that dmabuf instead of
+ * being copied.
  */
 
 #include <dirent.h>
@@ -18,7 +26,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <linux/dma-buf.h>
+
 #include "../include/rootstream.h"
+#include "fbcache/fb_cache.h"
 
 /* DRM kernel headers */
 #include <drm/drm.h>
@@ -195,6 +206,129 @@ int rootstream_select_display(rootstream_ctx_t *ctx, int display_index) {
     return 0;
 }
 
+/* Mapped scanout buffers of the display being captured */
+static struct {
+    fb_cache_t *fbs;
+    int fd;
+    uint32_t crtc_id; /* 0 = unknown, capture display.fb_id */
+} drm_state = {NULL, -1, 0};
+
+/* fb_cache release callback: drop the GEM handle GETFB gave us */
+static void release_gem_handle(const fb_cache_entry_t *fb, void *user) {
+    (void)user;
+    if (fb->handle) {
+        struct drm_gem_close req = {0};
+        req.handle = fb->handle;
+        ioctl(drm_state.fd, DRM_IOCTL_GEM_CLOSE, &req);
+    }
+}
+
+/*
+ * Find the CRTC driving the display
+ *
+ * rootstream_detect_displays() stores the connector's encoder ID in
+ * crtc_id; the encoder tells us the CRTC.
+ */
+static uint32_t resolve_crtc(const display_info_t *display) {
+    struct drm_mode_get_encoder enc = {0};
+    enc.encoder_id = display->crtc_id;
+    if (enc.encoder_id && ioctl(display->fd, DRM_IOCTL_MODE_GETENCODER, &enc) == 0 &&
+        enc.crtc_id) {
+        return enc.crtc_id;
+    }
+
+    struct drm_mode_crtc crtc = {0};
+    crtc.crtc_id = display->crtc_id;
+    if (crtc.crtc_id && ioctl(display->fd, DRM_IOCTL_MODE_GETCRTC, &crtc) == 0) {
+        return crtc.crtc_id;
+    }
+    return 0;
+}
+
+/*
+ * Framebuffer the CRTC is scanning out right now
+ */
+static uint32_t scanout_fb(const display_info_t *display) {
+    if (drm_state.crtc_id) {
+        struct drm_mode_crtc crtc = {0};
+        crtc.crtc_id = drm_state.crtc_id;
+        if (ioctl(display->fd, DRM_IOCTL_MODE_GETCRTC, &crtc) == 0 && crtc.fb_id) {
+            return crtc.fb_id;
+        }
+    }
+    return display->fb_id;
+}
+
+/*
+ * Map a framebuffer we have not seen before and add it to the cache
+ */
+static fb_cache_entry_t *map_fb(rootstream_ctx_t *ctx, uint32_t fb_id) {
+    int fd = ctx->display.fd;
+
+    struct drm_mode_fb_cmd fb_cmd = {0};
+    fb_cmd.fb_id = fb_id;
+    if (ioctl(fd, DRM_IOCTL_MODE_GETFB, &fb_cmd) < 0) {
+        set_error("Cannot get framebuffer %u info: %s", fb_id, strerror(errno));
+        return NULL;
+    }
+    if (fb_cmd.handle == 0) {
+        set_error("Framebuffer %u has no handle (needs DRM master or CAP_SYS_ADMIN)", fb_id);
+        return NULL;
+    }
+
+    fb_cache_entry_t fb = {0};
+    fb.fb_id = fb_id;
+    fb.width = fb_cmd.width;
+    fb.height = fb_cmd.height;
+    fb.pitch = fb_cmd.pitch;
+    fb.format = FRAME_FORMAT_BGRA; /* XRGB8888 / ARGB8888 are B,G,R,X in memory */
+    fb.handle = fb_cmd.handle;
+    fb.dmabuf_fd = -1;
+    fb.map_size = (size_t)fb_cmd.pitch * fb_cmd.height;
+
+    if (fb_cmd.bpp != 32 || (fb_cmd.depth != 24 && fb_cmd.depth != 32)) {
+        set_error("Unsupported framebuffer %u layout (bpp %u, depth %u)", fb_id, fb_cmd.bpp,
+                  fb_cmd.depth);
+        release_gem_handle(&fb, NULL);
+        return NULL;
+    }
+
+    /* Dumb buffers map through the card fd */
+    struct drm_mode_map_dumb map_req = {0};
+    map_req.handle = fb.handle;
+    if (ioctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map_req) == 0) {
+        void *map = mmap(NULL, fb.map_size, PROT_READ, MAP_SHARED, fd, map_req.offset);
+        if (map != MAP_FAILED) {
+            fb.map = map;
+        }
+    }
+
+    /* Everything else, and every zero-copy frame, goes through PRIME */
+    if (!fb.map || ctx->settings.zero_copy_capture) {
+        struct drm_prime_handle prime = {0};
+        prime.handle = fb.handle;
+        prime.flags = DRM_CLOEXEC;
+        prime.fd = -1;
+        if (ioctl(fd, DRM_IOCTL_PRIME_HANDLE_TO_FD, &prime) == 0) {
+            fb.dmabuf_fd = prime.fd;
+            if (!fb.map) {
+                void *map = mmap(NULL, fb.map_size, PROT_READ, MAP_SHARED, prime.fd, 0);
+                if (map != MAP_FAILED) {
+                    fb.map = map;
+                }
+            }
+        }
+    }
+
+    if (!fb.map && fb.dmabuf_fd < 0) {
+        set_error("Cannot map framebuffer %u: %s", fb_id, strerror(errno));
+        release_gem_handle(&fb, NULL);
+        return NULL;
+    }
+
+    return fb_cache_put(drm_state.fbs, &fb);
+}
+
 /*
  * Initialize DRM/KMS capture for a specific display
  */
@@ -204,36 +338,57 @@ int rootstream_capture_init_drm(rootstream_ctx_t *ctx) {
         return -1;
     }
 
-    /* Get current framebuffer info */
-    struct drm_mode_card_res res = {0};
-    if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
-        set_error("Cannot get DRM resources: %s", strerror(errno));
-        return -1;
-    }
+    drm_state.fd = ctx->display.fd;
+    drm_state.crtc_id = resolve_crtc(&ctx->display);
 
-    if (res.count_fbs == 0) {
-        set_error("No framebuffers available");
-        return -1;
-    }
+    /* Prefer what the CRTC scans out; fall back to the first listed FB */
+    ctx->display.fb_id = 0;
+    ctx->display.fb_id = scanout_fb(&ctx->display);
+    if (ctx->display.fb_id == 0) {
+        struct drm_mode_card_res res = {0};
+        if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+            set_error("Cannot get DRM resources: %s", strerror(errno));
+            return -1;
+        }
 
-    /* Get first framebuffer (active display) */
-    uint32_t *fbs = calloc(res.count_fbs, sizeof(uint32_t));
-    res.fb_id_ptr = (uint64_t)fbs;
+        if (res.count_fbs == 0) {
+            set_error("No framebuffers available");
+            return -1;
+        }
+
+        uint32_t *fbs = calloc(res.count_fbs, sizeof(uint32_t));
+        if (!fbs) {
+            set_error("Cannot allocate framebuffer list");
+            return -1;
+        }
+        res.count_connectors = 0;
+        res.count_crtcs = 0;
+        res.count_encoders = 0;
+        res.fb_id_ptr = (uint64_t)fbs;
 
-    if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+        if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_GETRESOURCES, &res) < 0) {
+            free(fbs);
+            set_error("Cannot get framebuffer IDs: %s", strerror(errno));
+            return -1;
+        }
+
+        ctx->display.fb_id = fbs[0];
         free(fbs);
-        set_error("Cannot get framebuffer IDs: %s", strerror(errno));
-        return -1;
     }
 
-    ctx->display.fb_id = fbs[0];
-    free(fbs);
+    drm_state.fbs = fb_cache_create(FB_CACHE_MAX_ENTRIES, release_gem_handle, NULL);
+    if (!drm_state.fbs) {
+        set_error("Cannot allocate framebuffer cache");
+        return -1;
+    }
 
     /* Allocate frame buffer */
     size_t frame_size = ctx->display.width * ctx->display.height * 4; /* RGBA */
     ctx->current_frame.data = malloc(frame_size);
     if (!ctx->current_frame.data) {
         set_error("Cannot allocate frame buffer");
+        fb_cache_destroy(drm_state.fbs);
+        drm_state.fbs = NULL;
         return -1;
     }
 
@@ -241,10 +396,11 @@ int rootstream_capture_init_drm(rootstream_ctx_t *ctx) {
     ctx->current_frame.height = ctx->display.height;
     ctx->current_frame.size = frame_size;
     ctx->current_frame.capacity = frame_size;
-    ctx->current_frame.format = 0x34325258; /* DRM_FORMAT_XRGB8888 */
+    ctx->current_frame.format = FRAME_FORMAT_BGRA;
 
-    printf("✓ DRM capture initialized: %dx%d @ %d Hz\n", ctx->display.width, ctx->display.height,
-           ctx->display.refresh_rate);
+    printf("✓ DRM capture initialized: %dx%d @ %d Hz%s\n", ctx->display.width,
+           ctx->display.height, ctx->display.refresh_rate,
+           ctx->settings.zero_copy_capture ? " (zero-copy)" : "");
 
     return 0;
 }
@@ -254,50 +410,76 @@ int rootstream_capture_init_drm(rootstream_ctx_t *ctx) {
  * This is the magic - no compositor involved!
  */
 int rootstream_capture_frame_drm(rootstream_ctx_t *ctx, frame_buffer_t *frame) {
-    if (!ctx || !frame) {
+    if (!ctx || !frame || !drm_state.fbs) {
         set_error("Invalid arguments");
         return -1;
     }
 
-    /* Get framebuffer info */
-    struct drm_mode_fb_cmd fb_cmd = {0};
-    fb_cmd.fb_id = ctx->display.fb_id;
-
-    if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_GETFB, &fb_cmd) < 0) {
-        set_error("Cannot get framebuffer info: %s", strerror(errno));
-        return -1;
+    /* Follow page flips; only a buffer we have not mapped yet costs ioctls */
+    uint32_t fb_id = scanout_fb(&ctx->display);
+    fb_cache_entry_t *fb = fb_cache_get(drm_state.fbs, fb_id);
+    if (!fb) {
+        fb = map_fb(ctx, fb_id);
+        if (!fb) {
+            return -1;
+        }
     }
 
-    /* Map the framebuffer into our address space */
-    struct drm_mode_map_dumb map_req = {0};
-    map_req.handle = fb_cmd.handle;
+    uint32_t width = fb->width < ctx->display.width ? fb->width : ctx->display.width;
+    uint32_t height = fb->height < ctx->display.height ? fb->height : ctx->display.height;
+
+    if (ctx->settings.zero_copy_capture && fb->dmabuf_fd >= 0) {
+        /* Hand out the scanout buffer itself */
+        frame->memory = FRAME_MEMORY_DMABUF;
+        frame->dmabuf_fd = fb->dmabuf_fd;
+        frame->mapped = fb->map;
+        frame->pitch = fb->pitch;
+        frame->size = fb->pitch * height;
+    } else {
+        size_t row_bytes = (size_t)width * 4;
+        if (!fb->map || row_bytes * height > frame->capacity) {
+            set_error("Framebuffer %u cannot be copied into a %u byte frame", fb_id,
+                      frame->capacity);
+            return -1;
+        }
 
-    if (ioctl(ctx->display.fd, DRM_IOCTL_MODE_MAP_DUMB, &map_req) < 0) {
-        set_error("Cannot map framebuffer: %s", strerror(errno));
-        return -1;
-    }
+        /* Reads through a dmabuf mapping must be bracketed for coherency */
+        struct dma_buf_sync sync = {0};
+        if (fb->dmabuf_fd >= 0) {
+            sync.flags = DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ;
+            ioctl(fb->dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync);
+        }
 
-    /* mmap the framebuffer */
-    void *fb_map = mmap(0, fb_cmd.pitch * fb_cmd.height, PROT_READ, MAP_SHARED, ctx->display.fd,
-                        map_req.offset);
+        if (fb->pitch == row_bytes) {
+            memcpy(frame->data, fb->map, row_bytes * height);
+        } else {
+            for (uint32_t y = 0; y < height; y++) {
+                memcpy(frame->data + y * row_bytes, fb->map + (size_t)y * fb->pitch, row_bytes);
+            }
+        }
 
-    if (fb_map == MAP_FAILED) {
-        set_error("mmap failed: %s", strerror(errno));
-        return -1;
+        if (fb->dmabuf_fd >= 0) {
+            sync.flags = DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ;
+            ioctl(fb->dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync);
+        }
+
+        frame->memory = FRAME_MEMORY_CPU;
+        frame->dmabuf_fd = -1;
+        frame->mapped = NULL;
+        frame->pitch = (uint32_t)row_bytes;
+        frame->size = (uint32_t)(row_bytes * height);
     }
 
-    /* Copy framebuffer data */
-    memcpy(frame->data, fb_map, frame->size);
-    frame->pitch = fb_cmd.pitch;
+    frame->width = width;
+    frame->height = height;
+    frame->format = fb->format;
+    frame->dirty_count = 0;
 
     /* Get timestamp */
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
     frame->timestamp = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
 
-    /* Cleanup */
-    munmap(fb_map, fb_cmd.pitch * fb_cmd.height);
-
     ctx->frames_captured++;
     return 0;
 }
@@ -306,6 +488,17 @@ void rootstream_capture_cleanup_drm(rootstream_ctx_t *ctx) {
     if (!ctx)
         return;
 
+    if (drm_state.fbs) {
+        fb_cache_stats_t stats;
+        fb_cache_get_stats(drm_state.fbs, &stats);
+        printf("INFO: DRM framebuffer mappings hits=%lu maps=%lu evictions=%lu\n",
+               (unsigned long)stats.hits, (unsigned long)stats.misses,
+               (unsigned long)stats.evictions);
+        fb_cache_destroy(drm_state.fbs);
+        drm_state.fbs = NULL;
+    }
+    drm_state.crtc_id = 0;
+
     if (ctx->current_frame.data) {
         free(ctx->current_frame.data);
         ctx->current_frame.data = NULL;
@@ -315,6 +508,7 @@ void rootstream_capture_cleanup_drm(rootstream_ctx_t *ctx) {
         close(ctx->display.fd);
         ctx->display.fd = -1;
     }
+    drm_state.fd = -1;
 }
 
 /* Legacy wrapper functions for backward compatibility */
@@ -5,20 +5,47 @@
  * - Allows pipeline validation without real display hardware
  * - Perfect for CI/headless systems
  * - Generates animated patterns for testing
+ * - Zero-copy mode draws into memfd "scanout buffers" and hands frames
+ *   out by fd, exercising the same path as DRM dmabuf capture
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* memfd_create */
+#endif
+
+#include <errno.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "../include/rootstream.h"
+#include "fbcache/fb_cache.h"
+
+#define DUMMY_FLIP_BUFFERS 3 /* Like a triple-buffered compositor */
 
 static uint64_t frame_counter = 0;
 static char last_error[256] = {0};
 
+/*
+ * Fake scanout buffers for zero-copy mode
+ *
+ * The pattern is drawn into one memfd per buffer, round robin like page
+ * flips, and captured through an fb_cache keyed by buffer number exactly
+ * as drm_capture.c captures framebuffers: a buffer is mapped on first
+ * sight and its entry owns a dup()ed fd standing in for a PRIME export.
+ */
+static struct {
+    int fd[DUMMY_FLIP_BUFFERS];
+    uint8_t *pixels[DUMMY_FLIP_BUFFERS]; /* Writable "GPU" side */
+    size_t size;
+    fb_cache_t *fbs;
+} dummy_fb = {{-1, -1, -1}, {NULL, NULL, NULL}, 0, NULL};
+
 const char *rootstream_get_error_dummy(void) {
     return last_error;
 }
@@ -30,6 +57,76 @@ static void set_error(const char *fmt, ...) {
     va_end(args);
 }
 
+static void fake_fbs_cleanup(void) {
+    fb_cache_destroy(dummy_fb.fbs);
+    dummy_fb.fbs = NULL;
+    for (int i = 0; i < DUMMY_FLIP_BUFFERS; i++) {
+        if (dummy_fb.pixels[i]) {
+            munmap(dummy_fb.pixels[i], dummy_fb.size);
+            dummy_fb.pixels[i] = NULL;
+        }
+        if (dummy_fb.fd[i] >= 0) {
+            close(dummy_fb.fd[i]);
+            dummy_fb.fd[i] = -1;
+        }
+    }
+}
+
+static int fake_fbs_init(size_t size) {
+    dummy_fb.size = size;
+    for (int i = 0; i < DUMMY_FLIP_BUFFERS; i++) {
+        dummy_fb.fd[i] = memfd_create("rootstream-dummy-fb", MFD_CLOEXEC);
+        if (dummy_fb.fd[i] < 0 || ftruncate(dummy_fb.fd[i], (off_t)size) < 0) {
+            set_error("Cannot create fake framebuffer: %s", strerror(errno));
+            fake_fbs_cleanup();
+            return -1;
+        }
+        void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, dummy_fb.fd[i], 0);
+        if (map == MAP_FAILED) {
+            set_error("Cannot map fake framebuffer: %s", strerror(errno));
+            fake_fbs_cleanup();
+            return -1;
+        }
+        dummy_fb.pixels[i] = map;
+    }
+
+    dummy_fb.fbs = fb_cache_create(FB_CACHE_MAX_ENTRIES, NULL, NULL);
+    if (!dummy_fb.fbs) {
+        set_error("Cannot allocate framebuffer cache");
+        fake_fbs_cleanup();
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Map fake buffer @index the way drm_capture.c maps a new framebuffer
+ */
+static fb_cache_entry_t *fake_fb_map(rootstream_ctx_t *ctx, int index) {
+    fb_cache_entry_t fb = {0};
+    fb.fb_id = (uint32_t)index + 1;
+    fb.width = ctx->display.width;
+    fb.height = ctx->display.height;
+    fb.pitch = ctx->display.width * 4;
+    fb.format = ctx->current_frame.format;
+    fb.map_size = dummy_fb.size;
+
+    fb.dmabuf_fd = dup(dummy_fb.fd[index]);
+    if (fb.dmabuf_fd < 0) {
+        set_error("Cannot export fake framebuffer: %s", strerror(errno));
+        return NULL;
+    }
+    void *map = mmap(NULL, fb.map_size, PROT_READ, MAP_SHARED, fb.dmabuf_fd, 0);
+    if (map == MAP_FAILED) {
+        set_error("Cannot map fake framebuffer: %s", strerror(errno));
+        close(fb.dmabuf_fd);
+        return NULL;
+    }
+    fb.map = map;
+
+    return fb_cache_put(dummy_fb.fbs, &fb);
+}
+
 /*
  * Initialize dummy capture with configurable resolution
  */
@@ -63,10 +160,17 @@ int rootstream_capture_init_dummy(rootstream_ctx_t *ctx) {
     ctx->current_frame.capacity = frame_size;
     ctx->current_frame.format = 0x34325258; /* DRM_FORMAT_XRGB8888 */
 
+    if (ctx->settings.zero_copy_capture && fake_fbs_init(frame_size) < 0) {
+        free(ctx->current_frame.data);
+        ctx->current_frame.data = NULL;
+        return -1;
+    }
+
     frame_counter = 0;
 
-    printf("✓ Dummy test pattern initialized: %dx%d @ %d Hz\n", ctx->display.width,
-           ctx->display.height, ctx->display.refresh_rate);
+    printf("✓ Dummy test pattern initialized: %dx%d @ %d Hz%s\n", ctx->display.width,
+           ctx->display.height, ctx->display.refresh_rate,
+           dummy_fb.fbs ? " (fd-backed frames)" : "");
 
     return 0;
 }
@@ -85,6 +189,12 @@ int rootstream_capture_frame_dummy(rootstream_ctx_t *ctx, frame_buffer_t *frame)
     uint32_t height = ctx->display.height;
     uint8_t *data = frame->data;
 
+    /* Zero-copy: draw into the back buffer, then "flip" to it */
+    int back = (int)(frame_counter % DUMMY_FLIP_BUFFERS);
+    if (dummy_fb.fbs) {
+        data = dummy_fb.pixels[back];
+    }
+
     /* Animate based on frame counter */
     double time = frame_counter / 60.0;
     int offset_x = (int)(sin(time) * 100.0);
@@ -179,6 +289,24 @@ int rootstream_capture_frame_dummy(rootstream_ctx_t *ctx, frame_buffer_t *frame)
         }
     }
 
+    if (dummy_fb.fbs) {
+        /* Capture the flipped-to buffer through the mapping cache */
+        fb_cache_entry_t *fb = fb_cache_get(dummy_fb.fbs, (uint32_t)back + 1);
+        if (!fb) {
+            fb = fake_fb_map(ctx, back);
+            if (!fb) {
+                return -1;
+            }
+        }
+        frame->memory = FRAME_MEMORY_DMABUF;
+        frame->dmabuf_fd = fb->dmabuf_fd;
+        frame->mapped = fb->map;
+    } else {
+        frame->memory = FRAME_MEMORY_CPU;
+        frame->dmabuf_fd = -1;
+        frame->mapped = NULL;
+    }
+
     /* Set frame metadata */
     frame->width = width;
     frame->height = height;
@@ -207,5 +335,6 @@ void rootstream_capture_cleanup_dummy(rootstream_ctx_t *ctx) {
         ctx->current_frame.data = NULL;
     }
 
+    fake_fbs_cleanup();
     frame_counter = 0;
 }
@@ -5,12 +5,17 @@
 #include "fanout_manager.h"
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h> /* write() */
 
+#include "fanout_pool.h"
+
+#define FANOUT_SESSION_QUEUE_DEPTH 2 /* Frames queued per session behind the one in flight */
+
 /* ── Write helpers ─────────────────────────────────────────────── */
 
 /*
@@ -44,12 +49,59 @@ static int send_frame(int fd, const uint8_t *data, size_t size, fanout_frame_typ
 
 /* ── Fanout manager ─────────────────────────────────────────────── */
 
+/* One copy of a frame shared by every session's send job */
+typedef struct {
+    atomic_int refs;
+    fanout_frame_type_t type;
+    size_t size;
+    uint8_t data[];
+} shared_frame_t;
+
+/* Send job for one session */
+typedef struct {
+    shared_frame_t *frame;
+    int fd;
+} session_job_t;
+
+/* Session currently assigned to a pool lane */
+typedef struct {
+    bool used;
+    session_id_t id;
+    uint64_t seen; /* Last delivery that found the session active */
+} lane_owner_t;
+
 struct fanout_manager_s {
     session_table_t *table; /* borrowed */
     fanout_stats_t stats;
     pthread_mutex_t stats_lock;
+    fanout_pool_t *pool; /* NULL: send on the caller's thread */
+    lane_owner_t lanes[FANOUT_MAX_LANES];
+    uint64_t deliveries;
 };
 
+static void run_session_job(void *job, int lane, void *user) {
+    (void)lane;
+    fanout_manager_t *m = user;
+    session_job_t *j = job;
+    if (send_frame(j->fd, j->frame->data, j->frame->size, j->frame->type) < 0) {
+        pthread_mutex_lock(&m->stats_lock);
+        m->stats.frames_dropped++;
+        pthread_mutex_unlock(&m->stats_lock);
+    }
+}
+
+static void frame_unref(shared_frame_t *frame) {
+    if (atomic_fetch_sub(&frame->refs, 1) == 1)
+        free(frame);
+}
+
+static void release_session_job(void *job, void *user) {
+    (void)user;
+    session_job_t *j = job;
+    frame_unref(j->frame);
+    free(j);
+}
+
 fanout_manager_t *fanout_manager_create(session_table_t *table) {
     if (!table)
         return NULL;
@@ -63,22 +115,107 @@ fanout_manager_t *fanout_manager_create(session_table_t *table) {
     return m;
 }
 
+fanout_manager_t *fanout_manager_create_pooled(session_table_t *table, int workers) {
+    if (workers < 1 || workers > FANOUT_MAX_WORKERS)
+        return NULL;
+
+    fanout_manager_t *m = fanout_manager_create(table);
+    if (!m)
+        return NULL;
+
+    m->pool = fanout_pool_create(workers, FANOUT_SESSION_QUEUE_DEPTH, run_session_job,
+                                 release_session_job, m);
+    if (!m->pool) {
+        fanout_manager_destroy(m);
+        return NULL;
+    }
+    return m;
+}
+
 void fanout_manager_destroy(fanout_manager_t *mgr) {
     if (!mgr)
         return;
+    fanout_pool_destroy(mgr->pool);
     pthread_mutex_destroy(&mgr->stats_lock);
     free(mgr);
 }
 
+void fanout_manager_flush(fanout_manager_t *mgr) {
+    if (mgr)
+        fanout_pool_wait(mgr->pool);
+}
+
 /* Per-session delivery callback data */
 typedef struct {
+    fanout_manager_t *mgr;
     const uint8_t *data;
     size_t size;
     fanout_frame_type_t type;
+    shared_frame_t *frame; /* pooled: copy handed to the send jobs */
     int delivered;
     int dropped;
 } deliver_ctx_t;
 
+/*
+ * Lane serving session @id, assigning a free one on first sight.
+ * Returns -1 when every lane is taken.
+ */
+static int session_lane(fanout_manager_t *m, session_id_t id) {
+    int free_lane = -1;
+    for (int i = 0; i < FANOUT_MAX_LANES; i++) {
+        if (m->lanes[i].used && m->lanes[i].id == id) {
+            m->lanes[i].seen = m->deliveries;
+            return i;
+        }
+        if (!m->lanes[i].used && free_lane < 0)
+            free_lane = i;
+    }
+    if (free_lane >= 0) {
+        m->lanes[free_lane] = (lane_owner_t){.used = true, .id = id, .seen = m->deliveries};
+    }
+    return free_lane;
+}
+
+/* Free the lanes of sessions that have left the table */
+static void release_stale_lanes(fanout_manager_t *m) {
+    for (int i = 0; i < FANOUT_MAX_LANES; i++) {
+        if (m->lanes[i].used && m->lanes[i].seen != m->deliveries) {
+            fanout_pool_reset_lane(m->pool, i);
+            m->lanes[i].used = false;
+        }
+    }
+}
+
+static fanout_job_kind_t job_kind(fanout_frame_type_t type) {
+    switch (type) {
+        case FANOUT_FRAME_VIDEO_KEY:
+            return FANOUT_JOB_KEY;
+        case FANOUT_FRAME_VIDEO_DELTA:
+            return FANOUT_JOB_DELTA;
+        default:
+            return FANOUT_JOB_INDEPENDENT;
+    }
+}
+
+static void queue_to_session(const session_entry_t *entry, deliver_ctx_t *ctx) {
+    int lane = session_lane(ctx->mgr, entry->id);
+    session_job_t *job = lane >= 0 ? malloc(sizeof(*job)) : NULL;
+    if (!job) {
+        ctx->dropped++;
+        return;
+    }
+
+    job->frame = ctx->frame;
+    job->fd = entry->socket_fd;
+    atomic_fetch_add(&ctx->frame->refs, 1);
+
+    if (fanout_pool_submit(ctx->mgr->pool, lane, job, job_kind(ctx->type)) == FANOUT_QUEUED) {
+        ctx->delivered++;
+    } else {
+        ctx->dropped++;
+    }
+}
+
 static void deliver_to_session(const session_entry_t *entry, void *user_data) {
     deliver_ctx_t *ctx = (deliver_ctx_t *)user_data;
 
@@ -91,6 +228,11 @@ static void deliver_to_session(const session_entry_t *entry, void *user_data) {
         }
     }
 
+    if (ctx->frame) {
+        queue_to_session(entry, ctx);
+        return;
+    }
+
     int rc = send_frame(entry->socket_fd, ctx->data, ctx->size, ctx->type);
     if (rc == 0) {
         ctx->delivered++;
@@ -105,15 +247,34 @@ int fanout_manager_deliver(fanout_manager_t *mgr, const uint8_t *frame_data, siz
         return 0;
 
     deliver_ctx_t ctx = {
+        .mgr = mgr,
         .data = frame_data,
         .size = frame_size,
         .type = type,
+        .frame = NULL,
         .delivered = 0,
         .dropped = 0,
     };
 
+    if (mgr->pool) {
+        /* One copy for all sessions; the last job to finish frees it */
+        ctx.frame = malloc(sizeof(shared_frame_t) + frame_size);
+        if (!ctx.frame)
+            return 0;
+        atomic_init(&ctx.frame->refs, 1);
+        ctx.frame->type = type;
+        ctx.frame->size = frame_size;
+        memcpy(ctx.frame->data, frame_data, frame_size);
+        mgr->deliveries++;
+    }
+
     session_table_foreach(mgr->table, deliver_to_session, &ctx);
 
+    if (ctx.frame) {
+        frame_unref(ctx.frame);
+        release_stale_lanes(mgr);
+    }
+
     pthread_mutex_lock(&mgr->stats_lock);
     mgr->stats.frames_in++;
     if (ctx.delivered > 0)
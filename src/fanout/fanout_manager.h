@@ -10,6 +10,11 @@
  *   2. Sends the frame on the session's socket (or queues it)
  *   3. Updates per-client statistics
  *
+ * A manager created with fanout_manager_create_pooled() copies the frame
+ * once and hands the per-session sends to a fanout_pool: each session is
+ * a lane, so a session whose socket blocks only backs up its own queue
+ * (and starts losing deltas) while the others keep receiving.
+ *
  * Thread-safety: fanout_manager_deliver() is safe to call from any single
  * producer thread.  session management functions (add/remove) lock
  * internally and may be called from any thread.
@@ -55,6 +60,18 @@ typedef struct fanout_manager_s fanout_manager_t;
  */
 fanout_manager_t *fanout_manager_create(session_table_t *table);
 
+/**
+ * fanout_manager_create_pooled — allocate a manager that sends in parallel
+ *
+ * Frames are delivered by @workers threads with a short send queue per
+ * session; fanout_manager_deliver() returns once the frame is queued.
+ *
+ * @param table    Session table to use for session lookup (not owned)
+ * @param workers  Sender threads, 1..FANOUT_MAX_WORKERS
+ * @return         Non-NULL handle, or NULL on OOM / bad args
+ */
+fanout_manager_t *fanout_manager_create_pooled(session_table_t *table, int workers);
+
 /**
  * fanout_manager_destroy — free fanout manager resources
  *
@@ -69,15 +86,28 @@ void fanout_manager_destroy(fanout_manager_t *mgr);
  * session only when the client's estimated bandwidth cannot sustain
  * the current frame rate at its negotiated bitrate.
  *
+ * A pooled manager also drops a delta for a session whose send queue is
+ * full, and keeps dropping that session's deltas until the next keyframe.
+ *
  * @param mgr         Fanout manager
  * @param frame_data  Encoded frame payload
  * @param frame_size  Payload size in bytes
  * @param type        Frame type (key/delta/audio/data)
- * @return            Number of sessions the frame was delivered to
+ * @return            Number of sessions the frame was delivered (or, for
+ *                    a pooled manager, queued) to
  */
 int fanout_manager_deliver(fanout_manager_t *mgr, const uint8_t *frame_data, size_t frame_size,
                            fanout_frame_type_t type);
 
+/**
+ * fanout_manager_flush — wait until every queued send has completed
+ *
+ * No-op for a manager without workers.
+ *
+ * @param mgr  Fanout manager
+ */
+void fanout_manager_flush(fanout_manager_t *mgr);
+
 /**
  * fanout_manager_get_stats — retrieve delivery statistics
  *
@@ -0,0 +1,239 @@
+/*
+ * fanout_pool.c — Worker pool with per-destination send queues
+ */
+
+#include "fanout_pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    void *jobs[FANOUT_LANE_DEPTH_MAX]; /* Ring of queued jobs */
+    int head;
+    int count;
+    bool busy;     /* A worker is running one of this lane's jobs */
+    bool need_key; /* Deltas refused until the next key job */
+    fanout_lane_stats_t stats;
+} fanout_lane_t;
+
+struct fanout_pool_s {
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv; /* Runnable job queued, or stop */
+    pthread_cond_t idle_cv; /* A job finished */
+    pthread_t threads[FANOUT_MAX_WORKERS];
+    int workers;
+    int depth;
+    fanout_run_fn run;
+    fanout_release_fn release;
+    void *user;
+    fanout_lane_t lanes[FANOUT_MAX_LANES];
+    int next_lane; /* Round-robin scan start, so no lane starves */
+    int queued;
+    int running;
+    bool stop;
+};
+
+static void release_job(fanout_pool_t *pool, void *job) {
+    if (pool->release) pool->release(job, pool->user);
+}
+
+static void *lane_pop(fanout_lane_t *lane) {
+    void *job = lane->jobs[lane->head];
+    lane->head = (lane->head + 1) % FANOUT_LANE_DEPTH_MAX;
+    lane->count--;
+    return job;
+}
+
+/*
+ * Remove every queued job of @lane into @out (caller releases them
+ * outside the lock).  Returns the number removed.
+ */
+static int lane_take_all(fanout_pool_t *pool, fanout_lane_t *lane, void **out) {
+    int n = 0;
+    while (lane->count > 0) out[n++] = lane_pop(lane);
+    pool->queued -= n;
+    return n;
+}
+
+/* Caller holds the lock */
+static fanout_lane_t *next_runnable(fanout_pool_t *pool, int *index) {
+    for (int i = 0; i < FANOUT_MAX_LANES; i++) {
+        int l = (pool->next_lane + i) % FANOUT_MAX_LANES;
+        fanout_lane_t *lane = &pool->lanes[l];
+        if (lane->count > 0 && !lane->busy) {
+            pool->next_lane = (l + 1) % FANOUT_MAX_LANES;
+            *index = l;
+            return lane;
+        }
+    }
+    return NULL;
+}
+
+static void *worker_main(void *arg) {
+    fanout_pool_t *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        int index = 0;
+        fanout_lane_t *lane = next_runnable(pool, &index);
+        if (!lane) {
+            if (pool->stop) break;
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+            continue;
+        }
+
+        void *job = lane_pop(lane);
+        lane->busy = true;
+        pool->queued--;
+        pool->running++;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool->run(job, index, pool->user);
+        release_job(pool, job);
+
+        pthread_mutex_lock(&pool->lock);
+        lane->busy = false;
+        lane->stats.completed++;
+        pool->running--;
+        pthread_cond_broadcast(&pool->idle_cv);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+fanout_pool_t *fanout_pool_create(int workers, int depth, fanout_run_fn run,
+                                  fanout_release_fn release, void *user) {
+    if (workers < 0 || workers > FANOUT_MAX_WORKERS || depth < 1 ||
+        depth > FANOUT_LANE_DEPTH_MAX || !run)
+        return NULL;
+
+    fanout_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+
+    pool->depth = depth;
+    pool->run = run;
+    pool->release = release;
+    pool->user = user;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->idle_cv, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+            fanout_pool_destroy(pool);
+            return NULL;
+        }
+        pool->workers++;
+    }
+    return pool;
+}
+
+void fanout_pool_destroy(fanout_pool_t *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    /* Queued jobs are released, not run */
+    void *left[FANOUT_LANE_DEPTH_MAX];
+    for (int l = 0; l < FANOUT_MAX_LANES; l++) {
+        int n = lane_take_all(pool, &pool->lanes[l], left);
+        pthread_mutex_unlock(&pool->lock);
+        for (int i = 0; i < n; i++) release_job(pool, left[i]);
+        pthread_mutex_lock(&pool->lock);
+    }
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->workers; i++) pthread_join(pool->threads[i], NULL);
+
+    pthread_cond_destroy(&pool->idle_cv);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int fanout_pool_submit(fanout_pool_t *pool, int lane_index, void *job, fanout_job_kind_t kind) {
+    if (!pool || !job || lane_index < 0 || lane_index >= FANOUT_MAX_LANES) return -1;
+
+    fanout_lane_t *lane = &pool->lanes[lane_index];
+
+    if (pool->workers == 0) {
+        pthread_mutex_lock(&pool->lock);
+        lane->stats.submitted++;
+        lane->stats.completed++;
+        pthread_mutex_unlock(&pool->lock);
+        pool->run(job, lane_index, pool->user);
+        release_job(pool, job);
+        return FANOUT_QUEUED;
+    }
+
+    void *superseded[FANOUT_LANE_DEPTH_MAX];
+    int n = 0;
+    int rc = FANOUT_QUEUED;
+
+    pthread_mutex_lock(&pool->lock);
+    lane->stats.submitted++;
+    if (kind == FANOUT_JOB_KEY) {
+        n = lane_take_all(pool, lane, superseded);
+        lane->stats.discarded += (uint64_t)n;
+        lane->need_key = false;
+    } else if (kind == FANOUT_JOB_DELTA && (lane->need_key || lane->count >= pool->depth)) {
+        lane->stats.dropped++;
+        lane->need_key = true;
+        rc = FANOUT_DROPPED;
+    } else if (lane->count >= pool->depth) {
+        lane->stats.dropped++;
+        rc = FANOUT_DROPPED;
+    }
+
+    if (rc == FANOUT_QUEUED) {
+        lane->jobs[(lane->head + lane->count) % FANOUT_LANE_DEPTH_MAX] = job;
+        lane->count++;
+        if ((uint32_t)lane->count > lane->stats.peak_depth)
+            lane->stats.peak_depth = (uint32_t)lane->count;
+        pool->queued++;
+        if (!lane->busy) pthread_cond_signal(&pool->work_cv);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < n; i++) release_job(pool, superseded[i]);
+    if (rc == FANOUT_DROPPED) release_job(pool, job);
+    return rc;
+}
+
+void fanout_pool_wait(fanout_pool_t *pool) {
+    if (!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    while (pool->queued > 0 || pool->running > 0) pthread_cond_wait(&pool->idle_cv, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void fanout_pool_reset_lane(fanout_pool_t *pool, int lane_index) {
+    if (!pool || lane_index < 0 || lane_index >= FANOUT_MAX_LANES) return;
+
+    fanout_lane_t *lane = &pool->lanes[lane_index];
+    void *left[FANOUT_LANE_DEPTH_MAX];
+
+    pthread_mutex_lock(&pool->lock);
+    int n = lane_take_all(pool, lane, left);
+    pthread_cond_broadcast(&pool->idle_cv);
+    while (lane->busy) pthread_cond_wait(&pool->idle_cv, &pool->lock);
+    lane->need_key = false;
+    memset(&lane->stats, 0, sizeof(lane->stats));
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < n; i++) release_job(pool, left[i]);
+}
+
+int fanout_pool_get_lane_stats(fanout_pool_t *pool, int lane_index, fanout_lane_stats_t *out) {
+    if (!pool || !out || lane_index < 0 || lane_index >= FANOUT_MAX_LANES) return -1;
+    pthread_mutex_lock(&pool->lock);
+    *out = pool->lanes[lane_index].stats;
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+int fanout_pool_worker_count(const fanout_pool_t *pool) {
+    return pool ? pool->workers : 0;
+}
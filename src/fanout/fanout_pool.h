@@ -0,0 +1,140 @@
+/*
+ * fanout_pool.h — Worker pool with per-destination send queues
+ *
+ * Fanning one encoded frame out to N receivers is N independent jobs
+ * (encrypt, send) that only have to stay in order per receiver.  The
+ * pool runs them on a fixed set of worker threads: every receiver gets
+ * a lane, a bounded FIFO of jobs, and at most one worker serves a lane
+ * at a time, so frames reach each receiver in submission order while
+ * different receivers proceed in parallel.
+ *
+ * Back-pressure is per lane.  A receiver whose socket cannot keep up
+ * fills its own lane and nobody else's:
+ *
+ *   - a key job (keyframe) discards whatever the lane still has queued,
+ *     since the keyframe supersedes it;
+ *   - a delta job offered to a full lane is dropped, and the lane then
+ *     refuses deltas until the next key job (the receiver could not
+ *     decode them anyway);
+ *   - an independent job (audio, control) is dropped only when the lane
+ *     is full and does not affect the key state.
+ *
+ * Every submitted job is handed to the release callback exactly once,
+ * whether it ran, was dropped or was discarded.
+ *
+ * Thread-safety: submit/wait/reset_lane/get_lane_stats may be called
+ *                from any thread; the run and release callbacks are
+ *                invoked on worker threads (or on the submitting thread
+ *                for drops, discards and a pool with no workers).
+ */
+
+#ifndef ROOTSTREAM_FANOUT_POOL_H
+#define ROOTSTREAM_FANOUT_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FANOUT_MAX_WORKERS 16   /**< Upper bound on worker threads */
+#define FANOUT_MAX_LANES 32     /**< Upper bound on receivers per pool */
+#define FANOUT_LANE_DEPTH_MAX 8 /**< Upper bound on jobs queued per lane */
+
+/** fanout_pool_submit() results */
+#define FANOUT_QUEUED 0  /**< Job accepted (or already run, with no workers) */
+#define FANOUT_DROPPED 1 /**< Refused by a congested lane and released */
+
+/** How a job relates to the jobs queued before it */
+typedef enum {
+    FANOUT_JOB_DELTA = 0,       /**< Depends on the previous job of its lane */
+    FANOUT_JOB_KEY = 1,         /**< Supersedes every queued job of its lane */
+    FANOUT_JOB_INDEPENDENT = 2, /**< Neither depends on nor supersedes others */
+} fanout_job_kind_t;
+
+/** Per-lane counters */
+typedef struct {
+    uint64_t submitted;  /**< Jobs offered to the lane */
+    uint64_t completed;  /**< Jobs run */
+    uint64_t dropped;    /**< Jobs refused (lane full, or delta waiting for a key) */
+    uint64_t discarded;  /**< Queued jobs superseded by a key job */
+    uint32_t peak_depth; /**< Largest queue length seen */
+} fanout_lane_stats_t;
+
+/**
+ * Runs one job for @lane; jobs of one lane never run concurrently.
+ */
+typedef void (*fanout_run_fn)(void *job, int lane, void *user);
+
+/**
+ * Disposes of a job after it ran or was dropped / discarded.
+ */
+typedef void (*fanout_release_fn)(void *job, void *user);
+
+/** Opaque pool */
+typedef struct fanout_pool_s fanout_pool_t;
+
+/**
+ * fanout_pool_create — start @workers threads
+ *
+ * @param workers  Worker threads, 0..FANOUT_MAX_WORKERS; 0 runs every
+ *                 job synchronously inside fanout_pool_submit()
+ * @param depth    Jobs queued per lane behind the running one,
+ *                 1..FANOUT_LANE_DEPTH_MAX
+ * @param run      Job body
+ * @param release  Job disposal (may be NULL)
+ * @param user     Passed to @run and @release
+ * @return         Pool, or NULL on bad arguments / OOM / thread failure
+ */
+fanout_pool_t *fanout_pool_create(int workers, int depth, fanout_run_fn run,
+                                  fanout_release_fn release, void *user);
+
+/**
+ * fanout_pool_destroy — stop the workers and free @pool
+ *
+ * Jobs already running finish; queued jobs are released without
+ * running.
+ */
+void fanout_pool_destroy(fanout_pool_t *pool);
+
+/**
+ * fanout_pool_submit — queue @job on @lane
+ *
+ * @param lane  0..FANOUT_MAX_LANES-1
+ * @param kind  Key, delta or independent, see above
+ * @return      FANOUT_QUEUED, FANOUT_DROPPED, or -1 on bad arguments
+ *              (in which case @job is not released)
+ */
+int fanout_pool_submit(fanout_pool_t *pool, int lane, void *job, fanout_job_kind_t kind);
+
+/**
+ * fanout_pool_wait — block until every lane is empty and idle
+ */
+void fanout_pool_wait(fanout_pool_t *pool);
+
+/**
+ * fanout_pool_reset_lane — prepare @lane for a new receiver
+ *
+ * Releases the lane's queued jobs, waits for its running job, and
+ * clears its counters and key state.
+ */
+void fanout_pool_reset_lane(fanout_pool_t *pool, int lane);
+
+/**
+ * fanout_pool_get_lane_stats — snapshot the counters of @lane
+ *
+ * @return  0 on success, -1 on bad arguments
+ */
+int fanout_pool_get_lane_stats(fanout_pool_t *pool, int lane, fanout_lane_stats_t *out);
+
+/**
+ * fanout_pool_worker_count — threads serving @pool (0 = synchronous)
+ */
+int fanout_pool_worker_count(const fanout_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_FANOUT_POOL_H */
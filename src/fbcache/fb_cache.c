@@ -0,0 +1,121 @@
+/*
+ * fb_cache.c — Persistent scanout framebuffer mappings
+ */
+
+#include "fb_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef struct {
+    fb_cache_entry_t fb;
+    uint64_t last_use; /* 0 = slot free */
+} fb_slot_t;
+
+struct fb_cache_s {
+    fb_slot_t slots[FB_CACHE_MAX_ENTRIES];
+    int capacity;
+    uint64_t clock;
+    fb_cache_release_fn release;
+    void *user;
+    fb_cache_stats_t stats;
+};
+
+static void release_slot(fb_cache_t *cache, fb_slot_t *slot) {
+    fb_cache_entry_t *fb = &slot->fb;
+    if (fb->map) munmap(fb->map, fb->map_size);
+    if (fb->dmabuf_fd >= 0) close(fb->dmabuf_fd);
+    if (cache->release) cache->release(fb, cache->user);
+    memset(slot, 0, sizeof(*slot));
+    slot->fb.dmabuf_fd = -1;
+}
+
+fb_cache_t *fb_cache_create(int capacity, fb_cache_release_fn release, void *user) {
+    if (capacity < 1 || capacity > FB_CACHE_MAX_ENTRIES) return NULL;
+
+    fb_cache_t *cache = calloc(1, sizeof(*cache));
+    if (!cache) return NULL;
+
+    cache->capacity = capacity;
+    cache->release = release;
+    cache->user = user;
+    for (int i = 0; i < FB_CACHE_MAX_ENTRIES; i++) cache->slots[i].fb.dmabuf_fd = -1;
+    return cache;
+}
+
+void fb_cache_destroy(fb_cache_t *cache) {
+    if (!cache) return;
+    for (int i = 0; i < cache->capacity; i++)
+        if (cache->slots[i].last_use) release_slot(cache, &cache->slots[i]);
+    free(cache);
+}
+
+static fb_slot_t *find(fb_cache_t *cache, uint32_t fb_id) {
+    for (int i = 0; i < cache->capacity; i++)
+        if (cache->slots[i].last_use && cache->slots[i].fb.fb_id == fb_id)
+            return &cache->slots[i];
+    return NULL;
+}
+
+fb_cache_entry_t *fb_cache_get(fb_cache_t *cache, uint32_t fb_id) {
+    if (!cache || fb_id == 0) return NULL;
+
+    fb_slot_t *slot = find(cache, fb_id);
+    if (!slot) {
+        cache->stats.misses++;
+        return NULL;
+    }
+    cache->stats.hits++;
+    slot->last_use = ++cache->clock;
+    return &slot->fb;
+}
+
+fb_cache_entry_t *fb_cache_put(fb_cache_t *cache, const fb_cache_entry_t *entry) {
+    if (!cache || !entry || entry->fb_id == 0) return NULL;
+
+    fb_slot_t *slot = find(cache, entry->fb_id);
+    if (slot) {
+        /* Same ID re-created by the owner: the old mapping is stale */
+        release_slot(cache, slot);
+    } else {
+        fb_slot_t *lru = NULL;
+        for (int i = 0; i < cache->capacity; i++) {
+            fb_slot_t *s = &cache->slots[i];
+            if (!s->last_use) {
+                slot = s;
+                break;
+            }
+            if (!lru || s->last_use < lru->last_use) lru = s;
+        }
+        if (!slot) {
+            release_slot(cache, lru);
+            cache->stats.evictions++;
+            slot = lru;
+        }
+    }
+
+    slot->fb = *entry;
+    slot->last_use = ++cache->clock;
+    return &slot->fb;
+}
+
+void fb_cache_invalidate(fb_cache_t *cache, uint32_t fb_id) {
+    if (!cache) return;
+    fb_slot_t *slot = find(cache, fb_id);
+    if (slot) release_slot(cache, slot);
+}
+
+int fb_cache_count(const fb_cache_t *cache) {
+    if (!cache) return 0;
+    int n = 0;
+    for (int i = 0; i < cache->capacity; i++)
+        if (cache->slots[i].last_use) n++;
+    return n;
+}
+
+void fb_cache_get_stats(const fb_cache_t *cache, fb_cache_stats_t *out) {
+    if (!cache || !out) return;
+    *out = cache->stats;
+}
@@ -0,0 +1,113 @@
+/*
+ * fb_cache.h — Persistent scanout framebuffer mappings
+ *
+ * Capturing a KMS framebuffer needs GETFB, MAP_DUMB (or a PRIME export)
+ * and an mmap before a single pixel can be read.  Compositors flip
+ * between a handful of buffers, so those mappings are worth keeping:
+ * the cache holds up to FB_CACHE_MAX_ENTRIES framebuffers keyed by
+ * framebuffer ID and evicts the least recently used one when full.
+ *
+ * An entry owns its CPU mapping and its dmabuf fd; both are released on
+ * eviction, together with anything the owner's release callback frees
+ * (e.g. the GEM handle GETFB returned).
+ *
+ * Thread-safety: NOT thread-safe; a cache belongs to one capture
+ *                backend.
+ */
+
+#ifndef ROOTSTREAM_FB_CACHE_H
+#define ROOTSTREAM_FB_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FB_CACHE_MAX_ENTRIES 8 /**< Upper bound on cached framebuffers */
+
+/** One mapped framebuffer */
+typedef struct {
+    uint32_t fb_id;  /**< Cache key (0 is never a valid framebuffer) */
+    uint32_t width;  /**< Pixels */
+    uint32_t height; /**< Pixels */
+    uint32_t pitch;  /**< Bytes per row */
+    uint32_t format; /**< FRAME_FORMAT_* of the pixels */
+    uint32_t handle; /**< Owner's buffer handle (GEM), 0 if none */
+    int dmabuf_fd;   /**< PRIME/dmabuf fd, -1 if not exported */
+    uint8_t *map;    /**< Read-only CPU view, NULL if not mapped */
+    size_t map_size; /**< Bytes mapped at @map */
+} fb_cache_entry_t;
+
+/** Cache counters */
+typedef struct {
+    uint64_t hits;      /**< Lookups served from the cache */
+    uint64_t misses;    /**< Lookups that needed a new mapping */
+    uint64_t evictions; /**< Entries released to make room */
+} fb_cache_stats_t;
+
+/**
+ * Called for every entry leaving the cache, after its mapping and fd
+ * have been released; frees whatever @entry->handle refers to.
+ */
+typedef void (*fb_cache_release_fn)(const fb_cache_entry_t *entry, void *user);
+
+/** Opaque cache */
+typedef struct fb_cache_s fb_cache_t;
+
+/**
+ * fb_cache_create — allocate an empty cache
+ *
+ * @param capacity  Entries kept, 1..FB_CACHE_MAX_ENTRIES
+ * @param release   Optional callback for owner resources
+ * @param user      Passed to @release
+ * @return          Cache, or NULL on bad capacity / OOM
+ */
+fb_cache_t *fb_cache_create(int capacity, fb_cache_release_fn release, void *user);
+
+/**
+ * fb_cache_destroy — release every entry and free @cache
+ */
+void fb_cache_destroy(fb_cache_t *cache);
+
+/**
+ * fb_cache_get — look up a framebuffer and mark it most recently used
+ *
+ * Counts a hit or a miss.
+ *
+ * @return  Entry, or NULL if @fb_id is not cached
+ */
+fb_cache_entry_t *fb_cache_get(fb_cache_t *cache, uint32_t fb_id);
+
+/**
+ * fb_cache_put — take ownership of a freshly mapped framebuffer
+ *
+ * Replaces an entry with the same ID, otherwise evicts the least
+ * recently used entry when the cache is full.
+ *
+ * @return  The stored entry, or NULL if @entry->fb_id is 0 (in which
+ *          case nothing is taken over)
+ */
+fb_cache_entry_t *fb_cache_put(fb_cache_t *cache, const fb_cache_entry_t *entry);
+
+/**
+ * fb_cache_invalidate — release the entry for @fb_id, if any
+ */
+void fb_cache_invalidate(fb_cache_t *cache, uint32_t fb_id);
+
+/**
+ * fb_cache_count — entries currently cached
+ */
+int fb_cache_count(const fb_cache_t *cache);
+
+/**
+ * fb_cache_get_stats — snapshot the counters
+ */
+void fb_cache_get_stats(const fb_cache_t *cache, fb_cache_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_FB_CACHE_H */
@@ -1,54 +1,72 @@
 /*
- * fec_decoder.c — FEC XOR recovery decoder
+ * fec_decoder.c — FEC Reed-Solomon erasure decoder
  */
 
 #include "fec_decoder.h"
 
-#include <stdlib.h>
 #include <string.h>
 
+#include "fec_gf.h"
+
 int fec_decode(const uint8_t *const *pkts, const bool *received, int k, int r, size_t pkt_size,
                uint8_t **recovered) {
     if (!pkts || !received || !recovered || k <= 0 || k > FEC_MAX_K || r < 0 || r > FEC_MAX_R ||
         pkt_size == 0 || pkt_size > FEC_MAX_PKT_SIZE)
         return -1;
 
-    int n_recovered = 0;
+    int lost[FEC_MAX_R];
+    int repairs[FEC_MAX_R];
+    int e = 0;
+    int avail = 0;
 
-    /* For each repair block ri, check if exactly one source covered by it
-     * is missing.  If so, recover it. */
-    for (int ri = 0; ri < r; ri++) {
-        int repair_idx = k + ri;
-        /* Only use this repair if the repair packet was received */
-        if (!received[repair_idx] || !pkts[repair_idx])
+    for (int j = 0; j < k; j++) {
+        if (received[j] && pkts[j])
             continue;
+        if (!recovered[j])
+            return -1;
+        if (e == FEC_MAX_R)
+            return 0; /* More losses than any group can repair */
+        lost[e++] = j;
+    }
+    if (e == 0)
+        return 0;
+
+    for (int ri = 0; ri < r && avail < e; ri++) {
+        if (received[k + ri] && pkts[k + ri])
+            repairs[avail++] = ri;
+    }
+    if (avail < e)
+        return 0;
 
-        /* Count missing sources covered by this repair */
-        int missing_idx = -1;
-        int missing_count = 0;
+    /* Row i: repair[repairs[i]] minus the known sources, kept in the
+     * buffer of lost source i; m holds the coefficients of the unknowns */
+    uint8_t m[FEC_MAX_R][FEC_MAX_R];
+    for (int i = 0; i < e; i++) {
+        uint8_t *row = recovered[lost[i]];
+        memcpy(row, pkts[k + repairs[i]], pkt_size);
         for (int j = 0; j < k; j++) {
-            if (fec_repair_covers(j, ri) && !received[j]) {
-                missing_count++;
-                missing_idx = j;
-            }
+            if (received[j] && pkts[j])
+                fec_gf_mul_add_region(row, pkts[j], fec_matrix_coef(repairs[i], j), pkt_size);
         }
-        if (missing_count != 1 || missing_idx < 0)
-            continue;
-        if (!recovered[missing_idx])
-            continue;
+        for (int c = 0; c < e; c++) m[i][c] = fec_matrix_coef(repairs[i], lost[c]);
+    }
 
-        /* recovered[missing_idx] = repair XOR all other present sources */
-        memcpy(recovered[missing_idx], pkts[repair_idx], pkt_size);
-        for (int j = 0; j < k; j++) {
-            if (!fec_repair_covers(j, ri))
-                continue;
-            if (j == missing_idx)
-                continue;
-            if (!received[j] || !pkts[j])
+    /* Gauss-Jordan: every leading minor of a Cauchy matrix is non-zero,
+     * so no row exchanges are needed and row c ends up holding lost[c] */
+    for (int c = 0; c < e; c++) {
+        if (m[c][c] == 0)
+            return -1;
+        uint8_t inv = fec_gf_inv(m[c][c]);
+        for (int x = 0; x < e; x++) m[c][x] = fec_gf_mul(m[c][x], inv);
+        fec_gf_mul_region(recovered[lost[c]], recovered[lost[c]], inv, pkt_size);
+
+        for (int i = 0; i < e; i++) {
+            uint8_t f = m[i][c];
+            if (i == c || f == 0)
                 continue;
-            for (size_t b = 0; b < pkt_size; b++) recovered[missing_idx][b] ^= pkts[j][b];
+            for (int x = 0; x < e; x++) m[i][x] ^= fec_gf_mul(f, m[c][x]);
+            fec_gf_mul_add_region(recovered[lost[i]], recovered[lost[c]], f, pkt_size);
         }
-        n_recovered++;
     }
-    return n_recovered;
+    return e;
 }
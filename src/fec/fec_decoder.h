@@ -1,19 +1,14 @@
 /*
- * fec_decoder.h — FEC group decoder (XOR recovery)
+ * fec_decoder.h — FEC group decoder (Reed-Solomon erasure recovery)
  *
  * Given a received subset of k+r transmitted packets (where up to r
  * may be lost), recovers the original k source packets.
  *
- * Recovery is possible when the number of lost source packets ≤ r,
- * because each repair block is an XOR combination of the sources that
- * cover it.  Specifically:
- *
- *   repair[ri] = XOR of all source[j] where fec_repair_covers(j, ri).
- *
- * If source[j] is missing and exactly one repair covers it, the source
- * can be recovered by XOR-ing all other sources that the same repair
- * covers.  This decoder performs one pass of such single-missing
- * recovery for each repair block.
+ * The code is MDS: recovery succeeds whenever the number of lost source
+ * packets e is ≤ the number of repair packets received.  The decoder
+ * takes e received repairs, subtracts the known sources from them, and
+ * solves the remaining e × e Cauchy system by Gauss-Jordan elimination
+ * directly in the output buffers (O(k·e + e²) region operations).
  *
  * Thread-safety: stateless function — thread-safe.
  */
@@ -43,7 +38,8 @@ extern "C" {
  * @param recovered  Output array of k allocated buffers; decoder writes
  *                   recovered data into recovered[j] for any lost source j.
  *                   Buffers for non-lost sources are left untouched.
- * @return           Number of source packets recovered (0..k), or -1 on error
+ * @return           Number of source packets recovered (0 if too few
+ *                   packets arrived), or -1 on error
  */
 int fec_decode(const uint8_t *const *pkts, const bool *received, int k, int r, size_t pkt_size,
                uint8_t **recovered);
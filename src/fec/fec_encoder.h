@@ -3,7 +3,8 @@
  *
  * Encodes a group of k source packets into k+r packets where r ≤
  * FEC_MAX_R repair packets are appended.  Each repair packet is a
- * distinct XOR combination of the source packets (see fec_matrix.h).
+ * Cauchy Reed-Solomon combination of the source packets (see
+ * fec_matrix.h), so any k of the k+r packets recover the group.
  *
  * Group wire convention:
  *   Packets 0 .. k-1  : original source packets (pass-through)
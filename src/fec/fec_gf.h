@@ -0,0 +1,54 @@
+/*
+ * fec_gf.h — GF(2^8) arithmetic for the Reed-Solomon FEC code
+ *
+ * Field: GF(2)[x] / (x^8 + x^4 + x^3 + x^2 + 1), generator 2.  Single
+ * products use log/exp tables.  The region kernels multiply a whole
+ * packet by a constant with two 16-entry tables (one per nibble), which
+ * maps directly onto PSHUFB: on x86 the SSSE3 or AVX2 kernel is chosen
+ * at run time, everything else uses the portable scalar kernel.
+ *
+ * Thread-safety: stateless — thread-safe.
+ */
+
+#ifndef ROOTSTREAM_FEC_GF_H
+#define ROOTSTREAM_FEC_GF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * fec_gf_mul — a × b
+ */
+uint8_t fec_gf_mul(uint8_t a, uint8_t b);
+
+/**
+ * fec_gf_inv — multiplicative inverse of a (a ≠ 0; returns 0 for a = 0)
+ */
+uint8_t fec_gf_inv(uint8_t a);
+
+/**
+ * fec_gf_mul_region — dst[i] = c × src[i]
+ *
+ * dst may equal src (in-place scaling); other overlap is not allowed.
+ */
+void fec_gf_mul_region(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+/**
+ * fec_gf_mul_add_region — dst[i] ^= c × src[i]
+ */
+void fec_gf_mul_add_region(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+/**
+ * fec_gf_kernel_name — region kernel in use ("avx2", "ssse3", "scalar")
+ */
+const char *fec_gf_kernel_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_FEC_GF_H */
@@ -1,15 +1,21 @@
 /*
- * fec_matrix.c — GF(2) XOR parity matrix implementation
+ * fec_matrix.c — Cauchy Reed-Solomon generator matrix implementation
  */
 
 #include "fec_matrix.h"
 
 #include <string.h>
 
+#include "fec_gf.h"
+
+uint8_t fec_matrix_coef(int repair_idx, int src_idx) {
+    if (repair_idx < 0 || repair_idx >= FEC_MAX_R || src_idx < 0 || src_idx >= FEC_MAX_K)
+        return 0;
+    return fec_gf_inv((uint8_t)(repair_idx ^ (FEC_MAX_R + src_idx)));
+}
+
 int fec_repair_covers(int src_idx, int repair_idx) {
-    /* Source src_idx contributes to repair repair_idx if
-     * (src_idx % (repair_idx + 2)) == 0                  */
-    return (src_idx % (repair_idx + 2)) == 0;
+    return fec_matrix_coef(repair_idx, src_idx) != 0;
 }
 
 int fec_build_repair(const uint8_t *const *sources, int k, int repair_idx, uint8_t *out,
@@ -23,9 +29,7 @@ int fec_build_repair(const uint8_t *const *sources, int k, int repair_idx, uint8
     for (int j = 0; j < k; j++) {
         if (!sources[j])
             continue;
-        if (fec_repair_covers(j, repair_idx)) {
-            for (size_t b = 0; b < pkt_size; b++) out[b] ^= sources[j][b];
-        }
+        fec_gf_mul_add_region(out, sources[j], fec_matrix_coef(repair_idx, j), pkt_size);
     }
     return 0;
 }
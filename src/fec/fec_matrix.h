@@ -1,16 +1,18 @@
 /*
- * fec_matrix.h — GF(2) XOR parity matrix builder for FEC
+ * fec_matrix.h — Cauchy Reed-Solomon generator matrix for FEC
  *
- * Builds the parity (repair) blocks for a group of k source packets
- * using XOR operations over GF(2).  For each repair block r_i, the
- * parity vector p_i is a subset of the source indices selected by a
- * simple binary matrix row (identity-derived pattern).
+ * Systematic MDS erasure code over GF(2^8): the k source packets go out
+ * unchanged and repair packet i is
  *
- * Repair block i is computed as:
- *   R_i = XOR of all source packets S_j where (j % (i+2)) == 0
+ *   R_i = Σ_j C[i][j] · S_j     with C[i][j] = 1 / (x_i + y_j)
  *
- * This guarantees each repair covers a distinct non-trivial subset
- * while keeping computation O(k × block_size).
+ * where x_i = i and y_j = FEC_MAX_R + j (addition is XOR).  Every square
+ * submatrix of a Cauchy matrix is invertible, so any k of the k+r
+ * packets of a group recover all k sources.  The coefficients depend
+ * only on (i, j), not on k or r, so they are part of the wire format.
+ *
+ * Each repair costs k multiply-accumulate passes over the packet (see
+ * fec_gf.h for the SIMD kernels).
  *
  * Thread-safety: stateless helpers — thread-safe.
  */
@@ -25,12 +27,26 @@
 extern "C" {
 #endif
 
-#define FEC_MAX_K 16          /**< Maximum source packets per group */
-#define FEC_MAX_R 4           /**< Maximum repair packets per group */
-#define FEC_MAX_PKT_SIZE 1472 /**< Maximum payload bytes per packet (UDP MTU) */
+#define FEC_MAX_K 128         /**< Maximum source packets per group */
+#define FEC_MAX_R 64          /**< Maximum repair packets per group */
+#define FEC_MAX_PKT_SIZE 8972 /**< Maximum payload bytes per packet (jumbo UDP MTU) */
+
+/* x_i and y_j must be distinct field elements */
+#if FEC_MAX_K + FEC_MAX_R > 256
+#error "FEC_MAX_K + FEC_MAX_R must not exceed the field size"
+#endif
 
 /**
- * fec_build_repair — compute repair[r] = XOR of selected sources
+ * fec_matrix_coef — Cauchy coefficient of source src_idx in repair repair_idx
+ *
+ * @param repair_idx Repair index (0..FEC_MAX_R-1)
+ * @param src_idx    Source index (0..FEC_MAX_K-1)
+ * @return           Non-zero coefficient, or 0 for out-of-range indices
+ */
+uint8_t fec_matrix_coef(int repair_idx, int src_idx);
+
+/**
+ * fec_build_repair — compute repair[repair_idx] = Σ coef · sources[j]
  *
  * @param sources     Array of k source payloads (each @pkt_size bytes)
  * @param k           Number of source packets (1..FEC_MAX_K)
@@ -45,7 +61,10 @@ int fec_build_repair(const uint8_t *const *sources, int k, int repair_idx, uint8
 /**
  * fec_repair_covers — return 1 if source[src_idx] contributes to repair[r]
  *
- * @param src_idx    Source index (0..k-1)
+ * Every coefficient of a Cauchy matrix is non-zero, so every repair
+ * covers every source of its group.
+ *
+ * @param src_idx    Source index (0..FEC_MAX_K-1)
  * @param repair_idx Repair index (0..FEC_MAX_R-1)
  * @return           1 if source contributes, 0 otherwise
  */
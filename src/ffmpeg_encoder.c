@@ -242,8 +242,22 @@ int rootstream_encode_frame_ffmpeg(rootstream_ctx_t *ctx, frame_buffer_t *in, ui
         return -1;
     }
 
-    /* Convert RGBA to YUV420P */
-    const uint8_t *src_data[1] = {in->data};
+    /* Convert RGBA (or BGRA from X11) to YUV420P */
+    enum AVPixelFormat src_fmt =
+        in->format == FRAME_FORMAT_BGRA ? AV_PIX_FMT_BGRA : AV_PIX_FMT_RGBA;
+    ff->sws_ctx = sws_getCachedContext(ff->sws_ctx, ff->width, ff->height, src_fmt, ff->width,
+                                       ff->height, AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR, NULL,
+                                       NULL, NULL);
+    if (!ff->sws_ctx) {
+        fprintf(stderr, "ERROR: Cannot initialize swscale context\n");
+        return -1;
+    }
+
+    const uint8_t *src_data[1] = {frame_buffer_pixels(in)};
+    if (!src_data[0]) {
+        fprintf(stderr, "ERROR: Frame has no CPU-readable pixels\n");
+        return -1;
+    }
     int src_linesize[1] = {(int)in->pitch};
 
     int ret = sws_scale(ff->sws_ctx, src_data, src_linesize, 0, ff->height, ff->frame->data,
@@ -258,9 +272,8 @@ int rootstream_encode_frame_ffmpeg(rootstream_ctx_t *ctx, frame_buffer_t *in, ui
     ff->frame->pts = ff->frame_count++;
 
     /* Check if we should force keyframe */
-    if (ctx->encoder.force_keyframe) {
+    if (encoder_take_keyframe(&ctx->encoder)) {
         ff->frame->pict_type = AV_PICTURE_TYPE_I;
-        ctx->encoder.force_keyframe = false;
     } else {
         ff->frame->pict_type = AV_PICTURE_TYPE_NONE;
     }
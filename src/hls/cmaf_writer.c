@@ -0,0 +1,448 @@
+/*
+ * cmaf_writer.c — Fragmented MP4 (CMAF) box writer implementation
+ *
+ * Boxes are written front to back with a 32-bit size placeholder that
+ * is patched when the box is closed.  An undersized buffer sets the
+ * overflow flag and every later write becomes a no-op, so callers
+ * check once at the end.
+ */
+
+#include "cmaf_writer.h"
+
+#include <string.h>
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t pos;
+    bool overflow;
+} box_writer_t;
+
+/* ── Primitive writers ────────────────────────────────────────────── */
+
+static void put_bytes(box_writer_t *w, const void *data, size_t len) {
+    if (w->overflow || len > w->cap - w->pos) {
+        w->overflow = true;
+        return;
+    }
+    if (len)
+        memcpy(w->buf + w->pos, data, len);
+    w->pos += len;
+}
+
+static void put_zeros(box_writer_t *w, size_t len) {
+    if (w->overflow || len > w->cap - w->pos) {
+        w->overflow = true;
+        return;
+    }
+    memset(w->buf + w->pos, 0, len);
+    w->pos += len;
+}
+
+static void put8(box_writer_t *w, uint32_t v) {
+    uint8_t b = (uint8_t)v;
+    put_bytes(w, &b, 1);
+}
+
+static void put16(box_writer_t *w, uint32_t v) {
+    uint8_t b[2] = {(uint8_t)(v >> 8), (uint8_t)v};
+    put_bytes(w, b, 2);
+}
+
+static void put24(box_writer_t *w, uint32_t v) {
+    uint8_t b[3] = {(uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v};
+    put_bytes(w, b, 3);
+}
+
+static void put32(box_writer_t *w, uint32_t v) {
+    uint8_t b[4] = {(uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v};
+    put_bytes(w, b, 4);
+}
+
+static void put64(box_writer_t *w, uint64_t v) {
+    put32(w, (uint32_t)(v >> 32));
+    put32(w, (uint32_t)v);
+}
+
+static void patch32(box_writer_t *w, size_t at, uint32_t v) {
+    if (w->overflow)
+        return;
+    w->buf[at] = (uint8_t)(v >> 24);
+    w->buf[at + 1] = (uint8_t)(v >> 16);
+    w->buf[at + 2] = (uint8_t)(v >> 8);
+    w->buf[at + 3] = (uint8_t)v;
+}
+
+static size_t box_begin(box_writer_t *w, const char *type) {
+    size_t at = w->pos;
+    put32(w, 0);
+    put_bytes(w, type, 4);
+    return at;
+}
+
+static size_t full_box_begin(box_writer_t *w, const char *type, uint8_t version, uint32_t flags) {
+    size_t at = box_begin(w, type);
+    put8(w, version);
+    put24(w, flags);
+    return at;
+}
+
+static void box_end(box_writer_t *w, size_t at) {
+    patch32(w, at, (uint32_t)(w->pos - at));
+}
+
+static void put_matrix(box_writer_t *w) {
+    static const uint32_t unity[9] = {0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000};
+    for (int i = 0; i < 9; i++)
+        put32(w, unity[i]);
+}
+
+/* ── Init section ─────────────────────────────────────────────────── */
+
+static int aac_rate_index(int rate) {
+    static const int rates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+                                22050, 16000, 12000, 11025, 8000,  7350};
+    for (int i = 0; i < (int)(sizeof(rates) / sizeof(rates[0])); i++) {
+        if (rates[i] == rate)
+            return i;
+    }
+    return -1;
+}
+
+static void put_avc1(box_writer_t *w, const cmaf_init_config_t *cfg) {
+    size_t entry = box_begin(w, "avc1");
+    put_zeros(w, 6);
+    put16(w, 1); /* data_reference_index */
+    put_zeros(w, 16);
+    put16(w, (uint32_t)cfg->width);
+    put16(w, (uint32_t)cfg->height);
+    put32(w, 0x00480000); /* 72 dpi */
+    put32(w, 0x00480000);
+    put32(w, 0);
+    put16(w, 1); /* frame_count */
+    put_zeros(w, 32); /* compressorname */
+    put16(w, 0x0018);
+    put16(w, 0xFFFF);
+
+    size_t avcc = box_begin(w, "avcC");
+    put8(w, 1);
+    put_bytes(w, cfg->sps + 1, 3); /* profile, compatibility, level */
+    put8(w, 0xFF);                 /* 4-byte NAL lengths */
+    put8(w, 0xE1);                 /* one SPS */
+    put16(w, (uint32_t)cfg->sps_len);
+    put_bytes(w, cfg->sps, cfg->sps_len);
+    put8(w, 1); /* one PPS */
+    put16(w, (uint32_t)cfg->pps_len);
+    put_bytes(w, cfg->pps, cfg->pps_len);
+    box_end(w, avcc);
+    box_end(w, entry);
+}
+
+static void put_mp4a(box_writer_t *w, const cmaf_init_config_t *cfg, int rate_index) {
+    size_t entry = box_begin(w, "mp4a");
+    put_zeros(w, 6);
+    put16(w, 1); /* data_reference_index */
+    put_zeros(w, 8);
+    put16(w, (uint32_t)cfg->audio_channels);
+    put16(w, 16); /* samplesize */
+    put_zeros(w, 4);
+    put32(w, (uint32_t)cfg->audio_sample_rate << 16);
+
+    /* AudioSpecificConfig: AAC-LC, rate index, channel configuration */
+    uint32_t asc = (2u << 11) | ((uint32_t)rate_index << 7) | ((uint32_t)cfg->audio_channels << 3);
+    size_t esds = full_box_begin(w, "esds", 0, 0);
+    put8(w, 0x03); /* ES_Descriptor */
+    put8(w, 25);
+    put16(w, 0); /* ES_ID */
+    put8(w, 0);
+    put8(w, 0x04); /* DecoderConfigDescriptor */
+    put8(w, 17);
+    put8(w, 0x40); /* MPEG-4 audio */
+    put8(w, 0x15); /* audio stream */
+    put24(w, 0);   /* bufferSizeDB */
+    put32(w, 0);   /* maxBitrate */
+    put32(w, 0);   /* avgBitrate */
+    put8(w, 0x05); /* DecoderSpecificInfo */
+    put8(w, 2);
+    put16(w, asc);
+    put8(w, 0x06); /* SLConfigDescriptor */
+    put8(w, 1);
+    put8(w, 0x02);
+    box_end(w, esds);
+    box_end(w, entry);
+}
+
+static void put_trak(box_writer_t *w, const cmaf_init_config_t *cfg, bool audio, int rate_index) {
+    size_t trak = box_begin(w, "trak");
+
+    size_t tkhd = full_box_begin(w, "tkhd", 0, 3); /* enabled, in movie */
+    put32(w, 0);
+    put32(w, 0);
+    put32(w, audio ? CMAF_AUDIO_TRACK_ID : CMAF_VIDEO_TRACK_ID);
+    put32(w, 0);
+    put32(w, 0); /* duration: fragments only */
+    put_zeros(w, 8);
+    put16(w, 0); /* layer */
+    put16(w, 0); /* alternate_group */
+    put16(w, audio ? 0x0100 : 0);
+    put16(w, 0);
+    put_matrix(w);
+    put32(w, audio ? 0 : (uint32_t)cfg->width << 16);
+    put32(w, audio ? 0 : (uint32_t)cfg->height << 16);
+    box_end(w, tkhd);
+
+    size_t mdia = box_begin(w, "mdia");
+    size_t mdhd = full_box_begin(w, "mdhd", 0, 0);
+    put32(w, 0);
+    put32(w, 0);
+    put32(w, audio ? (uint32_t)cfg->audio_sample_rate : CMAF_VIDEO_TIMESCALE);
+    put32(w, 0);
+    put16(w, 0x55C4); /* "und" */
+    put16(w, 0);
+    box_end(w, mdhd);
+
+    size_t hdlr = full_box_begin(w, "hdlr", 0, 0);
+    put32(w, 0);
+    put_bytes(w, audio ? "soun" : "vide", 4);
+    put_zeros(w, 12);
+    put_bytes(w, audio ? "SoundHandler" : "VideoHandler", 13);
+    box_end(w, hdlr);
+
+    size_t minf = box_begin(w, "minf");
+    if (audio) {
+        size_t smhd = full_box_begin(w, "smhd", 0, 0);
+        put32(w, 0);
+        box_end(w, smhd);
+    } else {
+        size_t vmhd = full_box_begin(w, "vmhd", 0, 1);
+        put_zeros(w, 8);
+        box_end(w, vmhd);
+    }
+    size_t dinf = box_begin(w, "dinf");
+    size_t dref = full_box_begin(w, "dref", 0, 0);
+    put32(w, 1);
+    box_end(w, full_box_begin(w, "url ", 0, 1)); /* media in this file */
+    box_end(w, dref);
+    box_end(w, dinf);
+
+    size_t stbl = box_begin(w, "stbl");
+    size_t stsd = full_box_begin(w, "stsd", 0, 0);
+    put32(w, 1);
+    if (audio)
+        put_mp4a(w, cfg, rate_index);
+    else
+        put_avc1(w, cfg);
+    box_end(w, stsd);
+    /* Empty sample tables: every sample is in a fragment */
+    static const char *const empty[] = {"stts", "stsc", "stco"};
+    for (int i = 0; i < 3; i++) {
+        size_t b = full_box_begin(w, empty[i], 0, 0);
+        put32(w, 0);
+        box_end(w, b);
+    }
+    size_t stsz = full_box_begin(w, "stsz", 0, 0);
+    put32(w, 0);
+    put32(w, 0);
+    box_end(w, stsz);
+    box_end(w, stbl);
+
+    box_end(w, minf);
+    box_end(w, mdia);
+    box_end(w, trak);
+}
+
+int cmaf_write_init(const cmaf_init_config_t *cfg, uint8_t *buf, size_t cap) {
+    if (!cfg || !buf || !cfg->sps || cfg->sps_len < 4 || !cfg->pps || cfg->pps_len == 0)
+        return -1;
+    if (cfg->width <= 0 || cfg->height <= 0 || cfg->width > 0xFFFF || cfg->height > 0xFFFF)
+        return -1;
+    int rate_index = -1;
+    if (cfg->has_audio) {
+        rate_index = aac_rate_index(cfg->audio_sample_rate);
+        if (rate_index < 0 || cfg->audio_channels < 1 || cfg->audio_channels > 7)
+            return -1;
+    }
+
+    box_writer_t w = {.buf = buf, .cap = cap};
+
+    size_t ftyp = box_begin(&w, "ftyp");
+    put_bytes(&w, "iso6", 4);
+    put32(&w, 0);
+    put_bytes(&w, "iso6cmfcmp41", 12);
+    box_end(&w, ftyp);
+
+    size_t moov = box_begin(&w, "moov");
+    size_t mvhd = full_box_begin(&w, "mvhd", 0, 0);
+    put32(&w, 0);
+    put32(&w, 0);
+    put32(&w, 1000); /* timescale */
+    put32(&w, 0);
+    put32(&w, 0x00010000); /* rate 1.0 */
+    put16(&w, 0x0100);     /* volume 1.0 */
+    put_zeros(&w, 10);
+    put_matrix(&w);
+    put_zeros(&w, 24);
+    put32(&w, cfg->has_audio ? 3 : 2); /* next_track_ID */
+    box_end(&w, mvhd);
+
+    put_trak(&w, cfg, false, rate_index);
+    if (cfg->has_audio)
+        put_trak(&w, cfg, true, rate_index);
+
+    size_t mvex = box_begin(&w, "mvex");
+    for (uint32_t id = 1; id <= (cfg->has_audio ? 2u : 1u); id++) {
+        size_t trex = full_box_begin(&w, "trex", 0, 0);
+        put32(&w, id);
+        put32(&w, 1); /* default_sample_description_index */
+        put32(&w, 0);
+        put32(&w, 0);
+        put32(&w, 0);
+        box_end(&w, trex);
+    }
+    box_end(&w, mvex);
+    box_end(&w, moov);
+
+    return w.overflow ? -1 : (int)w.pos;
+}
+
+/* ── Fragments ────────────────────────────────────────────────────── */
+
+#define TRUN_FLAGS 0x000F01 /* data offset + duration, size, flags, CTS per sample */
+#define SAMPLE_SYNC 0x02000000
+#define SAMPLE_NON_SYNC 0x01010000
+
+static size_t run_data_len(const cmaf_track_run_t *run) {
+    size_t len = 0;
+    for (int i = 0; i < run->sample_count; i++)
+        len += run->samples[i].len;
+    return len;
+}
+
+static size_t moof_size(const cmaf_track_run_t *runs, int n_runs) {
+    size_t size = 8 + 16; /* moof + mfhd */
+    for (int r = 0; r < n_runs; r++) {
+        if (runs[r].sample_count > 0)
+            size += 64 + 16 * (size_t)runs[r].sample_count; /* traf, tfhd, tfdt, trun */
+    }
+    return size;
+}
+
+size_t cmaf_fragment_size(const cmaf_track_run_t *runs, int n_runs) {
+    size_t size = moof_size(runs, n_runs) + 8;
+    for (int r = 0; r < n_runs; r++)
+        size += run_data_len(&runs[r]);
+    return size;
+}
+
+int cmaf_write_fragment(uint32_t sequence, const cmaf_track_run_t *runs, int n_runs, uint8_t *buf,
+                        size_t cap) {
+    if (!runs || n_runs <= 0 || !buf)
+        return -1;
+
+    box_writer_t w = {.buf = buf, .cap = cap};
+    size_t data_offset = moof_size(runs, n_runs) + 8;
+
+    size_t moof = box_begin(&w, "moof");
+    size_t mfhd = full_box_begin(&w, "mfhd", 0, 0);
+    put32(&w, sequence);
+    box_end(&w, mfhd);
+
+    for (int r = 0; r < n_runs; r++) {
+        const cmaf_track_run_t *run = &runs[r];
+        if (run->sample_count <= 0)
+            continue;
+        size_t traf = box_begin(&w, "traf");
+        size_t tfhd = full_box_begin(&w, "tfhd", 0, 0x020000); /* default-base-is-moof */
+        put32(&w, run->track_id);
+        box_end(&w, tfhd);
+        size_t tfdt = full_box_begin(&w, "tfdt", 1, 0);
+        put64(&w, run->base_decode_time);
+        box_end(&w, tfdt);
+
+        size_t trun = full_box_begin(&w, "trun", 1, TRUN_FLAGS);
+        put32(&w, (uint32_t)run->sample_count);
+        put32(&w, (uint32_t)data_offset);
+        for (int i = 0; i < run->sample_count; i++) {
+            const cmaf_sample_t *s = &run->samples[i];
+            put32(&w, s->duration);
+            put32(&w, (uint32_t)s->len);
+            put32(&w, s->is_sync ? SAMPLE_SYNC : SAMPLE_NON_SYNC);
+            put32(&w, (uint32_t)s->cts_offset);
+        }
+        box_end(&w, trun);
+        box_end(&w, traf);
+        data_offset += run_data_len(run);
+    }
+    box_end(&w, moof);
+
+    size_t mdat = box_begin(&w, "mdat");
+    for (int r = 0; r < n_runs; r++) {
+        for (int i = 0; i < runs[r].sample_count; i++)
+            put_bytes(&w, runs[r].samples[i].data, runs[r].samples[i].len);
+    }
+    box_end(&w, mdat);
+
+    return w.overflow ? -1 : (int)w.pos;
+}
+
+/* ── Annex B ──────────────────────────────────────────────────────── */
+
+/* Offset of the next 00 00 01 at or after @i, or @len */
+static size_t find_start_code(const uint8_t *p, size_t len, size_t i) {
+    while (i + 2 < len) {
+        const uint8_t *one = memchr(p + i + 2, 0x01, len - i - 2);
+        if (!one)
+            return len;
+        size_t k = (size_t)(one - p);
+        if (p[k - 1] == 0 && p[k - 2] == 0)
+            return k - 2;
+        i = k - 1;
+    }
+    return len;
+}
+
+/* Next NAL unit after *pos; trailing zeros (4-byte start codes) trimmed */
+static const uint8_t *next_nal(const uint8_t *in, size_t len, size_t *pos, size_t *nal_len) {
+    size_t start = find_start_code(in, len, *pos);
+    if (start >= len)
+        return NULL;
+    size_t begin = start + 3;
+    size_t end = find_start_code(in, len, begin);
+    *pos = end;
+    while (end > begin && in[end - 1] == 0)
+        end--;
+    *nal_len = end - begin;
+    return in + begin;
+}
+
+const uint8_t *cmaf_find_nal(const uint8_t *in, size_t len, int type, size_t *nal_len) {
+    if (!in || !nal_len)
+        return NULL;
+    size_t pos = 0, n;
+    const uint8_t *nal;
+    while ((nal = next_nal(in, len, &pos, &n)) != NULL) {
+        if (n > 0 && (nal[0] & 0x1F) == type) {
+            *nal_len = n;
+            return nal;
+        }
+    }
+    return NULL;
+}
+
+int cmaf_annexb_to_avcc(const uint8_t *in, size_t len, uint8_t *out, size_t cap) {
+    if (!in || !out)
+        return -1;
+    box_writer_t w = {.buf = out, .cap = cap};
+    size_t pos = 0, n;
+    const uint8_t *nal;
+    while ((nal = next_nal(in, len, &pos, &n)) != NULL) {
+        if (n == 0)
+            continue;
+        int type = nal[0] & 0x1F;
+        if (type == 7 || type == 8 || type == 9) /* SPS, PPS, AUD */
+            continue;
+        put32(&w, (uint32_t)n);
+        put_bytes(&w, nal, n);
+    }
+    return w.overflow ? -1 : (int)w.pos;
+}
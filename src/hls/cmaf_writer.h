@@ -0,0 +1,128 @@
+/*
+ * cmaf_writer.h — Fragmented MP4 (CMAF) box writer
+ *
+ * Builds the two kinds of resource an fMP4 HLS stream is made of,
+ * directly into caller-supplied memory:
+ *
+ *   init section — ftyp + moov (avc1 video track 1, optional mp4a
+ *                  audio track 2, mvex/trex for fragments)
+ *   fragment     — moof (mfhd, one traf per track) + mdat
+ *
+ * Video samples are AVCC (4-byte length-prefixed NAL units);
+ * cmaf_annexb_to_avcc() converts encoder output.  Audio samples are raw
+ * AAC access units (no ADTS header).
+ *
+ * Thread-safety: all functions are stateless and thread-safe.
+ */
+
+#ifndef ROOTSTREAM_CMAF_WRITER_H
+#define ROOTSTREAM_CMAF_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Track IDs used in the init section and fragments */
+#define CMAF_VIDEO_TRACK_ID 1
+#define CMAF_AUDIO_TRACK_ID 2
+
+/** Video track timescale (matches MPEG-TS timestamps) */
+#define CMAF_VIDEO_TIMESCALE 90000
+
+/** Init section parameters */
+typedef struct {
+    int width;              /**< Coded width in pixels */
+    int height;             /**< Coded height in pixels */
+    const uint8_t *sps;     /**< H.264 SPS NAL unit (no start code) */
+    size_t sps_len;         /**< SPS length in bytes */
+    const uint8_t *pps;     /**< H.264 PPS NAL unit (no start code) */
+    size_t pps_len;         /**< PPS length in bytes */
+    bool has_audio;         /**< Add an AAC-LC track */
+    int audio_sample_rate;  /**< Audio timescale (e.g. 48000) */
+    int audio_channels;     /**< Channel count (1-7) */
+} cmaf_init_config_t;
+
+/** One sample in a fragment */
+typedef struct {
+    const uint8_t *data; /**< Sample bytes (AVCC video or raw AAC) */
+    size_t len;          /**< Size in bytes */
+    uint32_t duration;   /**< Duration in track timescale units */
+    int32_t cts_offset;  /**< PTS - DTS in track timescale units */
+    bool is_sync;        /**< Keyframe / independently decodable */
+} cmaf_sample_t;
+
+/** The samples of one track in a fragment */
+typedef struct {
+    uint32_t track_id;         /**< CMAF_VIDEO_TRACK_ID or CMAF_AUDIO_TRACK_ID */
+    uint64_t base_decode_time; /**< DTS of the first sample (track timescale) */
+    const cmaf_sample_t *samples;
+    int sample_count;
+} cmaf_track_run_t;
+
+/**
+ * cmaf_write_init — write ftyp + moov into @buf
+ *
+ * @param cfg  Track parameters (SPS/PPS required)
+ * @param buf  Output buffer
+ * @param cap  Buffer capacity in bytes
+ * @return     Bytes written, or -1 on bad config / buffer too small
+ */
+int cmaf_write_init(const cmaf_init_config_t *cfg, uint8_t *buf, size_t cap);
+
+/**
+ * cmaf_fragment_size — exact size cmaf_write_fragment() will produce
+ *
+ * @param runs    Track runs (tracks with no samples are omitted)
+ * @param n_runs  Number of runs
+ * @return        Size in bytes
+ */
+size_t cmaf_fragment_size(const cmaf_track_run_t *runs, int n_runs);
+
+/**
+ * cmaf_write_fragment — write moof + mdat for @runs into @buf
+ *
+ * @param sequence  Fragment sequence number (mfhd), starting at 1
+ * @param runs      Track runs; sample data is copied into the mdat
+ * @param n_runs    Number of runs
+ * @param buf       Output buffer
+ * @param cap       Buffer capacity in bytes
+ * @return          Bytes written, or -1 on error / buffer too small
+ */
+int cmaf_write_fragment(uint32_t sequence, const cmaf_track_run_t *runs, int n_runs, uint8_t *buf,
+                        size_t cap);
+
+/**
+ * cmaf_annexb_to_avcc — convert an Annex B access unit to AVCC samples
+ *
+ * Replaces start codes with 4-byte lengths and drops parameter-set and
+ * access-unit-delimiter NAL units (they live in the init section).
+ * @out needs at most @len + @len / 3 + 4 bytes.
+ *
+ * @param in       Annex B access unit
+ * @param len      Input length
+ * @param out      Output buffer
+ * @param cap      Output capacity
+ * @return         Bytes written, or -1 if @out is too small
+ */
+int cmaf_annexb_to_avcc(const uint8_t *in, size_t len, uint8_t *out, size_t cap);
+
+/**
+ * cmaf_find_nal — find the first NAL unit of @type in an Annex B buffer
+ *
+ * @param in       Annex B data
+ * @param len      Input length
+ * @param type     nal_unit_type (e.g. 7 = SPS, 8 = PPS)
+ * @param nal_len  Receives the NAL length (without start code)
+ * @return         Pointer to the NAL header byte, or NULL if absent
+ */
+const uint8_t *cmaf_find_nal(const uint8_t *in, size_t len, int type, size_t *nal_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_CMAF_WRITER_H */
@@ -18,6 +18,15 @@ extern "C" {
 /** Default number of segments to keep in a live sliding-window playlist */
 #define HLS_DEFAULT_WINDOW_SEGMENTS 5
 
+/** Default LL-HLS segment duration in seconds */
+#define HLS_DEFAULT_LL_SEGMENT_DURATION_S 2
+
+/** Default LL-HLS partial segment target in milliseconds */
+#define HLS_DEFAULT_PART_TARGET_MS 200
+
+/** Default number of complete segments kept in an LL-HLS playlist */
+#define HLS_DEFAULT_LL_WINDOW_SEGMENTS 12
+
 /** Maximum path length for HLS output directory */
 #define HLS_MAX_PATH 512
 
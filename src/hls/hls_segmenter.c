@@ -1,10 +1,19 @@
 /*
  * hls_segmenter.c — HLS segment lifecycle manager implementation
+ *
+ * Each rung owns a buffered ts_writer on "<segment>.tmp".  Closing a
+ * segment flushes the writer and renames the file into place.  With
+ * several rungs, rungs 1..N-1 each have a worker thread; open, write
+ * and close are posted to all workers as one job while the caller
+ * runs rung 0 itself, then waits for the rest.  A wake-up costs more
+ * than muxing a typical delta frame, so write batches smaller than
+ * PARALLEL_MIN_BYTES are muxed on the caller's thread instead.
  */
 
 #include "hls_segmenter.h"
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,40 +23,276 @@
 #include "ts_writer.h"
 
 #define MAX_SEGS 512
+#define SEG_PATH_MAX (HLS_MAX_PATH + HLS_MAX_SEG_NAME + 8)
+#define PARALLEL_MIN_BYTES (64 * 1024)
 
-struct hls_segmenter_s {
-    hls_segmenter_config_t cfg;
+typedef enum { JOB_OPEN, JOB_WRITE, JOB_CLOSE } hls_job_t;
+
+struct hls_segmenter_s;
+
+typedef struct {
+    struct hls_segmenter_s *owner;
+    int index;
     hls_segment_t segs[MAX_SEGS];
     int seg_count;
-    int seg_index; /* current open segment index */
     ts_writer_t *ts;
     int ts_fd;
+    char cur_name[HLS_MAX_SEG_NAME]; /* Open segment's final file name */
+    int rc;                          /* Result of the last job */
+    pthread_t thread;
+    bool thread_started;
+} hls_rung_t;
+
+struct hls_segmenter_s {
+    hls_segmenter_config_t cfg;
+    int rung_count;
+    hls_rung_t rungs[HLS_MAX_VARIANTS];
+    int seg_index; /* current open segment index */
     bool segment_open;
+
+    /* Job posted to the rung workers; read-only while job_pending > 0 */
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    uint64_t job_gen;
+    int job_pending;
+    bool stopping;
+    hls_job_t job;
+    const hls_frame_t *job_frames;
+    int job_n;
+    double job_duration;
 };
 
+/* ── Per-rung work ───────────────────────────────────────────────── */
+
+static int segment_name(const hls_segmenter_t *s, int r, char out[HLS_MAX_SEG_NAME]) {
+    int n;
+    if (s->rung_count == 1) {
+        n = snprintf(out, HLS_MAX_SEG_NAME, "%.*s%d.ts",
+                     (int)(HLS_MAX_SEG_NAME - 14), /* leave room for index + ".ts" */
+                     s->cfg.base_name, s->seg_index);
+    } else {
+        n = snprintf(out, HLS_MAX_SEG_NAME, "%.*s%s_%d.ts",
+                     (int)(HLS_MAX_SEG_NAME - 30), /* rung name + index + ".ts" */
+                     s->cfg.base_name, s->cfg.renditions[r].name, s->seg_index);
+    }
+    return (n > 0 && n < HLS_MAX_SEG_NAME) ? 0 : -1;
+}
+
+static void segment_paths(const hls_segmenter_t *s, const hls_rung_t *rung, char *path,
+                          char *tmp) {
+    snprintf(path, SEG_PATH_MAX, "%s/%s", s->cfg.output_dir, rung->cur_name);
+    snprintf(tmp, SEG_PATH_MAX, "%s/%s.tmp", s->cfg.output_dir, rung->cur_name);
+}
+
+/* Drop the open segment without publishing it */
+static void rung_abandon(hls_segmenter_t *s, hls_rung_t *rung) {
+    char path[SEG_PATH_MAX], tmp[SEG_PATH_MAX];
+    ts_writer_destroy(rung->ts);
+    rung->ts = NULL;
+    if (rung->ts_fd >= 0) {
+        close(rung->ts_fd);
+        rung->ts_fd = -1;
+        segment_paths(s, rung, path, tmp);
+        unlink(tmp);
+    }
+}
+
+static int rung_open(hls_segmenter_t *s, hls_rung_t *rung) {
+    char path[SEG_PATH_MAX], tmp[SEG_PATH_MAX];
+    if (segment_name(s, rung->index, rung->cur_name) != 0)
+        return -1;
+    segment_paths(s, rung, path, tmp);
+
+    rung->ts_fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (rung->ts_fd < 0)
+        return -1;
+
+    ts_writer_config_t tcfg = {
+        .video_type = TS_STREAM_H264,
+        .audio_type = s->cfg.with_audio ? TS_STREAM_AAC : TS_STREAM_NONE,
+    };
+    rung->ts = ts_writer_create_ex(rung->ts_fd, &tcfg);
+    if (!rung->ts || ts_writer_write_pat_pmt(rung->ts) != 0) {
+        rung_abandon(s, rung);
+        return -1;
+    }
+    return 0;
+}
+
+static int rung_write(hls_rung_t *rung, const hls_frame_t *frames, int n) {
+    for (int i = 0; i < n; i++) {
+        const hls_frame_t *f = &frames[i];
+        if (f->rendition != rung->index)
+            continue;
+        int rc = f->is_audio ? ts_writer_write_audio(rung->ts, f->data, f->len, f->pts_90khz)
+                             : ts_writer_write_video(rung->ts, f->data, f->len, f->pts_90khz,
+                                                     f->dts_90khz, f->is_kf);
+        if (rc != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int rung_close(hls_segmenter_t *s, hls_rung_t *rung, double duration_s) {
+    char path[SEG_PATH_MAX], tmp[SEG_PATH_MAX];
+    segment_paths(s, rung, path, tmp);
+
+    int rc = ts_writer_flush(rung->ts);
+    ts_writer_destroy(rung->ts);
+    rung->ts = NULL;
+    if (close(rung->ts_fd) != 0)
+        rc = -1;
+    rung->ts_fd = -1;
+
+    /* Publish the complete segment in one step */
+    if (rc == 0 && rename(tmp, path) != 0)
+        rc = -1;
+    if (rc != 0) {
+        unlink(tmp);
+        return -1;
+    }
+
+    if (rung->seg_count < MAX_SEGS) {
+        hls_segment_t *seg = &rung->segs[rung->seg_count];
+        memcpy(seg->filename, rung->cur_name, HLS_MAX_SEG_NAME);
+        seg->duration_s = duration_s;
+        seg->is_discontinuity = false;
+        rung->seg_count++;
+    }
+    return 0;
+}
+
+static int rung_run(hls_segmenter_t *s, hls_rung_t *rung) {
+    switch (s->job) {
+    case JOB_OPEN:
+        return rung_open(s, rung);
+    case JOB_WRITE:
+        return rung_write(rung, s->job_frames, s->job_n);
+    case JOB_CLOSE:
+        return rung_close(s, rung, s->job_duration);
+    }
+    return -1;
+}
+
+static void *rung_worker(void *arg) {
+    hls_rung_t *rung = arg;
+    hls_segmenter_t *s = rung->owner;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->stopping && s->job_gen == seen)
+            pthread_cond_wait(&s->work_cv, &s->lock);
+        if (s->stopping)
+            break;
+        seen = s->job_gen;
+        pthread_mutex_unlock(&s->lock);
+
+        rung->rc = rung_run(s, rung);
+
+        pthread_mutex_lock(&s->lock);
+        if (--s->job_pending == 0)
+            pthread_cond_signal(&s->done_cv);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/* Run @job on every rung, in parallel unless @inline_only */
+static int run_job(hls_segmenter_t *s, hls_job_t job, const hls_frame_t *frames, int n,
+                   double duration_s, bool inline_only) {
+    s->job = job;
+    s->job_frames = frames;
+    s->job_n = n;
+    s->job_duration = duration_s;
+    if (s->rung_count == 1 || inline_only) {
+        int rc = 0;
+        for (int r = 0; r < s->rung_count; r++) {
+            if (rung_run(s, &s->rungs[r]) != 0)
+                rc = -1;
+        }
+        return rc;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->job_pending = s->rung_count - 1;
+    s->job_gen++;
+    pthread_cond_broadcast(&s->work_cv);
+    pthread_mutex_unlock(&s->lock);
+
+    s->rungs[0].rc = rung_run(s, &s->rungs[0]);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->job_pending > 0)
+        pthread_cond_wait(&s->done_cv, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    int rc = 0;
+    for (int r = 0; r < s->rung_count; r++) {
+        if (s->rungs[r].rc != 0)
+            rc = -1;
+    }
+    return rc;
+}
+
+/* ── Lifecycle ───────────────────────────────────────────────────── */
+
 hls_segmenter_t *hls_segmenter_create(const hls_segmenter_config_t *cfg) {
-    if (!cfg)
+    if (!cfg || cfg->rendition_count > HLS_MAX_VARIANTS)
         return NULL;
     hls_segmenter_t *s = calloc(1, sizeof(*s));
     if (!s)
         return NULL;
     s->cfg = *cfg;
-    s->ts_fd = -1;
     if (s->cfg.target_duration_s <= 0)
         s->cfg.target_duration_s = HLS_DEFAULT_SEGMENT_DURATION_S;
     if (s->cfg.window_size <= 0)
         s->cfg.window_size = HLS_DEFAULT_WINDOW_SEGMENTS;
+    s->rung_count = s->cfg.rendition_count > 1 ? s->cfg.rendition_count : 1;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->work_cv, NULL);
+    pthread_cond_init(&s->done_cv, NULL);
+
+    for (int r = 0; r < HLS_MAX_VARIANTS; r++) {
+        s->rungs[r].owner = s;
+        s->rungs[r].index = r;
+        s->rungs[r].ts_fd = -1;
+    }
+    for (int r = 0; s->rung_count > 1 && r < s->rung_count; r++) {
+        if (s->cfg.renditions[r].name[0] == '\0') {
+            hls_segmenter_destroy(s);
+            return NULL;
+        }
+    }
+    for (int r = 1; r < s->rung_count; r++) {
+        if (pthread_create(&s->rungs[r].thread, NULL, rung_worker, &s->rungs[r]) != 0) {
+            hls_segmenter_destroy(s);
+            return NULL;
+        }
+        s->rungs[r].thread_started = true;
+    }
     return s;
 }
 
 void hls_segmenter_destroy(hls_segmenter_t *seg) {
     if (!seg)
         return;
-    if (seg->ts_fd >= 0) {
-        close(seg->ts_fd);
-        seg->ts_fd = -1;
+
+    pthread_mutex_lock(&seg->lock);
+    seg->stopping = true;
+    pthread_cond_broadcast(&seg->work_cv);
+    pthread_mutex_unlock(&seg->lock);
+    for (int r = 0; r < seg->rung_count; r++) {
+        if (seg->rungs[r].thread_started)
+            pthread_join(seg->rungs[r].thread, NULL);
+        rung_abandon(seg, &seg->rungs[r]);
     }
-    ts_writer_destroy(seg->ts);
+
+    pthread_cond_destroy(&seg->done_cv);
+    pthread_cond_destroy(&seg->work_cv);
+    pthread_mutex_destroy(&seg->lock);
     free(seg);
 }
 
@@ -55,92 +300,118 @@ int hls_segmenter_open_segment(hls_segmenter_t *seg) {
     if (!seg || seg->segment_open)
         return -1;
 
-    /* Build path: dir/base_nameINDEX.ts — total bounded by HLS_MAX_PATH+SEG */
-    char path[HLS_MAX_PATH + HLS_MAX_SEG_NAME * 2 + 4];
-    snprintf(path, sizeof(path), "%s/%.*s%d.ts", seg->cfg.output_dir,
-             (int)(HLS_MAX_SEG_NAME - 14), /* leave room for index + ".ts" */
-             seg->cfg.base_name, seg->seg_index);
-
-    seg->ts_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (seg->ts_fd < 0)
-        return -1;
-
-    ts_writer_destroy(seg->ts);
-    seg->ts = ts_writer_create(seg->ts_fd);
-    if (!seg->ts) {
-        close(seg->ts_fd);
-        seg->ts_fd = -1;
+    if (run_job(seg, JOB_OPEN, NULL, 0, 0.0, false) != 0) {
+        for (int r = 0; r < seg->rung_count; r++)
+            rung_abandon(seg, &seg->rungs[r]);
         return -1;
     }
 
-    if (ts_writer_write_pat_pmt(seg->ts) != 0)
-        return -1;
-
     seg->segment_open = true;
     return 0;
 }
 
 int hls_segmenter_write(hls_segmenter_t *seg, const uint8_t *data, size_t len, uint64_t pts_90khz,
                         bool is_kf) {
-    if (!seg || !seg->segment_open || !seg->ts)
+    hls_frame_t f = {
+        .rendition = 0,
+        .data = data,
+        .len = len,
+        .pts_90khz = pts_90khz,
+        .dts_90khz = pts_90khz,
+        .is_kf = is_kf,
+    };
+    return hls_segmenter_write_frames(seg, &f, 1);
+}
+
+int hls_segmenter_write_frames(hls_segmenter_t *seg, const hls_frame_t *frames, int n) {
+    if (!seg || !seg->segment_open || !frames || n <= 0)
         return -1;
-    return ts_writer_write_pes(seg->ts, data, len, pts_90khz, is_kf);
+    size_t bytes = 0;
+    for (int i = 0; i < n; i++) {
+        if (frames[i].rendition < 0 || frames[i].rendition >= seg->rung_count)
+            return -1;
+        bytes += frames[i].len;
+    }
+    return run_job(seg, JOB_WRITE, frames, n, 0.0, bytes < PARALLEL_MIN_BYTES);
 }
 
 int hls_segmenter_close_segment(hls_segmenter_t *seg, double duration_s) {
     if (!seg || !seg->segment_open)
         return -1;
 
-    close(seg->ts_fd);
-    seg->ts_fd = -1;
-    ts_writer_destroy(seg->ts);
-    seg->ts = NULL;
+    int rc = run_job(seg, JOB_CLOSE, NULL, 0, duration_s, false);
     seg->segment_open = false;
-
-    if (seg->seg_count < MAX_SEGS) {
-        hls_segment_t *s = &seg->segs[seg->seg_count];
-        snprintf(s->filename, HLS_MAX_SEG_NAME, "%.*s%d.ts", (int)(HLS_MAX_SEG_NAME - 14),
-                 seg->cfg.base_name, seg->seg_index);
-        s->duration_s = duration_s;
-        s->is_discontinuity = false;
-        seg->seg_count++;
-    }
     seg->seg_index++;
-    return 0;
+    return rc;
 }
 
-int hls_segmenter_update_manifest(hls_segmenter_t *seg) {
-    if (!seg || seg->seg_count == 0)
-        return -1;
+/* ── Manifests ───────────────────────────────────────────────────── */
 
-    char path[HLS_MAX_PATH + HLS_MAX_SEG_NAME + 2];
-    char tmp[HLS_MAX_PATH + HLS_MAX_SEG_NAME + 8];
-    snprintf(path, sizeof(path), "%s/%s", seg->cfg.output_dir, seg->cfg.playlist_name);
+static int write_file_atomic(const char *path, const char *buf, size_t len) {
+    char tmp[SEG_PATH_MAX + 8];
     snprintf(tmp, sizeof(tmp), "%s.tmp", path);
 
+    FILE *f = fopen(tmp, "w");
+    if (!f)
+        return -1;
+    if (fwrite(buf, 1, len, f) != len) {
+        fclose(f);
+        remove(tmp);
+        return -1;
+    }
+    if (fclose(f) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return rename(tmp, path) == 0 ? 0 : -1;
+}
+
+static int write_media_playlist(const hls_segmenter_t *seg, const hls_rung_t *rung,
+                                const char *name) {
+    char path[SEG_PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", seg->cfg.output_dir, name);
+
     char buf[65536];
     int n;
     if (seg->cfg.vod_mode) {
-        n = m3u8_write_vod(seg->segs, seg->seg_count, seg->cfg.target_duration_s, buf, sizeof(buf));
+        n = m3u8_write_vod(rung->segs, rung->seg_count, seg->cfg.target_duration_s, buf,
+                           sizeof(buf));
     } else {
-        n = m3u8_write_live(seg->segs, seg->seg_count, seg->cfg.window_size,
+        n = m3u8_write_live(rung->segs, rung->seg_count, seg->cfg.window_size,
                             seg->cfg.target_duration_s, 0, buf, sizeof(buf));
     }
     if (n < 0)
         return -1;
+    return write_file_atomic(path, buf, (size_t)n);
+}
 
-    FILE *f = fopen(tmp, "w");
-    if (!f)
-        return -1;
-    if (fwrite(buf, 1, (size_t)n, f) != (size_t)n) {
-        fclose(f);
-        remove(tmp);
+int hls_segmenter_update_manifest(hls_segmenter_t *seg) {
+    if (!seg || seg->rungs[0].seg_count == 0)
         return -1;
+
+    if (seg->rung_count == 1)
+        return write_media_playlist(seg, &seg->rungs[0], seg->cfg.playlist_name);
+
+    char names[HLS_MAX_VARIANTS][sizeof(seg->cfg.renditions[0].name) + 8];
+    const char *uris[HLS_MAX_VARIANTS];
+    int bandwidths[HLS_MAX_VARIANTS];
+    for (int r = 0; r < seg->rung_count; r++) {
+        snprintf(names[r], sizeof(names[r]), "%s.m3u8", seg->cfg.renditions[r].name);
+        if (write_media_playlist(seg, &seg->rungs[r], names[r]) != 0)
+            return -1;
+        uris[r] = names[r];
+        bandwidths[r] = seg->cfg.renditions[r].bandwidth_bps;
     }
-    fclose(f);
-    return rename(tmp, path) == 0 ? 0 : -1;
+
+    char path[SEG_PATH_MAX];
+    char buf[4096];
+    snprintf(path, sizeof(path), "%s/%s", seg->cfg.output_dir, seg->cfg.playlist_name);
+    int n = m3u8_write_master(uris, bandwidths, seg->rung_count, 0, 0, buf, sizeof(buf));
+    if (n < 0)
+        return -1;
+    return write_file_atomic(path, buf, (size_t)n);
 }
 
 size_t hls_segmenter_segment_count(const hls_segmenter_t *seg) {
-    return seg ? (size_t)seg->seg_count : 0;
+    return seg ? (size_t)seg->rungs[0].seg_count : 0;
 }
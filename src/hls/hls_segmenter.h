@@ -5,6 +5,16 @@
  * files, tracks open/complete status, enforces the sliding window by
  * deleting old segments, and updates the M3U8 manifest atomically.
  *
+ * A segment is written to "<name>.ts.tmp" through a buffered ts_writer
+ * and renamed into place when it is closed, so a server on the same
+ * host never serves a partial segment.
+ *
+ * Multi-rendition mode (rendition_count > 1) writes every rung of an
+ * ABR ladder in lock step: segments open and close together, and
+ * hls_segmenter_write_frames() muxes each rung's frames on its own
+ * worker thread.  Rung r writes "<base><name>_N.ts" and "<name>.m3u8";
+ * playlist_name becomes the master playlist.
+ *
  * Typical usage
  * ─────────────
  *   hls_segmenter_t *seg = hls_segmenter_create(&cfg);
@@ -13,6 +23,8 @@
  *   hls_segmenter_close_segment(seg, dur);  // finish segment
  *   hls_segmenter_update_manifest(seg);     // rewrite M3U8
  *   hls_segmenter_destroy(seg);
+ *
+ * Thread-safety: NOT thread-safe; drive each segmenter from one thread.
  */
 
 #ifndef ROOTSTREAM_HLS_SEGMENTER_H
@@ -29,16 +41,36 @@
 extern "C" {
 #endif
 
+/** One rung of a multi-rendition ladder */
+typedef struct {
+    char name[16];     /**< Label used in file names (e.g. "720p") */
+    int bandwidth_bps; /**< Advertised in the master playlist */
+} hls_rendition_t;
+
 /** HLS segmenter configuration */
 typedef struct {
-    char output_dir[HLS_MAX_PATH];        /**< Directory for .ts and .m3u8 files */
-    char base_name[HLS_MAX_SEG_NAME];     /**< Segment base name (e.g. "seg") */
-    char playlist_name[HLS_MAX_SEG_NAME]; /**< Playlist file name */
-    int target_duration_s;                /**< Target segment duration */
-    int window_size;                      /**< Sliding window (live) */
-    bool vod_mode;                        /**< Write VOD playlist */
+    char output_dir[HLS_MAX_PATH];                /**< Directory for .ts and .m3u8 files */
+    char base_name[HLS_MAX_SEG_NAME];             /**< Segment base name (e.g. "seg") */
+    char playlist_name[HLS_MAX_SEG_NAME];         /**< Playlist (master if multi-rendition) */
+    int target_duration_s;                        /**< Target segment duration */
+    int window_size;                              /**< Sliding window (live) */
+    bool vod_mode;                                /**< Write VOD playlist */
+    bool with_audio;                              /**< Mux an AAC (ADTS) audio PID */
+    int rendition_count;                          /**< Ladder rungs; 0 or 1 = single */
+    hls_rendition_t renditions[HLS_MAX_VARIANTS]; /**< Used when rendition_count > 1 */
 } hls_segmenter_config_t;
 
+/** One frame for hls_segmenter_write_frames() */
+typedef struct {
+    int rendition;       /**< Rung index (0 in single-rendition mode) */
+    const uint8_t *data; /**< Access unit or ADTS frame(s) */
+    size_t len;          /**< Data length in bytes */
+    uint64_t pts_90khz;  /**< Presentation timestamp in 90 kHz units */
+    uint64_t dts_90khz;  /**< Decode timestamp (video; ignored for audio) */
+    bool is_kf;          /**< IDR / keyframe (video) */
+    bool is_audio;       /**< Audio frame (requires with_audio) */
+} hls_frame_t;
+
 /** Opaque HLS segmenter */
 typedef struct hls_segmenter_s hls_segmenter_t;
 
@@ -58,7 +90,7 @@ hls_segmenter_t *hls_segmenter_create(const hls_segmenter_config_t *cfg);
 void hls_segmenter_destroy(hls_segmenter_t *seg);
 
 /**
- * hls_segmenter_open_segment — begin a new segment file
+ * hls_segmenter_open_segment — begin a new segment file (on every rung)
  *
  * @param seg  Segmenter
  * @return     0 on success, -1 on error
@@ -68,6 +100,8 @@ int hls_segmenter_open_segment(hls_segmenter_t *seg);
 /**
  * hls_segmenter_write — write a NAL frame to the current open segment
  *
+ * Writes to rung 0 with DTS == PTS.
+ *
  * @param seg        Segmenter
  * @param data       NAL unit data
  * @param len        Data length in bytes
@@ -79,7 +113,21 @@ int hls_segmenter_write(hls_segmenter_t *seg, const uint8_t *data, size_t len, u
                         bool is_kf);
 
 /**
- * hls_segmenter_close_segment — finalise the current segment
+ * hls_segmenter_write_frames — write frames to their rungs' open segments
+ *
+ * In multi-rendition mode each rung's frames are muxed in parallel on
+ * that rung's worker thread; the call returns once all are written.
+ * Frames for one rung are written in array order.
+ *
+ * @param seg     Segmenter
+ * @param frames  Frames, any mix of rungs and audio/video
+ * @param n       Number of frames
+ * @return        0 on success, -1 if any frame failed
+ */
+int hls_segmenter_write_frames(hls_segmenter_t *seg, const hls_frame_t *frames, int n);
+
+/**
+ * hls_segmenter_close_segment — flush and rename the current segment(s)
  *
  * @param seg         Segmenter
  * @param duration_s  Actual segment duration in seconds
@@ -0,0 +1,798 @@
+/*
+ * llhls_packager.c — Low-latency HLS packager implementation
+ *
+ * The writer thread keeps the samples of the part being built in
+ * growable buffers.  A video frame's duration is only known when the
+ * next frame arrives, so the newest frame always stays at the tail of
+ * the list and each cut happens at the incoming frame's DTS.  Closing
+ * a part writes moof + mdat straight into a new blob and publishes it
+ * under the lock; closing a segment concatenates its part blobs.
+ *
+ * Segments live in a ring of window_size + 1 slots indexed by media
+ * sequence number; the extra slot is the open segment.  Parts are kept
+ * (and advertised) only for segments within three target durations of
+ * the live edge.
+ */
+
+#include "llhls_packager.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cmaf_writer.h"
+#include "m3u8_writer.h"
+
+#define AAC_FRAME_SAMPLES 1024
+#define PLAYLIST_MAX (64 * 1024)
+#define INIT_MAX 2048
+#define CONTENT_TYPE_PLAYLIST "application/vnd.apple.mpegurl"
+#define CONTENT_TYPE_MP4 "video/mp4"
+
+/* ── Blobs ────────────────────────────────────────────────────────── */
+
+typedef struct {
+    atomic_int refs;
+    size_t len;
+    uint8_t data[];
+} blob_t;
+
+static blob_t *blob_alloc(size_t len) {
+    blob_t *b = malloc(sizeof(*b) + len);
+    if (!b)
+        return NULL;
+    atomic_init(&b->refs, 1);
+    b->len = len;
+    return b;
+}
+
+static blob_t *blob_ref(blob_t *b) {
+    atomic_fetch_add_explicit(&b->refs, 1, memory_order_relaxed);
+    return b;
+}
+
+static void blob_unref(blob_t *b) {
+    if (b && atomic_fetch_sub_explicit(&b->refs, 1, memory_order_acq_rel) == 1)
+        free(b);
+}
+
+/* ── Writer-side buffers ──────────────────────────────────────────── */
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} bytes_t;
+
+typedef struct {
+    size_t off; /* Into the track's bytes_t */
+    size_t len;
+    uint64_t time; /* DTS in track timescale */
+    uint32_t duration;
+    int32_t cts_offset;
+    bool is_sync;
+} held_sample_t;
+
+typedef struct {
+    held_sample_t *v;
+    int n;
+    int cap;
+    bytes_t bytes;
+} track_buf_t;
+
+static int bytes_reserve(bytes_t *b, size_t extra) {
+    if (b->cap - b->len >= extra)
+        return 0;
+    size_t cap = b->cap ? b->cap : 64 * 1024;
+    while (cap - b->len < extra)
+        cap *= 2;
+    uint8_t *d = realloc(b->data, cap);
+    if (!d)
+        return -1;
+    b->data = d;
+    b->cap = cap;
+    return 0;
+}
+
+static held_sample_t *track_push(track_buf_t *t) {
+    if (t->n == t->cap) {
+        int cap = t->cap ? t->cap * 2 : 64;
+        held_sample_t *v = realloc(t->v, (size_t)cap * sizeof(*v));
+        if (!v)
+            return NULL;
+        t->v = v;
+        t->cap = cap;
+    }
+    return &t->v[t->n++];
+}
+
+/* Drop the first @n samples and their bytes */
+static void track_consume(track_buf_t *t, int n) {
+    if (n >= t->n) {
+        t->n = 0;
+        t->bytes.len = 0;
+        return;
+    }
+    size_t cut = t->v[n].off;
+    memmove(t->bytes.data, t->bytes.data + cut, t->bytes.len - cut);
+    t->bytes.len -= cut;
+    memmove(t->v, t->v + n, (size_t)(t->n - n) * sizeof(*t->v));
+    t->n -= n;
+    for (int i = 0; i < t->n; i++)
+        t->v[i].off -= cut;
+}
+
+static void track_free(track_buf_t *t) {
+    free(t->v);
+    free(t->bytes.data);
+}
+
+/* ── Shared state ─────────────────────────────────────────────────── */
+
+typedef struct {
+    int64_t msn;
+    bool complete;
+    hls_segment_t info;
+    hls_part_t part_info[LLHLS_MAX_PARTS];
+    blob_t *part_blob[LLHLS_MAX_PARTS];
+    int n_parts;
+    bool parts_dropped;
+    blob_t *blob; /* Whole segment once complete */
+} segment_t;
+
+struct llhls_packager_s {
+    llhls_config_t cfg;
+    uint64_t part_target; /* 90 kHz */
+    uint64_t seg_target;  /* 90 kHz */
+    char init_name[HLS_MAX_SEG_NAME];
+
+    /* Writer thread only */
+    bool started;
+    track_buf_t video; /* Samples of the open part; the last one is held */
+    track_buf_t audio; /* Audio not yet placed in a part */
+    bool audio_started;
+    uint64_t audio_next; /* Audio timescale */
+    uint64_t part_start; /* 90 kHz DTS */
+    uint64_t seg_start;
+    uint32_t fragment_seq;
+
+    /* Shared with request threads, under lock */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    blob_t *init;
+    segment_t *ring;
+    int ring_size;
+    int64_t open_msn;
+    int active_requests;
+    bool stopping;
+};
+
+static segment_t *slot(llhls_packager_t *p, int64_t msn) {
+    return &p->ring[msn % p->ring_size];
+}
+
+static int64_t oldest_msn(const llhls_packager_t *p) {
+    int64_t oldest = p->open_msn - p->cfg.window_size;
+    return oldest < 0 ? 0 : oldest;
+}
+
+static void segment_clear(segment_t *s) {
+    for (int i = 0; i < s->n_parts; i++)
+        blob_unref(s->part_blob[i]);
+    blob_unref(s->blob);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Begin segment @msn in its ring slot, evicting what was there (locked) */
+static void open_segment(llhls_packager_t *p, int64_t msn) {
+    segment_t *s = slot(p, msn);
+    segment_clear(s);
+    s->msn = msn;
+    snprintf(s->info.filename, sizeof(s->info.filename), "%s%lld.m4s", p->cfg.base_name,
+             (long long)msn);
+    p->open_msn = msn;
+}
+
+/* Stop advertising parts more than three target durations back (locked) */
+static void drop_old_parts(llhls_packager_t *p) {
+    double keep_s = 3.0 * p->cfg.target_duration_s;
+    double age = 0.0;
+    for (int64_t msn = p->open_msn - 1; msn >= oldest_msn(p); msn--) {
+        segment_t *s = slot(p, msn);
+        if (age > keep_s && !s->parts_dropped) {
+            for (int i = 0; i < s->n_parts; i++) {
+                blob_unref(s->part_blob[i]);
+                s->part_blob[i] = NULL;
+            }
+            s->parts_dropped = true;
+        }
+        age += s->info.duration_s;
+    }
+}
+
+/* ── Writer ───────────────────────────────────────────────────────── */
+
+llhls_packager_t *llhls_create(const llhls_config_t *cfg) {
+    if (!cfg || cfg->width <= 0 || cfg->height <= 0 || !cfg->base_name[0] ||
+        !cfg->playlist_name[0] || cfg->window_size > LLHLS_MAX_WINDOW || cfg->window_size < 0)
+        return NULL;
+
+    llhls_packager_t *p = calloc(1, sizeof(*p));
+    if (!p)
+        return NULL;
+    p->cfg = *cfg;
+    if (p->cfg.target_duration_s <= 0)
+        p->cfg.target_duration_s = HLS_DEFAULT_LL_SEGMENT_DURATION_S;
+    if (p->cfg.part_target_ms <= 0)
+        p->cfg.part_target_ms = HLS_DEFAULT_PART_TARGET_MS;
+    if (p->cfg.window_size == 0)
+        p->cfg.window_size = HLS_DEFAULT_LL_WINDOW_SEGMENTS;
+    if (p->cfg.audio_sample_rate <= 0)
+        p->cfg.audio_sample_rate = 48000;
+    if (p->cfg.audio_channels <= 0)
+        p->cfg.audio_channels = 2;
+    p->part_target = (uint64_t)p->cfg.part_target_ms * 90;
+    p->seg_target = (uint64_t)p->cfg.target_duration_s * 90000;
+    snprintf(p->init_name, sizeof(p->init_name), "%sinit.mp4", p->cfg.base_name);
+    if (p->part_target >= p->seg_target) {
+        free(p);
+        return NULL;
+    }
+
+    p->ring_size = p->cfg.window_size + 1;
+    p->ring = calloc((size_t)p->ring_size, sizeof(*p->ring));
+    if (!p->ring) {
+        free(p);
+        return NULL;
+    }
+    open_segment(p, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return p;
+}
+
+void llhls_destroy(llhls_packager_t *p) {
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&p->lock);
+    p->stopping = true;
+    pthread_cond_broadcast(&p->cond);
+    while (p->active_requests > 0)
+        pthread_cond_wait(&p->cond, &p->lock);
+    pthread_mutex_unlock(&p->lock);
+
+    for (int i = 0; i < p->ring_size; i++)
+        segment_clear(&p->ring[i]);
+    free(p->ring);
+    blob_unref(p->init);
+    track_free(&p->video);
+    track_free(&p->audio);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
+
+static uint64_t audio_to_90k(const llhls_packager_t *p, uint64_t t) {
+    return t * 90000 / (uint64_t)p->cfg.audio_sample_rate;
+}
+
+/* Whole segment = its parts back to back (part blobs are immutable) */
+static blob_t *concat_parts(const segment_t *seg) {
+    size_t total = 0;
+    for (int i = 0; i < seg->n_parts; i++)
+        total += seg->part_blob[i]->len;
+    blob_t *whole = blob_alloc(total);
+    if (!whole)
+        return NULL;
+    size_t off = 0;
+    for (int i = 0; i < seg->n_parts; i++) {
+        memcpy(whole->data + off, seg->part_blob[i]->data, seg->part_blob[i]->len);
+        off += seg->part_blob[i]->len;
+    }
+    return whole;
+}
+
+/* Publish the open part, ending at @end_dts; optionally end the segment */
+static int close_part(llhls_packager_t *p, uint64_t end_dts, bool end_segment) {
+    if (p->video.n == 0)
+        return 0;
+
+    segment_t *seg = slot(p, p->open_msn); /* only this thread adds parts */
+    if (seg->n_parts + 1 >= LLHLS_MAX_PARTS)
+        end_segment = true;
+
+    int n_audio = 0;
+    while (n_audio < p->audio.n && audio_to_90k(p, p->audio.v[n_audio].time) < end_dts)
+        n_audio++;
+
+    cmaf_sample_t *samples = malloc((size_t)(p->video.n + n_audio) * sizeof(*samples));
+    if (!samples)
+        return -1;
+    cmaf_track_run_t runs[2];
+    int n_runs = 0;
+    const track_buf_t *tracks[2] = {&p->video, &p->audio};
+    const int counts[2] = {p->video.n, n_audio};
+    cmaf_sample_t *next = samples;
+    for (int t = 0; t < 2; t++) {
+        if (counts[t] == 0)
+            continue;
+        runs[n_runs] = (cmaf_track_run_t){
+            .track_id = t == 0 ? CMAF_VIDEO_TRACK_ID : CMAF_AUDIO_TRACK_ID,
+            .base_decode_time = tracks[t]->v[0].time,
+            .samples = next,
+            .sample_count = counts[t],
+        };
+        for (int i = 0; i < counts[t]; i++, next++) {
+            const held_sample_t *h = &tracks[t]->v[i];
+            *next = (cmaf_sample_t){
+                .data = tracks[t]->bytes.data + h->off,
+                .len = h->len,
+                .duration = h->duration,
+                .cts_offset = h->cts_offset,
+                .is_sync = h->is_sync,
+            };
+        }
+        n_runs++;
+    }
+
+    size_t size = cmaf_fragment_size(runs, n_runs);
+    blob_t *part = blob_alloc(size);
+    if (!part || cmaf_write_fragment(++p->fragment_seq, runs, n_runs, part->data, size) < 0) {
+        free(samples);
+        blob_unref(part);
+        return -1;
+    }
+    free(samples);
+
+    hls_part_t info = {
+        .duration_s = (double)(end_dts - p->part_start) / 90000.0,
+        .independent = p->video.v[0].is_sync,
+    };
+    snprintf(info.uri, sizeof(info.uri), "%s%lld.%d.m4s", p->cfg.base_name,
+             (long long)p->open_msn, seg->n_parts);
+
+    pthread_mutex_lock(&p->lock);
+    seg->part_info[seg->n_parts] = info;
+    seg->part_blob[seg->n_parts] = part;
+    seg->n_parts++;
+    if (end_segment) {
+        seg->info.duration_s = (double)(end_dts - p->seg_start) / 90000.0;
+        seg->complete = true;
+        open_segment(p, p->open_msn + 1);
+        drop_old_parts(p);
+    }
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    /* Waiters for the part are already woken; now the whole-segment copy */
+    if (end_segment) {
+        blob_t *whole = concat_parts(seg);
+        pthread_mutex_lock(&p->lock);
+        seg->blob = whole;
+        pthread_cond_broadcast(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+    }
+
+    track_consume(&p->video, p->video.n);
+    track_consume(&p->audio, n_audio);
+    p->part_start = end_dts;
+    if (end_segment)
+        p->seg_start = end_dts;
+    return end_segment && !seg->blob ? -1 : 0;
+}
+
+static int publish_init(llhls_packager_t *p, const uint8_t *data, size_t len) {
+    size_t sps_len = 0, pps_len = 0;
+    const uint8_t *sps = cmaf_find_nal(data, len, 7, &sps_len);
+    const uint8_t *pps = cmaf_find_nal(data, len, 8, &pps_len);
+    if (!sps || !pps)
+        return -1;
+
+    cmaf_init_config_t icfg = {
+        .width = p->cfg.width,
+        .height = p->cfg.height,
+        .sps = sps,
+        .sps_len = sps_len,
+        .pps = pps,
+        .pps_len = pps_len,
+        .has_audio = p->cfg.with_audio,
+        .audio_sample_rate = p->cfg.audio_sample_rate,
+        .audio_channels = p->cfg.audio_channels,
+    };
+    blob_t *init = blob_alloc(INIT_MAX + sps_len + pps_len);
+    if (!init)
+        return -1;
+    int n = cmaf_write_init(&icfg, init->data, INIT_MAX + sps_len + pps_len);
+    if (n < 0) {
+        blob_unref(init);
+        return -1;
+    }
+    init->len = (size_t)n;
+
+    pthread_mutex_lock(&p->lock);
+    p->init = init;
+    pthread_mutex_unlock(&p->lock);
+    return 0;
+}
+
+int llhls_write_video(llhls_packager_t *p, const uint8_t *data, size_t len, uint64_t pts_90khz,
+                      uint64_t dts_90khz, bool is_kf) {
+    if (!p || !data || len == 0 || pts_90khz < dts_90khz || pts_90khz - dts_90khz > INT32_MAX)
+        return -1;
+
+    if (!p->started) {
+        if (!is_kf)
+            return 0;
+        if (publish_init(p, data, len) != 0)
+            return -1;
+        p->started = true;
+        p->part_start = p->seg_start = dts_90khz;
+    }
+
+    if (p->video.n > 0) {
+        held_sample_t *held = &p->video.v[p->video.n - 1];
+        if (dts_90khz <= held->time || dts_90khz - held->time > UINT32_MAX)
+            return -1;
+        uint64_t dur = dts_90khz - held->time;
+        held->duration = (uint32_t)dur;
+
+        bool seg_due = is_kf && dts_90khz - p->seg_start >= p->seg_target;
+        bool part_due = dts_90khz - p->part_start + dur > p->part_target;
+        if ((seg_due || part_due) && close_part(p, dts_90khz, seg_due) != 0)
+            return -1;
+    }
+
+    /* AVCC never exceeds the Annex B size by more than a third */
+    size_t cap = len + len / 3 + 4;
+    if (bytes_reserve(&p->video.bytes, cap) != 0)
+        return -1;
+    int n = cmaf_annexb_to_avcc(data, len, p->video.bytes.data + p->video.bytes.len, cap);
+    held_sample_t *s = n < 0 ? NULL : track_push(&p->video);
+    if (!s)
+        return -1;
+    *s = (held_sample_t){
+        .off = p->video.bytes.len,
+        .len = (size_t)n,
+        .time = dts_90khz,
+        .cts_offset = (int32_t)(pts_90khz - dts_90khz),
+        .is_sync = is_kf,
+    };
+    p->video.bytes.len += (size_t)n;
+    return 0;
+}
+
+int llhls_write_audio(llhls_packager_t *p, const uint8_t *data, size_t len, uint64_t pts_90khz) {
+    if (!p || !data || len == 0 || !p->cfg.with_audio)
+        return -1;
+    if (!p->started)
+        return 0; /* Nothing to attach it to before the first keyframe */
+
+    uint64_t rate = (uint64_t)p->cfg.audio_sample_rate;
+    uint64_t t = pts_90khz * rate / 90000;
+    /* Follow the caller's clock across gaps; count samples otherwise */
+    if (!p->audio_started || t > p->audio_next + AAC_FRAME_SAMPLES ||
+        t + AAC_FRAME_SAMPLES < p->audio_next) {
+        p->audio_next = t;
+        p->audio_started = true;
+    }
+
+    size_t off = 0;
+    while (off < len) {
+        const uint8_t *h = data + off;
+        if (len - off < 7 || h[0] != 0xFF || (h[1] & 0xF6) != 0xF0)
+            return -1;
+        size_t hdr = (h[1] & 0x01) ? 7 : 9; /* protection_absent */
+        size_t frame = ((size_t)(h[3] & 0x03) << 11) | ((size_t)h[4] << 3) | (h[5] >> 5);
+        if (frame <= hdr || frame > len - off)
+            return -1;
+
+        if (bytes_reserve(&p->audio.bytes, frame - hdr) != 0)
+            return -1;
+        held_sample_t *s = track_push(&p->audio);
+        if (!s)
+            return -1;
+        *s = (held_sample_t){
+            .off = p->audio.bytes.len,
+            .len = frame - hdr,
+            .time = p->audio_next,
+            .duration = AAC_FRAME_SAMPLES,
+            .is_sync = true,
+        };
+        memcpy(p->audio.bytes.data + p->audio.bytes.len, h + hdr, frame - hdr);
+        p->audio.bytes.len += frame - hdr;
+        p->audio_next += AAC_FRAME_SAMPLES;
+        off += frame;
+    }
+    return 0;
+}
+
+int llhls_finish(llhls_packager_t *p) {
+    if (!p)
+        return -1;
+    if (p->video.n == 0)
+        return 0;
+
+    /* The held frame lasts as long as the one before it */
+    held_sample_t *held = &p->video.v[p->video.n - 1];
+    uint32_t dur = p->video.n > 1 ? p->video.v[p->video.n - 2].duration : 3000;
+    held->duration = dur;
+    return close_part(p, held->time + dur, true);
+}
+
+void llhls_get_position(llhls_packager_t *p, int64_t *msn, int *part) {
+    if (!p)
+        return;
+    pthread_mutex_lock(&p->lock);
+    if (msn)
+        *msn = p->open_msn;
+    if (part)
+        *part = slot(p, p->open_msn)->n_parts;
+    pthread_mutex_unlock(&p->lock);
+}
+
+/* ── Requests ─────────────────────────────────────────────────────── */
+
+static void deadline_after(struct timespec *ts, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Is part @part of segment @msn (or the whole segment if @part < 0) out? (locked) */
+static bool playlist_ready(llhls_packager_t *p, int64_t msn, int part) {
+    if (part < 0)
+        return p->open_msn > msn;
+    if (p->open_msn > msn + 1)
+        return true;
+    if (p->open_msn == msn + 1) {
+        /* A part past the end of a finished segment means the next one's first */
+        return part < slot(p, msn)->n_parts || slot(p, p->open_msn)->n_parts > 0;
+    }
+    return p->open_msn == msn && slot(p, msn)->n_parts > part;
+}
+
+/* Segments at the head of the window that a delta update may skip (locked) */
+static int skippable(llhls_packager_t *p) {
+    double total = 0.0;
+    for (int64_t msn = oldest_msn(p); msn <= p->open_msn; msn++) {
+        const segment_t *s = slot(p, msn);
+        if (s->complete) {
+            total += s->info.duration_s;
+        } else {
+            for (int i = 0; i < s->n_parts; i++)
+                total += s->part_info[i].duration_s;
+        }
+    }
+    double skip_until = 6.0 * p->cfg.target_duration_s;
+    double start = 0.0;
+    int skip = 0;
+    for (int64_t msn = oldest_msn(p); msn < p->open_msn; msn++) {
+        start += slot(p, msn)->info.duration_s;
+        if (total - start < skip_until)
+            break;
+        skip++;
+    }
+    return skip;
+}
+
+static int render_playlist(llhls_packager_t *p, bool skip, char *buf, size_t cap) {
+    hls_ll_segment_t segs[LLHLS_MAX_WINDOW + 1];
+    int n = 0;
+    double longest = 0.0;
+    for (int64_t msn = oldest_msn(p); msn <= p->open_msn; msn++, n++) {
+        const segment_t *s = slot(p, msn);
+        segs[n].seg = s->info;
+        segs[n].parts = s->parts_dropped ? NULL : s->part_info;
+        segs[n].n_parts = s->parts_dropped ? 0 : s->n_parts;
+        if (s->info.duration_s > longest)
+            longest = s->info.duration_s;
+    }
+
+    char preload[HLS_MAX_SEG_NAME];
+    snprintf(preload, sizeof(preload), "%s%lld.%d.m4s", p->cfg.base_name,
+             (long long)p->open_msn, slot(p, p->open_msn)->n_parts);
+    int target = (int)(longest + 0.5);
+    hls_ll_playlist_t pl = {
+        .segs = segs,
+        .n_segs = n,
+        .last_open = true,
+        .media_seq = (int)oldest_msn(p),
+        .target_dur_s = target > p->cfg.target_duration_s ? target : p->cfg.target_duration_s,
+        .part_target_s = p->cfg.part_target_ms / 1000.0,
+        .map_uri = p->init_name,
+        .preload_uri = preload,
+        .skip = skip ? skippable(p) : 0,
+    };
+    return m3u8_write_ll_live(&pl, buf, cap);
+}
+
+/* Parse "_HLS_msn=..&_HLS_part=..&_HLS_skip=.."; unknown keys are ignored */
+static int parse_query(const char *q, int64_t *msn, int *part, bool *skip) {
+    *msn = -1;
+    *part = -1;
+    *skip = false;
+    while (q && *q) {
+        const char *end = strchr(q, '&');
+        size_t n = end ? (size_t)(end - q) : strlen(q);
+        char *num_end;
+        if (n > 9 && strncmp(q, "_HLS_msn=", 9) == 0) {
+            long long v = strtoll(q + 9, &num_end, 10);
+            if (num_end != q + n || v < 0)
+                return -1;
+            *msn = v;
+        } else if (n > 10 && strncmp(q, "_HLS_part=", 10) == 0) {
+            long v = strtol(q + 10, &num_end, 10);
+            if (num_end != q + n || v < 0 || v >= LLHLS_MAX_PARTS)
+                return -1;
+            *part = (int)v;
+        } else if (n > 10 && strncmp(q, "_HLS_skip=", 10) == 0) {
+            *skip = (n == 13 && strncmp(q + 10, "YES", 3) == 0) ||
+                    (n == 12 && strncmp(q + 10, "v2", 2) == 0);
+        }
+        q = end ? end + 1 : NULL;
+    }
+    return (*part >= 0 && *msn < 0) ? -1 : 0;
+}
+
+static int serve_playlist(llhls_packager_t *p, const char *query, const struct timespec *deadline,
+                          llhls_response_t *out) {
+    int64_t msn;
+    int part;
+    bool skip;
+    if (parse_query(query, &msn, &part, &skip) != 0)
+        return 400;
+
+    char *buf = malloc(PLAYLIST_MAX);
+    if (!buf)
+        return 503;
+
+    pthread_mutex_lock(&p->lock);
+    if (msn > p->open_msn + 2) {
+        pthread_mutex_unlock(&p->lock);
+        free(buf);
+        return 400;
+    }
+    p->active_requests++;
+    while (msn >= 0 && !p->stopping && !playlist_ready(p, msn, part)) {
+        if (pthread_cond_timedwait(&p->cond, &p->lock, deadline) == ETIMEDOUT)
+            break;
+    }
+    int status = 503;
+    int n = -1;
+    if (!p->stopping && (msn < 0 || playlist_ready(p, msn, part)) && p->init) {
+        n = render_playlist(p, skip, buf, PLAYLIST_MAX);
+        status = n < 0 ? 503 : 200;
+    }
+    if (--p->active_requests == 0 && p->stopping)
+        pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+
+    blob_t *b = status == 200 ? blob_alloc((size_t)n) : NULL;
+    if (b) {
+        memcpy(b->data, buf, (size_t)n);
+        *out = (llhls_response_t){b->data, b->len, CONTENT_TYPE_PLAYLIST, b};
+    }
+    free(buf);
+    return b ? 200 : 503;
+}
+
+/* Is @msn/@part the hinted part or a segment still being copied? (locked) */
+static bool media_pending(llhls_packager_t *p, int64_t msn, int part) {
+    if (msn != p->open_msn && msn != p->open_msn - 1)
+        return false;
+    const segment_t *s = slot(p, msn);
+    if (part < 0)
+        return s->complete && !s->blob;
+    return msn == p->open_msn && part == s->n_parts;
+}
+
+/* "<base>M.m4s" → part -1, "<base>M.P.m4s" → part P */
+static int parse_media_name(const llhls_packager_t *p, const char *name, int64_t *msn,
+                            int *part) {
+    size_t base = strlen(p->cfg.base_name);
+    if (strncmp(name, p->cfg.base_name, base) != 0)
+        return -1;
+    const char *s = name + base;
+    char *end;
+    if (*s < '0' || *s > '9')
+        return -1;
+    *msn = strtoll(s, &end, 10);
+    *part = -1;
+    if (end[0] == '.' && end[1] >= '0' && end[1] <= '9') {
+        long v = strtol(end + 1, &end, 10);
+        if (v >= LLHLS_MAX_PARTS)
+            return -1;
+        *part = (int)v;
+    }
+    return strcmp(end, ".m4s") == 0 ? 0 : -1;
+}
+
+static int serve_media(llhls_packager_t *p, const char *name, const struct timespec *deadline,
+                       llhls_response_t *out) {
+    blob_t *found = NULL;
+
+    pthread_mutex_lock(&p->lock);
+    if (strcmp(name, p->init_name) == 0) {
+        found = p->init ? blob_ref(p->init) : NULL;
+    } else {
+        int64_t msn;
+        int part;
+        if (parse_media_name(p, name, &msn, &part) != 0) {
+            pthread_mutex_unlock(&p->lock);
+            return 404;
+        }
+        /* Hold requests for the preload-hinted part until it is published */
+        p->active_requests++;
+        while (!p->stopping && media_pending(p, msn, part)) {
+            if (pthread_cond_timedwait(&p->cond, &p->lock, deadline) == ETIMEDOUT)
+                break;
+        }
+        if (--p->active_requests == 0 && p->stopping)
+            pthread_cond_broadcast(&p->cond);
+
+        if (!p->stopping && msn >= oldest_msn(p) && msn <= p->open_msn) {
+            segment_t *s = slot(p, msn);
+            if (part < 0 && s->complete)
+                found = blob_ref(s->blob);
+            else if (part >= 0 && part < s->n_parts && !s->parts_dropped)
+                found = blob_ref(s->part_blob[part]);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    if (!found)
+        return 404;
+    *out = (llhls_response_t){found->data, found->len, CONTENT_TYPE_MP4, found};
+    return 200;
+}
+
+int llhls_handle_request(llhls_packager_t *p, const char *target, int timeout_ms,
+                         llhls_response_t *out) {
+    if (!out)
+        return 400;
+    memset(out, 0, sizeof(*out));
+    if (!p || !target)
+        return 400;
+
+    const char *query = strchr(target, '?');
+    size_t path_len = query ? (size_t)(query - target) : strlen(target);
+    const char *name = target;
+    for (size_t i = 0; i < path_len; i++) {
+        if (target[i] == '/')
+            name = target + i + 1;
+    }
+    size_t name_len = path_len - (size_t)(name - target);
+    if (name_len == 0 || name_len >= HLS_MAX_SEG_NAME)
+        return 404;
+    char nm[HLS_MAX_SEG_NAME];
+    memcpy(nm, name, name_len);
+    nm[name_len] = '\0';
+
+    struct timespec deadline;
+    deadline_after(&deadline, timeout_ms > 0 ? timeout_ms : 3000 * p->cfg.target_duration_s);
+
+    if (strcmp(nm, p->cfg.playlist_name) == 0)
+        return serve_playlist(p, query ? query + 1 : NULL, &deadline, out);
+    return serve_media(p, nm, &deadline, out);
+}
+
+void llhls_response_release(llhls_response_t *res) {
+    if (!res)
+        return;
+    blob_unref(res->ref);
+    memset(res, 0, sizeof(*res));
+}
@@ -0,0 +1,174 @@
+/*
+ * llhls_packager.h — Low-latency HLS packager serving from memory
+ *
+ * Cuts the encoder's output into ~200 ms CMAF parts and ~2 s segments
+ * entirely in memory and answers HLS requests for them, including
+ * LL-HLS blocking playlist reloads:
+ *
+ *   <playlist>?_HLS_msn=M[&_HLS_part=P][&_HLS_skip=YES]
+ *                     held until part P of segment M (or segment M)
+ *                     is available, then a (delta) playlist
+ *   <base>init.mp4    init section (ftyp + moov)
+ *   <base>M.P.m4s     part P of segment M; the preload-hinted part
+ *                     is held until it is complete
+ *   <base>M.m4s       complete segment M
+ *
+ * Parts are cut at video frame boundaries, never longer than the part
+ * target; segments start on a keyframe once the segment target has
+ * elapsed.  Resources are immutable reference-counted blobs, so a
+ * response stays valid after the packager moves on.
+ *
+ * Typical usage
+ * ─────────────
+ *   llhls_packager_t *p = llhls_create(&cfg);
+ *   llhls_write_video(p, au, len, pts, dts, is_kf);   // encoder thread
+ *   llhls_write_audio(p, adts, len, pts);
+ *
+ *   llhls_response_t res;                              // web threads
+ *   int status = llhls_handle_request(p, "/live.m3u8?_HLS_msn=7&_HLS_part=2",
+ *                                     0, &res);
+ *   ... send res.data / res.len with res.content_type ...
+ *   llhls_response_release(&res);
+ *
+ * Thread-safety: llhls_write_*() and llhls_finish() from one thread;
+ *                llhls_handle_request() from any number of threads.
+ */
+
+#ifndef ROOTSTREAM_LLHLS_PACKAGER_H
+#define ROOTSTREAM_LLHLS_PACKAGER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hls_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Parts per segment; a segment with no keyframe in sight is cut here */
+#define LLHLS_MAX_PARTS 64
+
+/** Largest supported window of complete segments */
+#define LLHLS_MAX_WINDOW 64
+
+/** LL-HLS packager configuration */
+typedef struct {
+    char base_name[HLS_MAX_SEG_NAME / 2]; /**< Resource prefix (e.g. "seg") */
+    char playlist_name[HLS_MAX_SEG_NAME]; /**< Media playlist name (e.g. "live.m3u8") */
+    int target_duration_s;                /**< Segment target; 0 = default */
+    int part_target_ms;                   /**< Part target; 0 = default */
+    int window_size;                      /**< Complete segments kept; 0 = default */
+    int width;                            /**< Video width for the init section */
+    int height;                           /**< Video height for the init section */
+    bool with_audio;                      /**< Add an AAC track (llhls_write_audio) */
+    int audio_sample_rate;                /**< 0 = 48000 */
+    int audio_channels;                   /**< 0 = 2 */
+} llhls_config_t;
+
+/** A resource handed to the web layer */
+typedef struct {
+    const uint8_t *data;      /**< Body */
+    size_t len;               /**< Body length in bytes */
+    const char *content_type; /**< MIME type */
+    void *ref;                /**< Owning reference; see llhls_response_release() */
+} llhls_response_t;
+
+/** Opaque packager handle */
+typedef struct llhls_packager_s llhls_packager_t;
+
+/**
+ * llhls_create — allocate a packager
+ *
+ * @param cfg  Configuration (width/height and names required)
+ * @return     Non-NULL handle, or NULL on OOM / bad config
+ */
+llhls_packager_t *llhls_create(const llhls_config_t *cfg);
+
+/**
+ * llhls_destroy — wake blocked requests, wait for them, free everything
+ *
+ * Outstanding responses stay valid until released.
+ *
+ * @param p  Packager
+ */
+void llhls_destroy(llhls_packager_t *p);
+
+/**
+ * llhls_write_video — add one H.264 access unit
+ *
+ * Frames before the first keyframe (which must carry SPS and PPS) are
+ * dropped.  Each frame is held until the next one arrives, which gives
+ * its duration; a part is published when the next frame would take it
+ * past the part target.
+ *
+ * @param p         Packager
+ * @param data      Annex B access unit
+ * @param len       Length in bytes
+ * @param pts_90khz Presentation timestamp in 90 kHz units
+ * @param dts_90khz Decode timestamp in 90 kHz units (strictly increasing)
+ * @param is_kf     True for an IDR frame
+ * @return          0 on success (including dropped frames), -1 on error
+ */
+int llhls_write_video(llhls_packager_t *p, const uint8_t *data, size_t len, uint64_t pts_90khz,
+                      uint64_t dts_90khz, bool is_kf);
+
+/**
+ * llhls_write_audio — add one or more ADTS-framed AAC frames
+ *
+ * Audio is placed in the part that covers its timestamp.
+ *
+ * @param p         Packager (created with with_audio)
+ * @param data      ADTS frame(s)
+ * @param len       Length in bytes
+ * @param pts_90khz Presentation timestamp of the first frame
+ * @return          0 on success, -1 on error / malformed ADTS
+ */
+int llhls_write_audio(llhls_packager_t *p, const uint8_t *data, size_t len, uint64_t pts_90khz);
+
+/**
+ * llhls_finish — publish the held frame and close the open segment
+ *
+ * @param p  Packager
+ * @return   0 on success, -1 on error
+ */
+int llhls_finish(llhls_packager_t *p);
+
+/**
+ * llhls_get_position — newest published part
+ *
+ * @param p     Packager
+ * @param msn   Receives the media sequence number of the open segment
+ * @param part  Receives its published part count
+ */
+void llhls_get_position(llhls_packager_t *p, int64_t *msn, int *part);
+
+/**
+ * llhls_handle_request — answer an HTTP GET for a playlist or resource
+ *
+ * @p target is the request path with optional query; only its last
+ * path component is matched.  Blocking reloads and preload-hinted part
+ * requests wait up to @timeout_ms (0 = three target durations).
+ *
+ * @param p           Packager
+ * @param target      Request target (e.g. "/hls/live.m3u8?_HLS_msn=4")
+ * @param timeout_ms  Maximum time to hold the request
+ * @param out         Receives the response on 200
+ * @return            HTTP status: 200, 400, 404 or 503
+ */
+int llhls_handle_request(llhls_packager_t *p, const char *target, int timeout_ms,
+                         llhls_response_t *out);
+
+/**
+ * llhls_response_release — drop a response's reference to its data
+ *
+ * @param res  Response filled by llhls_handle_request() (may be unset)
+ */
+void llhls_response_release(llhls_response_t *res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_LLHLS_PACKAGER_H */
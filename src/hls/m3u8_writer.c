@@ -4,6 +4,7 @@
 
 #include "m3u8_writer.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -129,3 +130,64 @@ int m3u8_write_master(const char **uris, const int *bandwidths, int n, int width
 
     return (int)pos;
 }
+
+/* ── Low-latency playlist ────────────────────────────────────────── */
+
+static int append(char *buf, size_t buf_sz, size_t *pos, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int r = vsnprintf(buf + *pos, buf_sz - *pos, fmt, ap);
+    va_end(ap);
+    if (r < 0 || (size_t)r >= buf_sz - *pos)
+        return -1;
+    *pos += (size_t)r;
+    return 0;
+}
+
+int m3u8_write_ll_live(const hls_ll_playlist_t *pl, char *buf, size_t buf_sz) {
+    if (!pl || !pl->segs || !pl->map_uri || !buf || buf_sz == 0)
+        return -1;
+    if (pl->n_segs <= 0 || pl->skip < 0 || pl->skip >= pl->n_segs || pl->part_target_s <= 0.0)
+        return -1;
+
+    size_t pos = 0;
+    if (append(buf, buf_sz, &pos,
+               "#EXTM3U\n"
+               "#EXT-X-VERSION:9\n"
+               "#EXT-X-TARGETDURATION:%d\n"
+               "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,CAN-SKIP-UNTIL=%.1f,"
+               "PART-HOLD-BACK=%.3f\n"
+               "#EXT-X-PART-INF:PART-TARGET=%.3f\n"
+               "#EXT-X-MEDIA-SEQUENCE:%d\n"
+               "#EXT-X-MAP:URI=\"%s\"\n",
+               pl->target_dur_s, 6.0 * pl->target_dur_s, 3.0 * pl->part_target_s,
+               pl->part_target_s, pl->media_seq, pl->map_uri) != 0)
+        return -1;
+    if (pl->skip > 0 &&
+        append(buf, buf_sz, &pos, "#EXT-X-SKIP:SKIPPED-SEGMENTS=%d\n", pl->skip) != 0)
+        return -1;
+
+    for (int i = pl->skip; i < pl->n_segs; i++) {
+        const hls_ll_segment_t *s = &pl->segs[i];
+        bool open = pl->last_open && i == pl->n_segs - 1;
+        if (!open && s->seg.is_discontinuity &&
+            append(buf, buf_sz, &pos, "#EXT-X-DISCONTINUITY\n") != 0)
+            return -1;
+        for (int p = 0; s->parts && p < s->n_parts; p++) {
+            if (append(buf, buf_sz, &pos, "#EXT-X-PART:DURATION=%.5f,URI=\"%s\"%s\n",
+                       s->parts[p].duration_s, s->parts[p].uri,
+                       s->parts[p].independent ? ",INDEPENDENT=YES" : "") != 0)
+                return -1;
+        }
+        if (!open && append(buf, buf_sz, &pos, "#EXTINF:%.5f,\n%s\n", s->seg.duration_s,
+                            s->seg.filename) != 0)
+            return -1;
+    }
+
+    if (pl->preload_uri &&
+        append(buf, buf_sz, &pos, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"%s\"\n",
+               pl->preload_uri) != 0)
+        return -1;
+
+    return (int)pos;
+}
@@ -8,6 +8,10 @@
  *
  *   VOD    — full list of all segments; written once at stream end.
  *
+ *   LL     — low-latency live: #EXT-X-PART partial segments for the
+ *            newest segments, #EXT-X-PRELOAD-HINT for the next part,
+ *            blocking-reload server control and delta (skip) updates.
+ *
  * The output is written into a caller-supplied buffer (no heap alloc).
  *
  * Thread-safety: all functions are stateless and thread-safe.
@@ -32,6 +36,33 @@ typedef struct {
     bool is_discontinuity;           /**< Insert #EXT-X-DISCONTINUITY */
 } hls_segment_t;
 
+/** A partial segment (LL-HLS #EXT-X-PART) */
+typedef struct {
+    char uri[HLS_MAX_SEG_NAME]; /**< Part URI */
+    double duration_s;          /**< Part duration (s) */
+    bool independent;           /**< Starts with a keyframe */
+} hls_part_t;
+
+/** A segment in an LL-HLS playlist, with the parts advertised for it */
+typedef struct {
+    hls_segment_t seg;       /**< Whole segment (unused for the open one) */
+    const hls_part_t *parts; /**< Parts, or NULL when no longer advertised */
+    int n_parts;             /**< Number of @parts */
+} hls_ll_segment_t;
+
+/** Input to m3u8_write_ll_live() */
+typedef struct {
+    const hls_ll_segment_t *segs; /**< Window, oldest first */
+    int n_segs;                   /**< Number of @segs */
+    bool last_open;               /**< segs[n_segs - 1] is still being built */
+    int media_seq;                /**< Sequence number of segs[0] */
+    int target_dur_s;             /**< #EXT-X-TARGETDURATION value */
+    double part_target_s;         /**< #EXT-X-PART-INF PART-TARGET value */
+    const char *map_uri;          /**< #EXT-X-MAP init section URI */
+    const char *preload_uri;      /**< Next part for #EXT-X-PRELOAD-HINT, or NULL */
+    int skip;                     /**< Delta update: first @skip segments become EXT-X-SKIP */
+} hls_ll_playlist_t;
+
 /**
  * m3u8_write_live — generate a live sliding-window M3U8 into @buf
  *
@@ -75,6 +106,20 @@ int m3u8_write_vod(const hls_segment_t *segments, int n, int target_dur_s, char
 int m3u8_write_master(const char **uris, const int *bandwidths, int n, int width, int height,
                       char *buf, size_t buf_sz);
 
+/**
+ * m3u8_write_ll_live — generate a low-latency HLS media playlist
+ *
+ * Advertises CAN-BLOCK-RELOAD, PART-HOLD-BACK of three part targets
+ * and CAN-SKIP-UNTIL of six target durations.  Segments with parts
+ * list them before their #EXTINF; the open segment lists parts only.
+ *
+ * @param pl      Playlist description
+ * @param buf     Output buffer
+ * @param buf_sz  Size of @buf
+ * @return        Bytes written (excl. NUL), or -1 on bad input / buf too small
+ */
+int m3u8_write_ll_live(const hls_ll_playlist_t *pl, char *buf, size_t buf_sz);
+
 #ifdef __cplusplus
 }
 #endif
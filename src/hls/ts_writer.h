@@ -1,16 +1,18 @@
 /*
- * ts_writer.h — Minimal MPEG-TS segment writer
+ * ts_writer.h — Buffered MPEG-TS segment writer
  *
- * Writes raw NAL-unit payloads (H.264/H.265) into MPEG-TS packets
- * suitable for HLS segments.  Only the subset of MPEG-TS required
- * for single-program HLS is implemented:
+ * Writes H.264/H.265 access units and (optionally) AAC audio frames
+ * into MPEG-TS packets suitable for HLS segments.  The subset of
+ * MPEG-TS required for single-program HLS is implemented:
  *
  *   PAT  — Program Association Table  (PID 0)
  *   PMT  — Program Map Table          (PID 4096)
- *   PES  — Packetized Elementary Stream (video PID 256)
+ *   PES  — video (PID 256, carries the PCR) and audio (PID 257)
  *
- * No audio muxing: a video-only TS is sufficient for the HLS tests.
- * Audio can be added as an additional PES stream in a future microtask.
+ * Packets are assembled in an in-memory buffer and handed to the
+ * kernel in large write() calls (TS_WRITER_FLUSH_BYTES by default)
+ * instead of one syscall per 188-byte packet.  Call ts_writer_flush()
+ * before closing the file; ts_writer_destroy() also flushes.
  *
  * Thread-safety: NOT thread-safe; use one ts_writer_t per encoding thread.
  */
@@ -28,11 +30,44 @@
 extern "C" {
 #endif
 
+/** Video elementary stream PID (also the PCR PID) */
+#define TS_VIDEO_PID 0x100
+
+/** Audio elementary stream PID */
+#define TS_AUDIO_PID 0x101
+
+/** Program Map Table PID */
+#define TS_PMT_PID 0x1000
+
+/** Default output buffer: 1024 TS packets per write() */
+#define TS_WRITER_FLUSH_BYTES (1024 * HLS_TS_PACKET_SZ)
+
+/** Maximum gap between PCRs (40 ms at 90 kHz; the spec allows 100 ms) */
+#define TS_PCR_INTERVAL_90KHZ 3600
+
+/** PCR runs this far behind the video DTS so decoders can buffer (90 kHz) */
+#define TS_PCR_LEAD_90KHZ 9000
+
+/** Elementary stream types as they appear in the PMT */
+typedef enum {
+    TS_STREAM_NONE = 0x00, /**< No stream (audio disabled) */
+    TS_STREAM_AAC = 0x0F,  /**< AAC in ADTS framing */
+    TS_STREAM_H264 = 0x1B, /**< H.264 Annex B */
+    TS_STREAM_H265 = 0x24, /**< H.265 Annex B */
+} ts_stream_type_t;
+
+/** TS writer configuration */
+typedef struct {
+    ts_stream_type_t video_type; /**< TS_STREAM_NONE selects H.264 */
+    ts_stream_type_t audio_type; /**< TS_STREAM_NONE = video only */
+    size_t flush_bytes;          /**< Buffer size; 0 = TS_WRITER_FLUSH_BYTES */
+} ts_writer_config_t;
+
 /** Opaque TS writer handle */
 typedef struct ts_writer_s ts_writer_t;
 
 /**
- * ts_writer_create — allocate a TS writer writing to @fd
+ * ts_writer_create — allocate a video-only H.264 writer writing to @fd
  *
  * @param fd       Open writable file descriptor (segment file)
  * @return         Non-NULL handle, or NULL on OOM
@@ -40,7 +75,19 @@ typedef struct ts_writer_s ts_writer_t;
 ts_writer_t *ts_writer_create(int fd);
 
 /**
- * ts_writer_destroy — free writer (does NOT close @fd)
+ * ts_writer_create_ex — allocate a writer with explicit stream types
+ *
+ * @param fd   Open writable file descriptor (segment file)
+ * @param cfg  Configuration, or NULL for the ts_writer_create() defaults
+ * @return     Non-NULL handle, or NULL on OOM / unsupported stream type
+ */
+ts_writer_t *ts_writer_create_ex(int fd, const ts_writer_config_t *cfg);
+
+/**
+ * ts_writer_destroy — flush buffered packets and free the writer
+ *
+ * Does NOT close @fd.  Flush errors are lost; call ts_writer_flush()
+ * first when they matter.
  *
  * @param w  Writer to destroy
  */
@@ -50,7 +97,7 @@ void ts_writer_destroy(ts_writer_t *w);
  * ts_writer_write_pat_pmt — write PAT + PMT tables
  *
  * Must be called once at the start of each segment so decoders can
- * locate the program structure.
+ * locate the program structure.  The next video PES carries a PCR.
  *
  * @param w  TS writer
  * @return   0 on success, -1 on write error
@@ -58,10 +105,10 @@ void ts_writer_destroy(ts_writer_t *w);
 int ts_writer_write_pat_pmt(ts_writer_t *w);
 
 /**
- * ts_writer_write_pes — wrap @payload bytes as a PES packet and write TS
+ * ts_writer_write_pes — write a video access unit with DTS == PTS
  *
- * Splits the PES into 188-byte TS packets.  Sets the random-access
- * indicator on the first packet when @is_keyframe is true.
+ * Equivalent to ts_writer_write_video(w, payload, payload_len,
+ * pts_90khz, pts_90khz, is_keyframe).
  *
  * @param w           TS writer
  * @param payload     NAL unit data
@@ -74,13 +121,66 @@ int ts_writer_write_pes(ts_writer_t *w, const uint8_t *payload, size_t payload_l
                         uint64_t pts_90khz, bool is_keyframe);
 
 /**
- * ts_writer_bytes_written — total bytes written so far
+ * ts_writer_write_video — wrap a video access unit as PES on TS_VIDEO_PID
+ *
+ * The PES header carries PTS, plus DTS when it differs (B-frames).  A
+ * PCR derived from @dts_90khz is inserted on keyframes and at least
+ * every TS_PCR_INTERVAL_90KHZ.  The random-access indicator is set on
+ * the first packet when @is_keyframe is true.
+ *
+ * @param w           TS writer
+ * @param payload     Access unit (Annex B)
+ * @param payload_len Size in bytes
+ * @param pts_90khz   Presentation timestamp in 90 kHz units
+ * @param dts_90khz   Decode timestamp in 90 kHz units (<= PTS)
+ * @param is_keyframe True if this is an IDR / keyframe
+ * @return            0 on success, -1 on error
+ */
+int ts_writer_write_video(ts_writer_t *w, const uint8_t *payload, size_t payload_len,
+                          uint64_t pts_90khz, uint64_t dts_90khz, bool is_keyframe);
+
+/**
+ * ts_writer_write_audio — wrap audio frame(s) as PES on TS_AUDIO_PID
+ *
+ * @param w           TS writer (created with an audio_type)
+ * @param payload     One or more ADTS frames
+ * @param payload_len Size in bytes (PES length limit: 65527)
+ * @param pts_90khz   Presentation timestamp of the first frame
+ * @return            0 on success, -1 on error / no audio stream
+ */
+int ts_writer_write_audio(ts_writer_t *w, const uint8_t *payload, size_t payload_len,
+                          uint64_t pts_90khz);
+
+/**
+ * ts_writer_flush — write all buffered packets to the file
+ *
+ * @param w  TS writer
+ * @return   0 on success, -1 on write error
+ */
+int ts_writer_flush(ts_writer_t *w);
+
+/**
+ * ts_writer_bytes_written — total TS bytes produced so far
+ *
+ * Includes packets still buffered in memory.
  *
  * @param w  TS writer
  * @return   Byte count
  */
 size_t ts_writer_bytes_written(const ts_writer_t *w);
 
+/**
+ * ts_crc32_mpeg — CRC-32/MPEG-2 as used by PSI sections
+ *
+ * Polynomial 0x04C11DB7, MSB first, initial value 0xFFFFFFFF, no final
+ * XOR.  Computed eight bytes at a time (slicing-by-8).
+ *
+ * @param data  Input bytes
+ * @param len   Length in bytes
+ * @return      CRC value
+ */
+uint32_t ts_crc32_mpeg(const uint8_t *data, size_t len);
+
 #ifdef __cplusplus
 }
 #endif
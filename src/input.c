@@ -3,190 +3,94 @@
  *
  * Creates virtual keyboard and mouse devices to inject input
  * from the remote client. Works regardless of display server.
+ *
+ * The devices belong to the input manager (src/input/input_manager.c);
+ * input from the network goes through it to be split by device and timed
+ * for the click-to-photon latency report.  Each peer is a manager client
+ * of its own, so a batch it repeats (same batch seq) is injected once.
  */
 
-#include <errno.h>
-#include <fcntl.h>
-#include <linux/uinput.h>
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sys/time.h>
-#include <unistd.h>
 
 #include "../include/rootstream.h"
 
 /*
- * Create a virtual keyboard device
+ * Initialize input system
  */
-static int create_keyboard(void) {
-    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-    if (fd < 0) {
-        return -1;
-    }
-
-    /* Enable key events */
-    ioctl(fd, UI_SET_EVBIT, EV_KEY);
-    ioctl(fd, UI_SET_EVBIT, EV_SYN);
-
-    /* Enable all keyboard keys */
-    for (int i = 0; i < KEY_MAX; i++) {
-        ioctl(fd, UI_SET_KEYBIT, i);
-    }
-
-    /* Setup device */
-    struct uinput_setup setup = {0};
-    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "RootStream Virtual Keyboard");
-    setup.id.bustype = BUS_USB;
-    setup.id.vendor = 0x1234;
-    setup.id.product = 0x5678;
-    setup.id.version = 1;
-
-    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0) {
-        close(fd);
-        return -1;
-    }
-
-    /* Create the device */
-    if (ioctl(fd, UI_DEV_CREATE) < 0) {
-        close(fd);
+int rootstream_input_init(rootstream_ctx_t *ctx) {
+    if (!ctx) {
+        fprintf(stderr, "Invalid context\n");
         return -1;
     }
 
-    return fd;
+    return input_manager_init(ctx, INPUT_BACKEND_UINPUT);
 }
 
 /*
- * Create a virtual mouse device
+ * Process an input event from network
  */
-static int create_mouse(void) {
-    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-    if (fd < 0) {
-        return -1;
-    }
-
-    /* Enable events */
-    ioctl(fd, UI_SET_EVBIT, EV_KEY);
-    ioctl(fd, UI_SET_EVBIT, EV_REL);
-    ioctl(fd, UI_SET_EVBIT, EV_SYN);
-
-    /* Enable mouse buttons */
-    ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
-    ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT);
-    ioctl(fd, UI_SET_KEYBIT, BTN_MIDDLE);
-
-    /* Enable relative axes */
-    ioctl(fd, UI_SET_RELBIT, REL_X);
-    ioctl(fd, UI_SET_RELBIT, REL_Y);
-    ioctl(fd, UI_SET_RELBIT, REL_WHEEL);
-
-    /* Setup device */
-    struct uinput_setup setup = {0};
-    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "RootStream Virtual Mouse");
-    setup.id.bustype = BUS_USB;
-    setup.id.vendor = 0x1234;
-    setup.id.product = 0x5679;
-    setup.id.version = 1;
-
-    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0) {
-        close(fd);
-        return -1;
-    }
-
-    if (ioctl(fd, UI_DEV_CREATE) < 0) {
-        close(fd);
+int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
+    if (!ctx || !event) {
+        fprintf(stderr, "Invalid arguments\n");
         return -1;
     }
 
-    return fd;
+    /* Single events carry no sequence number or client timestamp */
+    return input_manager_submit_packet(ctx, event, 0, 0, 0);
 }
 
 /*
- * Emit an input event
+ * Input manager client id of @peer, registered with its first batch
+ *
+ * Ids are never reused, so a peer that left cannot match a newcomer.
+ * With INPUT_MAX_CLIENTS peers registered, a further peer keeps its id
+ * unregistered and its batches are injected without the seq check.
  */
-static int emit_event(int fd, uint16_t type, uint16_t code, int32_t value) {
-    struct input_event ev = {0};
-
-    ev.type = type;
-    ev.code = code;
-    ev.value = value;
-
-    /* Set timestamp */
-    gettimeofday(&ev.time, NULL);
-
-    if (write(fd, &ev, sizeof(ev)) < 0)
-        return -1;
-
-    /* Sync event */
-    ev.type = EV_SYN;
-    ev.code = SYN_REPORT;
-    ev.value = 0;
-
-    if (write(fd, &ev, sizeof(ev)) < 0)
-        return -1;
-
-    return 0;
+static uint32_t peer_client_id(rootstream_ctx_t *ctx, peer_t *peer) {
+    if (peer->input_client_id == 0) {
+        peer->input_client_id = ++ctx->input_manager->next_client_id;
+        input_manager_register_client(ctx, peer->input_client_id,
+                                      peer->hostname[0] ? peer->hostname : NULL);
+    }
+    return peer->input_client_id;
 }
 
 /*
- * Initialize input system
+ * Process a batch of input events from network
+ *
+ * See input_manager_submit_batch(): a batch repeating @peer's previous
+ * seq is skipped, each device gets its share of the batch in a single
+ * write(), and presses are timed up to the first video frame that can
+ * show them (input_manager_on_video_frame()).
  */
-int rootstream_input_init(rootstream_ctx_t *ctx) {
-    if (!ctx) {
-        fprintf(stderr, "Invalid context\n");
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len) {
+    if (!ctx || !peer || !payload) {
+        fprintf(stderr, "Invalid arguments\n");
         return -1;
     }
-
-    /* Create virtual devices */
-    ctx->uinput_kbd_fd = create_keyboard();
-    if (ctx->uinput_kbd_fd < 0) {
-        fprintf(stderr, "Cannot create virtual keyboard: %s\n", strerror(errno));
+    if (!ctx->input_manager) {
         return -1;
     }
 
-    ctx->uinput_mouse_fd = create_mouse();
-    if (ctx->uinput_mouse_fd < 0) {
-        close(ctx->uinput_kbd_fd);
-        fprintf(stderr, "Cannot create virtual mouse: %s\n", strerror(errno));
+    if (input_manager_submit_batch(ctx, payload, len, peer_client_id(ctx, peer)) < 0) {
+        fprintf(stderr, "WARNING: Dropped input batch (%zu bytes)\n", len);
         return -1;
     }
-
-    printf("✓ Virtual input devices created\n");
     return 0;
 }
 
 /*
- * Process an input event from network
+ * Drop @peer's batch seq tracking (peer removed, or a new session whose
+ * batch numbers start over)
  */
-int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
-    if (!ctx || !event) {
-        fprintf(stderr, "Invalid arguments\n");
-        return -1;
-    }
-
-    switch (event->type) {
-        case EV_KEY:
-            /* Keyboard or mouse button */
-            if (event->code < BTN_MOUSE) {
-                /* Keyboard */
-                return emit_event(ctx->uinput_kbd_fd, EV_KEY, event->code, event->value);
-            } else {
-                /* Mouse button */
-                return emit_event(ctx->uinput_mouse_fd, EV_KEY, event->code, event->value);
-            }
-            break;
-
-        case EV_REL:
-            /* Mouse movement */
-            return emit_event(ctx->uinput_mouse_fd, EV_REL, event->code, event->value);
-            break;
-
-        default:
-            /* Unsupported event type */
-            return 0;
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer) {
+    if (!ctx || !peer || peer->input_client_id == 0) {
+        return;
     }
 
-    return 0;
+    input_manager_unregister_client(ctx, peer->input_client_id);
+    peer->input_client_id = 0;
 }
 
 /*
@@ -196,15 +100,5 @@ void rootstream_input_cleanup(rootstream_ctx_t *ctx) {
     if (!ctx)
         return;
 
-    if (ctx->uinput_kbd_fd >= 0) {
-        ioctl(ctx->uinput_kbd_fd, UI_DEV_DESTROY);
-        close(ctx->uinput_kbd_fd);
-        ctx->uinput_kbd_fd = -1;
-    }
-
-    if (ctx->uinput_mouse_fd >= 0) {
-        ioctl(ctx->uinput_mouse_fd, UI_DEV_DESTROY);
-        close(ctx->uinput_mouse_fd);
-        ctx->uinput_mouse_fd = -1;
-    }
+    input_manager_cleanup(ctx);
 }
@@ -0,0 +1,209 @@
+/*
+ * input_batch.c - Batched, timestamped input events
+ */
+
+#include "input_batch.h"
+
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/input.h>
+#include <unistd.h>
+#else
+#define EV_REL 0x02
+#endif
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* Sum of two deltas, clamped to the int32_t range */
+static int32_t add_sat(int32_t a, int32_t b) {
+    int64_t s = (int64_t)a + b;
+    if (s > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (s < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)s;
+}
+
+void input_batch_init(input_batch_t *b, bool coalesce) {
+    if (!b) {
+        return;
+    }
+    memset(b, 0, sizeof(*b));
+    b->coalesce = coalesce;
+}
+
+void input_batch_reset(input_batch_t *b) {
+    if (!b) {
+        return;
+    }
+    b->count = 0;
+    b->merge_from = 0;
+    b->merged = false;
+}
+
+int input_batch_add(input_batch_t *b, uint8_t type, uint16_t code, int32_t value,
+                    uint64_t now_us) {
+    if (!b) {
+        return -1;
+    }
+
+    if (type == EV_REL && b->coalesce) {
+        for (int i = b->merge_from; i < b->count; i++) {
+            input_batch_event_t *e = &b->events[i];
+            if (e->type == type && e->code == code) {
+                e->value = add_sat(e->value, value);
+                b->merged = true;
+                b->coalesced++;
+                return 1;
+            }
+        }
+    }
+
+    if (b->count == INPUT_BATCH_MAX_EVENTS ||
+        (b->count > 0 && (now_us < b->events[0].time_us ||
+                          now_us - b->events[0].time_us > INPUT_BATCH_MAX_SPAN_US))) {
+        return -1;
+    }
+
+    b->events[b->count++] = (input_batch_event_t){
+        .type = type, .code = code, .value = value, .time_us = now_us};
+    if (type != EV_REL) {
+        b->merge_from = b->count;
+    }
+    return 0;
+}
+
+size_t input_batch_encode(const input_batch_t *b, uint16_t seq, uint64_t now_us, uint8_t *buf,
+                          size_t cap) {
+    if (!b || !buf || b->count == 0) {
+        return 0;
+    }
+    size_t len = INPUT_BATCH_HEADER_SIZE + (size_t)b->count * INPUT_BATCH_EVENT_SIZE;
+    if (len > cap) {
+        return 0;
+    }
+
+    uint64_t base = b->events[0].time_us;
+    uint64_t send_dt = now_us > base ? now_us - base : 0;
+    put_le16(buf, seq);
+    buf[2] = (uint8_t)b->count;
+    buf[3] = b->merged ? INPUT_BATCH_FLAG_COALESCED : 0;
+    put_le64(buf + 4, base);
+    put_le32(buf + 12, send_dt > UINT32_MAX ? UINT32_MAX : (uint32_t)send_dt);
+
+    uint8_t *p = buf + INPUT_BATCH_HEADER_SIZE;
+    for (int i = 0; i < b->count; i++) {
+        const input_batch_event_t *e = &b->events[i];
+        p[0] = e->type;
+        put_le16(p + 1, e->code);
+        put_le32(p + 3, (uint32_t)e->value);
+        put_le16(p + 7, (uint16_t)(e->time_us - base));
+        p += INPUT_BATCH_EVENT_SIZE;
+    }
+    return len;
+}
+
+int input_batch_decode(const uint8_t *buf, size_t len, input_batch_info_t *info,
+                       input_batch_event_t *events, int max) {
+    if (!buf || !events || len < INPUT_BATCH_HEADER_SIZE) {
+        return -1;
+    }
+    int count = buf[2];
+    if (count == 0 || count > INPUT_BATCH_MAX_EVENTS || count > max ||
+        len != INPUT_BATCH_HEADER_SIZE + (size_t)count * INPUT_BATCH_EVENT_SIZE) {
+        return -1;
+    }
+
+    uint64_t base = get_le64(buf + 4);
+    if (info) {
+        info->seq = get_le16(buf);
+        info->flags = buf[3];
+        info->base_us = base;
+        info->send_us = base + get_le32(buf + 12);
+    }
+
+    const uint8_t *p = buf + INPUT_BATCH_HEADER_SIZE;
+    for (int i = 0; i < count; i++) {
+        events[i].type = p[0];
+        events[i].code = get_le16(p + 1);
+        events[i].value = (int32_t)get_le32(p + 3);
+        events[i].time_us = base + get_le16(p + 7);
+        p += INPUT_BATCH_EVENT_SIZE;
+    }
+    return count;
+}
+
+int input_batch_inject(int fd, const input_batch_event_t *events, int n) {
+#ifdef __linux__
+    struct input_event out[2 * INPUT_BATCH_MAX_EVENTS + 1];
+    const struct input_event syn = {.type = EV_SYN, .code = SYN_REPORT, .value = 0};
+    size_t count = 0;
+    size_t report = 0; /* First event of the current report */
+
+    if (fd < 0 || !events || n <= 0 || n > INPUT_BATCH_MAX_EVENTS) {
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (size_t j = report; j < count; j++) {
+            if (out[j].type == events[i].type && out[j].code == events[i].code) {
+                out[count++] = syn;
+                report = count;
+                break;
+            }
+        }
+        out[count++] = (struct input_event){
+            .type = events[i].type, .code = events[i].code, .value = events[i].value};
+    }
+    out[count++] = syn;
+
+    ssize_t len = (ssize_t)(count * sizeof(out[0]));
+    if (write(fd, out, (size_t)len) != len) {
+        return -1;
+    }
+    return 0;
+#else
+    (void)fd;
+    (void)events;
+    (void)n;
+    return -1;
+#endif
+}
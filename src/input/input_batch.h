@@ -0,0 +1,112 @@
+/*
+ * input_batch.h - Batched, timestamped input events
+ *
+ * A 1000 Hz mouse produces two EV_REL events per millisecond.  Sent one
+ * per PKT_INPUT, each pays a packet header, a MAC and a sendto(), and
+ * on the host two write()s to uinput.  A batch carries every event the
+ * client collected since its last flush (one per display poll) in one
+ * PKT_INPUT_BATCH, and the host injects it with one write() per device.
+ *
+ * Coalescing (optional): a relative event is added onto an earlier event
+ * with the same type and code in the batch, as long as no non-relative
+ * event came in between, so motion is never moved across a click or a
+ * key.  The merged event keeps the earliest timestamp.
+ *
+ * Payload (PKT_INPUT_BATCH), little-endian:
+ *
+ *   offset  size  field
+ *   0       2     seq      batch sequence number
+ *   2       1     count    events that follow (1..INPUT_BATCH_MAX_EVENTS)
+ *   3       1     flags    INPUT_BATCH_FLAG_*
+ *   4       8     base_us  sender clock (µs) of the first event
+ *   12      4     send_dt  µs from base_us to when the batch was sent
+ *   16      9×n   events   u8 type, u16 code, s32 value, u16 dt (µs from base_us)
+ *
+ * Timestamps are on the sender's clock.  The receiver only uses
+ * differences between them (an event's age when the batch left), so the
+ * two clocks need not agree.
+ *
+ * Thread-safety: a batch is NOT thread-safe.
+ */
+
+#ifndef ROOTSTREAM_INPUT_BATCH_H
+#define ROOTSTREAM_INPUT_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INPUT_BATCH_MAX_EVENTS 64 /* Events per batch */
+#define INPUT_BATCH_HEADER_SIZE 16
+#define INPUT_BATCH_EVENT_SIZE 9
+#define INPUT_BATCH_MAX_PAYLOAD \
+    (INPUT_BATCH_HEADER_SIZE + INPUT_BATCH_MAX_EVENTS * INPUT_BATCH_EVENT_SIZE)
+#define INPUT_BATCH_MAX_SPAN_US 0xFFFF /* Largest event dt from base_us */
+
+#define INPUT_BATCH_FLAG_COALESCED 0x01 /* Relative events were merged */
+
+/* One input event (sender clock) */
+typedef struct {
+    uint8_t type;     /* EV_KEY, EV_REL, EV_ABS */
+    uint16_t code;    /* Key/button/axis code */
+    int32_t value;    /* Value/delta */
+    uint64_t time_us; /* When it happened */
+} input_batch_event_t;
+
+/* Batch header as decoded */
+typedef struct {
+    uint16_t seq;
+    uint8_t flags;
+    uint64_t base_us; /* Time of the first event */
+    uint64_t send_us; /* Time the batch was sent */
+} input_batch_info_t;
+
+/* Batch being built by the sender */
+typedef struct {
+    input_batch_event_t events[INPUT_BATCH_MAX_EVENTS];
+    int count;
+    int merge_from; /* First event coalescing may add onto */
+    bool coalesce;
+    bool merged;        /* Something was coalesced since the last reset */
+    uint64_t coalesced; /* Events merged away since init */
+} input_batch_t;
+
+/* Start an empty batch */
+void input_batch_init(input_batch_t *b, bool coalesce);
+
+/* Empty the batch after it was sent (keeps the coalescing setting) */
+void input_batch_reset(input_batch_t *b);
+
+/* Add an event.  Returns 1 if it was coalesced into an earlier one, 0 if
+ * appended, -1 if the batch is full or the event is too far from its
+ * first one: send the batch, reset it and add again. */
+int input_batch_add(input_batch_t *b, uint8_t type, uint16_t code, int32_t value,
+                    uint64_t now_us);
+
+/* Encode the batch sent at now_us.  Returns the payload length, 0 if the
+ * batch is empty or cap is too small. */
+size_t input_batch_encode(const input_batch_t *b, uint16_t seq, uint64_t now_us, uint8_t *buf,
+                          size_t cap);
+
+/* Decode a payload into at most max events; *info may be NULL.  Returns
+ * the event count, or -1 if the payload is malformed or holds more than
+ * max events. */
+int input_batch_decode(const uint8_t *buf, size_t len, input_batch_info_t *info,
+                       input_batch_event_t *events, int max);
+
+/* Write events to a uinput device with a single write(): a SYN_REPORT
+ * closes the batch, and one is put before any event whose type and code
+ * already occur in the current report so no state change is folded
+ * away.  Timestamps are not copied (uinput stamps events itself).
+ * Returns 0, or -1 on error or if n is out of range. */
+int input_batch_inject(int fd, const input_batch_event_t *events, int n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_INPUT_BATCH_H */
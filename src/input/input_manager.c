@@ -10,10 +10,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
 #include <unistd.h>
 
 #include "../../include/rootstream.h"
+#include "input_batch.h"
 
 #ifdef __linux__
 #include <linux/uinput.h>
@@ -23,35 +23,10 @@
  * Emit an input event to a device
  */
 static int emit_event(int fd, uint16_t type, uint16_t code, int32_t value) {
-#ifdef __linux__
-    struct input_event ev = {0};
-
-    ev.type = type;
-    ev.code = code;
-    ev.value = value;
-
-    /* Set timestamp */
-    gettimeofday(&ev.time, NULL);
-
-    if (write(fd, &ev, sizeof(ev)) < 0)
-        return -1;
+    input_batch_event_t ev = {.type = (uint8_t)type, .code = code, .value = value};
 
-    /* Sync event */
-    ev.type = EV_SYN;
-    ev.code = SYN_REPORT;
-    ev.value = 0;
-
-    if (write(fd, &ev, sizeof(ev)) < 0)
-        return -1;
-
-    return 0;
-#else
-    (void)fd;
-    (void)type;
-    (void)code;
-    (void)value;
-    return -1;
-#endif
+    /* Event and SYN_REPORT in one write() */
+    return input_batch_inject(fd, &ev, 1);
 }
 
 /*
@@ -329,6 +304,84 @@ static int process_input_event(input_manager_ctx_t *mgr, const input_event_pkt_t
     return result;
 }
 
+/*
+ * Inject one event through the active backend
+ */
+static int inject_event(input_manager_ctx_t *mgr, const input_event_pkt_t *event) {
+    int result = 0;
+
+    switch (mgr->backend_type) {
+        case INPUT_BACKEND_UINPUT:
+            result = process_input_event(mgr, event);
+            break;
+
+        case INPUT_BACKEND_XDOTOOL:
+            /* Use xdotool backend functions */
+            if (event->type == EV_KEY && event->code < BTN_MOUSE) {
+                result = input_inject_key_xdotool(event->code, event->value != 0);
+            } else if (event->type == EV_REL || event->type == EV_KEY) {
+                /* For mouse events, xdotool needs different handling */
+                result = 0; /* Simplified for now */
+            }
+            break;
+
+        case INPUT_BACKEND_LOGGING:
+            /* Use logging backend functions */
+            if (event->type == EV_KEY && event->code < BTN_MOUSE) {
+                result = input_inject_key_logging(event->code, event->value != 0);
+            } else {
+                result = 0; /* Log only */
+            }
+            break;
+    }
+
+    return result;
+}
+
+/*
+ * Inject a batch through uinput: one write() per device
+ */
+static int inject_batch_uinput(input_manager_ctx_t *mgr, const input_batch_event_t *events,
+                               int n) {
+#ifdef __linux__
+    input_batch_event_t kbd[INPUT_BATCH_MAX_EVENTS];
+    input_batch_event_t mouse[INPUT_BATCH_MAX_EVENTS];
+    input_batch_event_t pad[INPUT_BATCH_MAX_EVENTS];
+    int nkbd = 0, nmouse = 0, npad = 0;
+
+    for (int i = 0; i < n; i++) {
+        const input_batch_event_t *e = &events[i];
+        if (e->type == EV_KEY && e->code < BTN_MOUSE) {
+            kbd[nkbd++] = *e;
+        } else if ((e->type == EV_KEY && e->code < BTN_JOYSTICK) || e->type == EV_REL) {
+            mouse[nmouse++] = *e;
+        } else if (e->type == EV_KEY || e->type == EV_ABS) {
+            pad[npad++] = *e;
+        }
+    }
+
+    int result = 0;
+    if (nkbd > 0 && mgr->device_fd_kbd >= 0 &&
+        input_batch_inject(mgr->device_fd_kbd, kbd, nkbd) < 0) {
+        result = -1;
+    }
+    if (nmouse > 0 && mgr->device_fd_mouse >= 0 &&
+        input_batch_inject(mgr->device_fd_mouse, mouse, nmouse) < 0) {
+        result = -1;
+    }
+    if (npad > 0 && mgr->device_fd_gamepad >= 0 &&
+        input_batch_inject(mgr->device_fd_gamepad, pad, npad) < 0) {
+        result = -1;
+    }
+    return result;
+#else
+    (void)mgr;
+    (void)events;
+    (void)n;
+    return -1;
+#endif
+}
+
 /*
  * Initialize input manager
  */
@@ -464,32 +517,7 @@ int input_manager_submit_packet(rootstream_ctx_t *ctx, const input_event_pkt_t *
     uint64_t receive_time = get_timestamp_us();
 
     /* Process the event based on backend */
-    int result = 0;
-
-    switch (mgr->backend_type) {
-        case INPUT_BACKEND_UINPUT:
-            result = process_input_event(mgr, event);
-            break;
-
-        case INPUT_BACKEND_XDOTOOL:
-            /* Use xdotool backend functions */
-            if (event->type == EV_KEY && event->code < BTN_MOUSE) {
-                result = input_inject_key_xdotool(event->code, event->value != 0);
-            } else if (event->type == EV_REL || event->type == EV_KEY) {
-                /* For mouse events, xdotool needs different handling */
-                result = 0; /* Simplified for now */
-            }
-            break;
-
-        case INPUT_BACKEND_LOGGING:
-            /* Use logging backend functions */
-            if (event->type == EV_KEY && event->code < BTN_MOUSE) {
-                result = input_inject_key_logging(event->code, event->value != 0);
-            } else {
-                result = 0; /* Log only */
-            }
-            break;
-    }
+    int result = inject_event(mgr, event);
 
     if (result == 0) {
         /* Update tracking */
@@ -567,8 +595,111 @@ int input_manager_unregister_client(rootstream_ctx_t *ctx, uint32_t client_id) {
     return -1;
 }
 
+/*
+ * Submit a PKT_INPUT_BATCH payload for processing
+ *
+ * The batch sequence number takes the place of the per-event one for
+ * deduplication.  Event times are carried over to the host clock by
+ * their age when the batch was sent (the network leg is not counted).
+ */
+int input_manager_submit_batch(rootstream_ctx_t *ctx, const uint8_t *payload, size_t len,
+                               uint32_t client_id) {
+    input_batch_event_t events[INPUT_BATCH_MAX_EVENTS];
+    input_batch_info_t info;
+
+    if (!ctx || !ctx->input_manager || !payload) {
+        return -1;
+    }
+
+    input_manager_ctx_t *mgr = ctx->input_manager;
+
+    if (!mgr->initialized) {
+        return -1;
+    }
+
+    int n = input_batch_decode(payload, len, &info, events, INPUT_BATCH_MAX_EVENTS);
+    if (n < 0) {
+        return -1;
+    }
+
+    if (is_duplicate_event(mgr, client_id, info.seq)) {
+        mgr->duplicate_inputs_detected++;
+        return 0;
+    }
+
+    uint64_t receive_time = get_timestamp_us();
+    int result = 0;
+
+    if (mgr->backend_type == INPUT_BACKEND_UINPUT) {
+        result = inject_batch_uinput(mgr, events, n);
+    } else {
+        for (int i = 0; i < n; i++) {
+            input_event_pkt_t event = {
+                .type = events[i].type, .code = events[i].code, .value = events[i].value};
+            if (inject_event(mgr, &event) < 0) {
+                result = -1;
+            }
+        }
+    }
+
+    if (result != 0) {
+        return result;
+    }
+
+    uint64_t inject_time = get_timestamp_us();
+    update_client_tracking(mgr, client_id, info.seq, info.send_us);
+    mgr->total_inputs_processed += (uint64_t)n;
+
+    for (int i = 0; i < n; i++) {
+        uint64_t age = info.send_us > events[i].time_us ? info.send_us - events[i].time_us : 0;
+        uint64_t host_us = receive_time > age ? receive_time - age : 0;
+        mgr->total_latency_us += inject_time - host_us;
+        mgr->latency_samples++;
+
+        /* Oldest press not yet seen in a frame */
+        if (events[i].type == EV_KEY && events[i].value == 1 && mgr->pending_click_us == 0 &&
+            host_us > 0) {
+            mgr->pending_click_us = host_us;
+            mgr->pending_click_inject_us = inject_time;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Note a video frame leaving the host
+ *
+ * The first frame captured after a press was injected is the first that
+ * can show its effect; the time from the press to that frame being sent
+ * is one click-to-photon sample.
+ */
+void input_manager_on_video_frame(rootstream_ctx_t *ctx, uint64_t capture_us) {
+    if (!ctx || !ctx->input_manager) {
+        return;
+    }
+
+    input_manager_ctx_t *mgr = ctx->input_manager;
+
+    if (mgr->pending_click_us == 0 || capture_us < mgr->pending_click_inject_us) {
+        return;
+    }
+
+    uint64_t latency = get_timestamp_us() - mgr->pending_click_us;
+    mgr->total_click_latency_us += latency;
+    mgr->click_latency_samples++;
+    if (latency > mgr->max_click_latency_us) {
+        mgr->max_click_latency_us = latency;
+    }
+    mgr->pending_click_us = 0;
+}
+
 /*
  * Get average input latency in milliseconds
+ *
+ * Click-to-photon (press on the client to the first frame showing it
+ * leaving the host, see input_manager_on_video_frame()) once a sample
+ * exists, otherwise event-to-injection latency.
  */
 uint32_t input_manager_get_latency_ms(rootstream_ctx_t *ctx) {
     if (!ctx || !ctx->input_manager) {
@@ -577,6 +708,10 @@ uint32_t input_manager_get_latency_ms(rootstream_ctx_t *ctx) {
 
     input_manager_ctx_t *mgr = ctx->input_manager;
 
+    if (mgr->click_latency_samples > 0) {
+        return (uint32_t)(mgr->total_click_latency_us / mgr->click_latency_samples / 1000);
+    }
+
     if (mgr->latency_samples == 0) {
         return 0;
     }
@@ -15,6 +15,7 @@
 #include <windows.h>
 
 #include "../include/rootstream.h"
+#include "input/input_batch.h"
 
 /* Linux input event types (from linux/input-event-codes.h) */
 #define EV_SYN 0x00
@@ -466,6 +467,47 @@ int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
     }
 }
 
+/*
+ * Process a batch of input events from network
+ *
+ * SendInput() has no frame boundary to batch into, so events are
+ * injected one by one in order.
+ */
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len) {
+    input_batch_event_t events[INPUT_BATCH_MAX_EVENTS];
+    (void)peer;
+
+    if (!ctx || !payload) {
+        return -1;
+    }
+
+    int n = input_batch_decode(payload, len, NULL, events, INPUT_BATCH_MAX_EVENTS);
+    if (n < 0) {
+        return -1;
+    }
+
+    int result = 0;
+    for (int i = 0; i < n; i++) {
+        input_event_pkt_t event = {
+            .type = events[i].type, .code = events[i].code, .value = events[i].value};
+        if (rootstream_input_process(ctx, &event) < 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/*
+ * Drop @peer's input state
+ *
+ * Nothing to drop: batches are not tracked per peer on Windows.
+ */
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer) {
+    (void)ctx;
+    (void)peer;
+}
+
 /*
  * Cleanup input system
  *
@@ -62,6 +62,45 @@ static void fill_metric_samples(const latency_stats_t *stats, uint64_t *capture,
     }
 }
 
+static uint64_t sample_field(const latency_sample_t *sample, int field) {
+    switch (field) {
+        case 0:
+            return sample->encode_wait_us;
+        case 1:
+            return sample->send_wait_us;
+        case 2:
+            return sample->capture_queue_depth;
+        default:
+            return sample->encode_queue_depth;
+    }
+}
+
+/*
+ * Queue wait/depth summary for the pipelined host.  Each metric is sorted
+ * in the caller's scratch array (count entries) in turn.
+ */
+static void latency_report_queues(const latency_stats_t *stats, uint64_t *scratch) {
+    static const char *names[] = {"capture->encode wait", "encode->send wait",
+                                  "capture queue depth", "encode queue depth"};
+    size_t sample_count = stats->count;
+    bool wrapped = stats->count >= stats->capacity;
+
+    for (int field = 0; field < 4; field++) {
+        for (size_t i = 0; i < sample_count; i++) {
+            size_t index = wrapped ? (stats->cursor + i) % stats->capacity : i;
+            scratch[i] = sample_field(&stats->samples[index], field);
+        }
+        qsort(scratch, sample_count, sizeof(uint64_t), compare_u64);
+
+        uint64_t p50 = percentile_value(scratch, sample_count, 0.50);
+        uint64_t p99 = percentile_value(scratch, sample_count, 0.99);
+        uint64_t max = scratch[sample_count - 1];
+        const char *unit = field < 2 ? "us" : "";
+        printf("  %s: p50=%lu%s p99=%lu%s max=%lu%s\n", names[field], p50, unit, p99, unit, max,
+               unit);
+    }
+}
+
 static void latency_report(latency_stats_t *stats, uint64_t now_ms) {
     if (!stats->enabled || stats->count == 0) {
         return;
@@ -113,6 +152,10 @@ static void latency_report(latency_stats_t *stats, uint64_t now_ms) {
     printf("  send:    p50=%luus p95=%luus p99=%luus\n", send_p50, send_p95, send_p99);
     printf("  total:   p50=%luus p95=%luus p99=%luus\n", total_p50, total_p95, total_p99);
 
+    if (stats->pipelined) {
+        latency_report_queues(stats, capture);
+    }
+
     free(capture);
     free(encode);
     free(send);
@@ -62,6 +62,7 @@ static void print_usage(const char *progname) {
     printf("  --no-discovery      Disable mDNS auto-discovery\n");
     printf("  --latency-log       Enable latency percentile logging\n");
     printf("  --latency-interval MS  Latency log interval in ms (default: 1000)\n");
+    printf("  --pipeline          Overlap capture/encode/send on separate threads\n");
     printf("\n");
     printf("Manual Peer Entry (PHASE 5):\n");
     printf("  --peer-add IP:PORT  Manually add peer by IP address and port\n");
@@ -398,6 +399,7 @@ int main(int argc, char **argv) {
                                            {"input", required_argument, 0, 0},
                                            {"diagnostics", no_argument, 0, 0},
                                            {"ai-coding-logs", optional_argument, 0, 0},
+                                           {"pipeline", no_argument, 0, 0},
                                            {0, 0, 0, 0}};
 
     bool show_qr = false;
@@ -420,6 +422,7 @@ int main(int argc, char **argv) {
     bool latency_log = false;
     uint64_t latency_interval_ms = 1000;
     bool backend_verbose = false;
+    bool pipeline = false;
 
     int opt;
     int option_index = 0;
@@ -446,6 +449,8 @@ int main(int argc, char **argv) {
                 } else if (strcmp(long_options[option_index].name, "ai-coding-logs") == 0) {
                     enable_ai_logging = true;
                     ai_log_file = optarg; /* May be NULL for stderr */
+                } else if (strcmp(long_options[option_index].name, "pipeline") == 0) {
+                    pipeline = true;
                 }
                 break;
             case 'h':
@@ -541,6 +546,9 @@ int main(int argc, char **argv) {
 
     ctx.port = port;
     ctx.encoder.bitrate = (uint32_t)bitrate * 1000;
+    if (pipeline) {
+        ctx.settings.pipeline_enabled = true;
+    }
     ctx.is_host = false;
 
     if (display_idx < 0) {
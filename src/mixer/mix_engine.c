@@ -1,23 +1,319 @@
 /*
  * mix_engine.c — Weighted PCM blending engine
+ *
+ * Per block of up to MIX_MAX_FRAMES, each bus is summed into one float
+ * accumulator (which stays in L1) and then limited and converted once.
+ *
+ * Limiter
+ * ───────
+ * For every sample the gain r that would bring its peak onto the
+ * soft-knee curve is computed.  With a look-ahead of L frames:
+ *
+ *   1. wmin = min(r) over the last L + 1 frames (monotonic deque)
+ *   2. h    = wmin, or a release step towards it if it is rising
+ *   3. g    = mean(h) over the last L + 1 frames
+ *
+ * and g is applied to the input delayed by L.  Each h in the mean is at
+ * most the r of the delayed sample, so g never overshoots, and the mean
+ * turns gain changes into ramps L frames long.  With L = 0 this reduces
+ * to an instant-attack peak limiter.
  */
 
 #include "mix_engine.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MIX_X86 1
+#endif
+
+#define MIX_FULL_SCALE 32768.0f
+#define MIX_INDEX_SIZE 128 /* id → slot table, power of two ≥ 2 × MIX_MAX_SOURCES */
+
+/* acc[i] += gain * in[i] */
+typedef void (*mix_accumulate_fn)(float *acc, const int16_t *in, float gain, int n);
+
+typedef struct {
+    float *delay;    /* L input samples */
+    float *hbuf;     /* L + 1 smoothed gains */
+    float *dq_val;   /* Sliding-minimum deque, L + 1 entries */
+    uint32_t *dq_t;
+    int dq_head;
+    int dq_len;
+    double hsum;
+    float env;
+    uint32_t t;
+    int dpos;        /* t mod L */
+    int hpos;        /* t mod (L + 1) */
+} mix_limiter_t;
+
 struct mix_engine_s {
     mix_source_t sources[MIX_MAX_SOURCES];
     bool used[MIX_MAX_SOURCES];
     int count;
+    int8_t index[MIX_INDEX_SIZE]; /* Open addressing, -1 = empty */
+
+    float bus_gain[MIX_MAX_BUSES][MIX_MAX_SOURCES];
+
+    mix_limiter_config_t limiter_cfg;
+    float release_coef;
+    float *limiter_mem;
+    mix_limiter_t limiter[MIX_MAX_BUSES];
+
+    mix_accumulate_fn accumulate;
+    float acc[MIX_MAX_FRAMES];
 };
 
+/* ── Kernels ───────────────────────────────────────────────────────── */
+
+static void accumulate_scalar(float *acc, const int16_t *in, float gain, int n) {
+    for (int i = 0; i < n; i++)
+        acc[i] += gain * (float)in[i];
+}
+
+#ifdef MIX_X86
+
+__attribute__((target("sse2"))) static void accumulate_sse2(float *acc, const int16_t *in,
+                                                             float gain, int n) {
+    const __m128 g = _mm_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        /* Sign-extend by placing each int16 in the top half, then shifting */
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(g, lo)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(g, hi)));
+    }
+    accumulate_scalar(acc + i, in + i, gain, n - i);
+}
+
+__attribute__((target("avx2,fma"))) static void accumulate_avx2(float *acc, const int16_t *in,
+                                                                float gain, int n) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int i = 0;
+
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)));
+        _mm256_storeu_ps(acc + i, _mm256_fmadd_ps(g, lo, _mm256_loadu_ps(acc + i)));
+        _mm256_storeu_ps(acc + i + 8, _mm256_fmadd_ps(g, hi, _mm256_loadu_ps(acc + i + 8)));
+    }
+    accumulate_scalar(acc + i, in + i, gain, n - i);
+}
+
+#endif /* MIX_X86 */
+
+static mix_accumulate_fn pick_kernel(void) {
+#ifdef MIX_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return accumulate_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return accumulate_sse2;
+#endif
+    return accumulate_scalar;
+}
+
+const char *mix_engine_kernel_name(void) {
+    mix_accumulate_fn fn = pick_kernel();
+#ifdef MIX_X86
+    if (fn == accumulate_avx2)
+        return "avx2";
+    if (fn == accumulate_sse2)
+        return "sse2";
+#endif
+    (void)fn;
+    return "scalar";
+}
+
+/* ── Limiter ───────────────────────────────────────────────────────── */
+
+static void limiter_reset(mix_limiter_t *l, int lookahead) {
+    for (int i = 0; i < lookahead; i++)
+        l->delay[i] = 0.0f;
+    for (int i = 0; i <= lookahead && l->hbuf; i++)
+        l->hbuf[i] = 1.0f;
+    l->hsum = lookahead + 1;
+    l->dq_head = 0;
+    l->dq_len = 0;
+    l->env = 1.0f;
+    l->t = 0;
+    l->dpos = 0;
+    l->hpos = 0;
+}
+
+/* Gain that puts a sample of magnitude @a (full scale = 1) on the knee */
+static inline float knee_gain(float a, float threshold) {
+    if (a <= threshold)
+        return 1.0f;
+    if (threshold >= 1.0f)
+        return 1.0f / a;
+    float span = 1.0f - threshold;
+    return (threshold + span * tanhf((a - threshold) / span)) / a;
+}
+
+static inline int16_t to_s16(float v) {
+    long r = lrintf(v);
+    if (r > 32767)
+        return 32767;
+    if (r < -32768)
+        return -32768;
+    return (int16_t)r;
+}
+
+static void limit_block(const mix_engine_t *e, mix_limiter_t *l, const float *in, int16_t *out,
+                        int n) {
+    const float threshold = e->limiter_cfg.threshold;
+    const float rc = e->release_coef;
+    const int la = e->limiter_cfg.lookahead_frames;
+
+    for (int i = 0; i < n; i++) {
+        float x = in[i];
+        float r = knee_gain(fabsf(x) * (1.0f / MIX_FULL_SCALE), threshold);
+
+        if (la == 0) {
+            l->env = r < l->env ? r : l->env + (r - l->env) * rc;
+            out[i] = to_s16(x * l->env);
+            continue;
+        }
+
+        /* 1. Minimum over the window, via a deque of increasing values */
+        const int cap = la + 1;
+        if (l->dq_len > 0 && l->t - l->dq_t[l->dq_head] > (uint32_t)la) {
+            if (++l->dq_head == cap)
+                l->dq_head = 0;
+            l->dq_len--;
+        }
+        while (l->dq_len > 0) {
+            int back = l->dq_head + l->dq_len - 1;
+            if (back >= cap)
+                back -= cap;
+            if (l->dq_val[back] < r)
+                break;
+            l->dq_len--;
+        }
+        int slot = l->dq_head + l->dq_len;
+        if (slot >= cap)
+            slot -= cap;
+        l->dq_val[slot] = r;
+        l->dq_t[slot] = l->t;
+        l->dq_len++;
+        float wmin = l->dq_val[l->dq_head];
+
+        /* 2. Release towards a rising minimum, follow a falling one */
+        l->env = wmin < l->env ? wmin : l->env + (wmin - l->env) * rc;
+
+        /* 3. Box average, applied to the delayed input */
+        l->hsum += l->env - l->hbuf[l->hpos];
+        l->hbuf[l->hpos] = l->env;
+        if (++l->hpos == cap)
+            l->hpos = 0;
+
+        float delayed = l->delay[l->dpos];
+        l->delay[l->dpos] = x;
+        if (++l->dpos == la)
+            l->dpos = 0;
+
+        out[i] = to_s16(delayed * (float)(l->hsum / cap));
+        l->t++;
+    }
+}
+
+int mix_engine_set_limiter(mix_engine_t *e, const mix_limiter_config_t *cfg) {
+    if (!e || !cfg)
+        return -1;
+    if (!(cfg->threshold > 0.0f && cfg->threshold <= 1.0f))
+        return -1;
+    if (cfg->lookahead_frames < 0 || cfg->lookahead_frames > MIX_LIMITER_MAX_LOOKAHEAD)
+        return -1;
+    if (cfg->release_frames < 0)
+        return -1;
+
+    const size_t la = (size_t)cfg->lookahead_frames;
+    float *mem = NULL;
+    if (la > 0) {
+        /* delay (L) + hbuf (L+1) + dq_val (L+1) + dq_t (L+1) per bus */
+        mem = malloc(MIX_MAX_BUSES * (4 * la + 3) * sizeof(float));
+        if (!mem)
+            return -1;
+    }
+    free(e->limiter_mem);
+    e->limiter_mem = mem;
+
+    e->limiter_cfg = *cfg;
+    e->release_coef = cfg->release_frames > 0 ? 1.0f - expf(-1.0f / (float)cfg->release_frames)
+                                              : 1.0f;
+    for (int b = 0; b < MIX_MAX_BUSES; b++) {
+        mix_limiter_t *l = &e->limiter[b];
+        memset(l, 0, sizeof(*l));
+        if (mem) {
+            float *base = mem + (size_t)b * (4 * la + 3);
+            l->delay = base;
+            l->hbuf = base + la;
+            l->dq_val = base + 2 * la + 1;
+            l->dq_t = (uint32_t *)(base + 3 * la + 2);
+        }
+        limiter_reset(l, (int)la);
+    }
+    return 0;
+}
+
+/* ── Sources ───────────────────────────────────────────────────────── */
+
+static inline unsigned index_hash(uint32_t id) {
+    return (id * 2654435761u) >> (32 - 7);
+}
+
+static int find_slot(const mix_engine_t *e, uint32_t id) {
+    for (unsigned h = index_hash(id);; h = (h + 1) & (MIX_INDEX_SIZE - 1)) {
+        int slot = e->index[h];
+        if (slot < 0)
+            return -1;
+        if (e->sources[slot].id == id)
+            return slot;
+    }
+}
+
+static void index_insert(mix_engine_t *e, int slot) {
+    unsigned h = index_hash(e->sources[slot].id);
+    while (e->index[h] >= 0)
+        h = (h + 1) & (MIX_INDEX_SIZE - 1);
+    e->index[h] = (int8_t)slot;
+}
+
+/* Removal is rare: rebuild rather than handle tombstones */
+static void index_rebuild(mix_engine_t *e) {
+    memset(e->index, -1, sizeof(e->index));
+    for (int i = 0; i < MIX_MAX_SOURCES; i++)
+        if (e->used[i])
+            index_insert(e, i);
+}
+
 mix_engine_t *mix_engine_create(void) {
-    return calloc(1, sizeof(mix_engine_t));
+    mix_engine_t *e = calloc(1, sizeof(mix_engine_t));
+    if (!e)
+        return NULL;
+    memset(e->index, -1, sizeof(e->index));
+    e->accumulate = pick_kernel();
+
+    mix_limiter_config_t cfg = {
+        .threshold = 0.9f,
+        .lookahead_frames = 0,
+        .release_frames = 2400,
+    };
+    mix_engine_set_limiter(e, &cfg);
+    return e;
 }
 
 void mix_engine_destroy(mix_engine_t *e) {
+    if (!e)
+        return;
+    free(e->limiter_mem);
     free(e);
 }
 
@@ -25,13 +321,6 @@ int mix_engine_source_count(const mix_engine_t *e) {
     return e ? e->count : 0;
 }
 
-static int find_slot(const mix_engine_t *e, uint32_t id) {
-    for (int i = 0; i < MIX_MAX_SOURCES; i++)
-        if (e->used[i] && e->sources[i].id == id)
-            return i;
-    return -1;
-}
-
 int mix_engine_add_source(mix_engine_t *e, const mix_source_t *src) {
     if (!e || !src)
         return -1;
@@ -45,6 +334,9 @@ int mix_engine_add_source(mix_engine_t *e, const mix_source_t *src) {
             e->sources[i] = *src;
             e->used[i] = true;
             e->count++;
+            for (int b = 0; b < MIX_MAX_BUSES; b++)
+                e->bus_gain[b][i] = 1.0f;
+            index_insert(e, i);
             return 0;
         }
     }
@@ -59,6 +351,7 @@ int mix_engine_remove_source(mix_engine_t *e, uint32_t id) {
         return -1;
     e->used[slot] = false;
     e->count--;
+    index_rebuild(e);
     return 0;
 }
 
@@ -72,40 +365,66 @@ int mix_engine_update_source(mix_engine_t *e, const mix_source_t *src) {
     return 0;
 }
 
+int mix_engine_set_bus_gain(mix_engine_t *e, int bus, uint32_t src_id, float gain) {
+    if (!e || bus < 0 || bus >= MIX_MAX_BUSES)
+        return -1;
+    int slot = find_slot(e, src_id);
+    if (slot < 0)
+        return -1;
+    if (gain < 0.0f)
+        gain = 0.0f;
+    if (gain > MIX_WEIGHT_MAX)
+        gain = MIX_WEIGHT_MAX;
+    e->bus_gain[bus][slot] = gain;
+    return 0;
+}
+
+/* ── Mixing ────────────────────────────────────────────────────────── */
+
 void mix_engine_silence(int16_t *out, int frames) {
     if (out && frames > 0)
         memset(out, 0, (size_t)frames * sizeof(int16_t));
 }
 
-int mix_engine_mix(mix_engine_t *e, const int16_t *const *inputs, const uint32_t *src_ids,
-                   int src_count, int16_t *out, int frames) {
-    if (!e || !inputs || !src_ids || !out || frames <= 0)
+int mix_engine_mix_buses(mix_engine_t *e, const int16_t *const *inputs, const uint32_t *src_ids,
+                         int src_count, int16_t *const *outs, int bus_count, int frames) {
+    if (!e || !inputs || !src_ids || !outs || frames <= 0)
         return -1;
-    if (frames > MIX_MAX_FRAMES)
+    if (bus_count < 1 || bus_count > MIX_MAX_BUSES)
         return -1;
 
-    mix_engine_silence(out, frames);
+    for (int done = 0; done < frames; done += MIX_MAX_FRAMES) {
+        int n = frames - done < MIX_MAX_FRAMES ? frames - done : MIX_MAX_FRAMES;
 
-    for (int s = 0; s < src_count; s++) {
-        if (!inputs[s])
-            continue;
-        int slot = find_slot(e, src_ids[s]);
-        if (slot < 0)
-            continue;
-        const mix_source_t *src = &e->sources[slot];
-        if (src->muted || src->weight == 0.0f)
-            continue;
+        for (int b = 0; b < bus_count; b++) {
+            if (!outs[b])
+                continue;
+            memset(e->acc, 0, (size_t)n * sizeof(float));
 
-        for (int f = 0; f < frames; f++) {
-            float sample = (float)inputs[s][f] * src->weight;
-            float mixed = (float)out[f] + sample;
-            /* Hard-clip */
-            if (mixed > 32767.0f)
-                mixed = 32767.0f;
-            else if (mixed < -32768.0f)
-                mixed = -32768.0f;
-            out[f] = (int16_t)mixed;
+            for (int s = 0; s < src_count; s++) {
+                if (!inputs[s])
+                    continue;
+                int slot = find_slot(e, src_ids[s]);
+                if (slot < 0)
+                    continue;
+                const mix_source_t *src = &e->sources[slot];
+                if (src->muted)
+                    continue;
+                float gain = src->weight * e->bus_gain[b][slot];
+                if (gain == 0.0f)
+                    continue;
+                e->accumulate(e->acc, inputs[s] + done, gain, n);
+            }
+
+            limit_block(e, &e->limiter[b], e->acc, outs[b] + done, n);
         }
     }
     return 0;
 }
+
+int mix_engine_mix(mix_engine_t *e, const int16_t *const *inputs, const uint32_t *src_ids,
+                   int src_count, int16_t *out, int frames) {
+    if (!out)
+        return -1;
+    return mix_engine_mix_buses(e, inputs, src_ids, src_count, &out, 1, frames);
+}
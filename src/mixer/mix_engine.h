@@ -5,7 +5,16 @@
  * sources, blends them with per-source linear weights, and writes the
  * result into a caller-supplied output buffer.
  *
- * Overflow is handled by symmetric hard-clipping to [-32768, 32767].
+ * All sources are summed into a float bus (SSE2/AVX2 kernels, picked at
+ * runtime), so intermediate sums neither clip nor round.  The bus then
+ * goes through a soft-knee peak limiter, once, before conversion back
+ * to int16.  Calls of any length are processed in MIX_MAX_FRAMES
+ * blocks.
+ *
+ * Besides the main mix (bus 0) the engine has MIX_MAX_BUSES - 1 extra
+ * output buses, each with its own per-source gains and limiter state —
+ * e.g. a per-viewer mix that leaves out the viewer's own microphone.
+ * mix_engine_mix_buses() renders several buses from one set of inputs.
  *
  * Thread-safety: NOT thread-safe.
  */
@@ -23,8 +32,20 @@
 extern "C" {
 #endif
 
-#define MIX_MAX_SOURCES 16  /**< Maximum simultaneously registered sources */
-#define MIX_MAX_FRAMES 4096 /**< Maximum frame count per mix call */
+#define MIX_MAX_SOURCES 64  /**< Maximum simultaneously registered sources */
+#define MIX_MAX_FRAMES 4096 /**< Frames mixed per internal block */
+#define MIX_MAX_BUSES 16    /**< Output buses, including the main mix (0) */
+#define MIX_LIMITER_MAX_LOOKAHEAD 1024 /**< Maximum limiter look-ahead in frames */
+
+/** Output limiter settings (shared by all buses) */
+typedef struct {
+    float threshold;      /**< Knee start as a fraction of full scale (0, 1];
+                               1 = hard limit at full scale */
+    int lookahead_frames; /**< Gain reduction starts this many frames before
+                               a peak; output is delayed by as much
+                               (0 … MIX_LIMITER_MAX_LOOKAHEAD) */
+    int release_frames;   /**< Frames for gain to recover ~63% after a peak */
+} mix_limiter_config_t;
 
 /** Opaque mixer engine */
 typedef struct mix_engine_s mix_engine_t;
@@ -78,11 +99,38 @@ int mix_engine_update_source(mix_engine_t *e, const mix_source_t *src);
  */
 int mix_engine_source_count(const mix_engine_t *e);
 
+/**
+ * mix_engine_set_limiter — configure the output limiter
+ *
+ * The default has no look-ahead (no added latency), a knee at 0.9 of
+ * full scale and a 2400-frame release.  Resets every bus's limiter.
+ *
+ * @param e    Engine
+ * @param cfg  Settings
+ * @return     0 on success, -1 on invalid settings
+ */
+int mix_engine_set_limiter(mix_engine_t *e, const mix_limiter_config_t *cfg);
+
+/**
+ * mix_engine_set_bus_gain — per-bus gain for one source
+ *
+ * Multiplies the source's weight on @bus only.  Every bus starts at 1.0
+ * for every source; 0 leaves the source out of that bus.
+ *
+ * @param e       Engine
+ * @param bus     Bus index (0 … MIX_MAX_BUSES-1)
+ * @param src_id  Registered source ID
+ * @param gain    Linear gain [0.0, MIX_WEIGHT_MAX]
+ * @return        0 on success, -1 if the bus or source is unknown
+ */
+int mix_engine_set_bus_gain(mix_engine_t *e, int bus, uint32_t src_id, float gain);
+
 /**
  * mix_engine_mix — blend PCM data from all non-muted sources
  *
  * Each source contributes its @frames signed-16 samples (one channel),
- * scaled by its weight.  Mixed samples are hard-clipped to [-32768, 32767].
+ * scaled by its weight, into the main bus (0).  The sum is limited and
+ * saturated to [-32768, 32767].
  *
  * @param e          Engine
  * @param inputs     Array of @source_count input buffers (each @frames samples)
@@ -95,6 +143,29 @@ int mix_engine_source_count(const mix_engine_t *e);
 int mix_engine_mix(mix_engine_t *e, const int16_t *const *inputs, const uint32_t *src_ids,
                    int src_count, int16_t *out, int frames);
 
+/**
+ * mix_engine_mix_buses — render buses 0 … @bus_count-1 from one input set
+ *
+ * @param e          Engine
+ * @param inputs     Array of @src_count input buffers (each @frames samples)
+ * @param src_ids    Source IDs corresponding to each input buffer
+ * @param src_count  Number of input buffers
+ * @param outs       @bus_count output buffers (each @frames samples);
+ *                   a NULL entry skips that bus
+ * @param bus_count  Number of buses to render (1 … MIX_MAX_BUSES)
+ * @param frames     Number of samples per buffer
+ * @return           0 on success, -1 on error
+ */
+int mix_engine_mix_buses(mix_engine_t *e, const int16_t *const *inputs, const uint32_t *src_ids,
+                         int src_count, int16_t *const *outs, int bus_count, int frames);
+
+/**
+ * mix_engine_kernel_name — name of the accumulate kernel this CPU uses
+ *
+ * @return  "avx2", "sse2" or "scalar"
+ */
+const char *mix_engine_kernel_name(void);
+
 /**
  * mix_engine_silence — fill output buffer with zeros
  *
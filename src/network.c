@@ -39,126 +39,1391 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "../include/rootstream.h"
+#include "bufpool/bp_pool.h"
+#include "chunk/frame_reasm.h"
+#include "congestion/delay_controller.h"
+#include "congestion/transport_feedback.h"
+#include "fec/fec_matrix.h"
+#include "network/nack.h"
+#include "network/plpmtud.h"
 #include "platform/platform.h"
 
+#ifndef RS_PLATFORM_WINDOWS
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#include "fanout/fanout_pool.h"
+#include "network/udp_batch.h"
+#include "network/tx_pacer.h"
+#include "network/udp_rx.h"
+#endif
+
 /* Platform-specific includes for address structures */
 #ifndef RS_PLATFORM_WINDOWS
 #include <netinet/ip.h> /* IPTOS_LOWDELAY */
 #endif
 
-#ifdef HAVE_AVAHI
-#include <avahi-client/client.h>
-#include <avahi-client/lookup.h>
-#include <avahi-common/error.h>
-#include <avahi-common/simple-watch.h>
-#endif
+#ifdef HAVE_AVAHI
+#include <avahi-client/client.h>
+#include <avahi-client/lookup.h>
+#include <avahi-common/error.h>
+#include <avahi-common/simple-watch.h>
+#endif
+
+#define PACKET_MAGIC 0x524F4F54 /* "ROOT" */
+#define DEFAULT_PORT 9876
+#define MAX_VIDEO_FRAME_SIZE (16 * 1024 * 1024)
+#define VIDEO_KEYFRAME_REQUEST_MS 250 /* Min interval between loss keyframe requests */
+#define VIDEO_FEC_GROUP_MAX 64        /* Source chunks per FEC group (≤ FEC_MAX_K) */
+#define VIDEO_FEC_MIN_PERCENT 5       /* Smallest non-zero repair overhead */
+#define VIDEO_FEC_MAX_PERCENT 50      /* Largest repair overhead */
+#define VIDEO_FEC_UPDATE_MS 500       /* Receiver loss measurement period */
+#define VIDEO_FEC_CLEAN_PERIODS 4     /* Loss-free periods before stepping down */
+#define HANDSHAKE_RETRY_MS 1000
+#define PEER_TIMEOUT_MS 5000
+#define KEEPALIVE_INTERVAL_MS 1000
+#define PEER_TX_ARENA_PACKETS 64 /* Packet slots per peer (one UDP batch) */
+#define NET_RX_BATCH 64          /* Datagrams per recvmmsg */
+#define NET_RX_MAX_BATCHES 8     /* Batches drained per rootstream_net_recv call */
+#define NET_TCP_MAX_PACKETS 64   /* TCP packets read per peer per rootstream_net_recv call */
+#define NET_FANOUT_LANE_DEPTH 2  /* Video frames queued per peer behind the one in flight */
+#define NET_FANOUT_MAX_WORKERS 4 /* Video sender threads (fewer on small machines) */
+#define NET_FEEDBACK_INTERVAL_MS 20 /* Transport feedback report period */
+#define NET_CC_MIN_BITRATE 500000   /* Lowest bitrate congestion control goes to */
+#define NET_PACING_GAIN 2.0         /* Video pacing rate over the peer's target bitrate */
+#define NET_PACER_MAX_BACKLOG (TX_PACER_QUEUE_PACKETS / 2) /* Paced packets before deltas stop */
+
+/* Forward declarations */
+static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_t recv_len,
+                                   struct sockaddr_storage *from, socklen_t fromlen,
+                                   transport_type_t transport, uint64_t arrival_us);
+static void send_video_nacks(rootstream_ctx_t *ctx, peer_t *peer);
+static int send_handshake(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *echo);
+
+static peer_t *rootstream_find_peer_by_addr(rootstream_ctx_t *ctx,
+                                            const struct sockaddr_storage *addr,
+                                            socklen_t addr_len) {
+    if (!ctx || !addr) {
+        return NULL;
+    }
+
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->addr_len != addr_len) {
+            continue;
+        }
+
+        if (addr->ss_family == AF_INET) {
+            const struct sockaddr_in *a = (const struct sockaddr_in *)addr;
+            const struct sockaddr_in *b = (const struct sockaddr_in *)&peer->addr;
+            if (a->sin_port == b->sin_port &&
+                memcmp(&a->sin_addr, &b->sin_addr, sizeof(a->sin_addr)) == 0) {
+                return peer;
+            }
+        } else if (addr->ss_family == AF_INET6) {
+            const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)addr;
+            const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)&peer->addr;
+            if (a->sin6_port == b->sin6_port &&
+                memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0) {
+                return peer;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static size_t max_plain_payload_size(size_t max_packet) {
+    if (max_packet <= sizeof(packet_header_t) + crypto_aead_chacha20poly1305_IETF_ABYTES) {
+        return 0;
+    }
+    return max_packet - sizeof(packet_header_t) - crypto_aead_chacha20poly1305_IETF_ABYTES;
+}
+
+/*
+ * Datagram size for @peer's video: its path MTU once probing found one,
+ * MAX_PACKET_SIZE otherwise (and always over TCP)
+ */
+static size_t peer_packet_size(const peer_t *peer) {
+    if (peer->tx_pmtu && peer->transport == TRANSPORT_UDP) {
+        return plpmtud_size(peer->tx_pmtu);
+    }
+    return MAX_PACKET_SIZE;
+}
+
+/*
+ * Check that a peer can receive encrypted traffic
+ */
+static bool peer_ready_for_send(const peer_t *peer) {
+    /* Check connection health */
+    if (peer->state != PEER_CONNECTED && peer->state != PEER_HANDSHAKE_RECEIVED) {
+        fprintf(stderr, "WARNING: Peer not fully connected, skipping send\n");
+        return false;
+    }
+
+    if (!peer->session.authenticated) {
+        fprintf(stderr, "ERROR: Cannot send - peer not authenticated\n");
+        fprintf(stderr, "PEER: %s\n", peer->hostname);
+        fprintf(stderr, "FIX: Complete handshake first\n");
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Per-peer transmit state, created on the peer's first send
+ *
+ * The arena is a bp_pool of packet_size blocks kept until the peer is
+ * removed, so steady-state sends never touch the heap; it is rebuilt
+ * larger only when the peer's path MTU grows.  Each slot holds a whole
+ * wire packet:
+ *
+ *   [packet_header_t][plaintext → ciphertext][MAC]
+ *
+ * Callers write plaintext directly after the header and seal it in place.
+ * For UDP peers sealed slots are queued in a udp_batch and flushed with
+ * sendmmsg/GSO once per frame (or when the arena runs out of slots).
+ * While video is being sent with a pacer set, a flush copies the packets
+ * into the pacer's queue instead and the timer thread sends them.
+ * The history remembers when each nonce went out, which transport
+ * feedback from the receiver is matched against; for a receiver that
+ * NACKs, the resend cache keeps the sealed video packets themselves.
+ */
+typedef struct peer_tx_s {
+    bp_pool_t *arena;
+    bp_block_t *pending[PEER_TX_ARENA_PACKETS]; /* Sealed slots queued in batch */
+    int pending_count;
+    size_t pending_bytes;
+#ifndef RS_PLATFORM_WINDOWS
+    udp_batch_t *batch; /* NULL: send one packet per syscall */
+    tx_pacer_t *pacer;  /* Flush into this pacer's queue, NULL = send now */
+    int pacer_flow;
+#endif
+    size_t packet_size;                      /* Arena block (and resend cache slot) size */
+    tfb_history_t *history;                  /* Send time and size by nonce */
+    nack_cache_t *rtx;                       /* Sealed video by nonce, NULL unless NACKed */
+    uint8_t fec_tail[MAX_JUMBO_PACKET_SIZE]; /* Short final chunk, zero-padded for FEC */
+} peer_tx_t;
+
+static void peer_tx_destroy(peer_tx_t *tx) {
+    if (!tx) {
+        return;
+    }
+#ifndef RS_PLATFORM_WINDOWS
+    udp_batch_destroy(tx->batch);
+#endif
+    tfb_history_destroy(tx->history);
+    nack_cache_destroy(tx->rtx);
+    bp_pool_destroy(tx->arena);
+    free(tx);
+}
+
+static void peer_tx_free(peer_t *peer) {
+    peer_tx_destroy(peer->tx);
+    peer->tx = NULL;
+}
+
+static peer_tx_t *peer_tx_create(const char *hostname, size_t packet_size) {
+    peer_tx_t *tx = calloc(1, sizeof(peer_tx_t));
+    if (!tx) {
+        fprintf(stderr, "ERROR: Cannot allocate send state (peer=%s)\n", hostname);
+        return NULL;
+    }
+
+    tx->packet_size = packet_size;
+    tx->arena = bp_pool_create(PEER_TX_ARENA_PACKETS, packet_size);
+    if (!tx->arena) {
+        fprintf(stderr, "ERROR: Cannot allocate send arena (peer=%s)\n", hostname);
+        free(tx);
+        return NULL;
+    }
+
+#ifndef RS_PLATFORM_WINDOWS
+    /* Batching is an optimisation: without it packets go out one by one */
+    tx->batch = udp_batch_create(true);
+#endif
+    /* Without a history feedback finds no sends and congestion control stays idle */
+    tx->history = tfb_history_create();
+    return tx;
+}
+
+static peer_tx_t *peer_tx_get(peer_t *peer) {
+    if (!peer->tx) {
+        peer->tx = peer_tx_create(peer->hostname, MAX_PACKET_SIZE);
+    }
+    return peer->tx;
+}
+
+/*
+ * Make the arena and resend cache hold packets of @packet_size
+ *
+ * Only grows, and only with nothing queued; cached packets are dropped.
+ * Returns the packet size the slots can be filled to.
+ */
+static size_t peer_tx_fit(peer_tx_t *tx, size_t packet_size) {
+    if (packet_size > tx->packet_size && tx->pending_count == 0) {
+        bp_pool_t *arena = bp_pool_create(PEER_TX_ARENA_PACKETS, packet_size);
+        nack_cache_t *rtx = tx->rtx ? nack_cache_create(packet_size) : NULL;
+        if (arena && (rtx || !tx->rtx)) {
+            bp_pool_destroy(tx->arena);
+            tx->arena = arena;
+            if (rtx) {
+                nack_cache_destroy(tx->rtx);
+                tx->rtx = rtx;
+            }
+            tx->packet_size = packet_size;
+        } else {
+            bp_pool_destroy(arena);
+            nack_cache_destroy(rtx);
+        }
+    }
+    return packet_size < tx->packet_size ? packet_size : tx->packet_size;
+}
+
+/*
+ * Start (or stop) keeping sent video for retransmission; starts empty
+ */
+static void peer_tx_set_rtx(peer_tx_t *tx, bool on) {
+    if (on && !tx->rtx) {
+        tx->rtx = nack_cache_create(tx->packet_size);
+    } else if (!on) {
+        nack_cache_destroy(tx->rtx);
+        tx->rtx = NULL;
+    }
+    nack_cache_reset(tx->rtx);
+}
+
+#ifndef RS_PLATFORM_WINDOWS
+/*
+ * Pacer flow carrying @peer's video, opened on first use; -1 = unpaced
+ * (TCP, or no bitrate known yet)
+ *
+ * Called once per frame on the sending thread: the flow follows the
+ * congestion controller's target (or the encoder bitrate without one)
+ * times NET_PACING_GAIN, enough headroom for a keyframe to drain
+ * within a few frame intervals without leaving as one line-rate burst.
+ */
+static int net_pacer_flow(rootstream_ctx_t *ctx, peer_t *peer) {
+    uint32_t target = peer->tx_cc ? delay_controller_target_bps(peer->tx_cc) : 0;
+    if (target == 0) {
+        target = encoder_get_bitrate(&ctx->encoder);
+    }
+    if (target == 0) {
+        target = ctx->settings.video_bitrate;
+    }
+    if (peer->transport != TRANSPORT_UDP || target == 0) {
+        return -1; /* No rate to pace at */
+    }
+    if (!ctx->tx_pacer) {
+        ctx->tx_pacer = tx_pacer_create(ctx->sock_fd, MAX_PEERS, MAX_PACKET_SIZE);
+        if (!ctx->tx_pacer) {
+            fprintf(stderr, "WARNING: Cannot start video pacer, sending unpaced\n");
+            return -1;
+        }
+    }
+    if (peer->pacer_flow <= 0) {
+        int flow = tx_pacer_flow_open(ctx->tx_pacer, (const struct sockaddr *)&peer->addr,
+                                      peer->addr_len);
+        if (flow < 0) {
+            return -1;
+        }
+        peer->pacer_flow = flow + 1;
+    }
+
+    if (tx_pacer_set_max_packet(ctx->tx_pacer, peer->pacer_flow - 1, peer_packet_size(peer)) < 0) {
+        return -1;
+    }
+    tx_pacer_set_rate(ctx->tx_pacer, peer->pacer_flow - 1, (uint64_t)(target * NET_PACING_GAIN));
+    return peer->pacer_flow - 1;
+}
+#endif
+
+/*
+ * Encrypt a packet slot in place and fill in its header
+ *
+ * @param session    Session key
+ * @param nonce      Nonce for this packet (never reused with @session)
+ * @param type       Packet type
+ * @param packet     Slot with plain_len bytes of plaintext after the header
+ * @param plain_len  Plaintext length
+ * @return           Wire length, or 0 on error
+ */
+static size_t seal_packet_nonce(const crypto_session_t *session, uint64_t nonce, uint8_t type,
+                                uint8_t *packet, size_t plain_len) {
+    uint8_t *payload = packet + sizeof(packet_header_t);
+
+    /* ChaCha20-Poly1305 supports in-place operation: ciphertext overwrites
+     * the plaintext and the MAC lands directly after it. */
+    size_t cipher_len = 0;
+    if (crypto_encrypt_packet(session, payload, plain_len, payload, &cipher_len, nonce) < 0) {
+        fprintf(stderr, "ERROR: Encryption failed\n");
+        return 0;
+    }
+
+    /* Build header */
+    packet_header_t *hdr = (packet_header_t *)packet;
+    hdr->magic = PACKET_MAGIC;
+    hdr->version = PROTOCOL_VERSION;
+    hdr->type = type;
+    hdr->flags = 0;
+    hdr->nonce = nonce;
+    hdr->payload_size = cipher_len;
+    /* MAC is included in cipher_len by crypto_encrypt_packet */
+
+    return sizeof(packet_header_t) + cipher_len;
+}
+
+/*
+ * Seal a packet slot with the peer's next nonce
+ */
+static size_t seal_packet(peer_t *peer, uint8_t type, uint8_t *packet, size_t plain_len) {
+    /* Get nonce (monotonically increasing counter) */
+    uint64_t nonce = peer->session.nonce_counter++;
+    return seal_packet_nonce(&peer->session, nonce, type, packet, plain_len);
+}
+
+/*
+ * Transport failed: mark the peer for reconnection
+ */
+static void transmit_failed(rootstream_ctx_t *ctx, peer_t *peer) {
+    fprintf(stderr, "WARNING: Send failed, marking peer for reconnection\n");
+    peer->state = PEER_DISCONNECTED;
+    if (peer->reconnect_ctx) {
+        peer_try_reconnect(ctx, peer);
+    }
+}
+
+/*
+ * Hand one sealed packet to the peer's transport
+ */
+static int transmit_packet(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *packet,
+                           size_t len) {
+    /* Dispatch to transport */
+    int ret = -1;
+    switch (peer->transport) {
+        case TRANSPORT_UDP:
+            ret = rs_socket_sendto(ctx->sock_fd, packet, len, 0, (struct sockaddr *)&peer->addr,
+                                   peer->addr_len);
+            if (ret < 0) {
+                int err = rs_socket_error();
+                fprintf(stderr, "ERROR: UDP send failed: %s\n", rs_socket_strerror(err));
+            } else {
+                ctx->bytes_sent += ret;
+                peer->last_sent = get_timestamp_ms();
+                ret = 0; /* Success */
+            }
+            break;
+
+        case TRANSPORT_TCP:
+            ret = rootstream_net_tcp_send(ctx, peer, packet, len);
+            break;
+
+        default:
+            fprintf(stderr, "ERROR: Unknown transport type %d\n", peer->transport);
+            ret = -1;
+    }
+
+    if (ret < 0) {
+        transmit_failed(ctx, peer);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Remember when a sealed packet left, for transport feedback, and keep
+ * video for retransmission
+ *
+ * Keepalives are sealed but never authenticated by the receiver, so it
+ * cannot report them; they stay out of the history.  So do resends: the
+ * receiver does not report them and their nonce was recorded already.
+ */
+static void peer_tx_record(peer_tx_t *tx, const uint8_t *packet, uint64_t now_us) {
+    const packet_header_t *hdr = (const packet_header_t *)packet;
+    size_t len = sizeof(packet_header_t) + hdr->payload_size;
+    if (hdr->type == PKT_PING || hdr->type == PKT_PONG || (hdr->flags & PKT_FLAG_RETRANSMIT)) {
+        return;
+    }
+    tfb_history_record(tx->history, hdr->nonce, now_us, (uint32_t)len);
+    if (hdr->type == PKT_VIDEO) {
+        nack_cache_store(tx->rtx, hdr->nonce, packet, len);
+    }
+}
+
+#ifndef RS_PLATFORM_WINDOWS
+/*
+ * Hand the queued packets to the pacer; each is recorded as sent at its
+ * departure time, so feedback measures the network, not the pacer queue
+ *
+ * A packet the pacer has no room for is dropped like one lost on the
+ * wire.  Sends the pacer thread could not make are reported here.
+ */
+static int peer_tx_pace_batch(peer_tx_t *tx, size_t *bytes) {
+    udp_batch_clear(tx->batch); /* Its references die with the slots */
+    for (int i = 0; i < tx->pending_count; i++) {
+        const uint8_t *packet = tx->pending[i]->data;
+        size_t len = sizeof(packet_header_t) + ((const packet_header_t *)packet)->payload_size;
+        uint64_t depart_us;
+        if (tx_pacer_enqueue(tx->pacer, tx->pacer_flow, packet, len, &depart_us) == 0) {
+            peer_tx_record(tx, packet, depart_us);
+            *bytes += len;
+        }
+    }
+    return tx_pacer_take_error(tx->pacer, tx->pacer_flow) ? -1 : 0;
+}
+#endif
+
+/*
+ * Send every queued packet in one batch and return the slots to the arena
+ *
+ * @param bytes  Receives the bytes sent
+ * @return       0 on success, -1 if the batch could not be sent
+ */
+static int peer_tx_send_batch(rs_socket_t sock, peer_tx_t *tx,
+                              const struct sockaddr_storage *addr, socklen_t addr_len,
+                              size_t *bytes) {
+    int ret = 0;
+    *bytes = 0;
+#ifndef RS_PLATFORM_WINDOWS
+    if (tx->pacer) {
+        if (peer_tx_pace_batch(tx, bytes) < 0) {
+            fprintf(stderr, "ERROR: Paced UDP send failed\n");
+            ret = -1;
+        }
+    } else if (udp_batch_flush(tx->batch, sock, (const struct sockaddr *)addr, addr_len) < 0) {
+        int err = rs_socket_error();
+        fprintf(stderr, "ERROR: UDP batch send failed: %s\n", rs_socket_strerror(err));
+        ret = -1;
+    } else {
+        *bytes = tx->pending_bytes;
+        uint64_t now_us = get_timestamp_us();
+        for (int i = 0; i < tx->pending_count; i++) {
+            peer_tx_record(tx, tx->pending[i]->data, now_us);
+        }
+    }
+#else
+    (void)sock;
+    (void)addr;
+    (void)addr_len;
+#endif
+
+    for (int i = 0; i < tx->pending_count; i++) {
+        bp_pool_release(tx->arena, tx->pending[i]);
+    }
+    tx->pending_count = 0;
+    tx->pending_bytes = 0;
+    return ret;
+}
+
+/*
+ * Flush the peer's queued packets and account for them
+ */
+static int peer_tx_flush(rootstream_ctx_t *ctx, peer_t *peer, peer_tx_t *tx) {
+    if (tx->pending_count == 0) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    if (peer_tx_send_batch(ctx->sock_fd, tx, &peer->addr, peer->addr_len, &bytes) < 0) {
+        transmit_failed(ctx, peer);
+        return -1;
+    }
+
+    ctx->bytes_sent += bytes;
+    peer->last_sent = get_timestamp_ms();
+    return 0;
+}
+
+/*
+ * Take a free packet slot, flushing queued packets if the arena is full
+ */
+static bp_block_t *peer_tx_acquire(rootstream_ctx_t *ctx, peer_t *peer, peer_tx_t *tx) {
+    bp_block_t *slot = bp_pool_acquire(tx->arena);
+    if (!slot && tx->pending_count > 0) {
+        if (peer_tx_flush(ctx, peer, tx) < 0) {
+            return NULL;
+        }
+        slot = bp_pool_acquire(tx->arena);
+    }
+
+    if (!slot) {
+        fprintf(stderr, "ERROR: Send arena exhausted (peer=%s)\n", peer->hostname);
+    }
+    return slot;
+}
+
+#ifndef RS_PLATFORM_WINDOWS
+/*
+ * Add a sealed slot to the next batch
+ */
+static void peer_tx_queue(peer_tx_t *tx, bp_block_t *slot, size_t len) {
+    udp_batch_add(tx->batch, slot->data, len);
+    tx->pending[tx->pending_count++] = slot;
+    tx->pending_bytes += len;
+}
+#endif
+
+/*
+ * Queue a sealed slot for the next flush (UDP), or send it now (TCP)
+ */
+static int peer_tx_submit(rootstream_ctx_t *ctx, peer_t *peer, peer_tx_t *tx, bp_block_t *slot,
+                          size_t len) {
+#ifndef RS_PLATFORM_WINDOWS
+    if (tx->batch && peer->transport == TRANSPORT_UDP) {
+        peer_tx_queue(tx, slot, len);
+        return 0;
+    }
+#endif
+
+    int ret = transmit_packet(ctx, peer, slot->data, len);
+    if (ret == 0) {
+        peer_tx_record(tx, slot->data, get_timestamp_us());
+    }
+    bp_pool_release(tx->arena, slot);
+    return ret;
+}
+
+/*
+ * Append FEC repair chunks for a frame that was just queued
+ *
+ * The frame's chunks are split into groups of at most
+ * VIDEO_FEC_GROUP_MAX (balanced, so a 112-chunk keyframe becomes two
+ * groups of 56) and each group gets percent% repair chunks, at least
+ * one.  Repairs are built straight into arena slots from the caller's
+ * frame buffer; only the short final chunk is copied, to zero-pad it.
+ */
+static int send_video_repairs(rootstream_ctx_t *ctx, peer_t *peer, peer_tx_t *tx,
+                              const uint8_t *data, size_t size, size_t stride, uint32_t frame_id,
+                              uint64_t timestamp_us, unsigned percent) {
+    size_t chunks = (size + stride - 1) / stride;
+    size_t repair_len = chunks > 1 ? stride : size;
+    size_t groups = (chunks + VIDEO_FEC_GROUP_MAX - 1) / VIDEO_FEC_GROUP_MAX;
+    size_t group_k = (chunks + groups - 1) / groups;
+    const uint8_t *sources[FEC_MAX_K];
+
+    for (size_t first = 0; first < chunks; first += group_k) {
+        int k = (int)(chunks - first < group_k ? chunks - first : group_k);
+        int r = (int)(((unsigned)k * percent + 99) / 100);
+        if (r > FEC_MAX_R) {
+            r = FEC_MAX_R;
+        }
+
+        for (int j = 0; j < k; j++) {
+            size_t offset = (first + (size_t)j) * stride;
+            sources[j] = data + offset;
+            if (size - offset < repair_len) {
+                memset(tx->fec_tail, 0, repair_len);
+                memcpy(tx->fec_tail, data + offset, size - offset);
+                sources[j] = tx->fec_tail;
+            }
+        }
+
+        for (int ri = 0; ri < r; ri++) {
+            bp_block_t *slot = peer_tx_acquire(ctx, peer, tx);
+            if (!slot) {
+                return -1;
+            }
+
+            video_chunk_header_t header = {.frame_id = frame_id,
+                                           .total_size = (uint32_t)size,
+                                           .offset = (uint32_t)(first * stride),
+                                           .chunk_size = (uint16_t)repair_len,
+                                           .flags = VIDEO_CHUNK_REPAIR,
+                                           .timestamp_us = timestamp_us};
+            video_fec_header_t fec = {.group_k = (uint8_t)k, .repair_idx = (uint8_t)ri};
+
+            uint8_t *payload = (uint8_t *)slot->data + sizeof(packet_header_t);
+            memcpy(payload, &header, sizeof(header));
+            memcpy(payload + sizeof(header), &fec, sizeof(fec));
+            fec_build_repair(sources, k, ri, payload + sizeof(header) + sizeof(fec), repair_len);
+
+            size_t packet_len = seal_packet(peer, PKT_VIDEO, slot->data,
+                                            sizeof(header) + sizeof(fec) + repair_len);
+            if (packet_len == 0) {
+                bp_pool_release(tx->arena, slot);
+                return -1;
+            }
+            if (peer_tx_submit(ctx, peer, tx, slot, packet_len) < 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/*
+ * Send an encoded video frame as a sequence of encrypted chunks
+ *
+ * Each chunk is assembled straight into a packet slot of the peer's
+ * send arena (chunk header + frame bytes) and encrypted in place.  UDP
+ * chunks are queued and leave in one batched send per frame, so a
+ * keyframe costs a handful of syscalls instead of one per chunk.  No
+ * heap allocation happens after the peer's first send.
+ *
+ * While the receiver reports loss (CTRL_SET_FEC) the frame's chunks are
+ * followed by Reed-Solomon repair chunks, see send_video_repairs().
+ *
+ * On Linux the batch goes to the pacer (network/tx_pacer.h) rather than
+ * the socket, which spreads it out at NET_PACING_GAIN × the peer's
+ * bitrate; the call returns once the frame is queued.
+ */
+int rootstream_net_send_video(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data, size_t size,
+                              uint64_t timestamp_us) {
+    if (!ctx || !peer || !data || size == 0) {
+        fprintf(stderr, "ERROR: Invalid arguments to send_video\n");
+        return -1;
+    }
+
+    if (!peer_ready_for_send(peer)) {
+        return -1;
+    }
+
+    peer_tx_t *tx = peer_tx_get(peer);
+    if (!tx) {
+        return -1;
+    }
+
+    size_t max_plain = max_plain_payload_size(peer_tx_fit(tx, peer_packet_size(peer)));
+    if (max_plain <= sizeof(video_chunk_header_t)) {
+        fprintf(stderr, "ERROR: Payload size too small for video chunks\n");
+        return -1;
+    }
+
+    /* Repair chunks carry an extra header but must match the stride */
+    unsigned fec_percent = peer->video_fec_percent;
+    size_t max_chunk = max_plain - sizeof(video_chunk_header_t);
+    if (fec_percent > 0) {
+        max_chunk -= sizeof(video_fec_header_t);
+    }
+    uint32_t frame_id = peer->video_tx_frame_id++;
+    size_t offset = 0;
+    int result = 0;
+
+#ifndef RS_PLATFORM_WINDOWS
+    int flow = net_pacer_flow(ctx, peer);
+    tx->pacer = flow >= 0 ? ctx->tx_pacer : NULL;
+    tx->pacer_flow = flow;
+#endif
+
+    while (offset < size) {
+        size_t chunk_size = size - offset;
+        if (chunk_size > max_chunk) {
+            chunk_size = max_chunk;
+        }
+
+        bp_block_t *slot = peer_tx_acquire(ctx, peer, tx);
+        if (!slot) {
+            result = -1;
+            break;
+        }
+
+        video_chunk_header_t header = {.frame_id = frame_id,
+                                       .total_size = (uint32_t)size,
+                                       .offset = (uint32_t)offset,
+                                       .chunk_size = (uint16_t)chunk_size,
+                                       .flags = 0,
+                                       .timestamp_us = timestamp_us};
+
+        uint8_t *payload = (uint8_t *)slot->data + sizeof(packet_header_t);
+        memcpy(payload, &header, sizeof(header));
+        memcpy(payload + sizeof(header), data + offset, chunk_size);
+
+        size_t packet_len = seal_packet(peer, PKT_VIDEO, slot->data, sizeof(header) + chunk_size);
+        if (packet_len == 0) {
+            bp_pool_release(tx->arena, slot);
+            result = -1;
+            break;
+        }
+
+        if (peer_tx_submit(ctx, peer, tx, slot, packet_len) < 0) {
+            result = -1;
+            break;
+        }
+
+        offset += chunk_size;
+    }
+
+    if (result == 0 && fec_percent > 0 &&
+        send_video_repairs(ctx, peer, tx, data, size, max_chunk, frame_id, timestamp_us,
+                           fec_percent) < 0) {
+        result = -1;
+    }
+
+    if (peer_tx_flush(ctx, peer, tx) < 0) {
+        result = -1;
+    }
+#ifndef RS_PLATFORM_WINDOWS
+    tx->pacer = NULL; /* Audio and control packets are not paced */
+#endif
+    return result;
+}
+
+/*
+ * Serial fallback for rootstream_net_send_video_all()
+ */
+static int send_video_serial(rootstream_ctx_t *ctx, const uint8_t *data, size_t size,
+                             uint64_t timestamp_us) {
+    int sent = 0;
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->state != PEER_CONNECTED || !peer->is_streaming) {
+            continue;
+        }
+        if (rootstream_net_send_video(ctx, peer, data, size, timestamp_us) < 0) {
+            fprintf(stderr, "ERROR: Video send failed (peer=%s)\n", peer->hostname);
+        } else {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+#ifndef RS_PLATFORM_WINDOWS
+/*
+ * Parallel video fan-out
+ *
+ * With several streaming peers the frame is prepared once on the
+ * calling thread: copied into a shared, refcounted frame, and its FEC
+ * parity computed for the highest repair level any peer asked for.
+ * Each UDP peer then gets a job on a fanout_pool lane that builds,
+ * seals and batch-sends that peer's packets on a worker thread.
+ * Ciphertext itself cannot be shared (every peer has its own key), so
+ * the per-peer work is exactly the AEAD pass and the send.
+ *
+ * Workers never touch peer_t: a job carries a copy of the session key,
+ * the address and a range of nonces reserved on the calling thread, and
+ * sends from a lane-owned arena.  Byte counts and send failures are
+ * folded back into the context and the peer on the next call.
+ *
+ * A peer whose socket cannot keep up fills only its own lane; its
+ * deltas are then dropped until the next keyframe, which is requested
+ * from the encoder.
+ */
+typedef struct net_frame_s {
+    struct net_frame_s *next; /* Free list */
+    atomic_int refs;
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    uint64_t timestamp_us;
+    size_t stride;     /* Chunk payload without FEC */
+    size_t fec_stride; /* Chunk payload when repairs follow */
+    uint8_t *repairs;  /* Parity, group-major, repair_r slots per group */
+    size_t repairs_capacity;
+    size_t repair_len;
+    size_t group_k;
+    int repair_r;
+    uint8_t fec_tail[MAX_JUMBO_PACKET_SIZE]; /* Short final chunk, zero-padded for FEC */
+} net_frame_t;
+
+typedef struct {
+    atomic_bool busy;
+    net_frame_t *frame;
+    crypto_session_t session; /* Key snapshot: the peer may rekey meanwhile */
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    uint64_t nonce; /* First of the nonces reserved for this frame */
+    uint32_t frame_id;
+    unsigned fec_percent;
+    tx_pacer_t *pacer; /* NULL: send unpaced */
+    int pacer_flow;
+} net_job_t;
+
+typedef struct {
+    bool used;
+    peer_tx_t *tx; /* Lane-owned arena and batch */
+    net_job_t jobs[NET_FANOUT_LANE_DEPTH + 2];
+    atomic_uint_fast64_t bytes_sent; /* Not yet added to ctx->bytes_sent */
+    atomic_bool failed;              /* A send failed since the last collect */
+} net_lane_t;
+
+typedef struct net_fanout_s {
+    fanout_pool_t *pool;
+    rs_socket_t sock;
+    pthread_mutex_t frames_lock;
+    net_frame_t *free_frames;
+    size_t packet_size; /* Lane arena block size */
+    net_lane_t lanes[MAX_PEERS];
+} net_fanout_t;
+
+/*
+ * Packets (chunks plus repairs) a frame costs at the given FEC level
+ */
+static size_t video_packet_count(size_t size, size_t stride, unsigned percent) {
+    size_t chunks = (size + stride - 1) / stride;
+    if (percent == 0) {
+        return chunks;
+    }
+
+    size_t groups = (chunks + VIDEO_FEC_GROUP_MAX - 1) / VIDEO_FEC_GROUP_MAX;
+    size_t group_k = (chunks + groups - 1) / groups;
+    size_t packets = chunks;
+    for (size_t first = 0; first < chunks; first += group_k) {
+        size_t k = chunks - first < group_k ? chunks - first : group_k;
+        size_t r = (k * percent + 99) / 100;
+        packets += r > FEC_MAX_R ? FEC_MAX_R : r;
+    }
+    return packets;
+}
+
+static void net_frame_unref(net_fanout_t *fo, net_frame_t *frame) {
+    if (atomic_fetch_sub(&frame->refs, 1) != 1) {
+        return;
+    }
+    pthread_mutex_lock(&fo->frames_lock);
+    frame->next = fo->free_frames;
+    fo->free_frames = frame;
+    pthread_mutex_unlock(&fo->frames_lock);
+}
+
+/*
+ * Compute the frame's FEC parity once, for the largest @percent any
+ * peer uses.  A peer at a lower level sends a prefix of each group's
+ * repairs, since repair i depends only on the group, not on r.
+ */
+static int net_frame_build_repairs(net_frame_t *f, unsigned percent) {
+    size_t stride = f->fec_stride;
+    size_t chunks = (f->size + stride - 1) / stride;
+    size_t groups = (chunks + VIDEO_FEC_GROUP_MAX - 1) / VIDEO_FEC_GROUP_MAX;
+    const uint8_t *sources[FEC_MAX_K];
+
+    f->repair_len = chunks > 1 ? stride : f->size;
+    f->group_k = (chunks + groups - 1) / groups;
+    f->repair_r = (int)((f->group_k * percent + 99) / 100);
+    if (f->repair_r > FEC_MAX_R) {
+        f->repair_r = FEC_MAX_R;
+    }
+
+    size_t need = groups * (size_t)f->repair_r * f->repair_len;
+    if (need > f->repairs_capacity) {
+        uint8_t *repairs = realloc(f->repairs, need);
+        if (!repairs) {
+            return -1;
+        }
+        f->repairs = repairs;
+        f->repairs_capacity = need;
+    }
+
+    for (size_t g = 0, first = 0; first < chunks; g++, first += f->group_k) {
+        int k = (int)(chunks - first < f->group_k ? chunks - first : f->group_k);
+        int r = (int)(((unsigned)k * percent + 99) / 100);
+        if (r > f->repair_r) {
+            r = f->repair_r;
+        }
+
+        for (int j = 0; j < k; j++) {
+            size_t offset = (first + (size_t)j) * stride;
+            sources[j] = f->data + offset;
+            if (f->size - offset < f->repair_len) {
+                memset(f->fec_tail, 0, f->repair_len);
+                memcpy(f->fec_tail, f->data + offset, f->size - offset);
+                sources[j] = f->fec_tail;
+            }
+        }
+
+        for (int ri = 0; ri < r; ri++) {
+            uint8_t *out = f->repairs + (g * (size_t)f->repair_r + (size_t)ri) * f->repair_len;
+            fec_build_repair(sources, k, ri, out, f->repair_len);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Take a frame from the free list (or allocate one) holding a copy of
+ * @data, with parity for @fec_percent
+ */
+static net_frame_t *net_frame_prepare(net_fanout_t *fo, const uint8_t *data, size_t size,
+                                      uint64_t timestamp_us, size_t stride, unsigned fec_percent) {
+    pthread_mutex_lock(&fo->frames_lock);
+    net_frame_t *f = fo->free_frames;
+    if (f) {
+        fo->free_frames = f->next;
+    }
+    pthread_mutex_unlock(&fo->frames_lock);
+
+    if (!f) {
+        f = calloc(1, sizeof(*f));
+        if (!f) {
+            return NULL;
+        }
+    }
+
+    if (size > f->capacity) {
+        uint8_t *grown = realloc(f->data, size);
+        if (!grown) {
+            free(f->data);
+            free(f->repairs);
+            free(f);
+            return NULL;
+        }
+        f->data = grown;
+        f->capacity = size;
+    }
+
+    memcpy(f->data, data, size);
+    f->size = size;
+    f->timestamp_us = timestamp_us;
+    f->stride = stride;
+    f->fec_stride = stride - sizeof(video_fec_header_t);
+    f->repair_r = 0;
+    atomic_init(&f->refs, 1);
+
+    if (fec_percent > 0 && net_frame_build_repairs(f, fec_percent) < 0) {
+        net_frame_unref(fo, f);
+        return NULL;
+    }
+    return f;
+}
+
+/*
+ * Send the lane's queued packets; worker side of peer_tx_flush()
+ */
+static int lane_flush(net_fanout_t *fo, net_lane_t *lane, const net_job_t *job) {
+    if (lane->tx->pending_count == 0) {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    if (peer_tx_send_batch(fo->sock, lane->tx, &job->addr, job->addr_len, &bytes) < 0) {
+        atomic_store(&lane->failed, true);
+        return -1;
+    }
+    atomic_fetch_add(&lane->bytes_sent, bytes);
+    return 0;
+}
+
+/*
+ * Take a free slot from the lane's arena, flushing it if full
+ */
+static bp_block_t *lane_acquire(net_fanout_t *fo, net_lane_t *lane, const net_job_t *job) {
+    bp_block_t *slot = bp_pool_acquire(lane->tx->arena);
+    if (!slot && lane_flush(fo, lane, job) == 0) {
+        slot = bp_pool_acquire(lane->tx->arena);
+    }
+    return slot;
+}
+
+/*
+ * Seal a slot with the job's next nonce and queue it on the lane
+ */
+static int lane_submit(net_lane_t *lane, net_job_t *job, bp_block_t *slot, size_t plain_len) {
+    size_t len = seal_packet_nonce(&job->session, job->nonce++, PKT_VIDEO, slot->data, plain_len);
+    if (len == 0) {
+        bp_pool_release(lane->tx->arena, slot);
+        atomic_store(&lane->failed, true);
+        return -1;
+    }
+    peer_tx_queue(lane->tx, slot, len);
+    return 0;
+}
+
+/*
+ * Worker: send one frame to one peer
+ *
+ * Same packets as rootstream_net_send_video(), built straight into the
+ * lane's arena slots; repair payloads are copied from the shared parity.
+ */
+static void net_fanout_run(void *job_ptr, int lane_index, void *user) {
+    net_fanout_t *fo = user;
+    net_job_t *job = job_ptr;
+    net_lane_t *lane = &fo->lanes[lane_index];
+    const net_frame_t *f = job->frame;
+    size_t stride = job->fec_percent > 0 ? f->fec_stride : f->stride;
+    lane->tx->pacer = job->pacer;
+    lane->tx->pacer_flow = job->pacer_flow;
+
+    for (size_t offset = 0; offset < f->size; offset += stride) {
+        size_t chunk_size = f->size - offset < stride ? f->size - offset : stride;
+        bp_block_t *slot = lane_acquire(fo, lane, job);
+        if (!slot) {
+            goto out;
+        }
+
+        video_chunk_header_t header = {.frame_id = job->frame_id,
+                                       .total_size = (uint32_t)f->size,
+                                       .offset = (uint32_t)offset,
+                                       .chunk_size = (uint16_t)chunk_size,
+                                       .flags = 0,
+                                       .timestamp_us = f->timestamp_us};
+
+        uint8_t *payload = (uint8_t *)slot->data + sizeof(packet_header_t);
+        memcpy(payload, &header, sizeof(header));
+        memcpy(payload + sizeof(header), f->data + offset, chunk_size);
+        if (lane_submit(lane, job, slot, sizeof(header) + chunk_size) < 0) {
+            goto out;
+        }
+    }
+
+    if (job->fec_percent > 0) {
+        size_t chunks = (f->size + stride - 1) / stride;
+        for (size_t g = 0, first = 0; first < chunks; g++, first += f->group_k) {
+            int k = (int)(chunks - first < f->group_k ? chunks - first : f->group_k);
+            int r = (int)(((unsigned)k * job->fec_percent + 99) / 100);
+            if (r > FEC_MAX_R) {
+                r = FEC_MAX_R;
+            }
+
+            for (int ri = 0; ri < r; ri++) {
+                bp_block_t *slot = lane_acquire(fo, lane, job);
+                if (!slot) {
+                    goto out;
+                }
+
+                video_chunk_header_t header = {.frame_id = job->frame_id,
+                                               .total_size = (uint32_t)f->size,
+                                               .offset = (uint32_t)(first * stride),
+                                               .chunk_size = (uint16_t)f->repair_len,
+                                               .flags = VIDEO_CHUNK_REPAIR,
+                                               .timestamp_us = f->timestamp_us};
+                video_fec_header_t fec = {.group_k = (uint8_t)k, .repair_idx = (uint8_t)ri};
+                const uint8_t *parity =
+                    f->repairs + (g * (size_t)f->repair_r + (size_t)ri) * f->repair_len;
+
+                uint8_t *payload = (uint8_t *)slot->data + sizeof(packet_header_t);
+                memcpy(payload, &header, sizeof(header));
+                memcpy(payload + sizeof(header), &fec, sizeof(fec));
+                memcpy(payload + sizeof(header) + sizeof(fec), parity, f->repair_len);
+                if (lane_submit(lane, job, slot, sizeof(header) + sizeof(fec) + f->repair_len) <
+                    0) {
+                    goto out;
+                }
+            }
+        }
+    }
+
+out:
+    lane_flush(fo, lane, job);
+    lane->tx->pacer = NULL;
+}
 
-#define PACKET_MAGIC 0x524F4F54 /* "ROOT" */
-#define DEFAULT_PORT 9876
-#define MAX_VIDEO_FRAME_SIZE (16 * 1024 * 1024)
-#define HANDSHAKE_RETRY_MS 1000
-#define PEER_TIMEOUT_MS 5000
-#define KEEPALIVE_INTERVAL_MS 1000
+static void net_fanout_release(void *job_ptr, void *user) {
+    net_job_t *job = job_ptr;
+    net_frame_unref(user, job->frame);
+    job->frame = NULL;
+    atomic_store(&job->busy, false);
+}
 
-/* Forward declarations */
-static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_t recv_len,
-                                   struct sockaddr_storage *from, socklen_t fromlen,
-                                   transport_type_t transport);
+static net_fanout_t *net_fanout_get(rootstream_ctx_t *ctx) {
+    if (ctx->fanout) {
+        return ctx->fanout;
+    }
 
-static peer_t *rootstream_find_peer_by_addr(rootstream_ctx_t *ctx,
-                                            const struct sockaddr_storage *addr,
-                                            socklen_t addr_len) {
-    if (!ctx || !addr) {
+    net_fanout_t *fo = calloc(1, sizeof(*fo));
+    if (!fo) {
+        return NULL;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 1 ? (int)cpus - 1 : 1;
+    if (workers > NET_FANOUT_MAX_WORKERS) {
+        workers = NET_FANOUT_MAX_WORKERS;
+    }
+
+    fo->sock = ctx->sock_fd;
+    fo->packet_size = MAX_PACKET_SIZE;
+    pthread_mutex_init(&fo->frames_lock, NULL);
+    fo->pool = fanout_pool_create(workers, NET_FANOUT_LANE_DEPTH, net_fanout_run,
+                                  net_fanout_release, fo);
+    if (!fo->pool) {
+        fprintf(stderr, "WARNING: Cannot start video send workers, sending serially\n");
+        pthread_mutex_destroy(&fo->frames_lock);
+        free(fo);
         return NULL;
     }
 
+    printf("INFO: Video fan-out on %d sender thread%s\n", workers, workers == 1 ? "" : "s");
+    ctx->fanout = fo;
+    return fo;
+}
+
+static void net_fanout_destroy(rootstream_ctx_t *ctx) {
+    net_fanout_t *fo = ctx->fanout;
+    if (!fo) {
+        return;
+    }
+
+    fanout_pool_destroy(fo->pool);
+    for (int i = 0; i < MAX_PEERS; i++) {
+        peer_tx_destroy(fo->lanes[i].tx);
+    }
+    while (fo->free_frames) {
+        net_frame_t *f = fo->free_frames;
+        fo->free_frames = f->next;
+        free(f->data);
+        free(f->repairs);
+        free(f);
+    }
+    pthread_mutex_destroy(&fo->frames_lock);
+    free(fo);
+    ctx->fanout = NULL;
+
     for (int i = 0; i < ctx->num_peers; i++) {
-        peer_t *peer = &ctx->peers[i];
-        if (peer->addr_len != addr_len) {
+        ctx->peers[i].fanout_lane = 0;
+    }
+}
+
+/*
+ * Lane serving @peer, assigned on first use; -1 if none is available
+ */
+static int net_fanout_lane(net_fanout_t *fo, peer_t *peer) {
+    if (peer->fanout_lane > 0) {
+        return peer->fanout_lane - 1;
+    }
+
+    for (int i = 0; i < MAX_PEERS; i++) {
+        net_lane_t *lane = &fo->lanes[i];
+        if (lane->used) {
             continue;
         }
+        if (!lane->tx) {
+            lane->tx = peer_tx_create(peer->hostname, fo->packet_size);
+        }
+        if (!lane->tx || !lane->tx->batch) {
+            return -1;
+        }
+        lane->used = true;
+        tfb_history_reset(lane->tx->history); /* Sends to the lane's previous peer */
+        peer_tx_set_rtx(lane->tx, (peer->protocol_flags & PROTOCOL_FLAG_NACK) != 0);
+        atomic_store(&lane->bytes_sent, 0);
+        atomic_store(&lane->failed, false);
+        peer->fanout_lane = i + 1;
+        return i;
+    }
+    return -1;
+}
 
-        if (addr->ss_family == AF_INET) {
-            const struct sockaddr_in *a = (const struct sockaddr_in *)addr;
-            const struct sockaddr_in *b = (const struct sockaddr_in *)&peer->addr;
-            if (a->sin_port == b->sin_port &&
-                memcmp(&a->sin_addr, &b->sin_addr, sizeof(a->sin_addr)) == 0) {
-                return peer;
-            }
-        } else if (addr->ss_family == AF_INET6) {
-            const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)addr;
-            const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)&peer->addr;
-            if (a->sin6_port == b->sin6_port &&
-                memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0) {
-                return peer;
+/*
+ * Grow every lane's arena to @packet_size once the queued frames are out
+ */
+static void net_fanout_fit(net_fanout_t *fo, size_t packet_size) {
+    fanout_pool_wait(fo->pool);
+    for (int i = 0; i < MAX_PEERS; i++) {
+        if (fo->lanes[i].tx) {
+            size_t fitted = peer_tx_fit(fo->lanes[i].tx, packet_size);
+            if (fitted < packet_size) {
+                packet_size = fitted;
             }
         }
     }
+    fo->packet_size = packet_size;
+}
 
-    return NULL;
+/*
+ * Give @peer's lane back, dropping frames still queued for it
+ */
+static void net_fanout_release_lane(rootstream_ctx_t *ctx, peer_t *peer) {
+    if (!ctx->fanout || peer->fanout_lane <= 0) {
+        return;
+    }
+
+    int index = peer->fanout_lane - 1;
+    fanout_pool_reset_lane(ctx->fanout->pool, index);
+    ctx->fanout->lanes[index].used = false;
+    peer->fanout_lane = 0;
 }
 
-static size_t max_plain_payload_size(void) {
-    size_t max_packet = MAX_PACKET_SIZE;
-    if (max_packet <= sizeof(packet_header_t) + crypto_aead_chacha20poly1305_IETF_ABYTES) {
-        return 0;
+/*
+ * Fold worker-side byte counts and send failures into ctx and the peers
+ */
+static void net_fanout_collect(rootstream_ctx_t *ctx) {
+    net_fanout_t *fo = ctx->fanout;
+    if (!fo) {
+        return;
+    }
+
+    uint64_t now = get_timestamp_ms();
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->fanout_lane <= 0) {
+            continue;
+        }
+
+        net_lane_t *lane = &fo->lanes[peer->fanout_lane - 1];
+        uint64_t bytes = atomic_exchange(&lane->bytes_sent, 0);
+        if (bytes > 0) {
+            ctx->bytes_sent += bytes;
+            peer->last_sent = now;
+        }
+        if (atomic_exchange(&lane->failed, false) && peer->state == PEER_CONNECTED) {
+            transmit_failed(ctx, peer);
+        }
     }
-    return max_packet - sizeof(packet_header_t) - crypto_aead_chacha20poly1305_IETF_ABYTES;
 }
 
-int rootstream_net_send_video(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data, size_t size,
-                              uint64_t timestamp_us) {
-    if (!ctx || !peer || !data || size == 0) {
-        fprintf(stderr, "ERROR: Invalid arguments to send_video\n");
+/*
+ * Hand @frame to @peer's lane; returns 0 if queued
+ */
+static int net_fanout_submit(rootstream_ctx_t *ctx, net_fanout_t *fo, peer_t *peer, int lane_index,
+                             net_frame_t *frame, bool keyframe) {
+    net_lane_t *lane = &fo->lanes[lane_index];
+    net_job_t *job = NULL;
+    for (size_t i = 0; i < sizeof(lane->jobs) / sizeof(lane->jobs[0]); i++) {
+        if (!atomic_load(&lane->jobs[i].busy)) {
+            job = &lane->jobs[i];
+            break;
+        }
+    }
+
+    /* A deep pacer queue is the same congestion as a full lane */
+    int flow = net_pacer_flow(ctx, peer);
+    bool backlogged =
+        !keyframe && flow >= 0 && tx_pacer_backlog(ctx->tx_pacer, flow) > NET_PACER_MAX_BACKLOG;
+
+    /* The frame ID is spent either way, so the receiver sees the gap */
+    uint32_t frame_id = peer->video_tx_frame_id++;
+    if (!job || backlogged) {
+        encoder_request_keyframe(&ctx->encoder);
         return -1;
     }
 
-    size_t max_plain = max_plain_payload_size();
-    if (max_plain <= sizeof(video_chunk_header_t)) {
-        fprintf(stderr, "ERROR: Payload size too small for video chunks\n");
+    unsigned fec_percent = peer->video_fec_percent;
+    size_t stride = fec_percent > 0 ? frame->fec_stride : frame->stride;
+
+    atomic_store(&job->busy, true);
+    atomic_fetch_add(&frame->refs, 1);
+    job->frame = frame;
+    job->session = peer->session;
+    job->addr = peer->addr;
+    job->addr_len = peer->addr_len;
+    job->frame_id = frame_id;
+    job->fec_percent = fec_percent;
+    job->pacer = flow >= 0 ? ctx->tx_pacer : NULL;
+    job->pacer_flow = flow;
+    job->nonce = peer->session.nonce_counter;
+    peer->session.nonce_counter += video_packet_count(frame->size, stride, fec_percent);
+
+    int rc = fanout_pool_submit(fo->pool, lane_index, job,
+                                keyframe ? FANOUT_JOB_KEY : FANOUT_JOB_DELTA);
+    if (rc != FANOUT_QUEUED) {
+        /* Congested peer: it gets nothing useful until the next keyframe */
+        if (rc < 0) {
+            net_fanout_release(job, fo);
+        }
+        encoder_request_keyframe(&ctx->encoder);
         return -1;
     }
+    return 0;
+}
+#endif /* !RS_PLATFORM_WINDOWS */
 
-    size_t max_chunk = max_plain - sizeof(video_chunk_header_t);
-    uint8_t *payload = malloc(sizeof(video_chunk_header_t) + max_chunk);
-    if (!payload) {
-        fprintf(stderr, "ERROR: Cannot allocate video payload buffer\n");
+/*
+ * Send an encoded video frame to every streaming peer
+ *
+ * With two or more UDP peers the frame is chunked and its FEC parity
+ * built once, and the per-peer encryption and sends run in parallel on
+ * sender threads (see "Parallel video fan-out" above).  The call
+ * returns once the frame is queued; rootstream_net_flush_video() waits
+ * for the wire.  Otherwise each peer is sent to in turn with
+ * rootstream_net_send_video().
+ *
+ * @param keyframe  True if @data is a keyframe; queued deltas a slow
+ *                  peer has not sent yet are superseded by it
+ * @return          Number of peers the frame was sent or queued to
+ */
+int rootstream_net_send_video_all(rootstream_ctx_t *ctx, const uint8_t *data, size_t size,
+                                  uint64_t timestamp_us, bool keyframe) {
+    if (!ctx || !data || size == 0) {
+        fprintf(stderr, "ERROR: Invalid arguments to send_video_all\n");
         return -1;
     }
 
-    uint32_t frame_id = peer->video_tx_frame_id++;
-    size_t offset = 0;
-    int result = 0;
+#ifdef RS_PLATFORM_WINDOWS
+    (void)keyframe;
+    return send_video_serial(ctx, data, size, timestamp_us);
+#else
+    net_fanout_collect(ctx);
 
-    while (offset < size) {
-        size_t chunk_size = size - offset;
-        if (chunk_size > max_chunk) {
-            chunk_size = max_chunk;
+    /* Parallel sending pays off from the second UDP peer on.  The shared
+     * frame is chunked once, for the smallest path MTU among them. */
+    int udp_peers = 0;
+    unsigned max_fec = 0;
+    size_t packet_size = MAX_JUMBO_PACKET_SIZE;
+    for (int i = 0; i < ctx->num_peers; i++) {
+        const peer_t *peer = &ctx->peers[i];
+        if (peer->state == PEER_CONNECTED && peer->is_streaming &&
+            peer->transport == TRANSPORT_UDP) {
+            udp_peers++;
+            if (peer->video_fec_percent > max_fec) {
+                max_fec = peer->video_fec_percent;
+            }
+            if (peer_packet_size(peer) < packet_size) {
+                packet_size = peer_packet_size(peer);
+            }
         }
+    }
 
-        video_chunk_header_t header = {.frame_id = frame_id,
-                                       .total_size = (uint32_t)size,
-                                       .offset = (uint32_t)offset,
-                                       .chunk_size = (uint16_t)chunk_size,
-                                       .flags = 0,
-                                       .timestamp_us = timestamp_us};
+    net_fanout_t *fo = udp_peers >= 2 ? net_fanout_get(ctx) : NULL;
+    if (fo && packet_size > fo->packet_size) {
+        net_fanout_fit(fo, packet_size);
+    }
+    if (fo && packet_size > fo->packet_size) {
+        packet_size = fo->packet_size;
+    }
 
-        memcpy(payload, &header, sizeof(header));
-        memcpy(payload + sizeof(header), data + offset, chunk_size);
+    size_t max_plain = max_plain_payload_size(packet_size);
+    if (max_plain <= sizeof(video_chunk_header_t) + sizeof(video_fec_header_t)) {
+        fprintf(stderr, "ERROR: Payload size too small for video chunks\n");
+        return -1;
+    }
 
-        if (rootstream_net_send_encrypted(ctx, peer, PKT_VIDEO, payload,
-                                          sizeof(header) + chunk_size) < 0) {
-            result = -1;
-            break;
+    net_frame_t *frame = NULL;
+    if (fo) {
+        frame = net_frame_prepare(fo, data, size, timestamp_us,
+                                  max_plain - sizeof(video_chunk_header_t), max_fec);
+    }
+    if (!frame) {
+        return send_video_serial(ctx, data, size, timestamp_us);
+    }
+
+    int sent = 0;
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->state != PEER_CONNECTED || !peer->is_streaming) {
+            continue;
         }
 
-        offset += chunk_size;
+        int lane = peer->transport == TRANSPORT_UDP ? net_fanout_lane(fo, peer) : -1;
+        if (lane < 0) {
+            /* TCP peer or no free lane: send on this thread */
+            if (rootstream_net_send_video(ctx, peer, data, size, timestamp_us) == 0) {
+                sent++;
+            }
+            continue;
+        }
+
+        if (peer_ready_for_send(peer) &&
+            net_fanout_submit(ctx, fo, peer, lane, frame, keyframe) == 0) {
+            sent++;
+        }
     }
 
-    free(payload);
-    return result;
+    net_frame_unref(fo, frame);
+    return sent;
+#endif
+}
+
+/*
+ * Wait until every queued video frame has been sent
+ */
+void rootstream_net_flush_video(rootstream_ctx_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+#ifndef RS_PLATFORM_WINDOWS
+    if (ctx->fanout) {
+        fanout_pool_wait(ctx->fanout->pool);
+        net_fanout_collect(ctx);
+    }
+#endif
 }
 
 /*
@@ -220,6 +1485,14 @@ int rootstream_net_init(rootstream_ctx_t *ctx, uint16_t port) {
     rs_socket_setopt(ctx->sock_fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
 #endif
 
+#if defined(IP_MTU_DISCOVER) && !defined(RS_PLATFORM_WINDOWS)
+    /* Path MTU probes need DF without kernel fragmentation; only they get
+     * it (send_pmtu_probe()), everything else keeps the system default */
+    socklen_t pmtudisc_len = sizeof(ctx->udp_pmtudisc);
+    ctx->udp_probe_mtu = getsockopt(ctx->sock_fd, IPPROTO_IP, IP_MTU_DISCOVER,
+                                    &ctx->udp_pmtudisc, &pmtudisc_len) == 0;
+#endif
+
     /* Bind to address */
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
@@ -251,10 +1524,11 @@ int rootstream_net_init(rootstream_ctx_t *ctx, uint16_t port) {
  * @return     0 on success, -1 on error
  *
  * Process:
- * 1. Encrypt payload with session key
- * 2. Build packet header
- * 3. Send via UDP
- * 4. Update statistics
+ * 1. Copy payload into a slot of the peer's send arena
+ * 2. Encrypt in place with session key
+ * 3. Build packet header
+ * 4. Send via UDP/TCP
+ * 5. Update statistics
  */
 int rootstream_net_send_encrypted(rootstream_ctx_t *ctx, peer_t *peer, uint8_t type,
                                   const void *data, size_t size) {
@@ -263,105 +1537,206 @@ int rootstream_net_send_encrypted(rootstream_ctx_t *ctx, peer_t *peer, uint8_t t
         return -1;
     }
 
-    /* Check connection health */
-    if (peer->state != PEER_CONNECTED && peer->state != PEER_HANDSHAKE_RECEIVED) {
-        fprintf(stderr, "WARNING: Peer not fully connected, skipping send\n");
-        return -1;
-    }
-
-    if (!peer->session.authenticated) {
-        fprintf(stderr, "ERROR: Cannot send - peer not authenticated\n");
-        fprintf(stderr, "PEER: %s\n", peer->hostname);
-        fprintf(stderr, "FIX: Complete handshake first\n");
+    if (!peer_ready_for_send(peer)) {
         return -1;
     }
 
-    size_t max_plain = max_plain_payload_size();
+    size_t max_plain = max_plain_payload_size(MAX_PACKET_SIZE);
     if (size > max_plain) {
         fprintf(stderr, "ERROR: Payload too large for single packet (%zu > %zu)\n", size,
                 max_plain);
         return -1;
     }
 
-    /* Allocate packet buffer */
-    size_t max_cipher_len = size + crypto_aead_chacha20poly1305_IETF_ABYTES;
-    size_t packet_len = sizeof(packet_header_t) + max_cipher_len;
-    uint8_t *packet = malloc(packet_len);
-    if (!packet) {
-        fprintf(stderr, "ERROR: Cannot allocate packet buffer\n");
+    /* Borrow a packet slot from the peer's send arena */
+    peer_tx_t *tx = peer_tx_get(peer);
+    bp_block_t *slot = tx ? peer_tx_acquire(ctx, peer, tx) : NULL;
+    if (!slot) {
         return -1;
     }
 
-    packet_header_t *hdr = (packet_header_t *)packet;
-    uint8_t *payload = packet + sizeof(packet_header_t);
+    uint8_t *packet = slot->data;
+    if (size > 0) {
+        memcpy(packet + sizeof(packet_header_t), data, size);
+    }
 
-    /* Get nonce (monotonically increasing counter) */
-    uint64_t nonce = peer->session.nonce_counter++;
+    size_t packet_len = seal_packet(peer, type, packet, size);
+    if (packet_len == 0) {
+        bp_pool_release(tx->arena, slot);
+        return -1;
+    }
 
-    /* Encrypt payload */
-    size_t cipher_len = 0;
-    if (crypto_encrypt_packet(&peer->session, data, size, payload, &cipher_len, nonce) < 0) {
-        free(packet);
-        fprintf(stderr, "ERROR: Encryption failed\n");
+    if (peer_tx_submit(ctx, peer, tx, slot, packet_len) < 0) {
         return -1;
     }
+    return peer_tx_flush(ctx, peer, tx);
+}
 
-    /* Build header */
-    hdr->magic = PACKET_MAGIC;
-    hdr->version = PROTOCOL_VERSION;
-    hdr->type = type;
-    hdr->flags = 0;
-    hdr->nonce = nonce;
-    hdr->payload_size = cipher_len;
-    /* MAC is included in cipher_len by crypto_encrypt_packet */
+/*
+ * Hand the next reassembled video frame to ctx->current_frame
+ *
+ * ctx->current_frame borrows the reassembler's buffer (no copy); the
+ * consumer sets its size to 0 once decoded, which lets the next frame
+ * through.  Handing out one frame at a time keeps frames that complete
+ * in the same receive batch in order instead of overwriting each other.
+ *
+ * @return true if a frame is waiting in ctx->current_frame
+ */
+static bool deliver_video_frame(rootstream_ctx_t *ctx) {
+    if (ctx->current_frame.data && ctx->current_frame.size > 0) {
+        return true;
+    }
 
-    /* Dispatch to transport */
-    int ret = -1;
-    switch (peer->transport) {
-        case TRANSPORT_UDP:
-            ret = rs_socket_sendto(ctx->sock_fd, packet, sizeof(packet_header_t) + cipher_len, 0,
-                                   (struct sockaddr *)&peer->addr, peer->addr_len);
-            if (ret < 0) {
-                int err = rs_socket_error();
-                fprintf(stderr, "ERROR: UDP send failed: %s\n", rs_socket_strerror(err));
-            } else {
-                ctx->bytes_sent += ret;
-                peer->last_sent = get_timestamp_ms();
-                ret = 0; /* Success */
+    uint64_t now = get_timestamp_ms();
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        frame_reasm_frame_t frame;
+
+        if (!peer->video_rx || !frame_reasm_pop(peer->video_rx, now, &frame)) {
+            continue;
+        }
+
+        ctx->current_frame.data = (uint8_t *)frame.data;
+        ctx->current_frame.size = (uint32_t)frame.size;
+        ctx->current_frame.capacity = (uint32_t)frame.size;
+        ctx->current_frame.timestamp = frame.timestamp_us;
+        ctx->last_video_ts_us = frame.timestamp_us;
+        ctx->frames_received++;
+
+        /* Later frames reference what was lost; restart the GOP, but do
+         * not flood the host while a burst of loss is still in progress */
+        if (frame.after_gap && now - peer->video_rx_keyframe_req >= VIDEO_KEYFRAME_REQUEST_MS) {
+            peer->video_rx_keyframe_req = now;
+            rootstream_request_keyframe(ctx, peer);
+        }
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Drain the UDP socket
+ *
+ * Blocks up to timeout_ms for the socket to become readable, then reads
+ * up to NET_RX_MAX_BATCHES batches of NET_RX_BATCH datagrams (one
+ * recvmmsg each) and dispatches every datagram straight into
+ * process_received_packet().  The batch cap keeps a flood from starving
+ * the caller; whatever is left is picked up on the next call.
+ */
+static int net_recv_udp(rootstream_ctx_t *ctx, int timeout_ms) {
+#ifndef RS_PLATFORM_WINDOWS
+    if (!ctx->udp_rx) {
+        ctx->udp_rx = udp_rx_create(ctx->sock_fd, NET_RX_BATCH, MAX_JUMBO_PACKET_SIZE);
+        if (!ctx->udp_rx) {
+            fprintf(stderr, "ERROR: Cannot allocate UDP receive buffers\n");
+            return -1;
+        }
+    }
+
+    int ret = udp_rx_wait(ctx->udp_rx, timeout_ms);
+    if (ret < 0) {
+        int err = rs_socket_error();
+        fprintf(stderr, "ERROR: Poll failed: %s\n", rs_socket_strerror(err));
+        return -1;
+    }
+    if (ret == 0) {
+        return 0;
+    }
+
+    for (int b = 0; b < NET_RX_MAX_BATCHES; b++) {
+        int n = udp_rx_recv(ctx->udp_rx);
+        if (n < 0) {
+            int err = rs_socket_error();
+            fprintf(stderr, "ERROR: UDP receive failed: %s\n", rs_socket_strerror(err));
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            udp_rx_packet_t *pkt = udp_rx_packet(ctx->udp_rx, i);
+            if (pkt->len >= sizeof(packet_header_t) &&
+                rootstream_net_validate_packet(pkt->data, pkt->len) == 0) {
+                process_received_packet(ctx, pkt->data, pkt->len, &pkt->from, pkt->fromlen,
+                                        TRANSPORT_UDP, pkt->rx_time_us);
             }
-            break;
+        }
+
+        if (n < udp_rx_batch_size(ctx->udp_rx)) {
+            break; /* Socket drained */
+        }
+    }
+    return 0;
+#else
+    /* Poll UDP socket for incoming data */
+    int ret = rs_socket_poll(ctx->sock_fd, timeout_ms);
+    if (ret < 0) {
+        int err = rs_socket_error();
+        fprintf(stderr, "ERROR: Poll failed: %s\n", rs_socket_strerror(err));
+        return -1;
+    }
+
+    if (ret > 0) {
+        /* Receive UDP packet */
+        uint8_t buffer[MAX_JUMBO_PACKET_SIZE];
+        struct sockaddr_storage from;
+        socklen_t fromlen = sizeof(from);
 
-        case TRANSPORT_TCP:
-            ret = rootstream_net_tcp_send(ctx, peer, packet, sizeof(packet_header_t) + cipher_len);
-            break;
+        int recv_len = rs_socket_recvfrom(ctx->sock_fd, buffer, sizeof(buffer), 0,
+                                          (struct sockaddr *)&from, &fromlen);
 
-        default:
-            fprintf(stderr, "ERROR: Unknown transport type %d\n", peer->transport);
-            ret = -1;
+        if (recv_len >= (int)sizeof(packet_header_t)) {
+            if (rootstream_net_validate_packet(buffer, (size_t)recv_len) == 0) {
+                process_received_packet(ctx, buffer, recv_len, &from, fromlen, TRANSPORT_UDP, 0);
+            }
+        }
     }
+    return 0;
+#endif
+}
 
-    free(packet);
+/*
+ * Wait up to timeout_ms for the UDP socket or any connected TCP peer
+ *
+ * TCP peers are read without blocking, so with one connected the UDP
+ * wait alone would either miss TCP traffic or (non-blocking) spin.
+ * Waiting on every socket at once keeps the caller's timeout.
+ */
+static void net_wait_any(rootstream_ctx_t *ctx, int timeout_ms) {
+#ifndef RS_PLATFORM_WINDOWS
+    struct pollfd fds[MAX_PEERS + 1];
+    nfds_t n = 0;
 
-    if (ret < 0) {
-        /* Transport failed, mark for reconnection */
-        fprintf(stderr, "WARNING: Send failed, marking peer for reconnection\n");
-        peer->state = PEER_DISCONNECTED;
-        if (peer->reconnect_ctx) {
-            peer_try_reconnect(ctx, peer);
+    fds[n].fd = ctx->sock_fd;
+    fds[n].events = POLLIN;
+    n++;
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->transport != TRANSPORT_TCP || peer->state != PEER_CONNECTED) {
+            continue;
+        }
+        rs_socket_t fd = rootstream_net_tcp_socket(peer);
+        if (fd != RS_INVALID_SOCKET) {
+            fds[n].fd = fd;
+            fds[n].events = POLLIN;
+            n++;
         }
-        return -1;
     }
-
-    return 0;
+    poll(fds, n, timeout_ms); /* Errors surface on the reads that follow */
+#else
+    (void)ctx;
+    (void)timeout_ms;
+#endif
 }
 
 /*
  * Receive and process incoming packets
  *
  * @param ctx        RootStream context
- * @param timeout_ms Timeout in milliseconds (0 = non-blocking)
+ * @param timeout_ms Maximum time to wait for data (0 = non-blocking)
  * @return           0 on success, -1 on error
  *
+ * While a TCP peer is connected the wait covers its socket as well as the
+ * UDP socket; both are then drained without blocking.
+ *
  * Handles:
  * - Handshake packets (key exchange)
  * - Video frames
@@ -375,9 +1750,8 @@ int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
         return -1;
     }
 
-    (void)timeout_ms; /* Reserved for future use */
-
     /* First, check for reconnecting peers (iterate backwards to handle removal safely) */
+    bool tcp_active = false;
     for (int i = ctx->num_peers - 1; i >= 0; i--) {
         peer_t *peer = &ctx->peers[i];
 
@@ -391,31 +1765,21 @@ int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
                 continue;
             }
         }
-    }
 
-    /* Poll UDP socket for incoming data */
-    int ret = rs_socket_poll(ctx->sock_fd, 0); /* Non-blocking check */
-    if (ret < 0) {
-        int err = rs_socket_error();
-        fprintf(stderr, "ERROR: Poll failed: %s\n", rs_socket_strerror(err));
-        return -1;
+        if (peer->transport == TRANSPORT_TCP && peer->state == PEER_CONNECTED) {
+            tcp_active = true;
+        }
     }
 
-    if (ret > 0) {
-        /* Receive UDP packet */
-        uint8_t buffer[MAX_PACKET_SIZE];
-        struct sockaddr_storage from;
-        socklen_t fromlen = sizeof(from);
+    /* Do not block while a reassembled frame is waiting for the consumer */
+    bool frame_ready = deliver_video_frame(ctx);
 
-        int recv_len = rs_socket_recvfrom(ctx->sock_fd, buffer, sizeof(buffer), 0,
-                                          (struct sockaddr *)&from, &fromlen);
+    if (tcp_active && !frame_ready && timeout_ms != 0) {
+        net_wait_any(ctx, timeout_ms);
+    }
 
-        if (recv_len >= (int)sizeof(packet_header_t)) {
-            if (rootstream_net_validate_packet(buffer, (size_t)recv_len) == 0) {
-                /* Process UDP packet (existing logic) */
-                process_received_packet(ctx, buffer, recv_len, &from, fromlen, TRANSPORT_UDP);
-            }
-        }
+    if (net_recv_udp(ctx, (tcp_active || frame_ready) ? 0 : timeout_ms) < 0) {
+        return -1;
     }
 
     /* Check TCP peers for data */
@@ -426,37 +1790,420 @@ int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
             continue;
         }
 
-        uint8_t buffer[MAX_PACKET_SIZE];
-        size_t buffer_len = 0;
+        /* Drain what has arrived, so nothing sits buffered during the next wait */
+        for (int p = 0; p < NET_TCP_MAX_PACKETS; p++) {
+            uint8_t buffer[MAX_PACKET_SIZE];
+            size_t buffer_len = 0;
 
-        int tcp_ret = rootstream_net_tcp_recv(ctx, peer, buffer, &buffer_len);
+            int tcp_ret = rootstream_net_tcp_recv(ctx, peer, buffer, &buffer_len);
 
-        if (tcp_ret < 0) {
-            /* TCP receive failed, disconnect and mark for reconnect */
-            fprintf(stderr, "WARNING: TCP receive failed for peer %s\n", peer->hostname);
-            peer->state = PEER_DISCONNECTED;
-            if (peer->reconnect_ctx) {
-                peer_try_reconnect(ctx, peer);
+            if (tcp_ret < 0) {
+                /* TCP receive failed, disconnect and mark for reconnect */
+                fprintf(stderr, "WARNING: TCP receive failed for peer %s\n", peer->hostname);
+                peer->state = PEER_DISCONNECTED;
+                if (peer->reconnect_ctx) {
+                    peer_try_reconnect(ctx, peer);
+                }
+                break;
+            }
+
+            if (tcp_ret == 0 || buffer_len == 0) {
+                break;
             }
-            continue;
-        }
 
-        if (tcp_ret > 0 && buffer_len > 0) {
             /* Process TCP packet */
             process_received_packet(ctx, buffer, buffer_len, &peer->addr, peer->addr_len,
-                                    TRANSPORT_TCP);
+                                    TRANSPORT_TCP, 0);
+            if (peer->transport != TRANSPORT_TCP || peer->state != PEER_CONNECTED) {
+                break; /* Disconnected (or removed) by that packet */
+            }
+        }
+    }
+
+    /* Ask for lost chunks while the frames can still be completed */
+    for (int i = 0; i < ctx->num_peers; i++) {
+        peer_t *peer = &ctx->peers[i];
+        if (peer->rx_nack && peer->video_rx && peer->transport == TRANSPORT_UDP &&
+            peer->state == PEER_CONNECTED) {
+            send_video_nacks(ctx, peer);
         }
     }
 
+    deliver_video_frame(ctx);
     return 0;
 }
 
+/*
+ * Release receive state and close the UDP socket
+ */
+void rootstream_net_cleanup(rootstream_ctx_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+
+#ifndef RS_PLATFORM_WINDOWS
+    net_fanout_destroy(ctx);
+    tx_pacer_destroy(ctx->tx_pacer); /* After the workers, which enqueue to it */
+    ctx->tx_pacer = NULL;
+    udp_rx_destroy(ctx->udp_rx);
+    ctx->udp_rx = NULL;
+#endif
+
+    if (ctx->sock_fd != RS_INVALID_SOCKET) {
+        rs_socket_close(ctx->sock_fd);
+        ctx->sock_fd = RS_INVALID_SOCKET;
+    }
+}
+
+/*
+ * Transport feedback and congestion control
+ *
+ * A client whose host advertises PROTOCOL_FLAG_TRANSPORT_FEEDBACK
+ * records when each authenticated UDP packet arrived (by nonce) and
+ * reports back every NET_FEEDBACK_INTERVAL_MS.  The host joins the
+ * reports with its send history and runs one delay controller per peer;
+ * the encoder bitrate follows the lowest target among streaming peers,
+ * between NET_CC_MIN_BITRATE and encoder.max_bitrate.
+ */
+
+/* Wall-clock time (µs), the clock of kernel receive timestamps */
+static uint64_t net_realtime_us(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/*
+ * Send state of the fan-out lane serving @peer, NULL if none
+ */
+static peer_tx_t *peer_lane_tx(const rootstream_ctx_t *ctx, const peer_t *peer) {
+#ifndef RS_PLATFORM_WINDOWS
+    if (ctx->fanout && peer->fanout_lane > 0) {
+        return ctx->fanout->lanes[peer->fanout_lane - 1].tx;
+    }
+#else
+    (void)ctx;
+    (void)peer;
+#endif
+    return NULL;
+}
+
+/*
+ * Start transport feedback and retransmission afresh for a new session
+ *
+ * The sender restarts its nonces with every session, so arrivals, send
+ * times and cached packets recorded under the old one no longer match.
+ */
+static void peer_session_reset(rootstream_ctx_t *ctx, peer_t *peer) {
+    bool report = !ctx->is_host && (peer->protocol_flags & PROTOCOL_FLAG_TRANSPORT_FEEDBACK);
+    if (report && !peer->rx_feedback) {
+        peer->rx_feedback = tfb_recorder_create();
+    } else if (!report) {
+        tfb_recorder_destroy(peer->rx_feedback);
+        peer->rx_feedback = NULL;
+    }
+    tfb_recorder_reset(peer->rx_feedback);
+
+    bool nack = (peer->protocol_flags & PROTOCOL_FLAG_NACK) != 0;
+    if (!ctx->is_host && nack && !peer->rx_nack) {
+        peer->rx_nack = nack_tracker_create(0);
+    } else if (ctx->is_host || !nack) {
+        nack_tracker_destroy(peer->rx_nack);
+        peer->rx_nack = NULL;
+    }
+    nack_tracker_reset(peer->rx_nack);
+    if (!peer->rx_nack) {
+        frame_reasm_set_reorder(peer->video_rx, 0); /* No retransmissions to wait for */
+    }
+
+    peer_tx_t *tx = ctx->is_host && nack ? peer_tx_get(peer) : peer->tx;
+    if (tx) {
+        tfb_history_reset(tx->history);
+        peer_tx_set_rtx(tx, ctx->is_host && nack);
+    }
+    /* The lane may be sending: its cache is only emptied here, it is
+     * created or dropped when the lane is next assigned */
+    peer_tx_t *lane_tx = peer_lane_tx(ctx, peer);
+    if (lane_tx) {
+        tfb_history_reset(lane_tx->history);
+        nack_cache_reset(lane_tx->rtx);
+    }
+    delay_controller_reset(peer->tx_cc);
+
+    /* The path may have changed with the address: search it again */
+    bool probe = ctx->is_host && ctx->udp_probe_mtu && peer->transport == TRANSPORT_UDP &&
+                 (peer->protocol_flags & PROTOCOL_FLAG_PLPMTUD);
+    if (probe && !peer->tx_pmtu) {
+        peer->tx_pmtu = plpmtud_create(PLPMTUD_MIN_SIZE, MAX_JUMBO_PACKET_SIZE);
+    } else if (!probe) {
+        plpmtud_destroy(peer->tx_pmtu);
+        peer->tx_pmtu = NULL;
+    }
+    plpmtud_reset(peer->tx_pmtu);
+
+    /* The new session numbers its input batches from scratch */
+    rootstream_input_forget_peer(ctx, peer);
+}
+
+/*
+ * Bitrate ceiling for congestion control, fixed on first use
+ */
+static uint32_t net_cc_ceiling(rootstream_ctx_t *ctx) {
+    uint32_t ceiling = encoder_get_max_bitrate(&ctx->encoder);
+    if (ceiling == 0) {
+        uint32_t bitrate = encoder_get_bitrate(&ctx->encoder);
+        ceiling = bitrate > 0 ? bitrate : ctx->settings.video_bitrate;
+        encoder_set_max_bitrate(&ctx->encoder, ceiling);
+    }
+    return ceiling;
+}
+
+/*
+ * Point the encoder at the lowest target among streaming peers
+ *
+ * With no controlled peer left it returns to the ceiling.
+ */
+static void net_cc_apply(rootstream_ctx_t *ctx) {
+    uint32_t target = 0;
+    for (int i = 0; i < ctx->num_peers; i++) {
+        const peer_t *peer = &ctx->peers[i];
+        if (!peer->tx_cc || peer->state != PEER_CONNECTED || !peer->is_streaming) {
+            continue;
+        }
+        uint32_t t = delay_controller_target_bps(peer->tx_cc);
+        if (target == 0 || t < target) {
+            target = t;
+        }
+    }
+
+    if (target == 0) {
+        target = encoder_get_max_bitrate(&ctx->encoder);
+    }
+    if (target > 0) {
+        encoder_set_bitrate(&ctx->encoder, target);
+    }
+}
+
+/*
+ * Report settled arrivals to the sender
+ *
+ * A backlog (after a stall) goes out as several payloads at once.
+ */
+static void send_transport_feedback(rootstream_ctx_t *ctx, peer_t *peer, uint64_t now) {
+    if (now - peer->rx_feedback_sent < NET_FEEDBACK_INTERVAL_MS) {
+        return;
+    }
+    peer->rx_feedback_sent = now;
+
+    uint8_t payload[MAX_PACKET_SIZE];
+    uint64_t now_us = net_realtime_us();
+    size_t len;
+    while ((len = tfb_recorder_build(peer->rx_feedback, now_us, payload,
+                                     max_plain_payload_size(MAX_PACKET_SIZE))) > 0) {
+        if (rootstream_net_send_encrypted(ctx, peer, PKT_FEEDBACK, payload, len) < 0) {
+            break;
+        }
+    }
+}
+
+/*
+ * Feed one report into the peer's controller and retarget the encoder
+ *
+ * Packets the send histories no longer hold (or never did, such as
+ * keepalives) are left out.
+ */
+static void handle_transport_feedback(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data,
+                                      size_t len) {
+    tfb_packet_t pkts[TFB_MAX_PACKETS];
+    int n = tfb_parse(data, len, pkts, TFB_MAX_PACKETS);
+    if (n < 0) {
+        fprintf(stderr, "WARNING: Malformed transport feedback from peer %s\n", peer->hostname);
+        return;
+    }
+
+    const peer_tx_t *lane_tx = peer_lane_tx(ctx, peer);
+    const tfb_history_t *history = peer->tx ? peer->tx->history : NULL;
+    const tfb_history_t *lane_history = lane_tx ? lane_tx->history : NULL;
+    int known = 0;
+    for (int i = 0; i < n; i++) {
+        tfb_packet_t *p = &pkts[i];
+        if (tfb_history_lookup(history, p->seq, &p->send_us, &p->size) ||
+            tfb_history_lookup(lane_history, p->seq, &p->send_us, &p->size)) {
+            pkts[known++] = *p;
+        }
+    }
+    if (known == 0) {
+        return;
+    }
+
+    if (!peer->tx_cc) {
+        uint32_t ceiling = net_cc_ceiling(ctx);
+        if (ceiling == 0) {
+            return;
+        }
+        uint32_t bitrate = encoder_get_bitrate(&ctx->encoder);
+        delay_controller_config_t config = {
+            .min_bps = ceiling < NET_CC_MIN_BITRATE ? ceiling : NET_CC_MIN_BITRATE,
+            .max_bps = ceiling,
+            .start_bps = bitrate > 0 ? bitrate : ceiling};
+        peer->tx_cc = delay_controller_create(&config);
+        if (!peer->tx_cc) {
+            fprintf(stderr, "ERROR: Cannot allocate congestion controller (peer=%s)\n",
+                    peer->hostname);
+            return;
+        }
+    }
+
+    delay_controller_on_feedback(peer->tx_cc, pkts, known, get_timestamp_us());
+    net_cc_apply(ctx);
+}
+
+/*
+ * Selective retransmission (network/nack.h)
+ *
+ * When both ends advertise PROTOCOL_FLAG_NACK, the client reports video
+ * chunks lost on UDP with PKT_NACK and holds incomplete frames for about
+ * a round trip.  The host answers from the resend caches of the peer and
+ * of its fan-out lane with the packets exactly as first sealed, flagged
+ * PKT_FLAG_RETRANSMIT so they stay out of transport feedback.
+ */
+
+/*
+ * Request the video chunks that are due for a NACK
+ */
+static void send_video_nacks(rootstream_ctx_t *ctx, peer_t *peer) {
+    uint8_t payload[NACK_MAX_PAYLOAD];
+    size_t len = nack_tracker_poll(peer->rx_nack, peer->video_rx, get_timestamp_us(), payload,
+                                   sizeof(payload));
+    if (len > 0) {
+        rootstream_net_send_encrypted(ctx, peer, PKT_NACK, payload, len);
+    }
+    frame_reasm_set_reorder(peer->video_rx, nack_tracker_hold_ms(peer->rx_nack));
+}
+
+/*
+ * Resend the video packets a receiver reports lost
+ */
+static void handle_nack(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data, size_t len) {
+    uint64_t nonces[NACK_MAX_NONCES];
+    int n = nack_decode(data, len, nonces, NACK_MAX_NONCES);
+    if (n < 0) {
+        fprintf(stderr, "WARNING: Malformed NACK from peer %s\n", peer->hostname);
+        return;
+    }
+
+    peer_tx_t *tx = peer_tx_get(peer);
+    if (!tx) {
+        return;
+    }
+    size_t cap = peer_tx_fit(tx, peer_packet_size(peer));
+    peer_tx_t *lane_tx = peer_lane_tx(ctx, peer);
+    for (int i = 0; i < n; i++) {
+        bp_block_t *slot = peer_tx_acquire(ctx, peer, tx);
+        if (!slot) {
+            return;
+        }
+        size_t packet_len = nack_cache_fetch(tx->rtx, nonces[i], slot->data, cap);
+        if (packet_len == 0 && lane_tx) {
+            packet_len = nack_cache_fetch(lane_tx->rtx, nonces[i], slot->data, cap);
+        }
+        if (packet_len == 0) {
+            bp_pool_release(tx->arena, slot);
+            continue; /* Gone from the cache, or resent often enough */
+        }
+
+        ((packet_header_t *)slot->data)->flags |= PKT_FLAG_RETRANSMIT;
+        if (peer_tx_submit(ctx, peer, tx, slot, packet_len) < 0) {
+            return;
+        }
+    }
+    peer_tx_flush(ctx, peer, tx);
+}
+
+/*
+ * Send @peer the path MTU probe that is due, if any
+ *
+ * Probes bypass the send arena (they are larger than its slots until
+ * the search settles) and are neither paced nor cached for resending.
+ */
+static void send_pmtu_probe(rootstream_ctx_t *ctx, peer_t *peer) {
+#ifndef RS_PLATFORM_WINDOWS
+    uint64_t now_us = get_timestamp_us();
+    uint32_t id;
+    size_t size = plpmtud_poll(peer->tx_pmtu, now_us, &id);
+    size_t plain_len = max_plain_payload_size(size);
+    if (plain_len < PLPMTUD_PROBE_HEADER) {
+        return;
+    }
+
+    uint8_t packet[MAX_JUMBO_PACKET_SIZE];
+    plpmtud_encode(PLPMTUD_KIND_PROBE, id, (uint16_t)size, packet + sizeof(packet_header_t),
+                   plain_len);
+    size_t len = seal_packet(peer, PKT_PROBE, packet, plain_len);
+    if (len == 0) {
+        return;
+    }
+
+    /* DF and no fragmentation for this datagram only: a probe the kernel
+     * split would be answered for a size the path cannot carry.  A send
+     * from another thread in between goes out the same way; at worst it
+     * is lost instead of fragmented, and NACK recovers it. */
+#ifdef IP_MTU_DISCOVER
+    int pmtudisc = IP_PMTUDISC_PROBE;
+    rs_socket_setopt(ctx->sock_fd, IPPROTO_IP, IP_MTU_DISCOVER, &pmtudisc, sizeof(pmtudisc));
+#endif
+    int sent = rs_socket_sendto(ctx->sock_fd, packet, len, 0, (struct sockaddr *)&peer->addr,
+                                peer->addr_len);
+    int err = sent < 0 ? rs_socket_error() : 0;
+#ifdef IP_MTU_DISCOVER
+    rs_socket_setopt(ctx->sock_fd, IPPROTO_IP, IP_MTU_DISCOVER, &ctx->udp_pmtudisc,
+                     sizeof(ctx->udp_pmtudisc));
+#endif
+
+    if (sent < 0) {
+        if (err == EMSGSIZE) {
+            plpmtud_on_too_big(peer->tx_pmtu, now_us);
+        }
+        return;
+    }
+    ctx->bytes_sent += len;
+#else
+    (void)ctx;
+    (void)peer;
+#endif
+}
+
+/*
+ * Answer a path MTU probe, or take the answer to one of ours
+ */
+static void handle_pmtu_probe(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data,
+                              size_t len) {
+    uint8_t kind;
+    uint32_t id;
+    uint16_t size;
+    if (plpmtud_decode(data, len, &kind, &id, &size) < 0) {
+        fprintf(stderr, "WARNING: Malformed path MTU probe from peer %s\n", peer->hostname);
+        return;
+    }
+
+    if (kind == PLPMTUD_KIND_PROBE) {
+        uint8_t ack[PLPMTUD_PROBE_HEADER];
+        plpmtud_encode(PLPMTUD_KIND_ACK, id, size, ack, sizeof(ack));
+        rootstream_net_send_encrypted(ctx, peer, PKT_PROBE, ack, sizeof(ack));
+    } else if (plpmtud_on_ack(peer->tx_pmtu, id, get_timestamp_us())) {
+        printf("INFO: Path MTU to %s: %zu bytes\n", peer->hostname,
+               plpmtud_size(peer->tx_pmtu));
+    }
+}
+
 /*
  * Process a received packet (helper for both UDP and TCP)
+ *
+ * @param arrival_us  Kernel receive time (wall clock), 0 if unknown
  */
 static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_t recv_len,
                                    struct sockaddr_storage *from, socklen_t fromlen,
-                                   transport_type_t transport) {
+                                   transport_type_t transport, uint64_t arrival_us) {
     packet_header_t *hdr = (packet_header_t *)buffer;
 
     /* Find or create peer */
@@ -478,11 +2225,7 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
         peer->state = PEER_CONNECTING;
         peer->transport = transport; /* Set transport type */
         peer->video_tx_frame_id = 1;
-        peer->video_rx_frame_id = 0;
-        peer->video_rx_buffer = NULL;
-        peer->video_rx_capacity = 0;
-        peer->video_rx_expected = 0;
-        peer->video_rx_received = 0;
+        peer->video_rx = NULL;
     }
 
     /* Update last seen and received time */
@@ -540,6 +2283,45 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
                 return 0;
             }
 
+            /* Session nonce + echo of ours (zero in a hello) after the flags */
+            const uint8_t *peer_nonce = NULL;
+            const uint8_t *echo = NULL;
+            if (peer_flags & PROTOCOL_FLAG_SESSION_NONCE) {
+                size_t nonce_offset = extensions_offset + 2;
+                if (hdr->payload_size < nonce_offset + 2 * CRYPTO_SESSION_NONCE_BYTES) {
+                    fprintf(stderr, "ERROR: Handshake session nonce missing\n");
+                    return 0;
+                }
+                peer_nonce = payload + nonce_offset;
+                echo = peer_nonce + CRYPTO_SESSION_NONCE_BYTES;
+            }
+
+            /* Handshakes travel in the clear and can be replayed.  Only one
+             * carrying nonces we have not keyed with yet starts a session:
+             * the same key would otherwise restart both nonce counters and
+             * reopen the replay window to every packet captured under it. */
+            bool salted = peer->session.authenticated && peer->state == PEER_CONNECTED &&
+                          (peer->protocol_flags & PROTOCOL_FLAG_SESSION_NONCE);
+            bool current =
+                salted && peer_nonce &&
+                memcmp(peer_nonce, peer->hs_peer_nonce, CRYPTO_SESSION_NONCE_BYTES) == 0;
+            bool reply = echo && !sodium_is_zero(echo, CRYPTO_SESSION_NONCE_BYTES);
+
+            if (salted && !peer_nonce) {
+                fprintf(stderr, "WARNING: Ignoring unsalted handshake on a salted session\n");
+                return 0;
+            }
+            if (reply && memcmp(echo, peer->hs_nonce, CRYPTO_SESSION_NONCE_BYTES) != 0) {
+                return 0; /* Answers a hello we no longer wait for */
+            }
+            if (current) {
+                /* Retransmitted hello: our reply was lost, send it again */
+                if (!reply) {
+                    send_handshake(ctx, peer, peer_nonce);
+                }
+                return 0;
+            }
+
             printf("✓ Received handshake from %s\n", peer_hostname[0] ? peer_hostname : "unknown");
 
             /* Store peer information */
@@ -550,19 +2332,36 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
             peer->protocol_version = peer_version;
             peer->protocol_flags = peer_flags;
 
+            /* A hello gets a fresh nonce of ours, unless it crossed our own
+             * hello (simultaneous open), whose nonce the peer will echo */
+            if (peer_nonce && !reply && peer->state != PEER_HANDSHAKE_SENT) {
+                randombytes_buf(peer->hs_nonce, sizeof(peer->hs_nonce));
+            }
+
             /* Create encryption session (derive shared secret) */
-            if (crypto_create_session(&peer->session, ctx->keypair.secret_key, peer_public_key) <
-                0) {
+            int ret = crypto_create_session(&peer->session, ctx->keypair.secret_key,
+                                            peer_public_key);
+            if (ret == 0 && peer_nonce) {
+                ret = crypto_salt_session(&peer->session, peer->hs_nonce, peer_nonce);
+            }
+            if (ret < 0) {
                 fprintf(stderr, "ERROR: Failed to create encryption session\n");
+                peer->session.authenticated = false;
                 peer->state = PEER_DISCONNECTED;
                 return 0;
             }
+            if (peer_nonce) {
+                memcpy(peer->hs_peer_nonce, peer_nonce, CRYPTO_SESSION_NONCE_BYTES);
+            }
+            /* The peer restarts its nonce counter with every session */
+            replay_window_reset(&peer->rx_replay);
+            peer_session_reset(ctx, peer);
 
             /* Update peer state */
             peer->state = PEER_HANDSHAKE_RECEIVED;
 
-            /* Send handshake response if we haven't already */
-            if (rootstream_net_handshake(ctx, peer) == 0) {
+            /* Answer a hello; a reply completes our own hello */
+            if (reply || send_handshake(ctx, peer, peer_nonce) == 0) {
                 peer->state = PEER_CONNECTED;
                 if (ctx->is_host) {
                     peer->is_streaming = true;
@@ -583,7 +2382,11 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
         case PKT_VIDEO:
         case PKT_AUDIO:
         case PKT_INPUT:
+        case PKT_INPUT_BATCH:
         case PKT_CONTROL:
+        case PKT_FEEDBACK:
+        case PKT_NACK:
+        case PKT_PROBE:
             /* Decrypt and process */
             if (!peer->session.authenticated) {
                 fprintf(stderr, "WARNING: Encrypted packet before handshake\n");
@@ -593,19 +2396,34 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
             uint8_t *encrypted = buffer + sizeof(packet_header_t);
             size_t encrypted_len = hdr->payload_size;
 
-            uint8_t decrypted[MAX_PACKET_SIZE];
+            /* Replayed or too-old nonces are dropped before the AEAD runs;
+             * only an authenticated packet may advance the window */
+            uint64_t nonce = hdr->nonce;
+            if (!replay_window_check(&peer->rx_replay, nonce)) {
+                return 0;
+            }
+
+            uint8_t decrypted[MAX_JUMBO_PACKET_SIZE];
             size_t decrypted_len = 0;
 
             if (crypto_decrypt_packet(&peer->session, encrypted, encrypted_len, decrypted,
-                                      &decrypted_len, hdr->nonce) < 0) {
+                                      &decrypted_len, nonce) < 0) {
                 fprintf(stderr, "ERROR: Decryption failed\n");
                 return 0;
             }
+            replay_window_update(&peer->rx_replay, nonce);
+            bool retransmit = (hdr->flags & PKT_FLAG_RETRANSMIT) != 0;
+            if (peer->rx_feedback && transport == TRANSPORT_UDP && !retransmit) {
+                tfb_recorder_on_packet(peer->rx_feedback, nonce,
+                                       arrival_us > 0 ? arrival_us : net_realtime_us());
+            }
 
             /* Process decrypted payload based on type */
             if (hdr->type == PKT_INPUT) {
                 input_event_pkt_t *input = (input_event_pkt_t *)decrypted;
                 rootstream_input_process(ctx, input);
+            } else if (hdr->type == PKT_INPUT_BATCH) {
+                rootstream_input_process_batch(ctx, peer, decrypted, decrypted_len);
             } else if (hdr->type == PKT_VIDEO) {
                 if (decrypted_len < sizeof(video_chunk_header_t)) {
                     fprintf(stderr, "WARNING: Video chunk too small: %zu bytes\n", decrypted_len);
@@ -615,51 +2433,60 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
                 video_chunk_header_t header;
                 memcpy(&header, decrypted, sizeof(header));
 
+                /* Repair chunks span a whole stride; frame_reasm checks them */
+                bool repair = (header.flags & VIDEO_CHUNK_REPAIR) != 0;
+                size_t prefix =
+                    sizeof(video_chunk_header_t) + (repair ? sizeof(video_fec_header_t) : 0);
+
                 if (header.total_size == 0 || header.total_size > MAX_VIDEO_FRAME_SIZE) {
                     fprintf(stderr, "WARNING: Invalid video frame size: %u bytes\n",
                             header.total_size);
                     break;
                 }
 
-                if ((size_t)header.offset + header.chunk_size > header.total_size) {
+                if (!repair && (size_t)header.offset + header.chunk_size > header.total_size) {
                     fprintf(stderr,
                             "WARNING: Video chunk out of range (offset=%u size=%u total=%u)\n",
                             header.offset, header.chunk_size, header.total_size);
                     break;
                 }
 
-                if (decrypted_len != sizeof(video_chunk_header_t) + header.chunk_size) {
+                if (decrypted_len != prefix + header.chunk_size) {
                     fprintf(stderr, "WARNING: Video chunk size mismatch\n");
                     break;
                 }
 
-                if (peer->video_rx_frame_id != header.frame_id) {
-                    peer->video_rx_frame_id = header.frame_id;
-                    peer->video_rx_received = 0;
-                    peer->video_rx_expected = header.total_size;
-                }
-
-                if (peer->video_rx_capacity < peer->video_rx_expected) {
-                    uint8_t *new_buf = realloc(peer->video_rx_buffer, peer->video_rx_expected);
-                    if (!new_buf) {
-                        fprintf(stderr, "ERROR: Failed to allocate video reassembly buffer\n");
+                if (!peer->video_rx) {
+                    peer->video_rx = frame_reasm_create(0, 0, 0);
+                    if (!peer->video_rx) {
+                        fprintf(stderr, "ERROR: Failed to allocate video reassembler\n");
                         break;
                     }
-                    peer->video_rx_buffer = new_buf;
-                    peer->video_rx_capacity = peer->video_rx_expected;
                 }
 
-                memcpy(peer->video_rx_buffer + header.offset,
-                       decrypted + sizeof(video_chunk_header_t), header.chunk_size);
-                peer->video_rx_received += header.chunk_size;
-
-                if (peer->video_rx_received >= peer->video_rx_expected) {
-                    ctx->current_frame.data = peer->video_rx_buffer;
-                    ctx->current_frame.size = peer->video_rx_expected;
-                    ctx->current_frame.capacity = peer->video_rx_capacity;
-                    ctx->current_frame.timestamp = header.timestamp_us;
-                    ctx->last_video_ts_us = header.timestamp_us;
-                    ctx->frames_received++;
+                /* Completed frames are handed out by deliver_video_frame() */
+                int added;
+                if (repair) {
+                    video_fec_header_t fec;
+                    memcpy(&fec, decrypted + sizeof(video_chunk_header_t), sizeof(fec));
+                    added = frame_reasm_add_repair(peer->video_rx, header.frame_id,
+                                                   header.total_size, header.offset, fec.group_k,
+                                                   fec.repair_idx, decrypted + prefix,
+                                                   header.chunk_size, header.timestamp_us,
+                                                   get_timestamp_ms());
+                } else {
+                    if (peer->rx_nack && transport == TRANSPORT_UDP) {
+                        nack_tracker_on_chunk(peer->rx_nack, header.frame_id, nonce,
+                                              header.offset, header.chunk_size,
+                                              header.total_size, retransmit, get_timestamp_us());
+                    }
+                    added = frame_reasm_add(peer->video_rx, header.frame_id, header.total_size,
+                                            header.offset, decrypted + prefix,
+                                            header.chunk_size, header.timestamp_us,
+                                            get_timestamp_ms());
+                }
+                if (added == FRAME_REASM_COMPLETE) {
+                    nack_tracker_on_complete(peer->rx_nack, header.frame_id);
                 }
             } else if (hdr->type == PKT_AUDIO) {
                 if (!ctx->settings.audio_enabled) {
@@ -730,7 +2557,13 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
 
                         case CTRL_SET_BITRATE:
                             if (ctrl->value >= 500000 && ctrl->value <= 100000000) {
-                                ctx->encoder.bitrate = ctrl->value;
+                                /* Congestion control works below the new ceiling */
+                                encoder_set_bitrate(&ctx->encoder, ctrl->value);
+                                encoder_set_max_bitrate(&ctx->encoder, ctrl->value);
+                                for (int i = 0; i < ctx->num_peers; i++) {
+                                    delay_controller_set_bounds(
+                                        ctx->peers[i].tx_cc, NET_CC_MIN_BITRATE, ctrl->value);
+                                }
                                 printf("INFO: Bitrate changed to %u bps by peer %s\n", ctrl->value,
                                        peer->hostname);
                             } else {
@@ -751,7 +2584,7 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
                             break;
 
                         case CTRL_REQUEST_KEYFRAME:
-                            ctx->encoder.force_keyframe = true;
+                            encoder_request_keyframe(&ctx->encoder);
 #ifdef DEBUG
                             printf("DEBUG: Keyframe requested by peer %s\n", peer->hostname);
 #endif
@@ -765,6 +2598,17 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
                             }
                             break;
 
+                        case CTRL_SET_FEC:
+                            if (ctrl->value <= VIDEO_FEC_MAX_PERCENT) {
+                                peer->video_fec_percent = (uint8_t)ctrl->value;
+                                printf("INFO: Video FEC set to %u%% by peer %s\n", ctrl->value,
+                                       peer->hostname);
+                            } else {
+                                fprintf(stderr, "WARNING: Invalid FEC level %u from peer %s\n",
+                                        ctrl->value, peer->hostname);
+                            }
+                            break;
+
                         case CTRL_DISCONNECT:
                             printf("INFO: Peer %s requested disconnect\n", peer->hostname);
                             peer->state = PEER_DISCONNECTED;
@@ -781,6 +2625,18 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
                     fprintf(stderr, "WARNING: Control packet too small (%zu bytes)\n",
                             decrypted_len);
                 }
+            } else if (hdr->type == PKT_FEEDBACK) {
+                if (transport == TRANSPORT_UDP) {
+                    handle_transport_feedback(ctx, peer, decrypted, decrypted_len);
+                }
+            } else if (hdr->type == PKT_NACK) {
+                if (transport == TRANSPORT_UDP) {
+                    handle_nack(ctx, peer, decrypted, decrypted_len);
+                }
+            } else if (hdr->type == PKT_PROBE) {
+                if (transport == TRANSPORT_UDP) {
+                    handle_pmtu_probe(ctx, peer, decrypted, decrypted_len);
+                }
             }
 
             ctx->bytes_received += recv_len;
@@ -803,6 +2659,61 @@ static int process_received_packet(rootstream_ctx_t *ctx, uint8_t *buffer, size_
     return 0;
 }
 
+/*
+ * Ask the host for FEC repair chunks while video chunks are being lost
+ *
+ * Every VIDEO_FEC_UPDATE_MS the receiver measures chunk loss before FEC
+ * (chunks rebuilt from repairs plus chunks of dropped frames) and asks
+ * for twice that as repair overhead plus VIDEO_FEC_MIN_PERCENT.  After
+ * VIDEO_FEC_CLEAN_PERIODS loss-free periods it halves the overhead, and
+ * switches repairs off once that falls below the minimum.
+ */
+static void update_video_fec(rootstream_ctx_t *ctx, peer_t *peer, uint64_t now) {
+    if (now - peer->video_rx_fec_check < VIDEO_FEC_UPDATE_MS) {
+        return;
+    }
+    peer->video_rx_fec_check = now;
+
+    frame_reasm_stats_t st;
+    frame_reasm_get_stats(peer->video_rx, &st);
+    uint64_t lost = st.recovered + st.missing;
+    uint64_t total = st.chunks + lost;
+
+    /* Counters restart when the reassembler is reset */
+    if (total < peer->video_rx_fec_total || lost < peer->video_rx_fec_lost) {
+        peer->video_rx_fec_total = 0;
+        peer->video_rx_fec_lost = 0;
+    }
+    uint64_t period_lost = lost - peer->video_rx_fec_lost;
+    uint64_t period_total = total - peer->video_rx_fec_total;
+    peer->video_rx_fec_lost = lost;
+    peer->video_rx_fec_total = total;
+    if (period_total == 0) {
+        return; /* No video this period */
+    }
+
+    unsigned want = peer->video_rx_fec_percent;
+    if (period_lost > 0) {
+        peer->video_rx_fec_clean = 0;
+        want = (unsigned)((period_lost * 200 + period_total - 1) / period_total) +
+               VIDEO_FEC_MIN_PERCENT;
+        if (want > VIDEO_FEC_MAX_PERCENT) {
+            want = VIDEO_FEC_MAX_PERCENT;
+        }
+    } else if (want > 0 && ++peer->video_rx_fec_clean >= VIDEO_FEC_CLEAN_PERIODS) {
+        peer->video_rx_fec_clean = 0;
+        want /= 2;
+        if (want < VIDEO_FEC_MIN_PERCENT) {
+            want = 0;
+        }
+    }
+
+    if (want != peer->video_rx_fec_percent &&
+        rootstream_send_control(ctx, peer, CTRL_SET_FEC, want) == 0) {
+        peer->video_rx_fec_percent = (uint8_t)want;
+    }
+}
+
 void rootstream_net_tick(rootstream_ctx_t *ctx) {
     if (!ctx) {
         return;
@@ -829,14 +2740,25 @@ void rootstream_net_tick(rootstream_ctx_t *ctx) {
                         peer->hostname[0] ? peer->hostname : "unknown");
                 peer->state = PEER_DISCONNECTED;
                 peer->is_streaming = false;
-                if (peer->video_rx_buffer) {
-                    free(peer->video_rx_buffer);
-                    peer->video_rx_buffer = NULL;
-                    peer->video_rx_capacity = 0;
+                if (frame_reasm_is_held(peer->video_rx, ctx->current_frame.data)) {
+                    ctx->current_frame.data = NULL;
+                    ctx->current_frame.size = 0;
                 }
+                frame_reasm_reset(peer->video_rx);
+                nack_tracker_reset(peer->rx_nack);
                 continue;
             }
 
+            if (peer->video_rx) {
+                update_video_fec(ctx, peer, now);
+            }
+            if (peer->rx_feedback && peer->transport == TRANSPORT_UDP) {
+                send_transport_feedback(ctx, peer, now);
+            }
+            if (peer->tx_pmtu) {
+                send_pmtu_probe(ctx, peer);
+            }
+
             if (now - peer->last_sent >= KEEPALIVE_INTERVAL_MS) {
                 rootstream_net_send_encrypted(ctx, peer, PKT_PING, NULL, 0);
                 peer->last_ping = now;
@@ -855,6 +2777,9 @@ void rootstream_net_tick(rootstream_ctx_t *ctx) {
  * Handshake packet payload (plaintext):
  * - 32 bytes: sender's Ed25519 public key
  * - Variable: hostname (null-terminated string)
+ * - 1 byte each: protocol version, protocol flags
+ * - 32 bytes: sender's session nonce
+ * - 32 bytes: echo of the nonce being answered (zero in a hello)
  */
 int rootstream_net_handshake(rootstream_ctx_t *ctx, peer_t *peer) {
     if (!ctx || !peer) {
@@ -862,16 +2787,38 @@ int rootstream_net_handshake(rootstream_ctx_t *ctx, peer_t *peer) {
         return -1;
     }
 
-    /* Build handshake payload: [public_key][hostname] */
+    /* A new hello gets a new session nonce; retries repeat it so a late
+     * reply to the first one still matches */
+    if (peer->state != PEER_HANDSHAKE_SENT) {
+        randombytes_buf(peer->hs_nonce, sizeof(peer->hs_nonce));
+    }
+    return send_handshake(ctx, peer, NULL);
+}
+
+/*
+ * Send our handshake: a hello (echo NULL) or the reply to a hello,
+ * echoing the session nonce it carried
+ */
+static int send_handshake(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *echo) {
+    /* Build handshake payload:
+     * [public_key][hostname][version][flags][session nonce][echo] */
     uint8_t payload[256];
     memcpy(payload, ctx->keypair.public_key, CRYPTO_PUBLIC_KEY_BYTES);
     strcpy((char *)(payload + CRYPTO_PUBLIC_KEY_BYTES), ctx->keypair.identity);
 
     size_t payload_len = CRYPTO_PUBLIC_KEY_BYTES + strlen(ctx->keypair.identity) + 1;
-    if (payload_len + 2 <= sizeof(payload)) {
+    if (payload_len + 2 + 2 * CRYPTO_SESSION_NONCE_BYTES <= sizeof(payload)) {
         payload[payload_len] = PROTOCOL_VERSION;
         payload[payload_len + 1] = PROTOCOL_FLAGS;
         payload_len += 2;
+        memcpy(payload + payload_len, peer->hs_nonce, CRYPTO_SESSION_NONCE_BYTES);
+        payload_len += CRYPTO_SESSION_NONCE_BYTES;
+        if (echo) {
+            memcpy(payload + payload_len, echo, CRYPTO_SESSION_NONCE_BYTES);
+        } else {
+            memset(payload + payload_len, 0, CRYPTO_SESSION_NONCE_BYTES);
+        }
+        payload_len += CRYPTO_SESSION_NONCE_BYTES;
     }
 
     /* Send handshake (unencrypted for initial key exchange) */
@@ -1010,6 +2957,7 @@ peer_t *rootstream_add_peer(rootstream_ctx_t *ctx, const char *code) {
                 fprintf(stderr, "ERROR: Failed to create encryption session\n");
                 return NULL;
             }
+            peer_session_reset(ctx, existing);
         }
         return existing;
     }
@@ -1043,11 +2991,7 @@ peer_t *rootstream_add_peer(rootstream_ctx_t *ctx, const char *code) {
 
     peer->state = PEER_DISCOVERED;
     peer->video_tx_frame_id = 1;
-    peer->video_rx_frame_id = 0;
-    peer->video_rx_buffer = NULL;
-    peer->video_rx_capacity = 0;
-    peer->video_rx_expected = 0;
-    peer->video_rx_received = 0;
+    peer->video_rx = NULL;
     peer->transport = TRANSPORT_UDP; /* Default to UDP */
 
     /* Initialize reconnection context (PHASE 4) */
@@ -1107,21 +3051,38 @@ void rootstream_remove_peer(rootstream_ctx_t *ctx, peer_t *peer) {
     if (peer->reconnect_ctx) {
         peer_reconnect_cleanup(peer);
     }
+    rootstream_input_forget_peer(ctx, peer);
 
-    if (peer->video_rx_buffer) {
-        if (ctx->current_frame.data == peer->video_rx_buffer) {
+    if (peer->video_rx) {
+        if (frame_reasm_is_held(peer->video_rx, ctx->current_frame.data)) {
             ctx->current_frame.data = NULL;
             ctx->current_frame.size = 0;
         }
-        free(peer->video_rx_buffer);
-        peer->video_rx_buffer = NULL;
+        frame_reasm_destroy(peer->video_rx);
+        peer->video_rx = NULL;
+    }
+
+#ifndef RS_PLATFORM_WINDOWS
+    net_fanout_release_lane(ctx, peer);
+    if (peer->pacer_flow > 0) {
+        tx_pacer_flow_close(ctx->tx_pacer, peer->pacer_flow - 1);
     }
+#endif
+    peer_tx_free(peer);
+    tfb_recorder_destroy(peer->rx_feedback);
+    nack_tracker_destroy(peer->rx_nack);
+    plpmtud_destroy(peer->tx_pmtu);
+    bool controlled = peer->tx_cc != NULL;
+    delay_controller_destroy(peer->tx_cc);
 
     for (int i = index; i < ctx->num_peers - 1; i++) {
         ctx->peers[i] = ctx->peers[i + 1];
     }
 
     ctx->num_peers--;
+    if (controlled) {
+        net_cc_apply(ctx); /* The departed peer may have been the bottleneck */
+    }
 }
 
 /*
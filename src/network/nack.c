@@ -0,0 +1,463 @@
+/*
+ * nack.c - Selective retransmission of lost video chunks
+ *
+ * The tracker keeps a small record per frame in a ring indexed by
+ * frame_id and leaves the retry schedule to an rm_table keyed by the
+ * same id.  Which chunks are still missing is always asked of the
+ * reassembler at NACK time, so chunks rebuilt by FEC or arriving late
+ * are never requested.
+ */
+
+#include "nack.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../congestion/rtt_estimator.h"
+#include "../retry_mgr/rm_table.h"
+
+#define FRAME_MASK (NACK_TRACK_FRAMES - 1u)
+#define CACHE_MASK ((uint64_t)NACK_CACHE_PACKETS - 1)
+
+typedef struct {
+    bool used;
+    bool complete;
+    uint32_t frame_id;
+    bool have_base;
+    uint64_t base;      /* Nonce of chunk 0 */
+    uint32_t stride;    /* Chunk size, 0 until a non-final chunk */
+    bool have_highest;
+    uint32_t highest;   /* Highest chunk index seen */
+    uint64_t first_us;  /* First chunk's arrival */
+    uint64_t nack_us;   /* First NACK, 0 once an RTT was taken from it */
+    uint32_t nacks;     /* NACKs sent for this frame */
+} nack_frame_t;
+
+struct nack_tracker_s {
+    rm_table_t *pending; /* Frames with holes, by frame_id */
+    rtt_estimator_t *rtt;
+    uint64_t deadline_us;
+    nack_frame_t frames[NACK_TRACK_FRAMES];
+    bool have_latest;
+    uint32_t latest; /* Newest frame_id seen */
+    nack_tracker_stats_t stats;
+
+    /* Scratch for one poll */
+    const frame_reasm_t *reasm;
+    uint64_t now_us;
+    int nnonces;
+    uint32_t idx[FRAME_REASM_MAX_CHUNKS];
+    uint64_t nonces[NACK_MAX_NONCES];
+};
+
+typedef struct {
+    atomic_flag lock;
+    uint64_t nonce; /* Nonce + 1, 0 = empty */
+    uint16_t len;
+    uint8_t resends;
+} cache_slot_t;
+
+struct nack_cache_s {
+    cache_slot_t slots[NACK_CACHE_PACKETS];
+    size_t max_packet;
+    uint8_t *data; /* NACK_CACHE_PACKETS × max_packet */
+};
+
+/* Wrap-aware "a is newer than b" */
+static bool id_after(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+static void put_le64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint64_t get_le64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = v << 8 | p[i];
+    }
+    return v;
+}
+
+/* ── Wire format ─────────────────────────────────────────────────── */
+
+size_t nack_encode(const uint64_t *nonces, int n, uint8_t *buf, size_t cap, int *consumed) {
+    int used = 0;
+    size_t len = 1;
+    uint8_t count = 0;
+
+    if (nonces && buf) {
+        while (used < n && count < NACK_MAX_ENTRIES && len + NACK_ENTRY_SIZE <= cap) {
+            uint64_t first = nonces[used++];
+            uint16_t mask = 0;
+            while (used < n && nonces[used] > first &&
+                   nonces[used] - first <= NACK_MASK_BITS) {
+                mask |= (uint16_t)(1u << (nonces[used] - first - 1));
+                used++;
+            }
+            put_le64(buf + len, first);
+            buf[len + 8] = (uint8_t)mask;
+            buf[len + 9] = (uint8_t)(mask >> 8);
+            len += NACK_ENTRY_SIZE;
+            count++;
+        }
+    }
+    if (consumed) {
+        *consumed = used;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    buf[0] = count;
+    return len;
+}
+
+int nack_decode(const uint8_t *buf, size_t len, uint64_t *nonces, int max) {
+    if (!buf || !nonces || len < 1 || buf[0] == 0 ||
+        len != 1 + (size_t)buf[0] * NACK_ENTRY_SIZE) {
+        return -1;
+    }
+
+    int n = 0;
+    for (size_t e = 0; e < buf[0]; e++) {
+        const uint8_t *p = buf + 1 + e * NACK_ENTRY_SIZE;
+        uint64_t first = get_le64(p);
+        uint16_t mask = (uint16_t)(p[8] | p[9] << 8);
+        if (n >= max || first > UINT64_MAX - NACK_MASK_BITS) {
+            return -1;
+        }
+        nonces[n++] = first;
+        for (int b = 0; b < NACK_MASK_BITS; b++) {
+            if (mask >> b & 1) {
+                if (n >= max) {
+                    return -1;
+                }
+                nonces[n++] = first + 1 + (uint64_t)b;
+            }
+        }
+    }
+    return n;
+}
+
+/* ── Receiver ────────────────────────────────────────────────────── */
+
+nack_tracker_t *nack_tracker_create(uint32_t deadline_ms) {
+    nack_tracker_t *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return NULL;
+    }
+    t->pending = rm_table_create();
+    t->rtt = rtt_estimator_create();
+    if (!t->pending || !t->rtt) {
+        nack_tracker_destroy(t);
+        return NULL;
+    }
+    t->deadline_us =
+        (uint64_t)(deadline_ms ? deadline_ms : FRAME_REASM_DEFAULT_MAX_AGE_MS) * 1000;
+    return t;
+}
+
+void nack_tracker_destroy(nack_tracker_t *t) {
+    if (!t) {
+        return;
+    }
+    rm_table_destroy(t->pending);
+    rtt_estimator_destroy(t->rtt);
+    free(t);
+}
+
+void nack_tracker_reset(nack_tracker_t *t) {
+    if (!t) {
+        return;
+    }
+    for (int i = 0; i < NACK_TRACK_FRAMES; i++) {
+        if (t->frames[i].used) {
+            rm_table_remove(t->pending, t->frames[i].frame_id);
+        }
+    }
+    memset(t->frames, 0, sizeof(t->frames));
+    rtt_estimator_reset(t->rtt);
+    t->have_latest = false;
+    memset(&t->stats, 0, sizeof(t->stats));
+}
+
+uint64_t nack_tracker_rtt_us(const nack_tracker_t *t) {
+    rtt_snapshot_t s;
+    if (!t || !rtt_estimator_has_samples(t->rtt) || rtt_estimator_snapshot(t->rtt, &s) != 0) {
+        return NACK_DEFAULT_RTT_US;
+    }
+    return (uint64_t)s.srtt_us;
+}
+
+/* Delay before a NACK is repeated (doubled by rm_entry per attempt) */
+static uint64_t retry_delay_us(const nack_tracker_t *t) {
+    rtt_snapshot_t s;
+    if (!rtt_estimator_has_samples(t->rtt) || rtt_estimator_snapshot(t->rtt, &s) != 0) {
+        return NACK_DEFAULT_RTT_US;
+    }
+    return s.rto_us > NACK_MIN_BACKOFF_US ? (uint64_t)s.rto_us : NACK_MIN_BACKOFF_US;
+}
+
+/*
+ * The stall is timed from the frame's last chunk.  A lost tail only
+ * shows when the next frame starts, up to a frame interval later, and
+ * the answer takes a round trip more: allow two retry delays.
+ */
+uint32_t nack_tracker_hold_ms(const nack_tracker_t *t) {
+    if (!t) {
+        return 0;
+    }
+    uint64_t hold = NACK_REORDER_US + 2 * retry_delay_us(t);
+    if (hold > t->deadline_us) {
+        hold = t->deadline_us;
+    }
+    return (uint32_t)((hold + 999) / 1000);
+}
+
+static nack_frame_t *frame_get(nack_tracker_t *t, uint32_t frame_id) {
+    nack_frame_t *f = &t->frames[frame_id & FRAME_MASK];
+    return f->used && f->frame_id == frame_id ? f : NULL;
+}
+
+/* Queue a NACK for f NACK_REORDER_US from now unless one is already */
+static void frame_schedule(nack_tracker_t *t, nack_frame_t *f, uint64_t now_us) {
+    if (f->complete || f->nacks >= NACK_MAX_ATTEMPTS ||
+        rm_table_get(t->pending, f->frame_id)) {
+        return;
+    }
+    rm_entry_t *e =
+        rm_table_add(t->pending, f->frame_id, now_us, retry_delay_us(t), NACK_MAX_ATTEMPTS);
+    if (e) {
+        e->next_retry_us = now_us + NACK_REORDER_US;
+    }
+}
+
+void nack_tracker_on_chunk(nack_tracker_t *t, uint32_t frame_id, uint64_t nonce,
+                           uint32_t offset, uint32_t len, uint32_t total_size, bool retransmit,
+                           uint64_t now_us) {
+    if (!t || len == 0 || offset >= total_size || len > total_size - offset) {
+        return;
+    }
+
+    nack_frame_t *f = frame_get(t, frame_id);
+    if (!f) {
+        if (t->have_latest && !id_after(frame_id, t->latest) &&
+            t->latest - frame_id >= NACK_TRACK_FRAMES) {
+            return; /* Too old to track */
+        }
+        f = &t->frames[frame_id & FRAME_MASK];
+        if (f->used) {
+            rm_table_remove(t->pending, f->frame_id);
+        }
+        memset(f, 0, sizeof(*f));
+        f->used = true;
+        f->frame_id = frame_id;
+        f->first_us = now_us;
+    }
+
+    if (retransmit) {
+        t->stats.retransmits++;
+        if (f->nacks == 1 && f->nack_us != 0 && now_us > f->nack_us) {
+            rtt_estimator_update(t->rtt, now_us - f->nack_us);
+            f->nack_us = 0;
+        }
+    }
+
+    bool final = offset + len == total_size;
+    if (!final) {
+        f->stride = len;
+    }
+    if (f->stride != 0 && offset % f->stride == 0) {
+        uint32_t idx = offset / f->stride;
+        if (!f->have_base) {
+            f->base = nonce - idx;
+            f->have_base = true;
+        }
+        if (!f->have_highest || idx > f->highest) {
+            if (idx > (f->have_highest ? f->highest + 1 : 0)) {
+                frame_schedule(t, f, now_us); /* Hole below this chunk */
+            }
+            f->highest = idx;
+            f->have_highest = true;
+        }
+    } else if (offset == 0) {
+        f->base = nonce;
+        f->have_base = true;
+    } else if (final) {
+        frame_schedule(t, f, now_us); /* Tail without its predecessors */
+    }
+
+    /* A newer frame closes the older ones: their lost tails count now */
+    if (!t->have_latest || id_after(frame_id, t->latest)) {
+        for (int i = 0; i < NACK_TRACK_FRAMES; i++) {
+            nack_frame_t *o = &t->frames[i];
+            if (o->used && !o->complete && id_after(frame_id, o->frame_id) &&
+                o->first_us + t->deadline_us > now_us) {
+                frame_schedule(t, o, now_us);
+            }
+        }
+        t->latest = frame_id;
+        t->have_latest = true;
+    }
+}
+
+void nack_tracker_on_complete(nack_tracker_t *t, uint32_t frame_id) {
+    if (!t) {
+        return;
+    }
+    nack_frame_t *f = frame_get(t, frame_id);
+    if (f) {
+        f->complete = true;
+    }
+    rm_table_remove(t->pending, frame_id);
+}
+
+/* rm_table_tick callback: collect one frame's missing nonces */
+static void poll_frame(rm_entry_t *e, void *user) {
+    nack_tracker_t *t = user;
+    nack_frame_t *f = frame_get(t, (uint32_t)e->request_id);
+    int n = f && !f->complete && f->have_base
+                ? frame_reasm_missing(t->reasm, f->frame_id, t->idx, FRAME_REASM_MAX_CHUNKS)
+                : -1;
+
+    if (n > 0 && t->now_us + nack_tracker_rtt_us(t) > f->first_us + t->deadline_us) {
+        t->stats.too_late++;
+        n = -1;
+    }
+    if (n <= 0) {
+        /* Nothing left to ask for: make this the entry's last attempt */
+        e->attempt_count = e->max_attempts - 1;
+        return;
+    }
+
+    for (int i = 0; i < n && t->nnonces < NACK_MAX_NONCES; i++) {
+        t->nonces[t->nnonces++] = f->base + t->idx[i];
+    }
+    if (f->nacks++ == 0) {
+        f->nack_us = t->now_us;
+    }
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+size_t nack_tracker_poll(nack_tracker_t *t, const frame_reasm_t *reasm, uint64_t now_us,
+                         uint8_t *buf, size_t cap) {
+    if (!t || !reasm || !buf) {
+        return 0;
+    }
+
+    t->reasm = reasm;
+    t->now_us = now_us;
+    t->nnonces = 0;
+    rm_table_tick(t->pending, now_us, poll_frame, t);
+    if (t->nnonces == 0) {
+        return 0;
+    }
+
+    /* Frames come out in table order; nonces that do not fit wait for
+     * the frame's next attempt */
+    qsort(t->nonces, (size_t)t->nnonces, sizeof(t->nonces[0]), cmp_u64);
+    int used = 0;
+    size_t len = nack_encode(t->nonces, t->nnonces, buf, cap, &used);
+    if (len > 0) {
+        t->stats.nacks_sent++;
+        t->stats.nonces_requested += (uint64_t)used;
+    }
+    return len;
+}
+
+void nack_tracker_get_stats(const nack_tracker_t *t, nack_tracker_stats_t *out) {
+    if (!t || !out) {
+        return;
+    }
+    *out = t->stats;
+}
+
+/* ── Sender ──────────────────────────────────────────────────────── */
+
+nack_cache_t *nack_cache_create(size_t max_packet) {
+    if (max_packet == 0 || max_packet > UINT16_MAX) {
+        return NULL;
+    }
+    nack_cache_t *c = malloc(sizeof(*c));
+    if (!c) {
+        return NULL;
+    }
+    c->data = malloc(NACK_CACHE_PACKETS * max_packet);
+    if (!c->data) {
+        free(c);
+        return NULL;
+    }
+    c->max_packet = max_packet;
+    for (size_t i = 0; i < NACK_CACHE_PACKETS; i++) {
+        atomic_flag_clear(&c->slots[i].lock);
+        c->slots[i].nonce = 0;
+    }
+    return c;
+}
+
+void nack_cache_destroy(nack_cache_t *c) {
+    if (!c) {
+        return;
+    }
+    free(c->data);
+    free(c);
+}
+
+static void slot_lock(cache_slot_t *s) {
+    while (atomic_flag_test_and_set_explicit(&s->lock, memory_order_acquire)) {
+    }
+}
+
+static void slot_unlock(cache_slot_t *s) {
+    atomic_flag_clear_explicit(&s->lock, memory_order_release);
+}
+
+void nack_cache_reset(nack_cache_t *c) {
+    if (!c) {
+        return;
+    }
+    for (size_t i = 0; i < NACK_CACHE_PACKETS; i++) {
+        slot_lock(&c->slots[i]);
+        c->slots[i].nonce = 0;
+        slot_unlock(&c->slots[i]);
+    }
+}
+
+void nack_cache_store(nack_cache_t *c, uint64_t nonce, const uint8_t *packet, size_t len) {
+    if (!c || !packet || len == 0 || len > c->max_packet) {
+        return;
+    }
+    size_t i = (size_t)(nonce & CACHE_MASK);
+    cache_slot_t *s = &c->slots[i];
+    slot_lock(s);
+    memcpy(c->data + i * c->max_packet, packet, len);
+    s->nonce = nonce + 1;
+    s->len = (uint16_t)len;
+    s->resends = 0;
+    slot_unlock(s);
+}
+
+size_t nack_cache_fetch(nack_cache_t *c, uint64_t nonce, uint8_t *out, size_t cap) {
+    if (!c || !out) {
+        return 0;
+    }
+    size_t i = (size_t)(nonce & CACHE_MASK);
+    cache_slot_t *s = &c->slots[i];
+    size_t len = 0;
+    slot_lock(s);
+    if (s->nonce == nonce + 1 && s->resends < NACK_MAX_RESENDS && s->len <= cap) {
+        s->resends++;
+        len = s->len;
+        memcpy(out, c->data + i * c->max_packet, len);
+    }
+    slot_unlock(s);
+    return len;
+}
@@ -0,0 +1,132 @@
+/*
+ * nack.h - Selective retransmission of lost video chunks
+ *
+ * The receiver asks for lost chunks by nonce and the sender answers from
+ * a cache of the sealed packets it sent recently, resending the exact
+ * bytes: nothing is re-encrypted, and the receiver's replay window
+ * (replay_window.h) drops whichever copy arrives second.
+ *
+ * A frame's data chunks are sealed with consecutive nonces in offset
+ * order (network.c), so any data chunk tells the receiver the nonce of
+ * every other one: nonce = base + offset / chunk_size.
+ *
+ * NACK payload (PKT_NACK), little-endian, RFC 4585 PID/BLP style:
+ *
+ *   offset  size  field
+ *   0       1     count    entries that follow (1..NACK_MAX_ENTRIES)
+ *   1       10×n  entries  u64 nonce, u16 mask: bit i set = nonce+1+i lost
+ *
+ * Receiver (nack_tracker): a frame with a hole below its highest chunk,
+ * or left incomplete when a newer frame starts, goes into an rm_table
+ * (retry_mgr/rm_table.h).  Its first NACK fires NACK_REORDER_US later so
+ * reordered chunks do not trigger one; repeats back off exponentially
+ * from the retransmission timeout, at most NACK_MAX_ATTEMPTS in all.  A
+ * frame whose repair could not arrive before the reassembler gives up on
+ * it (first chunk + deadline < now + RTT) is not NACKed.  The RTT comes
+ * from the first retransmission answering a frame's first NACK (Karn's
+ * rule: later ones are ambiguous).
+ *
+ * Sender (nack_cache): ring of NACK_CACHE_PACKETS sealed packets keyed by
+ * nonce.  Each is resent at most NACK_MAX_RESENDS times, so a receiver
+ * cannot make the sender amplify its traffic.
+ *
+ * Thread-safety: the tracker is NOT thread-safe.  A cache may be stored
+ * into, fetched from and reset concurrently (a spinlock per slot).
+ */
+
+#ifndef ROOTSTREAM_NACK_H
+#define ROOTSTREAM_NACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../chunk/frame_reasm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NACK_MAX_ENTRIES 64      /* Entries per NACK payload */
+#define NACK_ENTRY_SIZE 10       /* Bytes per entry */
+#define NACK_MASK_BITS 16        /* Follow-on nonces per entry */
+#define NACK_MAX_NONCES (NACK_MAX_ENTRIES * (NACK_MASK_BITS + 1))
+#define NACK_MAX_PAYLOAD (1 + NACK_MAX_ENTRIES * NACK_ENTRY_SIZE)
+
+#define NACK_REORDER_US 3000     /* Hole age before the first NACK */
+#define NACK_MAX_ATTEMPTS 3      /* NACKs per frame */
+#define NACK_MIN_BACKOFF_US 10000 /* Floor of the retry delay */
+#define NACK_DEFAULT_RTT_US 50000 /* RTT until one is measured */
+#define NACK_TRACK_FRAMES 64     /* Frames the tracker remembers; power of two */
+
+#define NACK_CACHE_PACKETS 1024  /* Sealed packets a sender keeps; power of two */
+#define NACK_MAX_RESENDS 3       /* Resends of one packet */
+
+/* Receiver statistics */
+typedef struct {
+    uint64_t nacks_sent;       /* Payloads built */
+    uint64_t nonces_requested; /* Chunks asked for, repeats included */
+    uint64_t retransmits;      /* Retransmitted chunks received */
+    uint64_t too_late;         /* NACKs suppressed past the deadline */
+} nack_tracker_stats_t;
+
+typedef struct nack_tracker_s nack_tracker_t;
+typedef struct nack_cache_s nack_cache_t;
+
+/* Encode up to NACK_MAX_ENTRIES entries covering a prefix of the
+ * ascending, distinct nonces; *consumed says how many.  Returns the
+ * payload length, 0 if nothing fits or n is 0. */
+size_t nack_encode(const uint64_t *nonces, int n, uint8_t *buf, size_t cap, int *consumed);
+
+/* Decode a payload into ascending nonces; returns the count, or -1 if
+ * malformed or more than max */
+int nack_decode(const uint8_t *buf, size_t len, uint64_t *nonces, int max);
+
+/* Receiver.  deadline_ms is how long the reassembler waits for a frame
+ * (0 = FRAME_REASM_DEFAULT_MAX_AGE_MS). */
+nack_tracker_t *nack_tracker_create(uint32_t deadline_ms);
+void nack_tracker_destroy(nack_tracker_t *t);
+
+/* Forget all frames and the RTT (new session) */
+void nack_tracker_reset(nack_tracker_t *t);
+
+/* Note one data chunk as it arrives */
+void nack_tracker_on_chunk(nack_tracker_t *t, uint32_t frame_id, uint64_t nonce,
+                           uint32_t offset, uint32_t len, uint32_t total_size, bool retransmit,
+                           uint64_t now_us);
+
+/* The frame is whole: stop asking for it */
+void nack_tracker_on_complete(nack_tracker_t *t, uint32_t frame_id);
+
+/* Build the NACK payload due at now_us from the chunks reasm still
+ * lacks; returns its length, 0 if none is due.  cap should be at least
+ * NACK_MAX_PAYLOAD. */
+size_t nack_tracker_poll(nack_tracker_t *t, const frame_reasm_t *reasm, uint64_t now_us,
+                         uint8_t *buf, size_t cap);
+
+/* Round trip from NACK to retransmission (µs) */
+uint64_t nack_tracker_rtt_us(const nack_tracker_t *t);
+
+/* How long the reassembler should let an incomplete frame stall so a
+ * retransmission can still complete it (ms) */
+uint32_t nack_tracker_hold_ms(const nack_tracker_t *t);
+
+void nack_tracker_get_stats(const nack_tracker_t *t, nack_tracker_stats_t *out);
+
+/* Sender.  max_packet bounds the stored packet size. */
+nack_cache_t *nack_cache_create(size_t max_packet);
+void nack_cache_destroy(nack_cache_t *c);
+void nack_cache_reset(nack_cache_t *c);
+
+/* Remember a sealed packet; longer than max_packet is ignored */
+void nack_cache_store(nack_cache_t *c, uint64_t nonce, const uint8_t *packet, size_t len);
+
+/* Copy out the packet sealed with nonce; returns its length, or 0 if it
+ * is gone, larger than cap or already resent NACK_MAX_RESENDS times */
+size_t nack_cache_fetch(nack_cache_t *c, uint64_t nonce, uint8_t *out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_NACK_H */
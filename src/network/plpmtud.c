@@ -0,0 +1,240 @@
+/*
+ * plpmtud.c - Packetization layer path MTU discovery (RFC 8899)
+ *
+ * The search keeps an open range (lo, hi]: lo is the largest size known
+ * to reach the peer, hi the largest not known to fail.  An ack raises
+ * lo, PLPMTUD_MAX_PROBES losses lower hi below the probed size.
+ */
+
+#include "plpmtud.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* UDP payloads of common link MTUs, largest first: Ethernet over IPv4
+ * and IPv6, PPPoE, WireGuard over IPv4 and IPv6, the IPv6 minimum */
+static const uint16_t common_sizes[] = {1472, 1464, 1452, 1392, 1372, 1232};
+
+struct plpmtud_s {
+    size_t initial;
+    size_t max;
+    plpmtud_state_t state;
+    size_t size; /* PLPMTU */
+    size_t lo;   /* Largest size acked, 0 = none yet */
+    size_t hi;   /* Largest size not known to fail */
+
+    size_t probe_size;  /* Size being probed, 0 = none (SEARCH_COMPLETE) */
+    bool confirming;    /* probe_size re-checks the PLPMTU */
+    bool in_flight;
+    int lost;           /* Probes lost at probe_size */
+    uint32_t next_id;
+    uint32_t first_id;  /* First probe sent at probe_size */
+    uint64_t sent_us;   /* When the probe in flight left */
+    uint64_t next_us;   /* Next confirmation (SEARCH_COMPLETE) */
+    uint64_t raise_us;  /* Next search above the PLPMTU (SEARCH_COMPLETE) */
+
+    plpmtud_stats_t stats;
+};
+
+/* Next size to probe in SEARCHING, 0 once the range is closed */
+static size_t next_candidate(const plpmtud_t *p) {
+    if (p->hi <= p->lo || p->hi - p->lo < PLPMTUD_SEARCH_STEP) {
+        return 0;
+    }
+    if (p->hi == p->max) {
+        return p->max;
+    }
+    for (size_t i = 0; i < sizeof(common_sizes) / sizeof(common_sizes[0]); i++) {
+        if (common_sizes[i] > p->lo && common_sizes[i] <= p->hi) {
+            return common_sizes[i];
+        }
+    }
+    return p->lo + (p->hi - p->lo + 1) / 2;
+}
+
+static void start_probe(plpmtud_t *p, size_t size, bool confirming) {
+    p->probe_size = size;
+    p->confirming = confirming;
+    p->in_flight = false;
+    p->lost = 0;
+    p->first_id = p->next_id;
+}
+
+/* Pick the next search step, or settle on lo */
+static void search_next(plpmtud_t *p, uint64_t now_us) {
+    size_t size = next_candidate(p);
+    if (size > 0) {
+        p->state = PLPMTUD_SEARCHING;
+        start_probe(p, size, false);
+        return;
+    }
+
+    p->state = PLPMTUD_SEARCH_COMPLETE;
+    p->probe_size = 0;
+    p->in_flight = false;
+    p->next_us = now_us + PLPMTUD_CONFIRM_US;
+    p->raise_us = now_us + PLPMTUD_RAISE_US;
+}
+
+/* Search again from the minimum */
+static void search_from_min(plpmtud_t *p, size_t hi, uint64_t now_us) {
+    p->size = PLPMTUD_MIN_SIZE;
+    p->lo = PLPMTUD_MIN_SIZE;
+    p->hi = hi;
+    search_next(p, now_us);
+}
+
+/* The probed size was lost PLPMTUD_MAX_PROBES times or rejected */
+static void probe_failed(plpmtud_t *p, uint64_t now_us) {
+    if (p->state == PLPMTUD_BASE) {
+        search_from_min(p, p->initial - 1, now_us);
+    } else if (p->confirming) {
+        p->stats.black_holes++;
+        search_from_min(p, p->max, now_us);
+    } else {
+        p->hi = p->probe_size - 1;
+        search_next(p, now_us);
+    }
+}
+
+plpmtud_t *plpmtud_create(size_t initial, size_t max) {
+    if (initial < PLPMTUD_MIN_SIZE || initial > max || max > UINT16_MAX) {
+        return NULL;
+    }
+    plpmtud_t *p = calloc(1, sizeof(*p));
+    if (!p) {
+        return NULL;
+    }
+    p->initial = initial;
+    p->max = max;
+    plpmtud_reset(p);
+    return p;
+}
+
+void plpmtud_destroy(plpmtud_t *p) {
+    free(p);
+}
+
+void plpmtud_reset(plpmtud_t *p) {
+    if (!p) {
+        return;
+    }
+    p->state = PLPMTUD_BASE;
+    p->size = p->initial;
+    p->lo = 0;
+    p->hi = p->max;
+    start_probe(p, p->initial, false);
+}
+
+size_t plpmtud_size(const plpmtud_t *p) {
+    return p ? p->size : 0;
+}
+
+plpmtud_state_t plpmtud_state(const plpmtud_t *p) {
+    return p ? p->state : PLPMTUD_BASE;
+}
+
+size_t plpmtud_poll(plpmtud_t *p, uint64_t now_us, uint32_t *probe_id) {
+    if (!p || !probe_id) {
+        return 0;
+    }
+
+    if (p->in_flight) {
+        if (now_us - p->sent_us < PLPMTUD_PROBE_TIMEOUT_US) {
+            return 0;
+        }
+        p->in_flight = false;
+        p->stats.probes_lost++;
+        if (++p->lost >= PLPMTUD_MAX_PROBES) {
+            probe_failed(p, now_us);
+        }
+    }
+
+    if (p->state == PLPMTUD_SEARCH_COMPLETE && p->probe_size == 0) {
+        if (now_us >= p->raise_us && p->size < p->max) {
+            p->lo = p->size;
+            p->hi = p->max;
+            search_next(p, now_us);
+        } else if (now_us >= p->next_us && p->size > PLPMTUD_MIN_SIZE) {
+            start_probe(p, p->size, true);
+        } else {
+            return 0;
+        }
+        if (p->probe_size == 0) {
+            return 0;
+        }
+    }
+
+    *probe_id = p->next_id++;
+    p->in_flight = true;
+    p->sent_us = now_us;
+    p->stats.probes_sent++;
+    return p->probe_size;
+}
+
+bool plpmtud_on_ack(plpmtud_t *p, uint32_t probe_id, uint64_t now_us) {
+    /* Any probe sent at the current size counts, even one that timed out */
+    if (!p || p->probe_size == 0 ||
+        (uint32_t)(probe_id - p->first_id) >= (uint32_t)(p->next_id - p->first_id)) {
+        return false;
+    }
+    p->stats.probes_acked++;
+
+    if (p->confirming) {
+        p->state = PLPMTUD_SEARCH_COMPLETE;
+        p->probe_size = 0;
+        p->in_flight = false;
+        p->next_us = now_us + PLPMTUD_CONFIRM_US;
+        return false;
+    }
+
+    size_t old = p->size;
+    p->lo = p->probe_size;
+    p->size = p->probe_size;
+    search_next(p, now_us);
+    return p->size > old;
+}
+
+void plpmtud_on_too_big(plpmtud_t *p, uint64_t now_us) {
+    if (!p || !p->in_flight) {
+        return;
+    }
+    p->in_flight = false;
+    p->stats.probes_lost++;
+    probe_failed(p, now_us);
+}
+
+void plpmtud_get_stats(const plpmtud_t *p, plpmtud_stats_t *stats) {
+    if (!p || !stats) {
+        return;
+    }
+    *stats = p->stats;
+}
+
+size_t plpmtud_encode(uint8_t kind, uint32_t id, uint16_t size, uint8_t *buf, size_t len) {
+    if (!buf || len < PLPMTUD_PROBE_HEADER) {
+        return 0;
+    }
+    buf[0] = kind;
+    for (int i = 0; i < 4; i++) {
+        buf[1 + i] = (uint8_t)(id >> (8 * i));
+    }
+    buf[5] = (uint8_t)size;
+    buf[6] = (uint8_t)(size >> 8);
+    memset(buf + PLPMTUD_PROBE_HEADER, 0, len - PLPMTUD_PROBE_HEADER);
+    return len;
+}
+
+int plpmtud_decode(const uint8_t *buf, size_t len, uint8_t *kind, uint32_t *id, uint16_t *size) {
+    if (!buf || !kind || !id || !size || len < PLPMTUD_PROBE_HEADER ||
+        (buf[0] != PLPMTUD_KIND_PROBE && buf[0] != PLPMTUD_KIND_ACK)) {
+        return -1;
+    }
+    *kind = buf[0];
+    *id = 0;
+    for (int i = 3; i >= 0; i--) {
+        *id = (*id << 8) | buf[1 + i];
+    }
+    *size = (uint16_t)(buf[5] | (buf[6] << 8));
+    return 0;
+}
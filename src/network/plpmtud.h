@@ -0,0 +1,123 @@
+/*
+ * plpmtud.h - Packetization layer path MTU discovery (RFC 8899)
+ *
+ * Finds the largest datagram that reaches a peer, so video chunks can
+ * use 8900-byte packets on a jumbo-frame LAN instead of paying the
+ * per-packet cost (header, AEAD tag, syscall share, receive wakeup) six
+ * times over, and so tunnelled links whose MTU is below the default
+ * packet size stop losing packets to DF drops.
+ *
+ * Probes go out with DF set and no kernel fragmentation
+ * (IP_PMTUDISC_PROBE); other traffic keeps the socket's default.  The
+ * sender pads PKT_PROBE packets to a candidate
+ * size; the receiver answers each with a small ack.  An acked size is
+ * validated and data may use it at once.  PLPMTUD_MAX_PROBES probes lost
+ * at a size (PLPMTUD_PROBE_TIMEOUT_US each) mean it does not fit.
+ *
+ * States:
+ *
+ *   BASE             Data uses the initial size (network.c: the
+ *                    BASE_PLPMTU of RFC 8899, PLPMTUD_MIN_SIZE), which is
+ *                    probed first.  If an initial size above the minimum
+ *                    fails, the PLPMTU drops to PLPMTUD_MIN_SIZE and the
+ *                    search covers the range below it.
+ *   SEARCHING        One probe at a time: the maximum first (a jumbo LAN
+ *                    is found in one round trip), then common link sizes
+ *                    inside the open range, then bisection until the
+ *                    range is narrower than PLPMTUD_SEARCH_STEP.
+ *   SEARCH_COMPLETE  The PLPMTU is confirmed every PLPMTUD_CONFIRM_US; a
+ *                    confirmation that fails PLPMTUD_MAX_PROBES times is
+ *                    a black hole and the search restarts from
+ *                    PLPMTUD_MIN_SIZE.  After PLPMTUD_RAISE_US the range
+ *                    above a PLPMTU below the maximum is searched again.
+ *
+ * Sizes are whole UDP payloads: packet header, ciphertext and MAC.
+ *
+ * Probe payload (PKT_PROBE, encrypted), little-endian:
+ *
+ *   offset  size  field
+ *   0       1     kind     PLPMTUD_KIND_PROBE or PLPMTUD_KIND_ACK
+ *   1       4     id       probe id (echoed by the ack)
+ *   5       2     size     probe datagram size (echoed by the ack)
+ *   7       n     padding  zeros, probes only
+ *
+ * Thread-safety: NOT thread-safe.
+ */
+
+#ifndef ROOTSTREAM_PLPMTUD_H
+#define ROOTSTREAM_PLPMTUD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PLPMTUD_MIN_SIZE 1200                  /* Fallback PLPMTU (IPv6 minimum MTU less headers) */
+#define PLPMTUD_MAX_PROBES 3                   /* Lost probes before a size counts as too big */
+#define PLPMTUD_PROBE_TIMEOUT_US 1000000ULL    /* Wait for an ack (RFC 8899: at least 1 s) */
+#define PLPMTUD_CONFIRM_US 10000000ULL         /* Re-probe of a settled PLPMTU */
+#define PLPMTUD_RAISE_US 600000000ULL          /* Search above a settled PLPMTU again */
+#define PLPMTUD_SEARCH_STEP 16                 /* Search ends when the range is narrower */
+#define PLPMTUD_PROBE_HEADER 7                 /* Probe payload without padding */
+
+#define PLPMTUD_KIND_PROBE 0
+#define PLPMTUD_KIND_ACK 1
+
+typedef enum {
+    PLPMTUD_BASE,
+    PLPMTUD_SEARCHING,
+    PLPMTUD_SEARCH_COMPLETE,
+} plpmtud_state_t;
+
+/* Statistics (monotonic since create) */
+typedef struct {
+    uint64_t probes_sent;
+    uint64_t probes_acked;
+    uint64_t probes_lost;  /* Timed out or rejected by the local stack */
+    uint64_t black_holes;  /* Confirmations that failed */
+} plpmtud_stats_t;
+
+typedef struct plpmtud_s plpmtud_t;
+
+/* Create a search starting at @initial (unconfirmed) that goes up to
+ * @max; PLPMTUD_MIN_SIZE <= initial <= max <= UINT16_MAX */
+plpmtud_t *plpmtud_create(size_t initial, size_t max);
+
+void plpmtud_destroy(plpmtud_t *p);
+
+/* Start over in BASE (new session) */
+void plpmtud_reset(plpmtud_t *p);
+
+/* Datagram size data packets may use */
+size_t plpmtud_size(const plpmtud_t *p);
+
+plpmtud_state_t plpmtud_state(const plpmtud_t *p);
+
+/* Size of the probe to send now, 0 if none is due; *probe_id receives
+ * its id.  Also expires the probe in flight. */
+size_t plpmtud_poll(plpmtud_t *p, uint64_t now_us, uint32_t *probe_id);
+
+/* An ack for @probe_id arrived.  Returns true if the PLPMTU grew. */
+bool plpmtud_on_ack(plpmtud_t *p, uint32_t probe_id, uint64_t now_us);
+
+/* The probe just polled could not be sent because it is larger than the
+ * local interface allows (EMSGSIZE): its size fails at once */
+void plpmtud_on_too_big(plpmtud_t *p, uint64_t now_us);
+
+void plpmtud_get_stats(const plpmtud_t *p, plpmtud_stats_t *stats);
+
+/* Write a probe payload of @len bytes (>= PLPMTUD_PROBE_HEADER; probes
+ * are zero-padded to len).  Returns len, 0 if it is too short. */
+size_t plpmtud_encode(uint8_t kind, uint32_t id, uint16_t size, uint8_t *buf, size_t len);
+
+/* Parse a probe payload; returns 0, or -1 if it is malformed */
+int plpmtud_decode(const uint8_t *buf, size_t len, uint8_t *kind, uint32_t *id, uint16_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_PLPMTUD_H */
@@ -0,0 +1,67 @@
+/*
+ * replay_window.c - Sliding-window replay protection implementation
+ *
+ * Bit (counter % REPLAY_WINDOW_BITS) records counter.  When the newest
+ * counter moves forward, the blocks it skips over (at most the whole
+ * ring) are zeroed before the new bit is set, so stale bits from a
+ * previous lap never read as "seen".  An all-zero window is a valid
+ * empty one.
+ */
+
+#include "replay_window.h"
+
+#include <string.h>
+
+#define BLOCKS (REPLAY_WINDOW_BITS / 64) /* Power of two: indices are masked */
+
+/*
+ * Forget everything (new session)
+ */
+void replay_window_reset(replay_window_t *w) {
+    memset(w, 0, sizeof(*w));
+}
+
+/*
+ * Would counter be accepted?
+ */
+bool replay_window_check(replay_window_t *w, uint64_t counter) {
+    if (!w->any || counter > w->newest) {
+        return true;
+    }
+    if (w->newest - counter >= REPLAY_WINDOW_SIZE ||
+        (w->bitmap[(counter >> 6) & (BLOCKS - 1)] >> (counter & 63)) & 1) {
+        w->rejected++;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Mark an authenticated counter as seen
+ */
+bool replay_window_update(replay_window_t *w, uint64_t counter) {
+    if (!w->any || counter > w->newest) {
+        if (w->any) {
+            uint64_t current = w->newest >> 6;
+            uint64_t skip = (counter >> 6) - current;
+            if (skip > BLOCKS) {
+                skip = BLOCKS;
+            }
+            for (uint64_t i = 1; i <= skip; i++) {
+                w->bitmap[(current + i) & (BLOCKS - 1)] = 0;
+            }
+        }
+        w->newest = counter;
+        w->any = true;
+    } else if (w->newest - counter >= REPLAY_WINDOW_SIZE) {
+        return false;
+    }
+
+    uint64_t *word = &w->bitmap[(counter >> 6) & (BLOCKS - 1)];
+    uint64_t bit = 1ULL << (counter & 63);
+    if (*word & bit) {
+        return false;
+    }
+    *word |= bit;
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+ * replay_window.h - Sliding-window replay protection for packet nonces
+ *
+ * Tracks which of the last REPLAY_WINDOW_SIZE nonce counters of a
+ * session have been accepted, RFC 6479 style: a ring of 64-bit blocks
+ * where advancing the window clears whole blocks and a lookup is one
+ * shift and one bit test.  Counters may arrive out of order anywhere
+ * inside the window; anything older, or seen before, is a replay.
+ *
+ * Call replay_window_check() before decrypting (cheap rejection) and
+ * replay_window_update() only once the packet has authenticated, so a
+ * forged nonce can never move the window.
+ *
+ * Not thread-safe: one receiver thread per window.
+ */
+
+#ifndef REPLAY_WINDOW_H
+#define REPLAY_WINDOW_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bitmap size.  A video frame's nonces are reserved up front and its
+ * chunks may be sent after later packets (fan-out lanes, audio), so the
+ * window has to span the largest frame: 8192 bits covers ~11 MB of
+ * 1400-byte chunks.  Must be a power of two. */
+#define REPLAY_WINDOW_BITS 8192
+
+/* Accepted distance behind the newest counter (one block is partial) */
+#define REPLAY_WINDOW_SIZE (REPLAY_WINDOW_BITS - 64)
+
+typedef struct {
+    uint64_t newest;                           /* Highest accepted counter */
+    bool any;                                  /* Anything accepted yet? */
+    uint64_t rejected;                         /* Replays and too-old counters */
+    uint64_t bitmap[REPLAY_WINDOW_BITS / 64];  /* Ring of seen bits */
+} replay_window_t;
+
+/* Forget everything (new session) */
+void replay_window_reset(replay_window_t *w);
+
+/* Would counter be accepted?  Counts a rejection if not. */
+bool replay_window_check(replay_window_t *w, uint64_t counter);
+
+/* Mark an authenticated counter as seen; returns false (and changes
+ * nothing) if it is a replay after all */
+bool replay_window_update(replay_window_t *w, uint64_t counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPLAY_WINDOW_H */
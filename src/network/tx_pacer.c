@@ -0,0 +1,430 @@
+/*
+ * tx_pacer.c - Paced UDP transmission implementation
+ *
+ * The timer thread never holds wake_lock while sending.  It clears
+ * `kick`, scans the flows without wake_lock, then re-takes it: if an
+ * enqueue set `kick` meanwhile it scans again, otherwise it publishes
+ * the deadline it will sleep to in `wake_at_us` and waits.  An enqueue
+ * whose departure is earlier than that deadline signals the condvar, so
+ * a packet for an idle flow never waits behind another flow's gap.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "tx_pacer.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "../ratelimit/token_bucket.h"
+#include "udp_batch.h"
+
+#define QUEUE_MASK (TX_PACER_QUEUE_PACKETS - 1)
+#define IDLE UINT64_MAX
+
+typedef struct {
+    uint64_t depart_us;
+    uint32_t len;
+} queued_t;
+
+typedef struct {
+    pthread_mutex_t lock; /* Everything below; held by the thread while sending */
+    bool open;
+    bool failed;
+    token_bucket_t *bucket; /* NULL: unpaced */
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    uint64_t last_depart_us;
+    uint32_t head; /* Next to send */
+    uint32_t tail; /* Next free */
+    queued_t queue[TX_PACER_QUEUE_PACKETS];
+    uint8_t *data;        /* TX_PACER_QUEUE_PACKETS × stride, kept across reopen */
+    size_t stride;        /* Bytes per queue slot */
+    size_t max_packet;    /* Largest packet accepted (≤ stride) */
+    double bytes_per_sec; /* Pacing rate, 0 = unpaced */
+} pacer_flow_t;
+
+struct tx_pacer_s {
+    int sock;
+    size_t max_packet;
+    int max_flows;
+    pacer_flow_t *flows;
+    udp_batch_t *batch; /* Timer thread only */
+
+    pthread_t thread;
+    bool started;
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake;
+    uint64_t wake_at_us; /* Deadline the thread sleeps to, IDLE = until kicked, 0 = awake */
+    bool kick;           /* Something was enqueued since the thread's last scan */
+    bool stop;
+
+    atomic_uint_fast64_t packets;
+    atomic_uint_fast64_t bytes;
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t send_errors;
+    atomic_uint_fast64_t wakeups;
+    atomic_uint_fast64_t max_late_us;
+};
+
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static pacer_flow_t *flow_get(tx_pacer_t *p, int flow) {
+    if (!p || flow < 0 || flow >= p->max_flows) {
+        return NULL;
+    }
+    return &p->flows[flow];
+}
+
+/*
+ * Send what is due on one flow; returns the next departure still
+ * queued, IDLE if the queue is empty.  Called with the flow locked.
+ */
+static uint64_t flow_send_due(tx_pacer_t *p, pacer_flow_t *f, uint64_t now_us) {
+    while (f->head != f->tail) {
+        size_t bytes = 0;
+        uint64_t late = 0;
+        int n = 0;
+        while (f->head + (uint32_t)n != f->tail && n < UDP_BATCH_MAX_PACKETS) {
+            uint32_t slot = (f->head + (uint32_t)n) & QUEUE_MASK;
+            const queued_t *q = &f->queue[slot];
+            if (q->depart_us > now_us + TX_PACER_SLACK_US) {
+                break;
+            }
+            if (now_us > q->depart_us && now_us - q->depart_us > late) {
+                late = now_us - q->depart_us;
+            }
+            udp_batch_add(p->batch, f->data + (size_t)slot * f->stride, q->len);
+            bytes += q->len;
+            n++;
+        }
+        if (n == 0) {
+            return f->queue[f->head & QUEUE_MASK].depart_us;
+        }
+
+        if (udp_batch_flush(p->batch, p->sock, (const struct sockaddr *)&f->addr,
+                            f->addr_len) < 0) {
+            f->failed = true;
+            atomic_fetch_add(&p->send_errors, 1);
+        } else {
+            atomic_fetch_add(&p->packets, (uint64_t)n);
+            atomic_fetch_add(&p->bytes, bytes);
+        }
+        if (late > atomic_load(&p->max_late_us)) {
+            atomic_store(&p->max_late_us, late);
+        }
+        f->head += (uint32_t)n;
+    }
+    return IDLE;
+}
+
+static void *pacer_thread(void *arg) {
+    tx_pacer_t *p = arg;
+#ifdef __linux__
+    /* Default timer slack (50 µs) is a large fraction of a packet gap */
+    prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+#endif
+
+    pthread_mutex_lock(&p->wake_lock);
+    while (!p->stop) {
+        p->kick = false;
+        p->wake_at_us = 0;
+        pthread_mutex_unlock(&p->wake_lock);
+
+        atomic_fetch_add(&p->wakeups, 1);
+        uint64_t next = IDLE;
+        for (int i = 0; i < p->max_flows; i++) {
+            pacer_flow_t *f = &p->flows[i];
+            pthread_mutex_lock(&f->lock);
+            if (f->open) {
+                uint64_t t = flow_send_due(p, f, mono_us());
+                if (t < next) {
+                    next = t;
+                }
+            }
+            pthread_mutex_unlock(&f->lock);
+        }
+
+        pthread_mutex_lock(&p->wake_lock);
+        if (p->kick || p->stop) {
+            continue;
+        }
+        p->wake_at_us = next;
+        if (next == IDLE) {
+            pthread_cond_wait(&p->wake, &p->wake_lock);
+        } else if (next > mono_us() + TX_PACER_SLACK_US) {
+            struct timespec ts = {.tv_sec = (time_t)(next / 1000000u),
+                                  .tv_nsec = (long)(next % 1000000u) * 1000};
+            pthread_cond_timedwait(&p->wake, &p->wake_lock, &ts);
+        }
+    }
+    pthread_mutex_unlock(&p->wake_lock);
+    return NULL;
+}
+
+tx_pacer_t *tx_pacer_create(int sock, int max_flows, size_t max_packet) {
+    if (max_flows <= 0 || max_packet == 0) {
+        return NULL;
+    }
+
+    tx_pacer_t *p = calloc(1, sizeof(tx_pacer_t));
+    if (!p) {
+        return NULL;
+    }
+    p->sock = sock;
+    p->max_packet = max_packet;
+    p->max_flows = max_flows;
+    p->flows = calloc((size_t)max_flows, sizeof(pacer_flow_t));
+    p->batch = udp_batch_create(true);
+    if (!p->flows || !p->batch) {
+        free(p->flows);
+        udp_batch_destroy(p->batch);
+        free(p);
+        return NULL;
+    }
+    for (int i = 0; i < max_flows; i++) {
+        pthread_mutex_init(&p->flows[i].lock, NULL);
+    }
+
+    /* Departure times are CLOCK_MONOTONIC, so is the wait */
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&p->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&p->wake_lock, NULL);
+
+    if (pthread_create(&p->thread, NULL, pacer_thread, p) != 0) {
+        tx_pacer_destroy(p);
+        return NULL;
+    }
+    p->started = true;
+    return p;
+}
+
+void tx_pacer_destroy(tx_pacer_t *p) {
+    if (!p) {
+        return;
+    }
+
+    if (p->started) {
+        pthread_mutex_lock(&p->wake_lock);
+        p->stop = true;
+        pthread_cond_signal(&p->wake);
+        pthread_mutex_unlock(&p->wake_lock);
+        pthread_join(p->thread, NULL);
+    }
+
+    for (int i = 0; i < p->max_flows; i++) {
+        pthread_mutex_destroy(&p->flows[i].lock);
+        token_bucket_destroy(p->flows[i].bucket);
+        free(p->flows[i].data);
+    }
+    pthread_cond_destroy(&p->wake);
+    pthread_mutex_destroy(&p->wake_lock);
+    udp_batch_destroy(p->batch);
+    free(p->flows);
+    free(p);
+}
+
+int tx_pacer_flow_open(tx_pacer_t *p, const struct sockaddr *addr, socklen_t addr_len) {
+    if (!p || !addr || addr_len == 0 || addr_len > sizeof(struct sockaddr_storage)) {
+        return -1;
+    }
+
+    for (int i = 0; i < p->max_flows; i++) {
+        pacer_flow_t *f = &p->flows[i];
+        pthread_mutex_lock(&f->lock);
+        if (f->open) {
+            pthread_mutex_unlock(&f->lock);
+            continue;
+        }
+        if (!f->data) {
+            f->data = malloc(TX_PACER_QUEUE_PACKETS * p->max_packet);
+            if (!f->data) {
+                pthread_mutex_unlock(&f->lock);
+                return -1;
+            }
+            f->stride = p->max_packet;
+        }
+        f->max_packet = p->max_packet;
+        memcpy(&f->addr, addr, addr_len);
+        f->addr_len = addr_len;
+        f->head = f->tail = 0;
+        f->last_depart_us = 0;
+        f->failed = false;
+        f->open = true;
+        pthread_mutex_unlock(&f->lock);
+        return i;
+    }
+    return -1;
+}
+
+void tx_pacer_flow_close(tx_pacer_t *p, int flow) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f) {
+        return;
+    }
+
+    pthread_mutex_lock(&f->lock);
+    f->open = false;
+    f->head = f->tail = 0;
+    token_bucket_destroy(f->bucket);
+    f->bucket = NULL;
+    f->bytes_per_sec = 0;
+    pthread_mutex_unlock(&f->lock);
+}
+
+void tx_pacer_set_rate(tx_pacer_t *p, int flow, uint64_t rate_bps) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f) {
+        return;
+    }
+
+    uint64_t now_us = mono_us();
+    double bytes_per_sec = (double)rate_bps / 8.0;
+    pthread_mutex_lock(&f->lock);
+    f->bytes_per_sec = bytes_per_sec;
+    if (rate_bps == 0) {
+        token_bucket_destroy(f->bucket);
+        f->bucket = NULL;
+    } else if (f->bucket) {
+        token_bucket_set_rate(f->bucket, bytes_per_sec, now_us);
+    } else {
+        f->bucket = token_bucket_create(
+            bytes_per_sec, (double)(TX_PACER_BURST_PACKETS * f->max_packet), now_us);
+    }
+    pthread_mutex_unlock(&f->lock);
+}
+
+int tx_pacer_set_max_packet(tx_pacer_t *p, int flow, size_t max_packet) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f || max_packet == 0) {
+        return -1;
+    }
+
+    int ret = 0;
+    pthread_mutex_lock(&f->lock);
+    if (max_packet > f->stride) {
+        /* Queued packets keep their slots in the wider queue */
+        uint8_t *data = malloc(TX_PACER_QUEUE_PACKETS * max_packet);
+        if (data) {
+            for (uint32_t i = f->head; i != f->tail; i++) {
+                uint32_t slot = i & QUEUE_MASK;
+                memcpy(data + (size_t)slot * max_packet, f->data + (size_t)slot * f->stride,
+                       f->queue[slot].len);
+            }
+            free(f->data);
+            f->data = data;
+            f->stride = max_packet;
+        } else {
+            ret = -1;
+        }
+    }
+    if (ret == 0 && max_packet != f->max_packet) {
+        f->max_packet = max_packet;
+        if (f->bucket) {
+            /* The bucket holds TX_PACER_BURST_PACKETS of the new size */
+            token_bucket_destroy(f->bucket);
+            f->bucket = token_bucket_create(
+                f->bytes_per_sec, (double)(TX_PACER_BURST_PACKETS * max_packet), mono_us());
+        }
+    }
+    pthread_mutex_unlock(&f->lock);
+    return ret;
+}
+
+int tx_pacer_enqueue(tx_pacer_t *p, int flow, const void *packet, size_t len,
+                     uint64_t *depart_us) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f || !packet || len == 0) {
+        return -1;
+    }
+
+    uint64_t now_us = mono_us();
+    pthread_mutex_lock(&f->lock);
+    if (len > f->max_packet) {
+        pthread_mutex_unlock(&f->lock);
+        return -1;
+    }
+    if (!f->open || f->tail - f->head == TX_PACER_QUEUE_PACKETS) {
+        pthread_mutex_unlock(&f->lock);
+        atomic_fetch_add(&p->dropped, 1);
+        return -1;
+    }
+
+    /* A rate cut may give a later packet an earlier slot; order wins */
+    uint64_t depart = f->bucket ? token_bucket_reserve(f->bucket, (double)len, now_us) : now_us;
+    if (depart < f->last_depart_us) {
+        depart = f->last_depart_us;
+    }
+    f->last_depart_us = depart;
+
+    uint32_t slot = f->tail & QUEUE_MASK;
+    memcpy(f->data + (size_t)slot * f->stride, packet, len);
+    f->queue[slot] = (queued_t){.depart_us = depart, .len = (uint32_t)len};
+    f->tail++;
+    pthread_mutex_unlock(&f->lock);
+
+    pthread_mutex_lock(&p->wake_lock);
+    p->kick = true;
+    if (depart < p->wake_at_us) {
+        pthread_cond_signal(&p->wake);
+    }
+    pthread_mutex_unlock(&p->wake_lock);
+
+    if (depart_us) {
+        *depart_us = depart;
+    }
+    return 0;
+}
+
+int tx_pacer_backlog(tx_pacer_t *p, int flow) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&f->lock);
+    int n = (int)(f->tail - f->head);
+    pthread_mutex_unlock(&f->lock);
+    return n;
+}
+
+bool tx_pacer_take_error(tx_pacer_t *p, int flow) {
+    pacer_flow_t *f = flow_get(p, flow);
+    if (!f) {
+        return false;
+    }
+
+    pthread_mutex_lock(&f->lock);
+    bool failed = f->failed;
+    f->failed = false;
+    pthread_mutex_unlock(&f->lock);
+    return failed;
+}
+
+void tx_pacer_get_stats(tx_pacer_t *p, tx_pacer_stats_t *stats) {
+    if (!p || !stats) {
+        return;
+    }
+    stats->packets = atomic_load(&p->packets);
+    stats->bytes = atomic_load(&p->bytes);
+    stats->dropped = atomic_load(&p->dropped);
+    stats->send_errors = atomic_load(&p->send_errors);
+    stats->wakeups = atomic_load(&p->wakeups);
+    stats->max_late_us = atomic_load(&p->max_late_us);
+}
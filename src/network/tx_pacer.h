@@ -0,0 +1,100 @@
+/*
+ * tx_pacer.h - Paced UDP transmission on a timer thread
+ *
+ * Spreads a flow's packets out at a set rate instead of handing a whole
+ * frame to the NIC at once.  A 300 KB keyframe sent back to back leaves
+ * as a line-rate micro-burst that overflows shallow switch and Wi-Fi
+ * buffers; paced at twice the video bitrate it becomes an evenly spaced
+ * train the bottleneck queue can absorb.
+ *
+ * Each flow (one destination) has a token bucket (ratelimit/
+ * token_bucket.h) and a FIFO of copied packets.  Enqueueing reserves
+ * the packet's bytes from the bucket, which gives it a departure time
+ * (earliest departure time pacing): a burst of TX_PACER_BURST_PACKETS
+ * leaves at once, the rest one packet every len / rate.  A single
+ * thread sleeps until the earliest head-of-queue departure over all
+ * flows (absolute CLOCK_MONOTONIC deadline, so lateness does not
+ * accumulate) and sends whatever is due with udp_batch.  Packets due
+ * within TX_PACER_SLACK_US of one another leave in the same sendmmsg.
+ *
+ * A flow with rate 0 is unpaced: its packets depart as soon as the
+ * thread gets to them.
+ *
+ * Thread-safety: all functions may be called from any thread.  Enqueues
+ * to one flow from several threads are serialized; their order is the
+ * order on the wire.
+ */
+
+#ifndef TX_PACER_H
+#define TX_PACER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TX_PACER_QUEUE_PACKETS 1024 /* Packets queued per flow; power of two */
+#define TX_PACER_BURST_PACKETS 4    /* Bucket depth in max-size packets */
+#define TX_PACER_SLACK_US 50        /* Packets due this soon leave with the due ones */
+
+/* Pacer statistics (monotonic since create) */
+typedef struct {
+    uint64_t packets;     /* Packets handed to the kernel */
+    uint64_t bytes;       /* Bytes handed to the kernel */
+    uint64_t dropped;     /* Enqueues refused because the flow's queue was full */
+    uint64_t send_errors; /* Failed flushes (their packets are lost) */
+    uint64_t wakeups;     /* Timer thread passes */
+    uint64_t max_late_us; /* Largest delay of a send past its departure time */
+} tx_pacer_stats_t;
+
+/* Pacer handle */
+typedef struct tx_pacer_s tx_pacer_t;
+
+/* Create a pacer sending on sock and start its thread.  max_packet
+ * bounds the packet size of a newly opened flow, max_flows the number
+ * of open flows. */
+tx_pacer_t *tx_pacer_create(int sock, int max_flows, size_t max_packet);
+
+/* Stop the thread and free the pacer (queued packets are dropped) */
+void tx_pacer_destroy(tx_pacer_t *p);
+
+/* Open an unpaced flow to addr; returns its index, or -1 if none is
+ * free or its queue cannot be allocated */
+int tx_pacer_flow_open(tx_pacer_t *p, const struct sockaddr *addr, socklen_t addr_len);
+
+/* Close a flow, dropping its queued packets */
+void tx_pacer_flow_close(tx_pacer_t *p, int flow);
+
+/* Pace the flow at rate_bps bits per second from now on (0 = unpaced) */
+void tx_pacer_set_rate(tx_pacer_t *p, int flow, uint64_t rate_bps);
+
+/* Accept packets up to max_packet bytes on the flow (its path MTU
+ * changed).  Growing reallocates the queue, keeping what is queued; the
+ * bucket depth follows.  Returns 0, or -1 if the queue cannot grow. */
+int tx_pacer_set_max_packet(tx_pacer_t *p, int flow, size_t max_packet);
+
+/* Copy a packet into the flow's queue.  *depart_us receives its
+ * departure time (CLOCK_MONOTONIC µs).  Returns 0, or -1 if the queue is
+ * full or the packet too large (it is dropped). */
+int tx_pacer_enqueue(tx_pacer_t *p, int flow, const void *packet, size_t len,
+                     uint64_t *depart_us);
+
+/* Packets queued on the flow and not yet sent */
+int tx_pacer_backlog(tx_pacer_t *p, int flow);
+
+/* True if a send on the flow failed since the last call */
+bool tx_pacer_take_error(tx_pacer_t *p, int flow);
+
+/* Statistics */
+void tx_pacer_get_stats(tx_pacer_t *p, tx_pacer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TX_PACER_H */
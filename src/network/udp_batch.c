@@ -0,0 +1,255 @@
+/*
+ * udp_batch.c - Batched UDP transmission implementation
+ *
+ * Message layout on Linux: every queued packet gets one iovec.  A message
+ * (mmsghdr) spans one or more consecutive iovecs; with GSO a message
+ * covers a run of packets that all share the first packet's length
+ * (the last may be shorter) and carries UDP_SEGMENT = that length.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* sendmmsg */
+#endif
+
+#include "udp_batch.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#define UDP_BATCH_HAVE_MMSG 1
+#endif
+
+/* Kernel limits for one GSO send: segment count and total datagram size */
+#define GSO_MAX_SEGMENTS 64
+#define GSO_MAX_BYTES 65000
+
+typedef enum {
+    GSO_UNKNOWN, /* Not probed yet */
+    GSO_ON,
+    GSO_OFF,
+} gso_state_t;
+
+struct udp_batch {
+    const void *data[UDP_BATCH_MAX_PACKETS];
+    size_t len[UDP_BATCH_MAX_PACKETS];
+    int count;
+
+    gso_state_t gso;
+    udp_batch_stats_t stats;
+
+#ifdef UDP_BATCH_HAVE_MMSG
+    struct iovec iov[UDP_BATCH_MAX_PACKETS];
+    struct mmsghdr msgs[UDP_BATCH_MAX_PACKETS];
+    int msg_first[UDP_BATCH_MAX_PACKETS + 1]; /* First packet index of each message */
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        size_t align; /* cmsghdr alignment */
+    } ctrl[UDP_BATCH_MAX_PACKETS];
+#endif
+};
+
+udp_batch_t *udp_batch_create(bool use_gso) {
+    udp_batch_t *batch = calloc(1, sizeof(udp_batch_t));
+    if (!batch) {
+        return NULL;
+    }
+    batch->gso = use_gso ? GSO_UNKNOWN : GSO_OFF;
+    return batch;
+}
+
+void udp_batch_destroy(udp_batch_t *batch) {
+    free(batch);
+}
+
+int udp_batch_add(udp_batch_t *batch, const void *data, size_t len) {
+    if (!batch || !data || len == 0 || batch->count >= UDP_BATCH_MAX_PACKETS) {
+        return -1;
+    }
+    batch->data[batch->count] = data;
+    batch->len[batch->count] = len;
+    return ++batch->count;
+}
+
+void udp_batch_clear(udp_batch_t *batch) {
+    if (batch) {
+        batch->count = 0;
+    }
+}
+
+int udp_batch_count(const udp_batch_t *batch) {
+    return batch ? batch->count : 0;
+}
+
+bool udp_batch_gso_active(const udp_batch_t *batch) {
+    return batch && batch->gso == GSO_ON;
+}
+
+void udp_batch_get_stats(const udp_batch_t *batch, udp_batch_stats_t *stats) {
+    if (!batch || !stats) {
+        return;
+    }
+    *stats = batch->stats;
+}
+
+#ifdef UDP_BATCH_HAVE_MMSG
+
+/* Build messages for packets [start, count); returns message count */
+static int build_messages(udp_batch_t *batch, int start, const struct sockaddr *addr,
+                          socklen_t addrlen) {
+    int nmsgs = 0;
+    int i = start;
+
+    while (i < batch->count) {
+        int first = i;
+        size_t seg = batch->len[first];
+        size_t total = seg;
+        i++;
+
+        /* Extend a GSO run while segments match (a shorter one ends it) */
+        if (batch->gso == GSO_ON) {
+            while (i < batch->count && i - first < GSO_MAX_SEGMENTS &&
+                   batch->len[i] <= seg && total + batch->len[i] <= GSO_MAX_BYTES) {
+                total += batch->len[i];
+                i++;
+                if (batch->len[i - 1] < seg) {
+                    break;
+                }
+            }
+        }
+
+        struct mmsghdr *m = &batch->msgs[nmsgs];
+        memset(&m->msg_hdr, 0, sizeof(m->msg_hdr));
+        m->msg_hdr.msg_name = (void *)addr;
+        m->msg_hdr.msg_namelen = addrlen;
+        m->msg_hdr.msg_iov = &batch->iov[first];
+        m->msg_hdr.msg_iovlen = (size_t)(i - first);
+        m->msg_len = 0;
+
+        if (i - first > 1) {
+            m->msg_hdr.msg_control = batch->ctrl[nmsgs].buf;
+            m->msg_hdr.msg_controllen = sizeof(batch->ctrl[nmsgs].buf);
+            struct cmsghdr *cm = CMSG_FIRSTHDR(&m->msg_hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t gso_size = (uint16_t)seg;
+            memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+        }
+
+        batch->msg_first[nmsgs] = first;
+        nmsgs++;
+    }
+
+    batch->msg_first[nmsgs] = batch->count;
+    return nmsgs;
+}
+
+static bool is_gso_error(int err) {
+    return err == EIO || err == EINVAL || err == EOPNOTSUPP || err == ENOPROTOOPT;
+}
+
+int udp_batch_flush(udp_batch_t *batch, int sock, const struct sockaddr *addr,
+                    socklen_t addrlen) {
+    if (!batch || sock < 0 || !addr) {
+        return -1;
+    }
+    if (batch->count == 0) {
+        return 0;
+    }
+
+    /* Probe once: getsockopt(UDP_SEGMENT) fails on kernels without UDP GSO */
+    if (batch->gso == GSO_UNKNOWN) {
+        int val = 0;
+        socklen_t vlen = sizeof(val);
+        batch->gso = getsockopt(sock, SOL_UDP, UDP_SEGMENT, &val, &vlen) == 0 ? GSO_ON : GSO_OFF;
+    }
+
+    for (int i = 0; i < batch->count; i++) {
+        batch->iov[i].iov_base = (void *)batch->data[i];
+        batch->iov[i].iov_len = batch->len[i];
+    }
+
+    batch->stats.flushes++;
+    int start = 0;
+    int sent = 0;
+
+    while (start < batch->count) {
+        int nmsgs = build_messages(batch, start, addr, addrlen);
+        int r = sendmmsg(sock, batch->msgs, (unsigned int)nmsgs, 0);
+        batch->stats.syscalls++;
+
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (batch->gso == GSO_ON && is_gso_error(errno)) {
+                /* Device or path cannot segment: resend the rest unbatched */
+                batch->gso = GSO_OFF;
+                batch->stats.gso_fallbacks++;
+                continue;
+            }
+            batch->count = 0;
+            return -1;
+        }
+
+        for (int m = 0; m < r; m++) {
+            if (batch->msgs[m].msg_hdr.msg_iovlen > 1) {
+                batch->stats.gso_messages++;
+            }
+            batch->stats.bytes += batch->msgs[m].msg_len;
+        }
+
+        int next = batch->msg_first[r];
+        batch->stats.packets += (uint64_t)(next - start);
+        sent += next - start;
+        start = next;
+    }
+
+    batch->count = 0;
+    return sent;
+}
+
+#else /* !UDP_BATCH_HAVE_MMSG */
+
+int udp_batch_flush(udp_batch_t *batch, int sock, const struct sockaddr *addr,
+                    socklen_t addrlen) {
+    if (!batch || sock < 0 || !addr) {
+        return -1;
+    }
+
+    int sent = 0;
+    if (batch->count > 0) {
+        batch->stats.flushes++;
+    }
+
+    for (int i = 0; i < batch->count; i++) {
+        ssize_t r = sendto(sock, batch->data[i], batch->len[i], 0, addr, addrlen);
+        batch->stats.syscalls++;
+        if (r < 0) {
+            batch->count = 0;
+            return -1;
+        }
+        batch->stats.packets++;
+        batch->stats.bytes += (uint64_t)r;
+        sent++;
+    }
+
+    batch->count = 0;
+    return sent;
+}
+
+#endif /* UDP_BATCH_HAVE_MMSG */
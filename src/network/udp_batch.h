@@ -0,0 +1,76 @@
+/*
+ * udp_batch.h - Batched UDP transmission (sendmmsg + UDP GSO)
+ *
+ * Collects already-encrypted packets for one destination and sends them
+ * with as few syscalls as possible.  On Linux the batch is flushed with a
+ * single sendmmsg(); runs of equal-sized packets are additionally folded
+ * into one UDP_SEGMENT (GSO) message each, so the kernel segments them
+ * instead of walking the stack once per packet.  If the kernel or device
+ * rejects GSO the batch falls back to one message per packet, and on
+ * platforms without sendmmsg to one sendto() per packet.
+ *
+ * Packets are referenced, not copied: buffers passed to udp_batch_add()
+ * must stay valid until the next udp_batch_flush().
+ */
+
+#ifndef UDP_BATCH_H
+#define UDP_BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UDP_BATCH_MAX_PACKETS 64 /* Packets per flush */
+
+/* Batch statistics (monotonic since create) */
+typedef struct {
+    uint64_t packets;       /* Packets handed to the kernel */
+    uint64_t bytes;         /* Payload bytes handed to the kernel */
+    uint64_t syscalls;      /* sendmmsg/sendmsg/sendto calls */
+    uint64_t flushes;       /* Non-empty flushes */
+    uint64_t gso_messages;  /* Messages carrying a UDP_SEGMENT control */
+    uint64_t gso_fallbacks; /* Times GSO was disabled after a kernel error */
+} udp_batch_stats_t;
+
+/* Batch handle */
+typedef struct udp_batch udp_batch_t;
+
+/* Create batch; use_gso requests UDP_SEGMENT when the kernel supports it */
+udp_batch_t *udp_batch_create(bool use_gso);
+
+/* Destroy batch (queued packets are dropped) */
+void udp_batch_destroy(udp_batch_t *batch);
+
+/* Queue a packet; returns queued count, or -1 if the batch is full */
+int udp_batch_add(udp_batch_t *batch, const void *data, size_t len);
+
+/* Drop queued packets without sending them */
+void udp_batch_clear(udp_batch_t *batch);
+
+/* Number of queued packets */
+int udp_batch_count(const udp_batch_t *batch);
+
+/* Send all queued packets to addr; returns packets sent, -1 on error.
+ * The batch is empty afterwards either way. */
+int udp_batch_flush(udp_batch_t *batch, int sock, const struct sockaddr *addr,
+                    socklen_t addrlen);
+
+/* True once a flush has sent with GSO (false before the first probe) */
+bool udp_batch_gso_active(const udp_batch_t *batch);
+
+/* Statistics */
+void udp_batch_get_stats(const udp_batch_t *batch, udp_batch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UDP_BATCH_H */
@@ -0,0 +1,265 @@
+/*
+ * udp_rx.c - Batched UDP receive implementation
+ *
+ * Linux: the socket is registered with a private epoll instance and
+ * drained with recvmmsg(MSG_DONTWAIT) into UDP_RX_MAX_BATCH fixed
+ * buffers.  Each message carries room for two control messages: the
+ * socket's cumulative drop counter at enqueue time (SO_RXQ_OVFL) and the
+ * receive timestamp (SO_TIMESTAMPNS).
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* recvmmsg */
+#endif
+
+#include "udp_rx.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <time.h>
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+#define UDP_RX_HAVE_MMSG 1
+#endif
+
+struct udp_rx {
+    int sock;
+    int batch;
+    size_t buf_size;
+    uint8_t *buffers; /* batch × buf_size, one allocation */
+    udp_rx_packet_t packets[UDP_RX_MAX_BATCH];
+    int count;
+    udp_rx_stats_t stats;
+
+#ifdef UDP_RX_HAVE_MMSG
+    int epfd;
+    struct iovec iov[UDP_RX_MAX_BATCH];
+    struct mmsghdr msgs[UDP_RX_MAX_BATCH];
+    union {
+        char buf[CMSG_SPACE(sizeof(uint32_t)) + CMSG_SPACE(sizeof(struct timespec))];
+        size_t align; /* cmsghdr alignment */
+    } ctrl[UDP_RX_MAX_BATCH];
+#endif
+};
+
+udp_rx_t *udp_rx_create(int sock, int batch, size_t buf_size) {
+    if (sock < 0 || buf_size == 0) {
+        return NULL;
+    }
+    if (batch < 1) {
+        batch = 1;
+    }
+    if (batch > UDP_RX_MAX_BATCH) {
+        batch = UDP_RX_MAX_BATCH;
+    }
+
+    udp_rx_t *rx = calloc(1, sizeof(udp_rx_t));
+    if (!rx) {
+        return NULL;
+    }
+    rx->sock = sock;
+    rx->batch = batch;
+    rx->buf_size = buf_size;
+    rx->buffers = malloc((size_t)batch * buf_size);
+    if (!rx->buffers) {
+        free(rx);
+        return NULL;
+    }
+    for (int i = 0; i < batch; i++) {
+        rx->packets[i].data = rx->buffers + (size_t)i * buf_size;
+    }
+
+#ifdef UDP_RX_HAVE_MMSG
+    rx->epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = sock};
+    if (rx->epfd < 0 || epoll_ctl(rx->epfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+        if (rx->epfd >= 0) {
+            close(rx->epfd);
+        }
+        free(rx->buffers);
+        free(rx);
+        return NULL;
+    }
+
+    /* Drop reporting and timestamps are optional; ignore kernels without them */
+    int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on));
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+#endif
+
+    return rx;
+}
+
+void udp_rx_destroy(udp_rx_t *rx) {
+    if (!rx) {
+        return;
+    }
+#ifdef UDP_RX_HAVE_MMSG
+    close(rx->epfd);
+#endif
+    free(rx->buffers);
+    free(rx);
+}
+
+udp_rx_packet_t *udp_rx_packet(udp_rx_t *rx, int i) {
+    if (!rx || i < 0 || i >= rx->count) {
+        return NULL;
+    }
+    return &rx->packets[i];
+}
+
+int udp_rx_batch_size(const udp_rx_t *rx) {
+    return rx ? rx->batch : 0;
+}
+
+void udp_rx_get_stats(const udp_rx_t *rx, udp_rx_stats_t *stats) {
+    if (!rx || !stats) {
+        return;
+    }
+    *stats = rx->stats;
+}
+
+#ifdef UDP_RX_HAVE_MMSG
+
+int udp_rx_wait(udp_rx_t *rx, int timeout_ms) {
+    if (!rx) {
+        return -1;
+    }
+
+    struct epoll_event ev;
+    int n;
+    do {
+        n = epoll_wait(rx->epfd, &ev, 1, timeout_ms);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0) {
+        rx->stats.wakeups++;
+    }
+    return n < 0 ? -1 : (n > 0);
+}
+
+int udp_rx_recv(udp_rx_t *rx) {
+    if (!rx) {
+        return -1;
+    }
+    rx->count = 0;
+
+    for (int i = 0; i < rx->batch; i++) {
+        struct mmsghdr *m = &rx->msgs[i];
+        rx->iov[i].iov_base = rx->packets[i].data;
+        rx->iov[i].iov_len = rx->buf_size;
+        memset(&m->msg_hdr, 0, sizeof(m->msg_hdr));
+        m->msg_hdr.msg_name = &rx->packets[i].from;
+        m->msg_hdr.msg_namelen = sizeof(rx->packets[i].from);
+        m->msg_hdr.msg_iov = &rx->iov[i];
+        m->msg_hdr.msg_iovlen = 1;
+        m->msg_hdr.msg_control = rx->ctrl[i].buf;
+        m->msg_hdr.msg_controllen = sizeof(rx->ctrl[i].buf);
+        m->msg_len = 0;
+    }
+
+    int n;
+    do {
+        n = recvmmsg(rx->sock, rx->msgs, (unsigned int)rx->batch, MSG_DONTWAIT, NULL);
+        rx->stats.syscalls++;
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct msghdr *h = &rx->msgs[i].msg_hdr;
+        rx->packets[i].len = rx->msgs[i].msg_len;
+        rx->packets[i].fromlen = h->msg_namelen;
+        rx->packets[i].rx_time_us = 0;
+        rx->stats.bytes += rx->msgs[i].msg_len;
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(h); cm; cm = CMSG_NXTHDR(h, cm)) {
+            if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops;
+                memcpy(&drops, CMSG_DATA(cm), sizeof(drops));
+                if (drops > rx->stats.kernel_drops) {
+                    rx->stats.kernel_drops = drops;
+                }
+            } else if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+                rx->packets[i].rx_time_us =
+                    (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+            }
+        }
+    }
+
+    rx->count = n;
+    rx->stats.packets += (uint64_t)n;
+    if (n == rx->batch) {
+        rx->stats.full_batches++;
+    }
+    return n;
+}
+
+#else /* !UDP_RX_HAVE_MMSG */
+
+int udp_rx_wait(udp_rx_t *rx, int timeout_ms) {
+    if (!rx) {
+        return -1;
+    }
+
+    struct pollfd pfd = {.fd = rx->sock, .events = POLLIN, .revents = 0};
+    int n;
+    do {
+        n = poll(&pfd, 1, timeout_ms);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0) {
+        rx->stats.wakeups++;
+    }
+    return n < 0 ? -1 : (n > 0);
+}
+
+int udp_rx_recv(udp_rx_t *rx) {
+    if (!rx) {
+        return -1;
+    }
+    rx->count = 0;
+    bool failed = false;
+
+    while (rx->count < rx->batch) {
+        udp_rx_packet_t *p = &rx->packets[rx->count];
+        p->fromlen = sizeof(p->from);
+        ssize_t r = recvfrom(rx->sock, p->data, rx->buf_size, MSG_DONTWAIT,
+                             (struct sockaddr *)&p->from, &p->fromlen);
+        rx->stats.syscalls++;
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            failed = errno != EAGAIN && errno != EWOULDBLOCK;
+            break;
+        }
+        p->len = (size_t)r;
+        p->rx_time_us = 0;
+        rx->stats.bytes += (uint64_t)r;
+        rx->count++;
+    }
+
+    rx->stats.packets += (uint64_t)rx->count;
+    if (rx->count == rx->batch) {
+        rx->stats.full_batches++;
+    }
+    return (failed && rx->count == 0) ? -1 : rx->count;
+}
+
+#endif /* UDP_RX_HAVE_MMSG */
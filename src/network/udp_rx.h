@@ -0,0 +1,85 @@
+/*
+ * udp_rx.h - Batched UDP receive (epoll + recvmmsg)
+ *
+ * Owns a preallocated ring of packet buffers for one UDP socket.  A
+ * receive cycle is udp_rx_wait() (blocks on epoll with the caller's real
+ * timeout) followed by udp_rx_recv() calls, each of which drains up to
+ * UDP_RX_MAX_BATCH datagrams with a single recvmmsg().  Received packets
+ * stay valid until the next udp_rx_recv().
+ *
+ * Where supported the socket reports kernel receive-queue drops
+ * (SO_RXQ_OVFL), exposed as stats.kernel_drops, and stamps each
+ * datagram with its kernel receive time (SO_TIMESTAMPNS), which does not
+ * depend on when the receiver thread got around to it.  Platforms without
+ * epoll/recvmmsg fall back to poll() and one recvfrom() per datagram.
+ *
+ * Not thread-safe: one receiver thread per handle.
+ */
+
+#ifndef UDP_RX_H
+#define UDP_RX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UDP_RX_MAX_BATCH 64 /* Datagrams per recvmmsg */
+
+/* Receive statistics (monotonic since create) */
+typedef struct {
+    uint64_t packets;      /* Datagrams received */
+    uint64_t bytes;        /* Payload bytes received */
+    uint64_t syscalls;     /* recvmmsg/recvfrom calls (including empty ones) */
+    uint64_t wakeups;      /* udp_rx_wait calls that found data */
+    uint64_t full_batches; /* Receives that filled the whole batch */
+    uint64_t kernel_drops; /* Datagrams dropped by the kernel (SO_RXQ_OVFL) */
+} udp_rx_stats_t;
+
+/* One received datagram */
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    struct sockaddr_storage from;
+    socklen_t fromlen;
+    uint64_t rx_time_us; /* Kernel receive time (CLOCK_REALTIME), 0 = unknown */
+} udp_rx_packet_t;
+
+/* Receiver handle */
+typedef struct udp_rx udp_rx_t;
+
+/* Create receiver for sock with batch packets of buf_size bytes each
+ * (batch is clamped to 1..UDP_RX_MAX_BATCH) */
+udp_rx_t *udp_rx_create(int sock, int batch, size_t buf_size);
+
+/* Destroy receiver (the socket itself is not closed) */
+void udp_rx_destroy(udp_rx_t *rx);
+
+/* Wait up to timeout_ms for data (0 = poll, <0 = forever);
+ * returns 1 if readable, 0 on timeout, -1 on error */
+int udp_rx_wait(udp_rx_t *rx, int timeout_ms);
+
+/* Receive without blocking; returns datagrams received (0 if none), -1 on error */
+int udp_rx_recv(udp_rx_t *rx);
+
+/* Datagram i of the last udp_rx_recv() */
+udp_rx_packet_t *udp_rx_packet(udp_rx_t *rx, int i);
+
+/* Batch size in datagrams */
+int udp_rx_batch_size(const udp_rx_t *rx);
+
+/* Statistics */
+void udp_rx_get_stats(const udp_rx_t *rx, udp_rx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UDP_RX_H */
@@ -40,6 +40,20 @@ int rootstream_net_send_video(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t
     return -1;
 }
 
+int rootstream_net_send_video_all(rootstream_ctx_t *ctx, const uint8_t *data, size_t size,
+                                  uint64_t timestamp_us, bool keyframe) {
+    (void)ctx;
+    (void)data;
+    (void)size;
+    (void)timestamp_us;
+    (void)keyframe;
+    return 0;
+}
+
+void rootstream_net_flush_video(rootstream_ctx_t *ctx) {
+    (void)ctx;
+}
+
 int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
     (void)ctx;
     (void)timeout_ms;
@@ -47,6 +61,10 @@ int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
     return -1;
 }
 
+void rootstream_net_cleanup(rootstream_ctx_t *ctx) {
+    (void)ctx;
+}
+
 int rootstream_net_validate_packet(const uint8_t *buffer, size_t len) {
     (void)buffer;
     (void)len;
@@ -136,6 +154,11 @@ bool rootstream_net_tcp_is_healthy(peer_t *peer) {
     return false;
 }
 
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer) {
+    (void)peer;
+    return RS_INVALID_SOCKET;
+}
+
 int peer_reconnect_init(peer_t *peer) {
     (void)peer;
     return 0;
@@ -200,18 +200,16 @@ int rootstream_net_tcp_recv(rootstream_ctx_t *ctx, peer_t *peer, uint8_t *buffer
             tcp->connected = false;
             return -1;
         }
-        return 0; /* No data available */
-    }
-
-    if (ret == 0) {
+        /* No new data, but an earlier read may have buffered a packet */
+    } else if (ret == 0) {
         /* Connection closed */
         fprintf(stderr, "WARNING: TCP peer closed connection\n");
         tcp->connected = false;
         return -1;
+    } else {
+        tcp->read_offset += ret;
     }
 
-    tcp->read_offset += ret;
-
     /* Try to extract a complete packet */
     if (tcp->read_offset < sizeof(packet_header_t)) {
         return 0; /* Need more data */
@@ -252,6 +250,17 @@ void rootstream_net_tcp_cleanup(peer_t *peer) {
     peer->transport_priv = NULL;
 }
 
+/*
+ * Socket of a TCP peer, for callers that wait on it alongside the UDP
+ * socket (RS_INVALID_SOCKET if the peer has no TCP connection)
+ */
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer) {
+    if (!peer || !peer->transport_priv)
+        return RS_INVALID_SOCKET;
+    const tcp_peer_ctx_t *tcp = (const tcp_peer_ctx_t *)peer->transport_priv;
+    return tcp->connected ? tcp->fd : RS_INVALID_SOCKET;
+}
+
 /*
  * Check TCP connection health
  */
@@ -19,6 +19,8 @@
 
 #ifdef HAVE_NVENC
 
+#include "colorconv/colorconv.h"
+
 #include <dlfcn.h>
 
 /* NVENC SDK headers */
@@ -41,6 +43,11 @@ typedef struct {
     void *output_buffer;
     NV_ENC_REGISTERED_PTR registered_resource;
 
+    /* Host-side RGBA/BGRA → NV12 staging (1.5 B/px upload instead of 4) */
+    colorconv_t *cc;
+    uint8_t *nv12;
+    colorconv_image_t nv12_img;
+
     /* Configuration */
     int width;
     int height;
@@ -391,11 +398,30 @@ int rootstream_encoder_init_nvenc(rootstream_ctx_t *ctx, codec_type_t codec) {
         return -1;
     }
 
+    /* Frames are converted to NV12 on the CPU and uploaded as one
+     * pitch-linear block: Y rows, then interleaved UV rows */
+    size_t frame_size = colorconv_image_size(COLORCONV_NV12, nv->width, nv->height);
+    nv->cc = colorconv_create(colorconv_matrix_for_height(nv->height), COLORCONV_RANGE_LIMITED, 0);
+    nv->nv12 = malloc(frame_size);
+    if (!nv->cc || !nv->nv12) {
+        fprintf(stderr, "ERROR: Cannot allocate NV12 staging buffer\n");
+        colorconv_destroy(nv->cc);
+        free(nv->nv12);
+        nv->nvenc_api.nvEncDestroyEncoder(nv->encoder);
+        dlclose(nv->nvenc_lib);
+        cuCtxDestroy(nv->cuda_ctx);
+        dlclose(nv->cuda_lib);
+        free(nv);
+        return -1;
+    }
+    colorconv_image_init(&nv->nv12_img, COLORCONV_NV12, nv->width, nv->height, nv->nv12);
+
     /* Create input buffer (in CUDA device memory) */
-    size_t frame_size = nv->width * nv->height * 4; /* RGBA */
     cu_status = cuMemAlloc((CUdeviceptr *)&nv->input_buffer, frame_size);
     if (cu_status != CUDA_SUCCESS) {
         fprintf(stderr, "ERROR: cuMemAlloc failed for input buffer: %d\n", cu_status);
+        colorconv_destroy(nv->cc);
+        free(nv->nv12);
         nv->nvenc_api.nvEncDestroyEncoder(nv->encoder);
         dlclose(nv->nvenc_lib);
         cuCtxDestroy(nv->cuda_ctx);
@@ -411,13 +437,15 @@ int rootstream_encoder_init_nvenc(rootstream_ctx_t *ctx, codec_type_t codec) {
     register_params.resourceToRegister = nv->input_buffer;
     register_params.width = nv->width;
     register_params.height = nv->height;
-    register_params.pitch = nv->width * 4;
-    register_params.bufferFormat = NV_ENC_BUFFER_FORMAT_ABGR;
+    register_params.pitch = nv->nv12_img.stride[0];
+    register_params.bufferFormat = NV_ENC_BUFFER_FORMAT_NV12;
 
     status = nv->nvenc_api.nvEncRegisterResource(nv->encoder, &register_params);
     if (status != NV_ENC_SUCCESS) {
         fprintf(stderr, "ERROR: nvEncRegisterResource failed: %d\n", status);
         cuMemFree((CUdeviceptr)nv->input_buffer);
+        colorconv_destroy(nv->cc);
+        free(nv->nv12);
         nv->nvenc_api.nvEncDestroyEncoder(nv->encoder);
         dlclose(nv->nvenc_lib);
         cuCtxDestroy(nv->cuda_ctx);
@@ -437,6 +465,8 @@ int rootstream_encoder_init_nvenc(rootstream_ctx_t *ctx, codec_type_t codec) {
         fprintf(stderr, "ERROR: nvEncCreateBitstreamBuffer failed: %d\n", status);
         nv->nvenc_api.nvEncUnregisterResource(nv->encoder, nv->registered_resource);
         cuMemFree((CUdeviceptr)nv->input_buffer);
+        colorconv_destroy(nv->cc);
+        free(nv->nv12);
         nv->nvenc_api.nvEncDestroyEncoder(nv->encoder);
         dlclose(nv->nvenc_lib);
         cuCtxDestroy(nv->cuda_ctx);
@@ -483,16 +513,34 @@ int rootstream_encode_frame_nvenc(rootstream_ctx_t *ctx, frame_buffer_t *in, uin
         return -1;
     }
 
-    /* Upload frame to CUDA device memory */
+    const uint8_t *pixels = frame_buffer_pixels(in);
+    if (!pixels) {
+        fprintf(stderr, "ERROR: Frame has no CPU-readable pixels\n");
+        return -1;
+    }
+
+    /* Convert to NV12 on the host */
+    colorconv_image_t src;
+    colorconv_image_init(&src, in->format == FRAME_FORMAT_BGRA ? COLORCONV_BGRA : COLORCONV_RGBA,
+                         (int)in->width, (int)in->height, (uint8_t *)pixels);
+    if (in->pitch) {
+        src.stride[0] = (int)in->pitch;
+    }
+    if (colorconv_convert(nv->cc, &src, &nv->nv12_img) != 0) {
+        fprintf(stderr, "ERROR: Cannot convert %ux%u frame to NV12\n", in->width, in->height);
+        return -1;
+    }
+
+    /* Upload Y and UV rows to CUDA device memory in one copy */
     CUDA_MEMCPY2D copy_params = {0};
     copy_params.srcMemoryType = CU_MEMORYTYPE_HOST;
-    copy_params.srcHost = in->data;
-    copy_params.srcPitch = in->pitch;
+    copy_params.srcHost = nv->nv12;
+    copy_params.srcPitch = nv->nv12_img.stride[0];
     copy_params.dstMemoryType = CU_MEMORYTYPE_DEVICE;
     copy_params.dstDevice = (CUdeviceptr)nv->input_buffer;
-    copy_params.dstPitch = nv->width * 4;
-    copy_params.WidthInBytes = nv->width * 4;
-    copy_params.Height = nv->height;
+    copy_params.dstPitch = nv->nv12_img.stride[0];
+    copy_params.WidthInBytes = nv->nv12_img.stride[0];
+    copy_params.Height = nv->height + (nv->height + 1) / 2;
 
     CUresult cu_status = cuMemcpy2D(&copy_params);
     if (cu_status != CUDA_SUCCESS) {
@@ -512,10 +560,7 @@ int rootstream_encode_frame_nvenc(rootstream_ctx_t *ctx, frame_buffer_t *in, uin
     }
 
     /* Check if we should force a keyframe */
-    bool force_idr = ctx->encoder.force_keyframe;
-    if (force_idr) {
-        ctx->encoder.force_keyframe = false; /* Reset the flag */
-    }
+    bool force_idr = encoder_take_keyframe(&ctx->encoder);
 
     /* Encode frame */
     NV_ENC_PIC_PARAMS pic_params = {0};
@@ -600,6 +645,9 @@ void rootstream_encoder_cleanup_nvenc(rootstream_ctx_t *ctx) {
         cuMemFree((CUdeviceptr)nv->input_buffer);
     }
 
+    colorconv_destroy(nv->cc);
+    free(nv->nv12);
+
     if (nv->encoder && nv->nvenc_api.nvEncDestroyEncoder) {
         nv->nvenc_api.nvEncDestroyEncoder(nv->encoder);
     }
@@ -0,0 +1,436 @@
+/*
+ * client_pipeline.c — Staged receive → decode → present client pipeline
+ *
+ * Bitstream buffers circulate between the two stage threads through a
+ * pair of SPSC queues, as in host_pipeline.c:
+ *
+ *   recv_free ──▶ network ──recv_q──▶ decode ──▶ recv_free
+ *
+ * Decoded frames cannot follow the same scheme: once handed out they
+ * may be released from any thread, in any order.  They are recycled
+ * through a mutex-protected free list instead, fed by the last
+ * client_frame_release() of each frame.  A frame evicted from the
+ * presentation queue is released by the decode thread that pushed.
+ *
+ * The pipeline itself is freed by whichever comes last: destroy, or the
+ * release of the last frame the caller still held.
+ */
+
+#include "client_pipeline.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "frame_queue.h"
+
+#define CLIENT_KEYFRAME_REQUEST_MS 250 /* Min interval between keyframe requests */
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    uint64_t received_us; /* Taken off the reassembler */
+} recv_slot_t;
+
+struct client_frame_s {
+    rs_video_frame_t view;
+    frame_buffer_t decoded;
+    client_pipeline_t *owner;
+    atomic_int refs;
+    bool handed_out; /* Counted in held until the last release */
+    uint64_t decode_end_us;
+};
+
+struct client_pipeline_s {
+    rootstream_ctx_t *ctx;
+    client_pipeline_tick_fn tick;
+    void *tick_user;
+
+    fq_queue_t *recv_q;
+    fq_queue_t *recv_free;
+    fq_queue_t *present_q;
+
+    recv_slot_t *recv_slots;
+    int recv_count;
+
+    client_frame_t *frames;
+    int frame_count;
+    frame_buffer_t scratch; /* Decoder output while every frame is held */
+
+    pthread_mutex_t free_lock;
+    client_frame_t **free_frames;
+    int free_count;
+    bool destroyed;
+
+    pthread_t net_thread;
+    pthread_t decode_thread;
+    bool net_started;
+    bool decode_started;
+    atomic_int stop;
+
+    uint64_t last_keyframe_req_ms; /* Network thread only */
+
+    _Atomic uint64_t received;
+    _Atomic uint64_t receive_dropped;
+    _Atomic uint64_t decoded;
+    _Atomic uint64_t decode_errors;
+    _Atomic uint64_t present_dropped;
+    _Atomic uint64_t presented;
+    _Atomic uint32_t held;
+    _Atomic uint32_t queue_wait_us;
+    _Atomic uint32_t decode_us;
+    _Atomic uint32_t present_wait_us;
+};
+
+/* Running mean over roughly the last 8 samples; one writer per field */
+static void ewma_update(_Atomic uint32_t *avg, uint64_t sample_us) {
+    int64_t sample = sample_us > UINT32_MAX ? (int64_t)UINT32_MAX : (int64_t)sample_us;
+    int64_t cur = (int64_t)atomic_load_explicit(avg, memory_order_relaxed);
+    int64_t next = cur == 0 ? sample : cur + (sample - cur) / 8;
+    atomic_store_explicit(avg, (uint32_t)next, memory_order_relaxed);
+}
+
+static void free_pipeline(client_pipeline_t *p) {
+    if (p->recv_slots) {
+        for (int i = 0; i < p->recv_count; i++)
+            free(p->recv_slots[i].data);
+        free(p->recv_slots);
+    }
+    if (p->frames) {
+        for (int i = 0; i < p->frame_count; i++)
+            free(p->frames[i].decoded.data);
+        free(p->frames);
+    }
+    free(p->scratch.data);
+    free(p->free_frames);
+    fq_queue_destroy(p->recv_q);
+    fq_queue_destroy(p->recv_free);
+    fq_queue_destroy(p->present_q);
+    pthread_mutex_destroy(&p->free_lock);
+    free(p);
+}
+
+/* Return a frame with no references left to the free list */
+static void recycle_frame(client_pipeline_t *p, client_frame_t *f) {
+    pthread_mutex_lock(&p->free_lock);
+    p->free_frames[p->free_count++] = f;
+    bool last = p->destroyed && p->free_count == p->frame_count;
+    pthread_mutex_unlock(&p->free_lock);
+
+    if (last)
+        free_pipeline(p);
+}
+
+static client_frame_t *take_free_frame(client_pipeline_t *p) {
+    client_frame_t *f = NULL;
+    pthread_mutex_lock(&p->free_lock);
+    if (p->free_count > 0)
+        f = p->free_frames[--p->free_count];
+    pthread_mutex_unlock(&p->free_lock);
+    return f;
+}
+
+/* A frame the decoder needs was lost; restart the GOP (rate limited) */
+static void request_keyframe(client_pipeline_t *p) {
+    rootstream_ctx_t *ctx = p->ctx;
+    uint64_t now = get_timestamp_ms();
+    if (now - p->last_keyframe_req_ms < CLIENT_KEYFRAME_REQUEST_MS)
+        return;
+    p->last_keyframe_req_ms = now;
+
+    for (int i = 0; i < ctx->num_peers; i++) {
+        if (ctx->peers[i].state == PEER_CONNECTED)
+            rootstream_request_keyframe(ctx, &ctx->peers[i]);
+    }
+}
+
+/* Copy ctx->current_frame out of the reassembler and queue it for decode */
+static void queue_received_frame(client_pipeline_t *p, recv_slot_t **spare) {
+    const frame_buffer_t *in = &p->ctx->current_frame;
+    atomic_fetch_add_explicit(&p->received, 1, memory_order_relaxed);
+
+    recv_slot_t *slot = *spare ? *spare : (recv_slot_t *)fq_queue_pop(p->recv_free);
+    *spare = NULL;
+    if (!slot) {
+        atomic_fetch_add_explicit(&p->receive_dropped, 1, memory_order_relaxed);
+        request_keyframe(p);
+        return;
+    }
+
+    if (slot->capacity < in->size) {
+        uint8_t *grown = realloc(slot->data, in->size);
+        if (!grown) {
+            fprintf(stderr, "ERROR: Cannot grow receive buffer to %u bytes\n", in->size);
+            *spare = slot;
+            atomic_fetch_add_explicit(&p->receive_dropped, 1, memory_order_relaxed);
+            request_keyframe(p);
+            return;
+        }
+        slot->data = grown;
+        slot->capacity = in->size;
+    }
+    memcpy(slot->data, in->data, in->size);
+    slot->size = in->size;
+    slot->received_us = get_timestamp_us();
+
+    void *dropped = NULL;
+    if (fq_queue_push(p->recv_q, slot, &dropped) == FQ_DROPPED) {
+        *spare = (recv_slot_t *)dropped;
+        atomic_fetch_add_explicit(&p->receive_dropped, 1, memory_order_relaxed);
+        request_keyframe(p);
+    }
+}
+
+static void *net_thread_main(void *arg) {
+    client_pipeline_t *p = (client_pipeline_t *)arg;
+    rootstream_ctx_t *ctx = p->ctx;
+    recv_slot_t *spare = NULL;
+
+    while (!atomic_load_explicit(&p->stop, memory_order_acquire) && ctx->running) {
+        if (rootstream_net_recv(ctx, CLIENT_PIPELINE_RECV_TIMEOUT_MS) < 0) {
+            /* The error returns immediately; back off rather than spin */
+            rs_sleep_ms(CLIENT_PIPELINE_RECV_TIMEOUT_MS);
+        }
+        rootstream_net_tick(ctx);
+
+        if (ctx->current_frame.data && ctx->current_frame.size > 0) {
+            queue_received_frame(p, &spare);
+            ctx->current_frame.size = 0; /* Lets the next frame through */
+        }
+
+        if (p->tick)
+            p->tick(ctx, p->tick_user);
+    }
+
+    /* A spare slot is simply left out of circulation; the pipeline is
+     * not restarted, and recv_free has a single producer (decode). */
+    return NULL;
+}
+
+static void *decode_thread_main(void *arg) {
+    client_pipeline_t *p = (client_pipeline_t *)arg;
+    rootstream_ctx_t *ctx = p->ctx;
+
+    while (!atomic_load_explicit(&p->stop, memory_order_acquire)) {
+        recv_slot_t *in = (recv_slot_t *)fq_queue_pop(p->recv_q);
+        if (!in) {
+            fq_queue_wait(p->recv_q, 10000);
+            continue;
+        }
+
+        /* Every frame is decoded, held buffers or not, so the decoder's
+         * reference chain stays intact; only the output is discarded. */
+        client_frame_t *f = take_free_frame(p);
+        frame_buffer_t *out = f ? &f->decoded : &p->scratch;
+
+        uint64_t start_us = get_timestamp_us();
+        ewma_update(&p->queue_wait_us, start_us - in->received_us);
+        int rc = rootstream_decode_frame(ctx, in->data, in->size, out);
+        uint64_t end_us = get_timestamp_us();
+
+        fq_queue_push(p->recv_free, in, NULL);
+
+        if (rc < 0) {
+            fprintf(stderr, "ERROR: Decode failed (frame=%lu)\n",
+                    (unsigned long)atomic_load_explicit(&p->received, memory_order_relaxed));
+            atomic_fetch_add_explicit(&p->decode_errors, 1, memory_order_relaxed);
+            if (f)
+                recycle_frame(p, f);
+            continue;
+        }
+        ewma_update(&p->decode_us, end_us - start_us);
+        atomic_fetch_add_explicit(&p->decoded, 1, memory_order_relaxed);
+
+        if (!f || !out->data) {
+            atomic_fetch_add_explicit(&p->present_dropped, 1, memory_order_relaxed);
+            if (f)
+                recycle_frame(p, f);
+            continue;
+        }
+
+        client_pipeline_map_frame(&f->decoded, &f->view);
+        f->view.ref = f;
+        f->decode_end_us = end_us;
+        atomic_store_explicit(&f->refs, 1, memory_order_relaxed);
+
+        void *dropped = NULL;
+        if (fq_queue_push(p->present_q, f, &dropped) == FQ_DROPPED) {
+            /* The presenter fell behind; only the newest frames matter */
+            atomic_fetch_add_explicit(&p->present_dropped, 1, memory_order_relaxed);
+            client_frame_release((client_frame_t *)dropped);
+        }
+    }
+
+    return NULL;
+}
+
+client_pipeline_t *client_pipeline_start(rootstream_ctx_t *ctx, int depth,
+                                         client_pipeline_tick_fn tick, void *user) {
+    if (!ctx)
+        return NULL;
+    if (depth <= 0)
+        depth = CLIENT_PIPELINE_DEFAULT_DEPTH;
+
+    /* Queues round up to a power of two; size the buffer pools to match:
+     * depth queued + one being produced + one being consumed, and for
+     * decoded frames the ones the caller holds on top. */
+    int rounded = 1;
+    while (rounded < depth)
+        rounded <<= 1;
+    depth = rounded;
+    int recv_count = depth + 2;
+    int frame_count = depth + 1 + CLIENT_PIPELINE_MAX_HELD;
+    if (recv_count > FQ_MAX_SLOTS) {
+        fprintf(stderr, "ERROR: Pipeline depth %d exceeds %d\n", depth, FQ_MAX_SLOTS - 2);
+        return NULL;
+    }
+
+    client_pipeline_t *p = calloc(1, sizeof(*p));
+    if (!p)
+        return NULL;
+
+    p->ctx = ctx;
+    p->tick = tick;
+    p->tick_user = user;
+    p->recv_count = recv_count;
+    p->frame_count = frame_count;
+    pthread_mutex_init(&p->free_lock, NULL);
+    p->recv_q = fq_queue_create(depth);
+    p->recv_free = fq_queue_create(recv_count);
+    p->present_q = fq_queue_create(depth);
+    p->recv_slots = calloc((size_t)recv_count, sizeof(recv_slot_t));
+    p->frames = calloc((size_t)frame_count, sizeof(client_frame_t));
+    p->free_frames = calloc((size_t)frame_count, sizeof(client_frame_t *));
+    if (!p->recv_q || !p->recv_free || !p->present_q || !p->recv_slots || !p->frames ||
+        !p->free_frames) {
+        fprintf(stderr, "ERROR: Pipeline allocation failed\n");
+        free_pipeline(p);
+        return NULL;
+    }
+
+    /* Bitstream buffers grow to the largest frame seen, then stay */
+    for (int i = 0; i < recv_count; i++)
+        fq_queue_push(p->recv_free, &p->recv_slots[i], NULL);
+    for (int i = 0; i < frame_count; i++) {
+        p->frames[i].owner = p;
+        atomic_init(&p->frames[i].refs, 0);
+        p->free_frames[p->free_count++] = &p->frames[i];
+    }
+
+    atomic_init(&p->stop, 0);
+    if (pthread_create(&p->decode_thread, NULL, decode_thread_main, p) != 0) {
+        fprintf(stderr, "ERROR: Cannot start decode thread\n");
+        client_pipeline_destroy(p);
+        return NULL;
+    }
+    p->decode_started = true;
+
+    if (pthread_create(&p->net_thread, NULL, net_thread_main, p) != 0) {
+        fprintf(stderr, "ERROR: Cannot start network thread\n");
+        client_pipeline_destroy(p);
+        return NULL;
+    }
+    p->net_started = true;
+
+    printf("✓ Client pipeline started (queue depth %d, %d decoded frames)\n", depth,
+           frame_count);
+    return p;
+}
+
+client_frame_t *client_pipeline_next(client_pipeline_t *p, uint64_t timeout_us) {
+    if (!p)
+        return NULL;
+
+    client_frame_t *f = (client_frame_t *)fq_queue_pop(p->present_q);
+    if (!f && fq_queue_wait(p->present_q, timeout_us))
+        f = (client_frame_t *)fq_queue_pop(p->present_q);
+    if (!f)
+        return NULL;
+
+    f->handed_out = true;
+    atomic_fetch_add_explicit(&p->held, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&p->presented, 1, memory_order_relaxed);
+    ewma_update(&p->present_wait_us, get_timestamp_us() - f->decode_end_us);
+    return f;
+}
+
+const rs_video_frame_t *client_frame_view(const client_frame_t *f) {
+    return f ? &f->view : NULL;
+}
+
+client_frame_t *client_frame_retain(client_frame_t *f) {
+    if (f)
+        atomic_fetch_add_explicit(&f->refs, 1, memory_order_relaxed);
+    return f;
+}
+
+void client_frame_release(client_frame_t *f) {
+    if (!f || atomic_fetch_sub_explicit(&f->refs, 1, memory_order_acq_rel) != 1)
+        return;
+
+    client_pipeline_t *p = f->owner;
+    if (f->handed_out) {
+        f->handed_out = false;
+        atomic_fetch_sub_explicit(&p->held, 1, memory_order_relaxed);
+    }
+    recycle_frame(p, f);
+}
+
+int client_pipeline_get_stats(const client_pipeline_t *p, client_pipeline_stats_t *out) {
+    if (!p || !out)
+        return -1;
+
+    client_pipeline_t *mp = (client_pipeline_t *)p;
+    out->received = atomic_load_explicit(&mp->received, memory_order_relaxed);
+    out->receive_dropped = atomic_load_explicit(&mp->receive_dropped, memory_order_relaxed);
+    out->decoded = atomic_load_explicit(&mp->decoded, memory_order_relaxed);
+    out->decode_errors = atomic_load_explicit(&mp->decode_errors, memory_order_relaxed);
+    out->present_dropped = atomic_load_explicit(&mp->present_dropped, memory_order_relaxed);
+    out->presented = atomic_load_explicit(&mp->presented, memory_order_relaxed);
+    out->decode_queue_depth = (uint32_t)fq_queue_depth(p->recv_q);
+    out->decode_queue_capacity = (uint32_t)fq_queue_capacity(p->recv_q);
+    out->present_queue_depth = (uint32_t)fq_queue_depth(p->present_q);
+    out->present_queue_capacity = (uint32_t)fq_queue_capacity(p->present_q);
+    out->held = atomic_load_explicit(&mp->held, memory_order_relaxed);
+    out->queue_wait_us = atomic_load_explicit(&mp->queue_wait_us, memory_order_relaxed);
+    out->decode_us = atomic_load_explicit(&mp->decode_us, memory_order_relaxed);
+    out->present_wait_us = atomic_load_explicit(&mp->present_wait_us, memory_order_relaxed);
+    return 0;
+}
+
+void client_pipeline_stop(client_pipeline_t *p) {
+    if (!p)
+        return;
+
+    atomic_store_explicit(&p->stop, 1, memory_order_release);
+    fq_queue_wake(p->recv_q);
+
+    if (p->net_started)
+        pthread_join(p->net_thread, NULL);
+    if (p->decode_started)
+        pthread_join(p->decode_thread, NULL);
+    p->net_started = false;
+    p->decode_started = false;
+}
+
+void client_pipeline_destroy(client_pipeline_t *p) {
+    if (!p)
+        return;
+
+    client_pipeline_stop(p);
+
+    client_frame_t *f;
+    while ((f = (client_frame_t *)fq_queue_pop(p->present_q)) != NULL)
+        client_frame_release(f);
+
+    pthread_mutex_lock(&p->free_lock);
+    p->destroyed = true;
+    bool idle = p->free_count == p->frame_count;
+    pthread_mutex_unlock(&p->free_lock);
+
+    if (idle)
+        free_pipeline(p);
+}
@@ -0,0 +1,184 @@
+/*
+ * client_pipeline.h — Staged receive → decode → present client pipeline
+ *
+ * Splits the client loop into three stages so packet reception never
+ * waits for the decoder and the decoder never waits for the display:
+ *
+ *   network thread ──recv_q──▶ decode thread ──present_q──▶ caller (present)
+ *
+ * The network thread drives rootstream_net_recv() / rootstream_net_tick()
+ * and copies every reassembled frame out of the reassembler (whose buffer
+ * is only borrowed until the next receive) into a recycled bitstream
+ * buffer.  Both queues are small SPSC drop-oldest queues (frame_queue.h).
+ * When a compressed frame is shed before decode the host is asked for a
+ * keyframe, since later frames reference the one that was lost.
+ *
+ * Decoded frames are reference counted.  The presenter receives the
+ * queue's reference from client_pipeline_next() and may pass frames on
+ * to other threads, retaining and releasing them at will; a frame's
+ * buffer is recycled when its last reference is dropped.  Up to
+ * CLIENT_PIPELINE_MAX_HELD frames may be held outside the queue before
+ * the decoder starts discarding its output.
+ *
+ * Thread-safety: client_pipeline_next() must be called from a single
+ * (presentation) thread.  client_frame_retain()/client_frame_release()
+ * and client_pipeline_get_stats() may be called from any thread.  The
+ * network thread owns the network half of ctx, the decode thread owns
+ * ctx->decoder, while the pipeline runs.
+ */
+
+#ifndef ROOTSTREAM_CLIENT_PIPELINE_H
+#define ROOTSTREAM_CLIENT_PIPELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../include/rootstream.h"
+#include "../../include/rootstream_client_session.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CLIENT_PIPELINE_DEFAULT_DEPTH 2    /**< Default per-stage queue depth */
+#define CLIENT_PIPELINE_MAX_HELD 4         /**< Decoded frames the caller may hold */
+#define CLIENT_PIPELINE_RECV_TIMEOUT_MS 16 /**< Network wait per receive pass */
+
+/** Opaque pipeline */
+typedef struct client_pipeline_s client_pipeline_t;
+
+/** One decoded, reference-counted frame */
+typedef struct client_frame_s client_frame_t;
+
+/**
+ * Called on the network thread after every receive pass (audio and
+ * other per-packet work that must stay off the decode thread).
+ */
+typedef void (*client_pipeline_tick_fn)(rootstream_ctx_t *ctx, void *user);
+
+/** Pipeline counters and timings (snapshot) */
+typedef struct {
+    uint64_t received;               /**< Reassembled frames taken off the network */
+    uint64_t receive_dropped;        /**< Compressed frames shed before decode */
+    uint64_t decoded;                /**< Frames decoded */
+    uint64_t decode_errors;          /**< Failed decode calls */
+    uint64_t present_dropped;        /**< Decoded frames superseded or without a buffer */
+    uint64_t presented;              /**< Frames handed out by client_pipeline_next() */
+    uint32_t decode_queue_depth;     /**< Compressed frames waiting for the decoder */
+    uint32_t decode_queue_capacity;  /**< Slots in the decode queue */
+    uint32_t present_queue_depth;    /**< Decoded frames waiting for the presenter */
+    uint32_t present_queue_capacity; /**< Slots in the presentation queue */
+    uint32_t held;                   /**< Handed-out frames not yet fully released */
+    uint32_t queue_wait_us;          /**< Mean time from reassembly to decode start */
+    uint32_t decode_us;              /**< Mean decode call duration */
+    uint32_t present_wait_us;        /**< Mean time from decode end to hand-out */
+} client_pipeline_stats_t;
+
+/**
+ * client_pipeline_start — allocate buffers and launch network/decode threads
+ *
+ * The decoder must already be initialised.  The network socket and peer
+ * table are used as they are; the pipeline neither connects nor closes.
+ *
+ * @param ctx    Client context
+ * @param depth  Queue depth per stage (<= 0 → default)
+ * @param tick   Per-receive-pass hook (may be NULL)
+ * @param user   Passed to @tick
+ * @return       Running pipeline, or NULL on failure
+ */
+client_pipeline_t *client_pipeline_start(rootstream_ctx_t *ctx, int depth,
+                                         client_pipeline_tick_fn tick, void *user);
+
+/**
+ * client_pipeline_next — wait for the next decoded frame
+ *
+ * @param p           Pipeline
+ * @param timeout_us  Maximum wait in microseconds
+ * @return            Frame carrying one reference owned by the caller
+ *                    (drop it with client_frame_release()), or NULL on
+ *                    timeout
+ */
+client_frame_t *client_pipeline_next(client_pipeline_t *p, uint64_t timeout_us);
+
+/**
+ * client_frame_view — the frame as handed to applications
+ *
+ * The view stays valid while the caller holds a reference; its ref
+ * field points back at @f.
+ */
+const rs_video_frame_t *client_frame_view(const client_frame_t *f);
+
+/**
+ * client_frame_retain — add a reference to @f
+ *
+ * @return @f
+ */
+client_frame_t *client_frame_retain(client_frame_t *f);
+
+/**
+ * client_frame_release — drop a reference; the last one recycles the buffer
+ */
+void client_frame_release(client_frame_t *f);
+
+/**
+ * client_pipeline_get_stats — copy counters and timings into *out
+ *
+ * @return 0 on success, -1 on NULL
+ */
+int client_pipeline_get_stats(const client_pipeline_t *p, client_pipeline_stats_t *out);
+
+/**
+ * client_pipeline_stop — stop and join the network and decode threads
+ *
+ * Frames already handed out stay valid; frames still queued can be
+ * drained with client_pipeline_next().
+ */
+void client_pipeline_stop(client_pipeline_t *p);
+
+/**
+ * client_pipeline_destroy — stop if running and free the pipeline
+ *
+ * Frames the caller still holds stay valid; their memory goes with the
+ * last client_frame_release().
+ */
+void client_pipeline_destroy(client_pipeline_t *p);
+
+/**
+ * client_pipeline_map_frame — describe a decoder output buffer as an
+ * rs_video_frame_t (NV12 when the decoder produced NV12, packed RGBA
+ * otherwise); the view's ref is NULL
+ *
+ * Inline so the single-threaded session loop can share it on platforms
+ * that do not build the pipeline.
+ */
+static inline void client_pipeline_map_frame(const frame_buffer_t *decoded,
+                                             rs_video_frame_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->width = (int)decoded->width;
+    out->height = (int)decoded->height;
+    /* The decoder stamps its output; that is the presentation timestamp */
+    out->pts_us = decoded->timestamp;
+    out->is_keyframe = decoded->is_keyframe;
+
+    if (decoded->format == FRAME_FORMAT_NV12) {
+        /* Y plane followed by the interleaved UV plane (height / 2 rows) */
+        out->pixfmt = RS_PIXFMT_NV12;
+        out->plane0 = decoded->data;
+        out->stride0 = (int)decoded->width;
+        out->plane1 = decoded->data + (size_t)decoded->width * decoded->height;
+        out->stride1 = (int)decoded->width;
+    } else {
+        /* Fallback: treat as packed RGBA */
+        out->pixfmt = RS_PIXFMT_RGBA;
+        out->plane0 = decoded->data;
+        out->stride0 = (int)decoded->width * 4;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_CLIENT_PIPELINE_H */
@@ -0,0 +1,61 @@
+/*
+ * deadline_pacer.c — Absolute-deadline frame pacing implementation
+ */
+
+#include "deadline_pacer.h"
+
+#include <errno.h>
+#include <time.h>
+
+uint64_t dl_pacer_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void dl_pacer_init(dl_pacer_t *p, uint32_t hz) {
+    if (!p)
+        return;
+    p->period_ns = 1000000000ULL / (hz ? hz : 60);
+    p->next_ns = dl_pacer_now_ns() + p->period_ns;
+    p->ticks = 0;
+    p->overruns = 0;
+    p->resyncs = 0;
+}
+
+void dl_pacer_set_rate(dl_pacer_t *p, uint32_t hz) {
+    if (!p)
+        return;
+    uint64_t period = 1000000000ULL / (hz ? hz : 60);
+    p->next_ns = p->next_ns - p->period_ns + period;
+    p->period_ns = period;
+}
+
+uint64_t dl_pacer_wait(dl_pacer_t *p) {
+    if (!p)
+        return 0;
+
+    uint64_t now = dl_pacer_now_ns();
+    uint64_t slept = 0;
+
+    if (now < p->next_ns) {
+        struct timespec ts = {.tv_sec = (time_t)(p->next_ns / 1000000000ULL),
+                              .tv_nsec = (long)(p->next_ns % 1000000000ULL)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        slept = p->next_ns - now;
+        p->next_ns += p->period_ns;
+    } else {
+        p->overruns++;
+        if (now - p->next_ns >= p->period_ns) {
+            /* More than a full period late: drop the missed ticks. */
+            p->next_ns = now + p->period_ns;
+            p->resyncs++;
+        } else {
+            p->next_ns += p->period_ns;
+        }
+    }
+
+    p->ticks++;
+    return slept;
+}
@@ -0,0 +1,62 @@
+/*
+ * deadline_pacer.h — Absolute-deadline frame pacing
+ *
+ * Replaces "do work, then sleep one full period" loops.  Each call to
+ * dl_pacer_wait() sleeps until the next multiple of the period on the
+ * monotonic clock, so time spent doing work is subtracted from the
+ * sleep rather than added to it.  If the caller falls more than one
+ * full period behind, the schedule is re-anchored to "now" instead of
+ * bursting to catch up.
+ *
+ * Thread-safety: value type — one pacer per thread.
+ */
+
+#ifndef ROOTSTREAM_DEADLINE_PACER_H
+#define ROOTSTREAM_DEADLINE_PACER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Pacer state */
+typedef struct {
+    uint64_t period_ns;   /**< Frame period */
+    uint64_t next_ns;     /**< Absolute deadline of the next tick */
+    uint64_t ticks;       /**< Completed waits */
+    uint64_t overruns;    /**< Waits that found the deadline already passed */
+    uint64_t resyncs;     /**< Schedule re-anchors after falling > 1 period behind */
+} dl_pacer_t;
+
+/**
+ * dl_pacer_init — initialise pacer for a given rate
+ *
+ * @param p   Pacer
+ * @param hz  Tick rate (0 → 60)
+ */
+void dl_pacer_init(dl_pacer_t *p, uint32_t hz);
+
+/**
+ * dl_pacer_set_rate — change the tick rate, keeping the current phase
+ */
+void dl_pacer_set_rate(dl_pacer_t *p, uint32_t hz);
+
+/**
+ * dl_pacer_wait — sleep until the next deadline
+ *
+ * @param p  Pacer
+ * @return   Nanoseconds slept (0 on overrun)
+ */
+uint64_t dl_pacer_wait(dl_pacer_t *p);
+
+/**
+ * dl_pacer_now_ns — CLOCK_MONOTONIC in nanoseconds
+ */
+uint64_t dl_pacer_now_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_DEADLINE_PACER_H */
@@ -0,0 +1,196 @@
+/*
+ * frame_queue.c — Bounded SPSC frame queue implementation
+ *
+ * head/tail are free-running 64-bit counters; slot index = counter & mask.
+ * The producer owns tail.  head is advanced by the consumer on pop and by
+ * the producer on drop-oldest, always via CAS so an item is never both
+ * popped and evicted.
+ *
+ * Blocking waits use a mutex/condvar pair that is only touched when the
+ * consumer is actually asleep (`waiting` flag), keeping the steady-state
+ * push/pop path free of locks.
+ */
+
+#include "frame_queue.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct fq_queue_s {
+    _Atomic(void *) slots[FQ_MAX_SLOTS];
+    uint64_t mask;
+    int capacity;
+
+    _Atomic uint64_t head; /* next slot to pop */
+    _Atomic uint64_t tail; /* next slot to fill */
+
+    _Atomic uint64_t pushed;
+    _Atomic uint64_t popped;
+    _Atomic uint64_t dropped;
+    _Atomic uint32_t peak;
+
+    atomic_int waiting;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+fq_queue_t *fq_queue_create(int capacity) {
+    if (capacity < 1 || capacity > FQ_MAX_SLOTS)
+        return NULL;
+
+    int cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+
+    fq_queue_t *q = calloc(1, sizeof(*q));
+    if (!q)
+        return NULL;
+
+    q->capacity = cap;
+    q->mask = (uint64_t)cap - 1;
+    for (int i = 0; i < FQ_MAX_SLOTS; i++)
+        atomic_init(&q->slots[i], NULL);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->pushed, 0);
+    atomic_init(&q->popped, 0);
+    atomic_init(&q->dropped, 0);
+    atomic_init(&q->peak, 0);
+    atomic_init(&q->waiting, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return q;
+}
+
+void fq_queue_destroy(fq_queue_t *q) {
+    if (!q)
+        return;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
+
+int fq_queue_push(fq_queue_t *q, void *item, void **dropped) {
+    if (!q || !item)
+        return -1;
+
+    int rc = FQ_PUSHED;
+    uint64_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - head < (uint64_t)q->capacity)
+            break;
+
+        /* Full: try to claim the oldest item.  If the consumer pops it
+         * first the CAS fails and the loop re-checks for free space. */
+        void *old = atomic_load_explicit(&q->slots[head & q->mask], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&q->head, &head, head + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            if (dropped)
+                *dropped = old;
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            rc = FQ_DROPPED;
+            break;
+        }
+    }
+
+    atomic_store_explicit(&q->slots[tail & q->mask], item, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_seq_cst);
+    atomic_fetch_add_explicit(&q->pushed, 1, memory_order_relaxed);
+
+    uint64_t depth = tail + 1 - atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (depth > atomic_load_explicit(&q->peak, memory_order_relaxed))
+        atomic_store_explicit(&q->peak, (uint32_t)depth, memory_order_relaxed);
+
+    if (atomic_load_explicit(&q->waiting, memory_order_seq_cst)) {
+        pthread_mutex_lock(&q->lock);
+        pthread_cond_signal(&q->cond);
+        pthread_mutex_unlock(&q->lock);
+    }
+    return rc;
+}
+
+void *fq_queue_pop(fq_queue_t *q) {
+    if (!q)
+        return NULL;
+
+    for (;;) {
+        uint64_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == tail)
+            return NULL;
+
+        void *item = atomic_load_explicit(&q->slots[head & q->mask], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&q->head, &head, head + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            atomic_fetch_add_explicit(&q->popped, 1, memory_order_relaxed);
+            return item;
+        }
+        /* Lost the race to a drop-oldest eviction; retry with new head. */
+    }
+}
+
+bool fq_queue_wait(fq_queue_t *q, uint64_t timeout_us) {
+    if (!q)
+        return false;
+    if (fq_queue_depth(q) > 0)
+        return true;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeout_us / 1000000ULL);
+    deadline.tv_nsec += (long)(timeout_us % 1000000ULL) * 1000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    atomic_store_explicit(&q->waiting, 1, memory_order_seq_cst);
+    if (fq_queue_depth(q) == 0)
+        pthread_cond_timedwait(&q->cond, &q->lock, &deadline);
+    atomic_store_explicit(&q->waiting, 0, memory_order_relaxed);
+    pthread_mutex_unlock(&q->lock);
+
+    return fq_queue_depth(q) > 0;
+}
+
+void fq_queue_wake(fq_queue_t *q) {
+    if (!q)
+        return;
+    pthread_mutex_lock(&q->lock);
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+int fq_queue_depth(const fq_queue_t *q) {
+    if (!q)
+        return 0;
+    fq_queue_t *mq = (fq_queue_t *)q;
+    uint64_t tail = atomic_load_explicit(&mq->tail, memory_order_seq_cst);
+    uint64_t head = atomic_load_explicit(&mq->head, memory_order_seq_cst);
+    return tail > head ? (int)(tail - head) : 0;
+}
+
+int fq_queue_capacity(const fq_queue_t *q) {
+    return q ? q->capacity : 0;
+}
+
+int fq_queue_get_stats(const fq_queue_t *q, fq_stats_t *out) {
+    if (!q || !out)
+        return -1;
+    fq_queue_t *mq = (fq_queue_t *)q;
+    out->pushed = atomic_load_explicit(&mq->pushed, memory_order_relaxed);
+    out->popped = atomic_load_explicit(&mq->popped, memory_order_relaxed);
+    out->dropped = atomic_load_explicit(&mq->dropped, memory_order_relaxed);
+    out->peak = atomic_load_explicit(&mq->peak, memory_order_relaxed);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * frame_queue.h — Bounded SPSC frame queue with drop-oldest overflow
+ *
+ * Connects two pipeline stages (e.g. capture → encode).  The queue
+ * stores opaque item pointers; the items themselves are owned by the
+ * stage that allocated them and are recycled by the caller.
+ *
+ * When the producer pushes into a full queue the OLDEST queued item is
+ * evicted and handed back to the producer through *dropped, so a slow
+ * consumer always sees the freshest frames and the producer never
+ * blocks.  Eviction races with a concurrent pop are resolved with a
+ * single CAS on the head index: exactly one side wins each item.
+ *
+ * Thread-safety: one producer thread and one consumer thread.
+ *   fq_queue_push()  — producer only
+ *   fq_queue_pop()   — consumer only
+ *   fq_queue_wait()  — consumer only
+ *   fq_queue_depth() / fq_queue_get_stats() — any thread
+ */
+
+#ifndef ROOTSTREAM_FRAME_QUEUE_H
+#define ROOTSTREAM_FRAME_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FQ_MAX_SLOTS 64 /**< Maximum queue capacity (power of two) */
+
+/** Push outcome */
+#define FQ_PUSHED 0  /**< Item queued, nothing evicted */
+#define FQ_DROPPED 1 /**< Item queued, oldest item returned in *dropped */
+
+/** Queue counters (monotonic since create) */
+typedef struct {
+    uint64_t pushed;  /**< Items accepted by fq_queue_push() */
+    uint64_t popped;  /**< Items returned by fq_queue_pop() */
+    uint64_t dropped; /**< Items evicted by drop-oldest */
+    uint32_t peak;    /**< High-water mark of queued items */
+} fq_stats_t;
+
+/** Opaque frame queue */
+typedef struct fq_queue_s fq_queue_t;
+
+/**
+ * fq_queue_create — allocate queue
+ *
+ * @param capacity  Slot count; rounded up to a power of two (1..FQ_MAX_SLOTS)
+ * @return          Non-NULL handle, or NULL on OOM/invalid
+ */
+fq_queue_t *fq_queue_create(int capacity);
+
+/**
+ * fq_queue_destroy — free queue (does NOT free queued items)
+ */
+void fq_queue_destroy(fq_queue_t *q);
+
+/**
+ * fq_queue_push — enqueue item, evicting the oldest entry when full
+ *
+ * @param q        Queue
+ * @param item     Non-NULL item pointer
+ * @param dropped  Receives the evicted item on FQ_DROPPED (may be NULL)
+ * @return         FQ_PUSHED, FQ_DROPPED, or -1 on invalid arguments
+ */
+int fq_queue_push(fq_queue_t *q, void *item, void **dropped);
+
+/**
+ * fq_queue_pop — dequeue the oldest item
+ *
+ * @param q  Queue
+ * @return   Item pointer, or NULL if empty
+ */
+void *fq_queue_pop(fq_queue_t *q);
+
+/**
+ * fq_queue_wait — block until the queue is non-empty or timeout expires
+ *
+ * @param q           Queue
+ * @param timeout_us  Maximum wait in microseconds
+ * @return            true if at least one item is queued
+ */
+bool fq_queue_wait(fq_queue_t *q, uint64_t timeout_us);
+
+/**
+ * fq_queue_wake — wake a consumer blocked in fq_queue_wait()
+ *
+ * Used during shutdown so the consumer can observe its stop flag.
+ */
+void fq_queue_wake(fq_queue_t *q);
+
+/**
+ * fq_queue_depth — number of queued items (snapshot)
+ */
+int fq_queue_depth(const fq_queue_t *q);
+
+/**
+ * fq_queue_capacity — slot count after power-of-two rounding
+ */
+int fq_queue_capacity(const fq_queue_t *q);
+
+/**
+ * fq_queue_get_stats — copy counters into *out
+ *
+ * @return 0 on success, -1 on NULL
+ */
+int fq_queue_get_stats(const fq_queue_t *q, fq_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_FRAME_QUEUE_H */
@@ -0,0 +1,328 @@
+/*
+ * host_pipeline.c — Staged capture → encode → send host pipeline
+ *
+ * Buffer ownership is tracked entirely through queues so no buffer is
+ * ever shared between two stages:
+ *
+ *   raw_free ──▶ capture ──raw_q──▶ encode ──▶ raw_free
+ *   enc_free ──▶ encode  ──enc_q──▶ send   ──▶ enc_free
+ *
+ * Every queue has exactly one producer and one consumer.  An item evicted
+ * by drop-oldest is handed back to the producer that pushed, which keeps
+ * it as its next work buffer ("spare") rather than pushing it onto the
+ * free list — that would make the producer a second writer of a queue
+ * it does not own.
+ */
+
+#include "host_pipeline.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "deadline_pacer.h"
+#include "frame_queue.h"
+
+typedef struct {
+    frame_buffer_t frame;
+    uint64_t capture_start_us;
+    uint64_t capture_end_us;
+} raw_slot_t;
+
+struct host_pipeline_s {
+    rootstream_ctx_t *ctx;
+
+    fq_queue_t *raw_q;
+    fq_queue_t *raw_free;
+    fq_queue_t *enc_q;
+    fq_queue_t *enc_free;
+
+    raw_slot_t *raw_slots;
+    host_encoded_frame_t *enc_slots;
+    int slot_count;
+
+    pthread_t capture_thread;
+    pthread_t encode_thread;
+    bool capture_started;
+    bool encode_started;
+    atomic_int stop;
+
+    _Atomic uint64_t captured;
+    _Atomic uint64_t capture_errors;
+    _Atomic uint64_t capture_unchanged;
+    _Atomic uint64_t encoded;
+    _Atomic uint64_t encode_errors;
+    _Atomic uint64_t pacer_overruns;
+};
+
+static void *capture_thread_main(void *arg) {
+    host_pipeline_t *p = (host_pipeline_t *)arg;
+    rootstream_ctx_t *ctx = p->ctx;
+    raw_slot_t *spare = NULL;
+
+    dl_pacer_t pacer;
+    dl_pacer_init(&pacer, ctx->display.refresh_rate);
+
+    while (!atomic_load_explicit(&p->stop, memory_order_acquire)) {
+        raw_slot_t *slot = spare ? spare : (raw_slot_t *)fq_queue_pop(p->raw_free);
+        spare = NULL;
+        if (!slot) {
+            /* Encoder holds every buffer; wait for one to come back. */
+            fq_queue_wait(p->raw_free, pacer.period_ns / 1000);
+            continue;
+        }
+
+        slot->capture_start_us = get_timestamp_us();
+        int captured = ctx->capture_backend->capture_fn(ctx, &slot->frame);
+        if (captured < 0) {
+            fprintf(stderr, "ERROR: Capture failed (display=%s)\n", ctx->display.name);
+            fprintf(stderr, "DETAILS: %s\n", rootstream_get_error());
+            atomic_fetch_add_explicit(&p->capture_errors, 1, memory_order_relaxed);
+            spare = slot;
+            usleep(16000);
+            continue;
+        }
+        if (captured == CAPTURE_UNCHANGED) {
+            /* Static screen: keep the slot, wake up at the next frame time */
+            atomic_fetch_add_explicit(&p->capture_unchanged, 1, memory_order_relaxed);
+            spare = slot;
+            dl_pacer_wait(&pacer);
+            continue;
+        }
+        slot->capture_end_us = get_timestamp_us();
+        atomic_fetch_add_explicit(&p->captured, 1, memory_order_relaxed);
+
+        void *dropped = NULL;
+        if (fq_queue_push(p->raw_q, slot, &dropped) == FQ_DROPPED)
+            spare = (raw_slot_t *)dropped;
+
+        dl_pacer_wait(&pacer);
+        atomic_store_explicit(&p->pacer_overruns, pacer.overruns, memory_order_relaxed);
+    }
+
+    return NULL;
+}
+
+static void *encode_thread_main(void *arg) {
+    host_pipeline_t *p = (host_pipeline_t *)arg;
+    rootstream_ctx_t *ctx = p->ctx;
+    host_encoded_frame_t *spare = NULL;
+
+    while (!atomic_load_explicit(&p->stop, memory_order_acquire)) {
+        raw_slot_t *raw = (raw_slot_t *)fq_queue_pop(p->raw_q);
+        if (!raw) {
+            fq_queue_wait(p->raw_q, 10000);
+            continue;
+        }
+        uint32_t raw_depth = (uint32_t)fq_queue_depth(p->raw_q);
+
+        host_encoded_frame_t *enc = spare;
+        spare = NULL;
+        if (!enc)
+            enc = (host_encoded_frame_t *)fq_queue_pop(p->enc_free);
+        while (!enc && !atomic_load_explicit(&p->stop, memory_order_acquire)) {
+            fq_queue_wait(p->enc_free, 10000);
+            enc = (host_encoded_frame_t *)fq_queue_pop(p->enc_free);
+        }
+        if (!enc) {
+            fq_queue_push(p->raw_free, raw, NULL);
+            break;
+        }
+
+        enc->size = 0;
+        enc->is_keyframe = false;
+        enc->encode_start_us = get_timestamp_us();
+        int rc = rootstream_encode_frame_ex(ctx, &raw->frame, enc->data, &enc->size,
+                                            &enc->is_keyframe);
+        enc->encode_end_us = get_timestamp_us();
+        enc->timestamp = raw->frame.timestamp;
+        enc->capture_start_us = raw->capture_start_us;
+        enc->capture_end_us = raw->capture_end_us;
+        enc->capture_queue_depth = raw_depth;
+
+        /* Raw frame is consumed either way; hand it back to capture. */
+        fq_queue_push(p->raw_free, raw, NULL);
+
+        if (rc < 0) {
+            fprintf(stderr, "ERROR: Encode failed (frame=%lu)\n", ctx->frames_captured);
+            atomic_fetch_add_explicit(&p->encode_errors, 1, memory_order_relaxed);
+            spare = enc;
+            continue;
+        }
+        atomic_fetch_add_explicit(&p->encoded, 1, memory_order_relaxed);
+
+        void *dropped = NULL;
+        if (fq_queue_push(p->enc_q, enc, &dropped) == FQ_DROPPED) {
+            /* The client will never see the shed frame; later P-frames
+             * would reference it, so restart the GOP. */
+            spare = (host_encoded_frame_t *)dropped;
+            encoder_request_keyframe(&ctx->encoder);
+        }
+    }
+
+    return NULL;
+}
+
+static void free_buffers(host_pipeline_t *p) {
+    if (p->raw_slots) {
+        for (int i = 0; i < p->slot_count; i++)
+            free(p->raw_slots[i].frame.data);
+        free(p->raw_slots);
+    }
+    if (p->enc_slots) {
+        for (int i = 0; i < p->slot_count; i++)
+            free(p->enc_slots[i].data);
+        free(p->enc_slots);
+    }
+    fq_queue_destroy(p->raw_q);
+    fq_queue_destroy(p->raw_free);
+    fq_queue_destroy(p->enc_q);
+    fq_queue_destroy(p->enc_free);
+}
+
+host_pipeline_t *host_pipeline_start(rootstream_ctx_t *ctx, size_t enc_buf_size, int depth) {
+    if (!ctx || !ctx->capture_backend || !ctx->capture_backend->capture_fn || enc_buf_size == 0)
+        return NULL;
+    if (depth <= 0)
+        depth = HOST_PIPELINE_DEFAULT_DEPTH;
+
+    /* Queues round up to a power of two; size the buffer pools to match:
+     * depth queued + one being produced + one being consumed. */
+    int rounded = 1;
+    while (rounded < depth)
+        rounded <<= 1;
+    depth = rounded;
+    int slots = depth + 2;
+    if (slots > FQ_MAX_SLOTS) {
+        fprintf(stderr, "ERROR: Pipeline depth %d exceeds %d\n", depth, FQ_MAX_SLOTS - 2);
+        return NULL;
+    }
+
+    size_t raw_size = ctx->current_frame.capacity;
+    if (raw_size == 0)
+        raw_size = ctx->current_frame.size;
+    if (raw_size == 0)
+        raw_size = (size_t)ctx->display.width * ctx->display.height * 4;
+
+    host_pipeline_t *p = calloc(1, sizeof(*p));
+    if (!p)
+        return NULL;
+
+    p->ctx = ctx;
+    p->slot_count = slots;
+    p->raw_q = fq_queue_create(depth);
+    p->raw_free = fq_queue_create(slots);
+    p->enc_q = fq_queue_create(depth);
+    p->enc_free = fq_queue_create(slots);
+    p->raw_slots = calloc((size_t)slots, sizeof(raw_slot_t));
+    p->enc_slots = calloc((size_t)slots, sizeof(host_encoded_frame_t));
+    if (!p->raw_q || !p->raw_free || !p->enc_q || !p->enc_free || !p->raw_slots ||
+        !p->enc_slots) {
+        fprintf(stderr, "ERROR: Pipeline allocation failed\n");
+        free_buffers(p);
+        free(p);
+        return NULL;
+    }
+
+    for (int i = 0; i < slots; i++) {
+        raw_slot_t *raw = &p->raw_slots[i];
+        raw->frame = ctx->current_frame;
+        raw->frame.data = malloc(raw_size);
+        raw->frame.capacity = (uint32_t)raw_size;
+
+        host_encoded_frame_t *enc = &p->enc_slots[i];
+        enc->data = malloc(enc_buf_size);
+        enc->capacity = enc_buf_size;
+
+        if (!raw->frame.data || !enc->data) {
+            fprintf(stderr, "ERROR: Pipeline buffer allocation failed (%zu + %zu bytes)\n",
+                    raw_size, enc_buf_size);
+            free_buffers(p);
+            free(p);
+            return NULL;
+        }
+        fq_queue_push(p->raw_free, raw, NULL);
+        fq_queue_push(p->enc_free, enc, NULL);
+    }
+
+    atomic_init(&p->stop, 0);
+    if (pthread_create(&p->encode_thread, NULL, encode_thread_main, p) != 0) {
+        fprintf(stderr, "ERROR: Cannot start encode thread\n");
+        host_pipeline_stop(p);
+        return NULL;
+    }
+    p->encode_started = true;
+
+    if (pthread_create(&p->capture_thread, NULL, capture_thread_main, p) != 0) {
+        fprintf(stderr, "ERROR: Cannot start capture thread\n");
+        host_pipeline_stop(p);
+        return NULL;
+    }
+    p->capture_started = true;
+
+    printf("✓ Host pipeline started (queue depth %d, %d buffers/stage)\n", depth, slots);
+    return p;
+}
+
+host_encoded_frame_t *host_pipeline_next(host_pipeline_t *p, uint64_t timeout_us,
+                                         uint32_t *queue_depth) {
+    if (!p)
+        return NULL;
+
+    host_encoded_frame_t *frame = (host_encoded_frame_t *)fq_queue_pop(p->enc_q);
+    if (!frame && fq_queue_wait(p->enc_q, timeout_us))
+        frame = (host_encoded_frame_t *)fq_queue_pop(p->enc_q);
+
+    if (frame && queue_depth)
+        *queue_depth = (uint32_t)fq_queue_depth(p->enc_q);
+    return frame;
+}
+
+void host_pipeline_release(host_pipeline_t *p, host_encoded_frame_t *frame) {
+    if (!p || !frame)
+        return;
+    fq_queue_push(p->enc_free, frame, NULL);
+}
+
+int host_pipeline_get_stats(const host_pipeline_t *p, host_pipeline_stats_t *out) {
+    if (!p || !out)
+        return -1;
+
+    host_pipeline_t *mp = (host_pipeline_t *)p;
+    fq_stats_t raw, enc;
+    fq_queue_get_stats(p->raw_q, &raw);
+    fq_queue_get_stats(p->enc_q, &enc);
+
+    out->captured = atomic_load_explicit(&mp->captured, memory_order_relaxed);
+    out->capture_errors = atomic_load_explicit(&mp->capture_errors, memory_order_relaxed);
+    out->capture_unchanged = atomic_load_explicit(&mp->capture_unchanged, memory_order_relaxed);
+    out->capture_dropped = raw.dropped;
+    out->encoded = atomic_load_explicit(&mp->encoded, memory_order_relaxed);
+    out->encode_errors = atomic_load_explicit(&mp->encode_errors, memory_order_relaxed);
+    out->encode_dropped = enc.dropped;
+    out->pacer_overruns = atomic_load_explicit(&mp->pacer_overruns, memory_order_relaxed);
+    out->capture_peak = raw.peak;
+    out->encode_peak = enc.peak;
+    return 0;
+}
+
+void host_pipeline_stop(host_pipeline_t *p) {
+    if (!p)
+        return;
+
+    atomic_store_explicit(&p->stop, 1, memory_order_release);
+    fq_queue_wake(p->raw_q);
+    fq_queue_wake(p->raw_free);
+    fq_queue_wake(p->enc_free);
+
+    if (p->capture_started)
+        pthread_join(p->capture_thread, NULL);
+    if (p->encode_started)
+        pthread_join(p->encode_thread, NULL);
+
+    free_buffers(p);
+    free(p);
+}
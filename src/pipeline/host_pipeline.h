@@ -0,0 +1,123 @@
+/*
+ * host_pipeline.h — Staged capture → encode → send host pipeline
+ *
+ * Splits the host loop into three stages so capture of frame N+1 and
+ * encode of frame N overlap with the network send of frame N-1:
+ *
+ *   capture thread ──raw_q──▶ encode thread ──enc_q──▶ caller (send)
+ *
+ * The capture thread is paced on absolute deadlines (deadline_pacer.h)
+ * at the display refresh rate.  Both queues are small SPSC drop-oldest
+ * queues (frame_queue.h): a stalled downstream stage sheds stale frames
+ * instead of building latency.  When an encoded frame is shed the next
+ * frame is forced to a keyframe so clients never decode against a
+ * missing reference.
+ *
+ * All frame and bitstream buffers are allocated once at start and
+ * recycled through per-stage free lists; the steady state performs no
+ * heap allocation.
+ *
+ * Thread-safety: host_pipeline_next()/host_pipeline_release() must be
+ * called from a single (send) thread.  The encode thread owns
+ * ctx->encoder while the pipeline runs; other threads may only request
+ * keyframes and retarget the bitrate through the encoder_*() helpers in
+ * rootstream.h.
+ */
+
+#ifndef ROOTSTREAM_HOST_PIPELINE_H
+#define ROOTSTREAM_HOST_PIPELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../include/rootstream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_PIPELINE_DEFAULT_DEPTH 2 /**< Default per-stage queue depth */
+
+/** One encoded frame handed to the send stage */
+typedef struct {
+    uint8_t *data;       /**< Encoded bitstream */
+    size_t size;         /**< Bytes valid in data */
+    size_t capacity;     /**< Allocated bytes */
+    bool is_keyframe;    /**< Encoder reported an IDR/keyframe */
+    uint64_t timestamp;  /**< Capture timestamp (frame_buffer_t.timestamp) */
+
+    /* Stage timings (get_timestamp_us() clock) */
+    uint64_t capture_start_us;    /**< Capture call entered */
+    uint64_t capture_end_us;      /**< Capture call returned */
+    uint64_t encode_start_us;     /**< Encode call entered */
+    uint64_t encode_end_us;       /**< Encode call returned */
+    uint32_t capture_queue_depth; /**< Raw frames still queued at encode start */
+} host_encoded_frame_t;
+
+/** Pipeline counters (snapshot) */
+typedef struct {
+    uint64_t captured;          /**< Frames captured */
+    uint64_t capture_errors;    /**< Failed capture calls */
+    uint64_t capture_unchanged; /**< Ticks skipped on a static screen */
+    uint64_t capture_dropped;   /**< Raw frames shed before encode */
+    uint64_t encoded;           /**< Frames encoded */
+    uint64_t encode_errors;     /**< Failed encode calls */
+    uint64_t encode_dropped;    /**< Encoded frames shed before send */
+    uint64_t pacer_overruns;    /**< Capture ticks that missed their deadline */
+    uint32_t capture_peak;      /**< High-water mark of the raw queue */
+    uint32_t encode_peak;       /**< High-water mark of the encoded queue */
+} host_pipeline_stats_t;
+
+/** Opaque pipeline */
+typedef struct host_pipeline_s host_pipeline_t;
+
+/**
+ * host_pipeline_start — allocate buffers and launch capture/encode threads
+ *
+ * ctx->capture_backend and ctx->encoder_backend must already be
+ * initialised; ctx->current_frame supplies the raw frame geometry.
+ *
+ * @param ctx           Host context
+ * @param enc_buf_size  Bytes per encoded-frame buffer
+ * @param depth         Queue depth per stage (<= 0 → default)
+ * @return              Running pipeline, or NULL on failure
+ */
+host_pipeline_t *host_pipeline_start(rootstream_ctx_t *ctx, size_t enc_buf_size, int depth);
+
+/**
+ * host_pipeline_next — wait for the next encoded frame
+ *
+ * @param p           Pipeline
+ * @param timeout_us  Maximum wait in microseconds
+ * @param queue_depth Receives frames still queued after this one (may be NULL)
+ * @return            Frame owned by the caller until host_pipeline_release(),
+ *                    or NULL on timeout
+ */
+host_encoded_frame_t *host_pipeline_next(host_pipeline_t *p, uint64_t timeout_us,
+                                         uint32_t *queue_depth);
+
+/**
+ * host_pipeline_release — return a frame obtained from host_pipeline_next()
+ */
+void host_pipeline_release(host_pipeline_t *p, host_encoded_frame_t *frame);
+
+/**
+ * host_pipeline_get_stats — copy counters into *out
+ *
+ * @return 0 on success, -1 on NULL
+ */
+int host_pipeline_get_stats(const host_pipeline_t *p, host_pipeline_stats_t *out);
+
+/**
+ * host_pipeline_stop — stop and join the stage threads, free all buffers
+ *
+ * Any frame still held by the caller is invalidated.
+ */
+void host_pipeline_stop(host_pipeline_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_HOST_PIPELINE_H */
@@ -4,6 +4,7 @@
 
 #include "token_bucket.h"
 
+#include <math.h>
 #include <stdlib.h>
 
 struct token_bucket_s {
@@ -50,6 +51,16 @@ bool token_bucket_consume(token_bucket_t *tb, double n, uint64_t now_us) {
     return true;
 }
 
+uint64_t token_bucket_reserve(token_bucket_t *tb, double n, uint64_t now_us) {
+    if (!tb || n <= 0.0)
+        return now_us;
+    refill(tb, now_us);
+    tb->tokens -= n;
+    if (tb->tokens >= 0.0)
+        return now_us;
+    return now_us + (uint64_t)ceil(-tb->tokens / tb->rate_per_us);
+}
+
 double token_bucket_available(token_bucket_t *tb, uint64_t now_us) {
     if (!tb)
         return 0.0;
@@ -55,6 +55,21 @@ void token_bucket_destroy(token_bucket_t *tb);
  */
 bool token_bucket_consume(token_bucket_t *tb, double n, uint64_t now_us);
 
+/**
+ * token_bucket_reserve — take @n tokens now, on credit if need be
+ *
+ * Unlike consume() this always succeeds: the level may go negative and
+ * the refill pays the debt back first.  The return value is when the
+ * debt is paid, i.e. the earliest time @n tokens would have been there,
+ * which makes the bucket a departure-time pacer.
+ *
+ * @param tb      Bucket
+ * @param n       Tokens taken (e.g. packet bytes)
+ * @param now_us  Current wall-clock time in µs
+ * @return        Time in µs (≥ @now_us) the reservation is covered at
+ */
+uint64_t token_bucket_reserve(token_bucket_t *tb, double n, uint64_t now_us);
+
 /**
  * token_bucket_available — return current token level
  *
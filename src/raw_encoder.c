@@ -1,20 +1,22 @@
 /*
  * raw_encoder.c - Raw frame pass-through encoder for debugging
  *
- * Passes raw RGBA frames with minimal overhead. Huge bandwidth, but:
+ * Passes uncompressed NV12 frames with minimal overhead (the capture's
+ * RGBA/BGRA goes through the shared colorconv kernels, 1.5 bytes/pixel
+ * instead of 4). Huge bandwidth, but:
  * - Validates full pipeline without compression
  * - Useful for debugging encoder issues
  * - Never fails (always available)
  *
  * Frame format:
  *   [Header: 24 bytes]
- *   [Raw RGBA data]
+ *   [Y plane: width x height][UV plane: interleaved, half resolution]
  *
  * Header structure:
  *   uint32_t magic         - 0x52535452 "RSTR"
  *   uint32_t width         - Frame width
  *   uint32_t height        - Frame height
- *   uint32_t format        - Pixel format (1 = RGBA)
+ *   uint32_t format        - Pixel format (1 = RGBA, 2 = NV12)
  *   uint64_t timestamp_us  - Capture timestamp
  */
 
@@ -23,9 +25,11 @@
 #include <string.h>
 
 #include "../include/rootstream.h"
+#include "colorconv/colorconv.h"
 
 #define RAW_MAGIC 0x52535452 /* "RSTR" */
 #define RAW_FORMAT_RGBA 1
+#define RAW_FORMAT_NV12 2
 
 typedef struct {
     uint32_t magic;
@@ -39,6 +43,7 @@ typedef struct {
     int width;
     int height;
     uint64_t frame_count;
+    colorconv_t *cc;
 } raw_ctx_t;
 
 /*
@@ -62,12 +67,20 @@ int rootstream_encoder_init_raw(rootstream_ctx_t *ctx, codec_type_t codec) {
     raw->width = ctx->display.width;
     raw->height = ctx->display.height;
     raw->frame_count = 0;
+    raw->cc = colorconv_create(colorconv_matrix_for_height(raw->height), COLORCONV_RANGE_LIMITED,
+                               0);
+    if (!raw->cc) {
+        fprintf(stderr, "ERROR: Cannot create color converter\n");
+        free(raw);
+        return -1;
+    }
 
     ctx->encoder.type = ENCODER_RAW;
     ctx->encoder.codec = codec; /* Store but not used */
     ctx->encoder.hw_ctx = raw;
     ctx->encoder.low_latency = true;
-    ctx->encoder.max_output_size = sizeof(raw_header_t) + (size_t)raw->width * raw->height * 4;
+    ctx->encoder.max_output_size =
+        sizeof(raw_header_t) + colorconv_image_size(COLORCONV_NV12, raw->width, raw->height);
 
     size_t bandwidth_mb_per_sec =
         (ctx->encoder.max_output_size * ctx->display.refresh_rate) / (1024 * 1024);
@@ -80,7 +93,7 @@ int rootstream_encoder_init_raw(rootstream_ctx_t *ctx, codec_type_t codec) {
 }
 
 /*
- * Encode raw frame (just copy with header)
+ * Encode raw frame (convert to NV12 behind the header)
  */
 int rootstream_encode_frame_raw(rootstream_ctx_t *ctx, frame_buffer_t *in, uint8_t *out,
                                 size_t *out_size) {
@@ -94,19 +107,41 @@ int rootstream_encode_frame_raw(rootstream_ctx_t *ctx, frame_buffer_t *in, uint8
         return -1;
     }
 
+    const uint8_t *pixels = frame_buffer_pixels(in);
+    if (!pixels) {
+        fprintf(stderr, "ERROR: Frame has no CPU-readable pixels\n");
+        return -1;
+    }
+
     /* Build header */
     raw_header_t header = {.magic = RAW_MAGIC,
                            .width = in->width,
                            .height = in->height,
-                           .format = RAW_FORMAT_RGBA,
+                           .format = RAW_FORMAT_NV12,
                            .timestamp_us = in->timestamp};
 
     /* Copy header */
     memcpy(out, &header, sizeof(header));
 
-    /* Copy raw frame data */
-    size_t data_size = (size_t)in->width * in->height * 4;
-    memcpy(out + sizeof(header), in->data, data_size);
+    /* Convert frame data */
+    colorconv_image_t src, dst;
+    colorconv_image_init(&src, in->format == FRAME_FORMAT_BGRA ? COLORCONV_BGRA : COLORCONV_RGBA,
+                         (int)in->width, (int)in->height, (uint8_t *)pixels);
+    if (in->pitch) {
+        src.stride[0] = (int)in->pitch;
+    }
+    size_t data_size = colorconv_image_size(COLORCONV_NV12, (int)in->width, (int)in->height);
+    if (ctx->encoder.max_output_size > 0 &&
+        sizeof(header) + data_size > ctx->encoder.max_output_size) {
+        fprintf(stderr, "ERROR: Raw frame %ux%u exceeds output buffer\n", in->width, in->height);
+        return -1;
+    }
+    colorconv_image_init(&dst, COLORCONV_NV12, (int)in->width, (int)in->height,
+                         out + sizeof(header));
+    if (colorconv_convert(raw->cc, &src, &dst) != 0) {
+        fprintf(stderr, "ERROR: Cannot convert raw frame to NV12\n");
+        return -1;
+    }
 
     *out_size = sizeof(header) + data_size;
 
@@ -127,6 +162,7 @@ void rootstream_encoder_cleanup_raw(rootstream_ctx_t *ctx) {
     }
 
     raw_ctx_t *raw = (raw_ctx_t *)ctx->encoder.hw_ctx;
+    colorconv_destroy(raw->cc);
     free(raw);
     ctx->encoder.hw_ctx = NULL;
 }
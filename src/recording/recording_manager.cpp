@@ -750,6 +750,15 @@ int RecordingManager::disable_replay_buffer() {
     return 0;
 }
 
+static void on_replay_saved(int result, uint32_t frames_written, void *user) {
+    (void)user;
+    if (result != 0) {
+        fprintf(stderr, "ERROR: Failed to save replay buffer\n");
+        return;
+    }
+    printf("✓ Replay buffer saved successfully (%u frames)\n", frames_written);
+}
+
 int RecordingManager::save_replay_buffer(const char *filename, uint32_t duration_sec) {
     if (!replay_buffer_enabled || !replay_buffer) {
         fprintf(stderr, "ERROR: Replay buffer not enabled\n");
@@ -784,13 +793,14 @@ int RecordingManager::save_replay_buffer(const char *filename, uint32_t duration
     
     printf("Saving replay buffer to: %s\n", filepath);
     
-    int ret = replay_buffer_save(replay_buffer, filepath, duration_sec, codec);
+    // Muxes on the replay buffer's save thread; capture keeps running
+    int ret = replay_buffer_save_async(replay_buffer, filepath, duration_sec, codec,
+                                       on_replay_saved, nullptr);
     if (ret != 0) {
         fprintf(stderr, "ERROR: Failed to save replay buffer\n");
         return -1;
     }
     
-    printf("✓ Replay buffer saved successfully\n");
     return 0;
 }
 
@@ -817,13 +827,14 @@ int RecordingManager::save_replay_buffer(const char *filename, uint32_t duration
     
     printf("Saving replay buffer to: %s with specified codec: %d\n", filepath, codec);
     
-    int ret = replay_buffer_save(replay_buffer, filepath, duration_sec, codec);
+    // Muxes on the replay buffer's save thread; capture keeps running
+    int ret = replay_buffer_save_async(replay_buffer, filepath, duration_sec, codec,
+                                       on_replay_saved, nullptr);
     if (ret != 0) {
         fprintf(stderr, "ERROR: Failed to save replay buffer\n");
         return -1;
     }
     
-    printf("✓ Replay buffer saved successfully\n");
     return 0;
 }
 
@@ -2,8 +2,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <atomic>
 #include <deque>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -11,105 +16,293 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+/*
+ * Layout
+ * ------
+ * The arena is used as a FIFO of variable-sized records.  Each record
+ * is contiguous: when one does not fit before the end of the arena it
+ * starts again at offset 0 and the bytes skipped at the end come back
+ * when the records before them are evicted.  Every record is followed
+ * by AV_INPUT_BUFFER_PADDING_SIZE zero bytes, so FFmpeg can read video
+ * frames in place.
+ *
+ * Record metadata lives in a fixed ring of entries addressed by a
+ * free-running sequence number (slot = seq % capacity); the live
+ * entries are [first_seq, next_seq).  keyframes holds the sequence
+ * numbers of the video keyframes among them.
+ *
+ * Pinning: entries with seq >= pin_seq are never evicted.  A save sets
+ * pin_seq to the first entry it needs and advances it after muxing
+ * each entry, so space is handed back while the save is still running.
+ */
+
+#define REPLAY_RECORD_ALIGN 64
+
+// Extra arena space for per-record padding and the gap left when a
+// record wraps, so max_memory_mb is available for payload
+#define REPLAY_ARENA_HEADROOM (1u << 20)
+
+enum replay_entry_kind : uint8_t {
+    REPLAY_ENTRY_VIDEO,
+    REPLAY_ENTRY_AUDIO,
+};
+
+struct replay_entry {
+    size_t offset;          // Arena offset of the payload
+    size_t size;            // Payload bytes
+    size_t span;            // Bytes reserved (payload + padding, aligned)
+    uint64_t timestamp_us;
+    uint32_t width;         // Video: width;  audio: sample rate
+    uint32_t height;        // Video: height; audio: channels
+    uint8_t kind;
+    bool is_keyframe;
+};
+
 struct replay_buffer {
-    std::deque<replay_video_frame_t> video_frames;
-    std::deque<replay_audio_chunk_t> audio_chunks;
-    
+    uint8_t *arena;
+    size_t arena_bytes;
+    size_t head;                         // Next free arena offset
+
+    std::vector<replay_entry> entries;   // Preallocated entry ring
+    uint64_t first_seq;
+    uint64_t next_seq;
+    std::deque<uint64_t> keyframes;      // Video keyframe seqs, oldest first
+
     uint32_t duration_seconds;
     uint32_t max_memory_mb;
-    
+
     uint64_t total_memory_bytes;
-    uint64_t oldest_timestamp_us;
     uint64_t newest_timestamp_us;
-    
-    std::mutex video_mutex;
-    std::mutex audio_mutex;
+    uint32_t video_count;
+    uint32_t audio_count;
+    uint64_t dropped;
+    uint64_t evicted;
+    bool need_keyframe;                  // A video frame was dropped
+
+    std::mutex mutex;
+    std::atomic<uint64_t> pin_seq;       // UINT64_MAX = nothing pinned
+    bool saving;
+    std::thread save_thread;
+    int last_save_result;
+};
+
+/* Range fixed by a save when it starts */
+struct save_range {
+    uint64_t start_seq;
+    uint64_t end_seq;
 };
 
+static inline replay_entry &entry_at(replay_buffer_t *buffer, uint64_t seq) {
+    return buffer->entries[seq % buffer->entries.size()];
+}
+
 replay_buffer_t* replay_buffer_create(uint32_t duration_seconds, uint32_t max_memory_mb) {
     if (duration_seconds == 0 || duration_seconds > MAX_REPLAY_BUFFER_SECONDS) {
         fprintf(stderr, "Replay Buffer: Invalid duration: %u (max: %u)\n",
                 duration_seconds, MAX_REPLAY_BUFFER_SECONDS);
         return nullptr;
     }
-    
+
     replay_buffer_t *buffer = new replay_buffer_t;
     if (!buffer) {
         fprintf(stderr, "Replay Buffer: Failed to allocate buffer\n");
         return nullptr;
     }
-    
+
     buffer->duration_seconds = duration_seconds;
-    buffer->max_memory_mb = max_memory_mb;
+    buffer->max_memory_mb = max_memory_mb ? max_memory_mb : DEFAULT_REPLAY_BUFFER_SIZE_MB;
+    buffer->arena_bytes = (size_t)buffer->max_memory_mb * 1024 * 1024 + REPLAY_ARENA_HEADROOM;
+
+    // One mapping for the lifetime of the buffer, populated now so the
+    // first lap does not page-fault on the capture thread
+    void *arena = mmap(nullptr, buffer->arena_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (arena == MAP_FAILED) {
+        fprintf(stderr, "Replay Buffer: Failed to allocate %u MB ring\n", buffer->max_memory_mb);
+        delete buffer;
+        return nullptr;
+    }
+    buffer->arena = (uint8_t *)arena;
+    buffer->entries.resize((size_t)duration_seconds * REPLAY_ENTRIES_PER_SECOND);
+
+    buffer->head = 0;
+    buffer->first_seq = 0;
+    buffer->next_seq = 0;
     buffer->total_memory_bytes = 0;
-    buffer->oldest_timestamp_us = 0;
     buffer->newest_timestamp_us = 0;
-    
+    buffer->video_count = 0;
+    buffer->audio_count = 0;
+    buffer->dropped = 0;
+    buffer->evicted = 0;
+    buffer->need_keyframe = false;
+    buffer->pin_seq.store(UINT64_MAX);
+    buffer->saving = false;
+    buffer->last_save_result = 0;
+
     printf("Replay Buffer created: %u seconds, max memory: %u MB\n",
-           duration_seconds, max_memory_mb);
-    
+           duration_seconds, buffer->max_memory_mb);
+
     return buffer;
 }
 
-static void cleanup_old_frames(replay_buffer_t *buffer, uint64_t current_timestamp_us) {
-    if (!buffer) return;
-    
+/* ── Eviction (caller holds mutex) ─────────────────────────────────── */
+
+static void evict_front(replay_buffer_t *buffer) {
+    const replay_entry &oldest = entry_at(buffer, buffer->first_seq);
+    buffer->total_memory_bytes -= oldest.size;
+    if (oldest.kind == REPLAY_ENTRY_VIDEO) {
+        buffer->video_count--;
+        if (!buffer->keyframes.empty() && buffer->keyframes.front() == buffer->first_seq) {
+            buffer->keyframes.pop_front();
+        }
+    } else {
+        buffer->audio_count--;
+    }
+    buffer->first_seq++;
+    buffer->evicted++;
+
+    if (buffer->first_seq == buffer->next_seq) {
+        buffer->head = 0;
+    }
+}
+
+static bool front_evictable(replay_buffer_t *buffer) {
+    return buffer->first_seq < buffer->next_seq &&
+           buffer->first_seq < buffer->pin_seq.load(std::memory_order_acquire);
+}
+
+static bool front_is_keyframe(replay_buffer_t *buffer) {
+    return !buffer->keyframes.empty() && buffer->keyframes.front() == buffer->first_seq;
+}
+
+/*
+ * Evict the oldest entry and everything up to the next keyframe, so the
+ * buffer keeps starting on one.  Fails if the oldest entry is pinned.
+ */
+static bool evict_gop(replay_buffer_t *buffer) {
+    if (!front_evictable(buffer)) {
+        return false;
+    }
+
+    evict_front(buffer);
+    while (front_evictable(buffer) && !front_is_keyframe(buffer)) {
+        evict_front(buffer);
+    }
+    return true;
+}
+
+/*
+ * Drop whole GOPs that lie entirely before the window, so at least
+ * duration_seconds stay available and the buffer starts on a keyframe.
+ */
+static void cleanup_old_frames(replay_buffer_t *buffer) {
     uint64_t max_age_us = (uint64_t)buffer->duration_seconds * 1000000;
-    
-    // Remove old video frames
-    while (!buffer->video_frames.empty()) {
-        const auto &oldest = buffer->video_frames.front();
-        if (current_timestamp_us - oldest.timestamp_us > max_age_us) {
-            buffer->total_memory_bytes -= oldest.size;
-            free(oldest.data);
-            buffer->video_frames.pop_front();
-        } else {
-            break;
+    if (buffer->newest_timestamp_us < max_age_us) {
+        return;
+    }
+    uint64_t cutoff_us = buffer->newest_timestamp_us - max_age_us;
+
+    // No keyframes (audio only, or deltas after a drop): plain age limit
+    if (buffer->keyframes.empty()) {
+        while (front_evictable(buffer) &&
+               entry_at(buffer, buffer->first_seq).timestamp_us < cutoff_us) {
+            evict_front(buffer);
         }
+        return;
     }
-    
-    // Remove old audio chunks
-    while (!buffer->audio_chunks.empty()) {
-        const auto &oldest = buffer->audio_chunks.front();
-        if (current_timestamp_us - oldest.timestamp_us > max_age_us) {
-            buffer->total_memory_bytes -= oldest.sample_count * sizeof(float);
-            free(oldest.samples);
-            buffer->audio_chunks.pop_front();
-        } else {
+
+    for (;;) {
+        // First keyframe after the oldest entry
+        size_t k = front_is_keyframe(buffer) ? 1 : 0;
+        if (k >= buffer->keyframes.size()) {
+            break;
+        }
+        uint64_t next_key = buffer->keyframes[k];
+        if (entry_at(buffer, next_key).timestamp_us > cutoff_us) {
             break;
         }
+
+        while (buffer->first_seq < next_key && front_evictable(buffer)) {
+            evict_front(buffer);
+        }
+        if (buffer->first_seq < next_key) {
+            break;  // pinned by a save
+        }
     }
-    
-    // Update oldest timestamp
-    if (!buffer->video_frames.empty()) {
-        buffer->oldest_timestamp_us = buffer->video_frames.front().timestamp_us;
-    } else if (!buffer->audio_chunks.empty()) {
-        buffer->oldest_timestamp_us = buffer->audio_chunks.front().timestamp_us;
+}
+
+/*
+ * Reserve @span contiguous arena bytes, evicting GOPs as needed.
+ * Returns the offset, or SIZE_MAX if a pinned save is in the way.
+ */
+static size_t arena_alloc(replay_buffer_t *buffer, size_t span) {
+    for (;;) {
+        bool slot_free = buffer->next_seq - buffer->first_seq < buffer->entries.size();
+
+        if (buffer->first_seq == buffer->next_seq) {
+            buffer->head = 0;
+            return 0;
+        }
+
+        if (slot_free) {
+            size_t tail = entry_at(buffer, buffer->first_seq).offset;
+            if (buffer->head > tail) {
+                // Live bytes are [tail, head): room at the end, or wrap
+                if (buffer->arena_bytes - buffer->head >= span) {
+                    return buffer->head;
+                }
+                if (tail >= span) {
+                    return 0;
+                }
+            } else if (tail - buffer->head >= span) {
+                // Wrapped: live bytes are [tail, end) and [0, head)
+                return buffer->head;
+            }
+        }
+
+        if (!evict_gop(buffer)) {
+            return SIZE_MAX;
+        }
     }
 }
 
-static void enforce_memory_limit(replay_buffer_t *buffer) {
-    if (!buffer || buffer->max_memory_mb == 0) return;
-    
-    uint64_t max_memory_bytes = (uint64_t)buffer->max_memory_mb * 1024 * 1024;
-    
-    // Remove oldest frames until we're under the limit
-    while (buffer->total_memory_bytes > max_memory_bytes &&
-           !buffer->video_frames.empty()) {
-        const auto &oldest = buffer->video_frames.front();
-        buffer->total_memory_bytes -= oldest.size;
-        free(oldest.data);
-        buffer->video_frames.pop_front();
-    }
-    
-    // Remove oldest audio if still over limit
-    while (buffer->total_memory_bytes > max_memory_bytes &&
-           !buffer->audio_chunks.empty()) {
-        const auto &oldest = buffer->audio_chunks.front();
-        buffer->total_memory_bytes -= oldest.sample_count * sizeof(float);
-        free(oldest.samples);
-        buffer->audio_chunks.pop_front();
+/* Copy one record in; caller holds mutex */
+static int append_entry(replay_buffer_t *buffer, const void *data, size_t size,
+                        const replay_entry &meta) {
+    size_t span = (size + AV_INPUT_BUFFER_PADDING_SIZE + REPLAY_RECORD_ALIGN - 1) &
+                  ~(size_t)(REPLAY_RECORD_ALIGN - 1);
+    if (span > buffer->arena_bytes) {
+        fprintf(stderr, "Replay Buffer: %zu-byte entry exceeds the %u MB ring\n",
+                size, buffer->max_memory_mb);
+        return -1;
     }
+
+    size_t offset = arena_alloc(buffer, span);
+    if (offset == SIZE_MAX) {
+        buffer->dropped++;
+        return -1;
+    }
+
+    memcpy(buffer->arena + offset, data, size);
+    memset(buffer->arena + offset + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    replay_entry &e = entry_at(buffer, buffer->next_seq);
+    e = meta;
+    e.offset = offset;
+    e.size = size;
+    e.span = span;
+    if (e.kind == REPLAY_ENTRY_VIDEO && e.is_keyframe) {
+        buffer->keyframes.push_back(buffer->next_seq);
+    }
+    buffer->next_seq++;
+    buffer->head = offset + span;
+    buffer->total_memory_bytes += size;
+    if (meta.timestamp_us > buffer->newest_timestamp_us) {
+        buffer->newest_timestamp_us = meta.timestamp_us;
+    }
+
+    cleanup_old_frames(buffer);
+    return 0;
 }
 
 int replay_buffer_add_video_frame(replay_buffer_t *buffer,
@@ -122,37 +315,29 @@ int replay_buffer_add_video_frame(replay_buffer_t *buffer,
     if (!buffer || !frame_data || size == 0) {
         return -1;
     }
-    
-    std::lock_guard<std::mutex> lock(buffer->video_mutex);
-    
-    // Allocate and copy frame data
-    uint8_t *data_copy = (uint8_t *)malloc(size);
-    if (!data_copy) {
-        fprintf(stderr, "Replay Buffer: Failed to allocate frame memory\n");
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    // A delta whose reference was dropped cannot be decoded
+    if (buffer->need_keyframe && !is_keyframe) {
+        buffer->dropped++;
         return -1;
     }
-    memcpy(data_copy, frame_data, size);
-    
-    // Create frame entry
-    replay_video_frame_t frame;
-    frame.data = data_copy;
-    frame.size = size;
-    frame.timestamp_us = timestamp_us;
-    frame.width = width;
-    frame.height = height;
-    frame.is_keyframe = is_keyframe;
-    
-    // Add to buffer
-    buffer->video_frames.push_back(frame);
-    buffer->total_memory_bytes += size;
-    buffer->newest_timestamp_us = timestamp_us;
-    
-    // Cleanup old frames based on time
-    cleanup_old_frames(buffer, timestamp_us);
-    
-    // Enforce memory limit
-    enforce_memory_limit(buffer);
-    
+
+    replay_entry meta = {};
+    meta.timestamp_us = timestamp_us;
+    meta.width = width;
+    meta.height = height;
+    meta.kind = REPLAY_ENTRY_VIDEO;
+    meta.is_keyframe = is_keyframe;
+
+    if (append_entry(buffer, frame_data, size, meta) < 0) {
+        buffer->need_keyframe = true;
+        return -1;
+    }
+    buffer->need_keyframe = false;
+    buffer->video_count++;
+
     return 0;
 }
 
@@ -165,69 +350,95 @@ int replay_buffer_add_audio_chunk(replay_buffer_t *buffer,
     if (!buffer || !samples || sample_count == 0) {
         return -1;
     }
-    
-    std::lock_guard<std::mutex> lock(buffer->audio_mutex);
-    
-    // Allocate and copy audio data
-    size_t data_size = sample_count * sizeof(float);
-    float *samples_copy = (float *)malloc(data_size);
-    if (!samples_copy) {
-        fprintf(stderr, "Replay Buffer: Failed to allocate audio memory\n");
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    replay_entry meta = {};
+    meta.timestamp_us = timestamp_us;
+    meta.width = sample_rate;
+    meta.height = channels;
+    meta.kind = REPLAY_ENTRY_AUDIO;
+
+    if (append_entry(buffer, samples, sample_count * sizeof(float), meta) < 0) {
         return -1;
     }
-    memcpy(samples_copy, samples, data_size);
-    
-    // Create audio chunk entry
-    replay_audio_chunk_t chunk;
-    chunk.samples = samples_copy;
-    chunk.sample_count = sample_count;
-    chunk.timestamp_us = timestamp_us;
-    chunk.sample_rate = sample_rate;
-    chunk.channels = channels;
-    
-    // Add to buffer
-    buffer->audio_chunks.push_back(chunk);
-    buffer->total_memory_bytes += data_size;
-    buffer->newest_timestamp_us = timestamp_us;
-    
-    // Cleanup old chunks based on time
-    cleanup_old_frames(buffer, timestamp_us);
-    
-    // Enforce memory limit
-    enforce_memory_limit(buffer);
-    
+    buffer->audio_count++;
+
     return 0;
 }
 
-int replay_buffer_save(replay_buffer_t *buffer,
-                       const char *filename,
-                       uint32_t duration_sec,
-                       enum VideoCodec video_codec) {
-    if (!buffer || !filename) {
+/* ── Saving ────────────────────────────────────────────────────────── */
+
+/*
+ * Fix the range to save and pin it.  Starts at the last keyframe at or
+ * before the cutoff, so the clip decodes from its first frame and covers
+ * at least the requested duration when the buffer has it.
+ */
+static int save_begin(replay_buffer_t *buffer, uint32_t duration_sec, save_range *range) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    if (buffer->saving) {
+        fprintf(stderr, "Replay Buffer: A save is already in progress\n");
         return -1;
     }
-    
-    std::lock_guard<std::mutex> video_lock(buffer->video_mutex);
-    std::lock_guard<std::mutex> audio_lock(buffer->audio_mutex);
-    
-    if (buffer->video_frames.empty()) {
+    if (buffer->video_count == 0) {
         fprintf(stderr, "Replay Buffer: No video frames to save\n");
         return -1;
     }
-    
-    printf("Replay Buffer: Saving %u frames to '%s' with codec %d\n",
-           (uint32_t)buffer->video_frames.size(), filename, video_codec);
-    
-    // Calculate time range to save
-    uint64_t save_duration_us;
-    if (duration_sec == 0) {
-        save_duration_us = buffer->newest_timestamp_us - buffer->oldest_timestamp_us;
-    } else {
-        save_duration_us = (uint64_t)duration_sec * 1000000;
+
+    uint64_t start = buffer->first_seq;
+    if (!buffer->keyframes.empty()) {
+        start = buffer->keyframes.front();
+        if (duration_sec != 0) {
+            uint64_t span_us = (uint64_t)duration_sec * 1000000;
+            uint64_t cutoff_us = buffer->newest_timestamp_us > span_us
+                                     ? buffer->newest_timestamp_us - span_us
+                                     : 0;
+            for (uint64_t seq : buffer->keyframes) {
+                if (entry_at(buffer, seq).timestamp_us > cutoff_us) {
+                    break;
+                }
+                start = seq;
+            }
+        }
     }
-    
-    uint64_t cutoff_timestamp_us = buffer->newest_timestamp_us - save_duration_us;
-    
+
+    range->start_seq = start;
+    range->end_seq = buffer->next_seq;
+    buffer->pin_seq.store(start, std::memory_order_release);
+    buffer->saving = true;
+    return 0;
+}
+
+static void save_end(replay_buffer_t *buffer) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    buffer->pin_seq.store(UINT64_MAX, std::memory_order_release);
+    buffer->saving = false;
+}
+
+/*
+ * Mux a pinned range.  Runs without the buffer lock: pinned entries and
+ * their arena bytes cannot change until the pin moves past them.
+ */
+static int mux_range(replay_buffer_t *buffer, const save_range &range, const char *filename,
+                     enum VideoCodec video_codec, uint32_t *frames_out) {
+    *frames_out = 0;
+
+    const replay_entry *first_frame = nullptr;
+    for (uint64_t seq = range.start_seq; seq < range.end_seq; seq++) {
+        if (entry_at(buffer, seq).kind == REPLAY_ENTRY_VIDEO) {
+            first_frame = &entry_at(buffer, seq);
+            break;
+        }
+    }
+    if (!first_frame) {
+        fprintf(stderr, "Replay Buffer: No video frames to save\n");
+        return -1;
+    }
+
+    printf("Replay Buffer: Saving %u entries to '%s' with codec %d\n",
+           (uint32_t)(range.end_seq - range.start_seq), filename, video_codec);
+
     // Initialize FFmpeg output
     AVFormatContext *fmt_ctx = nullptr;
     int ret = avformat_alloc_output_context2(&fmt_ctx, nullptr, nullptr, filename);
@@ -235,66 +446,43 @@ int replay_buffer_save(replay_buffer_t *buffer,
         fprintf(stderr, "Replay Buffer: Failed to allocate output context\n");
         return -1;
     }
-    
+
     // Create video stream
-    AVStream *video_stream = nullptr;
-    if (!buffer->video_frames.empty()) {
-        const replay_video_frame_t &first_frame = buffer->video_frames.front();
-        
-        video_stream = avformat_new_stream(fmt_ctx, nullptr);
-        if (!video_stream) {
-            fprintf(stderr, "Replay Buffer: Failed to create video stream\n");
-            avformat_free_context(fmt_ctx);
-            return -1;
-        }
-        
-        video_stream->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
-        
-        // Set codec ID based on specified codec
-        switch (video_codec) {
-            case VIDEO_CODEC_H264:
-                video_stream->codecpar->codec_id = AV_CODEC_ID_H264;
-                break;
-            case VIDEO_CODEC_VP9:
-                video_stream->codecpar->codec_id = AV_CODEC_ID_VP9;
-                break;
-            case VIDEO_CODEC_AV1:
-                video_stream->codecpar->codec_id = AV_CODEC_ID_AV1;
-                break;
-            default:
-                fprintf(stderr, "Replay Buffer: Unknown codec %d, defaulting to H.264\n", video_codec);
-                video_stream->codecpar->codec_id = AV_CODEC_ID_H264;
-                break;
-        }
-        
-        video_stream->codecpar->width = first_frame.width;
-        video_stream->codecpar->height = first_frame.height;
-        video_stream->time_base = (AVRational){1, 1000000}; // Microseconds
+    AVStream *video_stream = avformat_new_stream(fmt_ctx, nullptr);
+    if (!video_stream) {
+        fprintf(stderr, "Replay Buffer: Failed to create video stream\n");
+        avformat_free_context(fmt_ctx);
+        return -1;
+    }
+
+    video_stream->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+
+    // Set codec ID based on specified codec
+    switch (video_codec) {
+        case VIDEO_CODEC_H264:
+            video_stream->codecpar->codec_id = AV_CODEC_ID_H264;
+            break;
+        case VIDEO_CODEC_VP9:
+            video_stream->codecpar->codec_id = AV_CODEC_ID_VP9;
+            break;
+        case VIDEO_CODEC_AV1:
+            video_stream->codecpar->codec_id = AV_CODEC_ID_AV1;
+            break;
+        default:
+            fprintf(stderr, "Replay Buffer: Unknown codec %d, defaulting to H.264\n", video_codec);
+            video_stream->codecpar->codec_id = AV_CODEC_ID_H264;
+            break;
     }
-    
-    // Create audio stream if audio chunks exist
+
+    video_stream->codecpar->width = first_frame->width;
+    video_stream->codecpar->height = first_frame->height;
+    video_stream->time_base = (AVRational){1, 1000000}; // Microseconds
+
     // TODO: Audio encoding not yet fully implemented
-    // Audio stream creation is disabled until proper Opus encoding is added
-    AVStream *audio_stream = nullptr;
-    /*
-    if (!buffer->audio_chunks.empty()) {
-        const replay_audio_chunk_t &first_chunk = buffer->audio_chunks.front();
-        
-        audio_stream = avformat_new_stream(fmt_ctx, nullptr);
-        if (!audio_stream) {
-            fprintf(stderr, "Replay Buffer: Failed to create audio stream\n");
-            avformat_free_context(fmt_ctx);
-            return -1;
-        }
-        
-        audio_stream->codecpar->codec_type = AVMEDIA_TYPE_AUDIO;
-        audio_stream->codecpar->codec_id = AV_CODEC_ID_OPUS; // Assume Opus encoded audio
-        audio_stream->codecpar->ch_layout.nb_channels = first_chunk.channels;
-        audio_stream->codecpar->sample_rate = first_chunk.sample_rate;
-        audio_stream->time_base = (AVRational){1, 1000000}; // Microseconds
-    }
-    */
-    
+    // Audio chunks are raw float samples that need to be encoded to Opus
+    // before they can be muxed; once they are, write packets with
+    // av_interleaved_write_frame() instead of av_write_frame() below.
+
     // Open output file
     if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
         ret = avio_open(&fmt_ctx->pb, filename, AVIO_FLAG_WRITE);
@@ -304,7 +492,7 @@ int replay_buffer_save(replay_buffer_t *buffer,
             return -1;
         }
     }
-    
+
     // Write header
     ret = avformat_write_header(fmt_ctx, nullptr);
     if (ret < 0) {
@@ -315,111 +503,131 @@ int replay_buffer_save(replay_buffer_t *buffer,
         avformat_free_context(fmt_ctx);
         return -1;
     }
-    
-    // Write video and audio frames in timestamp order
-    size_t video_idx = 0;
-    size_t audio_idx = 0;
-    size_t frames_written = 0;
-    
-    while (video_idx < buffer->video_frames.size() || audio_idx < buffer->audio_chunks.size()) {
-        bool write_video = false;
-        
-        // Determine which packet to write next (video or audio)
-        if (video_idx < buffer->video_frames.size() && audio_idx < buffer->audio_chunks.size()) {
-            // Both available, choose based on timestamp
-            write_video = buffer->video_frames[video_idx].timestamp_us <= 
-                         buffer->audio_chunks[audio_idx].timestamp_us;
-        } else if (video_idx < buffer->video_frames.size()) {
-            write_video = true;
-        } else {
-            write_video = false;
-        }
-        
-        if (write_video) {
-            const auto &frame = buffer->video_frames[video_idx];
-            if (frame.timestamp_us >= cutoff_timestamp_us) {
-                // Allocate memory for packet data
-                uint8_t *data_copy = (uint8_t *)av_memdup(frame.data, frame.size);
-                if (!data_copy) {
-                    fprintf(stderr, "Replay Buffer: Failed to allocate packet data\n");
-                    video_idx++;
-                    continue;
-                }
-                
-                AVPacket *pkt = av_packet_alloc();
-                if (pkt) {
-                    // Use av_packet_from_data to properly manage packet data ownership
-                    int ret = av_packet_from_data(pkt, data_copy, frame.size);
-                    if (ret < 0) {
-                        av_free(data_copy); // Free the allocated memory
-                        av_packet_free(&pkt);
-                        video_idx++;
-                        continue;
-                    }
-                    
-                    pkt->stream_index = video_stream->index;
-                    pkt->pts = frame.timestamp_us;
-                    pkt->dts = frame.timestamp_us;
-                    
-                    if (frame.is_keyframe) {
-                        pkt->flags |= AV_PKT_FLAG_KEY;
-                    }
-                    
-                    av_interleaved_write_frame(fmt_ctx, pkt);
-                    frames_written++;
-                    av_packet_free(&pkt);
-                }
+
+    AVPacket *pkt = av_packet_alloc();
+    if (!pkt) {
+        fprintf(stderr, "Replay Buffer: Failed to allocate packet\n");
+    }
+
+    // Packets point into the arena (not reference counted, so the muxer
+    // neither copies nor keeps them past av_write_frame()); one stream in
+    // timestamp order needs no interleaving
+    for (uint64_t seq = range.start_seq; pkt && seq < range.end_seq; seq++) {
+        const replay_entry &frame = entry_at(buffer, seq);
+        if (frame.kind == REPLAY_ENTRY_VIDEO) {
+            pkt->data = buffer->arena + frame.offset;
+            pkt->size = (int)frame.size;
+            pkt->stream_index = video_stream->index;
+            pkt->pts = frame.timestamp_us;
+            pkt->dts = frame.timestamp_us;
+            pkt->flags = frame.is_keyframe ? AV_PKT_FLAG_KEY : 0;
+
+            if (av_write_frame(fmt_ctx, pkt) >= 0) {
+                (*frames_out)++;
             }
-            video_idx++;
-        } else {
-            // TODO: Audio encoding not yet implemented
-            // Audio chunks in replay buffer are raw float samples that need to be 
-            // encoded to Opus before muxing. Skip audio chunks for now.
-            // When implementing:
-            // 1. Encode float samples to Opus
-            // 2. Create packet from encoded data
-            // 3. Set proper pts/dts
-            // 4. Write packet to muxer
-            audio_idx++;
+            av_packet_unref(pkt);
         }
+
+        // Hand the entry back to capture
+        buffer->pin_seq.store(seq + 1, std::memory_order_release);
     }
-    
+    av_packet_free(&pkt);
+
     // Write trailer
     av_write_trailer(fmt_ctx);
-    
+
     // Close output file
     if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
         avio_closep(&fmt_ctx->pb);
     }
-    
+
     avformat_free_context(fmt_ctx);
-    
-    printf("Replay Buffer: Saved %zu frames to %s\n", frames_written, filename);
-    
+
+    printf("Replay Buffer: Saved %u frames to %s\n", *frames_out, filename);
+
     return 0;
 }
 
+int replay_buffer_save(replay_buffer_t *buffer,
+                       const char *filename,
+                       uint32_t duration_sec,
+                       enum VideoCodec video_codec) {
+    if (!buffer || !filename) {
+        return -1;
+    }
+
+    save_range range;
+    if (save_begin(buffer, duration_sec, &range) < 0) {
+        return -1;
+    }
+
+    uint32_t frames_written = 0;
+    int ret = mux_range(buffer, range, filename, video_codec, &frames_written);
+    save_end(buffer);
+
+    return ret;
+}
+
+int replay_buffer_save_async(replay_buffer_t *buffer,
+                             const char *filename,
+                             uint32_t duration_sec,
+                             enum VideoCodec video_codec,
+                             replay_save_done_fn done,
+                             void *user) {
+    if (!buffer || !filename) {
+        return -1;
+    }
+
+    save_range range;
+    if (save_begin(buffer, duration_sec, &range) < 0) {
+        return -1;
+    }
+
+    // The previous save has finished (save_begin checked); reap its thread
+    if (buffer->save_thread.joinable()) {
+        buffer->save_thread.join();
+    }
+
+    std::string path(filename);
+    buffer->save_thread = std::thread([buffer, range, path, video_codec, done, user]() {
+        uint32_t frames_written = 0;
+        int ret = mux_range(buffer, range, path.c_str(), video_codec, &frames_written);
+        buffer->last_save_result = ret;
+        save_end(buffer);
+        if (done) {
+            done(ret, frames_written, user);
+        }
+    });
+
+    return 0;
+}
+
+int replay_buffer_save_wait(replay_buffer_t *buffer) {
+    if (!buffer) {
+        return -1;
+    }
+
+    if (buffer->save_thread.joinable()) {
+        buffer->save_thread.join();
+    }
+    return buffer->last_save_result;
+}
+
 void replay_buffer_clear(replay_buffer_t *buffer) {
     if (!buffer) return;
-    
-    std::lock_guard<std::mutex> video_lock(buffer->video_mutex);
-    std::lock_guard<std::mutex> audio_lock(buffer->audio_mutex);
-    
-    // Free all video frames
-    for (auto &frame : buffer->video_frames) {
-        free(frame.data);
-    }
-    buffer->video_frames.clear();
-    
-    // Free all audio chunks
-    for (auto &chunk : buffer->audio_chunks) {
-        free(chunk.samples);
-    }
-    buffer->audio_chunks.clear();
-    
+
+    replay_buffer_save_wait(buffer);
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    buffer->first_seq = buffer->next_seq;
+    buffer->keyframes.clear();
+    buffer->head = 0;
+    buffer->video_count = 0;
+    buffer->audio_count = 0;
     buffer->total_memory_bytes = 0;
-    buffer->oldest_timestamp_us = 0;
     buffer->newest_timestamp_us = 0;
+    buffer->need_keyframe = false;
 }
 
 int replay_buffer_get_stats(replay_buffer_t *buffer,
@@ -430,36 +638,56 @@ int replay_buffer_get_stats(replay_buffer_t *buffer,
     if (!buffer) {
         return -1;
     }
-    
-    std::lock_guard<std::mutex> video_lock(buffer->video_mutex);
-    std::lock_guard<std::mutex> audio_lock(buffer->audio_mutex);
-    
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
     if (video_frames_out) {
-        *video_frames_out = buffer->video_frames.size();
+        *video_frames_out = buffer->video_count;
     }
-    
+
     if (audio_chunks_out) {
-        *audio_chunks_out = buffer->audio_chunks.size();
+        *audio_chunks_out = buffer->audio_count;
     }
-    
+
     if (memory_used_mb) {
         *memory_used_mb = buffer->total_memory_bytes / (1024 * 1024);
     }
-    
+
     if (duration_sec_out) {
-        if (buffer->newest_timestamp_us > buffer->oldest_timestamp_us) {
-            *duration_sec_out = (buffer->newest_timestamp_us - buffer->oldest_timestamp_us) / 1000000;
-        } else {
-            *duration_sec_out = 0;
+        *duration_sec_out = 0;
+        if (buffer->first_seq < buffer->next_seq) {
+            uint64_t oldest_us = entry_at(buffer, buffer->first_seq).timestamp_us;
+            if (buffer->newest_timestamp_us > oldest_us) {
+                *duration_sec_out = (buffer->newest_timestamp_us - oldest_us) / 1000000;
+            }
         }
     }
-    
+
+    return 0;
+}
+
+int replay_buffer_get_ring_stats(replay_buffer_t *buffer, replay_buffer_stats_t *out) {
+    if (!buffer || !out) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+
+    out->arena_bytes = buffer->arena_bytes;
+    out->used_bytes = buffer->total_memory_bytes;
+    out->video_frames = buffer->video_count;
+    out->audio_chunks = buffer->audio_count;
+    out->dropped = buffer->dropped;
+    out->evicted = buffer->evicted;
+    out->saving = buffer->saving;
+
     return 0;
 }
 
 void replay_buffer_destroy(replay_buffer_t *buffer) {
     if (!buffer) return;
-    
+
     replay_buffer_clear(buffer);
+    munmap(buffer->arena, buffer->arena_bytes);
     delete buffer;
 }
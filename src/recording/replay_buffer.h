@@ -1,3 +1,22 @@
+/*
+ * replay_buffer.h — Instant-replay buffer on a preallocated byte ring
+ *
+ * Encoded video frames and audio chunks are copied once into a single
+ * arena of max_memory_mb, mapped and populated when the buffer is
+ * created.  Old data is evicted a GOP at a time, so the buffer always
+ * starts on a keyframe, once it exceeds duration_seconds or the arena
+ * is full.
+ *
+ * Saving pins the range it needs and muxes straight out of the arena
+ * with the buffer unlocked; capture continues meanwhile, and the pin is
+ * released entry by entry as the muxer moves past it.  If capture fills
+ * the arena up to a pinned entry, new frames are dropped (and deltas
+ * until the next keyframe) instead of blocking.
+ *
+ * Thread-safety: all functions may be called from any thread; at most
+ * one save runs at a time.
+ */
+
 #ifndef REPLAY_BUFFER_H
 #define REPLAY_BUFFER_H
 
@@ -11,6 +30,7 @@ extern "C" {
 #endif
 
 #define MAX_REPLAY_BUFFER_SECONDS 300  // 5 minutes max
+#define REPLAY_ENTRIES_PER_SECOND 512  // Entry slots preallocated per second of duration
 
 typedef struct {
     uint8_t *data;
@@ -31,11 +51,33 @@ typedef struct {
 
 typedef struct replay_buffer replay_buffer_t;
 
+/** Ring counters (snapshot) */
+typedef struct {
+    uint64_t arena_bytes;     /**< Preallocated ring size */
+    uint64_t used_bytes;      /**< Payload bytes held */
+    uint32_t video_frames;    /**< Video frames held */
+    uint32_t audio_chunks;    /**< Audio chunks held */
+    uint64_t dropped;         /**< Adds refused: no room beside a pinned save, or
+                                   a delta waiting for a keyframe */
+    uint64_t evicted;         /**< Entries evicted (age or space) */
+    bool saving;              /**< A save holds a pin */
+} replay_buffer_stats_t;
+
+/**
+ * Called when a background save finishes (on the save thread)
+ *
+ * @param result          0 on success, -1 on error
+ * @param frames_written  Video frames muxed
+ * @param user            As passed to replay_buffer_save_async()
+ */
+typedef void (*replay_save_done_fn)(int result, uint32_t frames_written, void *user);
+
 /**
  * Create a new replay buffer
  *
  * @param duration_seconds  Maximum duration of replay buffer in seconds
- * @param max_memory_mb     Maximum memory to use for buffer (0 = unlimited)
+ * @param max_memory_mb     Ring size in MB, allocated up front
+ *                          (0 = DEFAULT_REPLAY_BUFFER_SIZE_MB)
  * @return                  Pointer to replay buffer, or NULL on error
  */
 replay_buffer_t *replay_buffer_create(uint32_t duration_seconds, uint32_t max_memory_mb);
@@ -50,7 +92,7 @@ replay_buffer_t *replay_buffer_create(uint32_t duration_seconds, uint32_t max_me
  * @param height       Frame height
  * @param timestamp_us Frame timestamp in microseconds
  * @param is_keyframe  Whether this is a keyframe
- * @return             0 on success, -1 on error
+ * @return             0 on success, -1 on error or if the frame was dropped
  */
 int replay_buffer_add_video_frame(replay_buffer_t *buffer, const uint8_t *frame_data, size_t size,
                                   uint32_t width, uint32_t height, uint64_t timestamp_us,
@@ -74,6 +116,9 @@ int replay_buffer_add_audio_chunk(replay_buffer_t *buffer, const float *samples,
 /**
  * Save the replay buffer to a file
  *
+ * Starts at the last keyframe at or before the requested duration and
+ * muxes on the calling thread without blocking capture.
+ *
  * @param buffer        Replay buffer
  * @param filename      Output filename
  * @param duration_sec  Duration to save (0 = all available)
@@ -84,7 +129,35 @@ int replay_buffer_save(replay_buffer_t *buffer, const char *filename, uint32_t d
                        enum VideoCodec video_codec);
 
 /**
- * Clear all data from the replay buffer
+ * Save the replay buffer to a file on a background thread
+ *
+ * The range is fixed when this is called; the mux runs on its own
+ * thread and @done reports the result.  @done must not start another
+ * save or wait for this one.
+ *
+ * @param buffer        Replay buffer
+ * @param filename      Output filename
+ * @param duration_sec  Duration to save (0 = all available)
+ * @param video_codec   Video codec to use (from recording_types.h)
+ * @param done          Completion callback (may be NULL)
+ * @param user          Passed to @done
+ * @return              0 if the save started, -1 on error (nothing to save,
+ *                      or a save already running)
+ */
+int replay_buffer_save_async(replay_buffer_t *buffer, const char *filename,
+                             uint32_t duration_sec, enum VideoCodec video_codec,
+                             replay_save_done_fn done, void *user);
+
+/**
+ * Wait for a background save to finish
+ *
+ * @param buffer  Replay buffer
+ * @return        Result of the last background save (0 if there was none)
+ */
+int replay_buffer_save_wait(replay_buffer_t *buffer);
+
+/**
+ * Clear all data from the replay buffer (waits for a running save)
  *
  * @param buffer  Replay buffer
  */
@@ -105,7 +178,16 @@ int replay_buffer_get_stats(replay_buffer_t *buffer, uint32_t *video_frames_out,
                             uint32_t *duration_sec_out);
 
 /**
- * Destroy replay buffer and free all resources
+ * Get ring usage and drop counters
+ *
+ * @param buffer  Replay buffer
+ * @param out     Filled in
+ * @return        0 on success, -1 on error
+ */
+int replay_buffer_get_ring_stats(replay_buffer_t *buffer, replay_buffer_stats_t *out);
+
+/**
+ * Destroy replay buffer and free all resources (waits for a running save)
  *
  * @param buffer  Replay buffer to destroy
  */
@@ -0,0 +1,85 @@
+/*
+ * rstr_format.h — On-disk layout of RootStream recordings (.rstr)
+ *
+ * A recording is a file header followed by records.  Each record is a
+ * rstr_frame_header_t and @size payload bytes:
+ *
+ *   ┌────────────┬─────────┬─────────┬──────────────┬─────────┬─────┬────────────┐
+ *   │ header(64) │ frame   │ frame   │ checkpoint   │ frame   │ ... │ full index │
+ *   └────────────┴─────────┴─────────┴──────────────┴─────────┴─────┴────────────┘
+ *
+ * Version 1 files contain frames only.  Version 2 adds index records
+ * (RSTR_FLAG_INDEX), which sequential readers skip like any other
+ * record.  An index record's payload is an array of rstr_index_entry_t
+ * followed by a rstr_index_tail_t, so it can be parsed from its end:
+ *
+ *   - a checkpoint (RSTR_INDEX_MAGIC) lists the keyframes written since
+ *     the previous checkpoint and links back to it.  The header's
+ *     index_checkpoint field is rewritten after each checkpoint is on
+ *     disk, so a recording cut short by a crash can be indexed from the
+ *     checkpoint chain plus a short scan of the frames after it;
+ *   - the full index (RSTR_INDEX_FULL_MAGIC) lists every keyframe and
+ *     ends the file: its tail is the last 16 bytes.
+ *
+ * All integers are little-endian.
+ */
+
+#ifndef ROOTSTREAM_RSTR_FORMAT_H
+#define ROOTSTREAM_RSTR_FORMAT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RSTR_MAGIC 0x52535452            /**< "RSTR" */
+#define RSTR_VERSION_1 1                 /**< Frames only */
+#define RSTR_VERSION_2 2                 /**< Frames + index records */
+#define RSTR_VERSION RSTR_VERSION_2      /**< Version written */
+#define RSTR_INDEX_MAGIC 0x58444952      /**< "RIDX": checkpoint tail */
+#define RSTR_INDEX_FULL_MAGIC 0x58545352 /**< "RSTX": full index tail */
+
+/** rstr_frame_header_t flags */
+#define RSTR_FLAG_KEYFRAME 0x01 /**< Frame decodes on its own */
+#define RSTR_FLAG_INDEX 0x80    /**< Record is an index block, not a frame */
+
+/** File header (64 bytes) */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t codec; /* 0=H.264, 1=H.265 */
+    uint32_t fps;
+    uint64_t start_time;       /* Unix timestamp */
+    uint64_t index_checkpoint; /* v2: end offset of newest durable checkpoint (0 = none) */
+    uint32_t reserved[6];      /* For future use */
+} rstr_header_t;
+
+/** Record header (16 bytes) */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_us; /* Relative to start */
+    uint32_t size;
+    uint8_t flags; /* RSTR_FLAG_* */
+    uint8_t reserved[3];
+} rstr_frame_header_t;
+
+/** One keyframe in an index block */
+typedef struct __attribute__((packed)) {
+    uint64_t timestamp_us; /* Frame timestamp */
+    uint64_t offset;       /* File offset of the frame's record header */
+} rstr_index_entry_t;
+
+/** Last bytes of an index block */
+typedef struct __attribute__((packed)) {
+    uint64_t prev_end; /* End offset of the previous checkpoint (0 = none) */
+    uint32_t count;    /* Entries before this tail */
+    uint32_t magic;    /* RSTR_INDEX_MAGIC or RSTR_INDEX_FULL_MAGIC */
+} rstr_index_tail_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_RSTR_FORMAT_H */
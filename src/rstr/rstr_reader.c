@@ -0,0 +1,342 @@
+/*
+ * rstr_reader.c — .rstr reading, index loading and seeking
+ *
+ * Index records are parsed from their end: the 16-byte tail says how
+ * many entries precede it, so a reader that only knows where a block
+ * ends (the end of the file, the header's checkpoint pointer, a
+ * checkpoint's prev_end) can find the whole block.  Anything that does
+ * not check out — wrong magic, a block that would start before the
+ * first record, a pointer that does not go backwards — is ignored and
+ * the loader falls back to the next, slower source.
+ */
+
+#include "rstr_reader.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int rstr_read_header(int fd, rstr_header_t *header) {
+    if (fd < 0 || !header) {
+        return -1;
+    }
+
+    if (read(fd, header, sizeof(rstr_header_t)) != sizeof(rstr_header_t)) {
+        fprintf(stderr, "ERROR: Failed to read RSTR header\n");
+        return -1;
+    }
+
+    if (header->magic != RSTR_MAGIC) {
+        fprintf(stderr, "ERROR: Invalid RSTR file (bad magic: 0x%08X)\n", header->magic);
+        return -1;
+    }
+
+    if (header->version != RSTR_VERSION_1 && header->version != RSTR_VERSION_2) {
+        fprintf(stderr, "ERROR: Unsupported RSTR version: %u\n", header->version);
+        return -1;
+    }
+
+    /* v1 kept this field reserved (zero) */
+    if (header->version == RSTR_VERSION_1) {
+        header->index_checkpoint = 0;
+    }
+
+    return 0;
+}
+
+int rstr_read_frame(int fd, uint8_t *buffer, size_t buffer_size, rstr_frame_header_t *frame_hdr) {
+    if (fd < 0 || !buffer || !frame_hdr) {
+        return -1;
+    }
+
+    for (;;) {
+        /* Read record header */
+        ssize_t read_bytes = read(fd, frame_hdr, sizeof(rstr_frame_header_t));
+        if (read_bytes == 0) {
+            return 1; /* EOF */
+        }
+        if (read_bytes > 0 && read_bytes < (ssize_t)sizeof(rstr_frame_header_t)) {
+            return 1; /* Truncated by an unclean stop */
+        }
+        if (read_bytes != sizeof(rstr_frame_header_t)) {
+            fprintf(stderr, "ERROR: Failed to read frame header\n");
+            return -1;
+        }
+
+        if (!(frame_hdr->flags & RSTR_FLAG_INDEX)) {
+            break;
+        }
+        if (lseek(fd, frame_hdr->size, SEEK_CUR) < 0) {
+            fprintf(stderr, "ERROR: Failed to skip index record\n");
+            return -1;
+        }
+    }
+
+    if (frame_hdr->size > buffer_size) {
+        fprintf(stderr, "ERROR: Frame size %u exceeds buffer size %zu\n", frame_hdr->size,
+                buffer_size);
+        return -1;
+    }
+
+    /* Read frame data */
+    ssize_t got = read(fd, buffer, frame_hdr->size);
+    if (got >= 0 && got < (ssize_t)frame_hdr->size) {
+        return 1; /* Truncated by an unclean stop */
+    }
+    if (got != (ssize_t)frame_hdr->size) {
+        fprintf(stderr, "ERROR: Failed to read frame data\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* ── Index loading ─────────────────────────────────────────────────── */
+
+static bool pread_full(int fd, void *buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = pread(fd, (uint8_t *)buf + done, len - done, (off_t)(offset + done));
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            return false;
+        }
+        done += (size_t)r;
+    }
+    return true;
+}
+
+static int index_push(rstr_index_t *idx, size_t *cap, uint64_t timestamp_us, uint64_t offset) {
+    if (idx->count == *cap) {
+        size_t grown_cap = *cap ? *cap * 2 : 256;
+        rstr_index_entry_t *grown = realloc(idx->entries, grown_cap * sizeof(*grown));
+        if (!grown) {
+            return -1;
+        }
+        idx->entries = grown;
+        *cap = grown_cap;
+    }
+    idx->entries[idx->count].timestamp_us = timestamp_us;
+    idx->entries[idx->count].offset = offset;
+    idx->count++;
+    return 0;
+}
+
+/*
+ * Read the tail of the index block ending at @end and check it.
+ * @start receives the offset of the block's record header.
+ */
+static bool read_block_tail(int fd, uint64_t end, uint32_t magic, rstr_index_tail_t *tail,
+                            uint64_t *start) {
+    const uint64_t first = sizeof(rstr_header_t);
+    const uint64_t overhead = sizeof(rstr_frame_header_t) + sizeof(rstr_index_tail_t);
+
+    if (end < first + overhead || !pread_full(fd, tail, sizeof(*tail), end - sizeof(*tail))) {
+        return false;
+    }
+    if (tail->magic != magic) {
+        return false;
+    }
+
+    uint64_t body = (uint64_t)tail->count * sizeof(rstr_index_entry_t);
+    if (body > end - first - overhead) {
+        return false;
+    }
+    *start = end - overhead - body;
+
+    rstr_frame_header_t hdr;
+    if (!pread_full(fd, &hdr, sizeof(hdr), *start)) {
+        return false;
+    }
+    return (hdr.flags & RSTR_FLAG_INDEX) && hdr.size == body + sizeof(rstr_index_tail_t);
+}
+
+/* One read for the whole table at the end of a finished recording */
+static bool load_trailer(int fd, uint64_t file_size, rstr_index_t *idx) {
+    rstr_index_tail_t tail;
+    uint64_t start;
+    if (!read_block_tail(fd, file_size, RSTR_INDEX_FULL_MAGIC, &tail, &start)) {
+        return false;
+    }
+
+    idx->entries = malloc(tail.count ? tail.count * sizeof(rstr_index_entry_t) : 1);
+    if (!idx->entries) {
+        return false;
+    }
+    if (!pread_full(fd, idx->entries, tail.count * sizeof(rstr_index_entry_t),
+                    start + sizeof(rstr_frame_header_t))) {
+        free(idx->entries);
+        idx->entries = NULL;
+        return false;
+    }
+    idx->count = tail.count;
+    idx->data_end = start;
+    idx->source = RSTR_INDEX_SOURCE_TRAILER;
+    return true;
+}
+
+/*
+ * Walk the checkpoint chain back from @newest_end: a first pass sizes
+ * it, a second fills the table from the back, so entries come out in
+ * file order without reversing.
+ */
+static bool load_checkpoints(int fd, uint64_t newest_end, rstr_index_t *idx, size_t *cap) {
+    size_t total = 0;
+    uint64_t end = newest_end;
+    while (end) {
+        rstr_index_tail_t tail;
+        uint64_t start;
+        if (!read_block_tail(fd, end, RSTR_INDEX_MAGIC, &tail, &start)) {
+            return false;
+        }
+        if (tail.prev_end > start) {
+            return false; /* must point backwards, or the walk might not end */
+        }
+        total += tail.count;
+        end = tail.prev_end;
+    }
+
+    idx->entries = malloc(total ? total * sizeof(rstr_index_entry_t) : 1);
+    if (!idx->entries) {
+        return false;
+    }
+    *cap = total ? total : 1;
+
+    size_t fill = total;
+    end = newest_end;
+    while (end) {
+        rstr_index_tail_t tail;
+        uint64_t start;
+        if (!read_block_tail(fd, end, RSTR_INDEX_MAGIC, &tail, &start)) {
+            break;
+        }
+        fill -= tail.count;
+        if (!pread_full(fd, idx->entries + fill, tail.count * sizeof(rstr_index_entry_t),
+                        start + sizeof(rstr_frame_header_t))) {
+            break;
+        }
+        end = tail.prev_end;
+    }
+    if (fill != 0) {
+        free(idx->entries);
+        idx->entries = NULL;
+        *cap = 0;
+        return false;
+    }
+    idx->count = total;
+    return true;
+}
+
+/* Index the keyframes from @offset to the last complete record */
+static int scan_records(int fd, uint64_t offset, uint64_t file_size, rstr_index_t *idx,
+                        size_t *cap) {
+    idx->data_end = offset;
+    while (offset + sizeof(rstr_frame_header_t) <= file_size) {
+        rstr_frame_header_t hdr;
+        if (!pread_full(fd, &hdr, sizeof(hdr), offset)) {
+            return -1;
+        }
+        uint64_t next = offset + sizeof(hdr) + hdr.size;
+        if (next > file_size) {
+            break; /* truncated record */
+        }
+        if (!(hdr.flags & RSTR_FLAG_INDEX)) {
+            if ((hdr.flags & RSTR_FLAG_KEYFRAME) &&
+                index_push(idx, cap, hdr.timestamp_us, offset) < 0) {
+                return -1;
+            }
+            idx->data_end = next;
+        }
+        offset = next;
+    }
+    return 0;
+}
+
+int rstr_index_load(int fd, const rstr_header_t *header, rstr_index_t *idx) {
+    if (fd < 0 || !header || !idx) {
+        return -1;
+    }
+    memset(idx, 0, sizeof(*idx));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        return -1;
+    }
+    uint64_t file_size = (uint64_t)st.st_size;
+
+    if (header->version >= RSTR_VERSION_2) {
+        if (load_trailer(fd, file_size, idx)) {
+            return 0;
+        }
+
+        size_t cap = 0;
+        uint64_t cp = header->index_checkpoint;
+        if (cp && cp <= file_size && load_checkpoints(fd, cp, idx, &cap)) {
+            idx->source = RSTR_INDEX_SOURCE_CHECKPOINTS;
+            if (scan_records(fd, cp, file_size, idx, &cap) < 0) {
+                rstr_index_free(idx);
+                return -1;
+            }
+            return 0;
+        }
+        rstr_index_free(idx);
+    }
+
+    size_t cap = 0;
+    idx->source = RSTR_INDEX_SOURCE_SCAN;
+    if (scan_records(fd, sizeof(rstr_header_t), file_size, idx, &cap) < 0) {
+        rstr_index_free(idx);
+        return -1;
+    }
+    return 0;
+}
+
+/* ── Lookup ────────────────────────────────────────────────────────── */
+
+const rstr_index_entry_t *rstr_index_find(const rstr_index_t *idx, uint64_t timestamp_us) {
+    if (!idx || idx->count == 0) {
+        return NULL;
+    }
+
+    /* First entry with a timestamp after the target */
+    size_t lo = 0;
+    size_t hi = idx->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (idx->entries[mid].timestamp_us <= timestamp_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return &idx->entries[lo ? lo - 1 : 0];
+}
+
+int rstr_seek(int fd, const rstr_index_t *idx, uint64_t timestamp_us, uint64_t *keyframe_us) {
+    const rstr_index_entry_t *e = rstr_index_find(idx, timestamp_us);
+    if (fd < 0 || !e) {
+        return -1;
+    }
+    if (lseek(fd, (off_t)e->offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    if (keyframe_us) {
+        *keyframe_us = e->timestamp_us;
+    }
+    return 0;
+}
+
+void rstr_index_free(rstr_index_t *idx) {
+    if (!idx) {
+        return;
+    }
+    free(idx->entries);
+    idx->entries = NULL;
+    idx->count = 0;
+}
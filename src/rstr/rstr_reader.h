@@ -0,0 +1,102 @@
+/*
+ * rstr_reader.h — Sequential reading and indexed seeking in .rstr files
+ *
+ * rstr_read_frame() returns the frames of a version 1 or 2 recording in
+ * order and skips index records.  For random access, rstr_index_load()
+ * collects the keyframe index once:
+ *
+ *   - from the full index at the end of a finished v2 file (one read);
+ *   - from the header's checkpoint chain plus a scan of the frames after
+ *     the newest checkpoint, for a v2 file that was never closed;
+ *   - by scanning every record header, for v1 files.
+ *
+ * rstr_seek() then positions the file on the keyframe at or before a
+ * timestamp with a binary search.
+ *
+ * Thread-safety: functions are reentrant; an index may be shared by
+ * readers once loaded.  A file descriptor is not.
+ */
+
+#ifndef ROOTSTREAM_RSTR_READER_H
+#define ROOTSTREAM_RSTR_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rstr_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Where rstr_index_load() found the index */
+typedef enum {
+    RSTR_INDEX_SOURCE_TRAILER = 0,     /**< Full index at the end of the file */
+    RSTR_INDEX_SOURCE_CHECKPOINTS = 1, /**< Checkpoint chain + scan of the rest */
+    RSTR_INDEX_SOURCE_SCAN = 2,        /**< Scan of every record */
+} rstr_index_source_t;
+
+/** Keyframe index of one recording */
+typedef struct {
+    rstr_index_entry_t *entries; /**< Keyframes in file order */
+    size_t count;                /**< Entries */
+    uint64_t data_end;           /**< End of the last complete frame record */
+    rstr_index_source_t source;  /**< How the index was obtained */
+} rstr_index_t;
+
+/**
+ * rstr_read_header — read and validate the file header at the current
+ * position (version 1 or 2)
+ *
+ * @return 0 on success, -1 on error
+ */
+int rstr_read_header(int fd, rstr_header_t *header);
+
+/**
+ * rstr_read_frame — read the next frame, skipping index records
+ *
+ * A record cut short by the end of the file (a recording that was not
+ * closed) reads as end of file.
+ *
+ * @return 0 on success, -1 on error, 1 on EOF
+ */
+int rstr_read_frame(int fd, uint8_t *buffer, size_t buffer_size, rstr_frame_header_t *frame_hdr);
+
+/**
+ * rstr_index_load — build the keyframe index of an open recording
+ *
+ * Uses positioned reads; the file position is left unchanged.
+ *
+ * @param fd      Recording
+ * @param header  Header as returned by rstr_read_header()
+ * @param idx     Filled in; release with rstr_index_free()
+ * @return        0 on success, -1 on I/O or allocation failure
+ */
+int rstr_index_load(int fd, const rstr_header_t *header, rstr_index_t *idx);
+
+/**
+ * rstr_index_find — keyframe to start decoding from for @timestamp_us
+ *
+ * @return The last keyframe at or before @timestamp_us, the first
+ *         keyframe if @timestamp_us precedes it, or NULL if the index
+ *         is empty
+ */
+const rstr_index_entry_t *rstr_index_find(const rstr_index_t *idx, uint64_t timestamp_us);
+
+/**
+ * rstr_seek — position @fd so the next rstr_read_frame() returns the
+ * keyframe chosen by rstr_index_find()
+ *
+ * @param keyframe_us  Receives the keyframe's timestamp (may be NULL)
+ * @return             0 on success, -1 if the index is empty or on error
+ */
+int rstr_seek(int fd, const rstr_index_t *idx, uint64_t timestamp_us, uint64_t *keyframe_us);
+
+/** rstr_index_free — release the entries of @idx */
+void rstr_index_free(rstr_index_t *idx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_RSTR_READER_H */
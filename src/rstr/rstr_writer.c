@@ -0,0 +1,499 @@
+/*
+ * rstr_writer.c — Asynchronous, batched .rstr v2 writer implementation
+ *
+ * The ring holds the file byte for byte: ring position p is file offset
+ * p, starting with the header.  head (bytes appended) belongs to the
+ * caller's thread and tail (bytes written) to the writer thread; both
+ * are free-running and a byte lives at ring[pos & mask].  A record is
+ * published by storing head after it has been copied in whole, so the
+ * writer never sees half a frame.
+ *
+ * The keyframe index is built on the caller's thread, which already
+ * knows each record's file offset.  A checkpoint becomes "durable" once
+ * the writer thread has written past its end: it then syncs the data
+ * and stores the checkpoint's end offset in the header, so a reader
+ * never follows a header pointer to bytes that are not on disk.
+ *
+ * The writer sleeps on a condvar that the caller only signals when a
+ * full batch is pending and the writer is actually asleep (`waiting`),
+ * as in frame_queue.c.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* O_DIRECT */
+#endif
+
+#include "rstr_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RSTR_WRITER_MIN_RING (64u << 10)
+#define RSTR_WRITER_INDEX_INIT 1024
+
+struct rstr_writer_s {
+    int fd;
+    int meta_fd; /* header updates; == fd unless O_DIRECT is on */
+    atomic_bool direct;
+
+    uint8_t *ring;
+    uint64_t cap;
+    uint64_t mask;
+    uint64_t batch;
+    uint64_t checkpoint_us;
+
+    _Atomic uint64_t head;   /* bytes appended (caller) */
+    _Atomic uint64_t tail;   /* bytes written (writer thread) */
+    _Atomic uint64_t cp_end; /* end offset of the newest queued checkpoint */
+    uint64_t cp_durable;     /* writer thread: checkpoint stored in the header */
+
+    /* Caller-owned index state */
+    rstr_index_entry_t *index;
+    size_t index_count;
+    size_t index_cap;
+    size_t cp_first;     /* first entry not yet in a checkpoint */
+    uint64_t cp_last_ts; /* stream time of the last checkpoint */
+    bool need_keyframe;  /* a frame was dropped; deltas are useless until a keyframe */
+
+    _Atomic uint64_t frames;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t keyframes;
+    _Atomic uint64_t checkpoints;
+    _Atomic uint64_t writes;
+    _Atomic uint64_t max_write_us;
+    atomic_bool failed;
+
+    atomic_bool closing;
+    atomic_int waiting;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool thread_started;
+};
+
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/* ── Caller side ───────────────────────────────────────────────────── */
+
+static void ring_put(rstr_writer_t *w, uint64_t pos, const void *src, size_t len) {
+    size_t off = (size_t)(pos & w->mask);
+    size_t first = len < w->cap - off ? len : (size_t)(w->cap - off);
+    memcpy(w->ring + off, src, first);
+    if (len > first)
+        memcpy(w->ring, (const uint8_t *)src + first, len - first);
+}
+
+/*
+ * Append @hdr followed by up to two payload parts as one record.
+ * Returns false (nothing appended) if the ring cannot take it whole.
+ */
+static bool ring_append(rstr_writer_t *w, const void *hdr, size_t hdr_len, const void *a,
+                        size_t a_len, const void *b, size_t b_len) {
+    uint64_t head = atomic_load_explicit(&w->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&w->tail, memory_order_acquire);
+    uint64_t len = (uint64_t)hdr_len + a_len + b_len;
+    if (len > w->cap - (head - tail))
+        return false;
+
+    ring_put(w, head, hdr, hdr_len);
+    if (a_len)
+        ring_put(w, head + hdr_len, a, a_len);
+    if (b_len)
+        ring_put(w, head + hdr_len + a_len, b, b_len);
+    atomic_store_explicit(&w->head, head + len, memory_order_seq_cst);
+
+    if (head + len - tail >= w->batch && atomic_load_explicit(&w->waiting, memory_order_seq_cst)) {
+        pthread_mutex_lock(&w->lock);
+        pthread_cond_signal(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+    return true;
+}
+
+static void index_add(rstr_writer_t *w, uint64_t timestamp_us, uint64_t offset) {
+    if (w->index_count == w->index_cap) {
+        size_t cap = w->index_cap ? w->index_cap * 2 : RSTR_WRITER_INDEX_INIT;
+        rstr_index_entry_t *grown = realloc(w->index, cap * sizeof(*grown));
+        if (!grown)
+            return; /* unindexed keyframe: seeking lands on the one before */
+        w->index = grown;
+        w->index_cap = cap;
+    }
+    w->index[w->index_count].timestamp_us = timestamp_us;
+    w->index[w->index_count].offset = offset;
+    w->index_count++;
+    atomic_fetch_add_explicit(&w->keyframes, 1, memory_order_relaxed);
+}
+
+/* Queue the keyframes since the previous checkpoint; retried on the next
+ * frame if the ring is full */
+static void queue_checkpoint(rstr_writer_t *w, uint64_t timestamp_us) {
+    size_t count = w->index_count - w->cp_first;
+    rstr_index_tail_t tail = {
+        .prev_end = atomic_load_explicit(&w->cp_end, memory_order_relaxed),
+        .count = (uint32_t)count,
+        .magic = RSTR_INDEX_MAGIC,
+    };
+    rstr_frame_header_t hdr = {0};
+    hdr.timestamp_us = timestamp_us;
+    hdr.size = (uint32_t)(count * sizeof(rstr_index_entry_t) + sizeof(tail));
+    hdr.flags = RSTR_FLAG_INDEX;
+
+    uint64_t start = atomic_load_explicit(&w->head, memory_order_relaxed);
+    if (!ring_append(w, &hdr, sizeof(hdr), w->index + w->cp_first,
+                     count * sizeof(rstr_index_entry_t), &tail, sizeof(tail)))
+        return;
+
+    w->cp_first = w->index_count;
+    w->cp_last_ts = timestamp_us;
+    atomic_store_explicit(&w->cp_end, start + sizeof(hdr) + hdr.size, memory_order_release);
+    atomic_fetch_add_explicit(&w->checkpoints, 1, memory_order_relaxed);
+}
+
+int rstr_writer_write(rstr_writer_t *w, uint64_t timestamp_us, const uint8_t *data, size_t size,
+                      bool is_keyframe) {
+    if (!w || !data || size == 0 || size > UINT32_MAX)
+        return -1;
+    if (atomic_load_explicit(&w->failed, memory_order_relaxed))
+        return -1;
+
+    int rc = RSTR_WRITE_DROPPED;
+    if (is_keyframe || !w->need_keyframe) {
+        rstr_frame_header_t hdr = {0};
+        hdr.timestamp_us = timestamp_us;
+        hdr.size = (uint32_t)size;
+        hdr.flags = is_keyframe ? RSTR_FLAG_KEYFRAME : 0;
+
+        uint64_t offset = atomic_load_explicit(&w->head, memory_order_relaxed);
+        if (ring_append(w, &hdr, sizeof(hdr), data, size, NULL, 0)) {
+            if (is_keyframe)
+                index_add(w, timestamp_us, offset);
+            w->need_keyframe = false;
+            atomic_fetch_add_explicit(&w->frames, 1, memory_order_relaxed);
+            rc = RSTR_WRITE_QUEUED;
+        } else {
+            w->need_keyframe = true;
+        }
+    }
+    if (rc == RSTR_WRITE_DROPPED)
+        atomic_fetch_add_explicit(&w->dropped, 1, memory_order_relaxed);
+
+    if (timestamp_us >= w->cp_last_ts && timestamp_us - w->cp_last_ts >= w->checkpoint_us)
+        queue_checkpoint(w, timestamp_us);
+    return rc;
+}
+
+/* ── Writer side ───────────────────────────────────────────────────── */
+
+static void writer_fail(rstr_writer_t *w, const char *what) {
+    if (!atomic_exchange(&w->failed, true))
+        fprintf(stderr, "ERROR: Recording %s failed: %s\n", what, strerror(errno));
+}
+
+/* Leave O_DIRECT mode (unaligned tail, or a filesystem that refuses it) */
+static void drop_direct(rstr_writer_t *w) {
+    int flags = fcntl(w->fd, F_GETFL);
+    if (flags >= 0)
+        fcntl(w->fd, F_SETFL, flags & ~O_DIRECT);
+    atomic_store(&w->direct, false);
+}
+
+/*
+ * Write everything appended so far.  In O_DIRECT mode only whole
+ * RSTR_WRITER_ALIGN blocks are written unless @all is set (on close,
+ * after O_DIRECT has been dropped).  Ring size and write offsets are
+ * multiples of the alignment, so the split at the ring's end is too.
+ */
+static void writer_drain(rstr_writer_t *w, bool all) {
+    uint64_t head = atomic_load_explicit(&w->head, memory_order_acquire);
+    uint64_t tail = atomic_load_explicit(&w->tail, memory_order_relaxed);
+
+    while (tail < head && !atomic_load_explicit(&w->failed, memory_order_relaxed)) {
+        uint64_t n = head - tail;
+        if (!all && atomic_load_explicit(&w->direct, memory_order_relaxed)) {
+            n &= ~(uint64_t)(RSTR_WRITER_ALIGN - 1);
+            if (n == 0)
+                break;
+        }
+        uint64_t off = tail & w->mask;
+        if (n > w->cap - off)
+            n = w->cap - off;
+
+        uint64_t t0 = mono_us();
+        ssize_t r = pwrite(w->fd, w->ring + off, (size_t)n, (off_t)tail);
+        uint64_t dt = mono_us() - t0;
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EINVAL && atomic_load_explicit(&w->direct, memory_order_relaxed)) {
+                drop_direct(w);
+                continue;
+            }
+            writer_fail(w, "write");
+            break;
+        }
+        if (r == 0) {
+            errno = ENOSPC;
+            writer_fail(w, "write");
+            break;
+        }
+
+        atomic_fetch_add_explicit(&w->writes, 1, memory_order_relaxed);
+        if (dt > atomic_load_explicit(&w->max_write_us, memory_order_relaxed))
+            atomic_store_explicit(&w->max_write_us, dt, memory_order_relaxed);
+        tail += (uint64_t)r;
+        atomic_store_explicit(&w->tail, tail, memory_order_release);
+    }
+}
+
+/* Point the header at the newest checkpoint that is fully on disk */
+static void writer_publish_checkpoint(rstr_writer_t *w) {
+    uint64_t cp = atomic_load_explicit(&w->cp_end, memory_order_acquire);
+    if (cp <= w->cp_durable || atomic_load_explicit(&w->tail, memory_order_relaxed) < cp)
+        return;
+    if (atomic_load_explicit(&w->failed, memory_order_relaxed))
+        return;
+
+    /* Data first, so the header never points past what survives a crash */
+    fdatasync(w->fd);
+    if (pwrite(w->meta_fd, &cp, sizeof(cp), offsetof(rstr_header_t, index_checkpoint)) !=
+        (ssize_t)sizeof(cp)) {
+        writer_fail(w, "header update");
+        return;
+    }
+    w->cp_durable = cp;
+}
+
+static void *writer_thread(void *arg) {
+    rstr_writer_t *w = arg;
+
+    for (;;) {
+        bool closing = atomic_load(&w->closing);
+        writer_drain(w, false);
+        writer_publish_checkpoint(w);
+        if (closing || atomic_load_explicit(&w->failed, memory_order_relaxed))
+            break;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += RSTR_WRITER_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&w->lock);
+        atomic_store_explicit(&w->waiting, 1, memory_order_seq_cst);
+        uint64_t pending = atomic_load_explicit(&w->head, memory_order_seq_cst) -
+                           atomic_load_explicit(&w->tail, memory_order_relaxed);
+        if (!atomic_load(&w->closing) && pending < w->batch)
+            pthread_cond_timedwait(&w->cond, &w->lock, &deadline);
+        atomic_store_explicit(&w->waiting, 0, memory_order_relaxed);
+        pthread_mutex_unlock(&w->lock);
+    }
+    return NULL;
+}
+
+/* ── Lifecycle ─────────────────────────────────────────────────────── */
+
+static void writer_free(rstr_writer_t *w) {
+    if (w->meta_fd >= 0 && w->meta_fd != w->fd)
+        close(w->meta_fd);
+    if (w->fd >= 0)
+        close(w->fd);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w->index);
+    free(w->ring);
+    free(w);
+}
+
+rstr_writer_t *rstr_writer_open(const char *path, const rstr_header_t *header,
+                                const rstr_writer_config_t *cfg) {
+    if (!path || !header)
+        return NULL;
+
+    rstr_writer_config_t c = {0};
+    if (cfg)
+        c = *cfg;
+    if (c.ring_bytes == 0)
+        c.ring_bytes = RSTR_WRITER_DEFAULT_RING;
+    if (c.batch_bytes == 0)
+        c.batch_bytes = RSTR_WRITER_DEFAULT_BATCH;
+    if (c.checkpoint_interval_us == 0)
+        c.checkpoint_interval_us = RSTR_WRITER_DEFAULT_CHECKPOINT_US;
+
+    uint64_t cap = RSTR_WRITER_MIN_RING;
+    while (cap < c.ring_bytes)
+        cap <<= 1;
+
+    rstr_writer_t *w = calloc(1, sizeof(*w));
+    if (!w)
+        return NULL;
+    w->fd = -1;
+    w->meta_fd = -1;
+    w->cap = cap;
+    w->mask = cap - 1;
+    w->batch = c.batch_bytes < cap / 2 ? c.batch_bytes : cap / 2;
+    w->checkpoint_us = c.checkpoint_interval_us;
+    atomic_init(&w->direct, false);
+    atomic_init(&w->head, 0);
+    atomic_init(&w->tail, 0);
+    atomic_init(&w->cp_end, 0);
+    atomic_init(&w->frames, 0);
+    atomic_init(&w->dropped, 0);
+    atomic_init(&w->keyframes, 0);
+    atomic_init(&w->checkpoints, 0);
+    atomic_init(&w->writes, 0);
+    atomic_init(&w->max_write_us, 0);
+    atomic_init(&w->failed, false);
+    atomic_init(&w->closing, false);
+    atomic_init(&w->waiting, 0);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (posix_memalign((void **)&w->ring, RSTR_WRITER_ALIGN, (size_t)cap) != 0) {
+        w->ring = NULL;
+        writer_free(w);
+        return NULL;
+    }
+    /* Fault the ring in now rather than on the capture thread's first lap */
+    memset(w->ring, 0, (size_t)cap);
+
+    if (c.direct_io) {
+        w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (w->fd >= 0) {
+            atomic_store(&w->direct, true);
+            w->meta_fd = open(path, O_WRONLY);
+            if (w->meta_fd < 0)
+                drop_direct(w);
+        }
+    }
+    if (w->fd < 0)
+        w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) {
+        writer_free(w);
+        return NULL;
+    }
+    if (w->meta_fd < 0)
+        w->meta_fd = w->fd;
+
+    rstr_header_t hdr = *header;
+    hdr.magic = RSTR_MAGIC;
+    hdr.version = RSTR_VERSION;
+    hdr.index_checkpoint = 0;
+    ring_put(w, 0, &hdr, sizeof(hdr));
+    atomic_store(&w->head, sizeof(hdr));
+
+    if (pthread_create(&w->thread, NULL, writer_thread, w) != 0) {
+        writer_free(w);
+        unlink(path);
+        return NULL;
+    }
+    w->thread_started = true;
+    return w;
+}
+
+int rstr_writer_get_stats(const rstr_writer_t *w, rstr_writer_stats_t *out) {
+    if (!w || !out)
+        return -1;
+    memset(out, 0, sizeof(*out));
+    uint64_t tail = atomic_load_explicit(&w->tail, memory_order_acquire);
+    uint64_t head = atomic_load_explicit(&w->head, memory_order_acquire);
+    out->frames = atomic_load_explicit(&w->frames, memory_order_relaxed);
+    out->frames_dropped = atomic_load_explicit(&w->dropped, memory_order_relaxed);
+    out->keyframes = atomic_load_explicit(&w->keyframes, memory_order_relaxed);
+    out->checkpoints = atomic_load_explicit(&w->checkpoints, memory_order_relaxed);
+    out->bytes_queued = head;
+    out->bytes_written = tail;
+    out->writes = atomic_load_explicit(&w->writes, memory_order_relaxed);
+    out->max_write_us = atomic_load_explicit(&w->max_write_us, memory_order_relaxed);
+    out->ring_used = (uint32_t)(head - tail);
+    out->ring_capacity = (uint32_t)w->cap;
+    out->direct_io = atomic_load_explicit(&w->direct, memory_order_relaxed);
+    out->failed = atomic_load_explicit(&w->failed, memory_order_relaxed);
+    return 0;
+}
+
+/* Append the full index and its tail at the current end of the file */
+static int write_full_index(rstr_writer_t *w) {
+    uint64_t end = atomic_load(&w->tail);
+    rstr_index_tail_t tail = {
+        .prev_end = atomic_load(&w->cp_end),
+        .count = (uint32_t)w->index_count,
+        .magic = RSTR_INDEX_FULL_MAGIC,
+    };
+    rstr_frame_header_t hdr = {0};
+    hdr.timestamp_us = w->index_count ? w->index[w->index_count - 1].timestamp_us : 0;
+    hdr.size = (uint32_t)(w->index_count * sizeof(rstr_index_entry_t) + sizeof(tail));
+    hdr.flags = RSTR_FLAG_INDEX;
+
+    size_t len = sizeof(hdr) + hdr.size;
+    uint8_t *buf = malloc(len);
+    if (!buf)
+        return -1;
+    memcpy(buf, &hdr, sizeof(hdr));
+    if (w->index_count)
+        memcpy(buf + sizeof(hdr), w->index, w->index_count * sizeof(rstr_index_entry_t));
+    memcpy(buf + len - sizeof(tail), &tail, sizeof(tail));
+
+    size_t done = 0;
+    while (done < len) {
+        ssize_t r = pwrite(w->fd, buf + done, len - done, (off_t)(end + done));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0) {
+            writer_fail(w, "index write");
+            free(buf);
+            return -1;
+        }
+        done += (size_t)r;
+    }
+    free(buf);
+    return 0;
+}
+
+int rstr_writer_close(rstr_writer_t *w) {
+    if (!w)
+        return -1;
+
+    if (w->thread_started) {
+        pthread_mutex_lock(&w->lock);
+        atomic_store(&w->closing, true);
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+    }
+
+    /* The writer thread is gone: finish the unaligned remainder here */
+    if (atomic_load(&w->direct))
+        drop_direct(w);
+    writer_drain(w, true);
+    writer_publish_checkpoint(w);
+
+    int rc = 0;
+    if (atomic_load(&w->failed) || write_full_index(w) < 0)
+        rc = -1;
+    if (fsync(w->fd) < 0)
+        rc = -1;
+
+    writer_free(w);
+    return rc;
+}
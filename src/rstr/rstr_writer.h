@@ -0,0 +1,123 @@
+/*
+ * rstr_writer.h — Asynchronous, batched .rstr v2 writer
+ *
+ * rstr_writer_write() never touches the disk: it copies the frame into
+ * a single-producer/single-consumer byte ring and returns.  A writer
+ * thread drains the ring in large writes (RSTR_WRITER_DEFAULT_BATCH, or
+ * whatever is pending every RSTR_WRITER_FLUSH_MS), so a slow or stalled
+ * disk delays the file, not the caller.
+ *
+ * When the ring is full the frame is dropped, and so is every following
+ * delta frame until the next keyframe, so the file stays decodable.
+ *
+ * The writer keeps the keyframe index in memory, queues an index
+ * checkpoint every checkpoint_interval_us and appends the full index
+ * on close (see rstr_format.h).
+ *
+ * With direct_io the file is opened with O_DIRECT and the ring is only
+ * drained in RSTR_WRITER_ALIGN multiples; the unaligned remainder and
+ * the index are written with buffered I/O on close.  Filesystems that
+ * refuse O_DIRECT fall back to buffered I/O.
+ *
+ * Thread-safety: rstr_writer_write() must be called from a single
+ * thread.  rstr_writer_get_stats() may be called from any thread.
+ * rstr_writer_close() must not race rstr_writer_write().
+ */
+
+#ifndef ROOTSTREAM_RSTR_WRITER_H
+#define ROOTSTREAM_RSTR_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rstr_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RSTR_WRITER_DEFAULT_RING (16u << 20)         /**< Bytes buffered ahead of the disk */
+#define RSTR_WRITER_DEFAULT_BATCH (1u << 20)         /**< Pending bytes that wake the writer */
+#define RSTR_WRITER_DEFAULT_CHECKPOINT_US 5000000ULL /**< Index checkpoint period */
+#define RSTR_WRITER_FLUSH_MS 100                     /**< Longest a partial batch waits */
+#define RSTR_WRITER_ALIGN 4096                       /**< Ring and O_DIRECT alignment */
+
+/** rstr_writer_write() results */
+#define RSTR_WRITE_QUEUED 0  /**< Frame queued for the disk */
+#define RSTR_WRITE_DROPPED 1 /**< Ring full, or a delta waiting for a keyframe */
+
+/** Writer tuning (zero fields take the defaults) */
+typedef struct {
+    size_t ring_bytes;               /**< Ring size, rounded up to a power of two */
+    size_t batch_bytes;              /**< Wake-up threshold for the writer thread */
+    uint64_t checkpoint_interval_us; /**< Stream time between index checkpoints */
+    bool direct_io;                  /**< Bypass the page cache with O_DIRECT */
+} rstr_writer_config_t;
+
+/** Writer counters (snapshot) */
+typedef struct {
+    uint64_t frames;         /**< Frames queued */
+    uint64_t frames_dropped; /**< Frames dropped (ring full / waiting for keyframe) */
+    uint64_t keyframes;      /**< Index entries */
+    uint64_t checkpoints;    /**< Index checkpoints queued */
+    uint64_t bytes_queued;   /**< Bytes appended to the ring (= file size so far) */
+    uint64_t bytes_written;  /**< Bytes on disk */
+    uint64_t writes;         /**< write syscalls issued by the writer thread */
+    uint64_t max_write_us;   /**< Slowest single write */
+    uint32_t ring_used;      /**< Bytes waiting in the ring */
+    uint32_t ring_capacity;  /**< Ring size */
+    bool direct_io;          /**< O_DIRECT is in effect */
+    bool failed;             /**< A write failed; the writer accepts no more frames */
+} rstr_writer_stats_t;
+
+/** Opaque writer */
+typedef struct rstr_writer_s rstr_writer_t;
+
+/**
+ * rstr_writer_open — create @path, queue the header and start the thread
+ *
+ * magic, version and index_checkpoint of @header are filled in.
+ *
+ * @param path    Output file (truncated)
+ * @param header  Stream description (width, height, codec, fps, start_time)
+ * @param cfg     Tuning, or NULL for defaults
+ * @return        Writer, or NULL on failure
+ */
+rstr_writer_t *rstr_writer_open(const char *path, const rstr_header_t *header,
+                                const rstr_writer_config_t *cfg);
+
+/**
+ * rstr_writer_write — queue one encoded frame
+ *
+ * @param w             Writer
+ * @param timestamp_us  Frame time relative to the start of the recording
+ * @param data          Encoded frame
+ * @param size          Bytes in @data
+ * @param is_keyframe   Frame decodes on its own (indexed)
+ * @return              RSTR_WRITE_QUEUED, RSTR_WRITE_DROPPED, or -1 on
+ *                      bad arguments or after a write error
+ */
+int rstr_writer_write(rstr_writer_t *w, uint64_t timestamp_us, const uint8_t *data, size_t size,
+                      bool is_keyframe);
+
+/**
+ * rstr_writer_get_stats — copy counters into *out
+ *
+ * @return 0 on success, -1 on NULL
+ */
+int rstr_writer_get_stats(const rstr_writer_t *w, rstr_writer_stats_t *out);
+
+/**
+ * rstr_writer_close — drain the ring, append the full index, sync and
+ * close the file, and free the writer
+ *
+ * @return 0 if every byte reached the file, -1 otherwise
+ */
+int rstr_writer_close(rstr_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_RSTR_WRITER_H */
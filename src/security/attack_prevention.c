@@ -4,17 +4,21 @@
 
 #include "attack_prevention.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 
 #include "crypto_primitives.h"
+#include "sec_table.h"
 
 #define MAX_NONCES 1024
-#define MAX_FAILED_ATTEMPTS 256
-#define MAX_RATE_LIMIT_ENTRIES 256
+#define MAX_FAILED_ATTEMPTS 65536
+#define MAX_RATE_LIMIT_ENTRIES 65536
 #define LOCKOUT_THRESHOLD 5
 #define LOCKOUT_DURATION_SEC 300
+#define RATE_WINDOW_MS 60000 /* 1 minute */
+#define EXPIRY_TICK_MS 1000
 
 /* Nonce cache for replay prevention */
 static struct {
@@ -22,33 +26,92 @@ static struct {
     bool used;
 } g_nonce_cache[MAX_NONCES];
 static int g_nonce_count = 0;
+static pthread_mutex_t g_nonce_lock = PTHREAD_MUTEX_INITIALIZER;
 
-/* Brute force tracker */
-static struct {
-    char username[64];
+/* Brute force tracker, keyed by username.  An entry expires
+ * LOCKOUT_DURATION_SEC after the last failure. */
+typedef struct {
     uint32_t failed_attempts;
-    uint64_t lockout_until_us;
-} g_failed_attempts[MAX_FAILED_ATTEMPTS];
-static int g_failed_count = 0;
+    uint64_t lockout_until_ms;
+} failed_login_t;
+static sec_table_t *g_failed_attempts = NULL;
 
-/* Rate limiter */
-static struct {
-    char client_id[128];
+/* Rate limiter, keyed by client ID.  An entry expires with its window. */
+typedef struct {
     uint32_t request_count;
-    uint64_t window_start_us;
-} g_rate_limits[MAX_RATE_LIMIT_ENTRIES];
-static int g_rate_limit_count = 0;
+    uint64_t window_start_ms;
+} rate_limit_t;
+static sec_table_t *g_rate_limits = NULL;
+
+typedef struct {
+    uint64_t now_ms;
+    uint32_t max_per_min;
+    bool result;
+} tracker_req_t;
+
+static sec_table_action_t failed_login_record(void *value, bool created, uint64_t *expires_ms,
+                                              void *arg) {
+    failed_login_t *f = value;
+    tracker_req_t *req = arg;
+    (void)created;
+
+    f->failed_attempts++;
+
+    /* Lock account if threshold exceeded */
+    if (f->failed_attempts >= LOCKOUT_THRESHOLD) {
+        f->lockout_until_ms = req->now_ms + LOCKOUT_DURATION_SEC * 1000;
+    }
+    *expires_ms = req->now_ms + LOCKOUT_DURATION_SEC * 1000;
+    return SEC_TABLE_KEEP;
+}
+
+static sec_table_action_t failed_login_locked(void *value, bool created, uint64_t *expires_ms,
+                                              void *arg) {
+    const failed_login_t *f = value;
+    tracker_req_t *req = arg;
+    (void)created;
+    (void)expires_ms;
+
+    req->result = f->lockout_until_ms > req->now_ms;
+    return SEC_TABLE_KEEP;
+}
+
+static sec_table_action_t rate_limit_count(void *value, bool created, uint64_t *expires_ms,
+                                           void *arg) {
+    rate_limit_t *r = value;
+    tracker_req_t *req = arg;
+
+    /* Start a new window if this is the first request or the old one expired */
+    if (created || req->now_ms - r->window_start_ms > RATE_WINDOW_MS) {
+        r->request_count = 1;
+        r->window_start_ms = req->now_ms;
+        *expires_ms = req->now_ms + RATE_WINDOW_MS + 1;
+        req->result = false;
+        return SEC_TABLE_KEEP;
+    }
+
+    /* Increment counter and check limit */
+    r->request_count++;
+    req->result = r->request_count > req->max_per_min;
+    return SEC_TABLE_KEEP;
+}
 
 /*
  * Initialize attack prevention
  */
 int attack_prevention_init(void) {
     g_nonce_count = 0;
-    g_failed_count = 0;
-    g_rate_limit_count = 0;
     memset(g_nonce_cache, 0, sizeof(g_nonce_cache));
-    memset(g_failed_attempts, 0, sizeof(g_failed_attempts));
-    memset(g_rate_limits, 0, sizeof(g_rate_limits));
+
+    sec_table_destroy(g_failed_attempts);
+    sec_table_destroy(g_rate_limits);
+    g_failed_attempts =
+        sec_table_create(MAX_FAILED_ATTEMPTS, sizeof(failed_login_t), EXPIRY_TICK_MS);
+    g_rate_limits = sec_table_create(MAX_RATE_LIMIT_ENTRIES, sizeof(rate_limit_t), EXPIRY_TICK_MS);
+    if (!g_failed_attempts || !g_rate_limits) {
+        attack_prevention_cleanup();
+        return -1;
+    }
     return 0;
 }
 
@@ -60,11 +123,14 @@ bool attack_prevention_check_nonce(const uint8_t *nonce, size_t nonce_len) {
         return false;
     }
 
+    pthread_mutex_lock(&g_nonce_lock);
+
     /* Check if nonce already used */
     for (int i = 0; i < g_nonce_count && i < MAX_NONCES; i++) {
         if (g_nonce_cache[i].used &&
             crypto_prim_constant_time_compare(g_nonce_cache[i].nonce, nonce,
                                               nonce_len < 32 ? nonce_len : 32)) {
+            pthread_mutex_unlock(&g_nonce_lock);
             return false; /* Replay detected */
         }
     }
@@ -81,6 +147,7 @@ bool attack_prevention_check_nonce(const uint8_t *nonce, size_t nonce_len) {
         g_nonce_cache[MAX_NONCES - 1].used = true;
     }
 
+    pthread_mutex_unlock(&g_nonce_lock);
     return true;
 }
 
@@ -88,59 +155,28 @@ bool attack_prevention_check_nonce(const uint8_t *nonce, size_t nonce_len) {
  * Record failed login
  */
 int attack_prevention_record_failed_login(const char *username) {
-    if (!username) {
+    if (!username || !g_failed_attempts) {
         return -1;
     }
 
-    /* Find existing entry */
-    for (int i = 0; i < g_failed_count; i++) {
-        if (strcmp(g_failed_attempts[i].username, username) == 0) {
-            g_failed_attempts[i].failed_attempts++;
-
-            /* Lock account if threshold exceeded */
-            if (g_failed_attempts[i].failed_attempts >= LOCKOUT_THRESHOLD) {
-                struct timespec ts;
-                clock_gettime(CLOCK_REALTIME, &ts);
-                uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-                g_failed_attempts[i].lockout_until_us = now_us + LOCKOUT_DURATION_SEC * 1000000;
-            }
-            return 0;
-        }
-    }
-
-    /* Add new entry */
-    if (g_failed_count < MAX_FAILED_ATTEMPTS) {
-        strncpy(g_failed_attempts[g_failed_count].username, username, 63);
-        g_failed_attempts[g_failed_count].username[63] = '\0';
-        g_failed_attempts[g_failed_count].failed_attempts = 1;
-        g_failed_attempts[g_failed_count].lockout_until_us = 0;
-        g_failed_count++;
-    }
-
-    return 0;
+    tracker_req_t req = {.now_ms = sec_table_now_ms()};
+    return sec_table_apply(g_failed_attempts, username, true, req.now_ms, failed_login_record,
+                           &req) == 1
+               ? 0
+               : -1;
 }
 
 /*
  * Check if account locked
  */
 bool attack_prevention_is_account_locked(const char *username) {
-    if (!username) {
+    if (!username || !g_failed_attempts) {
         return false;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-
-    for (int i = 0; i < g_failed_count; i++) {
-        if (strcmp(g_failed_attempts[i].username, username) == 0) {
-            if (g_failed_attempts[i].lockout_until_us > now_us) {
-                return true; /* Account locked */
-            }
-        }
-    }
-
-    return false;
+    tracker_req_t req = {.now_ms = sec_table_now_ms()};
+    sec_table_apply(g_failed_attempts, username, false, req.now_ms, failed_login_locked, &req);
+    return req.result;
 }
 
 /*
@@ -151,14 +187,7 @@ int attack_prevention_reset_failed_attempts(const char *username) {
         return -1;
     }
 
-    for (int i = 0; i < g_failed_count; i++) {
-        if (strcmp(g_failed_attempts[i].username, username) == 0) {
-            g_failed_attempts[i].failed_attempts = 0;
-            g_failed_attempts[i].lockout_until_us = 0;
-            return 0;
-        }
-    }
-
+    sec_table_remove(g_failed_attempts, username);
     return 0;
 }
 
@@ -166,44 +195,13 @@ int attack_prevention_reset_failed_attempts(const char *username) {
  * Check rate limiting
  */
 bool attack_prevention_is_rate_limited(const char *client_id, uint32_t max_per_min) {
-    if (!client_id) {
+    if (!client_id || !g_rate_limits) {
         return false;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-    uint64_t window_us = 60 * 1000000; /* 1 minute */
-
-    /* Find existing entry */
-    for (int i = 0; i < g_rate_limit_count; i++) {
-        if (strcmp(g_rate_limits[i].client_id, client_id) == 0) {
-            /* Check if window expired */
-            if (now_us - g_rate_limits[i].window_start_us > window_us) {
-                /* Reset window */
-                g_rate_limits[i].request_count = 1;
-                g_rate_limits[i].window_start_us = now_us;
-                return false;
-            }
-
-            /* Increment counter */
-            g_rate_limits[i].request_count++;
-
-            /* Check limit */
-            return g_rate_limits[i].request_count > max_per_min;
-        }
-    }
-
-    /* Add new entry */
-    if (g_rate_limit_count < MAX_RATE_LIMIT_ENTRIES) {
-        strncpy(g_rate_limits[g_rate_limit_count].client_id, client_id, 127);
-        g_rate_limits[g_rate_limit_count].client_id[127] = '\0';
-        g_rate_limits[g_rate_limit_count].request_count = 1;
-        g_rate_limits[g_rate_limit_count].window_start_us = now_us;
-        g_rate_limit_count++;
-    }
-
-    return false;
+    tracker_req_t req = {.now_ms = sec_table_now_ms(), .max_per_min = max_per_min};
+    sec_table_apply(g_rate_limits, client_id, true, req.now_ms, rate_limit_count, &req);
+    return req.result;
 }
 
 /*
@@ -211,9 +209,9 @@ bool attack_prevention_is_rate_limited(const char *client_id, uint32_t max_per_m
  */
 void attack_prevention_cleanup(void) {
     crypto_prim_secure_wipe(g_nonce_cache, sizeof(g_nonce_cache));
-    crypto_prim_secure_wipe(g_failed_attempts, sizeof(g_failed_attempts));
-    memset(g_rate_limits, 0, sizeof(g_rate_limits));
     g_nonce_count = 0;
-    g_failed_count = 0;
-    g_rate_limit_count = 0;
+    sec_table_destroy(g_failed_attempts);
+    sec_table_destroy(g_rate_limits);
+    g_failed_attempts = NULL;
+    g_rate_limits = NULL;
 }
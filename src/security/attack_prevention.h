@@ -1,5 +1,8 @@
 /*
  * attack_prevention.h - Protection against common attacks
+ *
+ * Failed-login and rate-limit state is kept per username / client ID in
+ * sec_tables; all calls except init and cleanup are thread-safe.
  */
 
 #ifndef ROOTSTREAM_ATTACK_PREVENTION_H
@@ -0,0 +1,459 @@
+/*
+ * sec_table.c - Concurrent string-keyed hash table implementation
+ *
+ * Each shard keeps its entries in a slab (indices stay stable while the
+ * probe array is rehashed) and an open-addressing probe array of
+ * "entry index + 1" (0 = empty), grown at 3/4 load.  Deletion shifts the
+ * following cluster back instead of leaving tombstones, so probe lengths
+ * never degrade under churn.
+ *
+ * Entries with an expiry are linked into the shard's timer wheel, slot
+ * (expires_ms / tick_ms) % WHEEL_SLOTS.  The wheel cursor remembers the
+ * last tick reclaimed; expiring walks only the slots from there to now
+ * (re-walking the cursor's own slot, whose tick may have been partial)
+ * and skips entries that belong to a later lap.  Creating an entry also
+ * advances its shard's wheel, so tables reclaim themselves under load
+ * even if sec_table_expire() is never called.
+ */
+
+#include "sec_table.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crypto_primitives.h"
+
+#define WHEEL_SLOTS 512 /* Power of two */
+#define INITIAL_SLOTS 16
+#define NIL UINT32_MAX
+
+typedef struct {
+    uint64_t hash;
+    uint64_t expires_ms;  /* 0 = never */
+    uint32_t next;        /* Wheel list, or free list when unused */
+    uint32_t prev;        /* Wheel list (NIL at the head) */
+    uint32_t wheel_slot;  /* NIL when not on the wheel */
+    char key[SEC_TABLE_KEY_MAX];
+} entry_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    uint32_t *probe;      /* Entry index + 1, 0 = empty */
+    uint32_t mask;        /* Probe array size - 1 */
+    entry_t *entries;
+    uint8_t *values;
+    uint32_t capacity;    /* Allocated entries */
+    uint32_t high;        /* Entries ever handed out */
+    uint32_t used;        /* Live entries */
+    uint32_t free_head;
+    uint64_t wheel_tick;  /* Last tick reclaimed */
+    uint32_t wheel[WHEEL_SLOTS];
+    char pad[64];         /* Keep neighbouring shard locks off this line */
+} shard_t;
+
+struct sec_table_s {
+    size_t max_entries;
+    size_t value_size;
+    uint32_t tick_ms;
+    uint64_t seed;
+    atomic_size_t count;
+    shard_t shards[SEC_TABLE_SHARDS];
+};
+
+/* FNV-1a, seeded per table, then a murmur finalizer to spread the bits
+ * used for shard (top) and probe position (bottom) */
+static uint64_t hash_key(uint64_t seed, const char *key, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)key[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint8_t *value_of(const sec_table_t *t, const shard_t *s, uint32_t idx) {
+    return s->values + (size_t)idx * t->value_size;
+}
+
+/* ── Timer wheel ──────────────────────────────────────────────────── */
+
+static void wheel_link(const sec_table_t *t, shard_t *s, uint32_t idx) {
+    entry_t *e = &s->entries[idx];
+    if (e->expires_ms == 0) {
+        e->wheel_slot = NIL;
+        return;
+    }
+    /* Already-passed ticks go in the cursor slot, which is walked next */
+    uint64_t tick = e->expires_ms / t->tick_ms;
+    if (tick < s->wheel_tick) {
+        tick = s->wheel_tick;
+    }
+    uint32_t slot = (uint32_t)(tick & (WHEEL_SLOTS - 1));
+    e->wheel_slot = slot;
+    e->prev = NIL;
+    e->next = s->wheel[slot];
+    if (e->next != NIL) {
+        s->entries[e->next].prev = idx;
+    }
+    s->wheel[slot] = idx;
+}
+
+static void wheel_unlink(shard_t *s, uint32_t idx) {
+    entry_t *e = &s->entries[idx];
+    if (e->wheel_slot == NIL) {
+        return;
+    }
+    if (e->prev != NIL) {
+        s->entries[e->prev].next = e->next;
+    } else {
+        s->wheel[e->wheel_slot] = e->next;
+    }
+    if (e->next != NIL) {
+        s->entries[e->next].prev = e->prev;
+    }
+    e->wheel_slot = NIL;
+}
+
+/* ── Probe array ──────────────────────────────────────────────────── */
+
+/* Position of key in the probe array, or -1 */
+static int64_t find(const shard_t *s, uint64_t hash, const char *key) {
+    for (uint32_t i = (uint32_t)hash & s->mask;; i = (i + 1) & s->mask) {
+        uint32_t v = s->probe[i];
+        if (v == 0) {
+            return -1;
+        }
+        const entry_t *e = &s->entries[v - 1];
+        if (e->hash == hash && strcmp(e->key, key) == 0) {
+            return i;
+        }
+    }
+}
+
+static uint32_t empty_slot(const shard_t *s, uint64_t hash) {
+    uint32_t i = (uint32_t)hash & s->mask;
+    while (s->probe[i] != 0) {
+        i = (i + 1) & s->mask;
+    }
+    return i;
+}
+
+static int grow_probe(shard_t *s) {
+    uint32_t old_size = s->mask + 1;
+    uint32_t *old = s->probe;
+    uint32_t *probe = calloc((size_t)old_size * 2, sizeof(*probe));
+    if (!probe) {
+        return -1;
+    }
+    s->probe = probe;
+    s->mask = old_size * 2 - 1;
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (old[i] != 0) {
+            s->probe[empty_slot(s, s->entries[old[i] - 1].hash)] = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+/*
+ * Take an entry from the slab, growing it if needed
+ */
+static int64_t alloc_entry(const sec_table_t *t, shard_t *s) {
+    if (s->free_head != NIL) {
+        uint32_t idx = s->free_head;
+        s->free_head = s->entries[idx].next;
+        return idx;
+    }
+    if (s->high == s->capacity) {
+        uint32_t cap = s->capacity ? s->capacity * 2 : INITIAL_SLOTS;
+        entry_t *entries = realloc(s->entries, (size_t)cap * sizeof(*entries));
+        if (!entries) {
+            return -1;
+        }
+        s->entries = entries;
+        uint8_t *values = realloc(s->values, (size_t)cap * t->value_size);
+        if (!values) {
+            return -1;
+        }
+        s->values = values;
+        s->capacity = cap;
+    }
+    return s->high++;
+}
+
+/*
+ * Wipe the entry at probe position pos, return it to the free list and
+ * shift the rest of its cluster back into the hole
+ */
+static void remove_at(sec_table_t *t, shard_t *s, uint32_t pos) {
+    uint32_t idx = s->probe[pos] - 1;
+    wheel_unlink(s, idx);
+    crypto_prim_secure_wipe(s->entries[idx].key, sizeof(s->entries[idx].key));
+    crypto_prim_secure_wipe(value_of(t, s, idx), t->value_size);
+    s->entries[idx].next = s->free_head;
+    s->free_head = idx;
+    s->used--;
+    atomic_fetch_sub(&t->count, 1);
+
+    uint32_t hole = pos;
+    uint32_t j = pos;
+    for (;;) {
+        s->probe[hole] = 0;
+        for (;;) {
+            j = (j + 1) & s->mask;
+            if (s->probe[j] == 0) {
+                return;
+            }
+            /* Move j into the hole unless its home lies in (hole, j] */
+            uint32_t home = (uint32_t)s->entries[s->probe[j] - 1].hash & s->mask;
+            bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+            if (!stays) {
+                break;
+            }
+        }
+        s->probe[hole] = s->probe[j];
+        hole = j;
+    }
+}
+
+/*
+ * Reclaim a shard's expired entries (shard locked)
+ */
+static int expire_shard(sec_table_t *t, shard_t *s, uint64_t now_ms) {
+    uint64_t now_tick = now_ms / t->tick_ms;
+    if (now_tick < s->wheel_tick) {
+        return 0;
+    }
+    uint64_t span = now_tick - s->wheel_tick + 1;
+    if (span > WHEEL_SLOTS) {
+        span = WHEEL_SLOTS;
+    }
+
+    int removed = 0;
+    for (uint64_t k = 0; k < span; k++) {
+        uint32_t slot = (uint32_t)((now_tick - k) & (WHEEL_SLOTS - 1));
+        uint32_t idx = s->wheel[slot];
+        while (idx != NIL) {
+            entry_t *e = &s->entries[idx];
+            uint32_t next = e->next;
+            if (e->expires_ms <= now_ms) {
+                int64_t pos = find(s, e->hash, e->key);
+                if (pos >= 0) {
+                    remove_at(t, s, (uint32_t)pos);
+                    removed++;
+                }
+            }
+            idx = next;
+        }
+    }
+    s->wheel_tick = now_tick;
+    return removed;
+}
+
+/* ── Public API ───────────────────────────────────────────────────── */
+
+/*
+ * Create table
+ */
+sec_table_t *sec_table_create(size_t max_entries, size_t value_size, uint32_t tick_ms) {
+    if (max_entries == 0 || max_entries >= NIL || value_size == 0 || tick_ms == 0) {
+        return NULL;
+    }
+
+    sec_table_t *t = calloc(1, sizeof(*t));
+    if (!t) {
+        return NULL;
+    }
+    t->max_entries = max_entries;
+    t->value_size = value_size;
+    t->tick_ms = tick_ms;
+    atomic_init(&t->count, 0);
+    if (crypto_prim_random_bytes((uint8_t *)&t->seed, sizeof(t->seed)) != 0) {
+        t->seed = (uint64_t)(uintptr_t)t ^ sec_table_now_ms();
+    }
+
+    int shards_ready = 0;
+    for (; shards_ready < SEC_TABLE_SHARDS; shards_ready++) {
+        shard_t *s = &t->shards[shards_ready];
+        s->probe = calloc(INITIAL_SLOTS, sizeof(*s->probe));
+        if (!s->probe) {
+            break;
+        }
+        s->mask = INITIAL_SLOTS - 1;
+        s->free_head = NIL;
+        for (int i = 0; i < WHEEL_SLOTS; i++) {
+            s->wheel[i] = NIL;
+        }
+        pthread_mutex_init(&s->lock, NULL);
+    }
+    if (shards_ready < SEC_TABLE_SHARDS) {
+        for (int i = 0; i < shards_ready; i++) {
+            pthread_mutex_destroy(&t->shards[i].lock);
+            free(t->shards[i].probe);
+        }
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+/*
+ * Wipe and free table
+ */
+void sec_table_destroy(sec_table_t *t) {
+    if (!t) {
+        return;
+    }
+    for (int i = 0; i < SEC_TABLE_SHARDS; i++) {
+        shard_t *s = &t->shards[i];
+        if (s->entries) {
+            crypto_prim_secure_wipe(s->entries, (size_t)s->capacity * sizeof(*s->entries));
+            crypto_prim_secure_wipe(s->values, (size_t)s->capacity * t->value_size);
+        }
+        free(s->entries);
+        free(s->values);
+        free(s->probe);
+        pthread_mutex_destroy(&s->lock);
+    }
+    free(t);
+}
+
+/*
+ * Find or create entry and run callback on it
+ */
+int sec_table_apply(sec_table_t *t, const char *key, bool create, uint64_t now_ms,
+                    sec_table_fn fn, void *arg) {
+    if (!t || !key || !fn) {
+        return -1;
+    }
+    size_t len = strnlen(key, SEC_TABLE_KEY_MAX);
+    if (len == 0 || len >= SEC_TABLE_KEY_MAX) {
+        return -1;
+    }
+
+    uint64_t hash = hash_key(t->seed, key, len);
+    shard_t *s = &t->shards[hash >> 58];
+    pthread_mutex_lock(&s->lock);
+
+    int64_t pos = find(s, hash, key);
+    if (pos >= 0) {
+        uint64_t expires = s->entries[s->probe[pos] - 1].expires_ms;
+        if (expires != 0 && expires <= now_ms) {
+            remove_at(t, s, (uint32_t)pos);
+            pos = -1;
+        }
+    }
+
+    bool created = false;
+    if (pos < 0) {
+        if (!create) {
+            pthread_mutex_unlock(&s->lock);
+            return 0;
+        }
+        expire_shard(t, s, now_ms);
+        if (atomic_fetch_add(&t->count, 1) >= t->max_entries) {
+            atomic_fetch_sub(&t->count, 1);
+            pthread_mutex_unlock(&s->lock);
+            return -1;
+        }
+        if ((s->used + 1) * 4 > (s->mask + 1) * 3 && grow_probe(s) != 0) {
+            atomic_fetch_sub(&t->count, 1);
+            pthread_mutex_unlock(&s->lock);
+            return -1;
+        }
+        int64_t idx = alloc_entry(t, s);
+        if (idx < 0) {
+            atomic_fetch_sub(&t->count, 1);
+            pthread_mutex_unlock(&s->lock);
+            return -1;
+        }
+        entry_t *e = &s->entries[idx];
+        memset(e, 0, sizeof(*e));
+        memcpy(e->key, key, len);
+        e->hash = hash;
+        e->wheel_slot = NIL;
+        memset(value_of(t, s, (uint32_t)idx), 0, t->value_size);
+        pos = empty_slot(s, hash);
+        s->probe[pos] = (uint32_t)idx + 1;
+        s->used++;
+        created = true;
+    }
+
+    uint32_t idx = s->probe[pos] - 1;
+    entry_t *e = &s->entries[idx];
+    uint64_t expires = e->expires_ms;
+    if (fn(value_of(t, s, idx), created, &expires, arg) == SEC_TABLE_REMOVE) {
+        remove_at(t, s, (uint32_t)pos);
+    } else if (expires != e->expires_ms) {
+        wheel_unlink(s, idx);
+        e->expires_ms = expires;
+        wheel_link(t, s, idx);
+    }
+
+    pthread_mutex_unlock(&s->lock);
+    return 1;
+}
+
+/*
+ * Remove entry
+ */
+bool sec_table_remove(sec_table_t *t, const char *key) {
+    if (!t || !key) {
+        return false;
+    }
+    size_t len = strnlen(key, SEC_TABLE_KEY_MAX);
+    if (len == 0 || len >= SEC_TABLE_KEY_MAX) {
+        return false;
+    }
+
+    uint64_t hash = hash_key(t->seed, key, len);
+    shard_t *s = &t->shards[hash >> 58];
+    pthread_mutex_lock(&s->lock);
+    int64_t pos = find(s, hash, key);
+    if (pos >= 0) {
+        remove_at(t, s, (uint32_t)pos);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return pos >= 0;
+}
+
+/*
+ * Reclaim expired entries
+ */
+int sec_table_expire(sec_table_t *t, uint64_t now_ms) {
+    if (!t) {
+        return 0;
+    }
+    int removed = 0;
+    for (int i = 0; i < SEC_TABLE_SHARDS; i++) {
+        pthread_mutex_lock(&t->shards[i].lock);
+        removed += expire_shard(t, &t->shards[i], now_ms);
+        pthread_mutex_unlock(&t->shards[i].lock);
+    }
+    return removed;
+}
+
+/*
+ * Entry count
+ */
+size_t sec_table_count(const sec_table_t *t) {
+    return t ? atomic_load(&((sec_table_t *)t)->count) : 0;
+}
+
+/*
+ * Monotonic milliseconds
+ */
+uint64_t sec_table_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
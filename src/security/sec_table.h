@@ -0,0 +1,110 @@
+/*
+ * sec_table.h - Concurrent string-keyed hash table with timed expiry
+ *
+ * Backs the security layer's per-client state (sessions, failed logins,
+ * rate limits).  Keys hash to one of SEC_TABLE_SHARDS shards, each an
+ * open-addressing table (linear probing, backward-shift deletion) with
+ * its own mutex, so threads serving different clients rarely contend.
+ *
+ * Every entry may carry an expiry time.  Expired entries are invisible
+ * to lookups at once and are reclaimed by sec_table_expire(), which
+ * walks a per-shard timer wheel: only the wheel slots whose ticks have
+ * passed are visited, never the whole table.  Removed keys and values
+ * are wiped.
+ *
+ * Thread-safety: all functions except create/destroy may be called
+ * concurrently.  Callbacks run with the key's shard locked and must not
+ * call back into the same table.
+ */
+
+#ifndef ROOTSTREAM_SEC_TABLE_H
+#define ROOTSTREAM_SEC_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEC_TABLE_KEY_MAX 128 /* Key length limit, including NUL */
+#define SEC_TABLE_SHARDS 64   /* Independently locked shards */
+
+typedef enum {
+    SEC_TABLE_KEEP = 0,   /* Leave the entry in place */
+    SEC_TABLE_REMOVE = 1, /* Delete (and wipe) the entry */
+} sec_table_action_t;
+
+/*
+ * Entry callback for sec_table_apply()
+ *
+ * @param value       Entry value (zeroed when just created)
+ * @param created     True if the entry did not exist before this call
+ * @param expires_ms  In/out: expiry time (0 = never), same clock as now_ms
+ * @param arg         Caller context
+ * @return            What to do with the entry afterwards
+ */
+typedef sec_table_action_t (*sec_table_fn)(void *value, bool created, uint64_t *expires_ms,
+                                           void *arg);
+
+typedef struct sec_table_s sec_table_t;
+
+/*
+ * Create a table
+ *
+ * @param max_entries  Hard limit on live entries
+ * @param value_size   Bytes of value per entry
+ * @param tick_ms      Timer wheel resolution (expiry granularity)
+ * @return             Table, or NULL on error
+ */
+sec_table_t *sec_table_create(size_t max_entries, size_t value_size, uint32_t tick_ms);
+
+/*
+ * Wipe and free a table
+ */
+void sec_table_destroy(sec_table_t *t);
+
+/*
+ * Find (and optionally create) the entry for key and run fn on it
+ *
+ * @param t       Table
+ * @param key     NUL-terminated key (1..SEC_TABLE_KEY_MAX-1 bytes)
+ * @param create  Create the entry if absent or expired
+ * @param now_ms  Current time, for expiry
+ * @param fn      Callback run under the shard lock
+ * @param arg     Callback context
+ * @return        1 if fn ran, 0 if absent and !create, -1 on bad key / table full
+ */
+int sec_table_apply(sec_table_t *t, const char *key, bool create, uint64_t now_ms,
+                    sec_table_fn fn, void *arg);
+
+/*
+ * Remove the entry for key
+ *
+ * @return  true if an entry was removed
+ */
+bool sec_table_remove(sec_table_t *t, const char *key);
+
+/*
+ * Reclaim entries that expired at or before now_ms
+ *
+ * @return  Number of entries removed
+ */
+int sec_table_expire(sec_table_t *t, uint64_t now_ms);
+
+/*
+ * Number of entries (including expired ones not yet reclaimed)
+ */
+size_t sec_table_count(const sec_table_t *t);
+
+/*
+ * Monotonic clock in milliseconds, for now_ms / expires_ms
+ */
+uint64_t sec_table_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ROOTSTREAM_SEC_TABLE_H */
@@ -9,83 +9,114 @@
 #include <time.h>
 
 #include "crypto_primitives.h"
+#include "sec_table.h"
 
-#define MAX_SESSIONS 256
+#define MAX_SESSIONS 65536
 #define MAX_USERNAME 64
+#define EXPIRY_TICK_MS 1000
 
+/* Keyed by session ID */
 typedef struct {
-    char session_id[SESSION_ID_LEN];
     char username[MAX_USERNAME];
     uint64_t creation_time_us;
-    uint64_t expiration_time_us;
-    bool is_active;
     uint8_t session_secret[32];
 } session_t;
 
-static session_t g_sessions[MAX_SESSIONS];
-static int g_session_count = 0;
+static sec_table_t *g_sessions = NULL;
 static uint32_t g_timeout_sec = 3600;
 
+typedef struct {
+    const char *username;
+    uint64_t expires_ms;
+} session_new_t;
+
+static sec_table_action_t session_fill(void *value, bool created, uint64_t *expires_ms,
+                                       void *arg) {
+    session_t *s = value;
+    session_new_t *req = arg;
+
+    if (!created) {
+        /* 256-bit ID collision: leave the existing session alone */
+        req->username = NULL;
+        return SEC_TABLE_KEEP;
+    }
+
+    strncpy(s->username, req->username, MAX_USERNAME - 1);
+    s->username[MAX_USERNAME - 1] = '\0';
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    s->creation_time_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+    /* Generate session secret for PFS */
+    crypto_prim_random_bytes(s->session_secret, sizeof(s->session_secret));
+
+    *expires_ms = req->expires_ms;
+    return SEC_TABLE_KEEP;
+}
+
+static sec_table_action_t session_keep(void *value, bool created, uint64_t *expires_ms,
+                                       void *arg) {
+    (void)value;
+    (void)created;
+    (void)expires_ms;
+    (void)arg;
+    return SEC_TABLE_KEEP;
+}
+
+static sec_table_action_t session_extend(void *value, bool created, uint64_t *expires_ms,
+                                         void *arg) {
+    (void)value;
+    (void)created;
+    *expires_ms = *(const uint64_t *)arg;
+    return SEC_TABLE_KEEP;
+}
+
 /*
  * Initialize session manager
  */
 int session_manager_init(uint32_t timeout_sec) {
-    g_session_count = 0;
     g_timeout_sec = timeout_sec > 0 ? timeout_sec : 3600;
-    memset(g_sessions, 0, sizeof(g_sessions));
-    return crypto_prim_init();
+    if (crypto_prim_init() != 0) {
+        return -1;
+    }
+    sec_table_destroy(g_sessions);
+    g_sessions = sec_table_create(MAX_SESSIONS, sizeof(session_t), EXPIRY_TICK_MS);
+    return g_sessions ? 0 : -1;
 }
 
 /*
  * Create session
  */
 int session_manager_create(const char *username, char *session_id) {
-    if (!username || !session_id || g_session_count >= MAX_SESSIONS) {
-        return -1;
-    }
-
-    /* Find available slot */
-    int slot = -1;
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (!g_sessions[i].is_active) {
-            slot = i;
-            break;
-        }
-    }
-
-    if (slot == -1) {
+    if (!username || !session_id || !g_sessions) {
         return -1;
     }
 
     /* Generate session ID */
     uint8_t id_bytes[32];
+    char id[SESSION_ID_LEN];
     crypto_prim_random_bytes(id_bytes, sizeof(id_bytes));
 
     const char hex[] = "0123456789abcdef";
     for (int i = 0; i < 32; i++) {
-        g_sessions[slot].session_id[i * 2] = hex[(id_bytes[i] >> 4) & 0xF];
-        g_sessions[slot].session_id[i * 2 + 1] = hex[id_bytes[i] & 0xF];
+        id[i * 2] = hex[(id_bytes[i] >> 4) & 0xF];
+        id[i * 2 + 1] = hex[id_bytes[i] & 0xF];
+    }
+    id[64] = '\0';
+    crypto_prim_secure_wipe(id_bytes, sizeof(id_bytes));
+
+    uint64_t now_ms = sec_table_now_ms();
+    session_new_t req = {username, now_ms + (uint64_t)g_timeout_sec * 1000};
+    if (sec_table_apply(g_sessions, id, true, now_ms, session_fill, &req) != 1 ||
+        !req.username) {
+        crypto_prim_secure_wipe(id, sizeof(id));
+        return -1;
     }
-    g_sessions[slot].session_id[64] = '\0';
 
     /* Copy session ID to output */
-    strcpy(session_id, g_sessions[slot].session_id);
-
-    /* Set session info */
-    strncpy(g_sessions[slot].username, username, MAX_USERNAME - 1);
-    g_sessions[slot].username[MAX_USERNAME - 1] = '\0';
-
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    g_sessions[slot].creation_time_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-    g_sessions[slot].expiration_time_us =
-        g_sessions[slot].creation_time_us + (uint64_t)g_timeout_sec * 1000000;
-    g_sessions[slot].is_active = true;
-
-    /* Generate session secret for PFS */
-    crypto_prim_random_bytes(g_sessions[slot].session_secret, 32);
-
-    g_session_count++;
+    memcpy(session_id, id, SESSION_ID_LEN);
+    crypto_prim_secure_wipe(id, sizeof(id));
     return 0;
 }
 
@@ -93,99 +124,53 @@ int session_manager_create(const char *username, char *session_id) {
  * Validate session
  */
 bool session_manager_is_valid(const char *session_id) {
-    if (!session_id) {
+    if (!session_id || !g_sessions) {
         return false;
     }
 
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_active && strcmp(g_sessions[i].session_id, session_id) == 0) {
-            return now_us < g_sessions[i].expiration_time_us;
-        }
-    }
-
-    return false;
+    return sec_table_apply(g_sessions, session_id, false, sec_table_now_ms(), session_keep,
+                           NULL) == 1;
 }
 
 /*
  * Refresh session
  */
 int session_manager_refresh(const char *session_id) {
-    if (!session_id) {
+    if (!session_id || !g_sessions) {
         return -1;
     }
 
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_active && strcmp(g_sessions[i].session_id, session_id) == 0) {
-            struct timespec ts;
-            clock_gettime(CLOCK_REALTIME, &ts);
-            uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-            g_sessions[i].expiration_time_us = now_us + (uint64_t)g_timeout_sec * 1000000;
-            return 0;
-        }
-    }
-
-    return -1;
+    uint64_t now_ms = sec_table_now_ms();
+    uint64_t expires_ms = now_ms + (uint64_t)g_timeout_sec * 1000;
+    return sec_table_apply(g_sessions, session_id, false, now_ms, session_extend,
+                           &expires_ms) == 1
+               ? 0
+               : -1;
 }
 
 /*
  * Invalidate session
  */
 int session_manager_invalidate(const char *session_id) {
-    if (!session_id) {
+    if (!session_id || !g_sessions) {
         return -1;
     }
 
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_active && strcmp(g_sessions[i].session_id, session_id) == 0) {
-            /* Mark as inactive first */
-            g_sessions[i].is_active = false;
-
-            /* Securely wipe sensitive session data */
-            crypto_prim_secure_wipe(g_sessions[i].session_secret, 32);
-            crypto_prim_secure_wipe(g_sessions[i].session_id, SESSION_ID_LEN);
-
-            g_session_count--;
-            return 0;
-        }
-    }
-
-    return -1;
+    /* The table wipes the session secret and ID on removal */
+    return sec_table_remove(g_sessions, session_id) ? 0 : -1;
 }
 
 /*
  * Cleanup expired sessions
  */
 int session_manager_cleanup_expired(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    uint64_t now_us = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
-
-    int cleaned = 0;
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (g_sessions[i].is_active && now_us >= g_sessions[i].expiration_time_us) {
-            /* Mark as inactive first */
-            g_sessions[i].is_active = false;
-
-            /* Securely wipe sensitive session data */
-            crypto_prim_secure_wipe(g_sessions[i].session_secret, 32);
-            crypto_prim_secure_wipe(g_sessions[i].session_id, SESSION_ID_LEN);
-
-            g_session_count--;
-            cleaned++;
-        }
-    }
-
-    return cleaned;
+    return sec_table_expire(g_sessions, sec_table_now_ms());
 }
 
 /*
  * Cleanup
  */
 void session_manager_cleanup(void) {
-    crypto_prim_secure_wipe(g_sessions, sizeof(g_sessions));
-    g_session_count = 0;
+    sec_table_destroy(g_sessions);
+    g_sessions = NULL;
 }
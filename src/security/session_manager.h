@@ -1,5 +1,9 @@
 /*
  * session_manager.h - Secure session management with perfect forward secrecy
+ *
+ * Sessions are kept in a sec_table keyed by session ID, so lookups are
+ * O(1) and safe from any thread; init and cleanup must not race with
+ * other calls.
  */
 
 #ifndef ROOTSTREAM_SESSION_MANAGER_H
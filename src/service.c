@@ -21,6 +21,12 @@
 #include "../include/rootstream.h"
 #include "../include/rootstream_client_session.h"
 
+/* The staged pipeline and the deadline pacer are Linux-only */
+#ifndef _WIN32
+#include "pipeline/deadline_pacer.h"
+#include "pipeline/host_pipeline.h"
+#endif
+
 #ifdef _WIN32
 #include <fcntl.h>
 #include <io.h>
@@ -336,12 +342,12 @@ int service_run_host(rootstream_ctx_t *ctx) {
     } else {
         /* Try xdotool fallback */
         printf("INFO: uinput unavailable, trying xdotool...\n");
-        if (input_init_xdotool(ctx) == 0) {
+        if (input_manager_init(ctx, INPUT_BACKEND_XDOTOOL) == 0) {
             ctx->active_backend.input_name = "xdotool";
         } else {
             /* Fall back to logging mode */
             printf("INFO: xdotool unavailable, using logging mode...\n");
-            if (input_init_logging(ctx) == 0) {
+            if (input_manager_init(ctx, INPUT_BACKEND_LOGGING) == 0) {
                 ctx->active_backend.input_name = "logging (debug)";
             } else {
                 fprintf(stderr, "WARNING: All input backends failed\n");
@@ -463,34 +469,95 @@ int service_run_host(rootstream_ctx_t *ctx) {
     printf("Audio Play:    %s\n", ctx->active_backend.audio_play_name);
     printf("\n");
 
-    /* Main loop */
-    while (service_running && ctx->running) {
-        uint64_t loop_start_us = get_timestamp_us();
-
-        /* Capture frame */
-        if (ctx->capture_backend->capture_fn(ctx, &ctx->current_frame) < 0) {
-            fprintf(stderr, "ERROR: Capture failed (display=%s)\n", ctx->display.name);
-            fprintf(stderr, "DETAILS: %s\n", rootstream_get_error());
-            usleep(16000);
-            continue;
+#ifndef _WIN32
+    /* Pipelined mode: capture and encode run on their own threads and this
+     * loop becomes the send stage.  Serial mode keeps everything inline. */
+    host_pipeline_t *pipeline = NULL;
+    if (ctx->settings.pipeline_enabled) {
+        pipeline = host_pipeline_start(ctx, enc_buf_size, HOST_PIPELINE_DEFAULT_DEPTH);
+        if (!pipeline) {
+            printf("WARNING: Host pipeline unavailable, using serial loop\n");
+        } else {
+            ctx->latency.pipelined = true;
         }
-        uint64_t capture_end_us = get_timestamp_us();
+    }
+
+    dl_pacer_t pacer;
+    dl_pacer_init(&pacer, ctx->display.refresh_rate);
+#endif
 
-        /* Encode frame */
+    /* Main loop */
+    while (service_running && ctx->running) {
+        latency_sample_t sample = {0};
+        uint8_t *frame_data = enc_buf;
         size_t enc_size = 0;
         bool is_keyframe = false;
-        uint64_t encode_start_us = get_timestamp_us();
-        if (rootstream_encode_frame_ex(ctx, &ctx->current_frame, enc_buf, &enc_size, &is_keyframe) <
-            0) {
-            fprintf(stderr, "ERROR: Encode failed (frame=%lu)\n", ctx->frames_captured);
-            continue;
+        uint64_t frame_timestamp = 0;
+        uint64_t frame_start_us = 0;
+        bool unchanged = false;
+
+#ifndef _WIN32
+        host_encoded_frame_t *piped = NULL;
+        if (pipeline) {
+            /* Wait for the encode stage; keep servicing the network meanwhile */
+            uint32_t enc_depth = 0;
+            piped = host_pipeline_next(pipeline, 1000, &enc_depth);
+            if (!piped) {
+                rootstream_net_recv(ctx, 0);
+                rootstream_net_tick(ctx);
+                check_peer_health(ctx);
+                continue;
+            }
+
+            frame_data = piped->data;
+            enc_size = piped->size;
+            is_keyframe = piped->is_keyframe;
+            frame_timestamp = piped->timestamp;
+            frame_start_us = piped->capture_start_us;
+
+            sample.capture_us = piped->capture_end_us - piped->capture_start_us;
+            sample.encode_wait_us = piped->encode_start_us - piped->capture_end_us;
+            sample.encode_us = piped->encode_end_us - piped->encode_start_us;
+            sample.capture_queue_depth = piped->capture_queue_depth;
+            sample.encode_queue_depth = enc_depth;
+        } else
+#endif
+        {
+            frame_start_us = get_timestamp_us();
+
+            /* Capture frame */
+            int captured = ctx->capture_backend->capture_fn(ctx, &ctx->current_frame);
+            if (captured < 0) {
+                fprintf(stderr, "ERROR: Capture failed (display=%s)\n", ctx->display.name);
+                fprintf(stderr, "DETAILS: %s\n", rootstream_get_error());
+                usleep(16000);
+                continue;
+            }
+            uint64_t capture_end_us = get_timestamp_us();
+
+            if (captured == CAPTURE_UNCHANGED) {
+                /* Static screen: nothing to encode or send, audio still flows */
+                unchanged = true;
+            } else {
+                /* Encode frame */
+                uint64_t encode_start_us = get_timestamp_us();
+                if (rootstream_encode_frame_ex(ctx, &ctx->current_frame, enc_buf, &enc_size,
+                                               &is_keyframe) < 0) {
+                    fprintf(stderr, "ERROR: Encode failed (frame=%lu)\n", ctx->frames_captured);
+                    continue;
+                }
+                uint64_t encode_end_us = get_timestamp_us();
+
+                frame_timestamp = ctx->current_frame.timestamp;
+                sample.capture_us = capture_end_us - frame_start_us;
+                sample.encode_us = encode_end_us - encode_start_us;
+            }
         }
-        uint64_t encode_end_us = get_timestamp_us();
 
         /* Write to recording file if active */
-        if (ctx->recording.active) {
+        if (ctx->recording.active && !unchanged) {
             /* Use real keyframe detection from encoder */
-            if (recording_write_frame(ctx, enc_buf, enc_size, is_keyframe) < 0) {
+            if (recording_write_frame(ctx, frame_data, enc_size, is_keyframe) < 0) {
                 fprintf(stderr, "WARNING: Failed to write frame to recording\n");
             }
         }
@@ -518,17 +585,18 @@ int service_run_host(rootstream_ctx_t *ctx) {
             }
         }
 
-        /* Send to all connected peers */
+        /* Send to all connected peers: video fans out on the sender
+         * threads, audio goes out from here */
         uint64_t send_start_us = get_timestamp_us();
+        if (enc_size > 0) {
+            rootstream_net_send_video_all(ctx, frame_data, enc_size, frame_timestamp, is_keyframe);
+#ifndef _WIN32
+            input_manager_on_video_frame(ctx, frame_timestamp);
+#endif
+        }
         for (int i = 0; i < ctx->num_peers; i++) {
             peer_t *peer = &ctx->peers[i];
             if (peer->state == PEER_CONNECTED && peer->is_streaming) {
-                /* Send video */
-                if (enc_size > 0 && rootstream_net_send_video(ctx, peer, enc_buf, enc_size,
-                                                              ctx->current_frame.timestamp) < 0) {
-                    fprintf(stderr, "ERROR: Video send failed (peer=%s)\n", peer->hostname);
-                }
-
                 /* Send audio if available */
                 if (audio_size > 0) {
                     audio_packet_header_t header = {.timestamp_us = get_timestamp_us(),
@@ -549,26 +617,54 @@ int service_run_host(rootstream_ctx_t *ctx) {
         }
         uint64_t send_end_us = get_timestamp_us();
 
-        if (ctx->latency.enabled) {
-            latency_sample_t sample = {.capture_us = capture_end_us - loop_start_us,
-                                       .encode_us = encode_end_us - encode_start_us,
-                                       .send_us = send_end_us - send_start_us,
-                                       .total_us = send_end_us - loop_start_us};
+#ifndef _WIN32
+        if (piped) {
+            sample.send_wait_us = send_start_us - piped->encode_end_us;
+            host_pipeline_release(pipeline, piped);
+        }
+#endif
+
+        if (ctx->latency.enabled && !unchanged) {
+            sample.send_us = send_end_us - send_start_us;
+            sample.total_us = send_end_us - frame_start_us;
             latency_record(&ctx->latency, &sample);
         }
 
         /* Process incoming packets */
+#ifndef _WIN32
+        rootstream_net_recv(ctx, pipeline ? 0 : 1);
+#else
         rootstream_net_recv(ctx, 1);
+#endif
         rootstream_net_tick(ctx);
 
         /* Check peer health and reconnect if needed (PHASE 4) */
         check_peer_health(ctx);
 
-        /* Rate limiting */
+        /* Rate limiting: sleep to the next frame deadline rather than a full
+         * period after the work.  The pipeline paces in its capture stage. */
+#ifndef _WIN32
+        if (!pipeline) {
+            dl_pacer_wait(&pacer);
+        }
+#else
         uint32_t refresh_rate = ctx->display.refresh_rate ? ctx->display.refresh_rate : 60;
         usleep(1000000 / refresh_rate);
+#endif
     }
 
+#ifndef _WIN32
+    if (pipeline) {
+        host_pipeline_stats_t stats;
+        host_pipeline_get_stats(pipeline, &stats);
+        printf("INFO: Pipeline captured=%lu unchanged=%lu encoded=%lu dropped(raw=%lu enc=%lu) "
+               "overruns=%lu peak(raw=%u enc=%u)\n",
+               stats.captured, stats.capture_unchanged, stats.encoded, stats.capture_dropped,
+               stats.encode_dropped, stats.pacer_overruns, stats.capture_peak, stats.encode_peak);
+        host_pipeline_stop(pipeline);
+    }
+#endif
+
     free(enc_buf);
     return 0;
 }
@@ -14,6 +14,7 @@
 #include <unistd.h>
 
 #include "../include/rootstream.h"
+#include "colorconv/colorconv.h"
 
 /* VA-API headers (typically in /usr/include/va) */
 #include <va/va.h>
@@ -38,6 +39,7 @@ typedef struct {
     int fps;
     uint32_t surface_index; /* Current surface in ring buffer */
     uint32_t frame_num;     /* Frame counter for encoding */
+    colorconv_t *cc;        /* RGBA/BGRA → NV12 for surface uploads */
 } vaapi_ctx_t;
 
 /* Forward declare from drm_capture.c */
@@ -138,49 +140,6 @@ static bool detect_h265_keyframe(const uint8_t *data, size_t size) {
     return false;
 }
 
-/*
- * Convert RGBA to NV12 colorspace
- *
- * NV12 format: Planar YUV 4:2:0
- * - Y plane: full resolution (width x height)
- * - UV plane: half resolution (width x height/2), interleaved U/V
- *
- * Uses ITU-R BT.709 color matrix (HD standard)
- */
-static void rgba_to_nv12(const uint8_t *rgba, uint8_t *nv12_y, uint8_t *nv12_uv, int width,
-                         int height, int y_stride, int uv_stride) {
-    /* Convert each pixel */
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgba_idx = (y * width + x) * 4;
-            int y_idx = y * y_stride + x;
-
-            uint8_t r = rgba[rgba_idx];
-            uint8_t g = rgba[rgba_idx + 1];
-            uint8_t b = rgba[rgba_idx + 2];
-
-            /* ITU-R BT.709 coefficients for Y */
-            /* Y = 0.2126*R + 0.7152*G + 0.0722*B (scaled to 16-235 range) */
-            int y_val = (66 * r + 129 * g + 25 * b + 128) >> 8;
-            nv12_y[y_idx] = (uint8_t)(y_val + 16);
-
-            /* Sample U/V every 2x2 pixels (4:2:0 subsampling) */
-            if ((y & 1) == 0 && (x & 1) == 0) {
-                int uv_idx = (y / 2) * uv_stride + (x & ~1);
-
-                /* ITU-R BT.709 coefficients for U and V */
-                /* U = -0.1146*R - 0.3854*G + 0.5*B */
-                /* V =  0.5*R - 0.4542*G - 0.0458*B */
-                int u_val = (-38 * r - 74 * g + 112 * b + 128) >> 8;
-                int v_val = (112 * r - 94 * g - 18 * b + 128) >> 8;
-
-                nv12_uv[uv_idx] = (uint8_t)(u_val + 128);     /* U */
-                nv12_uv[uv_idx + 1] = (uint8_t)(v_val + 128); /* V */
-            }
-        }
-    }
-}
-
 /*
  * Check if VA-API encoder is available
  *
@@ -417,6 +376,22 @@ int rootstream_encoder_init(rootstream_ctx_t *ctx, encoder_type_t type, codec_ty
         return -1;
     }
 
+    /* Matrix follows what the client's SDL renderer assumes for
+     * untagged video: BT.601 for SD, BT.709 above */
+    va->cc = colorconv_create(colorconv_matrix_for_height(va->height), COLORCONV_RANGE_LIMITED, 0);
+    if (!va->cc) {
+        vaDestroyBuffer(va->display, va->coded_buf_id);
+        vaDestroyContext(va->display, va->context_id);
+        vaDestroySurfaces(va->display, va->surfaces, va->num_surfaces);
+        vaDestroyConfig(va->display, va->config_id);
+        vaTerminate(va->display);
+        free(va->surfaces);
+        free(va);
+        close(drm_fd);
+        fprintf(stderr, "Cannot create color converter\n");
+        return -1;
+    }
+
     /* Initialize ring buffer and frame counter */
     va->surface_index = 0;
     va->frame_num = 0;
@@ -459,6 +434,13 @@ int rootstream_encode_frame(rootstream_ctx_t *ctx, frame_buffer_t *in, uint8_t *
         return -1;
     }
 
+    /* Captured pixels, possibly read straight from a dmabuf mapping */
+    const uint8_t *pixels = frame_buffer_pixels(in);
+    if (!pixels) {
+        fprintf(stderr, "Frame has no CPU-readable pixels\n");
+        return -1;
+    }
+
     /* Use ring buffer for better performance */
     VASurfaceID surface = va->surfaces[va->surface_index];
     va->surface_index = (va->surface_index + 1) % va->num_surfaces;
@@ -479,23 +461,39 @@ int rootstream_encode_frame(rootstream_ctx_t *ctx, frame_buffer_t *in, uint8_t *
         return -1;
     }
 
-    /* Convert RGBA to NV12 with proper colorspace conversion */
-    uint8_t *y_plane = (uint8_t *)va_data;
-    uint8_t *uv_plane = y_plane + (image.pitches[0] * va->height);
+    /* Convert RGBA/BGRA to NV12 straight into the surface planes */
+    colorconv_image_t src, dst;
+    colorconv_image_init(&src, in->format == FRAME_FORMAT_BGRA ? COLORCONV_BGRA : COLORCONV_RGBA,
+                         (int)in->width, (int)in->height, (uint8_t *)pixels);
+    if (in->pitch) {
+        src.stride[0] = (int)in->pitch;
+    }
+    memset(&dst, 0, sizeof(dst));
+    dst.format = COLORCONV_NV12;
+    dst.width = va->width;
+    dst.height = va->height;
+    dst.plane[0] = (uint8_t *)va_data + image.offsets[0];
+    dst.plane[1] = (uint8_t *)va_data + image.offsets[1];
+    dst.stride[0] = (int)image.pitches[0];
+    dst.stride[1] = (int)image.pitches[1];
 
-    rgba_to_nv12(in->data, y_plane, uv_plane, va->width, va->height,
-                 image.pitches[0],  /* Y stride */
-                 image.pitches[1]); /* UV stride */
+    int conv = -1;
+    if (image.format.fourcc == VA_FOURCC_NV12) {
+        conv = colorconv_convert(va->cc, &src, &dst);
+    }
 
     vaUnmapBuffer(va->display, image.buf);
     vaDestroyImage(va->display, image.image_id);
 
-    /* Check if we should force a keyframe */
-    bool force_idr = ctx->encoder.force_keyframe;
-    if (force_idr) {
-        ctx->encoder.force_keyframe = false; /* Reset the flag */
+    if (conv != 0) {
+        fprintf(stderr, "Cannot convert %ux%u frame to NV12 surface (fourcc 0x%08x)\n",
+                in->width, in->height, image.format.fourcc);
+        return -1;
     }
 
+    /* Check if we should force a keyframe */
+    bool force_idr = encoder_take_keyframe(&ctx->encoder);
+
     /* Determine if this frame should be a keyframe */
     bool is_keyframe = force_idr || (va->frame_num % va->fps) == 0;
 
@@ -507,7 +505,7 @@ int rootstream_encode_frame(rootstream_ctx_t *ctx, frame_buffer_t *in, uint8_t *
     seq_param.intra_period = va->fps; /* I-frame every 1 second */
     seq_param.intra_idr_period = va->fps;
     seq_param.ip_period = 1; /* No B-frames for low latency (I and P only) */
-    seq_param.bits_per_second = ctx->encoder.bitrate;
+    seq_param.bits_per_second = encoder_get_bitrate(&ctx->encoder);
     seq_param.max_num_ref_frames = 1; /* Low latency - 1 reference frame */
     seq_param.picture_width_in_mbs = (va->width + 15) / 16;
     seq_param.picture_height_in_mbs = (va->height + 15) / 16;
@@ -735,6 +733,7 @@ void rootstream_encoder_cleanup(rootstream_ctx_t *ctx) {
     vaTerminate(va->display);
 
     close(ctx->encoder.device_fd);
+    colorconv_destroy(va->cc);
     free(va->surfaces);
     free(va);
 
@@ -458,3 +458,41 @@ int api_route_get_auth_verify(const http_request_t *req, char **response_body,
 
     return api_send_json_response(response_body, response_size, content_type, json);
 }
+
+/**
+ * Register all API routes
+ */
+int api_routes_register(api_server_t *server) {
+    static const struct {
+        const char *method;
+        const char *path;
+        request_handler_t handler;
+    } routes[] = {
+        {"GET", "/api/host/info", api_route_get_host_info},
+        {"POST", "/api/host/start", api_route_post_host_start},
+        {"POST", "/api/host/stop", api_route_post_host_stop},
+        {"GET", "/api/metrics/current", api_route_get_metrics_current},
+        {"GET", "/api/metrics/history", api_route_get_metrics_history},
+        {"GET", "/api/peers", api_route_get_peers},
+        {"GET", "/api/streams", api_route_get_streams},
+        {"POST", "/api/streams/:stream_id/record", api_route_post_stream_record},
+        {"POST", "/api/streams/:stream_id/stop-record", api_route_post_stream_stop_record},
+        {"GET", "/api/settings/video", api_route_get_settings_video},
+        {"PUT", "/api/settings/video", api_route_put_settings_video},
+        {"GET", "/api/settings/audio", api_route_get_settings_audio},
+        {"PUT", "/api/settings/audio", api_route_put_settings_audio},
+        {"GET", "/api/settings/network", api_route_get_settings_network},
+        {"PUT", "/api/settings/network", api_route_put_settings_network},
+        {"POST", "/api/auth/login", api_route_post_auth_login},
+        {"POST", "/api/auth/logout", api_route_post_auth_logout},
+        {"GET", "/api/auth/verify", api_route_get_auth_verify},
+    };
+
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+        if (api_server_register_route(server, routes[i].path, routes[i].method,
+                                      routes[i].handler) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -76,6 +76,11 @@ int api_route_post_auth_logout(const http_request_t *req, char **response_body,
 int api_route_get_auth_verify(const http_request_t *req, char **response_body,
                               size_t *response_size, char **content_type);
 
+/**
+ * Register every endpoint above under /api (see docs/WEB_DASHBOARD_API.md)
+ */
+int api_routes_register(api_server_t *server);
+
 /**
  * Set the auth manager for API routes to use
  */
@@ -9,16 +9,51 @@
 #include <stdlib.h>
 #include <string.h>
 
-// Stub implementation for now - will be expanded with libmicrohttpd
-// when dependencies are properly installed
+#include "http_server.h"
+
+// Routes are served by the embedded event-loop server (http_server.c)
+
+typedef struct route_binding {
+    request_handler_t handler;
+    struct route_binding *next;
+} route_binding_t;
 
 struct api_server {
     api_server_config_t config;
-    void *mhd_daemon;  // struct MHD_Daemon *
-    pthread_t thread;
+    http_server_t *http;
+    route_binding_t *bindings;  // Owned adapters passed to http_server_route
     bool running;
 };
 
+/**
+ * Adapt a request_handler_t to the event-loop server
+ */
+static void dispatch(const http_request_t *req, http_response_t *res, void *user) {
+    const route_binding_t *binding = user;
+    char *body = NULL;
+    size_t size = 0;
+    char *content_type = NULL;
+
+    if (binding->handler(req, &body, &size, &content_type) != 0) {
+        free(body);
+        free(content_type);
+        body = NULL;
+        content_type = NULL;
+        res->status = 500;
+        api_send_error_response(&body, &size, &content_type, 500, "Handler failed");
+    }
+
+    res->body = body;
+    res->body_len = body ? size : 0;
+    if (content_type) {
+        // The header is formatted before the handler's string is freed
+        static __thread char type_buf[64];
+        snprintf(type_buf, sizeof(type_buf), "%s", content_type);
+        res->content_type = type_buf;
+        free(content_type);
+    }
+}
+
 /**
  * Initialize API server
  */
@@ -36,6 +71,17 @@ api_server_t *api_server_init(const api_server_config_t *config) {
     server->config = *config;
     server->running = false;
 
+    http_server_config_t http_config = {
+        .port = config->port,
+        .max_connections = config->max_connections,
+        .idle_timeout_ms = config->timeout_seconds * 1000,
+    };
+    server->http = http_server_create(&http_config);
+    if (!server->http) {
+        free(server);
+        return NULL;
+    }
+
     return server;
 }
 
@@ -48,8 +94,18 @@ int api_server_register_route(api_server_t *server, const char *path, const char
         return -1;
     }
 
-    // TODO: Implement route registration with libmicrohttpd
-    // For now, this is a stub
+    route_binding_t *binding = (route_binding_t *)calloc(1, sizeof(route_binding_t));
+    if (!binding) {
+        return -1;
+    }
+    binding->handler = handler;
+
+    if (http_server_route(server->http, method, path, dispatch, binding) != 0) {
+        free(binding);
+        return -1;
+    }
+    binding->next = server->bindings;
+    server->bindings = binding;
 
     return 0;
 }
@@ -62,11 +118,18 @@ int api_server_start(api_server_t *server) {
         return -1;
     }
 
-    // TODO: Start libmicrohttpd daemon
-    // For now, just mark as running
+    if (server->config.enable_https) {
+        // No TLS stack is linked: terminate HTTPS in a reverse proxy instead
+        fprintf(stderr, "API server: HTTPS is not supported by the embedded server\n");
+        return -1;
+    }
+
+    if (http_server_start(server->http) != 0) {
+        return -1;
+    }
     server->running = true;
 
-    printf("API server started on port %u\n", server->config.port);
+    printf("API server started on port %u\n", http_server_get_port(server->http));
 
     return 0;
 }
@@ -79,7 +142,7 @@ int api_server_stop(api_server_t *server) {
         return -1;
     }
 
-    // TODO: Stop libmicrohttpd daemon
+    http_server_stop(server->http);
     server->running = false;
 
     printf("API server stopped\n");
@@ -87,6 +150,13 @@ int api_server_stop(api_server_t *server) {
     return 0;
 }
 
+/**
+ * Get listening port
+ */
+uint16_t api_server_get_port(const api_server_t *server) {
+    return server ? http_server_get_port(server->http) : 0;
+}
+
 /**
  * Cleanup API server
  */
@@ -99,6 +169,12 @@ void api_server_cleanup(api_server_t *server) {
         api_server_stop(server);
     }
 
+    http_server_destroy(server->http);
+    while (server->bindings) {
+        route_binding_t *next = server->bindings->next;
+        free(server->bindings);
+        server->bindings = next;
+    }
     free(server);
 }
 
@@ -38,7 +38,7 @@ typedef int (*request_handler_t)(const http_request_t *req, char **response_body
  * API server configuration
  */
 typedef struct {
-    uint16_t port;  // Default 8080
+    uint16_t port;  // Default 8080, 0 = ephemeral (see api_server_get_port)
     bool enable_https;
     const char *cert_file;
     const char *key_file;
@@ -72,6 +72,11 @@ int api_server_start(api_server_t *server);
  */
 int api_server_stop(api_server_t *server);
 
+/**
+ * Get listening port (0 if not started)
+ */
+uint16_t api_server_get_port(const api_server_t *server);
+
 /**
  * Cleanup API server
  */
@@ -0,0 +1,130 @@
+/**
+ * PHASE 19: Web Dashboard - Embedded HTTP/1.1 + WebSocket server
+ *
+ * One event-loop thread multiplexes every connection with edge-triggered
+ * epoll: HTTP/1.1 with keep-alive and pipelining, routes matched through
+ * a path-segment trie, and RFC 6455 WebSocket upgrades.  Response bodies
+ * and broadcast frames are queued by reference and sent with writev(),
+ * never copied into per-connection buffers: a broadcast frame is built
+ * once and shared by every subscriber.  Broadcasting only enqueues the
+ * frame and wakes the loop, so callers (metrics, streaming threads) never
+ * wait on a socket.
+ *
+ * Thread-safety: routes must be registered before http_server_start().
+ * http_server_broadcast() and the getters may be called from any thread.
+ * Handlers run on the event-loop thread and must not block.
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "api_server.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Server configuration (zero fields take the defaults in brackets)
+ */
+typedef struct {
+    uint16_t port;             // 0 = ephemeral, see http_server_get_port()
+    const char *bind_addr;     // IPv4 address [0.0.0.0]
+    uint32_t max_connections;  // Concurrent sockets [4096]
+    uint32_t idle_timeout_ms;  // Idle HTTP keep-alive connections [30000]
+    size_t max_request_bytes;  // Request line + headers + body [65536]
+    size_t max_pending_bytes;  // Unsent bytes before a WebSocket client skips frames [1 MiB]
+} http_server_config_t;
+
+/**
+ * Route response.  body must be malloc()ed; the server takes ownership and
+ * sends it as is.
+ */
+typedef struct {
+    int status;                // HTTP status [200]
+    const char *content_type;  // Copied into the header [application/json]
+    char *body;
+    size_t body_len;
+} http_response_t;
+
+/**
+ * Route handler, called on the event-loop thread
+ */
+typedef void (*http_route_fn)(const http_request_t *req, http_response_t *res, void *user);
+
+/**
+ * Server statistics (monotonic since create)
+ */
+typedef struct {
+    uint64_t connections;     // Accepted sockets
+    uint64_t rejected;        // Sockets refused at max_connections
+    uint64_t requests;        // HTTP requests answered
+    uint64_t broadcasts;      // Frames passed to http_server_broadcast()
+    uint64_t frames_sent;     // Broadcast frames queued to clients
+    uint64_t frames_skipped;  // Broadcast frames skipped for slow clients
+} http_server_stats_t;
+
+typedef struct http_server http_server_t;
+
+/**
+ * Create server (does not listen yet)
+ */
+http_server_t *http_server_create(const http_server_config_t *config);
+
+/**
+ * Register handler for method + path.  A segment of the form ":name"
+ * matches any single segment, e.g. "/api/streams/:id/record".
+ */
+int http_server_route(http_server_t *server, const char *method, const char *path,
+                      http_route_fn fn, void *user);
+
+/**
+ * Accept WebSocket upgrades on path (NULL = any path)
+ */
+int http_server_websocket(http_server_t *server, const char *path);
+
+/**
+ * Bind, listen and start the event-loop thread
+ */
+int http_server_start(http_server_t *server);
+
+/**
+ * Stop the event loop and close every connection
+ */
+int http_server_stop(http_server_t *server);
+
+/**
+ * Stop (if running) and free server
+ */
+void http_server_destroy(http_server_t *server);
+
+/**
+ * Queue a text frame to every WebSocket client.  Returns the number of
+ * clients connected at the time, or -1 on error.
+ */
+int http_server_broadcast(http_server_t *server, const char *text, size_t len);
+
+/**
+ * Bound port (after start), 0 if not listening
+ */
+uint16_t http_server_get_port(const http_server_t *server);
+
+/**
+ * Number of connected WebSocket clients
+ */
+int http_server_get_ws_count(const http_server_t *server);
+
+/**
+ * Get statistics
+ */
+void http_server_get_stats(const http_server_t *server, http_server_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // HTTP_SERVER_H
@@ -4,23 +4,57 @@
 
 #include "websocket_server.h"
 
-#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-// Stub implementation for now - will be expanded with libwebsockets
-// when dependencies are properly installed
+#include "http_server.h"
+
+// Dashboards connect to any path; frames are fanned out by http_server.c
 
 struct websocket_server {
     websocket_server_config_t config;
-    void *lws_context;  // struct lws_context *
-    pthread_t thread;
+    http_server_t *http;
     bool running;
-    int client_count;
-    pthread_mutex_t lock;
 };
 
+/**
+ * Append src to buf as a JSON string literal
+ */
+static size_t json_escape(char *buf, size_t size, size_t pos, const char *src) {
+    static const char hex[] = "0123456789abcdef";
+    if (pos < size) {
+        buf[pos] = '"';
+    }
+    pos++;
+    for (const unsigned char *p = (const unsigned char *)src; *p; p++) {
+        char esc[7];
+        size_t n = 0;
+        if (*p == '"' || *p == '\\') {
+            esc[n++] = '\\';
+            esc[n++] = (char)*p;
+        } else if (*p < 0x20) {
+            esc[n++] = '\\';
+            esc[n++] = 'u';
+            esc[n++] = '0';
+            esc[n++] = '0';
+            esc[n++] = hex[*p >> 4];
+            esc[n++] = hex[*p & 0xF];
+        } else {
+            esc[n++] = (char)*p;
+        }
+        for (size_t i = 0; i < n; i++, pos++) {
+            if (pos < size) {
+                buf[pos] = esc[i];
+            }
+        }
+    }
+    if (pos < size) {
+        buf[pos] = '"';
+    }
+    return pos + 1;
+}
+
 /**
  * Initialize WebSocket server
  */
@@ -37,8 +71,14 @@ websocket_server_t *websocket_server_init(const websocket_server_config_t *confi
     // Copy configuration
     server->config = *config;
     server->running = false;
-    server->client_count = 0;
-    pthread_mutex_init(&server->lock, NULL);
+
+    http_server_config_t http_config = {.port = config->port};
+    server->http = http_server_create(&http_config);
+    if (!server->http || http_server_websocket(server->http, NULL) != 0) {
+        http_server_destroy(server->http);
+        free(server);
+        return NULL;
+    }
 
     return server;
 }
@@ -51,11 +91,18 @@ int websocket_server_start(websocket_server_t *server) {
         return -1;
     }
 
-    // TODO: Initialize libwebsockets context
-    // For now, just mark as running
+    if (server->config.enable_wss) {
+        // No TLS stack is linked: terminate WSS in a reverse proxy instead
+        fprintf(stderr, "WebSocket server: WSS is not supported by the embedded server\n");
+        return -1;
+    }
+
+    if (http_server_start(server->http) != 0) {
+        return -1;
+    }
     server->running = true;
 
-    printf("WebSocket server started on port %u\n", server->config.port);
+    printf("WebSocket server started on port %u\n", http_server_get_port(server->http));
 
     return 0;
 }
@@ -68,7 +115,7 @@ int websocket_server_stop(websocket_server_t *server) {
         return -1;
     }
 
-    // TODO: Shutdown libwebsockets context
+    http_server_stop(server->http);
     server->running = false;
 
     printf("WebSocket server stopped\n");
@@ -85,16 +132,25 @@ int websocket_server_broadcast_metrics(websocket_server_t *server,
         return -1;
     }
 
-    pthread_mutex_lock(&server->lock);
-
-    // TODO: Format metrics as JSON and broadcast via libwebsockets
-    // For now, just log
-    printf("Broadcasting metrics: FPS=%u, RTT=%ums, GPU=%u%%\n", metrics->fps, metrics->rtt_ms,
-           metrics->gpu_util);
-
-    pthread_mutex_unlock(&server->lock);
+    // Same fields as GET /api/metrics/current, wrapped for the dashboard
+    char json[512];
+    int len = snprintf(json, sizeof(json),
+                       "{\"type\": \"metrics\", \"data\": {"
+                       "\"fps\": %u, \"rtt_ms\": %u, \"jitter_ms\": %u, "
+                       "\"gpu_util\": %u, \"gpu_temp\": %u, \"cpu_util\": %u, "
+                       "\"bandwidth_mbps\": %.1f, \"packets_sent\": %llu, "
+                       "\"packets_lost\": %llu, \"bytes_sent\": %llu, \"timestamp_us\": %llu}}",
+                       metrics->fps, metrics->rtt_ms, metrics->jitter_ms, metrics->gpu_util,
+                       metrics->gpu_temp, metrics->cpu_util, (double)metrics->bandwidth_mbps,
+                       (unsigned long long)metrics->packets_sent,
+                       (unsigned long long)metrics->packets_lost,
+                       (unsigned long long)metrics->bytes_sent,
+                       (unsigned long long)metrics->timestamp_us);
+    if (len < 0 || (size_t)len >= sizeof(json)) {
+        return -1;
+    }
 
-    return 0;
+    return http_server_broadcast(server->http, json, (size_t)len) < 0 ? -1 : 0;
 }
 
 /**
@@ -106,14 +162,24 @@ int websocket_server_broadcast_event(websocket_server_t *server, const char *eve
         return -1;
     }
 
-    pthread_mutex_lock(&server->lock);
-
-    // TODO: Format event as JSON and broadcast via libwebsockets
-    printf("Broadcasting event: %s = %s\n", event_type, data);
-
-    pthread_mutex_unlock(&server->lock);
-
-    return 0;
+    // {"type": <event_type>, "data": <data>} with both sent as JSON strings
+    char stack_buf[1024];
+    size_t need = 10 + json_escape(NULL, 0, 0, event_type) + 10 + json_escape(NULL, 0, 0, data) + 2;
+    char *json = need <= sizeof(stack_buf) ? stack_buf : (char *)malloc(need);
+    if (!json) {
+        return -1;
+    }
+    size_t pos = (size_t)snprintf(json, need, "{\"type\": ");
+    pos = json_escape(json, need, pos, event_type);
+    pos += (size_t)snprintf(json + pos, need - pos, ", \"data\": ");
+    pos = json_escape(json, need, pos, data);
+    json[pos++] = '}';
+
+    int ret = http_server_broadcast(server->http, json, pos) < 0 ? -1 : 0;
+    if (json != stack_buf) {
+        free(json);
+    }
+    return ret;
 }
 
 /**
@@ -124,11 +190,14 @@ int websocket_server_get_client_count(websocket_server_t *server) {
         return -1;
     }
 
-    pthread_mutex_lock(&server->lock);
-    int count = server->client_count;
-    pthread_mutex_unlock(&server->lock);
+    return http_server_get_ws_count(server->http);
+}
 
-    return count;
+/**
+ * Get listening port
+ */
+uint16_t websocket_server_get_port(const websocket_server_t *server) {
+    return server ? http_server_get_port(server->http) : 0;
 }
 
 /**
@@ -143,6 +212,6 @@ void websocket_server_cleanup(websocket_server_t *server) {
         websocket_server_stop(server);
     }
 
-    pthread_mutex_destroy(&server->lock);
+    http_server_destroy(server->http);
     free(server);
 }
@@ -20,7 +20,7 @@ extern "C" {
  * WebSocket server configuration
  */
 typedef struct {
-    uint16_t port;    // Default 8081
+    uint16_t port;    // Default 8081, 0 = ephemeral
     bool enable_wss;  // WSS/TLS
     const char *cert_file;
     const char *key_file;
@@ -63,6 +63,11 @@ int websocket_server_broadcast_event(websocket_server_t *server, const char *eve
  */
 int websocket_server_get_client_count(websocket_server_t *server);
 
+/**
+ * Get listening port (0 if not started)
+ */
+uint16_t websocket_server_get_port(const websocket_server_t *server);
+
 /**
  * Cleanup WebSocket server
  */
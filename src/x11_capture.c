@@ -3,8 +3,18 @@
  *
  * Fallback capture backend when DRM is unavailable:
  * - Works on X11 systems without DRM access
- * - Uses XGetImage or XShm for screen capture
- * - Slower than DRM but more compatible
+ * - MIT-SHM: XShmGetImage into a persistent shared segment, so a grab
+ *   is one request and the pixels land directly in our memory
+ * - Plain XGetImage when the server has no MIT-SHM or is remote
+ * - XDamage: only damaged rectangles are re-read; a static screen
+ *   returns CAPTURE_UNCHANGED and the caller skips encode and send
+ *
+ * The last grabbed screen is kept in a shadow image (the SHM image
+ * itself when MIT-SHM is available).  Damaged rectangles are grabbed
+ * into a scratch area of the segment and copied into the shadow; the
+ * shadow is then copied to the caller's frame with one memcpy per row.
+ * 32-bit TrueColor visuals are passed through as BGRA (or RGBA) with no
+ * per-pixel conversion; the encoders' colour converter reads both.
  */
 
 #include <stdarg.h>
@@ -19,10 +29,44 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 
+#ifdef HAVE_XSHM
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
+#ifdef HAVE_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#endif
+
 typedef struct {
     Display *display;
     Window root;
     int screen;
+    Visual *visual;
+    int depth;
+    int width;
+    int height;
+    uint32_t pixel_format; /* FRAME_FORMAT_BGRA or FRAME_FORMAT_RGBA */
+
+    /* Last grabbed screen */
+    uint8_t *shadow;
+    int shadow_stride;
+    bool shadow_valid;
+
+#ifdef HAVE_XSHM
+    bool use_shm;
+    XShmSegmentInfo shm;
+    XImage *shm_image; /* Whole screen; its data is the shadow */
+    uint8_t *scratch;  /* Second half of the segment, for damaged rects */
+#endif
+
+#ifdef HAVE_XDAMAGE
+    bool use_damage;
+    Damage damage;
+    XserverRegion region;
+#endif
 } x11_capture_ctx_t;
 
 static x11_capture_ctx_t x11_ctx = {0};
@@ -39,6 +83,173 @@ static void set_error(const char *fmt, ...) {
     va_end(args);
 }
 
+/*
+ * Pick the byte order frames are handed out in from the visual masks
+ */
+static int detect_pixel_format(XImage *image) {
+    if (image->bits_per_pixel != 32) {
+        return -1;
+    }
+
+    unsigned long r = image->red_mask, g = image->green_mask, b = image->blue_mask;
+    if (g != 0xFF00) {
+        return -1;
+    }
+
+    /* In memory order: LSBFirst 0xRRGGBB is B,G,R,X */
+    bool lsb = image->byte_order == LSBFirst;
+    if (r == 0xFF0000 && b == 0xFF) {
+        return lsb ? FRAME_FORMAT_BGRA : -1;
+    }
+    if (r == 0xFF && b == 0xFF0000) {
+        return lsb ? FRAME_FORMAT_RGBA : -1;
+    }
+    return -1;
+}
+
+#ifdef HAVE_XSHM
+
+static bool shm_attach_failed = false;
+
+static int shm_error_handler(Display *display, XErrorEvent *event) {
+    (void)display;
+    (void)event;
+    shm_attach_failed = true;
+    return 0;
+}
+
+/*
+ * Create the shared segment: full-screen image + equally sized scratch
+ *
+ * Fails quietly on remote displays (XShmAttach raises BadAccess).
+ */
+static bool shm_init(void) {
+    if (!XShmQueryExtension(x11_ctx.display)) {
+        return false;
+    }
+
+    XImage *image = XShmCreateImage(x11_ctx.display, x11_ctx.visual, x11_ctx.depth, ZPixmap,
+                                    NULL, &x11_ctx.shm, x11_ctx.width, x11_ctx.height);
+    if (!image) {
+        return false;
+    }
+
+    size_t image_size = (size_t)image->bytes_per_line * image->height;
+    x11_ctx.shm.shmid = shmget(IPC_PRIVATE, 2 * image_size, IPC_CREAT | 0600);
+    if (x11_ctx.shm.shmid < 0) {
+        XDestroyImage(image);
+        return false;
+    }
+
+    x11_ctx.shm.shmaddr = shmat(x11_ctx.shm.shmid, NULL, 0);
+    if (x11_ctx.shm.shmaddr == (char *)-1) {
+        shmctl(x11_ctx.shm.shmid, IPC_RMID, NULL);
+        XDestroyImage(image);
+        return false;
+    }
+    image->data = x11_ctx.shm.shmaddr;
+    x11_ctx.shm.readOnly = False;
+
+    XErrorHandler old_handler = XSetErrorHandler(shm_error_handler);
+    shm_attach_failed = false;
+    XShmAttach(x11_ctx.display, &x11_ctx.shm);
+    XSync(x11_ctx.display, False);
+    XSetErrorHandler(old_handler);
+
+    /* The segment goes away once both sides have detached */
+    shmctl(x11_ctx.shm.shmid, IPC_RMID, NULL);
+
+    if (shm_attach_failed) {
+        shmdt(x11_ctx.shm.shmaddr);
+        image->data = NULL;
+        XDestroyImage(image);
+        return false;
+    }
+
+    x11_ctx.shm_image = image;
+    x11_ctx.scratch = (uint8_t *)x11_ctx.shm.shmaddr + image_size;
+    x11_ctx.shadow = (uint8_t *)image->data;
+    x11_ctx.shadow_stride = image->bytes_per_line;
+    x11_ctx.use_shm = true;
+    return true;
+}
+
+static void shm_cleanup(void) {
+    if (!x11_ctx.use_shm) {
+        return;
+    }
+
+    XShmDetach(x11_ctx.display, &x11_ctx.shm);
+    XSync(x11_ctx.display, False);
+    shmdt(x11_ctx.shm.shmaddr);
+    x11_ctx.shm_image->data = NULL; /* Not malloc'd; keep XDestroyImage off it */
+    XDestroyImage(x11_ctx.shm_image);
+    x11_ctx.shm_image = NULL;
+    x11_ctx.shadow = NULL;
+    x11_ctx.use_shm = false;
+}
+
+#endif /* HAVE_XSHM */
+
+/*
+ * Copy rows of an image into the shadow at (x, y)
+ */
+static void blit_to_shadow(const uint8_t *src, int src_stride, int x, int y, int w, int h) {
+    uint8_t *dst = x11_ctx.shadow + (size_t)y * x11_ctx.shadow_stride + (size_t)x * 4;
+    for (int row = 0; row < h; row++) {
+        memcpy(dst, src, (size_t)w * 4);
+        dst += x11_ctx.shadow_stride;
+        src += src_stride;
+    }
+}
+
+/*
+ * Refresh the shadow from the screen for one rectangle
+ */
+static int grab_rect(int x, int y, int w, int h) {
+#ifdef HAVE_XSHM
+    if (x11_ctx.use_shm) {
+        if (x == 0 && y == 0 && w == x11_ctx.width && h == x11_ctx.height) {
+            /* Whole screen straight into the shadow */
+            if (!XShmGetImage(x11_ctx.display, x11_ctx.root, x11_ctx.shm_image, 0, 0,
+                              AllPlanes)) {
+                set_error("XShmGetImage failed");
+                return -1;
+            }
+            return 0;
+        }
+
+        XImage *sub = XShmCreateImage(x11_ctx.display, x11_ctx.visual, x11_ctx.depth, ZPixmap,
+                                      (char *)x11_ctx.scratch, &x11_ctx.shm, w, h);
+        if (!sub) {
+            set_error("XShmCreateImage failed");
+            return -1;
+        }
+        int ok = XShmGetImage(x11_ctx.display, x11_ctx.root, sub, x, y, AllPlanes);
+        if (ok) {
+            blit_to_shadow((const uint8_t *)sub->data, sub->bytes_per_line, x, y, w, h);
+        }
+        sub->data = NULL;
+        XDestroyImage(sub);
+        if (!ok) {
+            set_error("XShmGetImage failed");
+            return -1;
+        }
+        return 0;
+    }
+#endif
+
+    XImage *image = XGetImage(x11_ctx.display, x11_ctx.root, x, y, (unsigned int)w,
+                              (unsigned int)h, AllPlanes, ZPixmap);
+    if (!image) {
+        set_error("XGetImage failed");
+        return -1;
+    }
+    blit_to_shadow((const uint8_t *)image->data, image->bytes_per_line, x, y, w, h);
+    XDestroyImage(image);
+    return 0;
+}
+
 /*
  * Initialize X11 capture
  */
@@ -66,6 +277,24 @@ int rootstream_capture_init_x11(rootstream_ctx_t *ctx) {
         x11_ctx.display = NULL;
         return -1;
     }
+    x11_ctx.visual = attrs.visual;
+    x11_ctx.depth = attrs.depth;
+    x11_ctx.width = attrs.width;
+    x11_ctx.height = attrs.height;
+
+    /* Probe the pixel layout with a 1x1 grab */
+    XImage *probe = XGetImage(x11_ctx.display, x11_ctx.root, 0, 0, 1, 1, AllPlanes, ZPixmap);
+    int format = probe ? detect_pixel_format(probe) : -1;
+    if (probe) {
+        XDestroyImage(probe);
+    }
+    if (format < 0) {
+        set_error("Unsupported X11 visual (need 32-bit TrueColor, depth %d)", x11_ctx.depth);
+        XCloseDisplay(x11_ctx.display);
+        x11_ctx.display = NULL;
+        return -1;
+    }
+    x11_ctx.pixel_format = (uint32_t)format;
 
     /* Initialize display info */
     ctx->display.width = attrs.width;
@@ -88,15 +317,52 @@ int rootstream_capture_init_x11(rootstream_ctx_t *ctx) {
     ctx->current_frame.height = ctx->display.height;
     ctx->current_frame.size = frame_size;
     ctx->current_frame.capacity = frame_size;
-    ctx->current_frame.format = 0x34325258; /* DRM_FORMAT_XRGB8888 */
+    ctx->current_frame.format = x11_ctx.pixel_format;
 
-    printf("✓ X11 SHM capture initialized: %dx%d\n", ctx->display.width, ctx->display.height);
+    const char *method = "XGetImage";
+#ifdef HAVE_XSHM
+    if (shm_init()) {
+        method = "MIT-SHM";
+    }
+#endif
+    if (!x11_ctx.shadow) {
+        x11_ctx.shadow_stride = x11_ctx.width * 4;
+        x11_ctx.shadow = malloc((size_t)x11_ctx.shadow_stride * x11_ctx.height);
+        if (!x11_ctx.shadow) {
+            set_error("Cannot allocate shadow buffer");
+            free(ctx->current_frame.data);
+            ctx->current_frame.data = NULL;
+            XCloseDisplay(x11_ctx.display);
+            x11_ctx.display = NULL;
+            return -1;
+        }
+    }
+    x11_ctx.shadow_valid = false;
+
+    const char *damage = "off";
+#ifdef HAVE_XDAMAGE
+    int damage_event, damage_error, fixes_event, fixes_error;
+    if (ctx->settings.damage_capture &&
+        XDamageQueryExtension(x11_ctx.display, &damage_event, &damage_error) &&
+        XFixesQueryExtension(x11_ctx.display, &fixes_event, &fixes_error)) {
+        x11_ctx.damage = XDamageCreate(x11_ctx.display, x11_ctx.root, XDamageReportNonEmpty);
+        x11_ctx.region = XFixesCreateRegion(x11_ctx.display, NULL, 0);
+        x11_ctx.use_damage = true;
+        damage = "on";
+    }
+#endif
+
+    printf("✓ X11 capture initialized: %dx%d (%s, damage %s)\n", ctx->display.width,
+           ctx->display.height, method, damage);
 
     return 0;
 }
 
 /*
- * Capture frame using X11 XGetImage
+ * Capture frame
+ *
+ * Returns CAPTURE_UNCHANGED without touching @frame when XDamage saw no
+ * change since the previous capture and no keyframe is pending.
  */
 int rootstream_capture_frame_x11(rootstream_ctx_t *ctx, frame_buffer_t *frame) {
     if (!ctx || !frame || !x11_ctx.display) {
@@ -104,38 +370,81 @@ int rootstream_capture_frame_x11(rootstream_ctx_t *ctx, frame_buffer_t *frame) {
         return -1;
     }
 
-    /* Capture screen using XGetImage */
-    XImage *image = XGetImage(x11_ctx.display, x11_ctx.root, 0, 0, ctx->display.width,
-                              ctx->display.height, AllPlanes, ZPixmap);
-    if (!image) {
-        set_error("XGetImage failed");
-        return -1;
-    }
+    frame_rect_t dirty[FRAME_MAX_DIRTY_RECTS];
+    int ndirty = -1; /* -1 = whole screen */
 
-    /* Convert to RGBA format */
-    uint8_t *dst = frame->data;
+#ifdef HAVE_XDAMAGE
+    if (x11_ctx.use_damage) {
+        /* Damage notifications only wake us; the region is what counts */
+        while (XPending(x11_ctx.display)) {
+            XEvent event;
+            XNextEvent(x11_ctx.display, &event);
+        }
 
-    for (unsigned int y = 0; y < ctx->display.height; y++) {
-        for (unsigned int x = 0; x < ctx->display.width; x++) {
-            unsigned long pixel = XGetPixel(image, x, y);
+        XDamageSubtract(x11_ctx.display, x11_ctx.damage, None, x11_ctx.region);
+        int nrects = 0;
+        XRectangle *rects = XFixesFetchRegion(x11_ctx.display, x11_ctx.region, &nrects);
+
+        if (x11_ctx.shadow_valid && nrects <= FRAME_MAX_DIRTY_RECTS) {
+            ndirty = 0;
+            for (int i = 0; i < nrects; i++) {
+                int x0 = rects[i].x < 0 ? 0 : rects[i].x;
+                int y0 = rects[i].y < 0 ? 0 : rects[i].y;
+                int x1 = rects[i].x + rects[i].width;
+                int y1 = rects[i].y + rects[i].height;
+                if (x1 > x11_ctx.width) x1 = x11_ctx.width;
+                if (y1 > x11_ctx.height) y1 = x11_ctx.height;
+                if (x1 <= x0 || y1 <= y0) continue;
+                dirty[ndirty++] = (frame_rect_t){(uint16_t)x0, (uint16_t)y0,
+                                                 (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+            }
+        }
+        if (rects) {
+            XFree(rects);
+        }
 
-            /* Extract RGB components (assuming 24-bit or 32-bit color) */
-            dst[0] = (pixel >> 16) & 0xFF; /* R */
-            dst[1] = (pixel >> 8) & 0xFF;  /* G */
-            dst[2] = pixel & 0xFF;         /* B */
-            dst[3] = 0xFF;                 /* A */
+        /* Static screen: nothing to capture, encode or send unless the
+         * encoder owes a keyframe (new peer, loss recovery) */
+        if (ndirty == 0 && !encoder_keyframe_pending(&ctx->encoder)) {
+            return CAPTURE_UNCHANGED;
+        }
+    }
+#endif
 
-            dst += 4;
+    if (ndirty < 0) {
+        if (grab_rect(0, 0, x11_ctx.width, x11_ctx.height) < 0) {
+            return -1;
+        }
+        x11_ctx.shadow_valid = true;
+    } else {
+        for (int i = 0; i < ndirty; i++) {
+            if (grab_rect(dirty[i].x, dirty[i].y, dirty[i].width, dirty[i].height) < 0) {
+                x11_ctx.shadow_valid = false;
+                return -1;
+            }
         }
     }
 
-    XDestroyImage(image);
+    /* Hand the shadow to the caller row by row */
+    size_t row_bytes = (size_t)x11_ctx.width * 4;
+    if (x11_ctx.shadow_stride == (int)row_bytes) {
+        memcpy(frame->data, x11_ctx.shadow, row_bytes * x11_ctx.height);
+    } else {
+        for (int y = 0; y < x11_ctx.height; y++) {
+            memcpy(frame->data + (size_t)y * row_bytes,
+                   x11_ctx.shadow + (size_t)y * x11_ctx.shadow_stride, row_bytes);
+        }
+    }
 
     /* Set frame metadata */
     frame->width = ctx->display.width;
     frame->height = ctx->display.height;
     frame->pitch = ctx->display.width * 4;
-    frame->format = ctx->current_frame.format;
+    frame->format = x11_ctx.pixel_format;
+    frame->dirty_count = ndirty > 0 ? (uint32_t)ndirty : 0;
+    if (ndirty > 0) {
+        memcpy(frame->dirty, dirty, (size_t)ndirty * sizeof(dirty[0]));
+    }
 
     /* Get timestamp */
     struct timespec ts;
@@ -159,6 +468,22 @@ void rootstream_capture_cleanup_x11(rootstream_ctx_t *ctx) {
     }
 
     if (x11_ctx.display) {
+#ifdef HAVE_XDAMAGE
+        if (x11_ctx.use_damage) {
+            XDamageDestroy(x11_ctx.display, x11_ctx.damage);
+            XFixesDestroyRegion(x11_ctx.display, x11_ctx.region);
+            x11_ctx.use_damage = false;
+        }
+#endif
+#ifdef HAVE_XSHM
+        if (x11_ctx.use_shm) {
+            shm_cleanup();
+        }
+#endif
+        free(x11_ctx.shadow);
+        x11_ctx.shadow = NULL;
+        x11_ctx.shadow_valid = false;
+
         XCloseDisplay(x11_ctx.display);
         x11_ctx.display = NULL;
     }
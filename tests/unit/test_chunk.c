@@ -2,8 +2,11 @@
  * test_chunk.c — Unit tests for PHASE-76 Chunk Splitter
  *
  * Tests chunk_hdr (init/invalid), chunk_split (1-chunk, multi-chunk,
- * empty, exact-MTU, last-flag), and chunk_reassemble (single/multi-chunk
- * frame, completion detection, release, out-of-order arrival).
+ * empty, exact-MTU, last-flag), chunk_reassemble (single/multi-chunk
+ * frame, completion detection, release, out-of-order arrival), and
+ * frame_reasm (interleaved frames, duplicates, tail-first arrival,
+ * in-order hand-off, age-out/gap flagging, slot eviction, bad grids,
+ * FEC repair of lost chunks, missing-chunk listing for NACKs).
  */
 
 #include <stdio.h>
@@ -14,6 +17,8 @@
 #include "../../src/chunk/chunk_hdr.h"
 #include "../../src/chunk/chunk_split.h"
 #include "../../src/chunk/chunk_reassemble.h"
+#include "../../src/chunk/frame_reasm.h"
+#include "../../src/fec/fec_matrix.h"
 
 #define TEST_ASSERT(cond, msg) \
     do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", (msg)); return 1; } } while (0)
@@ -149,6 +154,225 @@ static int test_reassemble_multi(void) {
     return 0;
 }
 
+/* ── frame_reasm ─────────────────────────────────────────────────── */
+
+#define FR_STRIDE 100
+
+static uint8_t fr_src[1000];
+
+/* Add chunk idx of a frame of total bytes cut at FR_STRIDE */
+static int fr_add(frame_reasm_t *r, uint32_t id, uint32_t total, uint32_t idx, uint64_t now) {
+    uint32_t off = idx * FR_STRIDE;
+    uint32_t len = total - off < FR_STRIDE ? total - off : FR_STRIDE;
+    return frame_reasm_add(r, id, total, off, fr_src + off, len, id * 1000u, now);
+}
+
+static int test_frame_reasm_interleaved(void) {
+    printf("\n=== test_frame_reasm_interleaved ===\n");
+
+    for (int i = 0; i < (int)sizeof(fr_src); i++) fr_src[i] = (uint8_t)(i * 7);
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    TEST_ASSERT(r != NULL, "created");
+
+    /* Frame 2 starts before frame 1 finishes; neither may be lost */
+    TEST_ASSERT(fr_add(r, 1, 250, 0, 0) == FRAME_REASM_ACCEPTED, "f1 c0");
+    TEST_ASSERT(fr_add(r, 2, 150, 1, 0) == FRAME_REASM_ACCEPTED, "f2 tail first");
+    TEST_ASSERT(fr_add(r, 1, 250, 0, 0) == FRAME_REASM_DUPLICATE, "f1 c0 duplicate");
+    TEST_ASSERT(fr_add(r, 2, 150, 1, 0) == FRAME_REASM_DUPLICATE, "f2 tail duplicate");
+    TEST_ASSERT(fr_add(r, 1, 250, 2, 0) == FRAME_REASM_ACCEPTED, "f1 c2");
+
+    frame_reasm_frame_t f;
+    TEST_ASSERT(frame_reasm_pop(r, 1, &f) == 0, "nothing complete yet");
+
+    TEST_ASSERT(fr_add(r, 2, 150, 0, 1) == FRAME_REASM_COMPLETE, "f2 complete");
+    TEST_ASSERT(frame_reasm_pop(r, 1, &f) == 0, "f2 waits behind active f1");
+
+    TEST_ASSERT(fr_add(r, 1, 250, 1, 2) == FRAME_REASM_COMPLETE, "f1 complete");
+    TEST_ASSERT(frame_reasm_pop(r, 2, &f) == 1 && f.frame_id == 1, "f1 first");
+    TEST_ASSERT(f.size == 250 && memcmp(f.data, fr_src, 250) == 0, "f1 payload intact");
+    TEST_ASSERT(!f.after_gap, "f1 no gap");
+    TEST_ASSERT(frame_reasm_pop(r, 2, &f) == 1 && f.frame_id == 2, "f2 second");
+    TEST_ASSERT(f.size == 150 && memcmp(f.data, fr_src, 150) == 0, "f2 payload intact");
+    TEST_ASSERT(!f.after_gap, "f2 no gap");
+    TEST_ASSERT(fr_add(r, 1, 250, 1, 3) == FRAME_REASM_LATE, "chunk of delivered frame late");
+
+    frame_reasm_stats_t st;
+    frame_reasm_get_stats(r, &st);
+    TEST_ASSERT(st.frames_complete == 2 && st.frames_dropped == 0, "2 complete, 0 dropped");
+    TEST_ASSERT(st.duplicates == 2, "2 duplicates");
+
+    frame_reasm_destroy(r);
+    TEST_PASS("frame_reasm interleaved frames/duplicates/tail-first/order");
+    return 0;
+}
+
+static int test_frame_reasm_loss(void) {
+    printf("\n=== test_frame_reasm_loss ===\n");
+
+    frame_reasm_t *r = frame_reasm_create(4, 100, 5);
+    frame_reasm_frame_t f;
+
+    /* Frame 10 loses chunk 1; frame 11 completes */
+    fr_add(r, 10, 300, 0, 0);
+    fr_add(r, 10, 300, 2, 0);
+    fr_add(r, 11, 100, 0, 1);
+    TEST_ASSERT(frame_reasm_pop(r, 3, &f) == 0, "waits within reorder window");
+    TEST_ASSERT(frame_reasm_pop(r, 6, &f) == 1 && f.frame_id == 11, "stalled f10 dropped");
+    TEST_ASSERT(f.after_gap, "f11 flagged after gap");
+    TEST_ASSERT(fr_add(r, 10, 300, 1, 7) == FRAME_REASM_LATE, "f10 straggler late");
+
+    /* Missing frame_id (13 never sent) is a gap too */
+    fr_add(r, 12, 100, 0, 10);
+    TEST_ASSERT(frame_reasm_pop(r, 10, &f) == 1 && !f.after_gap, "f12 contiguous");
+    fr_add(r, 14, 100, 0, 10);
+    TEST_ASSERT(frame_reasm_pop(r, 10, &f) == 1 && f.after_gap, "f14 after missing f13");
+
+    /* Incomplete frame alone ages out after max_age */
+    fr_add(r, 15, 300, 0, 20);
+    TEST_ASSERT(frame_reasm_pop(r, 119, &f) == 0, "not yet aged");
+    TEST_ASSERT(frame_reasm_pop(r, 120, &f) == 0, "aged out, nothing to pop");
+
+    /* Full table: the oldest incomplete frame is evicted */
+    for (uint32_t id = 16; id < 20; id++) fr_add(r, id, 300, 0, 130);
+    TEST_ASSERT(fr_add(r, 20, 100, 0, 130) == FRAME_REASM_COMPLETE, "f20 evicts f16");
+
+    frame_reasm_stats_t st;
+    frame_reasm_get_stats(r, &st);
+    TEST_ASSERT(st.frames_dropped == 3, "f10, f15, f16 dropped");
+    TEST_ASSERT(st.active == 4, "4 frames active");
+
+    frame_reasm_destroy(r);
+    TEST_PASS("frame_reasm reorder window/age-out/gaps/eviction");
+    return 0;
+}
+
+static int test_frame_reasm_invalid(void) {
+    printf("\n=== test_frame_reasm_invalid ===\n");
+
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    TEST_ASSERT(frame_reasm_add(r, 1, 0, 0, fr_src, 10, 0, 0) == FRAME_REASM_INVALID,
+                "zero total");
+    TEST_ASSERT(frame_reasm_add(r, 1, 100, 95, fr_src, 10, 0, 0) == FRAME_REASM_INVALID,
+                "chunk past end");
+
+    /* Non-final chunks must share the stride and sit on its grid */
+    TEST_ASSERT(frame_reasm_add(r, 1, 300, 0, fr_src, 100, 0, 0) == FRAME_REASM_ACCEPTED,
+                "grid = 100");
+    TEST_ASSERT(frame_reasm_add(r, 1, 300, 100, fr_src, 50, 0, 0) == FRAME_REASM_INVALID,
+                "short middle chunk");
+    TEST_ASSERT(frame_reasm_add(r, 1, 300, 150, fr_src, 100, 0, 0) == FRAME_REASM_INVALID,
+                "off-grid chunk");
+    TEST_ASSERT(frame_reasm_add(r, 1, 400, 100, fr_src, 100, 0, 0) == FRAME_REASM_INVALID,
+                "total size mismatch");
+
+    /* Sender restart: frame ids far behind the head resynchronise */
+    frame_reasm_frame_t f;
+    frame_reasm_add(r, 5000, 10, 0, fr_src, 10, 0, 0);
+    TEST_ASSERT(frame_reasm_pop(r, 200, &f) == 1 && f.frame_id == 5000, "f5000 delivered");
+    TEST_ASSERT(frame_reasm_add(r, 1, 10, 0, fr_src, 10, 0, 0) == FRAME_REASM_COMPLETE,
+                "restart resync");
+
+    frame_reasm_destroy(r);
+    TEST_PASS("frame_reasm malformed chunks/resync");
+    return 0;
+}
+
+/* Build repair ri over the 10 chunks of a 950-byte frame (short tail padded) */
+static void fr_repair(int ri, uint8_t *out) {
+    static uint8_t tail[FR_STRIDE];
+    const uint8_t *srcs[10];
+    for (int j = 0; j < 9; j++) srcs[j] = fr_src + j * FR_STRIDE;
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, fr_src + 900, 50);
+    srcs[9] = tail;
+    fec_build_repair(srcs, 10, ri, out, FR_STRIDE);
+}
+
+static int test_frame_reasm_fec(void) {
+    printf("\n=== test_frame_reasm_fec ===\n");
+
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    frame_reasm_frame_t f;
+    uint8_t rep[2][FR_STRIDE];
+    fr_repair(0, rep[0]);
+    fr_repair(1, rep[1]);
+
+    /* Lose a middle chunk and the short tail; two repairs rebuild both */
+    for (uint32_t i = 0; i < 9; i++)
+        if (i != 3) fr_add(r, 1, 950, i, 0);
+    TEST_ASSERT(frame_reasm_add_repair(r, 1, 950, 0, 10, 0, rep[0], FR_STRIDE, 1000, 0) ==
+                    FRAME_REASM_ACCEPTED, "one repair, two holes");
+    TEST_ASSERT(frame_reasm_add_repair(r, 1, 950, 0, 10, 0, rep[0], FR_STRIDE, 1000, 0) ==
+                    FRAME_REASM_DUPLICATE, "duplicate repair");
+    TEST_ASSERT(frame_reasm_add_repair(r, 1, 950, 0, 10, 1, rep[1], FR_STRIDE, 1000, 0) ==
+                    FRAME_REASM_COMPLETE, "second repair completes");
+    TEST_ASSERT(frame_reasm_pop(r, 1, &f) == 1 && f.size == 950 &&
+                    memcmp(f.data, fr_src, 950) == 0, "rebuilt frame intact");
+
+    /* Repair first: it fixes the grid, the last source chunk triggers decode */
+    TEST_ASSERT(frame_reasm_add_repair(r, 2, 950, 0, 10, 1, rep[1], FR_STRIDE, 2000, 1) ==
+                    FRAME_REASM_ACCEPTED, "repair before sources");
+    for (uint32_t i = 1; i < 10; i++) fr_add(r, 2, 950, i, 1);
+    TEST_ASSERT(frame_reasm_pop(r, 2, &f) == 1 && f.frame_id == 2 && !f.after_gap &&
+                    memcmp(f.data, fr_src, 950) == 0, "chunk 0 rebuilt");
+
+    /* Repairs that do not fit the frame's grid are rejected */
+    fr_add(r, 3, 950, 0, 2);
+    TEST_ASSERT(frame_reasm_add_repair(r, 3, 950, 0, 10, 0, rep[0], 50, 3000, 2) ==
+                    FRAME_REASM_INVALID, "repair length != stride");
+    TEST_ASSERT(frame_reasm_add_repair(r, 3, 950, 100, 10, 0, rep[0], FR_STRIDE, 3000, 2) ==
+                    FRAME_REASM_INVALID, "group past last chunk");
+
+    frame_reasm_stats_t st;
+    frame_reasm_get_stats(r, &st);
+    TEST_ASSERT(st.recovered == 3 && st.repairs == 3, "stats: 3 rebuilt from 3 repairs");
+
+    frame_reasm_destroy(r);
+    TEST_PASS("frame_reasm FEC repair of lost chunks");
+    return 0;
+}
+
+static int test_frame_reasm_missing(void) {
+    printf("\n=== test_frame_reasm_missing ===\n");
+
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    frame_reasm_frame_t f;
+    uint32_t idx[16];
+
+    TEST_ASSERT(frame_reasm_missing(r, 1, idx, 16) == -1, "unknown frame");
+    fr_add(r, 1, 950, 9, 0);
+    TEST_ASSERT(frame_reasm_missing(r, 1, idx, 16) == -1, "tail only: grid unknown");
+
+    /* Holes below the highest chunk are missing, chunks beyond it not yet */
+    fr_add(r, 1, 950, 0, 0);
+    fr_add(r, 1, 950, 3, 0);
+    TEST_ASSERT(frame_reasm_missing(r, 1, idx, 16) == 7 && idx[0] == 1 && idx[1] == 2 &&
+                    idx[2] == 4 && idx[6] == 8, "tail in: 1, 2, 4..8 missing");
+    TEST_ASSERT(frame_reasm_missing(r, 1, idx, 2) == 2 && idx[1] == 2, "bounded by max");
+
+    fr_add(r, 2, 950, 0, 0);
+    fr_add(r, 2, 950, 2, 0);
+    TEST_ASSERT(frame_reasm_missing(r, 2, idx, 16) == 1 && idx[0] == 1, "f2: trailing unknown");
+
+    /* A newer frame closes f2: its lost tail counts too */
+    fr_add(r, 3, 100, 0, 0);
+    TEST_ASSERT(frame_reasm_missing(r, 2, idx, 16) == 8 && idx[1] == 3, "f2 closed by f3");
+    TEST_ASSERT(frame_reasm_missing(r, 3, idx, 16) == 0, "complete frame");
+
+    /* Slower reorder window holds the stalled frames for retransmission */
+    frame_reasm_set_reorder(r, 50);
+    TEST_ASSERT(frame_reasm_pop(r, 20, &f) == 0, "f1 held past default window");
+    for (uint32_t i = 1; i < 9; i++)
+        if (i != 3) fr_add(r, 1, 950, i, 20);
+    TEST_ASSERT(frame_reasm_pop(r, 20, &f) == 1 && f.frame_id == 1 && !f.after_gap,
+                "retransmitted chunks complete f1");
+    TEST_ASSERT(frame_reasm_missing(r, 1, idx, 16) == -1, "delivered frame unknown");
+
+    frame_reasm_destroy(r);
+    TEST_PASS("frame_reasm missing chunks/reorder window");
+    return 0;
+}
+
 int main(void) {
     int failures = 0;
 
@@ -157,6 +381,11 @@ int main(void) {
     failures += test_split_multi();
     failures += test_reassemble_single();
     failures += test_reassemble_multi();
+    failures += test_frame_reasm_interleaved();
+    failures += test_frame_reasm_loss();
+    failures += test_frame_reasm_invalid();
+    failures += test_frame_reasm_fec();
+    failures += test_frame_reasm_missing();
 
     printf("\n");
     if (failures == 0) printf("ALL CHUNK TESTS PASSED\n");
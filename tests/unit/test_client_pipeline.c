@@ -0,0 +1,352 @@
+/*
+ * test_client_pipeline.c — Unit tests for the threaded client pipeline
+ *
+ * Runs client_pipeline against a scripted network (rootstream_net_recv
+ * hands out numbered frames) and a fake decoder, and checks frame order
+ * and content, reference-counted ownership (frames retained across
+ * threads, held past destroy), shedding with keyframe requests when the
+ * decoder falls behind, and that a stalled presenter never stalls
+ * reception.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../include/rootstream.h"
+#include "../../src/pipeline/client_pipeline.h"
+
+#define TEST_ASSERT(cond, msg) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", (msg)); return 1; } } while (0)
+#define TEST_PASS(msg) printf("PASS: %s\n", (msg))
+
+#define W 32
+#define H 16
+#define NV12_SIZE (W * H * 3 / 2)
+
+/* ── Scripted network and decoder ────────────────────────────────── */
+
+static atomic_int frames_to_send;  /* Frames the fake network still hands out */
+static atomic_int frames_sent;
+static atomic_int recv_interval_us; /* Delay per handed-out frame */
+static atomic_int decode_delay_us;
+static atomic_int keyframe_requests;
+static uint8_t wire[64];
+
+int rootstream_net_recv(rootstream_ctx_t *ctx, int timeout_ms) {
+    if (atomic_load(&frames_to_send) <= 0) {
+        usleep((useconds_t)timeout_ms * 1000);
+        return 0;
+    }
+    int interval = atomic_load(&recv_interval_us);
+    if (interval > 0)
+        usleep((useconds_t)interval);
+
+    /* Borrowed buffer, as the reassembler hands it out */
+    uint32_t seq = (uint32_t)atomic_fetch_add(&frames_sent, 1);
+    memset(wire, 0xA5, sizeof(wire));
+    memcpy(wire, &seq, sizeof(seq));
+    ctx->current_frame.data = wire;
+    ctx->current_frame.size = sizeof(wire);
+    atomic_fetch_sub(&frames_to_send, 1);
+    return 0;
+}
+
+void rootstream_net_tick(rootstream_ctx_t *ctx) { (void)ctx; }
+
+int rootstream_request_keyframe(rootstream_ctx_t *ctx, peer_t *peer) {
+    (void)ctx; (void)peer;
+    atomic_fetch_add(&keyframe_requests, 1);
+    return 0;
+}
+
+int rootstream_decode_frame(rootstream_ctx_t *ctx, const uint8_t *in, size_t in_size,
+                            frame_buffer_t *out) {
+    (void)ctx;
+    if (in_size != sizeof(wire)) return -1;
+    int delay = atomic_load(&decode_delay_us);
+    if (delay > 0) usleep((useconds_t)delay);
+
+    uint32_t seq;
+    memcpy(&seq, in, sizeof(seq));
+    if (!out->data || out->capacity < NV12_SIZE) {
+        uint8_t *buf = realloc(out->data, NV12_SIZE);
+        if (!buf) return -1;
+        out->data = buf;
+        out->capacity = NV12_SIZE;
+    }
+    memset(out->data, (int)(seq & 0xFF), NV12_SIZE);
+    out->size = NV12_SIZE;
+    out->width = W;
+    out->height = H;
+    out->format = FRAME_FORMAT_NV12;
+    out->timestamp = seq;
+    out->is_keyframe = seq == 0;
+    return 0;
+}
+
+uint64_t get_timestamp_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+uint64_t get_timestamp_ms(void) { return get_timestamp_us() / 1000; }
+
+void rs_sleep_ms(uint32_t ms) { usleep(ms * 1000); }
+
+static rootstream_ctx_t *make_ctx(void) {
+    rootstream_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) return NULL;
+    ctx->running = true;
+    ctx->num_peers = 1;
+    ctx->peers[0].state = PEER_CONNECTED;
+    return ctx;
+}
+
+static void script(int frames, int interval_us, int decode_us) {
+    atomic_store(&frames_sent, 0);
+    atomic_store(&recv_interval_us, interval_us);
+    atomic_store(&decode_delay_us, decode_us);
+    atomic_store(&keyframe_requests, 0);
+    atomic_store(&frames_to_send, frames);
+}
+
+/* Frame content matches its sequence number (pts) */
+static int frame_intact(const rs_video_frame_t *vf) {
+    if (vf->width != W || vf->height != H || vf->pixfmt != RS_PIXFMT_NV12) return 0;
+    if (vf->plane1 != vf->plane0 + W * H || vf->stride0 != W) return 0;
+    uint8_t v = (uint8_t)(vf->pts_us & 0xFF);
+    for (int i = 0; i < NV12_SIZE; i++)
+        if (vf->plane0[i] != v) return 0;
+    return 1;
+}
+
+/* ── Tests ───────────────────────────────────────────────────────── */
+
+static int test_frames_in_order(void) {
+    printf("\n=== test_frames_in_order ===\n");
+
+    rootstream_ctx_t *ctx = make_ctx();
+    TEST_ASSERT(ctx != NULL, "ctx");
+    /* Paced like a 500 fps stream so nothing is shed */
+    script(40, 2000, 0);
+
+    client_pipeline_t *p = client_pipeline_start(ctx, 0, NULL, NULL);
+    TEST_ASSERT(p != NULL, "started");
+
+    int got = 0;
+    int64_t last = -1;
+    while (got < 40) {
+        client_frame_t *f = client_pipeline_next(p, 500000);
+        TEST_ASSERT(f != NULL, "frame within 500 ms");
+        const rs_video_frame_t *vf = client_frame_view(f);
+        TEST_ASSERT(vf->ref == f, "view refers to its frame");
+        TEST_ASSERT(frame_intact(vf), "frame content intact");
+        TEST_ASSERT((int64_t)vf->pts_us > last, "frames in order");
+        last = (int64_t)vf->pts_us;
+        client_frame_release(f);
+        got++;
+    }
+
+    client_pipeline_stats_t st;
+    TEST_ASSERT(client_pipeline_get_stats(p, &st) == 0, "stats");
+    TEST_ASSERT(st.received == 40 && st.decoded == 40 && st.presented == 40, "all counted");
+    TEST_ASSERT(st.receive_dropped == 0 && st.present_dropped == 0, "nothing shed");
+    TEST_ASSERT(st.held == 0, "nothing held");
+    TEST_ASSERT(st.decode_queue_capacity == CLIENT_PIPELINE_DEFAULT_DEPTH &&
+                    st.present_queue_capacity == CLIENT_PIPELINE_DEFAULT_DEPTH,
+                "capacities reported");
+    TEST_ASSERT(atomic_load(&keyframe_requests) == 0, "no keyframe requests");
+
+    client_pipeline_destroy(p);
+    free(ctx);
+    TEST_PASS("frames arrive in order, intact, with no drops at a sustainable rate");
+    return 0;
+}
+
+typedef struct {
+    const rs_video_frame_t *frame;
+    int ok;
+} holder_t;
+
+static void *check_on_other_thread(void *arg) {
+    holder_t *h = arg;
+    usleep(20000); /* The presenter has long moved on */
+    h->ok = frame_intact(h->frame);
+    client_frame_release((client_frame_t *)h->frame->ref);
+    return NULL;
+}
+
+static int test_refcounted_ownership(void) {
+    printf("\n=== test_refcounted_ownership ===\n");
+
+    rootstream_ctx_t *ctx = make_ctx();
+    TEST_ASSERT(ctx != NULL, "ctx");
+    script(1000, 1000, 0);
+
+    client_pipeline_t *p = client_pipeline_start(ctx, 2, NULL, NULL);
+    TEST_ASSERT(p != NULL, "started");
+
+    /* Hand one frame to another thread, keep presenting meanwhile */
+    client_frame_t *f = client_pipeline_next(p, 500000);
+    TEST_ASSERT(f != NULL, "first frame");
+    holder_t h = {client_frame_view(client_frame_retain(f)), 0};
+    pthread_t t;
+    TEST_ASSERT(pthread_create(&t, NULL, check_on_other_thread, &h) == 0, "thread");
+    client_frame_release(f);
+    for (int i = 0; i < 10; i++) {
+        client_frame_t *g = client_pipeline_next(p, 500000);
+        TEST_ASSERT(g != NULL, "later frame");
+        client_frame_release(g);
+    }
+    pthread_join(t, NULL);
+    TEST_ASSERT(h.ok, "retained frame untouched while the pipeline ran on");
+
+    /* Hold more frames than the pipeline lends out: it keeps running and
+     * discards decoded output instead of reusing held buffers */
+    client_frame_t *held[CLIENT_PIPELINE_MAX_HELD];
+    for (int i = 0; i < CLIENT_PIPELINE_MAX_HELD; i++) {
+        held[i] = client_pipeline_next(p, 500000);
+        TEST_ASSERT(held[i] != NULL, "frame to hold");
+    }
+    client_pipeline_stats_t st;
+    client_pipeline_get_stats(p, &st);
+    TEST_ASSERT(st.held == CLIENT_PIPELINE_MAX_HELD, "held counted");
+    uint64_t decoded_before = st.decoded;
+    usleep(50000);
+    client_pipeline_get_stats(p, &st);
+    TEST_ASSERT(st.decoded > decoded_before + 10, "decoding continues while frames are held");
+    TEST_ASSERT(st.present_dropped > 0, "output discarded without free buffers");
+    for (int i = 0; i < CLIENT_PIPELINE_MAX_HELD; i++)
+        TEST_ASSERT(frame_intact(client_frame_view(held[i])), "held frame intact");
+
+    /* A frame held past destroy stays valid; its release frees the rest */
+    for (int i = 1; i < CLIENT_PIPELINE_MAX_HELD; i++)
+        client_frame_release(held[i]);
+    client_pipeline_destroy(p);
+    TEST_ASSERT(frame_intact(client_frame_view(held[0])), "frame valid after destroy");
+    client_frame_release(held[0]);
+
+    free(ctx);
+    TEST_PASS("frames retained across threads and past destroy; held frames never reused");
+    return 0;
+}
+
+static int test_slow_decoder_sheds(void) {
+    printf("\n=== test_slow_decoder_sheds ===\n");
+
+    rootstream_ctx_t *ctx = make_ctx();
+    TEST_ASSERT(ctx != NULL, "ctx");
+    /* Frames every 0.5 ms, 5 ms to decode each */
+    script(200, 500, 5000);
+
+    client_pipeline_t *p = client_pipeline_start(ctx, 2, NULL, NULL);
+    TEST_ASSERT(p != NULL, "started");
+
+    uint64_t start = get_timestamp_ms();
+    while (atomic_load(&frames_to_send) > 0 && get_timestamp_ms() - start < 2000) {
+        client_frame_t *f = client_pipeline_next(p, 10000);
+        if (f) client_frame_release(f);
+    }
+    TEST_ASSERT(atomic_load(&frames_to_send) == 0, "network never waited for the decoder");
+
+    client_pipeline_stats_t st;
+    client_pipeline_get_stats(p, &st);
+    TEST_ASSERT(st.received == 200, "all frames received");
+    TEST_ASSERT(st.receive_dropped > 0, "compressed frames shed");
+    TEST_ASSERT(st.decoded + st.receive_dropped <= st.received, "decoded + shed ≤ received");
+    TEST_ASSERT(atomic_load(&keyframe_requests) > 0, "keyframe requested after shedding");
+    TEST_ASSERT(atomic_load(&keyframe_requests) <= 10, "keyframe requests rate limited");
+    TEST_ASSERT(st.decode_us >= 4000, "decode time measured");
+
+    client_pipeline_destroy(p);
+    free(ctx);
+    TEST_PASS("slow decoder: reception keeps pace, old frames shed, keyframe requested");
+    return 0;
+}
+
+static int test_stalled_presenter(void) {
+    printf("\n=== test_stalled_presenter ===\n");
+
+    rootstream_ctx_t *ctx = make_ctx();
+    TEST_ASSERT(ctx != NULL, "ctx");
+    script(100, 200, 0);
+
+    client_pipeline_t *p = client_pipeline_start(ctx, 2, NULL, NULL);
+    TEST_ASSERT(p != NULL, "started");
+
+    /* Nobody presents for a while */
+    uint64_t start = get_timestamp_ms();
+    while (atomic_load(&frames_to_send) > 0 && get_timestamp_ms() - start < 2000)
+        usleep(5000);
+    usleep(20000);
+    TEST_ASSERT(atomic_load(&frames_to_send) == 0, "reception unaffected by the presenter");
+
+    client_pipeline_stats_t st;
+    client_pipeline_get_stats(p, &st);
+    TEST_ASSERT(st.decoded == 100 && st.receive_dropped == 0, "every frame decoded");
+    TEST_ASSERT(st.present_queue_depth == 2, "presentation queue full");
+    TEST_ASSERT(st.present_dropped == 98, "stale decoded frames shed");
+    TEST_ASSERT(atomic_load(&keyframe_requests) == 0, "no keyframe needed");
+
+    /* The newest frames are the ones left */
+    client_frame_t *f = client_pipeline_next(p, 0);
+    TEST_ASSERT(f && client_frame_view(f)->pts_us == 98, "second newest");
+    client_frame_release(f);
+    f = client_pipeline_next(p, 0);
+    TEST_ASSERT(f && client_frame_view(f)->pts_us == 99, "newest");
+    client_frame_release(f);
+
+    client_pipeline_destroy(p);
+    free(ctx);
+    TEST_PASS("stalled presenter: newest frames kept, reception and decode unaffected");
+    return 0;
+}
+
+static int test_map_frame(void) {
+    printf("\n=== test_map_frame ===\n");
+
+    uint8_t px[W * H * 4];
+    frame_buffer_t fb = {0};
+    fb.data = px;
+    fb.width = W;
+    fb.height = H;
+    fb.format = FRAME_FORMAT_NV12;
+    fb.timestamp = 1234;
+
+    rs_video_frame_t vf;
+    client_pipeline_map_frame(&fb, &vf);
+    TEST_ASSERT(vf.pixfmt == RS_PIXFMT_NV12 && vf.plane1 == px + W * H, "NV12 planes");
+    TEST_ASSERT(vf.stride0 == W && vf.stride1 == W && !vf.plane2, "NV12 strides");
+    TEST_ASSERT(vf.pts_us == 1234 && vf.ref == NULL, "pts, no ref");
+
+    fb.format = 0;
+    client_pipeline_map_frame(&fb, &vf);
+    TEST_ASSERT(vf.pixfmt == RS_PIXFMT_RGBA && vf.stride0 == W * 4 && !vf.plane1, "RGBA");
+
+    TEST_PASS("decoder output mapped to rs_video_frame_t");
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_frames_in_order();
+    failures += test_refcounted_ownership();
+    failures += test_slow_decoder_sheds();
+    failures += test_stalled_presenter();
+    failures += test_map_frame();
+
+    printf("\n");
+    if (failures == 0)
+        printf("ALL CLIENT PIPELINE TESTS PASSED\n");
+    else
+        printf("%d CLIENT PIPELINE TEST(S) FAILED\n", failures);
+    return failures ? 1 : 0;
+}
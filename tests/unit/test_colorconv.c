@@ -0,0 +1,310 @@
+/*
+ * test_colorconv.c — Unit tests for the RGBA/BGRA → YUV 4:2:0 converter
+ *
+ * Tests reference colours for BT.601/BT.709 in limited and full range,
+ * 2×2 chroma averaging, BGRA input, bit-exact agreement of the scalar,
+ * SSE2 and AVX2 kernels on odd sizes and padded strides, threaded
+ * conversion of a large frame, and geometry validation.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../../src/colorconv/colorconv.h"
+
+#define TEST_ASSERT(cond, msg) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", (msg)); return 1; } } while (0)
+#define TEST_PASS(msg)  printf("PASS: %s\n", (msg))
+
+#define PAD 24 /* Extra bytes per row to catch stride bugs and overruns */
+
+static uint64_t rng_state = 0x853C49E6748FEA9BULL;
+static uint8_t rnd8(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint8_t)(rng_state >> 24);
+}
+
+/* Solid w×h frame of one colour */
+static uint8_t *solid(int w, int h, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t *p = malloc((size_t)w * h * 4);
+    for (int i = 0; i < w * h; i++) {
+        p[4 * i] = r;
+        p[4 * i + 1] = g;
+        p[4 * i + 2] = b;
+        p[4 * i + 3] = 255;
+    }
+    return p;
+}
+
+/* Convert a w×h RGBA frame into a packed buffer of @fmt */
+static uint8_t *convert(colorconv_t *cc, uint8_t *rgba, int w, int h, colorconv_format_t fmt) {
+    colorconv_image_t src, dst;
+    uint8_t *out = malloc(colorconv_image_size(fmt, w, h));
+    colorconv_image_init(&src, COLORCONV_RGBA, w, h, rgba);
+    colorconv_image_init(&dst, fmt, w, h, out);
+    if (colorconv_convert(cc, &src, &dst) != 0) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+static int y_u_v(colorconv_matrix_t m, colorconv_range_t rg, uint8_t r, uint8_t g, uint8_t b,
+                 int *y, int *u, int *v) {
+    colorconv_t *cc = colorconv_create(m, rg, 1);
+    uint8_t *rgba = solid(2, 2, r, g, b);
+    uint8_t *nv12 = convert(cc, rgba, 2, 2, COLORCONV_NV12);
+    if (!nv12) return -1;
+    *y = nv12[0];
+    *u = nv12[4];
+    *v = nv12[5];
+    free(nv12);
+    free(rgba);
+    colorconv_destroy(cc);
+    return 0;
+}
+
+static int test_reference_colours(void) {
+    printf("\n=== test_reference_colours ===\n");
+    int y, u, v;
+
+    y_u_v(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 255, 255, 255, &y, &u, &v);
+    TEST_ASSERT(y == 235 && u == 128 && v == 128, "709 limited white");
+    y_u_v(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 0, 0, 0, &y, &u, &v);
+    TEST_ASSERT(y == 16 && u == 128 && v == 128, "709 limited black");
+    y_u_v(COLORCONV_BT709, COLORCONV_RANGE_FULL, 255, 255, 255, &y, &u, &v);
+    TEST_ASSERT(y == 255 && u == 128 && v == 128, "709 full white");
+    y_u_v(COLORCONV_BT601, COLORCONV_RANGE_FULL, 128, 128, 128, &y, &u, &v);
+    TEST_ASSERT(y == 128 && u == 128 && v == 128, "601 full grey");
+
+    /* Red: 601 Y = 16 + 219·0.299, Cb = 128 − 112·0.299/0.886 */
+    y_u_v(COLORCONV_BT601, COLORCONV_RANGE_LIMITED, 255, 0, 0, &y, &u, &v);
+    TEST_ASSERT(y == 81 && u == 90 && v == 240, "601 limited red");
+    y_u_v(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 255, 0, 0, &y, &u, &v);
+    TEST_ASSERT(y == 63 && u == 102 && v == 240, "709 limited red");
+    /* Full-range blue Cb is 255.5 before clamping */
+    y_u_v(COLORCONV_BT709, COLORCONV_RANGE_FULL, 0, 0, 255, &y, &u, &v);
+    TEST_ASSERT(y == 18 && u == 255 && v < 128, "709 full blue clamps Cb");
+
+    /* P010 stores 10-bit codes in the high bits */
+    colorconv_t *cc = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 1);
+    uint8_t *rgba = solid(2, 2, 255, 255, 255);
+    uint8_t *p010 = convert(cc, rgba, 2, 2, COLORCONV_P010);
+    TEST_ASSERT(p010, "P010 convert");
+    uint16_t y10 = (uint16_t)(p010[0] | p010[1] << 8);
+    uint16_t u10 = (uint16_t)(p010[8] | p010[9] << 8);
+    TEST_ASSERT(y10 == 940 << 6 && u10 == 512 << 6, "P010 limited white = 940/512");
+    free(p010);
+    free(rgba);
+    colorconv_destroy(cc);
+
+    TEST_PASS("reference colours");
+    return 0;
+}
+
+static int test_chroma_average(void) {
+    printf("\n=== test_chroma_average ===\n");
+    colorconv_t *cc = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_FULL, 1);
+
+    /* Left column red, right column blue: chroma is that of the mean
+     * colour, not of the top-left pixel */
+    uint8_t *rgba = solid(2, 2, 255, 0, 0);
+    for (int row = 0; row < 2; row++) {
+        rgba[row * 8 + 4] = 0;
+        rgba[row * 8 + 6] = 255;
+    }
+    uint8_t *mix = convert(cc, rgba, 2, 2, COLORCONV_NV12);
+    uint8_t *mean = solid(2, 2, 128, 0, 128);
+    uint8_t *ref = convert(cc, mean, 2, 2, COLORCONV_NV12);
+    TEST_ASSERT(mix && ref, "convert");
+    TEST_ASSERT(abs(mix[4] - ref[4]) <= 1 && abs(mix[5] - ref[5]) <= 1, "UV = UV(mean colour)");
+    TEST_ASSERT(mix[0] != mix[1], "luma stays per pixel");
+
+    /* Odd 3×3 frame: the last block only averages the pixels it has */
+    uint8_t *odd = solid(3, 3, 0, 255, 0);
+    uint8_t *i420 = convert(cc, odd, 3, 3, COLORCONV_I420);
+    TEST_ASSERT(i420, "convert odd");
+    /* 9 Y + 4 U + 4 V; all blocks green */
+    TEST_ASSERT(i420[9] == i420[12] && i420[13] == i420[16], "edge blocks equal interior");
+
+    free(i420);
+    free(odd);
+    free(ref);
+    free(mean);
+    free(mix);
+    free(rgba);
+    colorconv_destroy(cc);
+    TEST_PASS("2x2 chroma averaging");
+    return 0;
+}
+
+static int test_bgra(void) {
+    printf("\n=== test_bgra ===\n");
+    const int w = 70, h = 6;
+    uint8_t *rgba = malloc((size_t)w * h * 4), *bgra = malloc((size_t)w * h * 4);
+    for (int i = 0; i < w * h * 4; i++) rgba[i] = rnd8();
+    for (int i = 0; i < w * h; i++) {
+        bgra[4 * i] = rgba[4 * i + 2];
+        bgra[4 * i + 1] = rgba[4 * i + 1];
+        bgra[4 * i + 2] = rgba[4 * i];
+        bgra[4 * i + 3] = rgba[4 * i + 3];
+    }
+
+    colorconv_t *cc = colorconv_create(COLORCONV_BT601, COLORCONV_RANGE_LIMITED, 1);
+    size_t n = colorconv_image_size(COLORCONV_NV12, w, h);
+    uint8_t *a = malloc(n), *b = malloc(n);
+    colorconv_image_t src, dst;
+    colorconv_image_init(&dst, COLORCONV_NV12, w, h, a);
+    colorconv_image_init(&src, COLORCONV_RGBA, w, h, rgba);
+    TEST_ASSERT(colorconv_convert(cc, &src, &dst) == 0, "RGBA convert");
+    colorconv_image_init(&dst, COLORCONV_NV12, w, h, b);
+    colorconv_image_init(&src, COLORCONV_BGRA, w, h, bgra);
+    TEST_ASSERT(colorconv_convert(cc, &src, &dst) == 0, "BGRA convert");
+    TEST_ASSERT(memcmp(a, b, n) == 0, "BGRA == RGBA output");
+
+    free(a);
+    free(b);
+    free(rgba);
+    free(bgra);
+    colorconv_destroy(cc);
+    TEST_PASS("BGRA input");
+    return 0;
+}
+
+/* Destination with PAD bytes of 0xA5 after every row */
+static uint8_t *padded_dst(colorconv_image_t *img, colorconv_format_t fmt, int w, int h,
+                           size_t *size) {
+    int planes = fmt == COLORCONV_I420 ? 3 : 2;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    int bps = fmt == COLORCONV_P010 ? 2 : 1;
+    int tight[3] = {w * bps, fmt == COLORCONV_I420 ? cw : 2 * cw * bps, cw};
+    size_t off[3], total = 0;
+    for (int p = 0; p < planes; p++) {
+        off[p] = total;
+        total += (size_t)(tight[p] + PAD) * (p == 0 ? h : ch);
+    }
+    uint8_t *buf = malloc(total);
+    memset(buf, 0xA5, total);
+    memset(img, 0, sizeof(*img));
+    img->format = fmt;
+    img->width = w;
+    img->height = h;
+    for (int p = 0; p < planes; p++) {
+        img->plane[p] = buf + off[p];
+        img->stride[p] = tight[p] + PAD;
+    }
+    *size = total;
+    return buf;
+}
+
+static int test_kernels_match(void) {
+    printf("\n=== test_kernels_match ===\n");
+    static const int sizes[][2] = {{1, 1}, {17, 3}, {67, 37}, {96, 8}, {333, 21}};
+    static const colorconv_format_t fmts[] = {COLORCONV_NV12, COLORCONV_I420, COLORCONV_P010};
+    static const colorconv_kernel_t kernels[] = {COLORCONV_KERNEL_SSE2, COLORCONV_KERNEL_AVX2};
+    int compared = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int w = sizes[s][0], h = sizes[s][1];
+        int sstride = 4 * w + PAD;
+        uint8_t *rgb = malloc((size_t)sstride * h);
+        for (int i = 0; i < sstride * h; i++) rgb[i] = rnd8();
+        colorconv_image_t src = {COLORCONV_RGBA, w, h, {rgb, NULL, NULL}, {sstride, 0, 0}};
+
+        for (int m = 0; m < 2; m++) {
+            for (int rg = 0; rg < 2; rg++) {
+                colorconv_t *cc = colorconv_create((colorconv_matrix_t)m,
+                                                   (colorconv_range_t)rg, 1);
+                for (size_t f = 0; f < 3; f++) {
+                    colorconv_image_t ref_img, img;
+                    size_t n;
+                    uint8_t *ref = padded_dst(&ref_img, fmts[f], w, h, &n);
+                    colorconv_set_kernel(cc, COLORCONV_KERNEL_SCALAR);
+                    TEST_ASSERT(colorconv_convert(cc, &src, &ref_img) == 0, "scalar convert");
+                    TEST_ASSERT(ref[ref_img.stride[0] - 1] == 0xA5, "row padding untouched");
+
+                    for (size_t kk = 0; kk < 2; kk++) {
+                        if (colorconv_set_kernel(cc, kernels[kk]) != 0) continue;
+                        uint8_t *out = padded_dst(&img, fmts[f], w, h, &n);
+                        TEST_ASSERT(colorconv_convert(cc, &src, &img) == 0, "simd convert");
+                        TEST_ASSERT(memcmp(ref, out, n) == 0, "SIMD output == scalar output");
+                        free(out);
+                        compared++;
+                    }
+                    free(ref);
+                }
+                colorconv_destroy(cc);
+            }
+        }
+        free(rgb);
+    }
+    printf("  %d SIMD conversions compared\n", compared);
+    TEST_PASS("kernels bit-identical");
+    return 0;
+}
+
+static int test_threads(void) {
+    printf("\n=== test_threads ===\n");
+    const int w = 2560, h = 1442; /* ≥ COLORCONV_MT_MIN_PIXELS, uneven bands */
+    uint8_t *rgba = malloc((size_t)w * h * 4);
+    for (size_t i = 0; i < (size_t)w * h * 4; i++) rgba[i] = rnd8();
+
+    colorconv_t *one = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 1);
+    colorconv_t *four = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 4);
+    TEST_ASSERT(one && four, "create");
+
+    size_t n = colorconv_image_size(COLORCONV_P010, w, h);
+    uint8_t *a = convert(one, rgba, w, h, COLORCONV_P010);
+    for (int rep = 0; rep < 3; rep++) {
+        uint8_t *b = convert(four, rgba, w, h, COLORCONV_P010);
+        TEST_ASSERT(a && b && memcmp(a, b, n) == 0, "4 threads == 1 thread");
+        free(b);
+    }
+
+    free(a);
+    free(rgba);
+    colorconv_destroy(four);
+    colorconv_destroy(one);
+    TEST_PASS("threaded conversion");
+    return 0;
+}
+
+static int test_bad_geometry(void) {
+    printf("\n=== test_bad_geometry ===\n");
+    colorconv_t *cc = colorconv_create(COLORCONV_BT709, COLORCONV_RANGE_LIMITED, 1);
+    uint8_t buf[4 * 16 * 16];
+    colorconv_image_t src, dst;
+
+    colorconv_image_init(&src, COLORCONV_RGBA, 16, 16, buf);
+    colorconv_image_init(&dst, COLORCONV_NV12, 8, 16, buf);
+    TEST_ASSERT(colorconv_convert(cc, &src, &dst) == -1, "size mismatch rejected");
+    colorconv_image_init(&dst, COLORCONV_RGBA, 16, 16, buf);
+    TEST_ASSERT(colorconv_convert(cc, &src, &dst) == -1, "RGBA destination rejected");
+    colorconv_image_init(&dst, COLORCONV_I420, 16, 16, buf);
+    dst.stride[2] = 4;
+    TEST_ASSERT(colorconv_convert(cc, &src, &dst) == -1, "short stride rejected");
+    TEST_ASSERT(colorconv_convert(NULL, &src, &dst) == -1, "NULL converter rejected");
+
+    colorconv_destroy(cc);
+    TEST_PASS("geometry validation");
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_reference_colours();
+    failures += test_chroma_average();
+    failures += test_bgra();
+    failures += test_kernels_match();
+    failures += test_threads();
+    failures += test_bad_geometry();
+
+    printf("\n");
+    if (failures == 0) printf("ALL COLORCONV TESTS PASSED\n");
+    else               printf("%d COLORCONV TEST(S) FAILED\n", failures);
+    return failures ? 1 : 0;
+}
@@ -3,18 +3,31 @@
  *
  * Tests rtt_estimator (first-sample init, SRTT/RTTVAR/RTO updates,
  * min/max tracking, reset), loss_detector (record/fraction/threshold/
- * congestion signal/reset/set_threshold), and congestion_stats
- * (integrated RTT+loss, event counting).
+ * congestion signal/reset/set_threshold), congestion_stats
+ * (integrated RTT+loss, event counting), transport_feedback (payload
+ * round trip, reorder settling, size cap, send history, malformed
+ * input) and delay_controller, both against a simulated bottleneck and
+ * end to end over loopback through a netem-style impairment shim.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 
 #include "../../src/congestion/rtt_estimator.h"
 #include "../../src/congestion/loss_detector.h"
 #include "../../src/congestion/congestion_stats.h"
+#include "../../src/congestion/transport_feedback.h"
+#include "../../src/congestion/delay_controller.h"
+#include "../../src/network/udp_rx.h"
 
 /* ── Test macros ─────────────────────────────────────────────────── */
 
@@ -191,6 +204,557 @@ static int test_congestion_stats_integrated(void) {
     return 0;
 }
 
+/* ── transport_feedback tests ────────────────────────────────────── */
+
+static int test_tfb_roundtrip(void) {
+    printf("\n=== test_tfb_roundtrip ===\n");
+
+    tfb_recorder_t *r = tfb_recorder_create();
+    TEST_ASSERT(r != NULL, "created");
+
+    /* 100..119 one every ms; 105 lost, 110 overtaken by 111 */
+    uint64_t t0 = 1700000000000000ULL, arrival[20];
+    for (int i = 0; i < 20; i++) {
+        arrival[i] = t0 + (uint64_t)i * 1000 + (i == 10 ? 1700 : 0);
+        if (i != 5 && i != 10)
+            tfb_recorder_on_packet(r, 100 + (uint64_t)i, arrival[i]);
+        if (i == 11)
+            tfb_recorder_on_packet(r, 110, arrival[10]);
+    }
+
+    uint8_t buf[1400];
+    size_t len = tfb_recorder_build(r, t0 + 40000, buf, sizeof(buf));
+    TEST_ASSERT(len > TFB_HEADER_SIZE && len < 60, "compact payload");
+
+    tfb_packet_t pkts[TFB_MAX_PACKETS];
+    TEST_ASSERT(tfb_parse(buf, len, pkts, TFB_MAX_PACKETS) == 20, "20 entries");
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT(pkts[i].seq == 100 + (uint64_t)i, "sequence order");
+        if (i == 5) {
+            TEST_ASSERT(pkts[i].arrival_us == 0, "gap reported lost");
+            continue;
+        }
+        TEST_ASSERT(pkts[i].arrival_us <= arrival[i] &&
+                    arrival[i] - pkts[i].arrival_us < TFB_TICK_US, "arrival within a tick");
+    }
+    TEST_ASSERT(pkts[10].arrival_us > pkts[11].arrival_us, "reordered arrival kept");
+
+    TEST_ASSERT(tfb_recorder_build(r, t0 + 40000, buf, sizeof(buf)) == 0, "nothing left");
+    tfb_recorder_on_packet(r, 105, t0 + 41000);
+    TEST_ASSERT(tfb_recorder_build(r, t0 + 80000, buf, sizeof(buf)) == 0,
+                "late arrival of a reported packet ignored");
+
+    tfb_recorder_destroy(r);
+    TEST_PASS("transport feedback round trip");
+    return 0;
+}
+
+static int test_tfb_reorder_settling(void) {
+    printf("\n=== test_tfb_reorder_settling ===\n");
+
+    tfb_recorder_t *r = tfb_recorder_create();
+    uint64_t t0 = 1000000;
+    tfb_recorder_on_packet(r, 0, t0 + 1000);
+    tfb_recorder_on_packet(r, 1, t0 + 2000);
+    tfb_recorder_on_packet(r, 3, t0 + 3000);
+
+    /* Gap at 2 is younger than TFB_REORDER_US: report only up to it */
+    uint8_t buf[256];
+    tfb_packet_t pkts[TFB_MAX_PACKETS];
+    size_t len = tfb_recorder_build(r, t0 + 8000, buf, sizeof(buf));
+    TEST_ASSERT(tfb_parse(buf, len, pkts, TFB_MAX_PACKETS) == 2, "stops before young gap");
+
+    /* The straggler fills the gap: no loss */
+    tfb_recorder_on_packet(r, 2, t0 + 9000);
+    len = tfb_recorder_build(r, t0 + 9500, buf, sizeof(buf));
+    TEST_ASSERT(tfb_parse(buf, len, pkts, TFB_MAX_PACKETS) == 2, "2 and 3 reported");
+    TEST_ASSERT(pkts[0].seq == 2 && pkts[0].arrival_us > 0, "straggler received");
+    TEST_ASSERT(pkts[1].seq == 3 && pkts[1].arrival_us > 0, "3 received");
+
+    /* A gap that never fills settles as lost */
+    tfb_recorder_on_packet(r, 6, t0 + 10000);
+    TEST_ASSERT(tfb_recorder_build(r, t0 + 15000, buf, sizeof(buf)) == 0, "not settled yet");
+    len = tfb_recorder_build(r, t0 + 10000 + TFB_REORDER_US, buf, sizeof(buf));
+    TEST_ASSERT(tfb_parse(buf, len, pkts, TFB_MAX_PACKETS) == 3, "4..6 reported");
+    TEST_ASSERT(pkts[0].arrival_us == 0 && pkts[1].arrival_us == 0, "4 and 5 lost");
+    TEST_ASSERT(pkts[2].arrival_us > 0, "6 received");
+
+    tfb_recorder_reset(r);
+    TEST_ASSERT(tfb_recorder_build(r, t0 + 90000, buf, sizeof(buf)) == 0, "reset empties");
+
+    tfb_recorder_destroy(r);
+    TEST_PASS("transport feedback reorder settling");
+    return 0;
+}
+
+static int test_tfb_cap_split(void) {
+    printf("\n=== test_tfb_cap_split ===\n");
+
+    /* Alternating loss: one run per packet, so the cap bites quickly */
+    tfb_recorder_t *r = tfb_recorder_create();
+    for (uint64_t s = 0; s < 2000; s += 2)
+        tfb_recorder_on_packet(r, s, 1000000 + s * 500);
+
+    uint8_t buf[200];
+    tfb_packet_t pkts[TFB_MAX_PACKETS];
+    uint64_t next = 0;
+    int payloads = 0;
+    size_t len;
+    while ((len = tfb_recorder_build(r, 10000000, buf, sizeof(buf))) > 0) {
+        TEST_ASSERT(len <= sizeof(buf), "payload within cap");
+        int n = tfb_parse(buf, len, pkts, TFB_MAX_PACKETS);
+        TEST_ASSERT(n > 0, "payload parses");
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT(pkts[i].seq == next, "payloads continue each other");
+            TEST_ASSERT((pkts[i].arrival_us > 0) == (next % 2 == 0), "status kept");
+            next++;
+        }
+        payloads++;
+    }
+    /* 1999 is never sent, so 1998 is the last sequence number known */
+    TEST_ASSERT(next == 1999, "every sequence number reported once");
+    TEST_ASSERT(payloads > 10, "split over several payloads");
+
+    tfb_recorder_destroy(r);
+    TEST_PASS("transport feedback size cap");
+    return 0;
+}
+
+static int test_tfb_history(void) {
+    printf("\n=== test_tfb_history ===\n");
+
+    tfb_history_t *h = tfb_history_create();
+    TEST_ASSERT(h != NULL, "created");
+
+    uint64_t send_us = 0;
+    uint32_t size = 0;
+    TEST_ASSERT(!tfb_history_lookup(h, 0, &send_us, &size), "empty history");
+
+    tfb_history_record(h, 5, 123456789, 1228);
+    TEST_ASSERT(tfb_history_lookup(h, 5, &send_us, &size), "found");
+    TEST_ASSERT(send_us == 123456789 && size == 1228, "send time and size");
+
+    tfb_history_record(h, 5 + TFB_HISTORY_SIZE, 2, 3);
+    TEST_ASSERT(!tfb_history_lookup(h, 5, NULL, NULL), "overwritten entry gone");
+    TEST_ASSERT(tfb_history_lookup(h, 5 + TFB_HISTORY_SIZE, &send_us, &size) && send_us == 2,
+                "newer entry found");
+
+    tfb_history_reset(h);
+    TEST_ASSERT(!tfb_history_lookup(h, 5 + TFB_HISTORY_SIZE, NULL, NULL), "reset forgets");
+    TEST_ASSERT(!tfb_history_lookup(NULL, 5, NULL, NULL), "NULL history");
+
+    tfb_history_destroy(h);
+    TEST_PASS("transport feedback send history");
+    return 0;
+}
+
+static int test_tfb_malformed(void) {
+    printf("\n=== test_tfb_malformed ===\n");
+
+    tfb_recorder_t *r = tfb_recorder_create();
+    for (uint64_t s = 0; s < 10; s++)
+        if (s != 4)
+            tfb_recorder_on_packet(r, s, 5000000 + s * 1000);
+
+    uint8_t buf[256], bad[256];
+    size_t len = tfb_recorder_build(r, 9000000, buf, sizeof(buf));
+    tfb_packet_t pkts[16];
+    TEST_ASSERT(tfb_parse(buf, len, pkts, 16) == 10, "valid payload");
+
+    TEST_ASSERT(tfb_parse(buf, TFB_HEADER_SIZE - 1, pkts, 16) == -1, "short header");
+    TEST_ASSERT(tfb_parse(buf, len - 1, pkts, 16) == -1, "truncated deltas");
+    TEST_ASSERT(tfb_parse(buf, len, pkts, 9) == -1, "more packets than room");
+
+    memcpy(bad, buf, len);
+    bad[len] = 0;
+    TEST_ASSERT(tfb_parse(bad, len + 1, pkts, 16) == -1, "trailing bytes");
+
+    memcpy(bad, buf, len);
+    bad[16] = 11; /* packet_count no longer matches the runs */
+    TEST_ASSERT(tfb_parse(bad, len, pkts, 16) == -1, "count mismatch");
+
+    memcpy(bad, buf, len);
+    bad[18] = 0xFF; /* run_count past the end */
+    TEST_ASSERT(tfb_parse(bad, len, pkts, 16) == -1, "run table overruns");
+
+    memset(bad, 0xFF, sizeof(bad));
+    TEST_ASSERT(tfb_parse(bad, sizeof(bad), pkts, 16) == -1, "garbage");
+    TEST_ASSERT(tfb_parse(NULL, len, pkts, 16) == -1, "NULL buffer");
+
+    tfb_recorder_destroy(r);
+    TEST_PASS("transport feedback rejects malformed payloads");
+    return 0;
+}
+
+/* ── delay_controller tests ──────────────────────────────────────── */
+
+#define SIM_PACKET 1200
+#define SIM_QUEUE 65536
+
+/*
+ * Drive a controller through a simulated bottleneck in virtual time
+ *
+ * 1 ms steps; packets are paced at the target, dropped at random with
+ * probability @loss, queued behind the link (tail drop at 300 ms) and
+ * arrive 20 ms after leaving it.  Feedback goes back every 20 ms.
+ */
+static void sim_run(delay_controller_t *dc, double cap_bps, double loss, uint64_t duration_us) {
+    static struct { uint64_t seq, arrive_us; } q[SIM_QUEUE];
+    tfb_recorder_t *rec = tfb_recorder_create();
+    tfb_history_t *h = tfb_history_create();
+    tfb_packet_t pkts[TFB_MAX_PACKETS];
+    uint8_t buf[1400];
+    uint64_t seq = 0, link_free = 0, t0 = 1000000;
+    unsigned qh = 0, qt = 0;
+    double budget = 0;
+    srand(1);
+
+    for (uint64_t now = t0; now < t0 + duration_us; now += 1000) {
+        budget += delay_controller_target_bps(dc) / 8.0 / 1000.0;
+        for (; budget >= SIM_PACKET; budget -= SIM_PACKET, seq++) {
+            tfb_history_record(h, seq, now, SIM_PACKET);
+            if (rand() / (double)RAND_MAX < loss)
+                continue;
+            uint64_t dep = (link_free > now ? link_free : now) +
+                           (uint64_t)(SIM_PACKET * 8e6 / cap_bps);
+            if (dep - now < 300000) {
+                link_free = dep;
+                q[qt % SIM_QUEUE].seq = seq;
+                q[qt++ % SIM_QUEUE].arrive_us = dep + 20000;
+            }
+        }
+        for (; qh != qt && q[qh % SIM_QUEUE].arrive_us <= now; qh++)
+            tfb_recorder_on_packet(rec, q[qh % SIM_QUEUE].seq, q[qh % SIM_QUEUE].arrive_us);
+
+        if ((now / 1000) % 20 != 0)
+            continue;
+        size_t len;
+        while ((len = tfb_recorder_build(rec, now, buf, sizeof(buf))) > 0) {
+            int n = tfb_parse(buf, len, pkts, TFB_MAX_PACKETS), k = 0;
+            for (int i = 0; i < n; i++)
+                if (tfb_history_lookup(h, pkts[i].seq, &pkts[i].send_us, &pkts[i].size))
+                    pkts[k++] = pkts[i];
+            delay_controller_on_feedback(dc, pkts, k, now + 20000);
+        }
+    }
+
+    tfb_history_destroy(h);
+    tfb_recorder_destroy(rec);
+}
+
+static int test_dc_overuse(void) {
+    printf("\n=== test_dc_overuse ===\n");
+
+    /* Starting at 8 Mbps into a 3 Mbps bottleneck */
+    delay_controller_config_t cfg = {300000, 20000000, 8000000};
+    delay_controller_t *dc = delay_controller_create(&cfg);
+    TEST_ASSERT(dc != NULL, "created");
+
+    sim_run(dc, 3e6, 0.0, 6000000);
+
+    delay_controller_stats_t st;
+    delay_controller_get_stats(dc, &st);
+    printf("  target=%.2f Mbps acked=%.2f Mbps overuse=%llu\n", st.target_bps / 1e6,
+           st.acked_bps / 1e6, (unsigned long long)st.overuse_events);
+    TEST_ASSERT(st.overuse_events >= 1, "queue growth detected");
+    TEST_ASSERT(st.target_bps < 3300000, "target at or below capacity");
+    TEST_ASSERT(st.target_bps > 1000000, "target not collapsed");
+    TEST_ASSERT(st.acked_bps <= 3100000, "acked rate bounded by the link");
+
+    delay_controller_destroy(dc);
+    TEST_PASS("delay controller backs off to the bottleneck");
+    return 0;
+}
+
+static int test_dc_random_loss(void) {
+    printf("\n=== test_dc_random_loss ===\n");
+
+    /* 5 % random loss with plenty of capacity: hold, do not cut */
+    delay_controller_config_t cfg = {300000, 20000000, 4000000};
+    delay_controller_t *dc = delay_controller_create(&cfg);
+
+    sim_run(dc, 20e6, 0.05, 6000000);
+
+    delay_controller_stats_t st;
+    delay_controller_get_stats(dc, &st);
+    printf("  target=%.2f Mbps loss=%.3f\n", st.target_bps / 1e6, st.loss_fraction);
+    TEST_ASSERT(st.loss_fraction > 0.02 && st.loss_fraction < 0.10, "loss measured");
+    TEST_ASSERT(st.loss_events == 0, "no loss-based cut");
+    TEST_ASSERT(st.target_bps >= 3600000 && st.target_bps <= 4400000, "target held");
+
+    delay_controller_destroy(dc);
+    TEST_PASS("delay controller holds under moderate loss");
+    return 0;
+}
+
+static int test_dc_growth_and_bounds(void) {
+    printf("\n=== test_dc_growth_and_bounds ===\n");
+
+    delay_controller_config_t cfg = {500000, 20000000, 2000000};
+    delay_controller_t *dc = delay_controller_create(&cfg);
+
+    sim_run(dc, 50e6, 0.0, 5000000);
+
+    delay_controller_stats_t st;
+    delay_controller_get_stats(dc, &st);
+    TEST_ASSERT(st.overuse_events == 0 && st.loss_events == 0, "no congestion signalled");
+    TEST_ASSERT(st.target_bps > 2500000, "target grows on a clear path");
+    TEST_ASSERT(st.rtt_us > 20000 && st.rtt_us < 80000, "send-to-feedback time tracked");
+
+    TEST_ASSERT(delay_controller_set_bounds(dc, 500000, 1000000) == 0, "set_bounds");
+    TEST_ASSERT(delay_controller_target_bps(dc) <= 1000000, "target clamped to new max");
+    TEST_ASSERT(delay_controller_set_bounds(dc, 2000000, 1000000) == -1, "min > max rejected");
+
+    delay_controller_config_t bad = {0, 1000000, 500000};
+    TEST_ASSERT(delay_controller_create(&bad) == NULL, "zero min rejected");
+    TEST_ASSERT(delay_controller_target_bps(NULL) == 0, "NULL target");
+
+    delay_controller_destroy(dc);
+    TEST_PASS("delay controller growth and bounds");
+    return 0;
+}
+
+/* ── Loopback end-to-end tests ───────────────────────────────────── */
+
+#define E2E_PACKET 1200
+#define E2E_SHIM_SLOTS 4096
+
+/*
+ * netem-style impairment between sender and receiver: random loss, a
+ * rate-limited bottleneck with a tail-drop queue, then fixed delay
+ */
+typedef struct {
+    double rate_bps;
+    double loss;
+    uint64_t delay_us;
+    uint64_t queue_us;
+    uint64_t link_free_us;
+    uint64_t max_queue_us;
+    unsigned head, tail;
+    struct {
+        uint8_t data[E2E_PACKET];
+        size_t len;
+        uint64_t release_us;
+    } slots[E2E_SHIM_SLOTS];
+} e2e_shim_t;
+
+static uint64_t e2e_mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint64_t e2e_wall_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static int e2e_socket(struct sockaddr_in *addr) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return -1;
+    int buf = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(*addr);
+    if (bind(fd, (struct sockaddr *)addr, len) < 0 ||
+        getsockname(fd, (struct sockaddr *)addr, &len) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void e2e_shim_input(e2e_shim_t *shim, const uint8_t *data, size_t len, uint64_t now) {
+    if (rand() / (double)RAND_MAX < shim->loss || shim->tail - shim->head >= E2E_SHIM_SLOTS)
+        return;
+    uint64_t dep = (shim->link_free_us > now ? shim->link_free_us : now) +
+                   (uint64_t)(len * 8e6 / shim->rate_bps);
+    if (dep - now > shim->queue_us)
+        return; /* Tail drop */
+    shim->link_free_us = dep;
+    if (dep - now > shim->max_queue_us)
+        shim->max_queue_us = dep - now;
+
+    unsigned i = shim->tail++ % E2E_SHIM_SLOTS;
+    memcpy(shim->slots[i].data, data, len);
+    shim->slots[i].len = len;
+    shim->slots[i].release_us = dep + shim->delay_us;
+}
+
+typedef struct {
+    double queue_ms; /* Bottleneck queue at the end */
+    delay_controller_stats_t stats;
+} e2e_result_t;
+
+/*
+ * Stream paced packets sender → shim → receiver over loopback for
+ * @duration_us; the receiver stamps arrivals with kernel receive times
+ * (udp_rx) and returns feedback straight to the sender every 20 ms
+ */
+static int e2e_run(e2e_shim_t *shim, uint32_t start_bps, uint64_t duration_us,
+                   e2e_result_t *out) {
+    struct sockaddr_in tx_addr, shim_addr, rx_addr;
+    int tx = e2e_socket(&tx_addr), sh = e2e_socket(&shim_addr), rx = e2e_socket(&rx_addr);
+    udp_rx_t *urx = rx >= 0 ? udp_rx_create(rx, 64, 2048) : NULL;
+    delay_controller_config_t cfg = {300000, 20000000, start_bps};
+    delay_controller_t *dc = delay_controller_create(&cfg);
+    tfb_recorder_t *rec = tfb_recorder_create();
+    tfb_history_t *hist = tfb_history_create();
+    tfb_packet_t *pkts = malloc(sizeof(tfb_packet_t) * TFB_MAX_PACKETS);
+    int rc = -1;
+    if (tx < 0 || sh < 0 || !urx || !dc || !rec || !hist || !pkts)
+        goto out;
+
+    uint8_t pkt[E2E_PACKET] = {0}, buf[2048];
+    uint64_t seq = 0, start = e2e_mono_us(), last = start, next_fb = start;
+    double budget = 0;
+    srand(7);
+
+    for (uint64_t now = start; now - start < duration_us; now = e2e_mono_us()) {
+        /* Sender: pace at the target, bursts capped at 4 packets */
+        double rate = delay_controller_target_bps(dc) / 8e6;
+        budget += (double)(now - last) * rate;
+        last = now;
+        if (budget > 4 * E2E_PACKET)
+            budget = 4 * E2E_PACKET;
+        for (; budget >= E2E_PACKET; budget -= E2E_PACKET, seq++) {
+            memcpy(pkt, &seq, sizeof(seq));
+            sendto(tx, pkt, sizeof(pkt), 0, (struct sockaddr *)&shim_addr, sizeof(shim_addr));
+            tfb_history_record(hist, seq, now, E2E_PACKET);
+        }
+
+        /* Shim: take everything in, release what is due */
+        ssize_t r;
+        while ((r = recv(sh, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+            e2e_shim_input(shim, buf, (size_t)r, now);
+        for (; shim->head != shim->tail; shim->head++) {
+            unsigned i = shim->head % E2E_SHIM_SLOTS;
+            if (shim->slots[i].release_us > now)
+                break;
+            sendto(sh, shim->slots[i].data, shim->slots[i].len, 0, (struct sockaddr *)&rx_addr,
+                   sizeof(rx_addr));
+        }
+
+        /* Receiver: record arrivals, report every 20 ms */
+        int n;
+        while ((n = udp_rx_recv(urx)) > 0) {
+            for (int i = 0; i < n; i++) {
+                udp_rx_packet_t *p = udp_rx_packet(urx, i);
+                uint64_t s;
+                memcpy(&s, p->data, sizeof(s));
+                tfb_recorder_on_packet(rec, s, p->rx_time_us ? p->rx_time_us : e2e_wall_us());
+            }
+        }
+        if (now >= next_fb) {
+            next_fb += 20000;
+            size_t len;
+            while ((len = tfb_recorder_build(rec, e2e_wall_us(), buf, 1400)) > 0)
+                sendto(rx, buf, len, 0, (struct sockaddr *)&tx_addr, sizeof(tx_addr));
+        }
+
+        /* Sender: apply feedback */
+        while ((r = recv(tx, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            int k = 0, m = tfb_parse(buf, (size_t)r, pkts, TFB_MAX_PACKETS);
+            for (int i = 0; i < m; i++)
+                if (tfb_history_lookup(hist, pkts[i].seq, &pkts[i].send_us, &pkts[i].size))
+                    pkts[k++] = pkts[i];
+            if (k > 0)
+                delay_controller_on_feedback(dc, pkts, k, e2e_mono_us());
+        }
+
+        /* Sleep until the next packet, release or report is due */
+        uint64_t wake = next_fb;
+        if (rate > 0) {
+            uint64_t t = now + (uint64_t)((E2E_PACKET - budget) / rate);
+            if (t < wake)
+                wake = t;
+        }
+        if (shim->head != shim->tail &&
+            shim->slots[shim->head % E2E_SHIM_SLOTS].release_us < wake)
+            wake = shim->slots[shim->head % E2E_SHIM_SLOTS].release_us;
+        uint64_t wait = wake > now ? wake - now : 0;
+        struct pollfd fds[3] = {{sh, POLLIN, 0}, {rx, POLLIN, 0}, {tx, POLLIN, 0}};
+        struct timespec ts = {(time_t)(wait / 1000000), (long)(wait % 1000000) * 1000};
+        ppoll(fds, 3, &ts, NULL);
+    }
+
+    uint64_t end = e2e_mono_us();
+    out->queue_ms = shim->link_free_us > end ? (shim->link_free_us - end) / 1000.0 : 0.0;
+    delay_controller_get_stats(dc, &out->stats);
+    rc = 0;
+
+out:
+    free(pkts);
+    tfb_history_destroy(hist);
+    tfb_recorder_destroy(rec);
+    delay_controller_destroy(dc);
+    udp_rx_destroy(urx);
+    if (tx >= 0)
+        close(tx);
+    if (sh >= 0)
+        close(sh);
+    if (rx >= 0)
+        close(rx);
+    return rc;
+}
+
+static int test_e2e_bottleneck(void) {
+    printf("\n=== test_e2e_bottleneck ===\n");
+
+    /* 10 Mbps offered into a 4 Mbps link with a 250 ms queue */
+    e2e_shim_t *shim = calloc(1, sizeof(*shim));
+    TEST_ASSERT(shim != NULL, "shim allocated");
+    shim->rate_bps = 4e6;
+    shim->delay_us = 20000;
+    shim->queue_us = 250000;
+
+    e2e_result_t res;
+    int rc = e2e_run(shim, 10000000, 4000000, &res);
+    printf("  target=%.2f Mbps acked=%.2f Mbps overuse=%llu peak queue=%.0f ms end queue=%.0f ms\n",
+           res.stats.target_bps / 1e6, res.stats.acked_bps / 1e6,
+           (unsigned long long)res.stats.overuse_events, shim->max_queue_us / 1000.0,
+           res.queue_ms);
+    free(shim);
+    TEST_ASSERT(rc == 0, "loopback sockets");
+    TEST_ASSERT(res.stats.feedbacks > 50, "feedback flowing");
+    TEST_ASSERT(res.stats.overuse_events >= 1, "overuse detected");
+    TEST_ASSERT(res.stats.target_bps < 4400000, "target below the bottleneck");
+    TEST_ASSERT(res.queue_ms < 100.0, "queue drained");
+
+    TEST_PASS("loopback: controller converges under the bottleneck");
+    return 0;
+}
+
+static int test_e2e_random_loss(void) {
+    printf("\n=== test_e2e_random_loss ===\n");
+
+    /* 5 % random loss on an uncongested 20 Mbps link */
+    e2e_shim_t *shim = calloc(1, sizeof(*shim));
+    TEST_ASSERT(shim != NULL, "shim allocated");
+    shim->rate_bps = 20e6;
+    shim->loss = 0.05;
+    shim->delay_us = 20000;
+    shim->queue_us = 250000;
+
+    e2e_result_t res;
+    int rc = e2e_run(shim, 4000000, 3000000, &res);
+    printf("  target=%.2f Mbps loss=%.3f overuse=%llu\n", res.stats.target_bps / 1e6,
+           res.stats.loss_fraction, (unsigned long long)res.stats.overuse_events);
+    free(shim);
+    TEST_ASSERT(rc == 0, "loopback sockets");
+    TEST_ASSERT(res.stats.lost > 0, "losses reported");
+    TEST_ASSERT(res.stats.loss_events == 0, "no loss-based cut at 5 %");
+    TEST_ASSERT(res.stats.target_bps >= 3200000 && res.stats.target_bps <= 4400000,
+                "target held");
+
+    TEST_PASS("loopback: random loss does not collapse the rate");
+    return 0;
+}
+
 /* ── main ────────────────────────────────────────────────────────── */
 
 int main(void) {
@@ -206,6 +770,19 @@ int main(void) {
 
     failures += test_congestion_stats_integrated();
 
+    failures += test_tfb_roundtrip();
+    failures += test_tfb_reorder_settling();
+    failures += test_tfb_cap_split();
+    failures += test_tfb_history();
+    failures += test_tfb_malformed();
+
+    failures += test_dc_overuse();
+    failures += test_dc_random_loss();
+    failures += test_dc_growth_and_bounds();
+
+    failures += test_e2e_bottleneck();
+    failures += test_e2e_random_loss();
+
     printf("\n");
     if (failures == 0)
         printf("ALL CONGESTION TESTS PASSED\n");
@@ -5,6 +5,7 @@
  * - Key generation
  * - Session creation
  * - Encryption/decryption roundtrip
+ * - Handshake nonces salting the session key
  * - Fingerprint formatting
  * - Peer verification
  */
@@ -146,6 +147,45 @@ TEST(encrypt_decrypt_roundtrip) {
     ASSERT_STR_EQ((char*)decrypted, plaintext);
 }
 
+TEST(salted_session_keys) {
+    keypair_t alice, bob;
+    crypto_generate_keypair(&alice, "alice");
+    crypto_generate_keypair(&bob, "bob");
+
+    uint8_t nonce_a[CRYPTO_SESSION_NONCE_BYTES], nonce_b[CRYPTO_SESSION_NONCE_BYTES];
+    memset(nonce_a, 0x11, sizeof(nonce_a));
+    memset(nonce_b, 0x22, sizeof(nonce_b));
+
+    crypto_session_t unsalted, alice_session, bob_session;
+    crypto_create_session(&unsalted, alice.secret_key, bob.public_key);
+    crypto_create_session(&alice_session, alice.secret_key, bob.public_key);
+    crypto_create_session(&bob_session, bob.secret_key, alice.public_key);
+    alice_session.nonce_counter = 7;
+
+    /* Either side may list its own nonce first */
+    ASSERT_EQ(crypto_salt_session(&alice_session, nonce_a, nonce_b), 0);
+    ASSERT_EQ(crypto_salt_session(&bob_session, nonce_b, nonce_a), 0);
+    ASSERT(memcmp(alice_session.shared_key, bob_session.shared_key,
+                  CRYPTO_SHARED_KEY_BYTES) == 0);
+    ASSERT(memcmp(alice_session.shared_key, unsalted.shared_key,
+                  CRYPTO_SHARED_KEY_BYTES) != 0);
+    ASSERT_EQ(alice_session.nonce_counter, 0);
+
+    /* A packet sealed under one handshake does not open under the next */
+    uint8_t ciphertext[64];
+    size_t cipher_len = 0;
+    crypto_encrypt_packet(&alice_session, "frame", 6, ciphertext, &cipher_len, 0);
+
+    nonce_b[0] ^= 1;
+    crypto_create_session(&bob_session, bob.secret_key, alice.public_key);
+    ASSERT_EQ(crypto_salt_session(&bob_session, nonce_b, nonce_a), 0);
+
+    uint8_t decrypted[64];
+    size_t decrypted_len = 0;
+    ASSERT_NE(crypto_decrypt_packet(&bob_session, ciphertext, cipher_len, decrypted,
+                                    &decrypted_len, 0), 0);
+}
+
 TEST(decrypt_wrong_nonce_fails) {
     keypair_t alice, bob;
     crypto_generate_keypair(&alice, "alice");
@@ -281,6 +321,7 @@ int main(void) {
     run_test_keypair_uniqueness();
     run_test_session_creation();
     run_test_encrypt_decrypt_roundtrip();
+    run_test_salted_session_keys();
     run_test_decrypt_wrong_nonce_fails();
     run_test_decrypt_tampered_fails();
     run_test_fingerprint_format();
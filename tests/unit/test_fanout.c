@@ -1,16 +1,23 @@
 /*
  * test_fanout.c — Unit tests for PHASE-37 Multi-Client Fanout
  *
- * Tests session_table, fanout_manager (no sockets), and per_client_abr
- * without requiring real network connections.
+ * Tests session_table, fanout_manager, fanout_pool and per_client_abr
+ * without requiring real network connections (the pooled manager test
+ * uses local socketpairs).
  */
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "../../src/fanout/session_table.h"
 #include "../../src/fanout/fanout_manager.h"
+#include "../../src/fanout/fanout_pool.h"
 #include "../../src/fanout/per_client_abr.h"
 
 /* ── Test macros ─────────────────────────────────────────────────── */
@@ -235,6 +242,328 @@ static int test_fanout_manager_stats_reset(void) {
     return 0;
 }
 
+/* ── fanout_pool tests ───────────────────────────────────────────── */
+
+#define POOL_LANES 4
+#define POOL_JOBS 200
+
+typedef struct {
+    int lane;
+    int seq;
+} pool_job_t;
+
+static pthread_mutex_t pool_mu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cv = PTHREAD_COND_INITIALIZER;
+static int ran_seq[POOL_LANES][POOL_JOBS];
+static int ran_count[POOL_LANES];
+static atomic_int in_lane[POOL_LANES];
+static atomic_int lane_overlap;
+static atomic_int released_jobs;
+static int allocated_jobs;
+static bool gate_open;
+
+static void record_job(void *job, int lane, void *user) {
+    (void)user;
+    pool_job_t *j = job;
+    if (atomic_fetch_add(&in_lane[lane], 1) != 0) atomic_store(&lane_overlap, 1);
+
+    /* seq < 0 marks a job that blocks until the gate opens */
+    pthread_mutex_lock(&pool_mu);
+    while (j->seq < 0 && !gate_open) pthread_cond_wait(&pool_cv, &pool_mu);
+    ran_seq[lane][ran_count[lane]++] = j->seq;
+    pthread_cond_broadcast(&pool_cv);
+    pthread_mutex_unlock(&pool_mu);
+
+    atomic_fetch_sub(&in_lane[lane], 1);
+}
+
+static void free_job(void *job, void *user) {
+    (void)user;
+    free(job);
+    atomic_fetch_add(&released_jobs, 1);
+}
+
+static pool_job_t *new_job(int lane, int seq) {
+    pool_job_t *j = malloc(sizeof(*j));
+    allocated_jobs++;
+    j->lane = lane;
+    j->seq = seq;
+    return j;
+}
+
+static void reset_pool_records(void) {
+    memset(ran_seq, 0, sizeof(ran_seq));
+    memset(ran_count, 0, sizeof(ran_count));
+    atomic_store(&lane_overlap, 0);
+    atomic_store(&released_jobs, 0);
+    allocated_jobs = 0;
+    gate_open = false;
+}
+
+/* Wait (bounded) until @lane has run @n jobs */
+static bool wait_ran(int lane, int n) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 5;
+
+    pthread_mutex_lock(&pool_mu);
+    int rc = 0;
+    while (ran_count[lane] < n && rc == 0)
+        rc = pthread_cond_timedwait(&pool_cv, &pool_mu, &deadline);
+    bool ok = ran_count[lane] >= n;
+    pthread_mutex_unlock(&pool_mu);
+    return ok;
+}
+
+/* Wait (bounded) until a worker is running a job of @lane */
+static bool wait_busy(int lane) {
+    struct timespec ts = {0, 1000000};
+    for (int i = 0; i < 5000 && atomic_load(&in_lane[lane]) == 0; i++) nanosleep(&ts, NULL);
+    return atomic_load(&in_lane[lane]) == 1;
+}
+
+static void open_gate(void) {
+    pthread_mutex_lock(&pool_mu);
+    gate_open = true;
+    pthread_cond_broadcast(&pool_cv);
+    pthread_mutex_unlock(&pool_mu);
+}
+
+static int test_fanout_pool_lane_order(void) {
+    printf("\n=== test_fanout_pool_lane_order ===\n");
+
+    TEST_ASSERT(fanout_pool_create(FANOUT_MAX_WORKERS + 1, 2, record_job, NULL, NULL) == NULL,
+                "too many workers rejected");
+    TEST_ASSERT(fanout_pool_create(2, 0, record_job, NULL, NULL) == NULL, "depth 0 rejected");
+    TEST_ASSERT(fanout_pool_create(2, 2, NULL, NULL, NULL) == NULL, "missing run rejected");
+
+    reset_pool_records();
+    fanout_pool_t *p = fanout_pool_create(3, FANOUT_LANE_DEPTH_MAX, record_job, free_job, NULL);
+    TEST_ASSERT(p != NULL && fanout_pool_worker_count(p) == 3, "pool with 3 workers");
+    pool_job_t bad = {0, 0};
+    TEST_ASSERT(fanout_pool_submit(p, FANOUT_MAX_LANES, &bad, FANOUT_JOB_KEY) == -1,
+                "bad lane rejected");
+
+    for (int seq = 0; seq < POOL_JOBS; seq++) {
+        for (int lane = 0; lane < POOL_LANES; lane++) {
+            /* Independent jobs are only refused by a full lane: retry */
+            while (fanout_pool_submit(p, lane, new_job(lane, seq), FANOUT_JOB_INDEPENDENT) ==
+                   FANOUT_DROPPED)
+                fanout_pool_wait(p);
+        }
+    }
+    fanout_pool_wait(p);
+
+    for (int lane = 0; lane < POOL_LANES; lane++) {
+        TEST_ASSERT(ran_count[lane] == POOL_JOBS, "every job ran");
+        for (int i = 0; i < POOL_JOBS; i++)
+            TEST_ASSERT(ran_seq[lane][i] == i, "lane runs jobs in submission order");
+    }
+    TEST_ASSERT(atomic_load(&lane_overlap) == 0, "one worker per lane at a time");
+
+    fanout_lane_stats_t st;
+    TEST_ASSERT(fanout_pool_get_lane_stats(p, 0, &st) == 0, "stats");
+    TEST_ASSERT(st.completed == POOL_JOBS, "completed counted");
+    TEST_ASSERT(st.peak_depth >= 1 && st.peak_depth <= FANOUT_LANE_DEPTH_MAX, "peak depth");
+
+    fanout_pool_destroy(p);
+    TEST_ASSERT(atomic_load(&released_jobs) == allocated_jobs, "every job released once");
+    TEST_PASS("fanout_pool keeps per-lane order across workers");
+    return 0;
+}
+
+static int test_fanout_pool_backpressure(void) {
+    printf("\n=== test_fanout_pool_backpressure ===\n");
+
+    reset_pool_records();
+    fanout_pool_t *p = fanout_pool_create(2, 2, record_job, free_job, NULL);
+    TEST_ASSERT(p != NULL, "pool created");
+
+    /* Lane 0 stalls on its first job */
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, -1), FANOUT_JOB_KEY) == FANOUT_QUEUED,
+                "stalling key queued");
+    TEST_ASSERT(wait_busy(0), "lane 0 busy");
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 1), FANOUT_JOB_DELTA) == FANOUT_QUEUED,
+                "delta 1 queued");
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 2), FANOUT_JOB_DELTA) == FANOUT_QUEUED,
+                "delta 2 queued");
+
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 3), FANOUT_JOB_DELTA) == FANOUT_DROPPED,
+                "delta to a full lane dropped");
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 4), FANOUT_JOB_DELTA) == FANOUT_DROPPED,
+                "deltas refused until a key");
+
+    /* The other lane is not held up by lane 0 */
+    TEST_ASSERT(fanout_pool_submit(p, 1, new_job(1, 0), FANOUT_JOB_DELTA) == FANOUT_QUEUED,
+                "lane 1 queued");
+    TEST_ASSERT(wait_ran(1, 1), "lane 1 ran while lane 0 stalled");
+
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 5), FANOUT_JOB_KEY) == FANOUT_QUEUED,
+                "key accepted");
+    TEST_ASSERT(fanout_pool_submit(p, 0, new_job(0, 6), FANOUT_JOB_DELTA) == FANOUT_QUEUED,
+                "deltas accepted after the key");
+
+    open_gate();
+    fanout_pool_wait(p);
+
+    TEST_ASSERT(ran_count[0] == 3 && ran_seq[0][0] == -1 && ran_seq[0][1] == 5 &&
+                    ran_seq[0][2] == 6,
+                "key superseded the queued deltas");
+
+    fanout_lane_stats_t st;
+    fanout_pool_get_lane_stats(p, 0, &st);
+    TEST_ASSERT(st.submitted == 7 && st.completed == 3, "submitted / completed");
+    TEST_ASSERT(st.dropped == 2 && st.discarded == 2, "dropped / discarded");
+    TEST_ASSERT(atomic_load(&released_jobs) == 8, "dropped and discarded jobs released");
+
+    fanout_pool_destroy(p);
+    TEST_PASS("fanout_pool back-pressure stays on the congested lane");
+    return 0;
+}
+
+static int test_fanout_pool_reset_and_inline(void) {
+    printf("\n=== test_fanout_pool_reset_and_inline ===\n");
+
+    reset_pool_records();
+    fanout_pool_t *p = fanout_pool_create(1, 4, record_job, free_job, NULL);
+    TEST_ASSERT(p != NULL, "pool created");
+
+    fanout_pool_submit(p, 2, new_job(2, -1), FANOUT_JOB_KEY);
+    TEST_ASSERT(wait_busy(2), "lane 2 busy");
+    fanout_pool_submit(p, 2, new_job(2, 1), FANOUT_JOB_DELTA);
+    fanout_pool_submit(p, 2, new_job(2, 2), FANOUT_JOB_DELTA);
+
+    /* reset_lane waits for the running job, so let it finish */
+    open_gate();
+    fanout_pool_reset_lane(p, 2);
+    fanout_lane_stats_t st;
+    fanout_pool_get_lane_stats(p, 2, &st);
+    TEST_ASSERT(st.submitted == 0 && st.completed == 0, "counters cleared");
+    TEST_ASSERT(ran_count[2] >= 1 && ran_count[2] <= 3, "running job finished");
+    TEST_ASSERT(atomic_load(&released_jobs) == 3, "queued jobs released");
+
+    /* Queued jobs are released, not run, on destroy */
+    gate_open = false;
+    fanout_pool_submit(p, 0, new_job(0, -1), FANOUT_JOB_KEY);
+    fanout_pool_submit(p, 0, new_job(0, 1), FANOUT_JOB_DELTA);
+    open_gate();
+    fanout_pool_destroy(p);
+    TEST_ASSERT(atomic_load(&released_jobs) == 5, "destroy releases everything");
+
+    /* No workers: jobs run inside submit */
+    reset_pool_records();
+    p = fanout_pool_create(0, 1, record_job, free_job, NULL);
+    TEST_ASSERT(p != NULL && fanout_pool_worker_count(p) == 0, "inline pool");
+    for (int i = 0; i < 5; i++)
+        TEST_ASSERT(fanout_pool_submit(p, 1, new_job(1, i), FANOUT_JOB_DELTA) == FANOUT_QUEUED,
+                    "inline submit");
+    TEST_ASSERT(ran_count[1] == 5 && ran_seq[1][4] == 4, "ran synchronously, in order");
+    TEST_ASSERT(atomic_load(&released_jobs) == 5, "released after running");
+    fanout_pool_destroy(p);
+
+    TEST_PASS("fanout_pool reset_lane, destroy and inline mode");
+    return 0;
+}
+
+/* ── pooled fanout_manager ───────────────────────────────────────── */
+
+#define POOLED_SESSIONS 3
+#define POOLED_FRAMES 40
+#define POOLED_FRAME_SIZE (64 * 1024)
+
+typedef struct {
+    int fd;
+    int frames;
+    bool ok;
+} reader_t;
+
+static bool read_full(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = read(fd, buf, len);
+        if (n <= 0) return false;
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/* Reads framed messages until EOF, checking each payload's pattern */
+static void *session_reader(void *arg) {
+    reader_t *r = arg;
+    static __thread uint8_t payload[POOLED_FRAME_SIZE];
+    uint8_t hdr[8];
+    r->ok = true;
+    while (read_full(r->fd, hdr, sizeof(hdr))) {
+        uint32_t len;
+        memcpy(&len, hdr + 4, 4);
+        if (hdr[0] != 0x52 || hdr[1] != 0x53 || len != POOLED_FRAME_SIZE ||
+            !read_full(r->fd, payload, len) || payload[len - 1] != payload[0]) {
+            r->ok = false;
+            break;
+        }
+        r->frames++;
+    }
+    return NULL;
+}
+
+static int test_fanout_manager_pooled(void) {
+    printf("\n=== test_fanout_manager_pooled ===\n");
+
+    session_table_t *t = session_table_create();
+    TEST_ASSERT(fanout_manager_create_pooled(t, 0) == NULL, "0 workers rejected");
+    fanout_manager_t *m = fanout_manager_create_pooled(t, 3);
+    TEST_ASSERT(m != NULL, "pooled manager created");
+
+    int sv[POOLED_SESSIONS][2];
+    reader_t readers[POOLED_SESSIONS] = {{0}};
+    pthread_t threads[POOLED_SESSIONS];
+    for (int i = 0; i < POOLED_SESSIONS; i++) {
+        TEST_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, sv[i]) == 0, "socketpair");
+        session_id_t id;
+        TEST_ASSERT(session_table_add(t, sv[i][0], "local", &id) == 0, "session added");
+        readers[i].fd = sv[i][1];
+    }
+
+    /* Sessions 0 and 1 read; session 2 does not until the end */
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, session_reader, &readers[i]);
+
+    static uint8_t frame[POOLED_FRAME_SIZE];
+    int queued = 0;
+    for (int f = 0; f < POOLED_FRAMES; f++) {
+        memset(frame, f + 1, sizeof(frame));
+        fanout_frame_type_t type = f == 0 ? FANOUT_FRAME_VIDEO_KEY : FANOUT_FRAME_VIDEO_DELTA;
+        queued += fanout_manager_deliver(m, frame, sizeof(frame), type);
+        /* Let the readers keep up, so only the stalled session congests */
+        struct timespec ts = {0, 5000000};
+        nanosleep(&ts, NULL);
+    }
+    TEST_ASSERT(queued < POOLED_SESSIONS * POOLED_FRAMES, "stalled session lost frames");
+
+    pthread_create(&threads[2], NULL, session_reader, &readers[2]);
+    fanout_manager_flush(m);
+    for (int i = 0; i < POOLED_SESSIONS; i++) shutdown(sv[i][0], SHUT_WR);
+    for (int i = 0; i < POOLED_SESSIONS; i++) pthread_join(threads[i], NULL);
+
+    TEST_ASSERT(readers[0].ok && readers[0].frames == POOLED_FRAMES, "session 0 got every frame");
+    TEST_ASSERT(readers[1].ok && readers[1].frames == POOLED_FRAMES, "session 1 got every frame");
+    TEST_ASSERT(readers[2].ok && readers[2].frames < POOLED_FRAMES / 2,
+                "stalled session dropped deltas");
+
+    fanout_stats_t stats;
+    fanout_manager_get_stats(m, &stats);
+    TEST_ASSERT(stats.frames_in == POOLED_FRAMES, "frames_in");
+    TEST_ASSERT(stats.frames_dropped > 0, "drops counted");
+
+    fanout_manager_destroy(m);
+    for (int i = 0; i < POOLED_SESSIONS; i++) {
+        close(sv[i][0]);
+        close(sv[i][1]);
+    }
+    session_table_destroy(t);
+    TEST_PASS("pooled fanout isolates a stalled session");
+    return 0;
+}
+
 /* ── per_client_abr tests ────────────────────────────────────────── */
 
 static int test_abr_create_destroy(void) {
@@ -338,6 +667,11 @@ int main(void) {
     failures += test_fanout_manager_deliver_no_sessions();
     failures += test_fanout_manager_stats_reset();
 
+    failures += test_fanout_pool_lane_order();
+    failures += test_fanout_pool_backpressure();
+    failures += test_fanout_pool_reset_and_inline();
+    failures += test_fanout_manager_pooled();
+
     failures += test_abr_create_destroy();
     failures += test_abr_decrease_on_loss();
     failures += test_abr_increase_when_stable();
@@ -0,0 +1,237 @@
+/*
+ * test_fbcache.c — Unit tests for persistent framebuffer mappings
+ *
+ * Tests fb_cache (hit/miss accounting, LRU eviction, release of
+ * mappings, fds and owner handles) and the dummy capture backend's
+ * fd-backed zero-copy frames: buffers are mapped once and reused across
+ * flips, the fd carries the same pixels as the mapping and as a copied
+ * frame, and the raw encoder produces identical output from both.
+ */
+
+#define _GNU_SOURCE /* memfd_create */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../../include/rootstream.h"
+#include "../../src/fbcache/fb_cache.h"
+
+#define TEST_ASSERT(cond, msg) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", (msg)); return 1; } } while (0)
+#define TEST_PASS(msg) printf("PASS: %s\n", (msg))
+
+#define W 64
+#define H 32
+
+/* Raw encoder header: magic, width, height, format, then timestamp_us */
+#define RAW_TS_OFFSET  16
+#define RAW_HEADER_LEN 24
+
+static int released[16];
+static int released_count;
+
+static void on_release(const fb_cache_entry_t *fb, void *user) {
+    (void)user;
+    if (released_count < 16) released[released_count++] = (int)fb->handle;
+}
+
+static fb_cache_entry_t make_entry(uint32_t fb_id) {
+    fb_cache_entry_t fb = {0};
+    fb.fb_id = fb_id;
+    fb.handle = fb_id * 10;
+    fb.dmabuf_fd = -1;
+    return fb;
+}
+
+static bool fd_open(int fd) {
+    return fcntl(fd, F_GETFD) != -1 || errno != EBADF;
+}
+
+/* ── fb_cache ────────────────────────────────────────────────────── */
+
+static int test_cache_lru(void) {
+    printf("\n=== test_cache_lru ===\n");
+
+    TEST_ASSERT(fb_cache_create(0, NULL, NULL) == NULL, "capacity 0 rejected");
+    TEST_ASSERT(fb_cache_create(FB_CACHE_MAX_ENTRIES + 1, NULL, NULL) == NULL,
+                "capacity > max rejected");
+
+    released_count = 0;
+    fb_cache_t *c = fb_cache_create(2, on_release, NULL);
+    TEST_ASSERT(c != NULL, "created");
+
+    fb_cache_entry_t e = make_entry(0);
+    TEST_ASSERT(fb_cache_put(c, &e) == NULL, "fb_id 0 rejected");
+    TEST_ASSERT(fb_cache_get(c, 1) == NULL, "miss on empty cache");
+
+    e = make_entry(1);
+    TEST_ASSERT(fb_cache_put(c, &e) != NULL, "put 1");
+    e = make_entry(2);
+    TEST_ASSERT(fb_cache_put(c, &e) != NULL, "put 2");
+    TEST_ASSERT(fb_cache_count(c) == 2, "two cached");
+
+    /* Touch 1 so 2 becomes least recently used */
+    fb_cache_entry_t *hit = fb_cache_get(c, 1);
+    TEST_ASSERT(hit && hit->handle == 10, "hit returns entry 1");
+
+    e = make_entry(3);
+    TEST_ASSERT(fb_cache_put(c, &e) != NULL, "put 3");
+    TEST_ASSERT(released_count == 1 && released[0] == 20, "LRU entry 2 evicted");
+    TEST_ASSERT(fb_cache_get(c, 2) == NULL, "2 gone");
+    TEST_ASSERT(fb_cache_get(c, 1) != NULL && fb_cache_get(c, 3) != NULL, "1 and 3 kept");
+
+    /* Re-putting an ID drops the stale mapping */
+    e = make_entry(3);
+    e.handle = 99;
+    TEST_ASSERT(fb_cache_put(c, &e)->handle == 99, "replaced 3");
+    TEST_ASSERT(released_count == 2 && released[1] == 30, "old 3 released");
+
+    fb_cache_invalidate(c, 1);
+    TEST_ASSERT(released_count == 3 && released[2] == 10, "invalidate releases 1");
+    TEST_ASSERT(fb_cache_count(c) == 1, "one left");
+
+    fb_cache_stats_t st;
+    fb_cache_get_stats(c, &st);
+    TEST_ASSERT(st.hits == 3 && st.misses == 2 && st.evictions == 1, "stats");
+
+    fb_cache_destroy(c);
+    TEST_ASSERT(released_count == 4 && released[3] == 99, "destroy releases the rest");
+
+    TEST_PASS("fb_cache LRU, replace, invalidate, stats");
+    return 0;
+}
+
+static int test_cache_owns_mapping(void) {
+    printf("\n=== test_cache_owns_mapping ===\n");
+
+    fb_cache_t *c = fb_cache_create(1, NULL, NULL);
+    TEST_ASSERT(c != NULL, "created");
+
+    int fd = memfd_create("test-fb", MFD_CLOEXEC);
+    TEST_ASSERT(fd >= 0 && ftruncate(fd, 4096) == 0, "memfd");
+    void *map = mmap(NULL, 4096, PROT_READ, MAP_SHARED, fd, 0);
+    TEST_ASSERT(map != MAP_FAILED, "mmap");
+
+    fb_cache_entry_t e = make_entry(7);
+    e.dmabuf_fd = fd;
+    e.map = map;
+    e.map_size = 4096;
+    TEST_ASSERT(fb_cache_put(c, &e) != NULL, "put");
+    TEST_ASSERT(fd_open(fd), "fd still open while cached");
+
+    e = make_entry(8);
+    fb_cache_put(c, &e);
+    TEST_ASSERT(!fd_open(fd), "fd closed on eviction");
+
+    fb_cache_destroy(c);
+    TEST_PASS("fb_cache releases fd and mapping");
+    return 0;
+}
+
+/* ── dummy backend fd-backed frames ──────────────────────────────── */
+
+static rootstream_ctx_t *dummy_ctx(bool zero_copy) {
+    rootstream_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) return NULL;
+    ctx->display.width = W;
+    ctx->display.height = H;
+    ctx->settings.zero_copy_capture = zero_copy;
+    if (rootstream_capture_init_dummy(ctx) < 0 ||
+        rootstream_encoder_init_raw(ctx, CODEC_H264) < 0) {
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+static void dummy_free(rootstream_ctx_t *ctx) {
+    rootstream_encoder_cleanup_raw(ctx);
+    rootstream_capture_cleanup_dummy(ctx);
+    free(ctx);
+}
+
+static int test_dummy_zero_copy(void) {
+    printf("\n=== test_dummy_zero_copy ===\n");
+
+    enum { FRAMES = 9 };
+    static uint8_t copied[FRAMES][W * H * 4];
+    static uint8_t enc_cpu[FRAMES][W * H * 2 + 64];
+    size_t enc_cpu_size[FRAMES];
+
+    /* Reference: ordinary copied frames */
+    rootstream_ctx_t *ctx = dummy_ctx(false);
+    TEST_ASSERT(ctx != NULL, "CPU dummy init");
+    for (int i = 0; i < FRAMES; i++) {
+        TEST_ASSERT(rootstream_capture_frame_dummy(ctx, &ctx->current_frame) == 0, "capture");
+        TEST_ASSERT(ctx->current_frame.memory == FRAME_MEMORY_CPU, "CPU frame");
+        memcpy(copied[i], ctx->current_frame.data, sizeof(copied[i]));
+        TEST_ASSERT(rootstream_encode_frame_raw(ctx, &ctx->current_frame, enc_cpu[i],
+                                                &enc_cpu_size[i]) == 0,
+                    "encode CPU frame");
+    }
+    dummy_free(ctx);
+
+    ctx = dummy_ctx(true);
+    TEST_ASSERT(ctx != NULL, "zero-copy dummy init");
+
+    const uint8_t *maps[FRAMES];
+    int fds[FRAMES];
+    for (int i = 0; i < FRAMES; i++) {
+        frame_buffer_t *f = &ctx->current_frame;
+        TEST_ASSERT(rootstream_capture_frame_dummy(ctx, f) == 0, "capture");
+        TEST_ASSERT(f->memory == FRAME_MEMORY_DMABUF, "fd-backed frame");
+        TEST_ASSERT(f->dmabuf_fd >= 0 && f->mapped != NULL, "fd and mapping set");
+        TEST_ASSERT(frame_buffer_pixels(f) == f->mapped, "pixels come from the mapping");
+        maps[i] = f->mapped;
+        fds[i] = f->dmabuf_fd;
+
+        TEST_ASSERT(memcmp(f->mapped, copied[i], sizeof(copied[i])) == 0,
+                    "mapping matches copied frame");
+
+        static uint8_t via_fd[W * H * 4];
+        TEST_ASSERT(pread(f->dmabuf_fd, via_fd, sizeof(via_fd), 0) == (ssize_t)sizeof(via_fd),
+                    "read through fd");
+        TEST_ASSERT(memcmp(via_fd, copied[i], sizeof(via_fd)) == 0, "fd matches copied frame");
+
+        uint8_t enc[W * H * 2 + 64];
+        size_t enc_size = 0;
+        TEST_ASSERT(rootstream_encode_frame_raw(ctx, f, enc, &enc_size) == 0,
+                    "encode fd-backed frame");
+        TEST_ASSERT(enc_size == enc_cpu_size[i] && enc_size > RAW_HEADER_LEN, "encoded size");
+        TEST_ASSERT(memcmp(enc, enc_cpu[i], RAW_TS_OFFSET) == 0 &&
+                        memcmp(enc + RAW_HEADER_LEN, enc_cpu[i] + RAW_HEADER_LEN,
+                               enc_size - RAW_HEADER_LEN) == 0,
+                    "encoder output identical apart from the timestamp");
+    }
+
+    /* Three buffers flipped round robin, each mapped once and reused */
+    for (int i = 3; i < FRAMES; i++) {
+        TEST_ASSERT(maps[i] == maps[i - 3] && fds[i] == fds[i - 3], "mapping reused after flip");
+    }
+    TEST_ASSERT(maps[0] != maps[1] && maps[1] != maps[2] && maps[0] != maps[2],
+                "three distinct buffers");
+
+    dummy_free(ctx);
+    TEST_PASS("dummy fd-backed frames: persistent mappings, identical pixels and output");
+    return 0;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_cache_lru();
+    failures += test_cache_owns_mapping();
+    failures += test_dummy_zero_copy();
+
+    printf("\n");
+    if (failures == 0)
+        printf("ALL FBCACHE TESTS PASSED\n");
+    else
+        printf("%d FBCACHE TEST(S) FAILED\n", failures);
+    return failures ? 1 : 0;
+}
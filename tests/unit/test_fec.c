@@ -1,14 +1,16 @@
 /*
  * test_fec.c — Unit tests for PHASE-64 FEC Encoder / Decoder
  *
- * Tests fec_matrix (covers/repair), fec_encoder (encode k=4 r=2),
- * and fec_decoder (recover 1 lost source, 2 lost sources, irrecoverable).
+ * Tests fec_gf (field identities, region kernels), fec_matrix
+ * (coefficients/repair), fec_encoder (encode k=4 r=2), and fec_decoder
+ * (recover 1 lost source, 2 lost sources, irrecoverable, k=100 r=20).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../../src/fec/fec_gf.h"
 #include "../../src/fec/fec_matrix.h"
 #include "../../src/fec/fec_encoder.h"
 #include "../../src/fec/fec_decoder.h"
@@ -28,20 +30,51 @@ static uint8_t *make_src(uint8_t fill) {
     return p;
 }
 
-static int test_matrix_covers(void) {
-    printf("\n=== test_matrix_covers ===\n");
-
-    /* repair_idx=0: src_idx % 2 == 0 → covers 0, 2, 4, ... */
-    TEST_ASSERT(fec_repair_covers(0, 0) == 1, "src0 covers repair0");
-    TEST_ASSERT(fec_repair_covers(2, 0) == 1, "src2 covers repair0");
-    TEST_ASSERT(fec_repair_covers(1, 0) == 0, "src1 does not cover repair0");
-
-    /* repair_idx=1: src_idx % 3 == 0 → covers 0, 3, 6, ... */
-    TEST_ASSERT(fec_repair_covers(0, 1) == 1, "src0 covers repair1");
-    TEST_ASSERT(fec_repair_covers(3, 1) == 1, "src3 covers repair1");
-    TEST_ASSERT(fec_repair_covers(1, 1) == 0, "src1 does not cover repair1");
+static int test_gf_arith(void) {
+    printf("\n=== test_gf_arith ===\n");
+
+    for (int a = 1; a < 256; a++) {
+        TEST_ASSERT(fec_gf_mul((uint8_t)a, fec_gf_inv((uint8_t)a)) == 1, "a * inv(a) == 1");
+        TEST_ASSERT(fec_gf_mul((uint8_t)a, 1) == a, "a * 1 == a");
+        TEST_ASSERT(fec_gf_mul((uint8_t)a, 0) == 0, "a * 0 == 0");
+    }
+    /* x^8 = x^4 + x^3 + x^2 + 1 */
+    TEST_ASSERT(fec_gf_mul(0x80, 0x02) == 0x1D, "reduction polynomial 0x11D");
+
+    /* Region kernels (SIMD body + scalar tail) match single products */
+    uint8_t src[77], dst[77], acc[77];
+    for (int i = 0; i < 77; i++) {
+        src[i] = (uint8_t)(i * 37 + 11);
+        acc[i] = (uint8_t)i;
+    }
+    fec_gf_mul_region(dst, src, 0x53, sizeof(src));
+    fec_gf_mul_add_region(acc, src, 0xCA, sizeof(src));
+    for (int i = 0; i < 77; i++) {
+        TEST_ASSERT(dst[i] == fec_gf_mul(src[i], 0x53), "mul_region matches fec_gf_mul");
+        TEST_ASSERT(acc[i] == ((uint8_t)i ^ fec_gf_mul(src[i], 0xCA)), "mul_add_region");
+    }
+
+    printf("  region kernel: %s\n", fec_gf_kernel_name());
+    TEST_PASS("fec_gf field arithmetic and region kernels");
+    return 0;
+}
 
-    TEST_PASS("fec_matrix covers pattern");
+static int test_matrix_coef(void) {
+    printf("\n=== test_matrix_coef ===\n");
+
+    /* Cauchy: 1 / (x_i + y_j), never zero; every repair covers every source */
+    for (int i = 0; i < FEC_MAX_R; i++) {
+        for (int j = 0; j < FEC_MAX_K; j++) {
+            uint8_t c = fec_matrix_coef(i, j);
+            TEST_ASSERT(c != 0, "coefficient non-zero");
+            TEST_ASSERT(fec_gf_mul(c, (uint8_t)(i ^ (FEC_MAX_R + j))) == 1, "1 / (x_i + y_j)");
+            TEST_ASSERT(fec_repair_covers(j, i) == 1, "repair covers source");
+        }
+    }
+    TEST_ASSERT(fec_matrix_coef(FEC_MAX_R, 0) == 0, "repair index out of range");
+    TEST_ASSERT(fec_matrix_coef(0, FEC_MAX_K) == 0, "source index out of range");
+
+    TEST_PASS("fec_matrix Cauchy coefficients");
     return 0;
 }
 
@@ -64,13 +97,13 @@ static int test_fec_encode(void) {
     for (int i = 0; i < K; i++)
         TEST_ASSERT(memcmp(out[i], srcs[i], PSZ) == 0, "source pass-through");
 
-    /* Repair[0] = XOR of src[0] and src[2] (both % 2 == 0 for R=2 covers) */
-    uint8_t expected_r0[PSZ];
-    memset(expected_r0, 0, PSZ);
+    /* Repair[1] = sum of coef(1, j) * src[j] */
+    uint8_t expected_r1[PSZ];
+    memset(expected_r1, 0, PSZ);
     for (int j = 0; j < K; j++)
-        if (fec_repair_covers(j, 0))
-            for (int b = 0; b < PSZ; b++) expected_r0[b] ^= srcs[j][b];
-    TEST_ASSERT(memcmp(out[K], expected_r0, PSZ) == 0, "repair[0] correct XOR");
+        for (int b = 0; b < PSZ; b++)
+            expected_r1[b] ^= fec_gf_mul(fec_matrix_coef(1, j), srcs[j][b]);
+    TEST_ASSERT(memcmp(out[K + 1], expected_r1, PSZ) == 0, "repair[1] correct combination");
 
     for (int i = 0; i < K + R; i++) free(out[i]);
     for (int i = 0; i < K; i++) free(srcs[i]);
@@ -88,7 +121,7 @@ static int test_fec_decode_one_loss(void) {
     for (int i = 0; i < K + R; i++) encoded[i] = malloc(PSZ);
     fec_encode((const uint8_t *const *)srcs, K, R, (uint8_t **)encoded, PSZ);
 
-    /* Simulate loss of src[0] (which is covered by both repair[0] and repair[1]) */
+    /* Simulate loss of src[0] */
     bool received[K + R];
     for (int i = 0; i < K + R; i++) received[i] = true;
     received[0] = false; /* lose src[0] */
@@ -117,13 +150,11 @@ static int test_fec_decode_irrecoverable(void) {
     for (int i = 0; i < K + R; i++) encoded[i] = malloc(PSZ);
     fec_encode((const uint8_t *const *)srcs, K, R, (uint8_t **)encoded, PSZ);
 
-    /* Lose src[1] AND src[3] — repair[0] covers 0,2 but not 1 or 3;
-     * no repair covers both → irrecoverable with XOR-only scheme */
+    /* Lose src[1] AND src[3] plus repair[1]: two unknowns, one repair */
     bool received[K + R];
     for (int i = 0; i < K + R; i++) received[i] = true;
     received[1] = false;
     received[3] = false;
-    /* Also lose repair[1] to ensure no single-step recovery is possible */
     received[K + 1] = false;
 
     uint8_t *recovered[K];
@@ -139,13 +170,87 @@ static int test_fec_decode_irrecoverable(void) {
     return 0;
 }
 
+static int test_fec_decode_two_losses(void) {
+    printf("\n=== test_fec_decode_two_losses ===\n");
+
+    uint8_t *srcs[K];
+    for (int i = 0; i < K; i++) srcs[i] = make_src((uint8_t)(0xD0 + i));
+
+    uint8_t *encoded[K + R];
+    for (int i = 0; i < K + R; i++) encoded[i] = malloc(PSZ);
+    fec_encode((const uint8_t *const *)srcs, K, R, (uint8_t **)encoded, PSZ);
+
+    /* Same pattern the old XOR matrix could not repair: src[1] and src[3] */
+    bool received[K + R];
+    for (int i = 0; i < K + R; i++) received[i] = true;
+    received[1] = false;
+    received[3] = false;
+
+    uint8_t *recovered[K];
+    for (int i = 0; i < K; i++) recovered[i] = malloc(PSZ);
+
+    int n = fec_decode((const uint8_t *const *)encoded, received,
+                        K, R, PSZ, (uint8_t **)recovered);
+    TEST_ASSERT(n == 2, "recovered 2 packets");
+    TEST_ASSERT(memcmp(recovered[1], srcs[1], PSZ) == 0, "src[1] correctly recovered");
+    TEST_ASSERT(memcmp(recovered[3], srcs[3], PSZ) == 0, "src[3] correctly recovered");
+
+    for (int i = 0; i < K; i++) { free(recovered[i]); free(srcs[i]); }
+    for (int i = 0; i < K + R; i++) free(encoded[i]);
+    TEST_PASS("fec_decode two packet recovery");
+    return 0;
+}
+
+static int test_fec_decode_large_group(void) {
+    printf("\n=== test_fec_decode_large_group ===\n");
+
+    enum { LK = 100, LR = 20, LSZ = 1200 };
+    uint8_t *srcs[LK], *encoded[LK + LR], *recovered[LK];
+    for (int i = 0; i < LK; i++) {
+        srcs[i] = malloc(LSZ);
+        recovered[i] = malloc(LSZ);
+        for (int b = 0; b < LSZ; b++) srcs[i][b] = (uint8_t)(i * 131 + b * 7);
+    }
+    for (int i = 0; i < LK + LR; i++) encoded[i] = malloc(LSZ);
+    int rc = fec_encode((const uint8_t *const *)srcs, LK, LR, (uint8_t **)encoded, LSZ);
+    TEST_ASSERT(rc == 0, "encode k=100 r=20 ok");
+
+    /* Lose 17 sources and 3 repairs: exactly 100 of 120 packets remain */
+    bool received[LK + LR];
+    for (int i = 0; i < LK + LR; i++) received[i] = true;
+    for (int i = 0; i < 17; i++) received[(i * 37 + 5) % LK] = false;
+    received[LK + 0] = received[LK + 7] = received[LK + 19] = false;
+
+    int n = fec_decode((const uint8_t *const *)encoded, received,
+                        LK, LR, LSZ, (uint8_t **)recovered);
+    TEST_ASSERT(n == 17, "recovered 17 packets");
+    for (int i = 0; i < LK; i++)
+        if (!received[i])
+            TEST_ASSERT(memcmp(recovered[i], srcs[i], LSZ) == 0, "large group source recovered");
+
+    /* One more repair lost: 18 unknowns, 17 repairs */
+    received[LK + 1] = false;
+    received[(17 * 37 + 5) % LK] = false;
+    n = fec_decode((const uint8_t *const *)encoded, received,
+                    LK, LR, LSZ, (uint8_t **)recovered);
+    TEST_ASSERT(n == 0, "too few packets → 0 recovered");
+
+    for (int i = 0; i < LK; i++) { free(recovered[i]); free(srcs[i]); }
+    for (int i = 0; i < LK + LR; i++) free(encoded[i]);
+    TEST_PASS("fec_decode k=100 r=20 MDS recovery");
+    return 0;
+}
+
 int main(void) {
     int failures = 0;
 
-    failures += test_matrix_covers();
+    failures += test_gf_arith();
+    failures += test_matrix_coef();
     failures += test_fec_encode();
     failures += test_fec_decode_one_loss();
+    failures += test_fec_decode_two_losses();
     failures += test_fec_decode_irrecoverable();
+    failures += test_fec_decode_large_group();
 
     printf("\n");
     if (failures == 0) printf("ALL FEC TESTS PASSED\n");
@@ -0,0 +1,233 @@
+/*
+ * test_handshake_replay.c — Replayed handshakes must not reopen a session
+ *
+ * Runs a host and a client context over loopback through the real
+ * receive path (src/network.c) and plays an on-path attacker: every
+ * datagram the client sends is read off the host's socket, recorded and
+ * then delivered from the client's address, so it can be delivered
+ * again later.  Checks that
+ *
+ *   - a replayed hello leaves the session alone (same key, same nonce
+ *     counters, same replay window) and the captured packets stay
+ *     rejected;
+ *   - a new handshake gives a new key, so packets captured under the
+ *     previous one no longer authenticate, and replaying the old hello
+ *     on top of that does not bring them back.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sodium.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../../include/rootstream.h"
+
+#define TEST_ASSERT(cond, msg) \
+    do { if (!(cond)) { fprintf(stderr, "FAIL: %s\n", (msg)); return 1; } } while (0)
+#define TEST_PASS(msg) printf("PASS: %s\n", (msg))
+
+#define CAPTURED_PACKETS 3
+
+/* ── Link stubs for modules the handshake path never reaches ─────── */
+
+void config_add_peer_to_history(rootstream_ctx_t *ctx, const char *code) {
+    (void)ctx; (void)code;
+}
+int peer_reconnect_init(peer_t *peer) { (void)peer; return 0; }
+int peer_try_reconnect(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; return -1; }
+void peer_reconnect_cleanup(peer_t *peer) { (void)peer; }
+int rootstream_input_process(rootstream_ctx_t *ctx, input_event_pkt_t *event) {
+    (void)ctx; (void)event; return 0;
+}
+int rootstream_input_process_batch(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *payload,
+                                   size_t len) {
+    (void)ctx; (void)peer; (void)payload; (void)len; return 0;
+}
+void rootstream_input_forget_peer(rootstream_ctx_t *ctx, peer_t *peer) { (void)ctx; (void)peer; }
+int rootstream_net_tcp_connect(rootstream_ctx_t *ctx, peer_t *peer) {
+    (void)ctx; (void)peer; return -1;
+}
+int rootstream_net_tcp_send(rootstream_ctx_t *ctx, peer_t *peer, const uint8_t *data,
+                            size_t size) {
+    (void)ctx; (void)peer; (void)data; (void)size; return -1;
+}
+int rootstream_net_tcp_recv(rootstream_ctx_t *ctx, peer_t *peer, uint8_t *buffer,
+                            size_t *buffer_len) {
+    (void)ctx; (void)peer; (void)buffer; (void)buffer_len; return -1;
+}
+void rootstream_net_tcp_cleanup(peer_t *peer) { (void)peer; }
+rs_socket_t rootstream_net_tcp_socket(const peer_t *peer) { (void)peer; return -1; }
+int rootstream_opus_decode(rootstream_ctx_t *ctx, const uint8_t *in, size_t in_len,
+                           int16_t *pcm, size_t *pcm_len) {
+    (void)ctx; (void)in; (void)in_len; (void)pcm; (void)pcm_len; return -1;
+}
+
+/* ── Host, client and the attacker's recordings ─────────────────── */
+
+static rootstream_ctx_t host, client;
+static struct sockaddr_in host_addr;
+
+typedef struct {
+    uint8_t data[MAX_PACKET_SIZE];
+    size_t len;
+} capture_t;
+
+static int open_loopback(rootstream_ctx_t *ctx, struct sockaddr_in *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family      = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(*addr);
+    ctx->sock_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (ctx->sock_fd < 0 || bind(ctx->sock_fd, (struct sockaddr *)addr, sizeof(*addr)) < 0 ||
+        getsockname(ctx->sock_fd, (struct sockaddr *)addr, &len) < 0) {
+        perror("loopback socket");
+        return -1;
+    }
+    return 0;
+}
+
+/* Record the next datagram the client sent to the host */
+static int intercept(capture_t *cap) {
+    struct pollfd pfd = {.fd = host.sock_fd, .events = POLLIN};
+    if (poll(&pfd, 1, 1000) != 1) return -1;
+    ssize_t n = recv(host.sock_fd, cap->data, sizeof(cap->data), 0);
+    if (n <= 0) return -1;
+    cap->len = (size_t)n;
+    return 0;
+}
+
+/* Send a recording from the client's address and let the host take it */
+static void deliver(const capture_t *cap) {
+    sendto(client.sock_fd, cap->data, cap->len, 0, (struct sockaddr *)&host_addr,
+           sizeof(host_addr));
+    rootstream_net_recv(&host, 100);
+}
+
+/* Client hello, recorded on the way; the client then takes the reply */
+static int handshake(capture_t *hello) {
+    if (rootstream_net_handshake(&client, &client.peers[0]) < 0) return -1;
+    if (intercept(hello) < 0) return -1;
+    deliver(hello);
+    rootstream_net_recv(&client, 100);
+    return 0;
+}
+
+/* Client sends keyframe requests; records them as they are delivered */
+static int send_captured(capture_t *caps, int n) {
+    for (int i = 0; i < n; i++) {
+        if (rootstream_request_keyframe(&client, &client.peers[0]) < 0) return -1;
+        if (intercept(&caps[i]) < 0) return -1;
+        deliver(&caps[i]);
+    }
+    return 0;
+}
+
+/* Drain everything queued at the host (the client's keyframe request) */
+static void settle(void) {
+    rootstream_net_recv(&host, 50);
+    rootstream_net_recv(&client, 50);
+}
+
+int main(void) {
+    if (sodium_init() < 0) { fprintf(stderr, "sodium_init failed\n"); return 1; }
+
+    struct sockaddr_in client_addr;
+    host.is_host = true;
+    TEST_ASSERT(crypto_generate_keypair(&host.keypair, "replay-host") == 0, "host keypair");
+    TEST_ASSERT(crypto_generate_keypair(&client.keypair, "replay-client") == 0,
+                "client keypair");
+    TEST_ASSERT(open_loopback(&host, &host_addr) == 0, "host socket");
+    TEST_ASSERT(open_loopback(&client, &client_addr) == 0, "client socket");
+
+    /* The client knows the host (as rootstream_add_peer() leaves it) */
+    peer_t *to_host = &client.peers[0];
+    client.num_peers = 1;
+    memcpy(to_host->public_key, host.keypair.public_key, CRYPTO_PUBLIC_KEY_BYTES);
+    memcpy(&to_host->addr, &host_addr, sizeof(host_addr));
+    to_host->addr_len = sizeof(host_addr);
+    to_host->state = PEER_DISCOVERED;
+    to_host->video_tx_frame_id = 1;
+
+    /* ── Session 1 ── */
+    capture_t hello1;
+    TEST_ASSERT(handshake(&hello1) == 0, "first handshake sent");
+    settle();
+    TEST_ASSERT(host.num_peers == 1, "host added the client");
+    peer_t *to_client = &host.peers[0];
+    TEST_ASSERT(to_client->state == PEER_CONNECTED, "host connected");
+    TEST_ASSERT(to_host->state == PEER_CONNECTED, "client connected");
+    TEST_ASSERT(memcmp(to_client->session.shared_key, to_host->session.shared_key,
+                       CRYPTO_SHARED_KEY_BYTES) == 0, "both sides derived the same key");
+
+    capture_t old[CAPTURED_PACKETS];
+    TEST_ASSERT(send_captured(old, CAPTURED_PACKETS) == 0, "captured session 1 packets");
+    uint64_t newest = to_client->rx_replay.newest;
+    uint64_t rejected = to_client->rx_replay.rejected;
+    for (int i = 0; i < CAPTURED_PACKETS; i++) deliver(&old[i]);
+    TEST_ASSERT(to_client->rx_replay.rejected == rejected + CAPTURED_PACKETS,
+                "replayed packets rejected");
+    TEST_PASS("session 1 rejects replayed packets");
+
+    /* ── Replayed hello: nothing may restart ── */
+    uint8_t key1[CRYPTO_SHARED_KEY_BYTES];
+    memcpy(key1, to_client->session.shared_key, sizeof(key1));
+    uint64_t host_tx = to_client->session.nonce_counter;
+    deliver(&hello1);
+    rootstream_net_recv(&client, 100); /* The repeated reply */
+    TEST_ASSERT(memcmp(key1, to_client->session.shared_key, sizeof(key1)) == 0,
+                "replayed hello keeps the key");
+    TEST_ASSERT(to_client->session.nonce_counter == host_tx,
+                "replayed hello keeps the host's nonce counter");
+    TEST_ASSERT(memcmp(key1, to_host->session.shared_key, sizeof(key1)) == 0,
+                "repeated reply keeps the client's key");
+    TEST_ASSERT(to_client->rx_replay.newest == newest, "replayed hello keeps the window");
+
+    rejected = to_client->rx_replay.rejected;
+    for (int i = 0; i < CAPTURED_PACKETS; i++) deliver(&old[i]);
+    TEST_ASSERT(to_client->rx_replay.rejected == rejected + CAPTURED_PACKETS,
+                "packets after a replayed hello rejected");
+    TEST_ASSERT(to_client->rx_replay.newest == newest, "no packet accepted twice");
+
+    capture_t fresh;
+    TEST_ASSERT(send_captured(&fresh, 1) == 0, "live packet sent");
+    TEST_ASSERT(to_client->rx_replay.newest == newest + 1, "session still live");
+    TEST_PASS("replayed hello does not reopen the replay window");
+
+    /* ── Session 2: the client reconnects ── */
+    to_host->state = PEER_DISCONNECTED;
+    capture_t hello2;
+    TEST_ASSERT(handshake(&hello2) == 0, "second handshake sent");
+    settle();
+    TEST_ASSERT(to_client->state == PEER_CONNECTED && to_host->state == PEER_CONNECTED,
+                "reconnected");
+    TEST_ASSERT(memcmp(key1, to_client->session.shared_key, sizeof(key1)) != 0,
+                "new handshake, new key");
+    TEST_ASSERT(memcmp(to_client->session.shared_key, to_host->session.shared_key,
+                       CRYPTO_SHARED_KEY_BYTES) == 0, "both sides derived the new key");
+
+    /* The new window is empty, but the old packets no longer authenticate */
+    newest = to_client->rx_replay.newest;
+    bool any = to_client->rx_replay.any;
+    for (int i = 0; i < CAPTURED_PACKETS; i++) deliver(&old[i]);
+    TEST_ASSERT(to_client->rx_replay.newest == newest && to_client->rx_replay.any == any,
+                "session 1 packets rejected by session 2");
+
+    /* Replaying the first hello forces yet another key, never the old one */
+    deliver(&hello1);
+    TEST_ASSERT(memcmp(key1, to_client->session.shared_key, sizeof(key1)) != 0,
+                "old hello does not restore the old key");
+    for (int i = 0; i < CAPTURED_PACKETS; i++) deliver(&old[i]);
+    TEST_ASSERT(!to_client->rx_replay.any, "old hello plus old packets rejected");
+    TEST_PASS("new handshake invalidates captured packets");
+
+    close(host.sock_fd);
+    close(client.sock_fd);
+    printf("All handshake replay tests passed.\n");
+    return 0;
+}
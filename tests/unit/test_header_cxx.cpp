@@ -0,0 +1,23 @@
+/*
+ * test_header_cxx.cpp - rootstream.h compiles as C++
+ *
+ * The KDE client includes the public header from C++; this keeps
+ * C-only constructs (_Atomic, atomic_bool, ...) out of the parts a C++
+ * compiler sees.
+ */
+
+#include "../../include/rootstream.h"
+
+#include <cstdio>
+#include <type_traits>
+
+static_assert(std::is_standard_layout<encoder_ctx_t>::value,
+              "encoder_ctx_t must stay a plain C struct");
+
+int main() {
+    encoder_ctx_t enc = {};
+    enc.bitrate = 1000000;
+    enc.force_keyframe = true;
+    printf("PASS: rootstream.h compiles as C++\n");
+    return enc.bitrate == 1000000 && enc.force_keyframe ? 0 : 1;
+}
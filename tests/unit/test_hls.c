@@ -1,11 +1,16 @@
 /*
  * test_hls.c — Unit tests for PHASE-44 HLS Segment Output
  *
- * Tests ts_writer (PAT/PMT/PES generation), m3u8_writer (live/VOD/master
- * manifests), and hls_segmenter (open/write/close/manifest lifecycle).
+ * Tests ts_writer (PAT/PMT/PES generation), m3u8_writer (live/VOD/master/
+ * low-latency manifests), hls_segmenter (open/write/close/manifest
+ * lifecycle), cmaf_writer (fMP4 boxes) and llhls_packager (part timing
+ * and blocking reloads).
  * Uses /tmp for file I/O; no video hardware required.
  */
 
+#define _GNU_SOURCE /* memmem */
+#include <pthread.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,6 +22,8 @@
 #include "../../src/hls/ts_writer.h"
 #include "../../src/hls/m3u8_writer.h"
 #include "../../src/hls/hls_segmenter.h"
+#include "../../src/hls/cmaf_writer.h"
+#include "../../src/hls/llhls_packager.h"
 
 /* ── Test macros ─────────────────────────────────────────────────── */
 
@@ -129,6 +136,167 @@ static int test_ts_writer_null_guards(void) {
     return 0;
 }
 
+static uint32_t crc32_bitwise(const uint8_t *d, size_t n) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= (uint32_t)d[i] << 24;
+        for (int b = 0; b < 8; b++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+    }
+    return crc;
+}
+
+static int test_ts_crc32(void) {
+    printf("\n=== test_ts_crc32 ===\n");
+
+    TEST_ASSERT(ts_crc32_mpeg((const uint8_t *)"123456789", 9) == 0x0376E6E7,
+                "CRC-32/MPEG-2 check value");
+
+    uint8_t buf[300];
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 167 + 13);
+    for (size_t off = 0; off < 8; off++) {
+        for (size_t n = 0; n + off <= sizeof(buf); n += 7) {
+            TEST_ASSERT(ts_crc32_mpeg(buf + off, n) == crc32_bitwise(buf + off, n),
+                        "slicing-by-8 matches bitwise CRC");
+        }
+    }
+
+    TEST_PASS("ts_crc32_mpeg matches reference");
+    return 0;
+}
+
+static uint64_t read_timestamp(const uint8_t *p) {
+    return ((uint64_t)(p[0] & 0x0E) << 29) | ((uint64_t)p[1] << 22) |
+           ((uint64_t)(p[2] & 0xFE) << 14) | ((uint64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+static int test_ts_writer_av(void) {
+    printf("\n=== test_ts_writer_av ===\n");
+
+    const char *path = "/tmp/test_ts_av.ts";
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TEST_ASSERT(fd >= 0, "temp file");
+    ts_writer_config_t cfg = {.video_type = TS_STREAM_H264, .audio_type = TS_STREAM_AAC};
+    ts_writer_t *w = ts_writer_create_ex(fd, &cfg);
+    TEST_ASSERT(w != NULL, "A/V writer created");
+
+    uint8_t video[1000], audio[300];
+    memset(video, 0xAB, sizeof(video));
+    memset(audio, 0xCD, sizeof(audio));
+    TEST_ASSERT(ts_writer_write_pat_pmt(w) == 0, "PAT/PMT");
+    TEST_ASSERT(ts_writer_write_video(w, video, sizeof(video), 93003, 90000, true) == 0,
+                "video with DTS");
+    TEST_ASSERT(ts_writer_write_audio(w, audio, sizeof(audio), 90000) == 0, "audio");
+    TEST_ASSERT(ts_writer_write_video(w, video, 10, 96006, 93003, false) == 0,
+                "second video");
+    TEST_ASSERT(ts_writer_write_video(w, video, 10, 1, 2, false) == -1, "DTS > PTS rejected");
+    TEST_ASSERT(ts_writer_flush(w) == 0, "flush");
+    size_t total = ts_writer_bytes_written(w);
+    ts_writer_destroy(w);
+    close(fd);
+
+    static uint8_t ts[16 * HLS_TS_PACKET_SZ];
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT(f != NULL, "file readable");
+    size_t n = fread(ts, 1, sizeof(ts), f);
+    fclose(f);
+    remove(path);
+    TEST_ASSERT(n == total && n % HLS_TS_PACKET_SZ == 0, "file holds every packet");
+
+    uint8_t cc[0x2000];
+    memset(cc, 0xFF, sizeof(cc));
+    int video_starts = 0, audio_starts = 0;
+    for (size_t off = 0; off < n; off += HLS_TS_PACKET_SZ) {
+        const uint8_t *p = ts + off;
+        TEST_ASSERT(p[0] == HLS_TS_SYNC_BYTE, "sync byte");
+        int pid = ((p[1] & 0x1F) << 8) | p[2];
+        bool pusi = p[1] & 0x40;
+        TEST_ASSERT((p[3] & 0xC0) == 0, "not scrambled");
+        if (cc[pid] != 0xFF)
+            TEST_ASSERT((p[3] & 0x0F) == ((cc[pid] + 1) & 0x0F), "continuity counter");
+        cc[pid] = p[3] & 0x0F;
+
+        const uint8_t *payload = p + 4;
+        if (p[3] & 0x20)
+            payload += 1 + p[4];
+
+        if (pid == 0 || pid == TS_PMT_PID) {
+            const uint8_t *sec = payload + 1;
+            size_t sec_len = (size_t)(((sec[1] & 0x0F) << 8) | sec[2]) + 3;
+            TEST_ASSERT(ts_crc32_mpeg(sec, sec_len) == 0, "PSI CRC valid");
+            if (pid == TS_PMT_PID) {
+                TEST_ASSERT(sec_len == 12 + 10 + 4, "PMT lists two streams");
+                TEST_ASSERT(sec[12] == TS_STREAM_H264 && sec[17] == TS_STREAM_AAC,
+                            "PMT stream types");
+            }
+        } else if (pid == TS_VIDEO_PID && pusi) {
+            TEST_ASSERT(payload[3] == 0xE0, "video stream_id");
+            if (video_starts++ == 0) {
+                TEST_ASSERT((p[3] & 0x20) && (p[5] & 0x40), "keyframe has RAI");
+                TEST_ASSERT(p[5] & 0x10, "keyframe carries PCR");
+                uint64_t pcr = ((uint64_t)p[6] << 25) | ((uint64_t)p[7] << 17) |
+                               ((uint64_t)p[8] << 9) | ((uint64_t)p[9] << 1) | (p[10] >> 7);
+                TEST_ASSERT(pcr == 90000 - TS_PCR_LEAD_90KHZ, "PCR trails DTS");
+                TEST_ASSERT(payload[7] == 0xC0 && payload[8] == 10, "PTS+DTS flags");
+                TEST_ASSERT((payload[9] >> 4) == 0x3 && (payload[14] >> 4) == 0x1,
+                            "PTS/DTS prefixes");
+                TEST_ASSERT(read_timestamp(payload + 9) == 93003, "PTS value");
+                TEST_ASSERT(read_timestamp(payload + 14) == 90000, "DTS value");
+            } else {
+                TEST_ASSERT(!(p[3] & 0x20) || !(p[5] & 0x10), "no PCR within 40 ms");
+            }
+        } else if (pid == TS_AUDIO_PID && pusi) {
+            audio_starts++;
+            TEST_ASSERT(payload[3] == 0xC0, "audio stream_id");
+            TEST_ASSERT(((payload[4] << 8) | payload[5]) == 3 + 5 + 300, "bounded PES length");
+            TEST_ASSERT(read_timestamp(payload + 9) == 90000, "audio PTS");
+        }
+    }
+    TEST_ASSERT(video_starts == 2 && audio_starts == 1, "PES count per PID");
+
+    ts_writer_t *vo = ts_writer_create(fd);
+    TEST_ASSERT(ts_writer_write_audio(vo, audio, sizeof(audio), 0) == -1,
+                "audio on video-only writer rejected");
+    ts_writer_destroy(vo);
+
+    TEST_PASS("ts_writer PCR/PTS/DTS and A/V muxing");
+    return 0;
+}
+
+static int test_ts_writer_buffering(void) {
+    printf("\n=== test_ts_writer_buffering ===\n");
+
+    const char *path = "/tmp/test_ts_buf.ts";
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TEST_ASSERT(fd >= 0, "temp file");
+    ts_writer_config_t cfg = {.flush_bytes = 8 * HLS_TS_PACKET_SZ};
+    ts_writer_t *w = ts_writer_create_ex(fd, &cfg);
+
+    uint8_t nal[500] = {0};
+    ts_writer_write_pat_pmt(w);
+    ts_writer_write_pes(w, nal, sizeof(nal), 0, true);
+    struct stat st;
+    fstat(fd, &st);
+    TEST_ASSERT(st.st_size == 0, "packets stay buffered below flush size");
+
+    for (int i = 0; i < 4; i++)
+        ts_writer_write_pes(w, nal, sizeof(nal), (uint64_t)i * 3000, false);
+    fstat(fd, &st);
+    TEST_ASSERT(st.st_size > 0 && st.st_size % (8 * HLS_TS_PACKET_SZ) == 0,
+                "full buffers written in one piece");
+
+    TEST_ASSERT(ts_writer_flush(w) == 0, "flush");
+    fstat(fd, &st);
+    TEST_ASSERT((size_t)st.st_size == ts_writer_bytes_written(w), "flush writes the rest");
+
+    ts_writer_destroy(w);
+    close(fd);
+    remove(path);
+    TEST_PASS("ts_writer buffers and flushes whole packets");
+    return 0;
+}
+
 /* ── m3u8_writer tests ───────────────────────────────────────────── */
 
 static int test_m3u8_live(void) {
@@ -317,6 +485,436 @@ static int test_segmenter_vod(void) {
     return 0;
 }
 
+static bool file_exists(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static int test_segmenter_atomic_publish(void) {
+    printf("\n=== test_segmenter_atomic_publish ===\n");
+
+    hls_segmenter_config_t cfg = {0};
+    snprintf(cfg.output_dir,    sizeof(cfg.output_dir),    "%s", TMP_DIR);
+    snprintf(cfg.base_name,     sizeof(cfg.base_name),     "hls_at_seg_");
+    snprintf(cfg.playlist_name, sizeof(cfg.playlist_name), "hls_at.m3u8");
+
+    hls_segmenter_t *seg = hls_segmenter_create(&cfg);
+    TEST_ASSERT(seg != NULL, "segmenter created");
+    TEST_ASSERT(hls_segmenter_open_segment(seg) == 0, "open segment");
+    uint8_t nal[256] = {0};
+    hls_segmenter_write(seg, nal, sizeof(nal), 0ULL, true);
+
+    char seg_path[HLS_MAX_PATH + HLS_MAX_SEG_NAME + 2];
+    char tmp_path[HLS_MAX_PATH + HLS_MAX_SEG_NAME + 8];
+    snprintf(seg_path, sizeof(seg_path), "%s/hls_at_seg_0.ts", TMP_DIR);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/hls_at_seg_0.ts.tmp", TMP_DIR);
+    TEST_ASSERT(!file_exists(seg_path), "open segment not yet published");
+    TEST_ASSERT(file_exists(tmp_path), "open segment written to .tmp");
+
+    TEST_ASSERT(hls_segmenter_close_segment(seg, 2.0) == 0, "close segment");
+    TEST_ASSERT(file_exists(seg_path), "closed segment published");
+    TEST_ASSERT(!file_exists(tmp_path), "temporary file renamed");
+
+    /* A segment open at destroy time is discarded, not published */
+    hls_segmenter_open_segment(seg);
+    hls_segmenter_destroy(seg);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/hls_at_seg_1.ts.tmp", TMP_DIR);
+    TEST_ASSERT(!file_exists(tmp_path), "abandoned segment removed");
+
+    remove(seg_path);
+    TEST_PASS("hls_segmenter publishes segments atomically");
+    return 0;
+}
+
+static int test_segmenter_multi_rendition(void) {
+    printf("\n=== test_segmenter_multi_rendition ===\n");
+
+    static const char *names[] = {"1080p", "720p", "480p"};
+    hls_segmenter_config_t cfg = {0};
+    snprintf(cfg.output_dir,    sizeof(cfg.output_dir),    "%s", TMP_DIR);
+    snprintf(cfg.base_name,     sizeof(cfg.base_name),     "hls_mr_");
+    snprintf(cfg.playlist_name, sizeof(cfg.playlist_name), "hls_mr_master.m3u8");
+    cfg.with_audio = true;
+    cfg.rendition_count = 3;
+    for (int r = 0; r < 3; r++) {
+        snprintf(cfg.renditions[r].name, sizeof(cfg.renditions[r].name), "%s", names[r]);
+        cfg.renditions[r].bandwidth_bps = 6000000 >> r;
+    }
+
+    hls_segmenter_t *seg = hls_segmenter_create(&cfg);
+    TEST_ASSERT(seg != NULL, "3-rung segmenter created");
+
+    static uint8_t video[3][40000]; /* large enough to be muxed in parallel */
+    uint8_t audio[200] = {0};
+    for (int s = 0; s < 2; s++) {
+        TEST_ASSERT(hls_segmenter_open_segment(seg) == 0, "open on every rung");
+        for (int i = 0; i < 30; i++) {
+            uint64_t pts = (uint64_t)(s * 30 + i) * 3000;
+            hls_frame_t frames[6];
+            int n = 0;
+            for (int r = 0; r < 3; r++) {
+                frames[n++] = (hls_frame_t){.rendition = r, .data = video[r],
+                                            .len = sizeof(video[r]) >> r, .pts_90khz = pts,
+                                            .dts_90khz = pts, .is_kf = i == 0};
+                frames[n++] = (hls_frame_t){.rendition = r, .data = audio, .len = sizeof(audio),
+                                            .pts_90khz = pts, .is_audio = true};
+            }
+            TEST_ASSERT(hls_segmenter_write_frames(seg, frames, n) == 0, "write all rungs");
+        }
+        TEST_ASSERT(hls_segmenter_close_segment(seg, 1.0) == 0, "close on every rung");
+    }
+    hls_frame_t bad = {.rendition = 3, .data = audio, .len = 1};
+    TEST_ASSERT(hls_segmenter_write_frames(seg, &bad, 1) == -1, "closed segmenter rejects");
+    TEST_ASSERT(hls_segmenter_segment_count(seg) == 2, "2 segments per rung");
+    TEST_ASSERT(hls_segmenter_update_manifest(seg) == 0, "manifests written");
+
+    char path[HLS_MAX_PATH + HLS_MAX_SEG_NAME + 2];
+    off_t prev_size = 0;
+    for (int r = 0; r < 3; r++) {
+        for (int s = 0; s < 2; s++) {
+            struct stat st;
+            snprintf(path, sizeof(path), "%s/hls_mr_%s_%d.ts", TMP_DIR, names[r], s);
+            TEST_ASSERT(stat(path, &st) == 0, "rung segment exists");
+            TEST_ASSERT(st.st_size % HLS_TS_PACKET_SZ == 0, "rung segment whole packets");
+            if (s == 0) {
+                TEST_ASSERT(r == 0 || st.st_size < prev_size, "lower rung is smaller");
+                prev_size = st.st_size;
+            }
+            remove(path);
+        }
+        snprintf(path, sizeof(path), "%s/%s.m3u8", TMP_DIR, names[r]);
+        FILE *f = fopen(path, "r");
+        TEST_ASSERT(f != NULL, "rung playlist exists");
+        char contents[4096] = {0};
+        fread(contents, 1, sizeof(contents) - 1, f);
+        fclose(f);
+        char want[64];
+        snprintf(want, sizeof(want), "hls_mr_%s_1.ts", names[r]);
+        TEST_ASSERT(strstr(contents, want) != NULL, "rung playlist lists its segments");
+        remove(path);
+    }
+
+    snprintf(path, sizeof(path), "%s/hls_mr_master.m3u8", TMP_DIR);
+    FILE *f = fopen(path, "r");
+    TEST_ASSERT(f != NULL, "master playlist exists");
+    char contents[4096] = {0};
+    fread(contents, 1, sizeof(contents) - 1, f);
+    fclose(f);
+    TEST_ASSERT(strstr(contents, "BANDWIDTH=6000000") && strstr(contents, "720p.m3u8") &&
+                    strstr(contents, "480p.m3u8"),
+                "master lists every rung");
+    remove(path);
+
+    hls_segmenter_destroy(seg);
+    TEST_PASS("hls_segmenter writes a 3-rung ladder in parallel");
+    return 0;
+}
+
+/* ── cmaf_writer tests ───────────────────────────────────────────── */
+
+static const uint8_t SPS[] = {0x67, 0x64, 0x00, 0x28, 0xAC, 0xD9, 0x40, 0x78};
+static const uint8_t PPS[] = {0x68, 0xEB, 0xE3, 0xCB};
+
+static uint32_t rd32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+/* Synthetic Annex B access unit; keyframes carry SPS + PPS + IDR */
+static size_t make_au(uint8_t *buf, bool kf, size_t payload) {
+    static const uint8_t sc[4] = {0, 0, 0, 1};
+    size_t n = 0;
+    if (kf) {
+        memcpy(buf + n, sc, 4);
+        memcpy(buf + n + 4, SPS, sizeof(SPS));
+        n += 4 + sizeof(SPS);
+        memcpy(buf + n, sc + 1, 3); /* 3-byte start code */
+        memcpy(buf + n + 3, PPS, sizeof(PPS));
+        n += 3 + sizeof(PPS);
+    }
+    memcpy(buf + n, sc, 4);
+    n += 4;
+    buf[n++] = kf ? 0x65 : 0x41;
+    memset(buf + n, 0xAB, payload);
+    return n + payload;
+}
+
+/* One ADTS frame (AAC-LC, 48 kHz, stereo, no CRC) */
+static size_t make_adts(uint8_t *buf, size_t payload) {
+    size_t len = 7 + payload;
+    buf[0] = 0xFF;
+    buf[1] = 0xF1;
+    buf[2] = (1 << 6) | (3 << 2);
+    buf[3] = (uint8_t)((2 << 6) | (len >> 11));
+    buf[4] = (uint8_t)(len >> 3);
+    buf[5] = (uint8_t)(((len & 7) << 5) | 0x1F);
+    buf[6] = 0xFC;
+    memset(buf + 7, 0x21, payload);
+    return len;
+}
+
+static int test_cmaf_annexb_to_avcc(void) {
+    printf("\n=== test_cmaf_annexb_to_avcc ===\n");
+
+    uint8_t au[64], out[128];
+    size_t len = make_au(au, true, 10);
+    size_t nal_len = 0;
+    const uint8_t *sps = cmaf_find_nal(au, len, 7, &nal_len);
+    TEST_ASSERT(sps && nal_len == sizeof(SPS) && memcmp(sps, SPS, nal_len) == 0, "finds SPS");
+    const uint8_t *pps = cmaf_find_nal(au, len, 8, &nal_len);
+    TEST_ASSERT(pps && nal_len == sizeof(PPS), "finds PPS after 3-byte start code");
+    TEST_ASSERT(cmaf_find_nal(au, len, 6, &nal_len) == NULL, "absent SEI not found");
+
+    int n = cmaf_annexb_to_avcc(au, len, out, sizeof(out));
+    TEST_ASSERT(n == 4 + 11, "only the IDR slice remains");
+    TEST_ASSERT(rd32(out) == 11 && out[4] == 0x65, "4-byte length prefix");
+    TEST_ASSERT(cmaf_annexb_to_avcc(au, len, out, 8) == -1, "small output rejected");
+
+    TEST_PASS("Annex B to AVCC conversion");
+    return 0;
+}
+
+static int test_cmaf_boxes(void) {
+    printf("\n=== test_cmaf_boxes ===\n");
+
+    cmaf_init_config_t icfg = {.width = 1920, .height = 1080, .sps = SPS, .sps_len = sizeof(SPS),
+                               .pps = PPS, .pps_len = sizeof(PPS), .has_audio = true,
+                               .audio_sample_rate = 48000, .audio_channels = 2};
+    uint8_t init[2048];
+    int n = cmaf_write_init(&icfg, init, sizeof(init));
+    TEST_ASSERT(n > 0, "init section written");
+    TEST_ASSERT(memcmp(init + 4, "ftyp", 4) == 0, "starts with ftyp");
+    uint32_t ftyp = rd32(init);
+    TEST_ASSERT(memcmp(init + ftyp + 4, "moov", 4) == 0, "moov follows");
+    TEST_ASSERT(ftyp + rd32(init + ftyp) == (uint32_t)n, "boxes cover the output");
+    TEST_ASSERT(memmem(init, (size_t)n, "avcC", 4) && memmem(init, (size_t)n, "esds", 4),
+                "video and audio sample entries");
+    TEST_ASSERT(cmaf_write_init(&icfg, init, 100) == -1, "small buffer rejected");
+
+    uint8_t data[3][100];
+    memset(data, 0x11, sizeof(data));
+    cmaf_sample_t v[2] = {{data[0], 100, 1500, 3000, true}, {data[1], 60, 1500, 0, false}};
+    cmaf_sample_t a[1] = {{data[2], 40, 1024, 0, true}};
+    cmaf_track_run_t runs[2] = {{CMAF_VIDEO_TRACK_ID, 90000, v, 2},
+                                {CMAF_AUDIO_TRACK_ID, 48000, a, 1}};
+    size_t want = cmaf_fragment_size(runs, 2);
+    TEST_ASSERT(want == 24 + (64 + 32) + (64 + 16) + 8 + 200, "fragment size");
+    uint8_t frag[512];
+    n = cmaf_write_fragment(1, runs, 2, frag, sizeof(frag));
+    TEST_ASSERT(n == (int)want, "writes the predicted size");
+    uint32_t moof = rd32(frag);
+    TEST_ASSERT(memcmp(frag + 4, "moof", 4) == 0 && memcmp(frag + moof + 4, "mdat", 4) == 0,
+                "moof then mdat");
+    TEST_ASSERT(rd32(frag + moof) == 8 + 200, "mdat holds every sample");
+    const uint8_t *trun = memmem(frag, moof, "trun", 4);
+    TEST_ASSERT(trun && rd32(trun + 8) == 2 && rd32(trun + 12) == moof + 8,
+                "video data offset points into mdat");
+    TEST_ASSERT(cmaf_write_fragment(1, runs, 2, frag, want - 1) == -1, "small buffer rejected");
+
+    TEST_PASS("cmaf init section and fragment layout");
+    return 0;
+}
+
+/* ── llhls_packager tests ────────────────────────────────────────── */
+
+#define LL_FRAME_90K 1500 /* 60 fps */
+#define LL_GOP 120
+
+typedef struct {
+    llhls_packager_t *p;
+    int next_frame;    /* Writer position */
+    uint64_t audio_pts; /* Next AAC frame */
+} ll_feed_t;
+
+static int ll_feed(ll_feed_t *f, int frames) {
+    static uint8_t au[4096], adts[512];
+    for (int i = 0; i < frames; i++, f->next_frame++) {
+        int k = f->next_frame;
+        uint64_t dts = (uint64_t)k * LL_FRAME_90K;
+        size_t len = make_au(au, k % LL_GOP == 0, k % LL_GOP == 0 ? 3000 : 800);
+        if (llhls_write_video(f->p, au, len, dts, dts, k % LL_GOP == 0) != 0)
+            return -1;
+        /* 1024-sample AAC frames at 48 kHz are 1920 ticks of 90 kHz */
+        for (; f->audio_pts < dts + LL_FRAME_90K; f->audio_pts += 1920) {
+            size_t alen = make_adts(adts, 200);
+            if (llhls_write_audio(f->p, adts, alen, f->audio_pts) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static llhls_packager_t *ll_create(void) {
+    llhls_config_t cfg = {.width = 1280, .height = 720, .with_audio = true, .window_size = 10};
+    snprintf(cfg.base_name, sizeof(cfg.base_name), "ll_");
+    snprintf(cfg.playlist_name, sizeof(cfg.playlist_name), "live.m3u8");
+    return llhls_create(&cfg);
+}
+
+static int test_m3u8_ll_live(void) {
+    printf("\n=== test_m3u8_ll_live ===\n");
+
+    hls_part_t parts[2] = {{"s1.0.m4s", 0.2, true}, {"s1.1.m4s", 0.2, false}};
+    hls_ll_segment_t segs[3] = {
+        {{"s0.m4s", 2.0, false}, NULL, 0},
+        {{"s1.m4s", 2.0, false}, parts, 2},
+        {{"", 0.0, false}, parts, 1},
+    };
+    hls_ll_playlist_t pl = {.segs = segs, .n_segs = 3, .last_open = true, .media_seq = 4,
+                            .target_dur_s = 2, .part_target_s = 0.2, .map_uri = "init.mp4",
+                            .preload_uri = "s2.1.m4s"};
+    char buf[4096];
+    int n = m3u8_write_ll_live(&pl, buf, sizeof(buf));
+    TEST_ASSERT(n > 0, "ll playlist written");
+    TEST_ASSERT(strstr(buf, "#EXT-X-VERSION:9"), "version 9");
+    TEST_ASSERT(strstr(buf, "CAN-BLOCK-RELOAD=YES,CAN-SKIP-UNTIL=12.0,PART-HOLD-BACK=0.600"),
+                "server control");
+    TEST_ASSERT(strstr(buf, "#EXT-X-PART-INF:PART-TARGET=0.200"), "part target");
+    TEST_ASSERT(strstr(buf, "#EXT-X-MAP:URI=\"init.mp4\""), "init section");
+    TEST_ASSERT(strstr(buf, "#EXT-X-PART:DURATION=0.20000,URI=\"s1.0.m4s\",INDEPENDENT=YES"),
+                "independent part");
+    const char *last_inf = strstr(buf, "s1.m4s");
+    TEST_ASSERT(last_inf && strstr(last_inf, "#EXTINF") == NULL, "open segment has no EXTINF");
+    TEST_ASSERT(strstr(buf, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"s2.1.m4s\""), "preload hint");
+    TEST_ASSERT(strstr(buf, "#EXT-X-SKIP") == NULL, "no skip by default");
+
+    pl.skip = 1;
+    n = m3u8_write_ll_live(&pl, buf, sizeof(buf));
+    TEST_ASSERT(n > 0 && strstr(buf, "#EXT-X-SKIP:SKIPPED-SEGMENTS=1"), "delta update");
+    TEST_ASSERT(strstr(buf, "s0.m4s") == NULL && strstr(buf, "#EXT-X-MEDIA-SEQUENCE:4"),
+                "skipped segment omitted, sequence kept");
+    TEST_ASSERT(m3u8_write_ll_live(&pl, buf, 64) == -1, "small buffer rejected");
+
+    TEST_PASS("m3u8 low-latency playlist");
+    return 0;
+}
+
+static int test_llhls_timing(void) {
+    printf("\n=== test_llhls_timing ===\n");
+
+    llhls_packager_t *p = ll_create();
+    TEST_ASSERT(p != NULL, "packager created");
+    llhls_response_t res;
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_init.mp4", 0, &res) == 404,
+                "no init before the first keyframe");
+
+    ll_feed_t f = {p, 0, 0};
+    TEST_ASSERT(ll_feed(&f, 60 * 24 + 1) == 0, "24 s of 60 fps A/V");
+    int64_t msn;
+    int part;
+    llhls_get_position(p, &msn, &part);
+    TEST_ASSERT(msn == 12 && part == 0, "2 s segments, open segment 12 has no parts yet");
+
+    TEST_ASSERT(llhls_handle_request(p, "/hls/live.m3u8", 0, &res) == 200, "playlist served");
+    TEST_ASSERT(strcmp(res.content_type, "application/vnd.apple.mpegurl") == 0, "playlist type");
+    char pl[16384] = {0};
+    memcpy(pl, res.data, res.len < sizeof(pl) - 1 ? res.len : sizeof(pl) - 1);
+    llhls_response_release(&res);
+    TEST_ASSERT(strstr(pl, "#EXT-X-MEDIA-SEQUENCE:2"), "window of 10 complete segments");
+    TEST_ASSERT(strstr(pl, "#EXTINF:2.00000,\nll_11.m4s"), "segment duration 2 s");
+    TEST_ASSERT(strstr(pl, "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"ll_12.0.m4s\""), "preload hint");
+    TEST_ASSERT(strstr(pl, "ll_11.9.m4s") && !strstr(pl, "ll_11.10.m4s"), "10 parts a segment");
+    TEST_ASSERT(strstr(pl, "ll_11.0.m4s\",INDEPENDENT=YES"), "first part independent");
+    TEST_ASSERT(strstr(pl, "ll_8.0.m4s") && !strstr(pl, "ll_7.0.m4s"),
+                "old segments lose their parts");
+    for (const char *s = pl; (s = strstr(s, "#EXT-X-PART:DURATION=")) != NULL; s++)
+        TEST_ASSERT(atof(s + 21) > 0.0 && atof(s + 21) <= 0.2 + 1e-9, "part <= 200 ms");
+
+    TEST_ASSERT(llhls_handle_request(p, "live.m3u8?_HLS_msn=11&_HLS_skip=YES", 0, &res) == 200,
+                "delta playlist");
+    memcpy(pl, res.data, res.len < sizeof(pl) - 1 ? res.len : sizeof(pl) - 1);
+    pl[res.len < sizeof(pl) - 1 ? res.len : sizeof(pl) - 1] = '\0';
+    llhls_response_release(&res);
+    TEST_ASSERT(strstr(pl, "#EXT-X-SKIP:SKIPPED-SEGMENTS=4") && !strstr(pl, "ll_5.m4s"),
+                "delta skips the oldest segments");
+    TEST_ASSERT(strstr(pl, "ll_6.m4s"), "delta keeps the newest segments");
+
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_11.3.m4s", 0, &res) == 200, "part served");
+    TEST_ASSERT(strcmp(res.content_type, "video/mp4") == 0 && memcmp(res.data + 4, "moof", 4) == 0,
+                "part is moof + mdat");
+    const uint8_t *traf = memmem(res.data, res.len, "traf", 4);
+    TEST_ASSERT(traf && memmem(traf + 4, res.len - (size_t)(traf + 4 - res.data), "traf", 4),
+                "part carries video and audio");
+    llhls_response_release(&res);
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_11.m4s", 0, &res) == 200, "segment served");
+    TEST_ASSERT(memcmp(res.data + 4, "moof", 4) == 0, "segment is fragments");
+    llhls_response_t init;
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_init.mp4", 0, &init) == 200, "init served");
+    TEST_ASSERT(memcmp(init.data + 4, "ftyp", 4) == 0, "init is ftyp + moov");
+    llhls_response_release(&init);
+
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_1.m4s", 0, &init) == 404, "evicted segment");
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_12.m4s", 0, &init) == 404, "open segment");
+    TEST_ASSERT(llhls_handle_request(p, "/hls/ll_12.5.m4s", 0, &init) == 404, "unhinted part");
+    TEST_ASSERT(llhls_handle_request(p, "/hls/other.m4s", 0, &init) == 404, "unknown name");
+    TEST_ASSERT(llhls_handle_request(p, "live.m3u8?_HLS_part=1", 0, &init) == 400,
+                "part without msn");
+    TEST_ASSERT(llhls_handle_request(p, "live.m3u8?_HLS_msn=15", 0, &init) == 400,
+                "msn too far ahead");
+    TEST_ASSERT(llhls_handle_request(p, "live.m3u8?_HLS_msn=13", 50, &init) == 503,
+                "blocking reload times out");
+
+    llhls_destroy(p);
+    TEST_ASSERT(res.len > 0 && memcmp(res.data + 4, "moof", 4) == 0,
+                "responses outlive the packager");
+    llhls_response_release(&res);
+    TEST_PASS("llhls_packager part and segment timing");
+    return 0;
+}
+
+typedef struct {
+    ll_feed_t *feed;
+    int frames;
+} ll_writer_arg_t;
+
+static void *ll_writer(void *arg) {
+    ll_writer_arg_t *w = arg;
+    for (int i = 0; i < w->frames; i++) {
+        ll_feed(w->feed, 1);
+        usleep(1000);
+    }
+    return NULL;
+}
+
+static int test_llhls_blocking_reload(void) {
+    printf("\n=== test_llhls_blocking_reload ===\n");
+
+    llhls_packager_t *p = ll_create();
+    TEST_ASSERT(p != NULL, "packager created");
+    ll_feed_t f = {p, 0, 0};
+    TEST_ASSERT(ll_feed(&f, 125) == 0, "first segment and a frame");
+    int64_t msn;
+    int part;
+    llhls_get_position(p, &msn, &part);
+    TEST_ASSERT(msn == 1 && part == 0, "segment 0 complete");
+
+    /* Both requests name the part the writer has not produced yet */
+    ll_writer_arg_t arg = {&f, 40};
+    pthread_t th;
+    pthread_create(&th, NULL, ll_writer, &arg);
+    llhls_response_t pl, hinted;
+    int st_pl = llhls_handle_request(p, "live.m3u8?_HLS_msn=1&_HLS_part=1", 5000, &pl);
+    int st_part = llhls_handle_request(p, "ll_1.1.m4s", 5000, &hinted);
+    pthread_join(th, NULL);
+
+    TEST_ASSERT(st_pl == 200, "blocking reload released by the writer");
+    TEST_ASSERT(pl.len > 0 && memmem(pl.data, pl.len, "ll_1.1.m4s\"\n", 11),
+                "playlist lists the awaited part");
+    TEST_ASSERT(st_part == 200 && memcmp(hinted.data + 4, "moof", 4) == 0,
+                "preload-hinted part delivered when complete");
+    llhls_response_release(&pl);
+    llhls_response_release(&hinted);
+
+    /* A part past the end of a segment resolves to the next one's first */
+    TEST_ASSERT(ll_feed(&f, 120) == 0, "second segment");
+    TEST_ASSERT(llhls_handle_request(p, "live.m3u8?_HLS_msn=1&_HLS_part=30", 1000, &pl) == 200,
+                "reload for a part beyond the segment end");
+    llhls_response_release(&pl);
+
+    llhls_destroy(p);
+    TEST_PASS("llhls_packager blocking reload and preload hint");
+    return 0;
+}
+
 /* ── main ────────────────────────────────────────────────────────── */
 
 int main(void) {
@@ -326,15 +924,26 @@ int main(void) {
     failures += test_ts_writer_pat_pmt();
     failures += test_ts_writer_pes();
     failures += test_ts_writer_null_guards();
+    failures += test_ts_crc32();
+    failures += test_ts_writer_av();
+    failures += test_ts_writer_buffering();
 
     failures += test_m3u8_live();
     failures += test_m3u8_vod();
     failures += test_m3u8_master();
     failures += test_m3u8_buffer_too_small();
+    failures += test_m3u8_ll_live();
 
     failures += test_segmenter_create();
     failures += test_segmenter_lifecycle();
     failures += test_segmenter_vod();
+    failures += test_segmenter_atomic_publish();
+    failures += test_segmenter_multi_rendition();
+
+    failures += test_cmaf_annexb_to_avcc();
+    failures += test_cmaf_boxes();
+    failures += test_llhls_timing();
+    failures += test_llhls_blocking_reload();
 
     printf("\n");
     if (failures == 0)
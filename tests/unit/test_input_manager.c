@@ -2,7 +2,8 @@
  * test_input_manager.c - Unit tests for input manager (PHASE 15)
  * 
  * Tests input injection, deduplication, latency measurement,
- * and multi-client support.
+ * multi-client support, batched input (input_batch.h) and the
+ * network entry points in src/input.c.
  */
 
 #include <stdio.h>
@@ -11,9 +12,12 @@
 
 /* Include real rootstream header first */
 #include "../../include/rootstream.h"
+#include "../../src/input/input_batch.h"
 
 #ifdef __linux__
 #include <linux/input.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #endif
 
 /* Test result types - match test_harness.h */
@@ -317,6 +321,256 @@ test_result_t test_input_manager_statistics(void) {
     return TEST_PASS;
 }
 
+/* Test: Batch building, coalescing and wire round trip */
+test_result_t test_input_batch_roundtrip(void) {
+#ifdef __linux__
+    input_batch_t batch;
+    input_batch_init(&batch, true);
+
+    /* Motion, a click, more motion: the click splits the coalescing */
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 3, 1000), 0);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_Y, -1, 1100), 0);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 4, 1200), 1);
+    ASSERT_EQ(input_batch_add(&batch, EV_KEY, BTN_LEFT, 1, 1300), 0);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 5, 1400), 0);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 6, 1500), 1);
+    ASSERT_EQ(batch.count, 4);
+    ASSERT_EQ(batch.coalesced, 2);
+
+    /* Events too far apart need a new batch */
+    ASSERT_EQ(input_batch_add(&batch, EV_KEY, KEY_A, 1, 1000 + INPUT_BATCH_MAX_SPAN_US + 1), -1);
+
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(&batch, 7, 2500, payload, sizeof(payload));
+    ASSERT_EQ(len, (size_t)(INPUT_BATCH_HEADER_SIZE + 4 * INPUT_BATCH_EVENT_SIZE));
+
+    input_batch_info_t info;
+    input_batch_event_t events[INPUT_BATCH_MAX_EVENTS];
+    ASSERT_EQ(input_batch_decode(payload, len, &info, events, INPUT_BATCH_MAX_EVENTS), 4);
+    ASSERT_EQ(info.seq, 7);
+    ASSERT_EQ(info.flags, INPUT_BATCH_FLAG_COALESCED);
+    ASSERT_EQ(info.send_us, 2500);
+    ASSERT_TRUE(events[0].code == REL_X && events[0].value == 7 && events[0].time_us == 1000);
+    ASSERT_TRUE(events[1].code == REL_Y && events[1].value == -1 && events[1].time_us == 1100);
+    ASSERT_TRUE(events[2].type == EV_KEY && events[2].code == BTN_LEFT);
+    ASSERT_TRUE(events[3].code == REL_X && events[3].value == 11 && events[3].time_us == 1400);
+
+    /* Truncated or oversized payloads are rejected */
+    ASSERT_EQ(input_batch_decode(payload, len - 1, NULL, events, INPUT_BATCH_MAX_EVENTS), -1);
+    ASSERT_EQ(input_batch_decode(payload, len, NULL, events, 3), -1);
+
+    /* Without coalescing every event is kept */
+    input_batch_init(&batch, false);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 3, 1000), 0);
+    ASSERT_EQ(input_batch_add(&batch, EV_REL, REL_X, 4, 1001), 0);
+    ASSERT_EQ(batch.count, 2);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
+/* Test: A batch reaches the device as one write() with one SYN_REPORT
+ * per report */
+test_result_t test_input_batch_single_write(void) {
+#ifdef __linux__
+    /* SOCK_SEQPACKET keeps write() boundaries, so one read() is one write() */
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        return TEST_SKIP;
+    }
+
+    input_batch_event_t events[] = {
+        {.type = EV_REL, .code = REL_X, .value = 5},
+        {.type = EV_REL, .code = REL_Y, .value = 2},
+        {.type = EV_KEY, .code = BTN_LEFT, .value = 1},
+        {.type = EV_KEY, .code = BTN_LEFT, .value = 0},
+    };
+    ASSERT_EQ(input_batch_inject(sv[0], events, 4), 0);
+
+    struct input_event out[16];
+    ssize_t n = read(sv[1], out, sizeof(out));
+    close(sv[0]);
+    close(sv[1]);
+
+    /* REL_X REL_Y BTN_LEFT=1 SYN | BTN_LEFT=0 SYN: the release gets its
+     * own report so the press is not folded away */
+    ASSERT_EQ(n, (ssize_t)(6 * sizeof(struct input_event)));
+    ASSERT_TRUE(out[2].type == EV_KEY && out[2].value == 1);
+    ASSERT_TRUE(out[3].type == EV_SYN && out[3].code == SYN_REPORT);
+    ASSERT_TRUE(out[4].type == EV_KEY && out[4].value == 0);
+    ASSERT_TRUE(out[5].type == EV_SYN && out[5].code == SYN_REPORT);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
+/* Test: Batch submission and deduplication */
+test_result_t test_input_manager_submit_batch(void) {
+#ifdef __linux__
+    rootstream_ctx_t ctx = {0};
+
+    if (input_manager_init(&ctx, INPUT_BACKEND_LOGGING) != 0) {
+        return TEST_SKIP;
+    }
+
+    input_manager_register_client(&ctx, 1, "TestClient");
+
+    input_batch_t batch;
+    input_batch_init(&batch, true);
+    input_batch_add(&batch, EV_KEY, KEY_A, 1, 1000);
+    input_batch_add(&batch, EV_REL, REL_X, 1, 1100);
+    input_batch_add(&batch, EV_KEY, KEY_A, 0, 1200);
+
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(&batch, 5, 1300, payload, sizeof(payload));
+
+    ASSERT_EQ(input_manager_submit_batch(&ctx, payload, len, 1), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 3);
+
+    /* Same sequence number again is a duplicate */
+    ASSERT_EQ(input_manager_submit_batch(&ctx, payload, len, 1), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 3);
+    ASSERT_EQ(input_manager_get_duplicates(&ctx), 1);
+
+    /* Malformed payloads are refused */
+    ASSERT_EQ(input_manager_submit_batch(&ctx, payload, len - 2, 1), -1);
+
+    input_manager_cleanup(&ctx);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
+/* Test: Click-to-photon latency */
+test_result_t test_input_manager_click_to_photon(void) {
+#ifdef __linux__
+    rootstream_ctx_t ctx = {0};
+
+    if (input_manager_init(&ctx, INPUT_BACKEND_LOGGING) != 0) {
+        return TEST_SKIP;
+    }
+
+    /* A press that waited 20 ms on the client before its batch left */
+    input_batch_t batch;
+    input_batch_init(&batch, true);
+    input_batch_add(&batch, EV_KEY, BTN_LEFT, 1, 1000000);
+
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(&batch, 1, 1020000, payload, sizeof(payload));
+    uint64_t before = get_timestamp_us();
+    ASSERT_EQ(input_manager_submit_batch(&ctx, payload, len, 1), 0);
+
+    /* A frame captured before the injection cannot show the click */
+    input_manager_on_video_frame(&ctx, before - 1000);
+    ASSERT_EQ(ctx.input_manager->click_latency_samples, 0);
+
+    input_manager_on_video_frame(&ctx, get_timestamp_us());
+    ASSERT_EQ(ctx.input_manager->click_latency_samples, 1);
+
+    uint32_t latency = input_manager_get_latency_ms(&ctx);
+    ASSERT_TRUE(latency >= 20);
+    ASSERT_TRUE(latency < 1000);
+
+    /* Later frames do not count the same click again */
+    input_manager_on_video_frame(&ctx, get_timestamp_us());
+    ASSERT_EQ(ctx.input_manager->click_latency_samples, 1);
+
+    input_manager_cleanup(&ctx);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
+/* Test: Input from the network goes through the input manager */
+test_result_t test_input_network_path(void) {
+#ifdef __linux__
+    rootstream_ctx_t ctx = {0};
+
+    if (input_manager_init(&ctx, INPUT_BACKEND_LOGGING) != 0) {
+        return TEST_SKIP;
+    }
+
+    input_event_pkt_t event = {.type = EV_KEY, .code = KEY_A, .value = 1};
+    ASSERT_EQ(rootstream_input_process(&ctx, &event), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 1);
+
+    /* A press arriving as PKT_INPUT_BATCH yields a click-to-photon sample */
+    input_batch_t batch;
+    input_batch_init(&batch, true);
+    input_batch_add(&batch, EV_KEY, BTN_LEFT, 1, 1000000);
+
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(&batch, 1, 1000000, payload, sizeof(payload));
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, &ctx.peers[0], payload, len), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 2);
+
+    input_manager_on_video_frame(&ctx, get_timestamp_us());
+    ASSERT_EQ(ctx.input_manager->click_latency_samples, 1);
+
+    /* Malformed batches are refused */
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, &ctx.peers[0], payload, 3), -1);
+
+    rootstream_input_cleanup(&ctx);
+    ASSERT_NULL(ctx.input_manager);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
+/* Test: A batch a peer repeats is injected once */
+test_result_t test_input_network_duplicate_batch(void) {
+#ifdef __linux__
+    rootstream_ctx_t ctx = {0};
+
+    if (input_manager_init(&ctx, INPUT_BACKEND_LOGGING) != 0) {
+        return TEST_SKIP;
+    }
+
+    input_batch_t batch;
+    input_batch_init(&batch, true);
+    input_batch_add(&batch, EV_REL, REL_X, 5, 1000000);
+
+    uint8_t payload[INPUT_BATCH_MAX_PAYLOAD];
+    size_t len = input_batch_encode(&batch, 7, 1000000, payload, sizeof(payload));
+    peer_t *a = &ctx.peers[0];
+    peer_t *b = &ctx.peers[1];
+    snprintf(a->hostname, sizeof(a->hostname), "peer-a");
+    snprintf(b->hostname, sizeof(b->hostname), "peer-b");
+
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, a, payload, len), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 1);
+    ASSERT_EQ(ctx.input_manager->active_client_count, 1);
+
+    /* The same batch again from the same peer: skipped */
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, a, payload, len), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 1);
+    ASSERT_EQ(input_manager_get_duplicates(&ctx), 1);
+
+    /* Another peer's batch with the same seq is its own */
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, b, payload, len), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 2);
+    ASSERT_EQ(ctx.input_manager->active_client_count, 2);
+
+    /* A new session starts its numbering over */
+    rootstream_input_forget_peer(&ctx, a);
+    ASSERT_EQ(a->input_client_id, 0);
+    ASSERT_EQ(ctx.input_manager->active_client_count, 1);
+    ASSERT_EQ(rootstream_input_process_batch(&ctx, a, payload, len), 0);
+    ASSERT_EQ(input_manager_get_total_inputs(&ctx), 3);
+    ASSERT_EQ(input_manager_get_duplicates(&ctx), 1);
+
+    rootstream_input_cleanup(&ctx);
+    return TEST_PASS;
+#else
+    return TEST_SKIP;
+#endif
+}
+
 const test_case_t input_manager_tests[] = {
     { "Input manager initialization", test_input_manager_init },
     { "Client registration", test_input_manager_client_registration },
@@ -326,6 +580,12 @@ const test_case_t input_manager_tests[] = {
     { "Latency measurement", test_input_manager_latency },
     { "Backend selection", test_input_manager_backend_selection },
     { "Statistics tracking", test_input_manager_statistics },
+    { "Input batch round trip", test_input_batch_roundtrip },
+    { "Input batch single write", test_input_batch_single_write },
+    { "Batch submission", test_input_manager_submit_batch },
+    { "Click-to-photon latency", test_input_manager_click_to_photon },
+    { "Network input path", test_input_network_path },
+    { "Network duplicate batch", test_input_network_duplicate_batch },
     {NULL, NULL}
 };
 
@@ -2,7 +2,8 @@
  * test_mixer.c — Unit tests for PHASE-59 Multi-Stream Mixer
  *
  * Tests mix_source (init/set_weight/set_muted/type_names),
- * mix_engine (add/remove/update/duplicate/full/mix/clip/mute/silence),
+ * mix_engine (add/remove/update/duplicate/full/mix/clip/mute/silence,
+ * float bus, per-bus gains, block processing, look-ahead limiter),
  * and mix_stats (record/underrun/snapshot/reset).
  */
 
@@ -187,6 +188,108 @@ static int test_engine_silence(void) {
     return 0;
 }
 
+static int test_engine_float_bus(void) {
+    printf("\n=== test_engine_float_bus ===\n");
+
+    mix_engine_t *e = mix_engine_create();
+    mix_source_t s1 = make_src(1, 1.0f, false);
+    mix_source_t s2 = make_src(2, 1.0f, false);
+    mix_source_t s3 = make_src(3, 1.0f, false);
+    mix_engine_add_source(e, &s1);
+    mix_engine_add_source(e, &s2);
+    mix_engine_add_source(e, &s3);
+
+    /* 20000 + 20000 - 20000: the partial sum must not clip */
+    int16_t in1[4] = {20000, 20000, 20000, 20000};
+    int16_t in2[4] = {20000, 20000, 20000, 20000};
+    int16_t in3[4] = {-20000, -20000, -20000, -20000};
+    const int16_t *inputs[3] = {in1, in2, in3};
+    uint32_t ids[3] = {1, 2, 3};
+    int16_t  out[4] = {0};
+
+    mix_engine_mix(e, inputs, ids, 3, out, 4);
+    TEST_ASSERT(out[0] == 20000, "intermediate sum kept in float");
+
+    mix_engine_destroy(e);
+    TEST_PASS("mix_engine float accumulation");
+    return 0;
+}
+
+static int test_engine_buses(void) {
+    printf("\n=== test_engine_buses ===\n");
+
+    mix_engine_t *e = mix_engine_create();
+    mix_source_t s1 = make_src(1, 1.0f, false);
+    mix_source_t s2 = make_src(2, 1.0f, false);
+    mix_engine_add_source(e, &s1);
+    mix_engine_add_source(e, &s2);
+
+    /* Bus 1 leaves out source 1; bus 2 has source 2 at half gain */
+    TEST_ASSERT(mix_engine_set_bus_gain(e, 1, 1, 0.0f) == 0, "set bus 1 gain");
+    TEST_ASSERT(mix_engine_set_bus_gain(e, 2, 2, 0.5f) == 0, "set bus 2 gain");
+    TEST_ASSERT(mix_engine_set_bus_gain(e, MIX_MAX_BUSES, 1, 1.0f) == -1, "bad bus → -1");
+    TEST_ASSERT(mix_engine_set_bus_gain(e, 1, 99, 1.0f) == -1, "unknown source → -1");
+
+    /* Longer than one block */
+    enum { N = MIX_MAX_FRAMES + 1000 };
+    static int16_t in1[N], in2[N], out0[N], out1[N], out2[N];
+    for (int i = 0; i < N; i++) {
+        in1[i] = 1000;
+        in2[i] = 200;
+    }
+    const int16_t *inputs[2] = {in1, in2};
+    uint32_t ids[2] = {1, 2};
+    int16_t *outs[3] = {out0, out1, out2};
+
+    TEST_ASSERT(mix_engine_mix_buses(e, inputs, ids, 2, outs, 3, N) == 0, "mix buses ok");
+    TEST_ASSERT(out0[0] == 1200 && out0[N - 1] == 1200, "bus 0 = both sources");
+    TEST_ASSERT(out1[0] == 200 && out1[N - 1] == 200, "bus 1 = source 2 only");
+    TEST_ASSERT(out2[0] == 1100 && out2[N - 1] == 1100, "bus 2 = source 2 at half");
+
+    mix_engine_destroy(e);
+    TEST_PASS("mix_engine per-bus gains over several blocks");
+    return 0;
+}
+
+static int test_engine_limiter_lookahead(void) {
+    printf("\n=== test_engine_limiter_lookahead ===\n");
+
+    mix_engine_t *e = mix_engine_create();
+    mix_source_t s = make_src(1, 2.0f, false);
+    mix_engine_add_source(e, &s);
+
+    mix_limiter_config_t cfg = {
+        .threshold = 0.5f,
+        .lookahead_frames = 48,
+        .release_frames = 480,
+    };
+    TEST_ASSERT(mix_engine_set_limiter(e, &cfg) == 0, "limiter configured");
+    cfg.lookahead_frames = MIX_LIMITER_MAX_LOOKAHEAD + 1;
+    TEST_ASSERT(mix_engine_set_limiter(e, &cfg) == -1, "look-ahead too long → -1");
+
+    /* Silence, then a sine peaking at ~1.8 × full scale after the weight */
+    enum { N = 4800 };
+    static int16_t in[N], out[N];
+    for (int i = 0; i < N; i++)
+        in[i] = i < 1000 ? 0 : (int16_t)(30000.0 * sin(2.0 * 3.14159265 * 440.0 * i / 48000.0));
+    const int16_t *inputs[1] = {in};
+    uint32_t ids[1] = {1};
+
+    mix_engine_mix(e, inputs, ids, 1, out, N);
+
+    int peak = 0;
+    for (int i = 0; i < N; i++)
+        if (abs(out[i]) > peak)
+            peak = abs(out[i]);
+    TEST_ASSERT(out[1000 + 48 - 1] == 0 && out[1000 + 48 + 1] != 0, "output delayed by 48");
+    TEST_ASSERT(peak < 32767, "peaks land on the knee, never hard-clipped");
+    TEST_ASSERT(peak > 16384, "loud signal not crushed");
+
+    mix_engine_destroy(e);
+    TEST_PASS("mix_engine look-ahead soft limiter");
+    return 0;
+}
+
 /* ── mix_stats tests ─────────────────────────────────────────────── */
 
 static int test_mix_stats(void) {
@@ -233,6 +336,9 @@ int main(void) {
     failures += test_engine_mix_clip();
     failures += test_engine_mix_mute();
     failures += test_engine_silence();
+    failures += test_engine_float_bus();
+    failures += test_engine_buses();
+    failures += test_engine_limiter_lookahead();
 
     failures += test_mix_stats();
 
@@ -7,6 +7,10 @@
  * - Bandwidth estimation AIMD algorithm
  * - QoS packet classification
  * - Network optimizer integration
+ * - Nonce replay window
+ * - NACK wire format, resend cache and loss tracker
+ * - Paced sender departure times and loopback delivery
+ * - Path MTU search, black holes and probe wire format
  */
 
 #include "../../src/network/network_monitor.h"
@@ -15,6 +19,13 @@
 #include "../../src/network/bandwidth_estimator.h"
 #include "../../src/network/socket_tuning.h"
 #include "../../src/network/network_optimizer.h"
+#include "../../src/network/replay_window.h"
+#include "../../src/network/nack.h"
+#include "../../src/network/plpmtud.h"
+#include "../../src/network/tx_pacer.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -259,6 +270,540 @@ TEST(network_optimizer_diagnostics_json) {
     network_optimizer_destroy(optimizer);
 }
 
+TEST(replay_window_in_order_and_duplicates) {
+    replay_window_t w;
+    replay_window_reset(&w);
+
+    /* Counter 0 is a valid first nonce */
+    for (uint64_t n = 0; n < 1000; n++) {
+        ASSERT(replay_window_check(&w, n));
+        ASSERT(replay_window_update(&w, n));
+    }
+    ASSERT(!replay_window_check(&w, 0));
+    ASSERT(!replay_window_check(&w, 999));
+    ASSERT(!replay_window_update(&w, 500));
+    ASSERT_EQ(w.rejected, 2);
+
+    /* An all-zero window is an empty one */
+    replay_window_t z;
+    memset(&z, 0, sizeof(z));
+    ASSERT(replay_window_update(&z, 7));
+    ASSERT(!replay_window_check(&z, 7));
+}
+
+TEST(replay_window_reordering) {
+    replay_window_t w;
+    replay_window_reset(&w);
+
+    /* A frame reserves nonces 0..2999, then audio (3000) overtakes it */
+    ASSERT(replay_window_update(&w, 3000));
+    for (uint64_t n = 2999; n != UINT64_MAX; n--) {
+        ASSERT(replay_window_check(&w, n));
+        ASSERT(replay_window_update(&w, n));
+    }
+    for (uint64_t n = 0; n <= 3000; n += 7) {
+        ASSERT(!replay_window_check(&w, n));
+    }
+
+    /* Oldest acceptable and one past it */
+    ASSERT(replay_window_update(&w, 20000));
+    ASSERT(replay_window_check(&w, 20000 - REPLAY_WINDOW_SIZE + 1));
+    ASSERT(!replay_window_check(&w, 20000 - REPLAY_WINDOW_SIZE));
+    ASSERT(!replay_window_update(&w, 20000 - REPLAY_WINDOW_SIZE));
+}
+
+TEST(replay_window_jumps) {
+    replay_window_t w;
+    replay_window_reset(&w);
+
+    for (uint64_t n = 0; n < REPLAY_WINDOW_BITS; n++) {
+        replay_window_update(&w, n);
+    }
+    /* Jump further than the ring: every stale bit must be cleared */
+    uint64_t base = 10 * REPLAY_WINDOW_BITS + 5;
+    ASSERT(replay_window_update(&w, base));
+    for (uint64_t n = base - REPLAY_WINDOW_SIZE + 1; n < base; n++) {
+        ASSERT(replay_window_check(&w, n));
+    }
+    /* A partial jump clears only the blocks it passes */
+    ASSERT(replay_window_update(&w, base - 100));
+    ASSERT(replay_window_update(&w, base + 130));
+    ASSERT(!replay_window_check(&w, base - 100));
+    ASSERT(replay_window_check(&w, base + 129));
+
+    replay_window_reset(&w);
+    ASSERT(replay_window_check(&w, base));
+    ASSERT_EQ(w.rejected, 0);
+}
+
+TEST(nack_codec) {
+    const uint64_t nonces[] = {100, 101, 105, 116, 117, 200};
+    uint8_t buf[NACK_MAX_PAYLOAD];
+    uint64_t out[NACK_MAX_NONCES];
+    int used = 0;
+
+    /* 101..116 ride in 100's mask; 117 is one past it */
+    size_t len = nack_encode(nonces, 6, buf, sizeof(buf), &used);
+    ASSERT_EQ(used, 6);
+    ASSERT_EQ(len, 1 + 3 * NACK_ENTRY_SIZE);
+    ASSERT_EQ(nack_decode(buf, len, out, NACK_MAX_NONCES), 6);
+    ASSERT(memcmp(out, nonces, sizeof(nonces)) == 0);
+
+    /* Only whole entries fit */
+    len = nack_encode(nonces, 6, buf, 1 + NACK_ENTRY_SIZE + 5, &used);
+    ASSERT_EQ(len, 1 + NACK_ENTRY_SIZE);
+    ASSERT_EQ(used, 4);
+    ASSERT_EQ(nack_encode(nonces, 6, buf, NACK_ENTRY_SIZE, &used), 0);
+
+    /* Malformed payloads */
+    len = nack_encode(nonces, 6, buf, sizeof(buf), &used);
+    ASSERT_EQ(nack_decode(buf, len - 1, out, NACK_MAX_NONCES), -1);
+    ASSERT_EQ(nack_decode(buf, len, out, 5), -1);
+    buf[0] = 0;
+    ASSERT_EQ(nack_decode(buf, 1, out, NACK_MAX_NONCES), -1);
+}
+
+TEST(nack_cache_resend_limits) {
+    nack_cache_t *c = nack_cache_create(64);
+    ASSERT(c != NULL);
+    uint8_t pkt[64], out[64];
+    for (int i = 0; i < 64; i++) {
+        pkt[i] = (uint8_t)i;
+    }
+
+    nack_cache_store(c, 7, pkt, 40);
+    ASSERT_EQ(nack_cache_fetch(c, 8, out, sizeof(out)), 0);
+    ASSERT_EQ(nack_cache_fetch(c, 7, out, 39), 0);
+    for (int i = 0; i < NACK_MAX_RESENDS; i++) {
+        ASSERT_EQ(nack_cache_fetch(c, 7, out, sizeof(out)), 40);
+    }
+    ASSERT(memcmp(out, pkt, 40) == 0);
+    ASSERT_EQ(nack_cache_fetch(c, 7, out, sizeof(out)), 0);
+
+    /* A later nonce in the same slot evicts it; oversized is not kept */
+    nack_cache_store(c, 9, pkt, 10);
+    nack_cache_store(c, 9 + NACK_CACHE_PACKETS, pkt, 20);
+    ASSERT_EQ(nack_cache_fetch(c, 9, out, sizeof(out)), 0);
+    ASSERT_EQ(nack_cache_fetch(c, 9 + NACK_CACHE_PACKETS, out, sizeof(out)), 20);
+    nack_cache_store(c, 10, pkt, 65);
+    ASSERT_EQ(nack_cache_fetch(c, 10, out, sizeof(out)), 0);
+
+    nack_cache_reset(c);
+    ASSERT_EQ(nack_cache_fetch(c, 9 + NACK_CACHE_PACKETS, out, sizeof(out)), 0);
+    nack_cache_destroy(c);
+}
+
+/* Deliver chunk idx of a frame cut into 100-byte chunks with nonces base + idx */
+static int nack_chunk(nack_tracker_t *t, frame_reasm_t *r, uint32_t frame_id, uint32_t total,
+                      uint64_t base, uint32_t idx, bool retransmit, uint64_t now_us) {
+    static const uint8_t data[1000];
+    uint32_t off = idx * 100;
+    uint32_t len = total - off < 100 ? total - off : 100;
+    nack_tracker_on_chunk(t, frame_id, base + idx, off, len, total, retransmit, now_us);
+    int ret = frame_reasm_add(r, frame_id, total, off, data + off, len, 0, now_us / 1000);
+    if (ret == FRAME_REASM_COMPLETE) {
+        nack_tracker_on_complete(t, frame_id);
+    }
+    return ret;
+}
+
+TEST(nack_tracker_holes_and_rtt) {
+    nack_tracker_t *t = nack_tracker_create(0);
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    uint8_t buf[NACK_MAX_PAYLOAD];
+    uint64_t nonces[NACK_MAX_NONCES];
+    ASSERT(t != NULL && r != NULL);
+
+    /* Chunk 2 of frame 1 is lost: NACKed once the reorder delay passes */
+    for (uint32_t i = 0; i < 5; i++) {
+        if (i != 2) {
+            nack_chunk(t, r, 1, 500, 1000, i, false, 0);
+        }
+    }
+    ASSERT_EQ(nack_tracker_poll(t, r, NACK_REORDER_US - 1, buf, sizeof(buf)), 0);
+    size_t len = nack_tracker_poll(t, r, NACK_REORDER_US, buf, sizeof(buf));
+    ASSERT_EQ(nack_decode(buf, len, nonces, NACK_MAX_NONCES), 1);
+    ASSERT_EQ(nonces[0], 1002);
+    ASSERT_EQ(nack_tracker_poll(t, r, NACK_REORDER_US + 1000, buf, sizeof(buf)), 0);
+
+    /* The retransmission completes the frame and measures the round trip */
+    ASSERT_EQ(nack_chunk(t, r, 1, 500, 1000, 2, true, NACK_REORDER_US + 20000),
+              FRAME_REASM_COMPLETE);
+    ASSERT_EQ(nack_tracker_rtt_us(t), 20000);
+    ASSERT_EQ(nack_tracker_poll(t, r, 500000, buf, sizeof(buf)), 0);
+
+    /* Lost tail: frame 2 stops at chunk 2, noticed when frame 3 starts */
+    uint64_t now = 1000000;
+    for (uint32_t i = 0; i < 3; i++) {
+        nack_chunk(t, r, 2, 500, 2000, i, false, now);
+    }
+    ASSERT_EQ(nack_tracker_poll(t, r, now + NACK_REORDER_US, buf, sizeof(buf)), 0);
+    nack_chunk(t, r, 3, 100, 2005, 0, false, now + 1000);
+    len = nack_tracker_poll(t, r, now + 1000 + NACK_REORDER_US, buf, sizeof(buf));
+    ASSERT_EQ(nack_decode(buf, len, nonces, NACK_MAX_NONCES), 2);
+    ASSERT(nonces[0] == 2003 && nonces[1] == 2004);
+
+    /* Unanswered, it is repeated one RTO later; the third attempt would
+     * land past the deadline and is dropped */
+    int sent = 1;
+    for (uint64_t at = now + 5000; at < now + 1000000; at += 1000) {
+        sent += nack_tracker_poll(t, r, at, buf, sizeof(buf)) > 0;
+    }
+    nack_tracker_stats_t st;
+    nack_tracker_get_stats(t, &st);
+    ASSERT_EQ(sent, 2);
+    ASSERT_EQ(st.nacks_sent, 3);
+    ASSERT_EQ(st.too_late, 1);
+    ASSERT_EQ(st.retransmits, 1);
+
+    frame_reasm_destroy(r);
+    nack_tracker_destroy(t);
+}
+
+TEST(nack_tracker_too_late) {
+    nack_tracker_t *t = nack_tracker_create(100);
+    frame_reasm_t *r = frame_reasm_create(0, 0, 0);
+    uint8_t buf[NACK_MAX_PAYLOAD];
+    ASSERT(t != NULL && r != NULL);
+
+    /* A hole noticed 60 ms into a 100 ms deadline: one 50 ms RTT is too long */
+    nack_chunk(t, r, 7, 300, 50, 0, false, 0);
+    nack_chunk(t, r, 7, 300, 50, 2, false, 60000 - NACK_REORDER_US);
+    ASSERT_EQ(nack_tracker_poll(t, r, 60000, buf, sizeof(buf)), 0);
+
+    nack_tracker_stats_t st;
+    nack_tracker_get_stats(t, &st);
+    ASSERT_EQ(st.too_late, 1);
+    ASSERT_EQ(st.nacks_sent, 0);
+    ASSERT_EQ(nack_tracker_hold_ms(t), 100); /* Capped at the deadline */
+
+    frame_reasm_destroy(r);
+    nack_tracker_destroy(t);
+}
+
+/* Two loopback UDP sockets; *to receives whatever is sent to addr */
+static int pacer_sockets(int *from, int *to, struct sockaddr_in *addr) {
+    socklen_t len = sizeof(*addr);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    *from = socket(AF_INET, SOCK_DGRAM, 0);
+    *to = socket(AF_INET, SOCK_DGRAM, 0);
+    if (*from < 0 || *to < 0 || bind(*to, (struct sockaddr *)addr, len) < 0 ||
+        getsockname(*to, (struct sockaddr *)addr, &len) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int pacer_receive(int sock, int want, uint8_t *first_bytes) {
+    int got = 0;
+    uint8_t buf[2048];
+    struct pollfd pfd = {.fd = sock, .events = POLLIN};
+    while (got < want && poll(&pfd, 1, 1000) > 0) {
+        if (recv(sock, buf, sizeof(buf), 0) > 0) {
+            first_bytes[got++] = buf[0];
+        }
+    }
+    return got;
+}
+
+TEST(tx_pacer_departures) {
+    int from, to;
+    struct sockaddr_in addr;
+    ASSERT_EQ(pacer_sockets(&from, &to, &addr), 0);
+    tx_pacer_t *p = tx_pacer_create(from, 2, 1000);
+    ASSERT(p != NULL);
+    int flow = tx_pacer_flow_open(p, (struct sockaddr *)&addr, sizeof(addr));
+    ASSERT(flow >= 0);
+
+    /* 8 Mbit/s = one 1000-byte packet per ms after the 4-packet burst */
+    tx_pacer_set_rate(p, flow, 8000000);
+    uint8_t pkt[1000] = {0};
+    uint64_t depart[10];
+    for (int i = 0; i < 10; i++) {
+        pkt[0] = (uint8_t)i;
+        ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), &depart[i]), 0);
+    }
+    for (int i = 1; i < TX_PACER_BURST_PACKETS; i++) {
+        ASSERT(depart[i] - depart[0] < 100);
+    }
+    for (int i = TX_PACER_BURST_PACKETS + 1; i < 10; i++) {
+        ASSERT_EQ(depart[i] - depart[i - 1], 1000);
+    }
+    ASSERT(tx_pacer_enqueue(p, flow, pkt, 1001, NULL) < 0); /* Over max_packet */
+
+    /* All arrive, in order */
+    uint8_t order[10];
+    ASSERT_EQ(pacer_receive(to, 10, order), 10);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(order[i], i);
+    }
+
+    /* The thread counts a batch after the kernel has it */
+    tx_pacer_stats_t st;
+    tx_pacer_get_stats(p, &st);
+    for (int i = 0; i < 100 && st.packets < 10; i++) {
+        usleep(1000);
+        tx_pacer_get_stats(p, &st);
+    }
+    ASSERT_EQ(st.packets, 10);
+    ASSERT_EQ(st.bytes, 10000);
+    ASSERT(!tx_pacer_take_error(p, flow));
+
+    tx_pacer_destroy(p);
+    close(from);
+    close(to);
+}
+
+TEST(tx_pacer_queue_limits) {
+    int from, to;
+    struct sockaddr_in addr;
+    ASSERT_EQ(pacer_sockets(&from, &to, &addr), 0);
+    tx_pacer_t *p = tx_pacer_create(from, 1, 1000);
+    ASSERT(p != NULL);
+    int flow = tx_pacer_flow_open(p, (struct sockaddr *)&addr, sizeof(addr));
+    ASSERT_EQ(flow, 0);
+    ASSERT_EQ(tx_pacer_flow_open(p, (struct sockaddr *)&addr, sizeof(addr)), -1);
+
+    /* 8 kbit/s: one packet a second, so the queue only fills */
+    tx_pacer_set_rate(p, flow, 8000);
+    uint8_t pkt[1000] = {0};
+    int queued = 0;
+    while (tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), NULL) == 0) {
+        queued++;
+    }
+    ASSERT(queued >= TX_PACER_QUEUE_PACKETS);
+    ASSERT(tx_pacer_backlog(p, flow) > TX_PACER_QUEUE_PACKETS - TX_PACER_BURST_PACKETS - 1);
+
+    tx_pacer_stats_t st;
+    tx_pacer_get_stats(p, &st);
+    ASSERT_EQ(st.dropped, 1);
+
+    /* Closing drops the backlog; the reopened flow is unpaced */
+    tx_pacer_flow_close(p, flow);
+    ASSERT_EQ(tx_pacer_backlog(p, flow), 0);
+    ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), NULL), -1);
+    flow = tx_pacer_flow_open(p, (struct sockaddr *)&addr, sizeof(addr));
+    ASSERT_EQ(flow, 0);
+    uint64_t first, second;
+    ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), &first), 0);
+    for (int i = 0; i < 20; i++) {
+        ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), &second), 0);
+    }
+    ASSERT(second - first < 100000);
+
+    tx_pacer_destroy(p);
+    close(from);
+    close(to);
+}
+
+TEST(tx_pacer_grow_max_packet) {
+    int from, to;
+    struct sockaddr_in addr;
+    ASSERT_EQ(pacer_sockets(&from, &to, &addr), 0);
+    tx_pacer_t *p = tx_pacer_create(from, 1, 1000);
+    ASSERT(p != NULL);
+    int flow = tx_pacer_flow_open(p, (struct sockaddr *)&addr, sizeof(addr));
+    ASSERT(flow >= 0);
+
+    /* Grow while packets are still queued: they keep their bytes */
+    tx_pacer_set_rate(p, flow, 8000000);
+    uint8_t pkt[3000] = {0};
+    for (int i = 0; i < 10; i++) {
+        pkt[0] = (uint8_t)i;
+        ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, 1000, NULL), 0);
+    }
+    ASSERT(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), NULL) < 0);
+    ASSERT_EQ(tx_pacer_set_max_packet(p, flow, sizeof(pkt)), 0);
+    pkt[0] = 10;
+    ASSERT_EQ(tx_pacer_enqueue(p, flow, pkt, sizeof(pkt), NULL), 0);
+
+    uint8_t order[11];
+    ASSERT_EQ(pacer_receive(to, 11, order), 11);
+    for (int i = 0; i < 11; i++) {
+        ASSERT_EQ(order[i], i);
+    }
+
+    /* Shrinking only lowers the limit */
+    ASSERT_EQ(tx_pacer_set_max_packet(p, flow, 1000), 0);
+    ASSERT(tx_pacer_enqueue(p, flow, pkt, 1001, NULL) < 0);
+
+    tx_pacer_destroy(p);
+    close(from);
+    close(to);
+}
+
+/*
+ * Drive a search for @duration_us over a path that delivers datagrams up
+ * to @path_max, acking after 1 ms; returns the PLPMTU
+ */
+static size_t pmtu_run(plpmtud_t *p, size_t path_max, uint64_t *now_us, uint64_t duration_us) {
+    for (uint64_t end = *now_us + duration_us; *now_us < end; *now_us += 1000) {
+        uint32_t id;
+        size_t size = plpmtud_poll(p, *now_us, &id);
+        if (size > 0 && size <= path_max) {
+            plpmtud_on_ack(p, id, *now_us + 1000);
+        }
+    }
+    return plpmtud_size(p);
+}
+
+TEST(plpmtud_search_paths) {
+    uint64_t now = 1;
+
+    /* Jumbo LAN: the base size, then the maximum at once */
+    plpmtud_t *p = plpmtud_create(PLPMTUD_MIN_SIZE, 8900);
+    ASSERT(p != NULL);
+    ASSERT_EQ(plpmtud_size(p), PLPMTUD_MIN_SIZE);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_BASE);
+    ASSERT_EQ(pmtu_run(p, 8972, &now, 5000000), 8900);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_SEARCH_COMPLETE);
+    plpmtud_stats_t st;
+    plpmtud_get_stats(p, &st);
+    ASSERT_EQ(st.probes_sent, 2);
+    ASSERT_EQ(st.probes_acked, 2);
+
+    /* Ethernet: the maximum is lost, then the common size fits exactly */
+    plpmtud_reset(p);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_BASE);
+    ASSERT_EQ(pmtu_run(p, 1472, &now, 60000000), 1472);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_SEARCH_COMPLETE);
+
+    /* Tunnel below 1400 bytes: data stays at the base size, which always
+     * fits, until the search reaches the tunnel's common size */
+    plpmtud_reset(p);
+    ASSERT_EQ(pmtu_run(p, 1392, &now, 1000), PLPMTUD_MIN_SIZE);
+    ASSERT_EQ(pmtu_run(p, 1392, &now, 60000000), 1392);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_SEARCH_COMPLETE);
+
+    /* No common size fits: bisection gets within a search step */
+    plpmtud_reset(p);
+    size_t found = pmtu_run(p, 1300, &now, 60000000);
+    ASSERT(found <= 1300 && found > 1300 - PLPMTUD_SEARCH_STEP);
+
+    plpmtud_destroy(p);
+
+    /* A base above the minimum that is lost: the search continues below it */
+    p = plpmtud_create(1400, 8900);
+    ASSERT(p != NULL);
+    plpmtud_get_stats(p, &st);
+    uint64_t lost = st.probes_lost;
+    ASSERT_EQ(pmtu_run(p, 1392, &now, 60000000), 1392);
+    plpmtud_get_stats(p, &st);
+    ASSERT_EQ(st.probes_lost - lost, PLPMTUD_MAX_PROBES);
+
+    plpmtud_destroy(p);
+    ASSERT(plpmtud_create(1100, 8900) == NULL);
+    ASSERT(plpmtud_create(1400, 1300) == NULL);
+}
+
+TEST(plpmtud_black_hole_and_raise) {
+    uint64_t now = 1;
+    plpmtud_t *p = plpmtud_create(PLPMTUD_MIN_SIZE, 8900);
+    ASSERT(p != NULL);
+    ASSERT_EQ(pmtu_run(p, 8972, &now, 5000000), 8900);
+
+    /* Confirmations keep passing */
+    ASSERT_EQ(pmtu_run(p, 8972, &now, 3 * PLPMTUD_CONFIRM_US), 8900);
+    plpmtud_stats_t st;
+    plpmtud_get_stats(p, &st);
+    ASSERT(st.probes_sent >= 4);
+    ASSERT_EQ(st.black_holes, 0);
+
+    /* The route changes to a 1500-byte link: data falls back, then settles */
+    for (int i = 0; i < 100000 && st.black_holes == 0; i++) {
+        pmtu_run(p, 1472, &now, 1000);
+        plpmtud_get_stats(p, &st);
+    }
+    ASSERT_EQ(st.black_holes, 1);
+    ASSERT_EQ(plpmtud_size(p), PLPMTUD_MIN_SIZE);
+    ASSERT_EQ(pmtu_run(p, 1472, &now, 60000000), 1472);
+    plpmtud_get_stats(p, &st);
+    ASSERT_EQ(st.black_holes, 1);
+
+    /* The larger path returns: found again after the raise interval */
+    ASSERT_EQ(pmtu_run(p, 8972, &now, PLPMTUD_RAISE_US / 2), 1472);
+    ASSERT_EQ(pmtu_run(p, 8972, &now, PLPMTUD_RAISE_US), 8900);
+
+    plpmtud_destroy(p);
+}
+
+TEST(plpmtud_too_big_and_acks) {
+    plpmtud_t *p = plpmtud_create(PLPMTUD_MIN_SIZE, 8900);
+    ASSERT(p != NULL);
+
+    /* Nothing in flight: ignored */
+    plpmtud_on_too_big(p, 1);
+    ASSERT_EQ(plpmtud_size(p), PLPMTUD_MIN_SIZE);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_BASE);
+
+    /* The base size is confirmed, not raised */
+    uint32_t id;
+    ASSERT_EQ(plpmtud_poll(p, 1, &id), PLPMTUD_MIN_SIZE);
+    ASSERT(!plpmtud_on_ack(p, id, 2));
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_SEARCHING);
+
+    /* The local interface rejects the maximum: the next size at once */
+    ASSERT_EQ(plpmtud_poll(p, 3, &id), 8900);
+    ASSERT_EQ(plpmtud_poll(p, 4, &id), 0); /* In flight */
+    plpmtud_on_too_big(p, 4);
+    ASSERT_EQ(plpmtud_size(p), PLPMTUD_MIN_SIZE);
+    ASSERT_EQ(plpmtud_state(p), PLPMTUD_SEARCHING);
+    plpmtud_stats_t st;
+    plpmtud_get_stats(p, &st);
+    ASSERT_EQ(st.probes_lost, 1);
+
+    /* A stale or unknown id does not count */
+    uint32_t probe;
+    ASSERT_EQ(plpmtud_poll(p, 5, &probe), 1472);
+    ASSERT(!plpmtud_on_ack(p, id, 6));
+    ASSERT(!plpmtud_on_ack(p, probe + 1, 6));
+    ASSERT_EQ(plpmtud_size(p), PLPMTUD_MIN_SIZE);
+
+    /* A late ack for an earlier try at the same size does */
+    uint32_t retry;
+    ASSERT_EQ(plpmtud_poll(p, 5 + PLPMTUD_PROBE_TIMEOUT_US, &retry), 1472);
+    ASSERT(retry != probe);
+    ASSERT(plpmtud_on_ack(p, probe, 6 + PLPMTUD_PROBE_TIMEOUT_US));
+    ASSERT_EQ(plpmtud_size(p), 1472);
+
+    plpmtud_destroy(p);
+}
+
+TEST(plpmtud_codec) {
+    uint8_t buf[64];
+    memset(buf, 0xAA, sizeof(buf));
+    ASSERT_EQ(plpmtud_encode(PLPMTUD_KIND_PROBE, 0x01020304, 8900, buf, sizeof(buf)),
+              sizeof(buf));
+    ASSERT_EQ(buf[0], PLPMTUD_KIND_PROBE);
+    ASSERT_EQ(buf[1], 0x04);
+    for (size_t i = PLPMTUD_PROBE_HEADER; i < sizeof(buf); i++) {
+        ASSERT_EQ(buf[i], 0);
+    }
+
+    uint8_t kind;
+    uint32_t id;
+    uint16_t size;
+    ASSERT_EQ(plpmtud_decode(buf, sizeof(buf), &kind, &id, &size), 0);
+    ASSERT_EQ(kind, PLPMTUD_KIND_PROBE);
+    ASSERT_EQ(id, 0x01020304);
+    ASSERT_EQ(size, 8900);
+
+    /* The ack is just the header */
+    ASSERT_EQ(plpmtud_encode(PLPMTUD_KIND_ACK, 7, 1472, buf, PLPMTUD_PROBE_HEADER),
+              PLPMTUD_PROBE_HEADER);
+    ASSERT_EQ(plpmtud_decode(buf, PLPMTUD_PROBE_HEADER, &kind, &id, &size), 0);
+    ASSERT_EQ(kind, PLPMTUD_KIND_ACK);
+    ASSERT_EQ(id, 7);
+    ASSERT_EQ(size, 1472);
+
+    ASSERT_EQ(plpmtud_encode(PLPMTUD_KIND_ACK, 7, 1472, buf, PLPMTUD_PROBE_HEADER - 1), 0);
+    ASSERT_EQ(plpmtud_decode(buf, PLPMTUD_PROBE_HEADER - 1, &kind, &id, &size), -1);
+    buf[0] = 2;
+    ASSERT_EQ(plpmtud_decode(buf, PLPMTUD_PROBE_HEADER, &kind, &id, &size), -1);
+}
+
 /* ============================================================================
  * Test Runner
  * ============================================================================ */
@@ -295,6 +840,28 @@ int main(void) {
     run_test_network_optimizer_optimize();
     run_test_network_optimizer_diagnostics_json();
 
+    printf("\nRunning Replay Window Tests:\n");
+    run_test_replay_window_in_order_and_duplicates();
+    run_test_replay_window_reordering();
+    run_test_replay_window_jumps();
+
+    printf("\nRunning NACK Tests:\n");
+    run_test_nack_codec();
+    run_test_nack_cache_resend_limits();
+    run_test_nack_tracker_holes_and_rtt();
+    run_test_nack_tracker_too_late();
+
+    printf("\nRunning Paced Sender Tests:\n");
+    run_test_tx_pacer_departures();
+    run_test_tx_pacer_queue_limits();
+    run_test_tx_pacer_grow_max_packet();
+
+    printf("\nRunning Path MTU Tests:\n");
+    run_test_plpmtud_search_paths();
+    run_test_plpmtud_black_hole_and_raise();
+    run_test_plpmtud_too_big_and_acks();
+    run_test_plpmtud_codec();
+
     printf("\n");
     printf("═══════════════════════════════════════════════════════════════\n");
     printf("Test Results:\n");
@@ -1,7 +1,7 @@
 /*
  * test_ratelimit.c — Unit tests for PHASE-52 Token Bucket Rate Limiter
  *
- * Tests token_bucket (create/consume/refill/available/reset/set_rate),
+ * Tests token_bucket (create/consume/refill/reserve/available/reset/set_rate),
  * rate_limiter (add/remove/consume/has viewer), and ratelimit_stats
  * (record/snapshot/reset/throttle_rate).
  */
@@ -109,6 +109,31 @@ static int test_bucket_set_rate(void) {
     return 0;
 }
 
+static int test_bucket_reserve(void) {
+    printf("\n=== test_bucket_reserve ===\n");
+
+    /* 1 MB/s = 1 byte/µs, 2000-byte burst */
+    token_bucket_t *tb = token_bucket_create(1e6, 2000.0, 0);
+
+    /* The burst leaves at once, then each 1000 bytes waits 1 ms more */
+    TEST_ASSERT(token_bucket_reserve(tb, 1000.0, 0) == 0, "first in burst");
+    TEST_ASSERT(token_bucket_reserve(tb, 1000.0, 0) == 0, "second in burst");
+    TEST_ASSERT(token_bucket_reserve(tb, 1000.0, 0) == 1000, "third at 1 ms");
+    TEST_ASSERT(token_bucket_reserve(tb, 1000.0, 0) == 2000, "fourth at 2 ms");
+    TEST_ASSERT(token_bucket_available(tb, 0) < -1999.0, "in debt");
+
+    /* Half the debt repaid by 1 ms: the next reservation queues behind it */
+    TEST_ASSERT(token_bucket_reserve(tb, 500.0, 1000) == 2500, "queued behind debt");
+
+    /* Idle long enough and the burst is back */
+    TEST_ASSERT(token_bucket_reserve(tb, 1000.0, 100000) == 100000, "burst refilled");
+    TEST_ASSERT(token_bucket_reserve(NULL, 1000.0, 7) == 7, "NULL → now");
+
+    token_bucket_destroy(tb);
+    TEST_PASS("token_bucket reserve");
+    return 0;
+}
+
 /* ── rate_limiter tests ───────────────────────────────────────────── */
 
 static int test_rl_create(void) {
@@ -213,6 +238,7 @@ int main(void) {
     failures += test_bucket_consume();
     failures += test_bucket_reset();
     failures += test_bucket_set_rate();
+    failures += test_bucket_reserve();
 
     failures += test_rl_create();
     failures += test_rl_add_remove();
@@ -7,6 +7,7 @@
  * 3. Adding audio chunks to replay buffer
  * 4. Saving replay buffer to file
  * 5. Memory management and cleanup
+ * 6. Keyframe-aligned eviction and saving while capture continues
  */
 
 #include <stdio.h>
@@ -14,6 +15,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <atomic>
 
 #include "../../src/recording/replay_buffer.h"
 
@@ -230,6 +232,106 @@ int test_buffer_clear() {
     TEST_PASS("test_buffer_clear");
 }
 
+/**
+ * Test that eviction keeps the buffer starting on a keyframe
+ */
+int test_keyframe_aligned_eviction() {
+    // 1 MB ring, 64 KB frames, keyframe every 8 frames
+    replay_buffer_t *buffer = replay_buffer_create(60, 1);
+    TEST_ASSERT(buffer != nullptr, "Replay buffer should be created");
+
+    const size_t frame_size = 64 * 1024;
+    uint8_t *frame_data = (uint8_t *)malloc(frame_size);
+    TEST_ASSERT(frame_data != nullptr, "Failed to allocate frame data");
+    memset(frame_data, 1, frame_size);
+
+    for (int i = 0; i < 100; i++) {
+        int ret = replay_buffer_add_video_frame(buffer, frame_data, frame_size,
+                                               640, 480, i * 16667, i % 8 == 0);
+        TEST_ASSERT(ret == 0, "Should successfully add video frame");
+    }
+
+    replay_buffer_stats_t stats;
+    TEST_ASSERT(replay_buffer_get_ring_stats(buffer, &stats) == 0, "Should get ring stats");
+    TEST_ASSERT(stats.used_bytes <= stats.arena_bytes, "Frames should fit in the ring");
+    TEST_ASSERT(stats.evicted > 0, "Old frames should have been evicted");
+    TEST_ASSERT(stats.video_frames % 8 == 4, "Buffer should start on a keyframe");
+    TEST_ASSERT(stats.dropped == 0, "Nothing should be dropped without a save");
+
+    free(frame_data);
+    replay_buffer_destroy(buffer);
+
+    TEST_PASS("test_keyframe_aligned_eviction");
+}
+
+struct save_result {
+    std::atomic<int> calls;
+    int result;
+    uint32_t frames;
+};
+
+static void on_save_done(int result, uint32_t frames_written, void *user) {
+    save_result *r = (save_result *)user;
+    r->result = result;
+    r->frames = frames_written;
+    r->calls++;
+}
+
+/**
+ * Test a background save while capture keeps adding frames
+ */
+int test_save_async() {
+    replay_buffer_t *buffer = replay_buffer_create(10, 4);
+    TEST_ASSERT(buffer != nullptr, "Replay buffer should be created");
+
+    const size_t frame_size = 32 * 1024;
+    uint8_t *frame_data = (uint8_t *)malloc(frame_size);
+    TEST_ASSERT(frame_data != nullptr, "Failed to allocate frame data");
+    memset(frame_data, 2, frame_size);
+
+    // Nothing to save yet
+    save_result result = {};
+    TEST_ASSERT(replay_buffer_save_async(buffer, "/tmp/unused.h264", 0, VIDEO_CODEC_H264,
+                                         on_save_done, &result) != 0,
+                "Save of an empty buffer should fail");
+
+    for (int i = 0; i < 60; i++) {
+        replay_buffer_add_video_frame(buffer, frame_data, frame_size, 640, 480,
+                                      i * 16667, i % 30 == 0);
+    }
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), "/tmp/test_replay_%d.h264", (int)getpid());
+    int ret = replay_buffer_save_async(buffer, filename, 0, VIDEO_CODEC_H264,
+                                       on_save_done, &result);
+    TEST_ASSERT(ret == 0, "Background save should start");
+
+    // Capture continues; adds never block on the save, at worst they drop
+    for (int i = 60; i < 600; i++) {
+        replay_buffer_add_video_frame(buffer, frame_data, frame_size, 640, 480,
+                                      i * 16667, i % 30 == 0);
+    }
+
+    ret = replay_buffer_save_wait(buffer);
+    TEST_ASSERT(ret == 0, "Background save should succeed");
+    TEST_ASSERT(result.calls == 1, "Completion callback should run once");
+    TEST_ASSERT(result.frames == 60, "Save should contain the frames present when it started");
+
+    replay_buffer_stats_t stats;
+    replay_buffer_get_ring_stats(buffer, &stats);
+    TEST_ASSERT(!stats.saving, "Pin should be released");
+
+    struct stat st;
+    TEST_ASSERT(stat(filename, &st) == 0 && st.st_size >= (off_t)(60 * frame_size),
+                "Output file should hold every frame");
+    unlink(filename);
+
+    free(frame_data);
+    replay_buffer_destroy(buffer);
+
+    TEST_PASS("test_save_async");
+}
+
 /**
  * Main test runner
  */
@@ -245,6 +347,8 @@ int main() {
     if (test_memory_limit() != 0) failed++;
     if (test_time_based_cleanup() != 0) failed++;
     if (test_buffer_clear() != 0) failed++;
+    if (test_keyframe_aligned_eviction() != 0) failed++;
+    if (test_save_async() != 0) failed++;
     
     printf("\n=====================================\n");
     if (failed == 0) {
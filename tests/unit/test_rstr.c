@@ -0,0 +1,345 @@
+/*
+ * test_rstr.c — Unit tests for the .rstr v2 writer and reader
+ *
+ * Writes recordings to temporary files with rstr_writer, reads them
+ * back sequentially, and checks index loading from the trailer, from
+ * the checkpoint chain of a recording cut short, and by scanning a
+ * version 1 file, plus seeking and the writer's drop policy.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../src/rstr/rstr_reader.h"
+#include "../../src/rstr/rstr_writer.h"
+
+/* ── Test macros ─────────────────────────────────────────────────── */
+
+#define TEST_ASSERT(cond, msg) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "FAIL: %s\n", (msg)); \
+            return 1; \
+        } \
+    } while (0)
+
+#define TEST_PASS(msg) printf("PASS: %s\n", (msg))
+
+/* ── Helpers ─────────────────────────────────────────────────────── */
+
+#define FRAME_US 16667ULL /* 60 fps */
+#define GOP 30
+
+static void tmp_path(char *buf, size_t len, const char *tag) {
+    snprintf(buf, len, "/tmp/test_rstr_%s_%d.rstr", tag, (int)getpid());
+}
+
+/* Frame @n: size and bytes derived from n, so reads can be checked */
+static size_t frame_size(int n) {
+    return (n % GOP == 0) ? 40000 + (size_t)n : 3000 + (size_t)(n * 37 % 2000);
+}
+
+static void frame_fill(uint8_t *buf, int n) {
+    size_t size = frame_size(n);
+    for (size_t i = 0; i < size; i++)
+        buf[i] = (uint8_t)(n * 31 + i);
+}
+
+static int write_recording(const char *path, int frames, const rstr_writer_config_t *cfg) {
+    rstr_header_t hdr = {0};
+    hdr.width = 1280;
+    hdr.height = 720;
+    hdr.fps = 60;
+    rstr_writer_t *w = rstr_writer_open(path, &hdr, cfg);
+    if (!w)
+        return -1;
+
+    uint8_t *buf = malloc(80000);
+    for (int n = 0; n < frames; n++) {
+        frame_fill(buf, n);
+        if (rstr_writer_write(w, (uint64_t)n * FRAME_US, buf, frame_size(n), n % GOP == 0) !=
+            RSTR_WRITE_QUEUED) {
+            free(buf);
+            rstr_writer_close(w);
+            return -1;
+        }
+    }
+    free(buf);
+    return rstr_writer_close(w);
+}
+
+/* Read every frame back in order; returns frames read, -1 on mismatch */
+static int read_back(int fd) {
+    uint8_t *buf = malloc(80000);
+    uint8_t *want = malloc(80000);
+    rstr_frame_header_t fh;
+    int n = 0;
+    int rc;
+    while ((rc = rstr_read_frame(fd, buf, 80000, &fh)) == 0) {
+        frame_fill(want, n);
+        if (fh.size != frame_size(n) || fh.timestamp_us != (uint64_t)n * FRAME_US ||
+            !!(fh.flags & RSTR_FLAG_KEYFRAME) != (n % GOP == 0) ||
+            memcmp(buf, want, fh.size) != 0) {
+            n = -1;
+            break;
+        }
+        n++;
+    }
+    free(buf);
+    free(want);
+    return rc < 0 ? -1 : n;
+}
+
+/* ── Tests ───────────────────────────────────────────────────────── */
+
+static int test_roundtrip_and_trailer(void) {
+    printf("\n=== test_roundtrip_and_trailer ===\n");
+
+    char path[128];
+    tmp_path(path, sizeof(path), "trailer");
+    rstr_writer_config_t cfg = {.checkpoint_interval_us = 1000000};
+    TEST_ASSERT(write_recording(path, 600, &cfg) == 0, "600 frames written");
+
+    int fd = open(path, O_RDONLY);
+    rstr_header_t hdr;
+    TEST_ASSERT(rstr_read_header(fd, &hdr) == 0, "header reads");
+    TEST_ASSERT(hdr.version == RSTR_VERSION_2, "version 2");
+    TEST_ASSERT(hdr.width == 1280 && hdr.fps == 60, "header fields kept");
+    TEST_ASSERT(hdr.index_checkpoint > sizeof(hdr), "header points at a checkpoint");
+
+    rstr_index_t idx;
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "index loads");
+    TEST_ASSERT(idx.source == RSTR_INDEX_SOURCE_TRAILER, "index from trailer");
+    TEST_ASSERT(idx.count == 600 / GOP, "one entry per keyframe");
+
+    /* Sequential reading skips the checkpoints and the trailer */
+    TEST_ASSERT(read_back(fd) == 600, "all frames read back intact");
+
+    rstr_index_free(&idx);
+    close(fd);
+    unlink(path);
+    TEST_PASS("round trip with full index");
+    return 0;
+}
+
+static int test_seek(void) {
+    printf("\n=== test_seek ===\n");
+
+    char path[128];
+    tmp_path(path, sizeof(path), "seek");
+    TEST_ASSERT(write_recording(path, 300, NULL) == 0, "300 frames written");
+
+    int fd = open(path, O_RDONLY);
+    rstr_header_t hdr;
+    rstr_index_t idx;
+    TEST_ASSERT(rstr_read_header(fd, &hdr) == 0, "header reads");
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "index loads");
+
+    /* Frame 100 is a delta; its keyframe is frame 90 */
+    uint64_t key_us = 0;
+    TEST_ASSERT(rstr_seek(fd, &idx, 100 * FRAME_US, &key_us) == 0, "seek succeeds");
+    TEST_ASSERT(key_us == 90 * FRAME_US, "lands on the keyframe before");
+
+    uint8_t *buf = malloc(80000);
+    rstr_frame_header_t fh;
+    TEST_ASSERT(rstr_read_frame(fd, buf, 80000, &fh) == 0, "frame after seek reads");
+    TEST_ASSERT(fh.timestamp_us == 90 * FRAME_US, "it is the keyframe");
+    TEST_ASSERT(fh.flags & RSTR_FLAG_KEYFRAME, "flagged keyframe");
+
+    /* Exact hit, before the start, past the end */
+    TEST_ASSERT(rstr_index_find(&idx, 120 * FRAME_US)->timestamp_us == 120 * FRAME_US,
+                "exact keyframe timestamp");
+    TEST_ASSERT(rstr_index_find(&idx, 0)->timestamp_us == 0, "start");
+    TEST_ASSERT(rstr_index_find(&idx, UINT64_MAX)->timestamp_us == 270 * FRAME_US,
+                "past the end → last keyframe");
+
+    rstr_index_t empty = {0};
+    TEST_ASSERT(rstr_index_find(&empty, 0) == NULL, "empty index");
+    TEST_ASSERT(rstr_seek(fd, &empty, 0, NULL) == -1, "seek on empty index fails");
+
+    free(buf);
+    rstr_index_free(&idx);
+    close(fd);
+    unlink(path);
+    TEST_PASS("seek to keyframe");
+    return 0;
+}
+
+static int test_crash_recovery(void) {
+    printf("\n=== test_crash_recovery ===\n");
+
+    char path[128];
+    tmp_path(path, sizeof(path), "crash");
+    rstr_writer_config_t cfg = {.checkpoint_interval_us = 2000000};
+    TEST_ASSERT(write_recording(path, 900, &cfg) == 0, "900 frames written");
+
+    int fd = open(path, O_RDWR);
+    rstr_header_t hdr;
+    rstr_index_t idx;
+    TEST_ASSERT(rstr_read_header(fd, &hdr) == 0, "header reads");
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "index loads");
+    uint64_t data_end = idx.data_end;
+    uint64_t cp = hdr.index_checkpoint;
+    rstr_index_free(&idx);
+    TEST_ASSERT(cp > 0 && cp < data_end, "last checkpoint precedes the last frame");
+
+    /* Cut off the trailer and half of the last frame, as a crash would */
+    TEST_ASSERT(ftruncate(fd, (off_t)(data_end - 100)) == 0, "truncate");
+
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "index loads after crash");
+    TEST_ASSERT(idx.source == RSTR_INDEX_SOURCE_CHECKPOINTS, "index from checkpoints");
+    TEST_ASSERT(idx.count == 900 / GOP, "every keyframe found");
+    for (size_t i = 0; i < idx.count; i++)
+        TEST_ASSERT(idx.entries[i].timestamp_us == i * GOP * FRAME_US, "entries in order");
+    TEST_ASSERT(idx.data_end < data_end, "data ends before the torn frame");
+
+    /* Sequential read ends cleanly at the torn frame */
+    lseek(fd, sizeof(hdr), SEEK_SET);
+    TEST_ASSERT(read_back(fd) == 899, "all complete frames read");
+
+    /* Broken checkpoint pointer → full scan */
+    hdr.index_checkpoint = data_end * 2;
+    rstr_index_free(&idx);
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "index loads with bad pointer");
+    TEST_ASSERT(idx.source == RSTR_INDEX_SOURCE_SCAN, "falls back to a scan");
+    TEST_ASSERT(idx.count == 900 / GOP, "scan finds every keyframe");
+
+    rstr_index_free(&idx);
+    close(fd);
+    unlink(path);
+    TEST_PASS("index recovered from checkpoints");
+    return 0;
+}
+
+static int test_v1_scan(void) {
+    printf("\n=== test_v1_scan ===\n");
+
+    char path[128];
+    tmp_path(path, sizeof(path), "v1");
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    rstr_header_t hdr = {0};
+    hdr.magic = RSTR_MAGIC;
+    hdr.version = RSTR_VERSION_1;
+    TEST_ASSERT(write(fd, &hdr, sizeof(hdr)) == sizeof(hdr), "v1 header");
+
+    uint8_t *buf = malloc(80000);
+    for (int n = 0; n < 100; n++) {
+        rstr_frame_header_t fh = {0};
+        fh.timestamp_us = (uint64_t)n * FRAME_US;
+        fh.size = (uint32_t)frame_size(n);
+        fh.flags = n % GOP == 0 ? RSTR_FLAG_KEYFRAME : 0;
+        frame_fill(buf, n);
+        TEST_ASSERT(write(fd, &fh, sizeof(fh)) == sizeof(fh), "v1 frame header");
+        TEST_ASSERT(write(fd, buf, fh.size) == (ssize_t)fh.size, "v1 frame");
+    }
+    free(buf);
+
+    lseek(fd, 0, SEEK_SET);
+    rstr_index_t idx;
+    TEST_ASSERT(rstr_read_header(fd, &hdr) == 0, "v1 header reads");
+    TEST_ASSERT(rstr_index_load(fd, &hdr, &idx) == 0, "v1 index loads");
+    TEST_ASSERT(idx.source == RSTR_INDEX_SOURCE_SCAN, "v1 is scanned");
+    TEST_ASSERT(idx.count == 4, "4 keyframes");
+    TEST_ASSERT(read_back(fd) == 100, "v1 frames read back");
+
+    rstr_index_free(&idx);
+    close(fd);
+    unlink(path);
+    TEST_PASS("version 1 files still play");
+    return 0;
+}
+
+static int test_drop_until_keyframe(void) {
+    printf("\n=== test_drop_until_keyframe ===\n");
+
+    char path[128];
+    tmp_path(path, sizeof(path), "drop");
+    rstr_header_t hdr = {0};
+    rstr_writer_config_t cfg = {.ring_bytes = 64 << 10};
+    rstr_writer_t *w = rstr_writer_open(path, &hdr, &cfg);
+    TEST_ASSERT(w != NULL, "writer opened");
+
+    static uint8_t big[128 << 10];
+    static uint8_t small[1000];
+    TEST_ASSERT(rstr_writer_write(w, 0, small, sizeof(small), true) == RSTR_WRITE_QUEUED,
+                "keyframe queued");
+    TEST_ASSERT(rstr_writer_write(w, 1, big, sizeof(big), false) == RSTR_WRITE_DROPPED,
+                "frame larger than the ring dropped");
+    TEST_ASSERT(rstr_writer_write(w, 2, small, sizeof(small), false) == RSTR_WRITE_DROPPED,
+                "delta after a drop dropped");
+    TEST_ASSERT(rstr_writer_write(w, 3, small, sizeof(small), true) == RSTR_WRITE_QUEUED,
+                "next keyframe queued");
+    TEST_ASSERT(rstr_writer_write(w, 4, small, sizeof(small), false) == RSTR_WRITE_QUEUED,
+                "deltas resume");
+    TEST_ASSERT(rstr_writer_write(w, 5, NULL, 10, false) == -1, "NULL data rejected");
+
+    rstr_writer_stats_t st;
+    TEST_ASSERT(rstr_writer_get_stats(w, &st) == 0, "stats");
+    TEST_ASSERT(st.frames == 3 && st.frames_dropped == 2, "counters");
+    TEST_ASSERT(st.keyframes == 2, "two keyframes indexed");
+    TEST_ASSERT(rstr_writer_close(w) == 0, "close");
+
+    unlink(path);
+    TEST_PASS("drop policy keeps the file decodable");
+    return 0;
+}
+
+static int test_batched_and_direct(void) {
+    printf("\n=== test_batched_and_direct ===\n");
+
+    /* O_DIRECT where the filesystem allows it (tmpfs falls back) */
+    char path[128];
+    tmp_path(path, sizeof(path), "direct");
+    rstr_header_t hdr = {0};
+    rstr_writer_config_t cfg = {.direct_io = true, .batch_bytes = 256 << 10};
+    rstr_writer_t *w = rstr_writer_open(path, &hdr, &cfg);
+    TEST_ASSERT(w != NULL, "writer opened");
+
+    uint8_t *buf = malloc(80000);
+    for (int n = 0; n < 300; n++) {
+        frame_fill(buf, n);
+        TEST_ASSERT(rstr_writer_write(w, (uint64_t)n * FRAME_US, buf, frame_size(n),
+                                      n % GOP == 0) == RSTR_WRITE_QUEUED,
+                    "frame queued");
+    }
+    free(buf);
+
+    rstr_writer_stats_t st;
+    rstr_writer_get_stats(w, &st);
+    printf("  direct_io=%d writes=%lu for %lu bytes\n", st.direct_io, st.writes,
+           st.bytes_queued);
+    TEST_ASSERT(rstr_writer_close(w) == 0, "close");
+
+    int fd = open(path, O_RDONLY);
+    TEST_ASSERT(rstr_read_header(fd, &hdr) == 0, "header reads");
+    TEST_ASSERT(read_back(fd) == 300, "frames intact");
+    close(fd);
+    unlink(path);
+    TEST_PASS("batched writes produce the same file");
+    return 0;
+}
+
+/* ── main ────────────────────────────────────────────────────────── */
+
+int main(void) {
+    int failures = 0;
+
+    failures += test_roundtrip_and_trailer();
+    failures += test_seek();
+    failures += test_crash_recovery();
+    failures += test_v1_scan();
+    failures += test_drop_until_keyframe();
+    failures += test_batched_and_direct();
+
+    printf("\n");
+    if (failures == 0) {
+        printf("ALL RSTR TESTS PASSED\n");
+    } else {
+        printf("%d RSTR TEST(S) FAILED\n", failures);
+    }
+    return failures ? 1 : 0;
+}
@@ -12,6 +12,7 @@
 #include "../../src/security/attack_prevention.h"
 #include "../../src/security/audit_log.h"
 #include "../../src/security/security_manager.h"
+#include "../../src/security/sec_table.h"
 
 /* Test counter */
 static int tests_passed = 0;
@@ -256,6 +257,117 @@ void test_attack_prevention(void) {
     } else {
         FAIL("Account still locked after reset");
     }
+
+    /* Test rate limiting */
+    TEST("attack_prevention_is_rate_limited");
+    bool limited = false;
+    for (int i = 0; i < 10; i++) {
+        limited |= attack_prevention_is_rate_limited("client-a", 10);
+    }
+    if (!limited && attack_prevention_is_rate_limited("client-a", 10) &&
+        !attack_prevention_is_rate_limited("client-b", 10)) {
+        PASS();
+    } else {
+        FAIL("Rate limit not applied per client");
+    }
+}
+
+/* Counts calls; removes the entry when asked to */
+static sec_table_action_t count_fn(void *value, bool created, uint64_t *expires_ms, void *arg) {
+    uint32_t *hits = value;
+    (void)created;
+    (*hits)++;
+    if (arg) {
+        *expires_ms = *(const uint64_t *)arg;
+    }
+    return *hits >= 100 ? SEC_TABLE_REMOVE : SEC_TABLE_KEEP;
+}
+
+/* Test security hash table */
+void test_sec_table(void) {
+    printf("\n=== Security Table Tests ===\n");
+
+    sec_table_t *t = sec_table_create(50000, sizeof(uint32_t), 10);
+
+    /* Insert and find many keys */
+    TEST("sec_table_apply");
+    char key[32];
+    bool ok = t != NULL;
+    for (int i = 0; ok && i < 40000; i++) {
+        snprintf(key, sizeof(key), "client-%d", i);
+        ok = sec_table_apply(t, key, true, 0, count_fn, NULL) == 1;
+    }
+    for (int i = 0; ok && i < 40000; i += 7) {
+        snprintf(key, sizeof(key), "client-%d", i);
+        ok = sec_table_apply(t, key, false, 0, count_fn, NULL) == 1;
+    }
+    if (ok && sec_table_count(t) == 40000 &&
+        sec_table_apply(t, "missing", false, 0, count_fn, NULL) == 0) {
+        PASS();
+    } else {
+        FAIL("Insert/lookup failed");
+    }
+
+    /* Remove every other key; the rest must stay reachable */
+    TEST("sec_table_remove");
+    for (int i = 0; ok && i < 40000; i += 2) {
+        snprintf(key, sizeof(key), "client-%d", i);
+        ok = sec_table_remove(t, key);
+    }
+    for (int i = 1; ok && i < 40000; i += 2) {
+        snprintf(key, sizeof(key), "client-%d", i);
+        ok = sec_table_apply(t, key, false, 0, count_fn, NULL) == 1;
+    }
+    if (ok && sec_table_count(t) == 20000 && !sec_table_remove(t, "client-0")) {
+        PASS();
+    } else {
+        FAIL("Removal failed");
+    }
+
+    /* Capacity limit */
+    TEST("sec_table_max_entries");
+    for (int i = 0; i < 30000; i++) {
+        snprintf(key, sizeof(key), "extra-%d", i);
+        sec_table_apply(t, key, true, 0, count_fn, NULL);
+    }
+    if (sec_table_count(t) == 50000 &&
+        sec_table_apply(t, "one-more", true, 0, count_fn, NULL) == -1) {
+        PASS();
+    } else {
+        FAIL("Capacity limit not enforced");
+    }
+    sec_table_destroy(t);
+
+    /* Expiry: invisible at once, reclaimed by the timer wheel */
+    TEST("sec_table_expire");
+    t = sec_table_create(1000, sizeof(uint32_t), 10);
+    ok = t != NULL;
+    for (int i = 0; ok && i < 300; i++) {
+        uint64_t expires = 1000 + (uint64_t)i * 100; /* Spans several wheel laps */
+        snprintf(key, sizeof(key), "s-%d", i);
+        ok = sec_table_apply(t, key, true, 0, count_fn, &expires) == 1;
+    }
+    int reclaimed = sec_table_expire(t, 1000 + 149 * 100);
+    bool hidden = sec_table_apply(t, "s-150", false, 1000 + 150 * 100, count_fn, NULL) == 0;
+    bool alive = sec_table_apply(t, "s-151", false, 1000 + 150 * 100, count_fn, NULL) == 1;
+    int rest = sec_table_expire(t, 1000000);
+    if (ok && reclaimed == 150 && hidden && alive && rest == 149 && sec_table_count(t) == 0) {
+        PASS();
+    } else {
+        FAIL("Expiry failed");
+    }
+
+    /* Callback can remove its entry */
+    TEST("sec_table_callback_remove");
+    for (int i = 0; i < 100; i++) {
+        sec_table_apply(t, "hot", true, 0, count_fn, NULL);
+    }
+    if (sec_table_apply(t, "hot", false, 0, count_fn, NULL) == 0 && sec_table_count(t) == 0) {
+        PASS();
+    } else {
+        FAIL("Callback removal failed");
+    }
+    sec_table_destroy(t);
 }
 
 /* Test security manager */
@@ -310,6 +422,7 @@ int main(void) {
     test_user_auth();
     test_session_manager();
     test_attack_prevention();
+    test_sec_table();
     test_security_manager();
     
     printf("\n===================================\n");
@@ -8,7 +8,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
 #include "../src/web/api_server.h"
+#include "../src/web/api_routes.h"
 #include "../src/web/websocket_server.h"
 #include "../src/web/auth_manager.h"
 #include "../src/web/rate_limiter.h"
@@ -138,6 +144,197 @@ static int test_websocket_server_broadcast(void) {
     return result == 0;
 }
 
+/* Loopback helpers */
+static int loopback_connect(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct timeval tv = {.tv_sec = 2};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+static int send_str(int fd, const char *s) {
+    size_t len = strlen(s);
+    return write(fd, s, len) == (ssize_t)len ? 0 : -1;
+}
+
+/* Read one HTTP response; returns status, body copied into body */
+static int read_response(int fd, char *body, size_t body_size) {
+    static char buf[8192];
+    size_t len = 0;
+    char *end = NULL;
+    while (!end) {
+        ssize_t n = read(fd, buf + len, 1);  /* Byte-wise: never eat the next response */
+        if (n <= 0) {
+            return -1;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+        if (len + 1 >= sizeof(buf)) {
+            return -1;
+        }
+    }
+    int status = atoi(buf + 9);
+    char *cl = strstr(buf, "Content-Length: ");
+    size_t body_len = cl ? (size_t)atol(cl + 16) : 0;
+    if (body_len >= body_size) {
+        return -1;
+    }
+    size_t got = 0;
+    while (got < body_len) {
+        ssize_t n = read(fd, body + got, body_len - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    body[body_len] = '\0';
+    return status;
+}
+
+static int ws_handshake(int fd) {
+    /* Key and accept value from RFC 6455 section 1.3 */
+    if (send_str(fd, "GET /live HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+                     "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                     "Sec-WebSocket-Version: 13\r\n\r\n") != 0) {
+        return -1;
+    }
+    char buf[512];
+    size_t len = 0;
+    while (len < sizeof(buf) - 1) {
+        ssize_t n = read(fd, buf + len, 1);
+        if (n <= 0) {
+            return -1;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n")) {
+            return strstr(buf, "101 Switching") &&
+                   strstr(buf, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+/* Read one unmasked server frame; returns opcode, payload NUL-terminated */
+static int ws_read_frame(int fd, char *payload, size_t size) {
+    unsigned char hdr[4];
+    if (read(fd, hdr, 2) != 2) {
+        return -1;
+    }
+    size_t len = hdr[1] & 0x7F;
+    if (len == 126) {
+        if (read(fd, hdr + 2, 2) != 2) {
+            return -1;
+        }
+        len = (size_t)hdr[2] << 8 | hdr[3];
+    }
+    if (len >= size) {
+        return -1;
+    }
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = read(fd, payload + got, len - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += (size_t)n;
+    }
+    payload[len] = '\0';
+    return hdr[0] & 0x0F;
+}
+
+static int test_api_server_loopback_routes(void) {
+    api_server_config_t config = {.port = 0, .max_connections = 16, .timeout_seconds = 5};
+    api_server_t *server = api_server_init(&config);
+    if (!server || api_routes_register(server) != 0 || api_server_start(server) != 0) {
+        api_server_cleanup(server);
+        return 0;
+    }
+
+    int ok = 0;
+    char body[4096];
+    int fd = loopback_connect(api_server_get_port(server));
+    if (fd >= 0) {
+        /* All on one keep-alive connection, the last two pipelined */
+        ok = send_str(fd, "GET /api/host/info HTTP/1.1\r\nHost: x\r\n\r\n") == 0 &&
+             read_response(fd, body, sizeof(body)) == 200 && strstr(body, "hostname") &&
+             send_str(fd, "GET /api/nowhere HTTP/1.1\r\nHost: x\r\n\r\n") == 0 &&
+             read_response(fd, body, sizeof(body)) == 404 &&
+             send_str(fd, "DELETE /api/host/info HTTP/1.1\r\nHost: x\r\n\r\n") == 0 &&
+             read_response(fd, body, sizeof(body)) == 405 &&
+             send_str(fd, "POST /api/streams/abc/record HTTP/1.1\r\nContent-Length: 2\r\n\r\n{}"
+                          "GET /api/metrics/current?x=1 HTTP/1.1\r\n\r\n") == 0 &&
+             read_response(fd, body, sizeof(body)) == 200 &&
+             read_response(fd, body, sizeof(body)) == 200 && strstr(body, "\"fps\"");
+        close(fd);
+    }
+
+    api_server_cleanup(server);
+    return ok;
+}
+
+static int test_websocket_server_loopback(void) {
+    websocket_server_config_t config = {.port = 0};
+    websocket_server_t *server = websocket_server_init(&config);
+    if (!server || websocket_server_start(server) != 0) {
+        websocket_server_cleanup(server);
+        return 0;
+    }
+
+    enum { CLIENTS = 64 };
+    int fds[CLIENTS];
+    int ok = 1;
+    for (int i = 0; i < CLIENTS; i++) {
+        fds[i] = loopback_connect(websocket_server_get_port(server));
+        if (fds[i] < 0 || ws_handshake(fds[i]) != 0) {
+            ok = 0;
+        }
+    }
+    for (int i = 0; i < 200 && websocket_server_get_client_count(server) < CLIENTS; i++) {
+        usleep(5000);
+    }
+    ok = ok && websocket_server_get_client_count(server) == CLIENTS;
+
+    /* Every client receives the same metrics frame */
+    metrics_snapshot_t metrics = {.fps = 60, .rtt_ms = 15};
+    ok = ok && websocket_server_broadcast_metrics(server, &metrics) == 0;
+    char payload[1024];
+    for (int i = 0; ok && i < CLIENTS; i++) {
+        ok = ws_read_frame(fds[i], payload, sizeof(payload)) == 0x1 &&
+             strstr(payload, "\"type\": \"metrics\"") && strstr(payload, "\"fps\": 60");
+    }
+
+    /* Masked ping gets a pong, close gets a close */
+    const unsigned char ping[] = {0x89, 0x82, 1, 2, 3, 4, 'h' ^ 1, 'i' ^ 2};
+    const unsigned char bye[] = {0x88, 0x82, 0, 0, 0, 0, 0x03, 0xE8};
+    ok = ok && write(fds[0], ping, sizeof(ping)) == (ssize_t)sizeof(ping) &&
+         ws_read_frame(fds[0], payload, sizeof(payload)) == 0xA && strcmp(payload, "hi") == 0 &&
+         write(fds[0], bye, sizeof(bye)) == (ssize_t)sizeof(bye) &&
+         ws_read_frame(fds[0], payload, sizeof(payload)) == 0x8;
+
+    for (int i = 0; i < CLIENTS; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    for (int i = 0; i < 200 && websocket_server_get_client_count(server) > 0; i++) {
+        usleep(5000);
+    }
+    ok = ok && websocket_server_get_client_count(server) == 0;
+
+    websocket_server_cleanup(server);
+    return ok;
+}
+
 /* Authentication Manager Tests */
 static int test_auth_manager_init(void) {
     auth_manager_t *auth = auth_manager_init();
@@ -325,6 +522,8 @@ int main(void) {
     // WebSocket Server tests
     TEST(websocket_server_init);
     TEST(websocket_server_broadcast);
+    TEST(api_server_loopback_routes);
+    TEST(websocket_server_loopback);
 
     // Authentication Manager tests
     TEST(auth_manager_init);
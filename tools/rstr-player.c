@@ -6,6 +6,7 @@
  */
 
 #include "../include/rootstream.h"
+#include "../src/rstr/rstr_reader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -14,33 +15,6 @@
 #include <errno.h>
 #include <time.h>
 
-/* RSTR format structures (must match recording.c) */
-#define RSTR_MAGIC 0x52535452  /* "RSTR" */
-#define RSTR_VERSION 1
-
-typedef struct __attribute__((packed)) {
-    uint32_t magic;
-    uint32_t version;
-    uint32_t width;
-    uint32_t height;
-    uint32_t codec;        /* 0=H.264, 1=H.265 */
-    uint32_t fps;
-    uint64_t start_time;   /* Unix timestamp */
-    uint32_t reserved[8];
-} rstr_header_t;
-
-typedef struct __attribute__((packed)) {
-    uint64_t timestamp_us;
-    uint32_t size;
-    uint8_t flags;         /* 0x01=keyframe */
-    uint8_t reserved[3];
-} rstr_frame_header_t;
-
-/* External recording functions */
-extern int rstr_read_header(int fd, rstr_header_t *header);
-extern int rstr_read_frame(int fd, uint8_t *buffer, size_t buffer_size,
-                           rstr_frame_header_t *frame_hdr);
-
 static void print_usage(const char *prog) {
     printf("RootStream Recording Playback Tool\n\n");
     printf("Usage: %s [options] <recording.rstr>\n\n", prog);
@@ -48,6 +22,7 @@ static void print_usage(const char *prog) {
     printf("  -h, --help      Show this help\n");
     printf("  -l, --loop      Loop playback\n");
     printf("  -s, --speed N   Playback speed (0.5-2.0, default 1.0)\n");
+    printf("  -t, --start SEC Start at the keyframe before SEC seconds\n");
     printf("\nControls:\n");
     printf("  Space  Pause/Resume\n");
     printf("  Q/Esc  Quit\n");
@@ -59,6 +34,7 @@ int main(int argc, char **argv) {
     const char *filename = NULL;
     bool loop = false;
     float speed = 1.0f;
+    double start_sec = 0.0;
 
     /* Parse arguments */
     for (int i = 1; i < argc; i++) {
@@ -77,6 +53,16 @@ int main(int argc, char **argv) {
                 fprintf(stderr, "ERROR: Speed must be 0.5-2.0\n");
                 return 1;
             }
+        } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--start") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "ERROR: --start requires argument\n");
+                return 1;
+            }
+            start_sec = atof(argv[++i]);
+            if (start_sec < 0.0) {
+                fprintf(stderr, "ERROR: Start must be >= 0\n");
+                return 1;
+            }
         } else if (argv[i][0] != '-') {
             filename = argv[i];
         } else {
@@ -116,8 +102,28 @@ int main(int argc, char **argv) {
     /* Copy start_time to avoid unaligned pointer warning */
     time_t start_time = (time_t)header.start_time;
     printf("Recorded: %s", ctime(&start_time));
+
+    /* Keyframe index: read from the file's trailer when it was closed
+     * cleanly, so seeking is a binary search instead of a scan */
+    static const char *const index_sources[] = {"index", "checkpoints", "scan"};
+    rstr_index_t index;
+    if (rstr_index_load(fd, &header, &index) < 0) {
+        fprintf(stderr, "ERROR: Failed to index recording\n");
+        close(fd);
+        return 1;
+    }
+    printf("Keyframes: %zu (from %s)\n", index.count, index_sources[index.source]);
     printf("\n");
 
+    if (start_sec > 0.0) {
+        uint64_t keyframe_us = 0;
+        if (rstr_seek(fd, &index, (uint64_t)(start_sec * 1000000.0), &keyframe_us) == 0) {
+            printf("Starting at %.1f seconds\n", keyframe_us / 1000000.0);
+        } else {
+            fprintf(stderr, "WARNING: No keyframe to seek to, starting from the beginning\n");
+        }
+    }
+
     /* Initialize context */
     rootstream_ctx_t ctx = {0};
     ctx.display.width = header.width;
@@ -127,6 +133,7 @@ int main(int argc, char **argv) {
     /* Initialize decoder */
     if (rootstream_decoder_init(&ctx) < 0) {
         fprintf(stderr, "ERROR: Failed to initialize decoder\n");
+        rstr_index_free(&index);
         close(fd);
         return 1;
     }
@@ -137,6 +144,7 @@ int main(int argc, char **argv) {
     if (display_init(&ctx, title, header.width, header.height) < 0) {
         fprintf(stderr, "ERROR: Failed to initialize display\n");
         rootstream_decoder_cleanup(&ctx);
+        rstr_index_free(&index);
         close(fd);
         return 1;
     }
@@ -150,6 +158,7 @@ int main(int argc, char **argv) {
         fprintf(stderr, "ERROR: Failed to allocate frame buffer\n");
         display_cleanup(&ctx);
         rootstream_decoder_cleanup(&ctx);
+        rstr_index_free(&index);
         close(fd);
         return 1;
     }
@@ -169,7 +178,9 @@ int main(int argc, char **argv) {
             /* EOF */
             if (loop) {
                 printf("Looping playback...\n");
-                lseek(fd, sizeof(rstr_header_t), SEEK_SET);
+                if (rstr_seek(fd, &index, 0, NULL) < 0) {
+                    lseek(fd, sizeof(rstr_header_t), SEEK_SET);
+                }
                 last_frame_time = 0;
                 continue;
             } else {
@@ -222,6 +233,7 @@ int main(int argc, char **argv) {
     }
     display_cleanup(&ctx);
     rootstream_decoder_cleanup(&ctx);
+    rstr_index_free(&index);
     close(fd);
 
     return 0;